@@ -11,6 +11,8 @@
 #include <GL/glew.h>
 #include <GL/freeglut.h>
 
+#include "GLPresenter.hpp"
+
 #include <cuda.h>
 #include <cuda_gl_interop.h>
 
@@ -167,6 +169,12 @@ private:
 	sl::Orientation rotation_;
 };
 
+///
+/// \brief clears skeletons and adds the bones (cylinders) and keypoints (spheres) of the bodies to render, the keypoints
+/// not detected (not finite) skipped. Used by GLViewer::updateData and the benchmark of the sample
+///
+void buildSkeletonMesh(Simple3DObject &skeletons, std::vector<sl::ObjectData> &objs, sl::BODY_FORMAT body_format, bool isTrackingON);
+
 class CameraGL {
 public:
 
@@ -282,8 +290,7 @@ public:
 
 private:
 	GLuint texID;
-	GLuint imageTex;
-	cudaGraphicsResource* cuda_gl_ressource;//cuda GL resource
+	GLPresenter presenter;
 	Shader shader;
 	GLuint quad_vb;
 };
@@ -23,32 +23,6 @@ inline sl::float2 getImagePosition(std::vector<sl::uint2> &bounding_box_image, s
 
 void render_2D(cv::Mat &left, sl::float2 img_scale, std::vector<sl::ObjectData> &objects, bool isTrackingON, sl::BODY_FORMAT body_format);
 
-inline cv::Mat slMat2cvMat(sl::Mat& input) {
-    // Mapping between MAT_TYPE and CV_TYPE
-    int cv_type = -1;
-    switch (input.getDataType()) {
-        case sl::MAT_TYPE::F32_C1: cv_type = CV_32FC1;
-            break;
-        case sl::MAT_TYPE::F32_C2: cv_type = CV_32FC2;
-            break;
-        case sl::MAT_TYPE::F32_C3: cv_type = CV_32FC3;
-            break;
-        case sl::MAT_TYPE::F32_C4: cv_type = CV_32FC4;
-            break;
-        case sl::MAT_TYPE::U8_C1: cv_type = CV_8UC1;
-            break;
-        case sl::MAT_TYPE::U8_C2: cv_type = CV_8UC2;
-            break;
-        case sl::MAT_TYPE::U8_C3: cv_type = CV_8UC3;
-            break;
-        case sl::MAT_TYPE::U8_C4: cv_type = CV_8UC4;
-            break;
-        default: break;
-    }
-
-    return cv::Mat(input.getHeight(), input.getWidth(), cv_type, input.getPtr<sl::uchar1>(sl::MEM::CPU));
-}
-
 
 float const id_colors[8][3] = {
 	{ 232.0f, 176.0f ,59.0f },
@@ -256,20 +256,14 @@ inline bool renderObject(const sl::ObjectData& i, const bool isTrackingON) {
 		return (i.tracking_state == sl::OBJECT_TRACKING_STATE::OK || i.tracking_state == sl::OBJECT_TRACKING_STATE::OFF);
 }
 
-void GLViewer::updateData(sl::Mat &matXYZRGBA, std::vector<sl::ObjectData> &objs, sl::Transform& pose) {
-	mtx.lock();
-	pointCloud_.pushNewPC(matXYZRGBA);
+void buildSkeletonMesh(Simple3DObject &skeletons, std::vector<sl::ObjectData> &objs, sl::BODY_FORMAT body_format, bool isTrackingON) {
 	skeletons.clear();
-	cam_pose = pose;
-	sl::float3 tr_0(0, 0, 0);
-	cam_pose.setTranslation(tr_0);
-
 	for (unsigned int i = 0; i < objs.size(); i++) {
-		if (renderObject(objs[i], isTrackingON_)) {
+		if (renderObject(objs[i], isTrackingON)) {
 			// draw skeletons
 			auto clr_id = generateColorID(objs[i].id);
 			if (objs[i].keypoint.size()) {
-				if (body_format_ == sl::BODY_FORMAT::POSE_18) {
+				if (body_format == sl::BODY_FORMAT::POSE_18) {
 					for (auto& limb : SKELETON_BONES) {
 						sl::float3 kp_1 = objs[i].keypoint[getIdx(limb.first)];
 						sl::float3 kp_2 = objs[i].keypoint[getIdx(limb.second)];
@@ -297,7 +291,7 @@ void GLViewer::updateData(sl::Mat &matXYZRGBA, std::vector<sl::ObjectData> &objs
 					// Add Sphere at the Spine position
 					if (std::isfinite(spine.norm()))skeletons.addSphere(spine, clr_id);
 				}
-				else if (body_format_ == sl::BODY_FORMAT::POSE_34) {
+				else if (body_format == sl::BODY_FORMAT::POSE_34) {
 					for (auto& limb : sl::BODY_BONES_POSE_34) {
 						sl::float3 kp_1 = objs[i].keypoint[getIdx(limb.first)];
 						sl::float3 kp_2 = objs[i].keypoint[getIdx(limb.second)];
@@ -316,6 +310,15 @@ void GLViewer::updateData(sl::Mat &matXYZRGBA, std::vector<sl::ObjectData> &objs
 			}
 		}
 	}
+}
+
+void GLViewer::updateData(sl::Mat &matXYZRGBA, std::vector<sl::ObjectData> &objs, sl::Transform& pose) {
+	mtx.lock();
+	pointCloud_.pushNewPC(matXYZRGBA);
+	cam_pose = pose;
+	sl::float3 tr_0(0, 0, 0);
+	cam_pose.setTranslation(tr_0);
+	buildSkeletonMesh(skeletons, objs, body_format_, isTrackingON_);
 	mtx.unlock(); 
 }
 
@@ -905,8 +908,7 @@ GLchar* IMAGE_FRAGMENT_SHADER =
 " out vec4 color;\n"
 " uniform sampler2D texImage;\n"
 " void main() {\n"
-"	vec2 scaler  =vec2(UV.x,1.f - UV.y);\n"
-"	vec3 rgbcolor = vec3(texture(texImage, scaler).zyx);\n"
+"	vec3 rgbcolor = texture(texImage, UV).rgb;\n"
 "	vec3 color_rgb = pow(rgbcolor, vec3(1.65f));\n"
 "	color = vec4(color_rgb,1);\n"
 "}";
@@ -916,7 +918,7 @@ GLchar* IMAGE_VERTEX_SHADER =
 "layout(location = 0) in vec3 vert;\n"
 "out vec2 UV;"
 "void main() {\n"
-"	UV = (vert.xy+vec2(1,1))* .5f;\n"
+"	UV = vec2(vert.x + 1.0, 1.0 - vert.y) * .5f;\n"
 "	gl_Position = vec4(vert, 1);\n"
 "}\n";
 
@@ -928,7 +930,7 @@ ImageHandler::~ImageHandler() {
 }
 
 void ImageHandler::close() {
-	glDeleteTextures(1, &imageTex);
+	presenter.release();
 }
 
 bool ImageHandler::initialize(sl::Resolution res) {
@@ -948,34 +950,20 @@ bool ImageHandler::initialize(sl::Resolution res) {
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
 
 	glEnable(GL_TEXTURE_2D);
-	glGenTextures(1, &imageTex);
-	glBindTexture(GL_TEXTURE_2D, imageTex);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_BORDER);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, res.width, res.height, 0, GL_BGRA_EXT, GL_UNSIGNED_BYTE, NULL);
-	glBindTexture(GL_TEXTURE_2D, 0);
-	cudaError_t err = cudaGraphicsGLRegisterImage(&cuda_gl_ressource, imageTex, GL_TEXTURE_2D, cudaGraphicsRegisterFlagsWriteDiscard);
-	return (err == cudaSuccess);
+	// Ring of textures: the copy of the next image does not wait for the draw of this one
+	return presenter.init(res.width, res.height, true, PixelFormat::BGRA);
 }
 
 void ImageHandler::pushNewImage(sl::Mat &image) {
-	cudaArray_t ArrIm;
-	cudaGraphicsMapResources(1, &cuda_gl_ressource, 0);
-	cudaGraphicsSubResourceGetMappedArray(&ArrIm, cuda_gl_ressource, 0, 0);
-	cudaMemcpy2DToArray(ArrIm, 0, 0, image.getPtr<sl::uchar1>(sl::MEM::GPU), image.getStepBytes(sl::MEM::GPU), image.getPixelBytes()*image.getWidth(), image.getHeight(), cudaMemcpyDeviceToDevice);
-	cudaGraphicsUnmapResources(1, &cuda_gl_ressource, 0);
+	presenter.uploadDevice(image.getPtr<sl::uchar1>(sl::MEM::GPU), image.getStepBytes(sl::MEM::GPU));
 }
 
 void ImageHandler::draw() {
 	const auto id_shade = shader.getProgramId();
 	glUseProgram(id_shade);
 	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, imageTex);
+	glBindTexture(GL_TEXTURE_2D, presenter.texture());
 	glUniform1i(texID, 0);
-	//invert y axis and color for this image (since its reverted from cuda array)
 
 	glEnableVertexAttribArray(0);
 	glBindBuffer(GL_ARRAY_BUFFER, quad_vb);
@@ -0,0 +1,107 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+/***********************************************************************
+ ** Per frame work of the sample on synthetic bodies, no camera nor   **
+ ** window: meshes of the 3D skeletons (spheres and cylinders of the  **
+ ** Simple3DObject, before their upload) and 2D skeletons drawn on    **
+ ** the left image, in the 18 and 34 keypoints formats.               **
+ ***********************************************************************/
+
+#include <list>
+#include <random>
+#include <vector>
+
+#include <sl/Camera.hpp>
+
+#include "GLViewer.hpp"
+#include "TrackingViewer.hpp"
+#include "BenchSuite.hpp"
+
+using namespace std;
+
+// Bodies standing in front of the camera (RIGHT_HANDED_Y_UP, millimeters), keypoints in a 1280x720 image
+static vector<sl::ObjectData> makeBodies(int nb_bodies, int nb_keypoints, mt19937& rng) {
+    uniform_real_distribution<float> x(-2000.f, 2000.f), z(-6000.f, -1500.f), u(0.f, 1180.f), v(0.f, 420.f);
+    uniform_real_distribution<float> body_x(-300.f, 300.f), body_y(0.f, 1800.f), body_z(-150.f, 150.f), box_u(0.f, 100.f), box_v(0.f, 300.f);
+    vector<sl::ObjectData> bodies(nb_bodies);
+    for (int i = 0; i < nb_bodies; i++) {
+        auto& body = bodies[i];
+        body.id = i;
+        body.tracking_state = sl::OBJECT_TRACKING_STATE::OK;
+        body.position = sl::float3(x(rng), 900.f, z(rng));
+        float left = u(rng), top = v(rng);
+        body.bounding_box_2d = {sl::uint2(left, top), sl::uint2(left + 100, top), sl::uint2(left + 100, top + 300), sl::uint2(left, top + 300)};
+        for (int k = 0; k < nb_keypoints; k++) {
+            body.keypoint.push_back(sl::float3(body.position.x + body_x(rng), body_y(rng), body.position.z + body_z(rng)));
+            body.keypoint_2d.push_back(sl::float2(left + box_u(rng), top + box_v(rng)));
+        }
+    }
+    return bodies;
+}
+
+int main(int argc, char **argv) {
+    BenchSuite suite("ZED_Body_Tracking_Bench");
+    suite.setContext("opencv", CV_VERSION);
+    cv::setNumThreads(1);
+    mt19937 rng(42);
+
+    // No GL context: the objects are never pushed to the GPU, only their vertices are built
+    Simple3DObject skeletons(sl::Translation(0, 0, 0), true);
+    sl::float2 img_scale(1.f, 1.f);
+    cv::Mat left(720, 1280, CV_8UC4), left_render;
+    cv::randu(left, cv::Scalar::all(0), cv::Scalar::all(255));
+
+    struct { const char* name; sl::BODY_FORMAT format; int nb_keypoints; } formats[] = {
+        {"pose_18", sl::BODY_FORMAT::POSE_18, static_cast<int>(sl::BODY_PARTS::LAST)},
+        {"pose_34", sl::BODY_FORMAT::POSE_34, static_cast<int>(sl::BODY_PARTS_POSE_34::LAST)}
+    };
+    const int body_counts[] = {1, 5, 10};
+    list<vector<sl::ObjectData>> scenes;
+    for (auto& format : formats) {
+        for (int nb_bodies : body_counts) {
+            scenes.push_back(makeBodies(nb_bodies, format.nb_keypoints, rng));
+            auto& bodies = scenes.back();
+            auto body_format = format.format;
+            string name = string("/") + format.name + "/" + to_string(nb_bodies);
+            suite.add("skeleton_mesh" + name, [&skeletons, &bodies, body_format]() {
+                buildSkeletonMesh(skeletons, bodies, body_format, true);
+            }).items(nb_bodies);
+            suite.add("render_2D" + name, [&bodies, &left, &left_render, img_scale, body_format]() {
+                left.copyTo(left_render);
+                render_2D(left_render, img_scale, bodies, true, body_format);
+            }).items(1);
+        }
+    }
+
+    // Single primitives, the object cleared once its buffers are allocated
+    sl::float3 start(0.f, 0.f, -2000.f), end(150.f, 400.f, -2100.f);
+    sl::float4 color(0.2f, 0.8f, 0.4f, 1.f);
+    suite.add("simple3d/addSphere", [&skeletons, start, color]() {
+        skeletons.clear();
+        skeletons.addSphere(start, color);
+    }).items(1);
+    suite.add("simple3d/addCylinder", [&skeletons, start, end, color]() {
+        skeletons.clear();
+        skeletons.addCylinder(start, end, color);
+    }).items(1);
+
+    return suite.run(argc, argv);
+}
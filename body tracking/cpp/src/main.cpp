@@ -27,7 +27,11 @@
 #include <sl/Camera.hpp>
 
 // Sample includes
+#include "DisplayMode.hpp"
+#include "ZedFrameSource.hpp"
 #include "GLViewer.hpp"
+#include "MatBridge.hpp"
+#include "StageTrace.hpp"
 #include "TrackingViewer.hpp"
 
 // Using std and sl namespaces
@@ -36,7 +40,6 @@ using namespace sl;
 
 bool is_playback = false;
 void print(string msg_prefix, ERROR_CODE err_code = ERROR_CODE::SUCCESS, string msg_suffix = "");
-void parseArgs(int argc, char **argv, InitParameters& param);
 
 int main(int argc, char **argv) {
 
@@ -54,7 +57,16 @@ int main(int argc, char **argv) {
     init_parameters.depth_mode = isJetson ? DEPTH_MODE::PERFORMANCE : DEPTH_MODE::ULTRA;
     init_parameters.coordinate_system = COORDINATE_SYSTEM::RIGHT_HANDED_Y_UP;
 
-    parseArgs(argc, argv, init_parameters);
+    // --headless, --preview N, --sink
+    DisplayMode display;
+    if (!display.parse(argc, argv)) return EXIT_FAILURE;
+    // --trace <file.json>, --trace-stats
+    StageTrace trace;
+    if (!trace.parse(argc, argv)) return EXIT_FAILURE;
+    // Input of the sample: SVO file, IP[:port] of a stream, camera resolution or --source (FrameSource.hpp)
+    FrameSourceOptions source;
+    if (!source.parse(argc, argv) || !applyFrameSource(source, init_parameters)) return EXIT_FAILURE;
+    is_playback = source.kind == FRAME_SOURCE::SVO;
 
     // Open the camera
     auto returned_state = zed.open(init_parameters);
@@ -93,17 +105,20 @@ int main(int argc, char **argv) {
     // For 2D GUI
     Resolution display_resolution(min((int)camera_config.resolution.width, 1280), min((int)camera_config.resolution.height, 720));
     cv::Mat image_left_ocv(display_resolution.height, display_resolution.width, CV_8UC4, 1);
-    Mat image_left(display_resolution, MAT_TYPE::U8_C4, image_left_ocv.data, image_left_ocv.step);
+    Mat image_left = toSlMat(image_left_ocv);
     sl::float2 img_scale(display_resolution.width / (float)camera_config.resolution.width, display_resolution.height / (float) camera_config.resolution.height);
     char key = ' ';
 
 	// 3D View
 	Resolution pc_resolution(min((int)camera_config.resolution.width, 720), min((int)camera_config.resolution.height, 404));
 	auto camera_parameters = zed.getCameraInformation(pc_resolution).camera_configuration.calibration_parameters.left_cam;
-	Mat point_cloud(pc_resolution, MAT_TYPE::F32_C4, MEM::GPU);
-	// Create OpenGL Viewer
+	Mat point_cloud;
+	// Create OpenGL Viewer, no window nor GL context when headless
 	GLViewer viewer;
-	viewer.init(argc, argv, camera_parameters, obj_det_params.enable_tracking, obj_det_params.body_format);
+	if (!display.headless()) {
+		point_cloud.alloc(pc_resolution, MAT_TYPE::F32_C4, MEM::GPU);
+		viewer.init(argc, argv, camera_parameters, obj_det_params.enable_tracking, obj_det_params.body_format);
+	}
 
 	Pose cam_pose;
 	cam_pose.pose_data.setIdentity();
@@ -123,9 +138,13 @@ int main(int argc, char **argv) {
     bool need_floor_plane = positional_tracking_parameters.set_as_static;
 
 	bool gl_viewer_available = true;
-    while (gl_viewer_available && !quit && key != 'q') {
+    while (gl_viewer_available && !quit && key != 'q' && display.nextFrame()) {
+        STAGE_SPAN("frame");
         // Grab images
-        if (zed.grab() == ERROR_CODE::SUCCESS) {
+        StageSpan grab_span("grab");
+        returned_state = zed.grab();
+        grab_span.end();
+        if (returned_state == ERROR_CODE::SUCCESS) {
             // Once the camera has started, get the floor plane to stick the bounding box to the floor plane.
             // Only called if camera is static (see PositionalTrackingParameters)
             if (need_floor_plane) {
@@ -136,26 +155,49 @@ int main(int argc, char **argv) {
             }
 
             // Retrieve Detected Human Bodies
+            StageSpan objects_span("retrieveObjects");
             zed.retrieveObjects(bodies, objectTracker_parameters_rt);
+            objects_span.end();
 
-            //OCV View
-            zed.retrieveImage(image_left, VIEW::LEFT, MEM::CPU, display_resolution);
-			zed.retrieveMeasure(point_cloud, MEASURE::XYZRGBA, MEM::GPU, pc_resolution);
-			zed.getPosition(cam_pose, REFERENCE_FRAME::WORLD);
-
-			string window_name = "ZED| 2D View";
-
-			//Update GL View
-			viewer.updateData(point_cloud, bodies.object_list, cam_pose.pose_data);
+			if (display.hasSink()) {
+				string text = to_string(bodies.object_list.size()) + " bodies";
+				for (auto& body : bodies.object_list)
+					text += " " + to_string(body.id) + " " + to_string(body.position.x) + " " + to_string(body.position.y) + " " + to_string(body.position.z);
+				display.publish(bodies.timestamp.getNanoseconds(), text);
+			}
 
-			gl_viewer_available = viewer.isAvailable();
 			if (is_playback && zed.getSVOPosition() == zed.getSVONumberOfFrames()) {
 				quit = true;
 			}
-			render_2D(image_left_ocv, img_scale, bodies.object_list, obj_det_params.enable_tracking, obj_det_params.body_format);
-			cv::imshow(window_name, image_left_ocv);
-			key = cv::waitKey(10);
-        }
+
+			if (display.renderFrame()) {
+				//OCV View
+				StageSpan image_span("retrieveImage");
+				zed.retrieveImage(image_left, VIEW::LEFT, MEM::CPU, display_resolution);
+				image_span.end();
+				StageSpan measure_span("retrieveMeasure");
+				zed.retrieveMeasure(point_cloud, MEASURE::XYZRGBA, MEM::GPU, pc_resolution);
+				measure_span.end();
+				zed.getPosition(cam_pose, REFERENCE_FRAME::WORLD);
+
+				string window_name = "ZED| 2D View";
+
+				//Update GL View
+				StageSpan viewer_span("viewer");
+				viewer.updateData(point_cloud, bodies.object_list, cam_pose.pose_data);
+				viewer_span.end();
+
+				gl_viewer_available = viewer.isAvailable();
+				StageSpan render_span("render_2D");
+				render_2D(image_left_ocv, img_scale, bodies.object_list, obj_det_params.enable_tracking, obj_det_params.body_format);
+				render_span.end();
+				StageSpan imshow_span("imshow");
+				cv::imshow(window_name, image_left_ocv);
+				key = cv::waitKey(10);
+				imshow_span.end();
+			}
+        } else if (returned_state == ERROR_CODE::END_OF_SVOFILE_REACHED && display.headless())
+            break;
     }
 
     // Release objects
@@ -169,43 +211,11 @@ int main(int argc, char **argv) {
     zed.disableObjectDetection();
     zed.disablePositionalTracking();
     zed.close();
+    trace.finish();
 
     return EXIT_SUCCESS;
 }
 
-void parseArgs(int argc, char **argv, InitParameters& param) {
-    if (argc > 1 && string(argv[1]).find(".svo") != string::npos) {
-        // SVO input mode
-        param.input.setFromSVOFile(argv[1]);
-		is_playback = true;
-        cout << "[Sample] Using SVO File input: " << argv[1] << endl;
-    } else if (argc > 1 && string(argv[1]).find(".svo") == string::npos) {
-        string arg = string(argv[1]);
-        unsigned int a, b, c, d, port;
-        if (sscanf(arg.c_str(), "%u.%u.%u.%u:%d", &a, &b, &c, &d, &port) == 5) {
-            // Stream input mode - IP + port
-            string ip_adress = to_string(a) + "." + to_string(b) + "." + to_string(c) + "." + to_string(d);
-            param.input.setFromStream(String(ip_adress.c_str()), port);
-            cout << "[Sample] Using Stream input, IP : " << ip_adress << ", port : " << port << endl;
-        } else if (sscanf(arg.c_str(), "%u.%u.%u.%u", &a, &b, &c, &d) == 4) {
-            // Stream input mode - IP only
-            param.input.setFromStream(String(argv[1]));
-            cout << "[Sample] Using Stream input, IP : " << argv[1] << endl;
-        } else if (arg.find("HD2K") != string::npos) {
-            param.camera_resolution = RESOLUTION::HD2K;
-            cout << "[Sample] Using Camera in resolution HD2K" << endl;
-        } else if (arg.find("HD1080") != string::npos) {
-            param.camera_resolution = RESOLUTION::HD1080;
-            cout << "[Sample] Using Camera in resolution HD1080" << endl;
-        } else if (arg.find("HD720") != string::npos) {
-            param.camera_resolution = RESOLUTION::HD720;
-            cout << "[Sample] Using Camera in resolution HD720" << endl;
-        } else if (arg.find("VGA") != string::npos) {
-            param.camera_resolution = RESOLUTION::VGA;
-            cout << "[Sample] Using Camera in resolution VGA" << endl;
-        }
-    }
-}
 
 void print(string msg_prefix, ERROR_CODE err_code, string msg_suffix) {
     cout << "[Sample]";
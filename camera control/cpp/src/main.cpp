@@ -34,6 +34,11 @@
 // OpenCV include (for display)
 #include <opencv2/opencv.hpp>
 
+// Sample includes
+#include "DisplayMode.hpp"
+#include "ZedFrameSource.hpp"
+#include "MatBridge.hpp"
+
 // Using std and sl namespaces
 using namespace std;
 using namespace sl;
@@ -43,7 +48,6 @@ void updateCameraSettings(char key, sl::Camera &zed);
 void switchCameraSettings();
 void printHelp();
 void print(string msg_prefix, ERROR_CODE err_code = ERROR_CODE::SUCCESS, string msg_suffix = "");
-void parseArgs(int argc, char **argv,sl::InitParameters& param);
 
 // Sample variables
 VIDEO_SETTINGS camera_settings_ = VIDEO_SETTINGS::BRIGHTNESS;
@@ -91,6 +95,10 @@ static void onMouse(int event, int x, int y, int, void*)
 }
 
 int main(int argc, char **argv) {
+    // --headless, --preview N, --sink
+    DisplayMode display;
+    if (!display.parse(argc, argv)) return EXIT_FAILURE;
+
     // Create a ZED Camera object
 
     std::cout<<" Reboot CAMERA "<<std::endl;
@@ -103,7 +111,15 @@ int main(int argc, char **argv) {
     init_parameters.sdk_verbose = true;
     init_parameters.camera_resolution= sl::RESOLUTION::HD720;
     init_parameters.depth_mode = sl::DEPTH_MODE::NONE; // no depth computation required here
-    parseArgs(argc,argv, init_parameters);
+    // Input of the sample: SVO file, IP[:port] of a stream, camera resolution or --source (FrameSource.hpp)
+    FrameSourceOptions source;
+    if (!source.parse(argc, argv)) return EXIT_FAILURE;
+    if (source.kind == FRAME_SOURCE::SVO) {
+        // SVO input mode not available in camera control
+        cout << "SVO Input mode is not available for camera control sample" << endl;
+        source.kind = FRAME_SOURCE::CAMERA;
+    }
+    if (!applyFrameSource(source, init_parameters)) return EXIT_FAILURE;
 
 
     // Open the camera
@@ -114,8 +130,10 @@ int main(int argc, char **argv) {
     }
     
     cv::String win_name = "Camera Control";
-    cv::namedWindow(win_name, cv::WINDOW_NORMAL);
-    cv::setMouseCallback(win_name, onMouse);
+    if (!display.headless()) {
+        cv::namedWindow(win_name, cv::WINDOW_NORMAL);
+        cv::setMouseCallback(win_name, onMouse);
+    }
 
     // Print camera information
     auto camera_info = zed.getCameraInformation();
@@ -126,8 +144,8 @@ int main(int argc, char **argv) {
     cout <<"ZED Camera Resolution     : "<< camera_info.camera_configuration.resolution.width << "x" << camera_info.camera_configuration.resolution.height << endl;
     cout <<"ZED Camera FPS            : "<< zed.getInitParameters().camera_fps << endl;
     
-    // Print help in console
-    printHelp();
+    // Print help in console, the settings are changed from the window
+    if (!display.headless()) printHelp();
 
     // Create a Mat to store images
     Mat zed_image;
@@ -137,7 +155,7 @@ int main(int argc, char **argv) {
 
     // Capture new images until 'q' is pressed
     char key = ' ';
-    while (key != 'q') {
+    while (key != 'q' && display.nextFrame()) {
         // Check that a new image is successfully acquired
         returned_state = zed.grab();
         if (returned_state == ERROR_CODE::SUCCESS) {
@@ -145,22 +163,36 @@ int main(int argc, char **argv) {
             zed.retrieveImage(zed_image, VIEW::LEFT);
 
             // Convert sl::Mat to cv::Mat (share buffer)
-            cv::Mat cvImage = cv::Mat((int) zed_image.getHeight(), (int) zed_image.getWidth(), CV_8UC4, zed_image.getPtr<sl::uchar1>(sl::MEM::CPU));
+            cv::Mat cvImage = toCvMat(zed_image);
 
             //Check that selection rectangle is valid and draw it on the image
             if (!selection_rect.isEmpty() && selection_rect.isContained(sl::Resolution(cvImage.cols, cvImage.rows)))
                 cv::rectangle(cvImage, cv::Rect(selection_rect.x,selection_rect.y,selection_rect.width,selection_rect.height),cv::Scalar(220, 180, 20), 2);
 
+            if (display.hasSink()) {
+                FrameResult result;
+                result.timestamp = zed_image.timestamp.getNanoseconds();
+                result.text = "exposure " + to_string(zed.getCameraSettings(VIDEO_SETTINGS::EXPOSURE)) + " gain " + to_string(zed.getCameraSettings(VIDEO_SETTINGS::GAIN));
+                result.image = cvImage.data;
+                result.width = cvImage.cols;
+                result.height = cvImage.rows;
+                result.channels = 4;
+                result.step = zed_image.getStepBytes(sl::MEM::CPU);
+                display.publish(result);
+            }
+
             //Display the image
-            cv::imshow(win_name, cvImage);
+            if (display.renderFrame()) cv::imshow(win_name, cvImage);
         }else {
             print("Error during capture : ", returned_state);
             break;
         }
         
-        key = cv::waitKey(10);
-        // Change camera settings with keyboard
-        updateCameraSettings(key, zed);        
+        if (display.renderFrame()) {
+            key = cv::waitKey(10);
+            // Change camera settings with keyboard
+            updateCameraSettings(key, zed);
+        }
     }
 
     // Exit
@@ -279,40 +311,3 @@ void print(string msg_prefix, ERROR_CODE err_code, string msg_suffix) {
         cout << " " << msg_suffix;
     cout << endl;
 }
-
-void parseArgs(int argc, char **argv,sl::InitParameters& param)
-{
-    if (argc > 1 && string(argv[1]).find(".svo")!=string::npos) {
-        // SVO input mode not available in camera control
-	cout<<"SVO Input mode is not available for camera control sample"<<endl;
-    } else if (argc > 1 && string(argv[1]).find(".svo")==string::npos) {
-        string arg = string(argv[1]);
-        unsigned int a,b,c,d,port;
-        if (sscanf(arg.c_str(),"%u.%u.%u.%u:%d", &a, &b, &c, &d,&port) == 5) {
-            // Stream input mode - IP + port
-            string ip_adress = to_string(a)+"."+to_string(b)+"."+to_string(c)+"."+to_string(d);
-            param.input.setFromStream(sl::String(ip_adress.c_str()),port);
-            cout<<"[Sample] Using Stream input, IP : "<<ip_adress<<", port : "<<port<<endl;
-        }
-        else  if (sscanf(arg.c_str(),"%u.%u.%u.%u", &a, &b, &c, &d) == 4) {
-            // Stream input mode - IP only
-            param.input.setFromStream(sl::String(argv[1]));
-            cout<<"[Sample] Using Stream input, IP : "<<argv[1]<<endl;
-        }
-        else if (arg.find("HD2K")!=string::npos) {
-            param.camera_resolution = sl::RESOLUTION::HD2K;
-            cout<<"[Sample] Using Camera in resolution HD2K"<<endl;
-        } else if (arg.find("HD1080")!=string::npos) {
-            param.camera_resolution = sl::RESOLUTION::HD1080;
-            cout<<"[Sample] Using Camera in resolution HD1080"<<endl;
-        } else if (arg.find("HD720")!=string::npos) {
-            param.camera_resolution = sl::RESOLUTION::HD720;
-            cout<<"[Sample] Using Camera in resolution HD720"<<endl;
-        } else if (arg.find("VGA")!=string::npos) {
-            param.camera_resolution = sl::RESOLUTION::VGA;
-            cout<<"[Sample] Using Camera in resolution VGA"<<endl;
-        }
-    } else {
-        // Default
-    }
-}
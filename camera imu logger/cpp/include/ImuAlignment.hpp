@@ -0,0 +1,138 @@
+#ifndef __IMU_ALIGNMENT_HPP__
+#define __IMU_ALIGNMENT_HPP__
+
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "ImuRecord.hpp"
+
+#define IMU_ALIGN_MAGIC "ZEDALGN"
+#define IMU_ALIGN_VERSION 1
+
+#pragma pack(push, 1)
+///
+/// \brief One entry per SVO frame: the IMU records received since the previous frame, and their pre-integration
+///
+struct FrameAlignEntry {
+    uint64_t frame_index;           ///< SVO position of the frame
+    uint64_t image_timestamp;       ///< nanoseconds
+    uint64_t imu_offset;            ///< byte offset of the first record of the window in the IMU log
+    uint32_t first_record;          ///< index of the first record of the window in the IMU log
+    uint32_t nb_records;            ///< records with previous image_timestamp < timestamp <= image_timestamp
+    float delta_rotation[4];        ///< quaternion x, y, z, w, rotation of the IMU since the previous frame
+    float delta_velocity[3];        ///< m/s, in the IMU frame of the previous frame, gravity included
+    float delta_position[3];        ///< m, same frame
+    float delta_time;               ///< s, time covered by the integrated records
+    uint32_t flags;                 ///< FrameAlignEntry::FLAG_*
+
+    enum {
+        FLAG_FIRST = 1,             ///< first frame of the log, the window starts at the beginning of the log
+        FLAG_INCOMPLETE = 2         ///< the log ended before a record newer than the frame was received
+    };
+};
+
+///
+/// \brief Header of the alignment index, followed by the entries
+///
+struct ImuAlignHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t header_size;
+    uint32_t entry_size;
+    uint32_t imu_header_size;       ///< of the IMU log the index refers to
+    uint32_t imu_record_size;
+    uint8_t reserved[36];
+};
+#pragma pack(pop)
+
+static_assert(sizeof(FrameAlignEntry) == 80, "FrameAlignEntry must stay 80 bytes");
+static_assert(sizeof(ImuAlignHeader) == 64, "ImuAlignHeader must stay 64 bytes");
+
+///
+/// \brief path of the alignment index of an IMU log: "file.imu" -> "file.align"
+///
+std::string alignmentPath(const std::string& imu_path);
+
+///
+/// \brief The ImuFrameAligner class
+/// Builds the alignment entries from the records (in log order) and the frame timestamps. The frames may be added
+/// before or after the records surrounding them, a frame is completed once a newer record is seen.
+/// Pre-integration is a simple Euler integration of the raw samples, without bias nor gravity compensation.
+///
+class ImuFrameAligner {
+public:
+    void addFrame(uint64_t frame_index, uint64_t image_timestamp);
+    void addRecord(const ImuRecord& record, uint32_t record_index);
+
+    ///
+    /// \brief move the completed entries to out
+    /// \param flush_before : also completes the frames older than this timestamp, whatever the records received
+    ///
+    void collect(std::vector<FrameAlignEntry>& out, uint64_t flush_before = 0);
+
+    ///
+    /// \brief new log file starting at from_timestamp: the records are forgotten, the frames not collected yet are kept
+    ///
+    void reset(uint64_t from_timestamp);
+
+private:
+    struct PendingFrame {
+        uint64_t frame_index;
+        uint64_t timestamp;
+    };
+    struct IndexedRecord {
+        ImuRecord record;
+        uint32_t index;
+    };
+
+    FrameAlignEntry complete(const PendingFrame& frame, bool incomplete);
+
+    std::deque<PendingFrame> frames;
+    std::deque<IndexedRecord> records;
+    uint64_t last_record_ts = 0;
+    uint64_t window_start = 0;      ///< exclusive, timestamp of the previous frame
+    bool first = true;
+    uint32_t next_record_index = 0;
+};
+
+///
+/// \brief The ImuAlignmentReader class
+/// Loads the alignment index of a log, the IMU window of a frame is then read with a single seek
+///
+class ImuAlignmentReader {
+public:
+    ~ImuAlignmentReader();
+
+    ///
+    /// \param imu_path : the IMU log, its index is read from alignmentPath(imu_path)
+    ///
+    bool open(const std::string& imu_path);
+    void close();
+
+    int size() const { return static_cast<int>(entries.size()); }
+    const FrameAlignEntry& operator[](int i) const { return entries[i]; }
+
+    ///
+    /// \brief entry of an SVO frame (binary search), -1 if it is not in the index
+    ///
+    int findFrame(uint64_t frame_index) const;
+
+    ///
+    /// \brief entry of the frame whose image timestamp is the closest to ts, -1 if the index is empty
+    ///
+    int findTimestamp(uint64_t ts) const;
+
+    ///
+    /// \brief read the IMU records of the window of entry i
+    ///
+    bool readWindow(int i, std::vector<ImuRecord>& records);
+
+private:
+    std::vector<FrameAlignEntry> entries;
+    FILE* imu_file = nullptr;
+};
+
+#endif
@@ -0,0 +1,164 @@
+#ifndef __IMU_LOG_HPP__
+#define __IMU_LOG_HPP__
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ImuAlignment.hpp"
+#include "ImuRecord.hpp"
+#include "SpscRing.hpp"
+
+///
+/// \brief The ImuLogWriter class
+/// The sampler thread push()es records in a lock-free ring, a writer thread drains it and writes them to the log
+/// by blocks of block_records records. A partial block is only written after max_latency_ms, or when stopping.
+/// The log can be rotated to a new file without stopping the sampler, and the files are pre-allocated by chunks
+/// (Linux) so that the filesystem does not have to find new blocks on each write.
+/// Optionally, the image timestamps given by pushFrame() are aligned with the records as they are written, in an index
+/// next to each log (see ImuAlignment.hpp).
+///
+class ImuLogWriter {
+public:
+    ///
+    /// \param ring_capacity : number of records the ring can hold while the disk is busy
+    /// \param block_records : number of records written at once
+    /// \param max_latency_ms : maximum time a record waits in memory before being written
+    ///
+    ImuLogWriter(size_t ring_capacity = 16384, size_t block_records = 1024, int max_latency_ms = 1000);
+    ~ImuLogWriter();
+
+    ///
+    /// \brief create the log file and write its header
+    ///
+    bool open(const std::string& path, uint32_t serial_number, float sampling_rate, uint64_t start_timestamp);
+
+    ///
+    /// \brief start the writer thread
+    ///
+    void start();
+
+    ///
+    /// \brief reserve the disk space of the log by chunk_bytes at a time, 0 to disable. Only effective on Linux
+    ///
+    void setPreallocation(size_t chunk_bytes) { prealloc_chunk = chunk_bytes; }
+
+    ///
+    /// \brief write the frame alignment index of each log, to call before open()
+    ///
+    void setAlignment(bool enable) { alignment = enable; }
+
+    ///
+    /// \brief continue the log in a new file, from the first record whose timestamp is >= from_timestamp.
+    /// Can be called from any thread, the switch is done by the writer thread
+    ///
+    void rotate(const std::string& path, uint64_t from_timestamp);
+
+    ///
+    /// \brief called by the sampler thread only, never blocks
+    /// \return false if the ring is full and the record was dropped
+    ///
+    bool push(const ImuRecord& record);
+
+    ///
+    /// \brief called by the grab thread only, never blocks. The frame index restarts at 0 with each rotated file
+    /// \return false if the frame ring is full and the frame will be missing from the alignment index
+    ///
+    bool pushFrame(uint64_t frame_index, uint64_t image_timestamp);
+
+    ///
+    /// \brief write the remaining records, stop the writer thread and close the file
+    /// \return false if a write failed
+    ///
+    bool close();
+
+    bool isOpen() const { return file != nullptr; }
+    uint64_t getNbWritten() const { return nb_written; }
+    uint64_t getNbDropped() const { return nb_dropped; }
+    uint64_t getNbBlocks() const { return nb_blocks; }
+    ///
+    /// \brief size of the current file, header included
+    ///
+    uint64_t getFileSize() const { return file_size; }
+    uint64_t getNbFramesAligned() const { return nb_frames_aligned; }
+    size_t getMaxRingFill() const { return max_fill; }
+    size_t getRingCapacity() const { return ring.capacity(); }
+
+private:
+    void writeLoop();
+    bool writeBlock();
+    bool openFile(const std::string& path, uint64_t start_timestamp);
+    void closeFile(uint64_t flush_before);
+    // Closes the log and the alignment index of a file that failed to open, without writing: both left to nullptr
+    void closeOnError();
+    void alignRecords(size_t first_record_index);
+    void splitForRotation(size_t first_new);
+    void switchFile(uint64_t start_timestamp);
+
+    SpscRing<ImuRecord> ring;
+    std::vector<ImuRecord> block;
+    size_t block_fill = 0;
+    int max_latency_ms;
+
+    FILE* file = nullptr;
+    uint32_t serial_number = 0;
+    float sampling_rate = 0.f;
+    size_t prealloc_chunk = 0;
+    uint64_t allocated = 0;
+    std::atomic<uint64_t> file_size{0};
+
+    struct FrameMark {
+        uint64_t frame_index;
+        uint64_t timestamp;
+    };
+    bool alignment = false;
+    SpscRing<FrameMark> frame_ring;
+    ImuFrameAligner aligner;
+    std::vector<FrameAlignEntry> aligned;
+    FILE* align_file = nullptr;
+    std::atomic<uint64_t> nb_frames_aligned{0};
+
+    std::mutex rotation_mtx;
+    std::atomic<bool> rotation_pending{false};
+    std::string rotation_path;
+    uint64_t rotation_timestamp = 0;
+    std::chrono::steady_clock::time_point rotation_request;
+
+    std::thread writer;
+    std::atomic<bool> running{false};
+    bool write_error = false;
+
+    std::atomic<uint64_t> nb_written{0}, nb_dropped{0}, nb_blocks{0};
+    std::atomic<size_t> max_fill{0};
+};
+
+///
+/// \brief The ImuLogReader class
+/// Sequential reader of a binary log, used by the CSV converter
+///
+class ImuLogReader {
+public:
+    ~ImuLogReader();
+
+    bool open(const std::string& path);
+    void close();
+
+    const ImuLogHeader& getHeader() const { return header; }
+
+    ///
+    /// \brief read up to max_records records
+    /// \return the number of records read, 0 at the end of the file
+    ///
+    size_t read(ImuRecord* records, size_t max_records);
+
+private:
+    FILE* file = nullptr;
+    ImuLogHeader header;
+};
+
+#endif
@@ -0,0 +1,41 @@
+#ifndef __IMU_RECORD_HPP__
+#define __IMU_RECORD_HPP__
+
+#include <cstdint>
+
+#define IMU_LOG_MAGIC "ZEDIMUL"
+#define IMU_LOG_VERSION 1
+
+#pragma pack(push, 1)
+///
+/// \brief One IMU sample, fixed size so that the log can be read without parsing
+///
+struct ImuRecord {
+    uint64_t timestamp;             ///< nanoseconds
+    float angular_velocity[3];      ///< deg/s
+    float linear_acceleration[3];   ///< m/s²
+    float orientation[4];           ///< quaternion x, y, z, w
+    uint32_t sequence;              ///< incremented for every sample seen by the sampler, gaps are dropped samples
+    uint32_t reserved[3];
+};
+
+///
+/// \brief Header at the beginning of the binary log
+///
+struct ImuLogHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t header_size;
+    uint32_t record_size;
+    uint32_t serial_number;
+    float sampling_rate;            ///< nominal IMU rate, Hz
+    uint32_t reserved0;
+    uint64_t start_timestamp;       ///< nanoseconds, time the log was opened
+    uint8_t reserved[24];
+};
+#pragma pack(pop)
+
+static_assert(sizeof(ImuRecord) == 64, "ImuRecord must stay 64 bytes");
+static_assert(sizeof(ImuLogHeader) == 64, "ImuLogHeader must stay 64 bytes");
+
+#endif
@@ -0,0 +1,81 @@
+#ifndef __SPSC_RING_HPP__
+#define __SPSC_RING_HPP__
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+///
+/// \brief The SpscRing class
+/// Lock-free ring buffer for exactly one producer thread and one consumer thread.
+/// The producer never blocks: push() fails when the ring is full, so that a slow disk can not stall the sampler.
+///
+template <typename T>
+class SpscRing {
+public:
+    ///
+    /// \param capacity : rounded up to a power of two
+    ///
+    explicit SpscRing(size_t capacity) {
+        size_t size = 1;
+        while (size < capacity) size <<= 1;
+        buffer.resize(size);
+        mask = size - 1;
+    }
+
+    ///
+    /// \brief producer side, copy item in the ring
+    /// \return false if the ring is full, the item is dropped
+    ///
+    bool push(const T& item) {
+        const size_t head = write_pos.load(std::memory_order_relaxed);
+        if (head - cached_read > mask) {
+            // Only read the consumer position when the ring looks full, it is the only shared cache line touched
+            cached_read = read_pos.load(std::memory_order_acquire);
+            if (head - cached_read > mask) return false;
+        }
+        buffer[head & mask] = item;
+        write_pos.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    ///
+    /// \brief consumer side, move up to max_items items to out
+    /// \return the number of items read
+    ///
+    size_t pop(T* out, size_t max_items) {
+        const size_t tail = read_pos.load(std::memory_order_relaxed);
+        if (cached_write == tail)
+            cached_write = write_pos.load(std::memory_order_acquire);
+        size_t n = cached_write - tail;
+        if (n > max_items) n = max_items;
+        for (size_t i = 0; i < n; i++)
+            out[i] = buffer[(tail + i) & mask];
+        read_pos.store(tail + n, std::memory_order_release);
+        return n;
+    }
+
+    ///
+    /// \brief number of items in the ring, only approximate while the other thread is running
+    ///
+    size_t size() const {
+        return write_pos.load(std::memory_order_acquire) - read_pos.load(std::memory_order_acquire);
+    }
+
+    size_t capacity() const { return mask + 1; }
+
+private:
+    std::vector<T> buffer;
+    size_t mask;
+
+    // The producer and consumer positions live on their own cache lines
+    char pad0[64];
+    std::atomic<size_t> write_pos{0};
+    size_t cached_read = 0; ///< producer copy of read_pos
+    char pad1[64];
+    std::atomic<size_t> read_pos{0};
+    size_t cached_write = 0; ///< consumer copy of write_pos
+    char pad2[64];
+};
+
+#endif
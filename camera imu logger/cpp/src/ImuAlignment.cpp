@@ -0,0 +1,219 @@
+#include "ImuAlignment.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#ifdef _WIN32
+#define fseek64 _fseeki64
+#else
+#define fseek64 fseeko
+#endif
+
+std::string alignmentPath(const std::string& imu_path) {
+    const std::string ext(".imu");
+    if (imu_path.size() > ext.size() && imu_path.compare(imu_path.size() - ext.size(), ext.size(), ext) == 0)
+        return imu_path.substr(0, imu_path.size() - ext.size()) + ".align";
+    return imu_path + ".align";
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Pre-integration
+
+namespace {
+struct Quat {
+    float x = 0.f, y = 0.f, z = 0.f, w = 1.f;
+};
+
+Quat multiply(const Quat& a, const Quat& b) {
+    Quat q;
+    q.w = a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z;
+    q.x = a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y;
+    q.y = a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x;
+    q.z = a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w;
+    return q;
+}
+
+// Rotation of angle |v| around v
+Quat fromRotationVector(const float v[3]) {
+    Quat q;
+    float angle = std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+    if (angle < 1e-9f) return q;
+    float s = std::sin(angle * 0.5f) / angle;
+    q.x = v[0] * s;
+    q.y = v[1] * s;
+    q.z = v[2] * s;
+    q.w = std::cos(angle * 0.5f);
+    return q;
+}
+
+void rotate(const Quat& q, const float v[3], float out[3]) {
+    // v + 2w(u x v) + 2u x (u x v), u the vector part of q
+    float tx = 2.f * (q.y * v[2] - q.z * v[1]);
+    float ty = 2.f * (q.z * v[0] - q.x * v[2]);
+    float tz = 2.f * (q.x * v[1] - q.y * v[0]);
+    out[0] = v[0] + q.w * tx + (q.y * tz - q.z * ty);
+    out[1] = v[1] + q.w * ty + (q.z * tx - q.x * tz);
+    out[2] = v[2] + q.w * tz + (q.x * ty - q.y * tx);
+}
+
+const float DEG_TO_RAD = 3.14159265358979f / 180.f;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// ImuFrameAligner
+
+void ImuFrameAligner::addFrame(uint64_t frame_index, uint64_t image_timestamp) {
+    PendingFrame frame;
+    frame.frame_index = frame_index;
+    frame.timestamp = image_timestamp;
+    frames.push_back(frame);
+}
+
+void ImuFrameAligner::addRecord(const ImuRecord& record, uint32_t record_index) {
+    IndexedRecord r;
+    r.record = record;
+    r.index = record_index;
+    records.push_back(r);
+    last_record_ts = std::max(last_record_ts, record.timestamp);
+    next_record_index = record_index + 1;
+}
+
+void ImuFrameAligner::collect(std::vector<FrameAlignEntry>& out, uint64_t flush_before) {
+    while (!frames.empty()) {
+        const PendingFrame& frame = frames.front();
+        bool ready = last_record_ts > frame.timestamp;
+        if (!ready && frame.timestamp >= flush_before) break;
+        out.push_back(complete(frame, !ready));
+        frames.pop_front();
+    }
+}
+
+void ImuFrameAligner::reset(uint64_t from_timestamp) {
+    records.clear();
+    last_record_ts = 0;
+    next_record_index = 0;
+    window_start = from_timestamp > 0 ? from_timestamp - 1 : 0;
+    first = false;
+}
+
+FrameAlignEntry ImuFrameAligner::complete(const PendingFrame& frame, bool incomplete) {
+    FrameAlignEntry entry;
+    memset(&entry, 0, sizeof(entry));
+    entry.frame_index = frame.frame_index;
+    entry.image_timestamp = frame.timestamp;
+    entry.flags = (first ? FrameAlignEntry::FLAG_FIRST : 0) | (incomplete ? FrameAlignEntry::FLAG_INCOMPLETE : 0);
+
+    // Records older than the window (frame missed, or before a reset) do not belong to any frame
+    while (!records.empty() && !first && records.front().record.timestamp <= window_start)
+        records.pop_front();
+
+    entry.first_record = records.empty() ? next_record_index : records.front().index;
+    entry.imu_offset = sizeof(ImuLogHeader) + static_cast<uint64_t>(entry.first_record) * sizeof(ImuRecord);
+
+    Quat dq;
+    float dv[3] = {0.f, 0.f, 0.f}, dp[3] = {0.f, 0.f, 0.f};
+    uint64_t previous_ts = first ? 0 : window_start;
+    double total_dt = 0.;
+    while (!records.empty() && records.front().record.timestamp <= frame.timestamp) {
+        const ImuRecord& r = records.front().record;
+        float dt = (previous_ts > 0 && r.timestamp > previous_ts) ? static_cast<float>((r.timestamp - previous_ts) * 1e-9) : 0.f;
+        previous_ts = r.timestamp;
+        total_dt += dt;
+
+        // p += v dt + R a dt² / 2, v += R a dt, R = R exp(w dt)
+        float acc[3];
+        rotate(dq, r.linear_acceleration, acc);
+        for (int i = 0; i < 3; i++) {
+            dp[i] += dv[i] * dt + 0.5f * acc[i] * dt * dt;
+            dv[i] += acc[i] * dt;
+        }
+        float rotation[3];
+        for (int i = 0; i < 3; i++)
+            rotation[i] = r.angular_velocity[i] * DEG_TO_RAD * dt;
+        dq = multiply(dq, fromRotationVector(rotation));
+
+        entry.nb_records++;
+        records.pop_front();
+    }
+
+    entry.delta_rotation[0] = dq.x;
+    entry.delta_rotation[1] = dq.y;
+    entry.delta_rotation[2] = dq.z;
+    entry.delta_rotation[3] = dq.w;
+    for (int i = 0; i < 3; i++) {
+        entry.delta_velocity[i] = dv[i];
+        entry.delta_position[i] = dp[i];
+    }
+    entry.delta_time = static_cast<float>(total_dt);
+
+    window_start = frame.timestamp;
+    first = false;
+    return entry;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// ImuAlignmentReader
+
+ImuAlignmentReader::~ImuAlignmentReader() {
+    close();
+}
+
+bool ImuAlignmentReader::open(const std::string& imu_path) {
+    close();
+    FILE* file = fopen(alignmentPath(imu_path).c_str(), "rb");
+    if (!file) return false;
+
+    ImuAlignHeader header;
+    bool ok = fread(&header, sizeof(header), 1, file) == 1 && memcmp(header.magic, IMU_ALIGN_MAGIC, sizeof(IMU_ALIGN_MAGIC)) == 0
+            && header.version == IMU_ALIGN_VERSION && header.entry_size == sizeof(FrameAlignEntry)
+            && header.imu_record_size == sizeof(ImuRecord) && fseek(file, header.header_size, SEEK_SET) == 0;
+    if (ok) {
+        // The index is small (80 bytes per frame), it is loaded at once
+        FrameAlignEntry entry;
+        while (fread(&entry, sizeof(entry), 1, file) == 1)
+            entries.push_back(entry);
+    }
+    fclose(file);
+    if (!ok) return false;
+
+    imu_file = fopen(imu_path.c_str(), "rb");
+    if (!imu_file) {
+        entries.clear();
+        return false;
+    }
+    return true;
+}
+
+void ImuAlignmentReader::close() {
+    entries.clear();
+    if (imu_file) fclose(imu_file);
+    imu_file = nullptr;
+}
+
+int ImuAlignmentReader::findFrame(uint64_t frame_index) const {
+    auto it = std::lower_bound(entries.begin(), entries.end(), frame_index,
+            [](const FrameAlignEntry& e, uint64_t f) { return e.frame_index < f; });
+    if (it == entries.end() || it->frame_index != frame_index) return -1;
+    return static_cast<int>(it - entries.begin());
+}
+
+int ImuAlignmentReader::findTimestamp(uint64_t ts) const {
+    if (entries.empty()) return -1;
+    auto it = std::lower_bound(entries.begin(), entries.end(), ts,
+            [](const FrameAlignEntry& e, uint64_t t) { return e.image_timestamp < t; });
+    if (it == entries.end()) return size() - 1;
+    int i = static_cast<int>(it - entries.begin());
+    if (i > 0 && ts - entries[i - 1].image_timestamp < it->image_timestamp - ts)
+        i--;
+    return i;
+}
+
+bool ImuAlignmentReader::readWindow(int i, std::vector<ImuRecord>& records) {
+    if (!imu_file || i < 0 || i >= size()) return false;
+    const FrameAlignEntry& entry = entries[i];
+    records.resize(entry.nb_records);
+    if (entry.nb_records == 0) return true;
+    if (fseek64(imu_file, entry.imu_offset, SEEK_SET) != 0) return false;
+    return fread(records.data(), sizeof(ImuRecord), entry.nb_records, imu_file) == entry.nb_records;
+}
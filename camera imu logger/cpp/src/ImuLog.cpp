@@ -0,0 +1,313 @@
+#include "ImuLog.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+/////////////////////////////////////////////////////////////////////////////
+// ImuLogWriter
+
+ImuLogWriter::ImuLogWriter(size_t ring_capacity, size_t block_records, int max_latency_ms_)
+    : ring(ring_capacity), block(block_records > 0 ? block_records : 1), max_latency_ms(max_latency_ms_), frame_ring(1024) {
+}
+
+ImuLogWriter::~ImuLogWriter() {
+    close();
+}
+
+bool ImuLogWriter::open(const std::string& path, uint32_t serial_number_, float sampling_rate_, uint64_t start_timestamp) {
+    close();
+    serial_number = serial_number_;
+    sampling_rate = sampling_rate_;
+    block_fill = 0;
+    write_error = false;
+    rotation_pending = false;
+    nb_written = 0;
+    nb_dropped = 0;
+    nb_blocks = 0;
+    max_fill = 0;
+    nb_frames_aligned = 0;
+    aligner = ImuFrameAligner();
+    return openFile(path, start_timestamp);
+}
+
+bool ImuLogWriter::openFile(const std::string& path, uint64_t start_timestamp) {
+    file = fopen(path.c_str(), "wb");
+    if (!file) return false;
+    // The records are already gathered in large blocks, no need for another copy in the stdio buffer
+    setvbuf(file, nullptr, _IONBF, 0);
+    allocated = 0;
+    file_size = 0;
+
+    ImuLogHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, IMU_LOG_MAGIC, sizeof(IMU_LOG_MAGIC));
+    header.version = IMU_LOG_VERSION;
+    header.header_size = sizeof(ImuLogHeader);
+    header.record_size = sizeof(ImuRecord);
+    header.serial_number = serial_number;
+    header.sampling_rate = sampling_rate;
+    header.start_timestamp = start_timestamp;
+    if (fwrite(&header, sizeof(header), 1, file) != 1) {
+        closeOnError();
+        return false;
+    }
+    file_size = sizeof(header);
+
+    if (alignment) {
+        align_file = fopen(alignmentPath(path).c_str(), "wb");
+        if (!align_file) {
+            closeOnError();
+            return false;
+        }
+        ImuAlignHeader align_header;
+        memset(&align_header, 0, sizeof(align_header));
+        memcpy(align_header.magic, IMU_ALIGN_MAGIC, sizeof(IMU_ALIGN_MAGIC));
+        align_header.version = IMU_ALIGN_VERSION;
+        align_header.header_size = sizeof(ImuAlignHeader);
+        align_header.entry_size = sizeof(FrameAlignEntry);
+        align_header.imu_header_size = sizeof(ImuLogHeader);
+        align_header.imu_record_size = sizeof(ImuRecord);
+        if (fwrite(&align_header, sizeof(align_header), 1, align_file) != 1) {
+            closeOnError();
+            return false;
+        }
+    }
+    return true;
+}
+
+void ImuLogWriter::closeOnError() {
+    if (file) fclose(file);
+    if (align_file) fclose(align_file);
+    file = nullptr;
+    align_file = nullptr;
+}
+
+void ImuLogWriter::alignRecords(size_t first_record_index) {
+    FrameMark mark;
+    while (frame_ring.pop(&mark, 1) == 1)
+        aligner.addFrame(mark.frame_index, mark.timestamp);
+    for (size_t i = 0; i < block_fill; i++)
+        aligner.addRecord(block[i], static_cast<uint32_t>(first_record_index + i));
+}
+
+void ImuLogWriter::closeFile(uint64_t flush_before) {
+    if (align_file) {
+        // The frames of this file which are still waiting for their records are completed with what was received
+        FrameMark mark;
+        while (frame_ring.pop(&mark, 1) == 1)
+            aligner.addFrame(mark.frame_index, mark.timestamp);
+        aligned.clear();
+        aligner.collect(aligned, flush_before);
+        if (!aligned.empty() && fwrite(aligned.data(), sizeof(FrameAlignEntry), aligned.size(), align_file) != aligned.size())
+            write_error = true;
+        nb_frames_aligned += aligned.size();
+        if (fclose(align_file) != 0) write_error = true;
+        align_file = nullptr;
+    }
+    if (!file) return;
+#ifdef __linux__
+    // Give back the pre-allocated space which was not used
+    if (allocated > file_size && ftruncate(fileno(file), file_size) != 0)
+        write_error = true;
+#endif
+    if (fclose(file) != 0) write_error = true;
+    file = nullptr;
+}
+
+void ImuLogWriter::start() {
+    if (!file || running) return;
+    running = true;
+    writer = std::thread(&ImuLogWriter::writeLoop, this);
+}
+
+void ImuLogWriter::rotate(const std::string& path, uint64_t from_timestamp) {
+    std::lock_guard<std::mutex> lock(rotation_mtx);
+    rotation_path = path;
+    rotation_timestamp = from_timestamp;
+    rotation_request = std::chrono::steady_clock::now();
+    rotation_pending = true;
+}
+
+bool ImuLogWriter::push(const ImuRecord& record) {
+    if (ring.push(record)) return true;
+    nb_dropped.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+bool ImuLogWriter::pushFrame(uint64_t frame_index, uint64_t image_timestamp) {
+    FrameMark mark;
+    mark.frame_index = frame_index;
+    mark.timestamp = image_timestamp;
+    return frame_ring.push(mark);
+}
+
+bool ImuLogWriter::close() {
+    running = false;
+    if (writer.joinable()) writer.join();
+    closeFile(UINT64_MAX);
+    return !write_error;
+}
+
+bool ImuLogWriter::writeBlock() {
+    if (block_fill == 0) return true;
+    size_t bytes = block_fill * sizeof(ImuRecord);
+    if (!file)
+        write_error = true;
+    else {
+#ifdef __linux__
+        if (prealloc_chunk > 0 && file_size + bytes > allocated) {
+            // Reserve the next chunk now rather than letting the filesystem allocate on every block,
+            // KEEP_SIZE so that the file never shows unwritten records
+            uint64_t size = allocated + std::max<uint64_t>(prealloc_chunk, bytes);
+            if (fallocate(fileno(file), FALLOC_FL_KEEP_SIZE, 0, size) == 0)
+                allocated = size;
+            else
+                prealloc_chunk = 0; // not supported by this filesystem
+        }
+#endif
+        if (align_file) {
+            alignRecords((file_size - sizeof(ImuLogHeader)) / sizeof(ImuRecord));
+            aligned.clear();
+            aligner.collect(aligned);
+            if (!aligned.empty() && fwrite(aligned.data(), sizeof(FrameAlignEntry), aligned.size(), align_file) != aligned.size())
+                write_error = true;
+            nb_frames_aligned += aligned.size();
+        }
+        if (fwrite(block.data(), sizeof(ImuRecord), block_fill, file) != block_fill)
+            write_error = true;
+        file_size += bytes;
+    }
+    nb_written += block_fill;
+    nb_blocks++;
+    block_fill = 0;
+    return !write_error;
+}
+
+void ImuLogWriter::switchFile(uint64_t start_timestamp) {
+    std::string path;
+    {
+        std::lock_guard<std::mutex> lock(rotation_mtx);
+        path = rotation_path;
+        rotation_pending = false;
+    }
+    // The frames before the new file are all in the current one
+    closeFile(start_timestamp);
+    aligner.reset(start_timestamp);
+    if (!openFile(path, start_timestamp))
+        write_error = true;
+}
+
+void ImuLogWriter::splitForRotation(size_t first_new) {
+    uint64_t from_timestamp;
+    {
+        std::lock_guard<std::mutex> lock(rotation_mtx);
+        from_timestamp = rotation_timestamp;
+    }
+    size_t split = first_new;
+    while (split < block_fill && block[split].timestamp < from_timestamp) split++;
+    if (split == block_fill) return; // all the records still belong to the current file
+
+    // The records before the split end the current file, the others start the new one
+    size_t remaining = block_fill - split;
+    std::vector<ImuRecord> next(block.begin() + split, block.begin() + block_fill);
+    block_fill = split;
+    writeBlock();
+    switchFile(from_timestamp);
+    std::copy(next.begin(), next.end(), block.begin());
+    block_fill = remaining;
+}
+
+void ImuLogWriter::writeLoop() {
+    // Move everything available in the ring to the block, writing the full blocks
+    auto drain = [this]() {
+        while (true) {
+            size_t fill = ring.size();
+            if (fill > max_fill) max_fill = fill;
+            if (block_fill == block.size()) writeBlock();
+            size_t n = ring.pop(block.data() + block_fill, block.size() - block_fill);
+            if (n == 0) break;
+            size_t first_new = block_fill;
+            block_fill += n;
+            if (rotation_pending) splitForRotation(first_new);
+        }
+    };
+
+    const auto max_latency = std::chrono::milliseconds(max_latency_ms);
+    // The ring holds seconds of data, polling it every few ms costs nothing and keeps the sampler wait-free
+    const auto idle = std::chrono::milliseconds(10);
+    auto last_write = std::chrono::steady_clock::now();
+
+    while (running) {
+        uint64_t nb_blocks_before = nb_blocks;
+        drain();
+        auto now = std::chrono::steady_clock::now();
+        if (rotation_pending) {
+            // No sample reached the rotation time yet (IMU stopped?), do not wait forever
+            std::unique_lock<std::mutex> lock(rotation_mtx);
+            bool expired = now - rotation_request >= max_latency;
+            uint64_t from_timestamp = rotation_timestamp;
+            lock.unlock();
+            if (expired) {
+                writeBlock();
+                switchFile(from_timestamp);
+            }
+        }
+        if (nb_blocks != nb_blocks_before)
+            last_write = now;
+        else if (block_fill > 0 && now - last_write >= max_latency) {
+            writeBlock();
+            last_write = now;
+        }
+        std::this_thread::sleep_for(idle);
+    }
+
+    // Stop requested, the sampler does not push anymore: write what is left
+    drain();
+    writeBlock();
+    if (rotation_pending) {
+        std::unique_lock<std::mutex> lock(rotation_mtx);
+        uint64_t from_timestamp = rotation_timestamp;
+        lock.unlock();
+        switchFile(from_timestamp);
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// ImuLogReader
+
+ImuLogReader::~ImuLogReader() {
+    close();
+}
+
+bool ImuLogReader::open(const std::string& path) {
+    close();
+    file = fopen(path.c_str(), "rb");
+    if (!file) return false;
+    if (fread(&header, sizeof(header), 1, file) != 1 || memcmp(header.magic, IMU_LOG_MAGIC, sizeof(IMU_LOG_MAGIC)) != 0
+            || header.version != IMU_LOG_VERSION || header.record_size != sizeof(ImuRecord) || header.header_size < sizeof(ImuLogHeader)) {
+        close();
+        return false;
+    }
+    // Newer headers may be larger, the records start right after
+    if (fseek(file, header.header_size, SEEK_SET) != 0) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void ImuLogReader::close() {
+    if (file) fclose(file);
+    file = nullptr;
+}
+
+size_t ImuLogReader::read(ImuRecord* records, size_t max_records) {
+    if (!file) return 0;
+    return fread(records, sizeof(ImuRecord), max_records, file);
+}
@@ -0,0 +1,136 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+/***********************************************************************
+ ** Frame -> IMU window lookup: alignment index (one seek per frame)  **
+ ** versus a linear scan of the log, on a synthetic recording.        **
+ ***********************************************************************/
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ImuAlignment.hpp"
+#include "ImuLog.hpp"
+
+// Synthetic recording: IMU at imu_rate, frames at fps, as the logger would write them
+static bool writeRecording(const std::string& path, float imu_rate, float fps, float duration_s) {
+    ImuLogWriter log;
+    log.setAlignment(true);
+    if (!log.open(path, 0, imu_rate, 0)) return false;
+    log.start();
+
+    const uint64_t imu_period = static_cast<uint64_t>(1e9 / imu_rate);
+    const uint64_t frame_period = static_cast<uint64_t>(1e9 / fps);
+    const uint64_t end = static_cast<uint64_t>(duration_s * 1e9);
+    uint64_t next_frame = frame_period, frame_index = 0;
+    uint32_t sequence = 0;
+    for (uint64_t ts = imu_period; ts <= end; ts += imu_period) {
+        ImuRecord record;
+        memset(&record, 0, sizeof(record));
+        record.timestamp = ts;
+        record.angular_velocity[2] = 10.f;
+        record.linear_acceleration[2] = 9.81f;
+        record.orientation[3] = 1.f;
+        record.sequence = sequence++;
+        // Much faster than real time, wait for the writer rather than dropping
+        while (!log.push(record))
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        if (ts >= next_frame) {
+            while (!log.pushFrame(frame_index, next_frame))
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            frame_index++;
+            next_frame += frame_period;
+        }
+    }
+    return log.close();
+}
+
+// What a consumer without index does: read the log from the beginning until the frame window is found
+static size_t scanWindow(const std::string& path, uint64_t window_start, uint64_t window_end, std::vector<ImuRecord>& window) {
+    ImuLogReader reader;
+    window.clear();
+    if (!reader.open(path)) return 0;
+    std::vector<ImuRecord> records(4096);
+    size_t n;
+    while ((n = reader.read(records.data(), records.size())) > 0) {
+        for (size_t i = 0; i < n; i++) {
+            if (records[i].timestamp > window_end) return window.size();
+            if (records[i].timestamp > window_start) window.push_back(records[i]);
+        }
+    }
+    return window.size();
+}
+
+int main(int argc, char **argv) {
+    float duration = (argc > 1) ? static_cast<float>(atof(argv[1])) : 600.f;
+    int nb_queries = (argc > 2) ? atoi(argv[2]) : 200;
+    std::string folder = (argc > 3) ? std::string(argv[3]) : std::string(".");
+    std::string path = folder + "/imu_align_bench.imu";
+    const float imu_rate = 400.f, fps = 30.f;
+
+    std::cout << "Writing " << duration << "s of synthetic recording (IMU " << imu_rate << "Hz, images " << fps << "FPS)" << std::endl;
+    if (!writeRecording(path, imu_rate, fps, duration)) {
+        std::cout << "[Sample][Error] Could not write " << path << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    ImuAlignmentReader index;
+    if (!index.open(path)) {
+        std::cout << "[Sample][Error] Could not read the alignment index of " << path << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::cout << index.size() << " frames in the index" << std::endl;
+
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> pick(1, index.size() - 1);
+    std::vector<int> queries(nb_queries);
+    for (auto& q : queries) q = pick(rng);
+
+    std::vector<ImuRecord> window;
+    size_t total_index = 0, total_scan = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int q : queries) {
+        index.readWindow(q, window);
+        total_index += window.size();
+    }
+    double index_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / nb_queries;
+
+    start = std::chrono::steady_clock::now();
+    for (int q : queries)
+        total_scan += scanWindow(path, index[q - 1].image_timestamp, index[q].image_timestamp, window);
+    double scan_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / nb_queries;
+
+    printf("Index lookup : %10.1f us/frame\n", index_us);
+    printf("Linear scan  : %10.1f us/frame (x%.0f)\n", scan_us, scan_us / index_us);
+    if (total_index != total_scan)
+        std::cout << "[Sample][Error] The windows differ: " << total_index << " vs " << total_scan << " records" << std::endl;
+
+    index.close();
+    remove(path.c_str());
+    remove(alignmentPath(path).c_str());
+    return total_index == total_scan ? EXIT_SUCCESS : EXIT_FAILURE;
+}
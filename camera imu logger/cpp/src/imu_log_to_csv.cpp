@@ -0,0 +1,86 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+/***********************************************************************
+ ** Offline conversion of a binary IMU log to CSV                      **
+ ***********************************************************************/
+
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "ImuLog.hpp"
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        std::cout << "Usage: \n\n";
+        std::cout << "    ZED_Imu_Log_To_CSV  log_file.imu [output.csv]\n\n";
+        std::cout << "The CSV is written next to the log by default.\n";
+        return EXIT_FAILURE;
+    }
+    std::string log_path(argv[1]);
+    std::string csv_path = (argc > 2) ? std::string(argv[2]) : log_path + ".csv";
+
+    ImuLogReader reader;
+    if (!reader.open(log_path)) {
+        std::cout << "[Sample][Error] " << log_path << " is not a valid IMU log" << std::endl;
+        return EXIT_FAILURE;
+    }
+    FILE* csv = fopen(csv_path.c_str(), "w");
+    if (!csv) {
+        std::cout << "[Sample][Error] Could not create " << csv_path << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    const ImuLogHeader& header = reader.getHeader();
+    std::cout << "Camera S/N " << header.serial_number << ", IMU rate " << header.sampling_rate << " Hz" << std::endl;
+
+    // Same columns as the former text logger, followed by the orientation
+    fprintf(csv, "timestamp_us,gyro_x,gyro_y,gyro_z,acc_x,acc_y,acc_z,orientation_x,orientation_y,orientation_z,orientation_w\n");
+
+    std::vector<ImuRecord> records(4096);
+    uint64_t nb_records = 0, nb_missing = 0;
+    bool first = true;
+    uint32_t expected_sequence = 0;
+    size_t n;
+    while ((n = reader.read(records.data(), records.size())) > 0) {
+        for (size_t i = 0; i < n; i++) {
+            const ImuRecord& r = records[i];
+            if (!first && r.sequence != expected_sequence)
+                nb_missing += static_cast<uint32_t>(r.sequence - expected_sequence);
+            first = false;
+            expected_sequence = r.sequence + 1;
+
+            fprintf(csv, "%llu,%g,%g,%g,%g,%g,%g,%g,%g,%g,%g\n", static_cast<unsigned long long>(r.timestamp / 1000),
+                    r.angular_velocity[0], r.angular_velocity[1], r.angular_velocity[2],
+                    r.linear_acceleration[0], r.linear_acceleration[1], r.linear_acceleration[2],
+                    r.orientation[0], r.orientation[1], r.orientation[2], r.orientation[3]);
+        }
+        nb_records += n;
+    }
+
+    bool ok = (fclose(csv) == 0);
+    std::cout << nb_records << " samples written to " << csv_path;
+    if (nb_missing)
+        std::cout << ", " << nb_missing << " samples were dropped while logging";
+    std::cout << std::endl;
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,145 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+/***********************************************************************
+ ** IMU logger benchmark with a synthetic source, no camera needed:   **
+ **  - CPU usage of the logger at a fixed rate (400 Hz by default)     **
+ **  - maximum sample rate the logger sustains without dropping        **
+ ***********************************************************************/
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/resource.h>
+#include <sys/time.h>
+#endif
+
+#include "ImuLog.hpp"
+
+// CPU time used by the whole process, all threads
+static double processCpuSeconds() {
+#ifdef _WIN32
+    FILETIME creation, exit, kernel, user;
+    GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user);
+    auto toSeconds = [](const FILETIME& t) { return ((static_cast<uint64_t>(t.dwHighDateTime) << 32) | t.dwLowDateTime) * 1e-7; };
+    return toSeconds(kernel) + toSeconds(user);
+#else
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * 1e-6;
+#endif
+}
+
+static ImuRecord syntheticRecord(uint32_t sequence, uint64_t timestamp) {
+    ImuRecord record;
+    memset(&record, 0, sizeof(record));
+    record.timestamp = timestamp;
+    float t = timestamp * 1e-9f;
+    for (int i = 0; i < 3; i++) {
+        record.angular_velocity[i] = std::sin(t + i);
+        record.linear_acceleration[i] = std::cos(t + i);
+    }
+    record.orientation[3] = 1.f;
+    record.sequence = sequence;
+    return record;
+}
+
+struct BenchResult {
+    uint64_t nb_pushed = 0, nb_written = 0, nb_dropped = 0;
+    double seconds = 0, cpu_seconds = 0;
+    size_t max_fill = 0;
+};
+
+///
+/// \brief log synthetic samples for duration_s seconds
+/// \param rate : samples per second, 0 to push as fast as possible
+///
+static BenchResult runLogger(const std::string& path, float rate, float duration_s) {
+    BenchResult result;
+    ImuLogWriter log;
+    if (!log.open(path, 0, rate, 0)) {
+        std::cout << "[Sample][Error] Could not create " << path << std::endl;
+        return result;
+    }
+
+    double cpu_start = processCpuSeconds();
+    auto start = std::chrono::steady_clock::now();
+    auto end = start + std::chrono::microseconds(static_cast<int64_t>(duration_s * 1e6));
+    log.start();
+
+    uint32_t sequence = 0;
+    if (rate > 0) {
+        // Paced like the camera sampler: one sample per period, the thread sleeps in between
+        const std::chrono::nanoseconds period(static_cast<int64_t>(1e9 / rate));
+        auto next = start;
+        while (next < end) {
+            std::this_thread::sleep_until(next);
+            log.push(syntheticRecord(sequence++, std::chrono::duration_cast<std::chrono::nanoseconds>(next - start).count()));
+            next += period;
+        }
+    } else {
+        uint64_t ts = 0;
+        while (std::chrono::steady_clock::now() < end) {
+            for (int i = 0; i < 256; i++, ts += 1000)
+                log.push(syntheticRecord(sequence++, ts));
+        }
+    }
+
+    log.close();
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    result.cpu_seconds = processCpuSeconds() - cpu_start;
+    result.nb_pushed = sequence;
+    result.nb_written = log.getNbWritten();
+    result.nb_dropped = log.getNbDropped();
+    result.max_fill = log.getMaxRingFill();
+    remove(path.c_str());
+    return result;
+}
+
+int main(int argc, char **argv) {
+    float rate = (argc > 1) ? static_cast<float>(atof(argv[1])) : 400.f;
+    float duration = (argc > 2) ? static_cast<float>(atof(argv[2])) : 10.f;
+    std::string folder = (argc > 3) ? std::string(argv[3]) : std::string(".");
+    std::string path = folder + "/imu_logger_bench.imu";
+
+    std::cout << "Synthetic source at " << rate << " Hz for " << duration << "s" << std::endl;
+    BenchResult paced = runLogger(path, rate, duration);
+    printf("  %llu samples written, %llu dropped, ring max fill %zu\n", static_cast<unsigned long long>(paced.nb_written),
+            static_cast<unsigned long long>(paced.nb_dropped), paced.max_fill);
+    printf("  CPU usage (sampler + writer): %.2f%% of one core\n", 100. * paced.cpu_seconds / paced.seconds);
+
+    std::cout << "Unthrottled source for 2s" << std::endl;
+    BenchResult max = runLogger(path, 0.f, 2.f);
+    printf("  %llu samples pushed, %llu written, %llu dropped\n", static_cast<unsigned long long>(max.nb_pushed),
+            static_cast<unsigned long long>(max.nb_written), static_cast<unsigned long long>(max.nb_dropped));
+    // What reached the disk is what the writer sustains, the drops are what the ring could not absorb
+    printf("  Maximum sustainable rate: %.0f samples/s (%.1f MB/s)\n", max.nb_written / max.seconds,
+            max.nb_written * sizeof(ImuRecord) / max.seconds / 1e6);
+    return EXIT_SUCCESS;
+}
@@ -6,95 +6,96 @@
 // Standard includes
 #include <stdio.h>
 #include <string.h>
-#include <Windows.h>
+#include <chrono>
 #include <ctime>
-#include <thread>
-#include <fstream>
+#include <iostream>
+#include <sys/stat.h>
+#include <sys/types.h>
+#ifdef _WIN32
+#include <direct.h>
+#endif
 
 // ZED include
 #include <sl/Camera.hpp>
 
-static bool exit_app = false;
-// File name for where imu data will be logged to, since logging is done on a separate thread
-// we make this global
-static std::string imu_file_name;
+// Sample includes
+#include "ImuLog.hpp"
+#include "SensorStream.hpp"
+#include "utils.hpp"
 
 // Create a ZED Camera object
 static sl::Camera zed;
 
-// Handle the CTRL-C keyboard signal
-void CtrlHandler(DWORD fdwCtrlType) {
-    exit_app = (fdwCtrlType == CTRL_C_EVENT);
-}
-
-// Set the function to handle the CTRL-C
-void SetCtrlHandler() {
-    SetConsoleCtrlHandler((PHANDLER_ROUTINE)CtrlHandler, TRUE);
-}
-
 void print(std::string msg_prefix, 
            sl::ERROR_CODE err_code = sl::ERROR_CODE::SUCCESS, 
            std::string msg_suffix = "");
 
-// Basic structure to compare timestamps of a sensor. Determines if a specific sensor data has been updated or not.
-struct TimestampHandler {
+static bool fileExists(const std::string& path) {
+    struct stat info;
+    return stat(path.c_str(), &info) == 0;
+}
 
-    // Compare the new timestamp to the last valid one. If it is higher, save it as new reference.
-    inline bool isNew(sl::Timestamp& ts_curr, sl::Timestamp& ts_ref) {
-        bool new_ = ts_curr > ts_ref;
-        if (new_) ts_ref = ts_curr;
-        return new_;
-    }
-    // Specific function for IMUData.
-    inline bool isNew(sl::SensorsData::IMUData& imu_data) {
-        return isNew(imu_data.timestamp, ts_imu);
-    }
-    // Specific function for MagnetometerData.
-    inline bool isNew(sl::SensorsData::MagnetometerData& mag_data) {
-        return isNew(mag_data.timestamp, ts_mag);
-    }
-    // Specific function for BarometerData.
-    inline bool isNew(sl::SensorsData::BarometerData& baro_data) {
-        return isNew(baro_data.timestamp, ts_baro);
-    }
+static uint64_t fileSize(const std::string& path) {
+    struct stat info;
+    return (stat(path.c_str(), &info) == 0) ? static_cast<uint64_t>(info.st_size) : 0;
+}
 
-    sl::Timestamp ts_imu = 0, ts_baro = 0, ts_mag = 0; // Initial values
-};
+static bool createFolder(const std::string& path) {
+    if (fileExists(path)) return true;
+#ifdef _WIN32
+    return _mkdir(path.c_str()) == 0;
+#else
+    return mkdir(path.c_str(), 0755) == 0;
+#endif
+}
 
+// Base name of a recording segment, the SVO and the IMU log share it: folder/YYYY_MM_DD_HH_MM_SS
+static std::string segmentName(const std::string& folder) {
+    time_t rawtime;
+    time(&rawtime);
+    char buffer[64];
+    std::strftime(buffer, sizeof(buffer), "%Y_%m_%d_%H_%M_%S", localtime(&rawtime));
+    std::string name = folder + "/" + buffer;
+    // Several segments may start within the same second
+    std::string unique_name = name;
+    for (int i = 1; fileExists(unique_name + ".svo") || fileExists(unique_name + ".imu"); i++)
+        unique_name = name + "_" + std::to_string(i);
+    return unique_name;
+}
 
-void logImuData() {
-    std::ofstream imu_file(imu_file_name, std::ios::out);
-    if (!imu_file.is_open()) {
-        std::cout << "Could not open imu file \n\t" << imu_file_name << std::endl;
-        return;
+// Record of a new IMU sample, as written to the log
+static ImuRecord toImuRecord(const sl::SensorsData::IMUData& imu, uint32_t sequence) {
+    ImuRecord record;
+    memset(&record, 0, sizeof(record));
+    record.timestamp = imu.timestamp.getNanoseconds();
+    for (int i = 0; i < 3; i++) {
+        record.angular_velocity[i] = imu.angular_velocity[i];
+        record.linear_acceleration[i] = imu.linear_acceleration[i];
     }
-    std::cout << "Opened imu file " << imu_file_name << std::endl;
-
-    // Used to store sensors timestamps and check if new data is available.
-    TimestampHandler ts;
+    sl::Orientation orientation = imu.pose.getOrientation();
+    for (int i = 0; i < 4; i++)
+        record.orientation[i] = orientation[i];
+    record.sequence = sequence;
+    return record;
+}
 
-    // Used to store sensors data.
-    sl::SensorsData sensors_data;
+int main(int argc, char **argv) {
 
-    while (!exit_app) {
-        if (zed.getSensorsData(sensors_data, sl::TIME_REFERENCE::CURRENT) == sl::ERROR_CODE::SUCCESS) {
-            if (ts.isNew(sensors_data.imu)) {
-                imu_file << sensors_data.imu.timestamp.getMicroseconds() << ","
-                    << sensors_data.imu.angular_velocity[0] << ","
-                    << sensors_data.imu.angular_velocity[1] << ","
-                    << sensors_data.imu.angular_velocity[2] << ","
-                    << sensors_data.imu.linear_acceleration[0] << ","
-                    << sensors_data.imu.linear_acceleration[1] << ","
-                    << sensors_data.imu.linear_acceleration[2] << "\n";
-            }
-        }
+    if (argc > 1 && (std::string(argv[1]) == "-h" || std::string(argv[1]) == "--help")) {
+        std::cout << "Usage: \n\n";
+        std::cout << "    ZED_CameraImuLogger [output_folder=.] [max_file_size_MB=0] [max_file_duration_s=0]\n\n";
+        std::cout << "A new SVO / IMU log pair is started when one of the limits is reached, 0 disables it.\n";
+        return EXIT_SUCCESS;
     }
+    std::string output_folder = (argc > 1) ? std::string(argv[1]) : std::string(".");
+    uint64_t max_file_size = (argc > 2) ? static_cast<uint64_t>(atof(argv[2]) * 1024 * 1024) : 0;
+    int max_file_duration = (argc > 3) ? atoi(argv[3]) : 0;
 
-    imu_file.close();
-}
+    if (!createFolder(output_folder)) {
+        print("Could not create the output folder " + output_folder, sl::ERROR_CODE::FAILURE);
+        return EXIT_FAILURE;
+    }
 
-int main(int argc, char **argv) {
-    
     sl::InitParameters init_parameters;
     init_parameters.camera_resolution= sl::RESOLUTION::HD2K;
     // We are just logging data, so we dont need to compute depth
@@ -107,41 +108,94 @@ int main(int argc, char **argv) {
         return EXIT_FAILURE;
     }
 
-    // Setup output svo file name
-    time_t rawtime;
-    struct tm* time_info;
-    char buffer[256];
-    time(&rawtime);
-    time_info = localtime(&rawtime);
-
-    std::strftime(buffer, sizeof(buffer), "C:\\Users\\aclare\\Documents\\%Y_%m_%d_%H_%M_%S.svo", time_info);
-    std::string svo_file_name(buffer);
-    std::strftime(buffer, sizeof(buffer), "C:\\Users\\aclare\\Documents\\%Y_%m_%d_%H_%M_%S.imu", time_info);
-    imu_file_name = std::string(buffer);
-
-    std::cout << "SVO: " << svo_file_name << std::endl;
-    std::cout << "IMU: " << imu_file_name << std::endl;
+    // Setup output file names
+    std::string segment = segmentName(output_folder);
+    std::cout << "SVO: " << segment << ".svo" << std::endl;
+    std::cout << "IMU: " << segment << ".imu" << std::endl;
 
-    sl::String svo_name = sl::String(svo_file_name.c_str());
     returned_state = zed.enableRecording(
-        sl::RecordingParameters(svo_name, sl::SVO_COMPRESSION_MODE::H264));
+        sl::RecordingParameters(sl::String((segment + ".svo").c_str()), sl::SVO_COMPRESSION_MODE::H264));
     if (returned_state != sl::ERROR_CODE::SUCCESS) {
         print("Recording ZED : ", returned_state);
         zed.close();
         return EXIT_FAILURE;
     }
 
-    std::thread imu_thread(logImuData);
+    auto camera_infos = zed.getCameraInformation();
+    float imu_rate = camera_infos.sensors_configuration.accelerometer_parameters.sampling_rate;
+
+    // Binary log, convert it with ZED_Imu_Log_To_CSV
+    ImuLogWriter imu_log;
+    // About 10 minutes of IMU data at 400Hz per allocation
+    imu_log.setPreallocation(16 * 1024 * 1024);
+    // Frame -> IMU records index next to each log
+    imu_log.setAlignment(true);
+    if (!imu_log.open(segment + ".imu", camera_infos.serial_number, imu_rate, zed.getTimestamp(sl::TIME_REFERENCE::CURRENT).getNanoseconds())) {
+        print("Could not open imu file " + segment + ".imu", sl::ERROR_CODE::FAILURE);
+        zed.disableRecording();
+        zed.close();
+        return EXIT_FAILURE;
+    }
+    imu_log.start();
+
+    // The stream reads the IMU at its own rate, its thread hands the new samples to the log writer and never touches the disk.
+    // No queue: the samples only go to the log
+    CameraSensorSource sensor_source(zed);
+    SensorStream imu_stream(sensor_source, 0);
+    uint32_t sequence = 0;
+    imu_stream.subscribe([&imu_log, &sequence](const SensorSample& sample) {
+        imu_log.push(toImuRecord(sample.data.imu, sequence++));
+    });
+    imu_stream.start();
 
     SetCtrlHandler();
+    print("Recording, use Ctrl-C to stop.");
+    auto segment_start = std::chrono::steady_clock::now();
+    auto last_check = segment_start;
+    uint64_t frame_index = 0, last_image_ts = 0;
     while (!exit_app) {
         // Check that a new image is successfully acquired
         returned_state = zed.grab();
+        if (returned_state == sl::ERROR_CODE::SUCCESS && zed.getRecordingStatus().status) {
+            // The frame was added to the SVO, at position frame_index
+            last_image_ts = zed.getTimestamp(sl::TIME_REFERENCE::IMAGE).getNanoseconds();
+            imu_log.pushFrame(frame_index++, last_image_ts);
+        }
+
+        // Rotation check, once per second is enough
+        auto now = std::chrono::steady_clock::now();
+        if (now - last_check < std::chrono::seconds(1)) continue;
+        last_check = now;
+        bool rotate = (max_file_duration > 0 && now - segment_start >= std::chrono::seconds(max_file_duration))
+                || (max_file_size > 0 && fileSize(segment + ".svo") + imu_log.getFileSize() >= max_file_size);
+        if (!rotate) continue;
+
+        // The SVO is closed and the next one opened between two grabs, the IMU log follows from the last frame of
+        // the previous SVO: the samples received until the first frame of the new SVO are in its window
+        std::string next_segment = segmentName(output_folder);
+        zed.disableRecording();
+        returned_state = zed.enableRecording(
+            sl::RecordingParameters(sl::String((next_segment + ".svo").c_str()), sl::SVO_COMPRESSION_MODE::H264));
+        if (returned_state != sl::ERROR_CODE::SUCCESS) {
+            print("Recording ZED : ", returned_state);
+            exit_app = true;
+            break;
+        }
+        imu_log.rotate(next_segment + ".imu", last_image_ts + 1);
+        frame_index = 0;
+        segment = next_segment;
+        segment_start = now;
+        print("New segment " + segment);
     }
 
     // Exit
+    exit_app = true;
     zed.disableRecording();
-    imu_thread.join();
+    imu_stream.stop();
+    if (!imu_log.close())
+        print("Error while writing the IMU log", sl::ERROR_CODE::FAILURE);
+    std::cout << "IMU: " << imu_log.getNbWritten() << " samples written, " << imu_log.getNbDropped() << " dropped, ring max fill "
+            << imu_log.getMaxRingFill() << "/" << imu_log.getRingCapacity() << ", " << imu_stream.getStats().nb_missed << " missed by the sampler" << std::endl;
     zed.close();
     return EXIT_SUCCESS;
 }
@@ -0,0 +1,78 @@
+#ifndef __FRAME_AGE_HPP__
+#define __FRAME_AGE_HPP__
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+///
+/// \brief The FrameAgeStats class
+/// Age of the frames at a stage of the receiver (grab, display...): the host time of the stage minus the sender
+/// image timestamp, so capture, encoding, network, decoding and the receiver pipeline up to that stage. The sender
+/// and receiver clocks have to be synchronized (NTP, PTP) for the absolute values to be meaningful.
+/// Percentiles are computed over the last window_size frames.
+///
+class FrameAgeStats {
+public:
+    explicit FrameAgeStats(size_t window_size = 1000) : window_size(window_size) {}
+
+    void add(double age_ms);
+    void add(uint64_t image_timestamp_ns, uint64_t now_ns) { add((static_cast<double>(now_ns) - static_cast<double>(image_timestamp_ns)) * 1e-6); }
+
+    ///
+    /// \param p : in [0, 1], 0.5 for the median
+    ///
+    double percentile(double p) const;
+    double getMax() const;
+    uint64_t getCount() const { return count; }
+    void reset();
+
+private:
+    size_t window_size;
+    std::deque<double> ages;
+    uint64_t count = 0;
+};
+
+///
+/// \brief The StreamHealth class
+/// Frames received and lost over an interval, the lost frames being the gaps in the sender timestamps
+///
+class StreamHealth {
+public:
+    ///
+    /// \param fps : framerate of the sender
+    ///
+    explicit StreamHealth(float fps);
+
+    void addFrame(uint64_t image_timestamp_ns);
+
+    ///
+    /// \brief received fps and loss ratio since the previous call
+    ///
+    void getInterval(double interval_s, float& received_fps, float& loss);
+
+private:
+    uint64_t period_ns;
+    uint64_t last_timestamp = 0;
+    uint64_t nb_received = 0, nb_lost = 0;
+};
+
+///
+/// \brief The FeedbackSender class
+/// Sends the receiver report to the sender adaptive bitrate, one UDP datagram "ZEDFB <received_fps> <loss> <latency_ms>".
+/// latency_ms is a frame age, receiver clock minus sender timestamp: without synchronized clocks it includes their offset,
+/// it is a relative signal whose variations show the queuing in the network
+///
+class FeedbackSender {
+public:
+    ~FeedbackSender();
+    bool open(const std::string& ip, unsigned short port);
+    bool send(float received_fps, float loss, float latency_ms);
+
+private:
+    long long sock = -1;
+    std::vector<unsigned char> address;
+};
+
+#endif
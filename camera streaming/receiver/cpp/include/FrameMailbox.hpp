@@ -0,0 +1,108 @@
+#ifndef __FRAME_MAILBOX_HPP__
+#define __FRAME_MAILBOX_HPP__
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+///
+/// \brief The FrameMailbox class
+/// Latest-wins mailbox between one producer (the grab thread) and any number of consumers (display, processing...).
+/// The producer never waits: post() replaces the previous frame, which consumers that were too slow never see.
+/// Each consumer keeps the sequence number of the last frame it read and gets only newer ones.
+/// The frames are shared, not copied: a consumer keeps its frame alive as long as it holds the pointer, and
+/// acquire() gives the producer a pooled buffer that nobody holds anymore, so the memory is allocated only once.
+///
+template <typename T>
+class FrameMailbox {
+public:
+    ///
+    /// \param nb_buffers : pooled buffers, at least one per consumer plus one being written and one in the mailbox
+    ///
+    explicit FrameMailbox(int nb_buffers = 4) {
+        for (int i = 0; i < nb_buffers; i++) pool.push_back(std::make_shared<T>());
+    }
+
+    ///
+    /// \brief producer side, a buffer not referenced by the mailbox nor by any consumer
+    /// \return nullptr if all the buffers are held (a consumer keeps several frames)
+    ///
+    std::shared_ptr<T> acquire() {
+        std::lock_guard<std::mutex> lock(mtx);
+        for (auto& buffer : pool)
+            if (buffer.use_count() == 1) return buffer;
+        nb_no_buffer++;
+        return nullptr;
+    }
+
+    ///
+    /// \brief producer side, makes frame the latest one and wakes the consumers
+    /// \return the sequence number of the frame
+    ///
+    uint64_t post(std::shared_ptr<T> frame) {
+        uint64_t seq;
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            latest = std::move(frame);
+            seq = ++sequence;
+        }
+        cv.notify_all();
+        return seq;
+    }
+
+    ///
+    /// \brief consumer side, waits for a frame newer than last_seq
+    /// \param last_seq : sequence of the last frame read by this consumer, updated
+    /// \param nb_skipped : incremented by the number of frames this consumer missed
+    /// \return nullptr after timeout_ms or after close()
+    ///
+    std::shared_ptr<const T> wait(uint64_t& last_seq, int timeout_ms, uint64_t* nb_skipped = nullptr) {
+        std::unique_lock<std::mutex> lock(mtx);
+        if (!cv.wait_for(lock, std::chrono::milliseconds(timeout_ms), [&] { return closed || sequence > last_seq; }) || sequence <= last_seq)
+            return nullptr;
+        if (nb_skipped && last_seq > 0) *nb_skipped += sequence - last_seq - 1;
+        last_seq = sequence;
+        return latest;
+    }
+
+    ///
+    /// \brief consumer side, the newest frame if newer than last_seq, without waiting
+    ///
+    std::shared_ptr<const T> tryGet(uint64_t& last_seq, uint64_t* nb_skipped = nullptr) {
+        return wait(last_seq, 0, nb_skipped);
+    }
+
+    ///
+    /// \brief wakes up all the consumers, wait() returns nullptr from now on
+    ///
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            closed = true;
+        }
+        cv.notify_all();
+    }
+
+    uint64_t getSequence() {
+        std::lock_guard<std::mutex> lock(mtx);
+        return sequence;
+    }
+    uint64_t getNbNoBuffer() {
+        std::lock_guard<std::mutex> lock(mtx);
+        return nb_no_buffer;
+    }
+
+private:
+    std::mutex mtx;
+    std::condition_variable cv;
+    std::vector<std::shared_ptr<T>> pool;
+    std::shared_ptr<T> latest;
+    uint64_t sequence = 0;
+    uint64_t nb_no_buffer = 0;
+    bool closed = false;
+};
+
+#endif
@@ -0,0 +1,124 @@
+#ifndef __RELAY_SERVER_HPP__
+#define __RELAY_SERVER_HPP__
+
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "FrameMailbox.hpp"
+
+///
+/// \brief Encoding of the frames re-streamed by the relay
+///
+enum class RelayFormat : uint32_t {
+    BGRA = 0,   ///< raw pixels, step bytes per row
+    JPEG = 1
+};
+
+///
+/// \brief Header sent before each frame on the relay TCP connections, in the byte order of the host
+///
+struct RelayFrameHeader {
+    char magic[4] = {'Z', 'R', 'L', 'Y'};
+    uint32_t format = 0;        ///< RelayFormat
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t step = 0;          ///< bytes per row, BGRA only
+    uint32_t size = 0;          ///< bytes of the payload that follows
+    uint64_t timestamp = 0;     ///< sender capture time, in ns
+    uint64_t seq = 0;           ///< sequence of the frame at the relay, the gaps are the frames skipped for this client
+};
+
+///
+/// \brief The RelayServer class
+/// Re-streams the frames of the relay to TCP clients. Each frame is copied once in a pooled buffer shared by all the
+/// clients (FrameMailbox), then every client thread sends the same buffer: the cost of a client is a send() per
+/// frame, no encoding nor copy. A client that cannot keep up skips frames (latest wins) and does not slow down the
+/// others nor the relay. The clients that left are reaped by the accept thread within 500ms.
+///
+class RelayServer {
+public:
+    ///
+    /// \param max_clients : more connections are refused, the frame pool has max_clients + 2 buffers
+    ///
+    explicit RelayServer(int max_clients = 16);
+    ~RelayServer();
+
+    ///
+    /// \param bind_ip : "127.0.0.1" to serve the local host only
+    ///
+    bool open(unsigned short port, const std::string& bind_ip = "0.0.0.0");
+    void close();
+
+    ///
+    /// \brief copies the frame in the pool and wakes up the clients, never waits for them
+    /// \return false if no client is connected (nothing copied) or no buffer is free
+    ///
+    bool publish(RelayFormat format, uint32_t width, uint32_t height, uint32_t step, uint64_t timestamp, const void* data, size_t size);
+
+    int getNbClients() const { return nb_clients; }
+    uint64_t getNbDropped() const { return nb_dropped; }
+    ///
+    /// \brief client sockets still open: the connected clients, and the ones that left less than a reap period ago
+    ///
+    size_t getNbConnections();
+
+private:
+    struct Frame {
+        RelayFrameHeader header;
+        std::vector<uint8_t> payload;
+    };
+    struct Client {
+        long long sock = -1;
+        std::thread thread;
+        std::atomic<bool> done{false};
+    };
+
+    void acceptLoop();
+    void clientLoop(Client& client);
+    ///
+    /// \brief joins the threads of the clients that left and closes their socket, clients_mtx locked
+    ///
+    void reapClients();
+
+    const int max_clients;
+    FrameMailbox<Frame> mailbox;
+    long long listen_sock = -1;
+    std::atomic<bool> running{false};
+    std::atomic<int> nb_clients{0};
+    std::atomic<uint64_t> nb_dropped{0};
+    std::thread accept_thread;
+    std::mutex clients_mtx;
+    std::list<Client> clients;
+};
+
+///
+/// \brief The RelayClient class
+/// Reads the frames of a RelayServer
+///
+class RelayClient {
+public:
+    ~RelayClient();
+
+    bool connect(const std::string& ip, unsigned short port);
+    void close();
+
+    ///
+    /// \brief blocking, false when the connection is closed
+    ///
+    bool read(RelayFrameHeader& header, std::vector<uint8_t>& payload);
+
+private:
+    long long sock = -1;
+};
+
+///
+/// \brief Initializes the socket library (Windows), once per process
+///
+bool relayNetworkInit();
+
+#endif
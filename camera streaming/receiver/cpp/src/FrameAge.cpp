@@ -0,0 +1,90 @@
+#include "FrameAge.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+void FrameAgeStats::add(double age_ms) {
+    ages.push_back(age_ms);
+    if (ages.size() > window_size) ages.pop_front();
+    count++;
+}
+
+double FrameAgeStats::percentile(double p) const {
+    if (ages.empty()) return 0.;
+    std::vector<double> sorted(ages.begin(), ages.end());
+    size_t index = std::min(sorted.size() - 1, static_cast<size_t>(std::max(0., p) * sorted.size()));
+    std::nth_element(sorted.begin(), sorted.begin() + index, sorted.end());
+    return sorted[index];
+}
+
+double FrameAgeStats::getMax() const {
+    return ages.empty() ? 0. : *std::max_element(ages.begin(), ages.end());
+}
+
+void FrameAgeStats::reset() {
+    ages.clear();
+    count = 0;
+}
+
+StreamHealth::StreamHealth(float fps) : period_ns(static_cast<uint64_t>(1e9 / std::max(1.f, fps))) {}
+
+void StreamHealth::addFrame(uint64_t timestamp) {
+    // A gap of N periods is N - 1 lost frames, the half period margin absorbs the jitter
+    if (last_timestamp && timestamp > last_timestamp) {
+        uint64_t periods = (timestamp - last_timestamp + period_ns / 2) / period_ns;
+        if (periods > 1) nb_lost += periods - 1;
+    }
+    if (timestamp > last_timestamp) last_timestamp = timestamp;
+    nb_received++;
+}
+
+void StreamHealth::getInterval(double interval_s, float& received_fps, float& loss) {
+    received_fps = interval_s > 0. ? static_cast<float>(nb_received / interval_s) : 0.f;
+    loss = (nb_received + nb_lost) ? static_cast<float>(nb_lost) / (nb_received + nb_lost) : 0.f;
+    nb_received = nb_lost = 0;
+}
+
+FeedbackSender::~FeedbackSender() {
+    if (sock < 0) return;
+#ifdef _WIN32
+    closesocket(static_cast<SOCKET>(sock));
+    WSACleanup();
+#else
+    close(static_cast<int>(sock));
+#endif
+}
+
+bool FeedbackSender::open(const std::string& ip, unsigned short port) {
+#ifdef _WIN32
+    WSADATA wsa_data;
+    if (WSAStartup(MAKEWORD(2, 2), &wsa_data) != 0) return false;
+#endif
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    if (inet_pton(AF_INET, ip.c_str(), &addr.sin_addr) != 1) return false;
+    sock = static_cast<long long>(socket(AF_INET, SOCK_DGRAM, 0));
+    if (sock < 0) return false;
+    address.resize(sizeof(addr));
+    memcpy(address.data(), &addr, sizeof(addr));
+    return true;
+}
+
+bool FeedbackSender::send(float received_fps, float loss, float latency_ms) {
+    if (sock < 0) return false;
+    char message[96];
+    int size = snprintf(message, sizeof(message), "ZEDFB %.2f %.4f %.2f", received_fps, loss, latency_ms);
+    return sendto(sock, message, size, 0, reinterpret_cast<const sockaddr*>(address.data()), static_cast<int>(address.size())) == size;
+}
@@ -0,0 +1,239 @@
+#include "RelayServer.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#define SHUT_RDWR SD_BOTH
+#define SOCKET_TYPE SOCKET
+#else
+#include <arpa/inet.h>
+#include <csignal>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#define SOCKET_TYPE int
+#endif
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+namespace {
+void closeSocket(long long sock) {
+    if (sock < 0) return;
+#ifdef _WIN32
+    closesocket(static_cast<SOCKET>(sock));
+#else
+    ::close(static_cast<int>(sock));
+#endif
+}
+
+bool sendAll(long long sock, const void* data, size_t size) {
+    const char* ptr = static_cast<const char*>(data);
+    while (size > 0) {
+        int sent = send(sock, ptr, static_cast<int>(std::min(size, static_cast<size_t>(1 << 30))), MSG_NOSIGNAL);
+        if (sent <= 0) return false;
+        ptr += sent;
+        size -= sent;
+    }
+    return true;
+}
+
+bool recvAll(long long sock, void* data, size_t size) {
+    char* ptr = static_cast<char*>(data);
+    while (size > 0) {
+        int received = recv(sock, ptr, static_cast<int>(std::min(size, static_cast<size_t>(1 << 30))), 0);
+        if (received <= 0) return false;
+        ptr += received;
+        size -= received;
+    }
+    return true;
+}
+
+void setNoDelay(long long sock) {
+    int flag = 1;
+    setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&flag), sizeof(flag));
+}
+
+// Wait for a connection on sock for timeout_ms at most
+bool waitReadable(long long sock, int timeout_ms) {
+    fd_set read_set;
+    FD_ZERO(&read_set);
+    FD_SET(static_cast<SOCKET_TYPE>(sock), &read_set);
+    timeval timeout = {timeout_ms / 1000, (timeout_ms % 1000) * 1000};
+    return select(static_cast<int>(sock + 1), &read_set, nullptr, nullptr, &timeout) > 0;
+}
+
+const uint32_t MAX_FRAME_SIZE = 64 << 20;
+// Period of the accept loop, the connections of the clients that left are closed at this pace
+const int REAP_PERIOD_MS = 500;
+}
+
+bool relayNetworkInit() {
+#ifdef _WIN32
+    static bool initialized = false;
+    if (!initialized) {
+        WSADATA wsa_data;
+        initialized = WSAStartup(MAKEWORD(2, 2), &wsa_data) == 0;
+    }
+    return initialized;
+#else
+    // A client that disconnects must not kill the relay (platforms without MSG_NOSIGNAL)
+    signal(SIGPIPE, SIG_IGN);
+    return true;
+#endif
+}
+
+RelayServer::RelayServer(int max_clients_) : max_clients(std::max(1, max_clients_)), mailbox(std::max(1, max_clients_) + 2) {}
+
+RelayServer::~RelayServer() {
+    close();
+}
+
+bool RelayServer::open(unsigned short port, const std::string& bind_ip) {
+    if (running || !relayNetworkInit()) return false;
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    if (inet_pton(AF_INET, bind_ip.c_str(), &addr.sin_addr) != 1) return false;
+
+    listen_sock = static_cast<long long>(socket(AF_INET, SOCK_STREAM, 0));
+    if (listen_sock < 0) return false;
+    int reuse = 1;
+    setsockopt(listen_sock, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&reuse), sizeof(reuse));
+    if (bind(listen_sock, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0 || listen(listen_sock, max_clients) != 0) {
+        closeSocket(listen_sock);
+        listen_sock = -1;
+        return false;
+    }
+    running = true;
+    accept_thread = std::thread(&RelayServer::acceptLoop, this);
+    return true;
+}
+
+void RelayServer::close() {
+    if (!running.exchange(false)) return;
+    // shutdown() wakes up the threads blocked in accept() or send()
+    shutdown(listen_sock, SHUT_RDWR);
+    accept_thread.join();
+    closeSocket(listen_sock);
+    listen_sock = -1;
+    mailbox.close();
+    std::lock_guard<std::mutex> lock(clients_mtx);
+    for (auto& client : clients) shutdown(client.sock, SHUT_RDWR);
+    for (auto& client : clients) {
+        client.thread.join();
+        closeSocket(client.sock);
+    }
+    clients.clear();
+}
+
+size_t RelayServer::getNbConnections() {
+    std::lock_guard<std::mutex> lock(clients_mtx);
+    return clients.size();
+}
+
+void RelayServer::reapClients() {
+    // The sockets are closed here, after their thread ended, so close() never shuts down a reused descriptor
+    for (auto it = clients.begin(); it != clients.end();) {
+        if (it->done) {
+            it->thread.join();
+            closeSocket(it->sock);
+            it = clients.erase(it);
+        } else
+            ++it;
+    }
+}
+
+void RelayServer::acceptLoop() {
+    while (running) {
+        // accept() only once a connection is pending, so that the clients that left are reaped even without new client
+        bool pending = waitReadable(listen_sock, REAP_PERIOD_MS);
+        long long sock = pending ? static_cast<long long>(accept(listen_sock, nullptr, nullptr)) : -1;
+        std::lock_guard<std::mutex> lock(clients_mtx);
+        reapClients();
+        if (sock < 0) continue;
+        if (!running || nb_clients >= max_clients) {
+            closeSocket(sock);
+            continue;
+        }
+        setNoDelay(sock);
+        clients.emplace_back();
+        Client& client = clients.back();
+        client.sock = sock;
+        nb_clients++;
+        client.thread = std::thread(&RelayServer::clientLoop, this, std::ref(client));
+    }
+}
+
+void RelayServer::clientLoop(Client& client) {
+    uint64_t last_seq = 0;
+    while (running) {
+        auto frame = mailbox.wait(last_seq, 200);
+        if (!frame) continue;
+        if (!sendAll(client.sock, &frame->header, sizeof(frame->header)) || !sendAll(client.sock, frame->payload.data(), frame->payload.size()))
+            break;
+    }
+    nb_clients--;
+    client.done = true;
+}
+
+bool RelayServer::publish(RelayFormat format, uint32_t width, uint32_t height, uint32_t step, uint64_t timestamp, const void* data, size_t size) {
+    if (!running || nb_clients == 0 || size > MAX_FRAME_SIZE) return false;
+    auto frame = mailbox.acquire();
+    if (!frame) {
+        nb_dropped++;
+        return false;
+    }
+    frame->header.format = static_cast<uint32_t>(format);
+    frame->header.width = width;
+    frame->header.height = height;
+    frame->header.step = step;
+    frame->header.size = static_cast<uint32_t>(size);
+    frame->header.timestamp = timestamp;
+    frame->header.seq = mailbox.getSequence() + 1;
+    // assign() keeps the capacity of the buffer, no allocation once the pool is warm
+    frame->payload.assign(static_cast<const uint8_t*>(data), static_cast<const uint8_t*>(data) + size);
+    mailbox.post(frame);
+    return true;
+}
+
+RelayClient::~RelayClient() {
+    close();
+}
+
+bool RelayClient::connect(const std::string& ip, unsigned short port) {
+    close();
+    if (!relayNetworkInit()) return false;
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    if (inet_pton(AF_INET, ip.c_str(), &addr.sin_addr) != 1) return false;
+    sock = static_cast<long long>(socket(AF_INET, SOCK_STREAM, 0));
+    if (sock < 0) return false;
+    if (::connect(sock, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0) {
+        close();
+        return false;
+    }
+    setNoDelay(sock);
+    return true;
+}
+
+void RelayClient::close() {
+    closeSocket(sock);
+    sock = -1;
+}
+
+bool RelayClient::read(RelayFrameHeader& header, std::vector<uint8_t>& payload) {
+    if (sock < 0 || !recvAll(sock, &header, sizeof(header))) return false;
+    if (memcmp(header.magic, "ZRLY", 4) != 0 || header.size > MAX_FRAME_SIZE) {
+        close();
+        return false;
+    }
+    payload.resize(header.size);
+    return recvAll(sock, payload.data(), header.size);
+}
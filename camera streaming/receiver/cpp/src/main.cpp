@@ -21,11 +21,20 @@
 /*********************************************************************************
  ** This sample demonstrates how to capture and process the streaming video feed **
  ** provided by an application that uses the ZED SDK with streaming enabled.     **
+ ** The grab runs on its own thread and keeps only the newest frame, the display **
+ ** and processing threads read it, so a slow display does not delay the grab.   **
+ ** The age of the frames (sender capture to receiver) is printed every second.  **
  **********************************************************************************/
 
 // Standard includes
 #include <stdio.h>
 #include <string.h>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 // ZED include
 #include <sl/Camera.hpp>
@@ -33,12 +42,41 @@
 // OpenCV include (for display)
 #include <opencv2/opencv.hpp>
 
+// Sample includes
+#include "DisplayMode.hpp"
+#include "FrameAge.hpp"
+#include "FrameMailbox.hpp"
+#include "MatBridge.hpp"
+#include "ZedFrameSource.hpp"
+
 // Using std and sl namespaces
 using namespace std;
 using namespace sl;
 
+// Calls to the Camera asked by the main thread (keyboard), run by the grab thread between two grabs:
+// the Camera is never used by two threads at once
+class CameraCommands {
+public:
+    void post(function<void(Camera&)> command) {
+        lock_guard<mutex> lock(mtx);
+        commands.push_back(move(command));
+    }
+    void run(Camera& zed) {
+        vector<function<void(Camera&)>> pending;
+        {
+            lock_guard<mutex> lock(mtx);
+            pending.swap(commands);
+        }
+        for (auto& command : pending) command(zed);
+    }
+
+private:
+    mutex mtx;
+    vector<function<void(Camera&)>> commands;
+};
+
 // Sample functions
-void updateCameraSettings(char key, sl::Camera &zed);
+void updateCameraSettings(char key, CameraCommands& commands);
 void switchCameraSettings();
 void switchViewMode();
 void printHelp();
@@ -46,11 +84,29 @@ void print(string msg_prefix, ERROR_CODE err_code = ERROR_CODE::SUCCESS, string
 
 // Sample variables
 VIDEO_SETTINGS camera_settings_ = VIDEO_SETTINGS::BRIGHTNESS;
-VIEW view_mode = VIEW::LEFT;
+atomic<VIEW> view_mode(VIEW::LEFT);
 string str_camera_settings = "BRIGHTNESS";
 int step_camera_setting = 1;
 bool led_on = true;
 
+// A frame of the stream, shared by the grab thread and the consumers
+struct ReceivedFrame {
+    Mat image;
+    cv::Mat cv_image;           // shares the buffer of image
+    uint64_t timestamp = 0;     // sender capture time
+};
+
+// Frame age and stream health, updated by the threads and printed by the main loop
+struct ReceiverStats {
+    mutex mtx;
+    FrameAgeStats grab_age, display_age;
+    StreamHealth health;
+    uint64_t nb_display_skipped = 0, nb_processing_skipped = 0;
+    double brightness = 0.;
+
+    explicit ReceiverStats(float fps) : health(fps) {}
+};
+
 
 bool selectInProgress = false;
 sl::Rect selection_rect;
@@ -90,26 +146,85 @@ static void onMouse(int event, int x, int y, int, void*)
     }
 }
 
-vector< string> split(const string& s, char seperator) {
-    vector< string> output;
-    string::size_type prev_pos = 0, pos = 0;
-
-    while ((pos = s.find(seperator, pos)) != string::npos) {
-        string substring(s.substr(prev_pos, pos - prev_pos));
-        output.push_back(substring);
-        prev_pos = ++pos;
+/**
+    Grab thread: grabs as soon as a frame is available and posts it to the mailbox, never waits for the consumers
+ **/
+void grabLoop(Camera& zed, FrameMailbox<ReceivedFrame>& mailbox, CameraCommands& commands, ReceiverStats& stats, atomic<bool>& run) {
+    uint64_t nb_no_buffer = 0;
+    while (run) {
+        // The camera settings changed since the previous grab
+        commands.run(zed);
+        auto returned_state = zed.grab();
+        if (returned_state != ERROR_CODE::SUCCESS) {
+            print("Error during capture : ", returned_state);
+            break;
+        }
+        auto frame = mailbox.acquire();
+        if (!frame) {
+            // All the buffers are held by the consumers, this frame is dropped
+            if ((++nb_no_buffer % 100) == 1) print("No free buffer, frame dropped");
+            continue;
+        }
+        zed.retrieveImage(frame->image, view_mode.load());
+        // The buffer is reallocated when the view changes, the cv::Mat is made again each time
+        frame->cv_image = toCvMat(frame->image);
+        frame->timestamp = zed.getTimestamp(TIME_REFERENCE::IMAGE).getNanoseconds();
+        {
+            lock_guard<mutex> lock(stats.mtx);
+            stats.grab_age.add(frame->timestamp, getCurrentTimeStamp().getNanoseconds());
+            stats.health.addFrame(frame->timestamp);
+        }
+        mailbox.post(frame);
     }
+    run = false;
+    mailbox.close();
+}
 
-    output.push_back(s.substr(prev_pos, pos - prev_pos));
-    return output;
+/**
+    Source thread, without sender: posts the frames of a FrameSource (synthetic, images, raw container) at the rate of
+    their timestamps, as a stream would, until the end of the source. The capture times start at the first frame
+ **/
+void sourceLoop(FrameSource& frames, FrameMailbox<ReceivedFrame>& mailbox, ReceiverStats& stats, atomic<bool>& run) {
+    FrameBundle bundle;
+    uint64_t nb_no_buffer = 0, first_timestamp = 0;
+    const uint64_t start_ns = getCurrentTimeStamp().getNanoseconds();
+    const auto start = chrono::steady_clock::now();
+    while (run && frames.read(bundle) == FRAME_STATUS::FRAME) {
+        if (bundle.index == 0) first_timestamp = bundle.timestamp;
+        const uint64_t offset = bundle.timestamp - first_timestamp;
+        this_thread::sleep_until(start + chrono::nanoseconds(offset));
+        auto frame = mailbox.acquire();
+        if (!frame) {
+            if ((++nb_no_buffer % 100) == 1) print("No free buffer, frame dropped");
+            continue;
+        }
+        toCvMat(bundle.image).copyTo(frame->cv_image);
+        frame->timestamp = start_ns + offset;
+        {
+            lock_guard<mutex> lock(stats.mtx);
+            stats.grab_age.add(frame->timestamp, getCurrentTimeStamp().getNanoseconds());
+            stats.health.addFrame(frame->timestamp);
+        }
+        mailbox.post(frame);
+    }
+    run = false;
+    mailbox.close();
 }
 
-void setStreamParameter(InitParameters& init_p, string& argument) {
-    vector< string> configStream = split(argument, ':');
-    String ip(configStream.at(0).c_str());
-    if (configStream.size() == 2) {
-        init_p.input.setFromStream(ip, atoi(configStream.at(1).c_str()));
-    } else init_p.input.setFromStream(ip);
+/**
+    Processing thread: an example of a consumer independent of the display, the mean brightness of the newest frame
+ **/
+void processingLoop(FrameMailbox<ReceivedFrame>& mailbox, ReceiverStats& stats, atomic<bool>& run) {
+    uint64_t last_seq = 0, nb_skipped = 0;
+    while (run) {
+        auto frame = mailbox.wait(last_seq, 100, &nb_skipped);
+        if (!frame) continue;
+        cv::Scalar mean = cv::mean(frame->cv_image);
+        double brightness = (frame->cv_image.channels() == 1) ? mean[0] : (mean[0] + mean[1] + mean[2]) / 3.;
+        lock_guard<mutex> lock(stats.mtx);
+        stats.brightness = brightness;
+        stats.nb_processing_skipped = nb_skipped;
+    }
 }
 
 int main(int argc, char **argv) {
@@ -135,86 +250,172 @@ int main(int argc, char **argv) {
     init_parameters.coordinate_system = COORDINATE_SYSTEM::RIGHT_HANDED_Y_UP; // OpenGL's coordinate system is right_handed
     init_parameters.sdk_verbose = true;
 
-    string stream_params;
-    if (argc > 1) {
-        stream_params = string(argv[1]);
+    DisplayMode display;
+    if (!display.parse(argc, argv)) return EXIT_FAILURE;
+
+    // IP:[port] of the sender, or --source of frames without camera (synthetic, images, raw) to run without sender
+    FrameSourceOptions source;
+    if (!source.parse(argc, argv)) return EXIT_FAILURE;
+    string stream_params, feedback_params;
+    for (int i = 1; i < argc; i++) {
+        string arg(argv[i]);
+        if (arg == "--feedback" && i + 1 < argc)
+            feedback_params = argv[++i];
+        else
+            stream_params = arg;
+    }
+    // No input given
+    if (source.kind == FRAME_SOURCE::CAMERA && source.resolution.empty()) {
+        if (stream_params.empty()) {
+            cout << "\nOpening the stream requires the IP of the sender\n";
+            cout << "Usage : ./ZED_Streaming_Receiver IP:[port] [--feedback IP:port] " << DisplayMode::usage() << "\n";
+            cout << "        ./ZED_Streaming_Receiver --source synthetic|images:<directory>|raw:<file.zraw> [--frames N] [--fps N]\n";
+            cout << "You can specify it now, then press ENTER, 'IP:[port]': ";
+            cin >> stream_params;
+        }
+        source.parseInput(stream_params);
+    }
+    if (source.usesCamera() && source.kind != FRAME_SOURCE::STREAM) {
+        cout << "[Sample][Error] Invalid stream address " << (stream_params.empty() ? source.describe() : stream_params) << ", expected IP:[port]" << endl;
+        return EXIT_FAILURE;
+    }
+    unique_ptr<FrameSource> frames;
+    if (source.usesCamera()) {
+        if (!applyFrameSource(source, init_parameters)) return EXIT_FAILURE;
     } else {
-        cout << "\nOpening the stream requires the IP of the sender\n";
-        cout << "Usage : ./ZED_Streaming_Receiver IP:[port]\n";
-        cout << "You can specify it now, then press ENTER, 'IP:[port]': ";
-        cin >> stream_params;
+        frames = FrameSource::create(source);
+        if (!frames || !frames->open()) return EXIT_FAILURE;
     }
 
-    setStreamParameter(init_parameters, stream_params);
-
     cv::String win_name = "Camera Remote Control";
-    cv::namedWindow(win_name);
-    cv::setMouseCallback(win_name, onMouse);
+    if (!display.headless()) {
+        cv::namedWindow(win_name);
+        cv::setMouseCallback(win_name, onMouse);
+    }
 
-    // Open the camera
-    auto returned_state = zed.open(init_parameters);
-    if (returned_state != ERROR_CODE::SUCCESS) {
-        print("Camera Open", returned_state, "Exit program.");
-        return EXIT_FAILURE;
+    if (!frames) {
+        // Open the camera
+        auto returned_state = zed.open(init_parameters);
+        if (returned_state != ERROR_CODE::SUCCESS) {
+            print("Camera Open", returned_state, "Exit program.");
+            return EXIT_FAILURE;
+        }
+
+        // Print camera information
+        auto camera_info = zed.getCameraInformation();
+        cout << endl;
+        cout << "ZED Model                 : " << camera_info.camera_model << endl;
+        cout << "ZED Serial Number         : " << camera_info.serial_number << endl;
+        cout << "ZED Camera Firmware       : " << camera_info.camera_configuration.firmware_version << "/" << camera_info.sensors_configuration.firmware_version << endl;
+        cout << "ZED Camera Resolution     : " << camera_info.camera_configuration.resolution.width << "x" << camera_info.camera_configuration.resolution.height << endl;
+        cout << "ZED Camera FPS            : " << zed.getInitParameters().camera_fps << endl;
     }
 
-    // Print camera information
-    auto camera_info = zed.getCameraInformation();
-    cout << endl;
-    cout << "ZED Model                 : " << camera_info.camera_model << endl;
-    cout << "ZED Serial Number         : " << camera_info.serial_number << endl;
-    cout << "ZED Camera Firmware       : " << camera_info.camera_configuration.firmware_version << "/" << camera_info.sensors_configuration.firmware_version << endl;
-    cout << "ZED Camera Resolution     : " << camera_info.camera_configuration.resolution.width << "x" << camera_info.camera_configuration.resolution.height << endl;
-    cout << "ZED Camera FPS            : " << zed.getInitParameters().camera_fps << endl;
+    // Report of the link to the sender, for its adaptive bitrate (--feedback-port of the sender)
+    FeedbackSender feedback;
+    if (!feedback_params.empty()) {
+        string feedback_ip;
+        int feedback_port = 0;
+        if (!parseIPv4(feedback_params, feedback_ip, feedback_port) || !feedback_port || !feedback.open(feedback_ip, static_cast<unsigned short>(feedback_port)))
+            print("Invalid feedback address " + feedback_params + ", no report sent to the sender");
+    }
 
     // Print help in console
-    printHelp();
+    if (!display.headless()) printHelp();
 
-    // Create a Mat to store images
-    Mat image;
+    // Initialise camera setting, the keys of the camera settings do nothing without sender
+    if (!frames) switchCameraSettings();
 
-    // Initialise camera setting
-    switchCameraSettings();
+    // 4 buffers: the one being written, the one in the mailbox, one per consumer (display and processing)
+    FrameMailbox<ReceivedFrame> mailbox(4);
+    CameraCommands commands;
+    ReceiverStats stats(frames ? static_cast<float>(source.fps) : static_cast<float>(zed.getInitParameters().camera_fps));
+    atomic<bool> run(true);
+    thread grab_thread = frames ? thread(sourceLoop, ref(*frames), ref(mailbox), ref(stats), ref(run))
+                                : thread(grabLoop, ref(zed), ref(mailbox), ref(commands), ref(stats), ref(run));
+    thread processing_thread(processingLoop, ref(mailbox), ref(stats), ref(run));
 
-    // Capture new images until 'q' is pressed
+    // Display the newest frame until 'q' is pressed
     char key = ' ';
-    while (key != 'q') {
-        // Check that a new image is successfully acquired
-        returned_state = zed.grab();
-        if (returned_state == ERROR_CODE::SUCCESS) {
-            // Retrieve left image
-            zed.retrieveImage(image, view_mode);
-
-            // Convert sl::Mat to cv::Mat (share buffer)
-            cv::Mat cvImage(image.getHeight(), image.getWidth(), (image.getChannels() == 1) ? CV_8UC1 : CV_8UC4, image.getPtr<sl::uchar1>(sl::MEM::CPU));
-            
-            //Check that selection rectangle is valid and draw it on the image
-            if (!selection_rect.isEmpty() && selection_rect.isContained(sl::Resolution(cvImage.cols, cvImage.rows)))
-                cv::rectangle(cvImage, cv::Rect(selection_rect.x,selection_rect.y,selection_rect.width,selection_rect.height),cv::Scalar(0, 255, 0), 2);
+    uint64_t last_seq = 0, nb_display_skipped = 0;
+    cv::Mat display_image;
+    auto last_print = chrono::steady_clock::now();
+    while (key != 'q' && run) {
+        auto frame = mailbox.wait(last_seq, 100, &nb_display_skipped);
+        if (frame && !display.nextFrame()) break;
+        if (frame && display.hasSink()) {
+            FrameResult result;
+            result.timestamp = frame->timestamp;
+            result.image = frame->cv_image.data;
+            result.width = frame->cv_image.cols;
+            result.height = frame->cv_image.rows;
+            result.channels = frame->cv_image.channels();
+            result.step = frame->cv_image.step;
+            {
+                lock_guard<mutex> lock(stats.mtx);
+                result.text = "brightness " + to_string(stats.brightness);
+            }
+            display.publish(result);
+        }
+        if (frame && display.renderFrame()) {
+            cv::Mat cvImage = frame->cv_image;
+            //Check that selection rectangle is valid and draw it on a copy, the frame is shared with the other consumers
+            if (!selection_rect.isEmpty() && selection_rect.isContained(sl::Resolution(cvImage.cols, cvImage.rows))) {
+                cvImage.copyTo(display_image);
+                cv::rectangle(display_image, cv::Rect(selection_rect.x,selection_rect.y,selection_rect.width,selection_rect.height),cv::Scalar(0, 255, 0), 2);
+                cvImage = display_image;
+            }
 
             // Display image with OpenCV
             cv::imshow(win_name, cvImage);
 
-        } else {
-            print("Error during capture : ", returned_state);
-            break;
+            lock_guard<mutex> lock(stats.mtx);
+            stats.display_age.add(frame->timestamp, getCurrentTimeStamp().getNanoseconds());
+            stats.nb_display_skipped = nb_display_skipped;
         }
 
-        key = cv::waitKey(5);
-        // Change camera settings with keyboard
-        updateCameraSettings(key, zed);
+        if (display.renderFrame()) {
+            key = cv::waitKey(1);
+            // Change camera settings with keyboard, applied by the grab thread
+            updateCameraSettings(key, commands);
+        }
+
+        auto now = chrono::steady_clock::now();
+        double elapsed = chrono::duration<double>(now - last_print).count();
+        if (elapsed >= 1.) {
+            last_print = now;
+            lock_guard<mutex> lock(stats.mtx);
+            float received_fps, loss;
+            stats.health.getInterval(elapsed, received_fps, loss);
+            printf("[Sample] %.1f FPS, loss %.1f%% | frame age grab p50 %.0fms p99 %.0fms, display p50 %.0fms p99 %.0fms | skipped: display %llu, processing %llu | brightness %.0f\n",
+                    received_fps, loss * 100.f, stats.grab_age.percentile(0.5), stats.grab_age.percentile(0.99), stats.display_age.percentile(0.5),
+                    stats.display_age.percentile(0.99), (unsigned long long)stats.nb_display_skipped, (unsigned long long)stats.nb_processing_skipped, stats.brightness);
+            // The frame age at grab covers the network, not the display. The clocks of the sender and receiver may differ by
+            // an unknown offset: the sender only uses the variations of this latency (above its recent minimum), not its value
+            feedback.send(received_fps, loss, static_cast<float>(stats.grab_age.percentile(0.5)));
+            // Percentiles of the last second only
+            stats.grab_age.reset();
+            stats.display_age.reset();
+        }
     }
 
     // Exit
+    run = false;
+    mailbox.close();
+    grab_thread.join();
+    processing_thread.join();
     zed.close();
     return EXIT_SUCCESS;
 }
 
 /**
-    This function updates camera settings
+    This function updates camera settings. The calls to the Camera are posted to the grab thread, with the current setting
  **/
-void updateCameraSettings(char key, sl::Camera &zed) {
-    int current_value;
+void updateCameraSettings(char key, CameraCommands& commands) {
+    const VIDEO_SETTINGS setting = camera_settings_;
+    const string name = str_camera_settings;
+    const int step = step_camera_setting;
+    const sl::Rect rect = selection_rect;
 
     // Keyboard shortcuts
     switch (key) {
@@ -227,47 +428,50 @@ void updateCameraSettings(char key, sl::Camera &zed) {
             // Switch to the next camera parameter
         case 's':
             switchCameraSettings();
-            current_value = zed.getCameraSettings(camera_settings_);
             break;
 
             // Increase camera settings value ('+' key)
         case '+':
-            current_value = zed.getCameraSettings(camera_settings_);
-            zed.setCameraSettings(camera_settings_, current_value + step_camera_setting);
-            print(str_camera_settings + ": " + to_string(zed.getCameraSettings(camera_settings_)));
+            commands.post([=](Camera& zed) {
+                int current_value = zed.getCameraSettings(setting);
+                zed.setCameraSettings(setting, current_value + step);
+                print(name + ": " + to_string(zed.getCameraSettings(setting)));
+            });
             break;
 
             // Decrease camera settings value ('-' key)
         case '-':
-            current_value = zed.getCameraSettings(camera_settings_);
-            current_value = current_value > 0 ? current_value - step_camera_setting : 0; // take care of the 'default' value parameter:  VIDEO_SETTINGS_VALUE_AUTO
-            zed.setCameraSettings(camera_settings_, current_value);
-            print(str_camera_settings + ": " + to_string(zed.getCameraSettings(camera_settings_)));
+            commands.post([=](Camera& zed) {
+                int current_value = zed.getCameraSettings(setting);
+                current_value = current_value > 0 ? current_value - step : 0; // take care of the 'default' value parameter:  VIDEO_SETTINGS_VALUE_AUTO
+                zed.setCameraSettings(setting, current_value);
+                print(name + ": " + to_string(zed.getCameraSettings(setting)));
+            });
             break;
 
             //switch LED On :
         case 'l':
             led_on = !led_on;
-            zed.setCameraSettings(sl::VIDEO_SETTINGS::LED_STATUS, led_on);
+            commands.post([led = led_on](Camera& zed) { zed.setCameraSettings(sl::VIDEO_SETTINGS::LED_STATUS, led); });
             break;
 
             // Reset to default parameters
         case 'r':
             print("Reset all settings to default");
-            for (int s = (int) VIDEO_SETTINGS::BRIGHTNESS; s <= (int) VIDEO_SETTINGS::WHITEBALANCE_TEMPERATURE; s++)
-                zed.setCameraSettings(static_cast<VIDEO_SETTINGS> (s), sl::VIDEO_SETTINGS_VALUE_AUTO);
+            commands.post([](Camera& zed) {
+                for (int s = (int) VIDEO_SETTINGS::BRIGHTNESS; s <= (int) VIDEO_SETTINGS::WHITEBALANCE_TEMPERATURE; s++)
+                    zed.setCameraSettings(static_cast<VIDEO_SETTINGS> (s), sl::VIDEO_SETTINGS_VALUE_AUTO);
+            });
             break;
 
         case 'a':
-            {
-            cout<<"[Sample] set AEC_AGC_ROI on target ["<<selection_rect.x<<","<<selection_rect.y<<","<<selection_rect.width<<","<<selection_rect.height<<"]\n";
-            zed.setCameraSettings(VIDEO_SETTINGS::AEC_AGC_ROI,selection_rect,sl::SIDE::BOTH);
-            }
+            cout<<"[Sample] set AEC_AGC_ROI on target ["<<rect.x<<","<<rect.y<<","<<rect.width<<","<<rect.height<<"]\n";
+            commands.post([=](Camera& zed) { zed.setCameraSettings(VIDEO_SETTINGS::AEC_AGC_ROI,rect,sl::SIDE::BOTH); });
             break;
 
         case 'f' :
             print("reset AEC_AGC_ROI to full res");
-            zed.setCameraSettings(VIDEO_SETTINGS::AEC_AGC_ROI,selection_rect,sl::SIDE::BOTH,true);
+            commands.post([=](Camera& zed) { zed.setCameraSettings(VIDEO_SETTINGS::AEC_AGC_ROI,rect,sl::SIDE::BOTH,true); });
             break;
 
         default :
@@ -298,14 +502,15 @@ void switchCameraSettings() {
     This function toggles between view mode
  **/
 void switchViewMode() {
-    view_mode = static_cast<VIEW> ((int) view_mode + 1);
+    VIEW next_view = static_cast<VIEW> ((int) view_mode.load() + 1);
 
     // reset to 1st setting
-    if (view_mode == VIEW::DEPTH_RIGHT)
-        view_mode = VIEW::LEFT;
+    if (next_view == VIEW::DEPTH_RIGHT)
+        next_view = VIEW::LEFT;
+    view_mode = next_view;
 
 
-    print("Switch to view mode: ", ERROR_CODE::SUCCESS, string(sl::toString(view_mode).c_str()));
+    print("Switch to view mode: ", ERROR_CODE::SUCCESS, string(sl::toString(next_view).c_str()));
 }
 
 /**
@@ -337,37 +542,3 @@ void print(string msg_prefix, ERROR_CODE err_code, string msg_suffix) {
         cout << " " << msg_suffix;
     cout << endl;
 }
-
-void parseArgs(int argc, char **argv, sl::InitParameters& param) {
-    if (argc > 1 && string(argv[1]).find(".svo") != string::npos) {
-        // SVO input mode not available in camera control
-        cout << "SVO Input mode is not available for camera control sample" << endl;
-    } else if (argc > 1 && string(argv[1]).find(".svo") == string::npos) {
-        string arg = string(argv[1]);
-        unsigned int a, b, c, d, port;
-        if (sscanf(arg.c_str(), "%u.%u.%u.%u:%d", &a, &b, &c, &d, &port) == 5) {
-            // Stream input mode - IP + port
-            string ip_adress = to_string(a) + "." + to_string(b) + "." + to_string(c) + "." + to_string(d);
-            param.input.setFromStream(sl::String(ip_adress.c_str()), port);
-            cout << "[Sample] Using Stream input, IP : " << ip_adress << ", port : " << port << endl;
-        } else if (sscanf(arg.c_str(), "%u.%u.%u.%u", &a, &b, &c, &d) == 4) {
-            // Stream input mode - IP only
-            param.input.setFromStream(sl::String(argv[1]));
-            cout << "[Sample] Using Stream input, IP : " << argv[1] << endl;
-        } else if (arg.find("HD2K") != string::npos) {
-            param.camera_resolution = sl::RESOLUTION::HD2K;
-            cout << "[Sample] Using Camera in resolution HD2K" << endl;
-        } else if (arg.find("HD1080") != string::npos) {
-            param.camera_resolution = sl::RESOLUTION::HD1080;
-            cout << "[Sample] Using Camera in resolution HD1080" << endl;
-        } else if (arg.find("HD720") != string::npos) {
-            param.camera_resolution = sl::RESOLUTION::HD720;
-            cout << "[Sample] Using Camera in resolution HD720" << endl;
-        } else if (arg.find("VGA") != string::npos) {
-            param.camera_resolution = sl::RESOLUTION::VGA;
-            cout << "[Sample] Using Camera in resolution VGA" << endl;
-        }
-    } else {
-        // Default
-    }
-}
@@ -0,0 +1,220 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+/***********************************************************************
+ ** Checks of the receiver pipeline, without network nor ZED:         **
+ **  - FrameAgeStats percentiles and StreamHealth loss on known data  **
+ **  - FrameMailbox: fast producer, slow and fast consumers, no frame **
+ **    modified while held, only newer frames                         **
+ **  - frame age at display of the serial receiver loop compared to   **
+ **    the decoupled grab thread + mailbox, on a simulated stream     **
+ ***********************************************************************/
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+#include "FrameAge.hpp"
+#include "FrameMailbox.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+static uint64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+}
+
+struct TestFrame {
+    std::vector<uint8_t> data = std::vector<uint8_t>(1 << 20);
+    uint64_t timestamp = 0;
+};
+
+static bool statsTest() {
+    bool ok = true;
+    FrameAgeStats stats(100);
+    for (int i = 1; i <= 200; i++) stats.add(static_cast<double>(i));
+    // Only the last 100 values (101..200) are in the window
+    ok &= stats.percentile(0.5) == 151. && stats.percentile(0.99) == 200. && stats.getMax() == 200. && stats.getCount() == 200;
+
+    StreamHealth health(30.f);
+    const uint64_t period = 33333333;
+    int frames[] = {0, 1, 2, 4, 5, 9, 10};      // 3, 6, 7 and 8 are lost
+    for (int f : frames) health.addFrame(1000000000ull + f * period + (f % 2) * 3000000);
+    float fps, loss;
+    health.getInterval(1., fps, loss);
+    ok &= fps == 7.f && std::abs(loss - 4.f / 11.f) < 1e-4f;
+    printf("  p50 %.0f, p99 %.0f, loss %.3f: %s\n", stats.percentile(0.5), stats.percentile(0.99), loss, ok ? "OK" : "[Error]");
+    return ok;
+}
+
+static bool mailboxTest(int duration_s) {
+    FrameMailbox<TestFrame> mailbox(4);
+    std::atomic<bool> run(true);
+    std::atomic<uint64_t> nb_torn(0), nb_unordered(0);
+
+    auto consumer = [&](int hold_ms, uint64_t& nb_read, uint64_t& nb_skipped) {
+        uint64_t last_seq = 0, last_ts = 0;
+        while (true) {
+            auto frame = mailbox.wait(last_seq, 100, &nb_skipped);
+            if (!frame) {
+                if (!run) break;
+                continue;
+            }
+            nb_read++;
+            if (frame->timestamp <= last_ts) nb_unordered++;
+            last_ts = frame->timestamp;
+            const uint8_t expected = static_cast<uint8_t>(frame->timestamp);
+            std::this_thread::sleep_for(std::chrono::milliseconds(hold_ms));
+            // The frame must not be reused by the producer while it is held
+            for (size_t i = 0; i < frame->data.size(); i += 4096)
+                if (frame->data[i] != expected) {
+                    nb_torn++;
+                    break;
+                }
+        }
+    };
+    uint64_t slow_read = 0, slow_skipped = 0, fast_read = 0, fast_skipped = 0;
+    std::thread slow(consumer, 20, std::ref(slow_read), std::ref(slow_skipped));
+    std::thread fast(consumer, 0, std::ref(fast_read), std::ref(fast_skipped));
+
+    uint64_t nb_posted = 0, nb_no_buffer = 0;
+    auto start = Clock::now();
+    while (Clock::now() - start < std::chrono::seconds(duration_s)) {
+        auto frame = mailbox.acquire();
+        if (!frame) {
+            nb_no_buffer++;
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+            continue;
+        }
+        frame->timestamp = ++nb_posted;
+        memset(frame->data.data(), static_cast<uint8_t>(frame->timestamp), frame->data.size());
+        mailbox.post(frame);
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    run = false;
+    mailbox.close();
+    slow.join();
+    fast.join();
+
+    bool ok = nb_torn == 0 && nb_unordered == 0 && nb_no_buffer == 0 && slow_read > 0 && fast_read > 0
+            && slow_read + slow_skipped <= nb_posted && fast_read + fast_skipped <= nb_posted;
+    printf("  %llu posted, slow consumer %llu read / %llu skipped, fast consumer %llu read / %llu skipped, %llu torn: %s\n",
+            (unsigned long long)nb_posted, (unsigned long long)slow_read, (unsigned long long)slow_skipped, (unsigned long long)fast_read,
+            (unsigned long long)fast_skipped, (unsigned long long)nb_torn.load(), ok ? "OK" : "[Error]");
+    return ok;
+}
+
+// Simulated stream: frames captured at 30FPS arrive after a transport delay in the receive buffer of the SDK,
+// grab() takes the oldest one and decodes it
+class SimulatedStream {
+public:
+    SimulatedStream() : next_capture(nowNs()) {}
+
+    uint64_t grab() {
+        std::unique_lock<std::mutex> lock(mtx);
+        while (true) {
+            uint64_t now = nowNs();
+            while (next_capture + transport_ns <= now) {
+                buffer.push_back(next_capture);
+                if (buffer.size() > 8) buffer.pop_front();   // receive buffer overflow
+                next_capture += period_ns;
+            }
+            if (!buffer.empty()) break;
+            lock.unlock();
+            std::this_thread::sleep_for(std::chrono::nanoseconds(next_capture + transport_ns - now));
+            lock.lock();
+        }
+        uint64_t timestamp = buffer.front();
+        buffer.pop_front();
+        lock.unlock();
+        std::this_thread::sleep_for(std::chrono::milliseconds(4));  // decoding
+        return timestamp;
+    }
+
+private:
+    std::mutex mtx;
+    std::deque<uint64_t> buffer;
+    uint64_t next_capture;
+    const uint64_t period_ns = 33333333, transport_ns = 30000000;
+};
+
+// Display time: 25ms with a 100ms spike every 20 frames (window resize, slow compositor...)
+static void display(int frame) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(frame % 20 == 19 ? 100 : 25));
+}
+
+static void latencyTest(int duration_s) {
+    {
+        SimulatedStream stream;
+        FrameAgeStats age;
+        auto start = Clock::now();
+        for (int f = 0; Clock::now() - start < std::chrono::seconds(duration_s); f++) {
+            uint64_t timestamp = stream.grab();
+            display(f);
+            age.add(timestamp, nowNs());
+        }
+        printf("  serial grab + display:  %llu frames displayed, age p50 %.0fms, p99 %.0fms\n", (unsigned long long)age.getCount(), age.percentile(0.5), age.percentile(0.99));
+    }
+    {
+        SimulatedStream stream;
+        FrameMailbox<TestFrame> mailbox(3);
+        std::atomic<bool> run(true);
+        std::thread grab_thread([&] {
+            while (run) {
+                uint64_t timestamp = stream.grab();
+                auto frame = mailbox.acquire();
+                if (!frame) continue;
+                frame->timestamp = timestamp;
+                mailbox.post(frame);
+            }
+        });
+        FrameAgeStats age;
+        uint64_t last_seq = 0, nb_skipped = 0;
+        auto start = Clock::now();
+        for (int f = 0; Clock::now() - start < std::chrono::seconds(duration_s);) {
+            auto frame = mailbox.wait(last_seq, 100, &nb_skipped);
+            if (!frame) continue;
+            display(f++);
+            age.add(frame->timestamp, nowNs());
+        }
+        run = false;
+        grab_thread.join();
+        printf("  grab thread + mailbox:  %llu frames displayed (%llu skipped), age p50 %.0fms, p99 %.0fms\n", (unsigned long long)age.getCount(),
+                (unsigned long long)nb_skipped, age.percentile(0.5), age.percentile(0.99));
+    }
+}
+
+int main(int argc, char **argv) {
+    int duration_s = (argc > 1) ? atoi(argv[1]) : 5;
+    bool ok = true;
+    std::cout << "Frame age statistics" << std::endl;
+    ok &= statsTest();
+    std::cout << "Mailbox, producer at 500FPS, consumers holding frames 20ms and 0ms" << std::endl;
+    ok &= mailboxTest(duration_s);
+    std::cout << "Frame age at display, 30FPS stream, 30ms transport, 4ms decoding, 25ms display with 100ms spikes" << std::endl;
+    latencyTest(duration_s);
+    std::cout << (ok ? "OK" : "[Error] failed") << std::endl;
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,254 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+/*********************************************************************************
+ ** This sample receives the stream of a ZED once and serves it to many clients: **
+ **  - processes of the same host read the decoded frames in shared memory       **
+ **  - remote clients get the frames re-streamed over TCP, encoded once          **
+ ** The sender (often an embedded board) only has one receiver to serve.         **
+ **********************************************************************************/
+
+// Standard includes
+#include <chrono>
+#include <stdio.h>
+#include <string.h>
+#include <thread>
+
+// ZED include
+#include <sl/Camera.hpp>
+
+// OpenCV include (for the encoding)
+#include <opencv2/opencv.hpp>
+
+// Sample includes
+#include "DisplayMode.hpp"
+#include "MatBridge.hpp"
+#include "RelayServer.hpp"
+#include "SharedFrameRing.hpp"
+#include "utils.hpp"
+#include "ZedFrameSource.hpp"
+
+// Using std and sl namespaces
+using namespace std;
+using namespace sl;
+
+void print(string msg_prefix, ERROR_CODE err_code = ERROR_CODE::SUCCESS, string msg_suffix = "");
+
+struct RelayParameters {
+    string stream;                  // IP:[port] of the sender, empty with a --source
+    string shm_name = "zed_relay";  // empty: no shared memory
+    int nb_slots = 8;
+    int port = 30100;               // 0: no re-streaming
+    string bind_ip = "0.0.0.0";
+    int max_clients = 16;
+    int jpeg_quality = 80;          // 0: raw BGRA
+};
+
+bool parseArgs(int argc, char **argv, RelayParameters& params) {
+    for (int i = 1; i < argc; i++) {
+        string arg(argv[i]);
+        bool has_value = i + 1 < argc;
+        if (arg == "--shm" && has_value) params.shm_name = argv[++i];
+        else if (arg == "--no-shm") params.shm_name.clear();
+        else if (arg == "--slots" && has_value) params.nb_slots = atoi(argv[++i]);
+        else if (arg == "--port" && has_value) params.port = atoi(argv[++i]);
+        else if (arg == "--bind" && has_value) params.bind_ip = argv[++i];
+        else if (arg == "--max-clients" && has_value) params.max_clients = atoi(argv[++i]);
+        else if (arg == "--jpeg" && has_value) params.jpeg_quality = atoi(argv[++i]);
+        else if (arg == "--raw") params.jpeg_quality = 0;
+        else if (arg[0] != '-') params.stream = arg;
+        else return false;
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    // No window: --sink gets a line per relayed frame
+    DisplayMode display;
+    if (!display.parse(argc, argv)) return EXIT_FAILURE;
+    // IP:[port] of the sender, or --source of frames without camera (synthetic, images, raw) to run without sender
+    FrameSourceOptions source;
+    if (!source.parse(argc, argv)) return EXIT_FAILURE;
+    RelayParameters params;
+    if (!parseArgs(argc, argv, params) || (source.kind == FRAME_SOURCE::CAMERA && source.resolution.empty() && params.stream.empty())) {
+        cout << "Usage : ./ZED_Streaming_Relay IP:[port] [--shm name | --no-shm] [--slots 8] [--port 30100] [--bind 0.0.0.0]\n"
+                "                                       [--max-clients 16] [--jpeg 80 | --raw] " << DisplayMode::usage() << "\n"
+                "        ./ZED_Streaming_Relay --source synthetic|images:<directory>|raw:<file.zraw> [--frames N] [--fps N] <options>\n";
+        return EXIT_FAILURE;
+    }
+    if (!params.stream.empty()) source.parseInput(params.stream);
+    if (source.usesCamera() && source.kind != FRAME_SOURCE::STREAM) {
+        cout << "[Sample][Error] Invalid stream address " << (params.stream.empty() ? source.describe() : params.stream) << ", expected IP:[port]" << endl;
+        return EXIT_FAILURE;
+    }
+
+    Camera zed;
+    InitParameters init_parameters;
+    init_parameters.depth_mode = DEPTH_MODE::NONE;
+    init_parameters.sdk_verbose = true;
+    // Frames of the source, relayed at the rate of their timestamps as a stream would
+    unique_ptr<FrameSource> frames;
+    FrameBundle bundle;
+    Resolution resolution;
+    ERROR_CODE returned_state;
+    if (source.usesCamera()) {
+        if (!applyFrameSource(source, init_parameters)) return EXIT_FAILURE;
+        // The only decoding of the stream, by the SDK
+        returned_state = zed.open(init_parameters);
+        if (returned_state != ERROR_CODE::SUCCESS) {
+            print("Camera Open", returned_state, "Exit program.");
+            return EXIT_FAILURE;
+        }
+        resolution = zed.getCameraInformation().camera_configuration.resolution;
+    } else {
+        // The first frame gives the size of the slots of the shared memory
+        frames = FrameSource::create(source);
+        if (!frames || !frames->open() || frames->read(bundle) != FRAME_STATUS::FRAME) {
+            print("No frame in the " + source.describe(), ERROR_CODE::FAILURE);
+            return EXIT_FAILURE;
+        }
+        resolution = Resolution(bundle.image.width, bundle.image.height);
+    }
+    Mat image(resolution, MAT_TYPE::U8_C4, MEM::CPU);
+
+    SharedFrameRing ring;
+    if (!params.shm_name.empty()) {
+        if (ring.create(params.shm_name, params.nb_slots, image.getStepBytes() * image.getHeight()))
+            print("Shared memory '" + params.shm_name + "': " + to_string(params.nb_slots) + " frames of " + to_string(resolution.width) + "x" + to_string(resolution.height));
+        else {
+            print("Shared memory '" + params.shm_name + "' cannot be created", ERROR_CODE::FAILURE);
+            return EXIT_FAILURE;
+        }
+    }
+    RelayServer server(params.max_clients);
+    if (params.port > 0) {
+        if (server.open(static_cast<unsigned short>(params.port), params.bind_ip))
+            print("Re-streaming on " + params.bind_ip + ":" + to_string(params.port) + (params.jpeg_quality > 0 ? " (JPEG)" : " (BGRA)"));
+        else {
+            print("Port " + to_string(params.port) + " unavailable", ERROR_CODE::FAILURE);
+            return EXIT_FAILURE;
+        }
+    }
+
+    SetCtrlHandler();
+
+    cv::Mat bgr;
+    vector<uchar> encoded;
+    const vector<int> encode_params = {cv::IMWRITE_JPEG_QUALITY, params.jpeg_quality};
+    int nb_frames = 0;
+    double encode_ms = 0.;
+    auto last_print = chrono::steady_clock::now();
+    int nb_failed_grabs = 0;
+    auto last_failure_print = last_print;
+    const auto source_start = last_print;
+    const uint64_t first_timestamp = bundle.timestamp;
+    bool has_frame = frames != nullptr;
+    while (!exit_app) {
+        if (frames) {
+            // The first frame was read at the opening
+            if (!has_frame && frames->read(bundle) != FRAME_STATUS::FRAME) break;
+            has_frame = false;
+            this_thread::sleep_until(source_start + chrono::nanoseconds(bundle.timestamp - first_timestamp));
+            const FrameImage& frame = bundle.image;
+            // The slots of the shared memory keep the size of the first frame
+            if (frame.width != static_cast<int>(resolution.width) || frame.height != static_cast<int>(resolution.height)) continue;
+            for (int y = 0; y < frame.height; y++)
+                memcpy(image.getPtr<sl::uchar1>(MEM::CPU) + y * image.getStepBytes(), frame.row<uint8_t>(y), static_cast<size_t>(frame.width) * 4);
+        } else if ((returned_state = zed.grab()) != ERROR_CODE::SUCCESS) {
+            // The SDK reconnects to the sender by itself: wait for it, 1ms to 128ms between the grabs, and tell it every 5s
+            auto now = chrono::steady_clock::now();
+            if (nb_failed_grabs == 0 || chrono::duration<double>(now - last_failure_print).count() >= 5.) {
+                print("Grab failed " + to_string(nb_failed_grabs + 1) + " times, waiting for the sender", returned_state);
+                last_failure_print = now;
+            }
+            sleep_ms(1 << min(nb_failed_grabs, 7));
+            nb_failed_grabs++;
+            continue;
+        }
+        if (nb_failed_grabs > 0) {
+            print("Stream back after " + to_string(nb_failed_grabs) + " failed grabs");
+            nb_failed_grabs = 0;
+        }
+        if (!frames) zed.retrieveImage(image, VIEW::LEFT, MEM::CPU);
+        const uint64_t timestamp = frames ? bundle.timestamp : zed.getTimestamp(TIME_REFERENCE::IMAGE).getNanoseconds();
+        const uint32_t width = static_cast<uint32_t>(image.getWidth()), height = static_cast<uint32_t>(image.getHeight());
+        const uint32_t step = static_cast<uint32_t>(image.getStepBytes());
+        nb_frames++;
+
+        // Local processes: one copy in the ring, whatever their number
+        if (ring.getNbSlots() > 0) {
+            SharedFrameInfo info;
+            info.timestamp = timestamp;
+            info.width = width;
+            info.height = height;
+            info.step = step;
+            info.channels = 4;
+            info.size = step * height;
+            ring.write(image.getPtr<sl::uchar1>(MEM::CPU), info);
+        }
+
+        // Remote clients: one encoding, whatever their number, and none without client
+        if (server.getNbClients() > 0) {
+            if (params.jpeg_quality > 0) {
+                auto start = chrono::steady_clock::now();
+                cv::cvtColor(toCvMat(image), bgr, cv::COLOR_BGRA2BGR);
+                cv::imencode(".jpg", bgr, encoded, encode_params);
+                encode_ms += chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+                server.publish(RelayFormat::JPEG, width, height, 0, timestamp, encoded.data(), encoded.size());
+            } else
+                server.publish(RelayFormat::BGRA, width, height, step, timestamp, image.getPtr<sl::uchar1>(MEM::CPU), step * height);
+        }
+        // Index of the relayed frame in the results, Ctrl+C is handled by exit_app
+        display.nextFrame();
+        if (display.hasSink())
+            display.publish(timestamp, to_string(server.getNbClients()) + " TCP clients, " + to_string(server.getNbDropped()) + " frames dropped");
+
+        auto now = chrono::steady_clock::now();
+        double elapsed = chrono::duration<double>(now - last_print).count();
+        if (elapsed >= 5.) {
+            printf("[Sample] %.1f FPS received | %d TCP clients, %llu frames dropped | encoding %.1fms/frame\n", nb_frames / elapsed,
+                    server.getNbClients(), (unsigned long long)server.getNbDropped(), nb_frames ? encode_ms / nb_frames : 0.);
+            nb_frames = 0;
+            encode_ms = 0.;
+            last_print = now;
+        }
+    }
+
+    server.close();
+    ring.close();
+    zed.close();
+    return EXIT_SUCCESS;
+}
+
+void print(string msg_prefix, ERROR_CODE err_code, string msg_suffix) {
+    cout << "[Sample]";
+    if (err_code != ERROR_CODE::SUCCESS)
+        cout << "[Error] ";
+    else
+        cout << " ";
+    cout << msg_prefix << " ";
+    if (err_code != ERROR_CODE::SUCCESS) {
+        cout << " | " << toString(err_code) << " : ";
+        cout << toVerbose(err_code);
+    }
+    if (!msg_suffix.empty())
+        cout << " " << msg_suffix;
+    cout << endl;
+}
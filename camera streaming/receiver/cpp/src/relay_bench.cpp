@@ -0,0 +1,290 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+/***********************************************************************
+ ** Loopback harness of the relay, without ZED nor network:           **
+ ** a stand-in sender process publishes synthetic frames on 127.0.0.1 **
+ ** and N consumer processes read them:                               **
+ **  - direct: every consumer connects to the sender                  **
+ **  - relay tcp: the relay (this process) ingests the sender once    **
+ **    and re-streams to the consumers                                **
+ **  - relay shm: the consumers read the relay shared memory          **
+ ** The CPU time of each process gives the cost of each consumer.     **
+ ***********************************************************************/
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <signal.h>
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "FrameAge.hpp"
+#include "RelayServer.hpp"
+#include "SharedFrameRing.hpp"
+
+using namespace std;
+
+static const unsigned short SENDER_PORT = 30200, RELAY_PORT = 30201;
+static const char* SHM_NAME = "zed_relay_bench";
+static volatile sig_atomic_t stop_requested = 0;
+
+static uint64_t nowNs() {
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::system_clock::now().time_since_epoch()).count();
+}
+
+static double cpuSeconds(const struct rusage& usage) {
+    return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * 1e-6;
+}
+
+// What a consumer does with a frame, the same whatever the transport
+static uint32_t useFrame(const uint8_t* data, size_t size) {
+    uint32_t sum = 0;
+    for (size_t i = 0; i < size; i += 64) sum += data[i];
+    return sum;
+}
+
+// Stand-in for the ZED sender: BGRA frames at a fixed rate, served to whoever connects
+static int runSender(int width, int height, int fps) {
+    signal(SIGTERM, [](int) { stop_requested = 1; });
+    RelayServer server(32);
+    if (!server.open(SENDER_PORT, "127.0.0.1")) {
+        cerr << "[Error] sender port " << SENDER_PORT << " unavailable" << endl;
+        return EXIT_FAILURE;
+    }
+    vector<uint8_t> frame(static_cast<size_t>(width) * height * 4);
+    auto next = chrono::steady_clock::now();
+    for (uint64_t f = 0; !stop_requested; f++) {
+        memset(frame.data(), static_cast<int>(f & 0xFF), frame.size());
+        server.publish(RelayFormat::BGRA, width, height, width * 4, nowNs(), frame.data(), frame.size());
+        next += chrono::microseconds(1000000 / fps);
+        this_thread::sleep_until(next);
+    }
+    server.close();
+    return EXIT_SUCCESS;
+}
+
+// Consumer process: reads for duration_s, then prints its counters on stdout
+static int runConsumer(const string& source, double duration_s) {
+    FrameAgeStats age;
+    uint64_t nb_frames = 0, nb_skipped = 0, nb_torn = 0, last_seq = 0;
+    uint32_t checksum = 0;
+    SharedFrameRing ring;
+    RelayClient client;
+    unsigned short port = static_cast<unsigned short>(atoi(source.c_str() + 4));
+    bool connected = (source == "shm") ? ring.open(SHM_NAME) : client.connect("127.0.0.1", port);
+    auto end = chrono::steady_clock::now() + chrono::duration_cast<chrono::nanoseconds>(chrono::duration<double>(duration_s));
+    RelayFrameHeader header;
+    vector<uint8_t> payload;
+    while (connected && chrono::steady_clock::now() < end) {
+        if (source == "shm") {
+            SharedFrameView view;
+            if (!ring.acquire(last_seq, view, 100, &nb_skipped)) continue;
+            checksum += useFrame(view.data, view.info.size);
+            if (!ring.isValid(view)) {
+                nb_torn++;
+                continue;
+            }
+            // The first frame was published before the consumer started, its age says nothing of the path
+            if (nb_frames) age.add(view.info.timestamp, nowNs());
+        } else {
+            if (!client.read(header, payload)) break;
+            if (last_seq && header.seq > last_seq + 1) nb_skipped += header.seq - last_seq - 1;
+            last_seq = header.seq;
+            checksum += useFrame(payload.data(), payload.size());
+            if (nb_frames) age.add(header.timestamp, nowNs());
+        }
+        nb_frames++;
+    }
+    printf("%d %llu %llu %llu %.2f %.2f %u\n", connected ? 1 : 0, (unsigned long long)nb_frames, (unsigned long long)nb_skipped,
+            (unsigned long long)nb_torn, age.percentile(0.5), age.percentile(0.99), checksum);
+    return connected ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+struct Child {
+    pid_t pid = -1;
+    int output = -1;
+    chrono::steady_clock::time_point start;
+};
+
+static Child spawn(const char* self, const vector<string>& args) {
+    Child child;
+    int fds[2];
+    if (pipe(fds) != 0) return child;
+    child.start = chrono::steady_clock::now();
+    child.pid = fork();
+    if (child.pid == 0) {
+        dup2(fds[1], STDOUT_FILENO);
+        ::close(fds[0]);
+        ::close(fds[1]);
+        vector<char*> argv;
+        argv.push_back(const_cast<char*>(self));
+        for (auto& a : args) argv.push_back(const_cast<char*>(a.c_str()));
+        argv.push_back(nullptr);
+        execv(self, argv.data());
+        _exit(127);
+    }
+    ::close(fds[1]);
+    child.output = fds[0];
+    return child;
+}
+
+// Waits for the child, its CPU usage in % of a core over its life, its output
+static double reap(Child& child, string& output) {
+    struct rusage usage;
+    int status;
+    wait4(child.pid, &status, 0, &usage);
+    double wall = chrono::duration<double>(chrono::steady_clock::now() - child.start).count();
+    char buffer[256];
+    ssize_t n;
+    output.clear();
+    while ((n = read(child.output, buffer, sizeof(buffer))) > 0) output.append(buffer, n);
+    ::close(child.output);
+    return wall > 0. ? 100. * cpuSeconds(usage) / wall : 0.;
+}
+
+struct RunResult {
+    double sender_cpu = 0., relay_cpu = 0., consumer_cpu = 0.;  // consumer: mean
+    double fps = 0., age_p50 = 0., age_p99 = 0.;               // consumer: worst
+    uint64_t torn = 0;
+    int nb_failed = 0;
+};
+
+static RunResult run(const char* self, const string& path, int nb_consumers, double duration_s, int width, int height, int fps) {
+    RunResult result;
+    Child sender = spawn(self, {"--sender", to_string(width), to_string(height), to_string(fps)});
+    this_thread::sleep_for(chrono::milliseconds(300));
+
+    // The relay: ingests the sender once, writes the ring and re-streams
+    atomic<bool> relay_run(path != "direct");
+    SharedFrameRing ring;
+    RelayServer server(32);
+    thread relay;
+    if (relay_run) {
+        ring.create(SHM_NAME, 8, static_cast<size_t>(width) * height * 4);
+        server.open(RELAY_PORT, "127.0.0.1");
+        relay = thread([&] {
+            RelayClient client;
+            RelayFrameHeader header;
+            vector<uint8_t> payload;
+            if (!client.connect("127.0.0.1", SENDER_PORT)) return;
+            while (relay_run && client.read(header, payload)) {
+                SharedFrameInfo info;
+                info.timestamp = header.timestamp;
+                info.width = header.width;
+                info.height = header.height;
+                info.step = header.step;
+                info.channels = 4;
+                info.size = header.size;
+                ring.write(payload.data(), info);
+                server.publish(static_cast<RelayFormat>(header.format), header.width, header.height, header.step, header.timestamp, payload.data(), payload.size());
+            }
+        });
+        this_thread::sleep_for(chrono::milliseconds(200));
+    }
+    struct rusage relay_start, relay_end;
+    getrusage(RUSAGE_SELF, &relay_start);
+    auto start = chrono::steady_clock::now();
+
+    string source = (path == "direct") ? "tcp:" + to_string(SENDER_PORT) : (path == "relay tcp") ? "tcp:" + to_string(RELAY_PORT) : "shm";
+    vector<Child> consumers;
+    for (int c = 0; c < nb_consumers; c++) consumers.push_back(spawn(self, {"--consumer", source, to_string(duration_s)}));
+    if (nb_consumers == 0) this_thread::sleep_for(chrono::duration<double>(duration_s));
+
+    result.fps = 1e9;
+    for (auto& consumer : consumers) {
+        string output;
+        result.consumer_cpu += reap(consumer, output) / nb_consumers;
+        int connected = 0;
+        unsigned long long frames = 0, skipped = 0, torn = 0;
+        double p50 = 0., p99 = 0.;
+        if (sscanf(output.c_str(), "%d %llu %llu %llu %lf %lf", &connected, &frames, &skipped, &torn, &p50, &p99) != 6 || !connected) {
+            result.nb_failed++;
+            continue;
+        }
+        result.fps = min(result.fps, frames / duration_s);
+        result.age_p50 = max(result.age_p50, p50);
+        result.age_p99 = max(result.age_p99, p99);
+        result.torn += torn;
+    }
+    if (nb_consumers == 0) result.fps = 0.;
+    getrusage(RUSAGE_SELF, &relay_end);
+    double wall = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    if (path != "direct") result.relay_cpu = 100. * (cpuSeconds(relay_end) - cpuSeconds(relay_start)) / wall;
+
+    kill(sender.pid, SIGTERM);
+    string output;
+    result.sender_cpu = reap(sender, output);
+    relay_run = false;
+    if (relay.joinable()) relay.join();
+    server.close();
+    ring.close();
+    return result;
+}
+
+int main(int argc, char **argv) {
+    string mode = (argc > 1) ? argv[1] : "";
+    if (mode == "--sender" && argc > 4) return runSender(atoi(argv[2]), atoi(argv[3]), atoi(argv[4]));
+    if (mode == "--consumer" && argc > 3) return runConsumer(argv[2], atof(argv[3]));
+
+    double duration_s = (argc > 1) ? atof(argv[1]) : 4.;
+    int max_consumers = (argc > 2) ? atoi(argv[2]) : 8;
+    int width = 640, height = 360, fps = 30;
+    if (argc > 3) sscanf(argv[3], "%dx%d", &width, &height);
+    relayNetworkInit();
+
+    printf("Stand-in sender: %dx%d BGRA at %d FPS (%.1f MB/s), %.0fs per run, CPU in %% of a core\n", width, height, fps, width * height * 4. * fps / 1e6, duration_s);
+    printf("%9s | %-9s | %10s | %9s | %14s | %12s | %s\n", "consumers", "path", "sender CPU", "relay CPU", "CPU / consumer", "FPS (worst)", "frame age p50 / p99 (worst)");
+
+    vector<int> counts = {0, 1};
+    for (int n = 2; n <= max_consumers; n *= 2) counts.push_back(n);
+    const vector<string> paths = {"direct", "relay tcp", "relay shm"};
+    // CPU for 1 and max consumers, per path
+    vector<RunResult> one(paths.size()), last(paths.size());
+    bool ok = true;
+    for (int n : counts) {
+        for (size_t p = 0; p < paths.size(); p++) {
+            RunResult r = run(argv[0], paths[p], n, duration_s, width, height, fps);
+            printf("%9d | %-9s | %9.1f%% | %8.1f%% | %13.1f%% | %12.1f | %.1fms / %.1fms%s\n", n, paths[p].c_str(), r.sender_cpu, r.relay_cpu,
+                    r.consumer_cpu, r.fps, r.age_p50, r.age_p99, r.nb_failed ? " [Error] consumer failed" : r.torn ? " (frames overwritten while used)" : "");
+            ok &= r.nb_failed == 0;
+            if (n == 1) one[p] = r;
+            if (n == counts.back()) last[p] = r;
+        }
+    }
+    if (counts.back() > 1) {
+        const int added = counts.back() - 1;
+        printf("\nCPU per added consumer, from 1 to %d consumers (the consumers themselves excluded):\n", counts.back());
+        for (size_t p = 0; p < paths.size(); p++)
+            printf("  %-9s: sender %+.2f%%, relay %+.2f%% of a core\n", paths[p].c_str(), (last[p].sender_cpu - one[p].sender_cpu) / added,
+                    (last[p].relay_cpu - one[p].relay_cpu) / added);
+    }
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
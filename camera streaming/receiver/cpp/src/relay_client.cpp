@@ -0,0 +1,134 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+/*********************************************************************************
+ ** This sample reads the frames served by the ZED_Streaming_Relay, either from  **
+ ** its shared memory (same host, no copy nor decoding) or from its TCP port.    **
+ ** It is the starting point of a process using the stream of a shared ZED.      **
+ **********************************************************************************/
+
+// Standard includes
+#include <chrono>
+#include <iostream>
+#include <stdio.h>
+#include <string.h>
+
+// OpenCV include (for display)
+#include <opencv2/opencv.hpp>
+
+// Sample includes
+#include "FrameAge.hpp"
+#include "RelayServer.hpp"
+#include "SharedFrameRing.hpp"
+#include "utils.hpp"
+
+using namespace std;
+
+static uint64_t nowNs() {
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::system_clock::now().time_since_epoch()).count();
+}
+
+int main(int argc, char **argv) {
+    string source = (argc > 1) ? argv[1] : "shm:zed_relay";
+    bool display = argc > 2 && string(argv[2]) == "--display";
+
+    SharedFrameRing ring;
+    RelayClient client;
+    if (source.compare(0, 4, "shm:") == 0) {
+        if (!ring.open(source.substr(4))) {
+            cout << "[Sample][Error] Shared memory '" << source.substr(4) << "' not found, is the ZED_Streaming_Relay running?" << endl;
+            return EXIT_FAILURE;
+        }
+    } else if (source.compare(0, 4, "tcp:") == 0 && source.find(':', 4) != string::npos) {
+        size_t colon = source.find(':', 4);
+        if (!client.connect(source.substr(4, colon - 4), static_cast<unsigned short>(atoi(source.substr(colon + 1).c_str())))) {
+            cout << "[Sample][Error] Cannot connect to " << source.substr(4) << endl;
+            return EXIT_FAILURE;
+        }
+    } else {
+        cout << "Usage : ./ZED_Streaming_Relay_Client shm:<name> | tcp:<ip>:<port> [--display]\n";
+        return EXIT_FAILURE;
+    }
+    const bool use_shm = ring.getNbSlots() > 0;
+    cout << "[Sample] Reading " << source << endl;
+
+    SetCtrlHandler();
+
+    FrameAgeStats age;
+    uint64_t last_seq = 0, nb_frames = 0, nb_skipped = 0, nb_torn = 0;
+    RelayFrameHeader header;
+    vector<uint8_t> payload;
+    cv::Mat image;
+    auto last_print = chrono::steady_clock::now(), last_frame = last_print;
+    while (!exit_app) {
+        if (use_shm) {
+            SharedFrameView view;
+            if (!ring.acquire(last_seq, view, 100, &nb_skipped)) {
+                // A restarted relay creates a new ring, the old one is never written again
+                if (chrono::steady_clock::now() - last_frame > chrono::seconds(2) && ring.open(source.substr(4))) {
+                    last_seq = 0;
+                    last_frame = chrono::steady_clock::now();
+                }
+                continue;
+            }
+            last_frame = chrono::steady_clock::now();
+            // The frame is used in place: cv::Mat on the shared memory, no copy
+            cv::Mat frame(view.info.height, view.info.width, CV_8UC4, const_cast<uint8_t*>(view.data), view.info.step);
+            if (display) frame.copyTo(image);
+            // The relay reuses the slot after (nb_slots - 1) frames, a slower use has to be dropped
+            if (!ring.isValid(view)) {
+                nb_torn++;
+                continue;
+            }
+            age.add(view.info.timestamp, nowNs());
+        } else {
+            if (!client.read(header, payload)) {
+                cout << "[Sample] Connection closed by the relay" << endl;
+                break;
+            }
+            if (last_seq && header.seq > last_seq + 1) nb_skipped += header.seq - last_seq - 1;
+            last_seq = header.seq;
+            if (display) {
+                if (header.format == static_cast<uint32_t>(RelayFormat::JPEG))
+                    image = cv::imdecode(payload, cv::IMREAD_COLOR);
+                else
+                    image = cv::Mat(header.height, header.width, CV_8UC4, payload.data(), header.step);
+            }
+            age.add(header.timestamp, nowNs());
+        }
+        nb_frames++;
+
+        if (display && !image.empty()) {
+            cv::imshow(source, image);
+            if (cv::waitKey(1) == 'q') break;
+        }
+
+        auto now = chrono::steady_clock::now();
+        double elapsed = chrono::duration<double>(now - last_print).count();
+        if (elapsed >= 1.) {
+            printf("[Sample] %.1f FPS, %llu skipped, %llu overwritten while used | frame age p50 %.0fms, p99 %.0fms\n", nb_frames / elapsed,
+                    (unsigned long long)nb_skipped, (unsigned long long)nb_torn, age.percentile(0.5), age.percentile(0.99));
+            nb_frames = nb_skipped = nb_torn = 0;
+            age.reset();
+            last_print = now;
+        }
+    }
+    return EXIT_SUCCESS;
+}
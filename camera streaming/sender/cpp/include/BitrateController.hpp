@@ -0,0 +1,124 @@
+#ifndef __BITRATE_CONTROLLER_HPP__
+#define __BITRATE_CONTROLLER_HPP__
+
+#include <deque>
+#include <ostream>
+#include <string>
+#include <vector>
+
+///
+/// \brief State of the link over the last interval, as seen by the sender and, when available, by the receiver
+///
+struct LinkReport {
+    double time_s = 0.;                 ///< sender clock
+    float sent_fps = 0.f;               ///< frames grabbed and given to the encoder
+    bool has_feedback = false;          ///< the fields below come from the receiver
+    float received_fps = 0.f;
+    float loss = 0.f;                   ///< ratio of the frames lost or too late
+    float latency_ms = 0.f;             ///< frame age at the receiver, only its variations are used (the clocks may differ)
+};
+
+///
+/// \brief Parameters of the BitrateController, bitrates in kbits/s
+///
+struct BitrateConfig {
+    int min_bitrate = 1000;
+    int max_bitrate = 16000;
+    int start_bitrate = 8000;
+    int increase_step = 1000;           ///< additive increase, near a bitrate which congested the link
+    float increase_factor = 1.25f;      ///< multiplicative increase, far from it
+    bool fast_recovery = true;          ///< after a drop of the link, the increases go half way back to the bitrate before it
+    double probe_backoff_s = 15.;       ///< after an increase congested the link, the bitrate stays below it for this long
+    float decrease_factor = 0.7f;       ///< multiplicative decrease, down to the estimated receive rate if lower
+    float loss_hold = 0.02f;            ///< no increase above this loss ratio (random loss is not congestion)
+    float loss_threshold = 0.1f;        ///< congestion above this loss ratio
+    double loss_window_s = 3.;          ///< window of the loss and received fps, the random loss of a single report is too noisy
+    float delay_threshold_ms = 40.f;    ///< congestion above this queuing delay (latency above its recent minimum)
+    float fps_ratio_threshold = 0.9f;   ///< congestion below this ratio of received (or sent) fps to target fps
+    int increase_after = 3;             ///< consecutive clear intervals before each increase
+    double hold_after_decrease_s = 4.;  ///< no increase for this long after a decrease
+    double min_decrease_interval_s = 1.;///< one decrease per interval at most, its effect has to be seen first
+    double max_drain_s = 3.;            ///< after a decrease, the queuing delay has to go down fast enough to be clear within this time
+    double min_increase_interval_s = 5.;///< no increase (bitrate, fps or resolution) sooner after any change: each one restarts the stream
+    double latency_window_s = 30.;      ///< window of the minimum latency
+
+    bool adapt_fps = false;
+    std::vector<int> fps_levels = {15, 30};   ///< ascending
+    int downgrade_bitrate = 3000;       ///< a decrease below this bitrate lowers the fps too, fewer frames with more bits each
+    bool adapt_resolution = false;
+    int nb_resolution_levels = 3;       ///< 0 is the lowest, the caller maps the levels to resolutions
+    int upgrade_after = 10;             ///< consecutive clear intervals before raising fps or resolution, at upgrade_bitrate
+    int upgrade_bitrate = 6000;
+};
+
+///
+/// \brief Output of the controller for an interval
+///
+struct BitrateDecision {
+    double time_s = 0.;
+    int bitrate = 0;
+    int fps = 0;
+    int resolution_level = 0;
+    bool changed = false;               ///< bitrate, fps or resolution differs from the previous decision
+    std::string action;                 ///< hold, increase, decrease, fps_down...
+    std::string reason;
+    float queuing_delay_ms = 0.f;
+};
+
+///
+/// \brief The BitrateController class
+/// AIMD control of the streaming bitrate: a multiplicative decrease when the link is congested (high loss, queuing
+/// delay or missing frames), an additive increase after a few clear intervals. As in GCC, a moderate loss only
+/// stops the increases. The decreases are spaced and followed by a hold period, each increase needs consecutive clear
+/// intervals and the increases are spaced by min_increase_interval_s, so the bitrate does not oscillate with the noise of
+/// the reports (each change restarts the stream).
+/// After a decrease, the queue of the link drains for a few intervals: while its delay goes down, its delay and loss are
+/// those of the previous bitrate and do not trigger another decrease. Once the link is clear again, the increases go
+/// half way back to the bitrate which went through before the link dropped (such a drop is often temporary). An increase
+/// which congests the link is not tried again for probe_backoff_s, so the bitrate settles below the capacity instead of
+/// probing it every few seconds.
+/// When a decrease goes below downgrade_bitrate, or the bitrate is at its minimum and the link is still congested, the
+/// fps then the resolution are lowered (if enabled), and raised back once the link is clear for long at a high bitrate.
+/// update() is called once per interval (typically 1s) and every decision is written to the log, if any.
+///
+class BitrateController {
+public:
+    BitrateController(const BitrateConfig& config, int fps, int resolution_level = 0);
+
+    BitrateDecision update(const LinkReport& report);
+
+    int getBitrate() const { return bitrate; }
+    int getFps() const { return config.fps_levels.empty() ? 0 : config.fps_levels[fps_level]; }
+    int getResolutionLevel() const { return resolution_level; }
+
+    ///
+    /// \brief CSV log of the decisions, the header is written immediately
+    ///
+    void setLog(std::ostream* log);
+
+private:
+    bool isCongested(const LinkReport& report, float queuing_delay, std::string& reason) const;
+
+    BitrateConfig config;
+    int bitrate;
+    int fps_level;
+    int resolution_level;
+    int clear_count = 0;                ///< consecutive clear intervals since the last change
+    int upgrade_count = 0;              ///< consecutive clear intervals since the last congestion or upgrade
+    double last_decrease_s = -1e9;
+    double last_change_s = -1e9;
+    double last_increase_s = -1e9;
+    double last_report_s = 0.;
+    int increased_from = 0;             ///< bitrate before the last increase
+    bool draining = false;              ///< decreased, the queue has not stopped draining yet
+    bool was_clear = false;             ///< the previous interval was not congested
+    float last_queuing_delay = 0.f;
+    int recovery_bitrate = 0;           ///< before the drop of the link, 0 if none
+    int failed_bitrate = 0;             ///< of the last increase which congested the link
+    double failed_s = -1e9;
+    std::deque<std::pair<double, float>> latencies;
+    std::deque<LinkReport> reports;     ///< of the loss window, since the last decrease
+    std::ostream* log = nullptr;
+};
+
+#endif
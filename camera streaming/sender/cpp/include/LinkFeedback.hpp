@@ -0,0 +1,38 @@
+#ifndef __LINK_FEEDBACK_HPP__
+#define __LINK_FEEDBACK_HPP__
+
+#include <string>
+
+#include "BitrateController.hpp"
+
+///
+/// \brief Receiver report, sent once per interval in a UDP datagram "ZEDFB <received_fps> <loss> <latency_ms>"
+///
+std::string formatFeedback(const LinkReport& report);
+bool parseFeedback(const std::string& message, LinkReport& report);
+
+///
+/// \brief The FeedbackListener class
+/// Non blocking UDP socket receiving the receiver reports, poll() is called from the grab loop.
+///
+class FeedbackListener {
+public:
+    FeedbackListener() {}
+    ~FeedbackListener();
+
+    bool open(unsigned short port);
+    void close();
+    bool isOpened() const;
+
+    ///
+    /// \brief reads the pending datagrams
+    /// \param report : the feedback fields of the most recent report, if any
+    /// \return true if a report was received
+    ///
+    bool poll(LinkReport& report);
+
+private:
+    long long sock = -1;
+};
+
+#endif
@@ -0,0 +1,92 @@
+#ifndef __LINK_MODEL_HPP__
+#define __LINK_MODEL_HPP__
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "BitrateController.hpp"
+
+///
+/// \brief Capacity of the link from time_s until the next sample
+///
+struct LinkSample {
+    double time_s = 0.;
+    float bandwidth_kbps = 0.f;
+    float latency_ms = 0.f;             ///< propagation delay, without queuing
+    float packet_loss = 0.f;            ///< random loss ratio of the packets
+};
+
+///
+/// \brief Bandwidth, latency and loss over time
+///
+class LinkTrace {
+public:
+    ///
+    /// \brief CSV file, one "time_s,bandwidth_kbps,latency_ms,packet_loss" line per change, '#' for comments
+    ///
+    static bool load(const std::string& path, LinkTrace& trace);
+
+    ///
+    /// \brief predefined traces: "stable", "step", "wifi", "lossy", "oscillating", "congested"
+    ///
+    static bool builtin(const std::string& name, LinkTrace& trace);
+    static std::vector<std::string> builtinNames();
+
+    const LinkSample& at(double time_s) const;
+    double getDuration() const { return samples.empty() ? 0. : samples.back().time_s; }
+    const std::string& getName() const { return name; }
+
+private:
+    std::string name;
+    std::vector<LinkSample> samples;
+};
+
+///
+/// \brief Counters of a LinkSimulator run
+///
+struct LinkSimStats {
+    double duration_s = 0.;
+    double sent_kbits = 0.;
+    double delivered_kbits = 0.;
+    double on_time_kbits = 0.;          ///< delivered within the deadline, in time for a live display
+    double capacity_kbits = 0.;         ///< what the link could carry
+    uint64_t nb_frames_sent = 0;
+    uint64_t nb_frames_lost = 0;        ///< dropped by the queue or by packet loss
+    double stall_s = 0.;                ///< time with a queuing delay above 500ms
+    std::vector<float> delays_ms;       ///< of the delivered frames
+};
+
+///
+/// \brief The LinkSimulator class
+/// Frame level model of the streaming link: each frame (bitrate / fps) goes through a bottleneck queue drained at
+/// the trace bandwidth. A frame is lost when the queue is full or when one of its packets is lost, its delay is the
+/// queuing delay plus the trace latency. step() gives the LinkReport the receiver would send for the interval.
+///
+class LinkSimulator {
+public:
+    ///
+    /// \param buffer_ms : size of the bottleneck queue, in time at the current bandwidth
+    /// \param packet_kbits : size of a packet, for the loss of a frame
+    /// \param deadline_ms : delay above which a delivered frame is too late for a live display
+    ///
+    LinkSimulator(const LinkTrace& trace, float buffer_ms = 500.f, float packet_kbits = 32.f, unsigned seed = 42, float deadline_ms = 200.f);
+
+    LinkReport step(double dt_s, int bitrate_kbps, int fps);
+
+    double getTime() const { return time_s; }
+    const LinkSimStats& getStats() const { return stats; }
+
+private:
+    const LinkTrace& trace;
+    float buffer_ms, packet_kbits, deadline_ms;
+    std::mt19937 rng;
+    double time_s = 0.;
+    double next_frame_s = 0.;
+    double queue_kbits = 0.;
+    double queue_update_s = 0.;
+    LinkSimStats stats;
+};
+
+#endif
@@ -0,0 +1,217 @@
+#include "BitrateController.hpp"
+
+#include <algorithm>
+#include <cstdio>
+
+BitrateController::BitrateController(const BitrateConfig& config_, int fps, int resolution_level_) : config(config_) {
+    config.min_bitrate = std::max(1, config.min_bitrate);
+    config.max_bitrate = std::max(config.min_bitrate, config.max_bitrate);
+    bitrate = std::min(std::max(config.start_bitrate, config.min_bitrate), config.max_bitrate);
+
+    // Without fps adaptation, the only level is the camera one
+    if (!config.adapt_fps || config.fps_levels.empty()) config.fps_levels = {fps};
+    std::sort(config.fps_levels.begin(), config.fps_levels.end());
+    fps_level = 0;
+    for (size_t l = 0; l < config.fps_levels.size(); l++)
+        if (config.fps_levels[l] <= fps) fps_level = static_cast<int>(l);
+
+    config.nb_resolution_levels = std::max(1, config.nb_resolution_levels);
+    resolution_level = std::min(std::max(resolution_level_, 0), config.nb_resolution_levels - 1);
+}
+
+void BitrateController::setLog(std::ostream* log_) {
+    log = log_;
+    if (log) *log << "time_s,bitrate,fps,resolution_level,action,sent_fps,received_fps,loss,queuing_delay_ms,reason" << std::endl;
+}
+
+bool BitrateController::isCongested(const LinkReport& report, float queuing_delay, std::string& reason) const {
+    const float target_fps = static_cast<float>(getFps());
+    char text[128];
+    if (report.has_feedback) {
+        if (report.loss > config.loss_threshold) {
+            snprintf(text, sizeof(text), "loss %.1f%%", report.loss * 100.f);
+            reason = text;
+            return true;
+        }
+        if (queuing_delay > config.delay_threshold_ms) {
+            snprintf(text, sizeof(text), "queuing delay %.0fms", queuing_delay);
+            reason = text;
+            return true;
+        }
+        if (target_fps > 0.f && report.received_fps < config.fps_ratio_threshold * std::min(target_fps, report.sent_fps)) {
+            snprintf(text, sizeof(text), "received %.1f of %.1f FPS", report.received_fps, report.sent_fps);
+            reason = text;
+            return true;
+        }
+    } else if (target_fps > 0.f && report.sent_fps < config.fps_ratio_threshold * target_fps) {
+        // Without the receiver, the only sign of congestion is the sender slowing down
+        snprintf(text, sizeof(text), "sending %.1f of %.0f FPS", report.sent_fps, target_fps);
+        reason = text;
+        return true;
+    }
+    return false;
+}
+
+BitrateDecision BitrateController::update(const LinkReport& report) {
+    BitrateDecision decision;
+    decision.time_s = report.time_s;
+    const int previous_bitrate = bitrate, previous_fps_level = fps_level, previous_resolution = resolution_level;
+
+    // Queuing delay: the latency above its minimum over the window, the constant part (and clock offset) cancels out
+    if (report.has_feedback) {
+        latencies.push_back(std::make_pair(report.time_s, report.latency_ms));
+        while (!latencies.empty() && latencies.front().first < report.time_s - config.latency_window_s) latencies.pop_front();
+        float min_latency = report.latency_ms;
+        for (auto& l : latencies) min_latency = std::min(min_latency, l.second);
+        decision.queuing_delay_ms = report.latency_ms - min_latency;
+    }
+
+    // Loss and received fps over the window, weighted by the frames sent: one lost frame of a report is already 3%
+    LinkReport window = report;
+    if (report.has_feedback) {
+        reports.push_back(report);
+        while (!reports.empty() && reports.front().time_s < report.time_s - config.loss_window_s) reports.pop_front();
+        float sent = 0.f, received = 0.f, lost = 0.f;
+        for (auto& r : reports) {
+            sent += r.sent_fps;
+            received += r.received_fps;
+            lost += r.loss * r.sent_fps;
+        }
+        window.sent_fps = sent / reports.size();
+        window.received_fps = received / reports.size();
+        window.loss = sent > 0.f ? lost / sent : report.loss;
+    }
+
+    // The queue built up at the previous bitrate still drains, its delay and loss say nothing of the current one. It has
+    // to be clear within max_drain_s, a bitrate just below the capacity of the link would keep the delay for long
+    if (draining) {
+        const float drain_rate = (last_queuing_delay - decision.queuing_delay_ms) / static_cast<float>(std::max(1e-3, report.time_s - last_report_s));
+        draining = report.has_feedback && drain_rate > 0.f
+                && decision.queuing_delay_ms - drain_rate * config.max_drain_s <= config.delay_threshold_ms;
+    }
+    last_queuing_delay = decision.queuing_delay_ms;
+    last_report_s = report.time_s;
+
+    std::string reason;
+    const bool previous_clear = was_clear;
+    was_clear = false;
+    if (draining) {
+        decision.action = "hold";
+        decision.reason = "queue draining after decrease";
+    } else if (isCongested(window, decision.queuing_delay_ms, reason)) {
+        clear_count = 0;
+        upgrade_count = 0;
+        decision.reason = reason;
+        if (report.time_s - last_decrease_s < config.min_decrease_interval_s) {
+            decision.action = "hold";
+            decision.reason += " - waiting for the previous decrease";
+        } else if (bitrate > config.min_bitrate) {
+            int target = static_cast<int>(bitrate * config.decrease_factor);
+            // What goes through the link now, from the share of the frames received
+            int received_bitrate = bitrate;
+            if (report.has_feedback && report.sent_fps > 0.f) {
+                received_bitrate = static_cast<int>(bitrate * report.received_fps / report.sent_fps);
+                target = std::min(target, static_cast<int>(0.85f * received_bitrate));
+            }
+            if (previous_clear) {
+                const bool recent_increase = report.time_s - last_increase_s <= config.min_increase_interval_s;
+                if (recent_increase && received_bitrate >= increased_from) {
+                    // The link still carries the bitrate before the increase, which congested it: the next increases
+                    // stay below it for a while
+                    failed_bitrate = bitrate;
+                    failed_s = report.time_s;
+                    recovery_bitrate = 0;
+                } else
+                    // The bitrate went through until the link dropped, the increases go half way back to it
+                    recovery_bitrate = std::max(recovery_bitrate, recent_increase ? increased_from : bitrate);
+            }
+            bitrate = std::max(config.min_bitrate, target);
+            decision.action = "decrease";
+            if (config.adapt_fps && fps_level > 0 && bitrate < config.downgrade_bitrate) {
+                fps_level--;
+                decision.action = "fps_down";
+            }
+            last_decrease_s = report.time_s;
+            draining = true;
+            // The loss of the previous bitrate
+            reports.clear();
+        } else if (config.adapt_fps && fps_level > 0) {
+            fps_level--;
+            decision.action = "fps_down";
+            last_decrease_s = report.time_s;
+        } else if (config.adapt_resolution && resolution_level > 0) {
+            resolution_level--;
+            decision.action = "resolution_down";
+            last_decrease_s = report.time_s;
+        } else {
+            decision.action = "hold";
+            decision.reason += " - already at the minimum";
+        }
+    } else {
+        clear_count++;
+        upgrade_count++;
+        was_clear = true;
+        if (report.time_s - last_decrease_s < config.hold_after_decrease_s) {
+            decision.action = "hold";
+            decision.reason = "after decrease";
+        } else if (report.time_s - last_change_s < config.min_increase_interval_s) {
+            // The clear intervals keep counting, the increase happens once the restarts are spaced enough
+            decision.action = "hold";
+            decision.reason = "after change";
+        } else if (upgrade_count >= config.upgrade_after && bitrate >= std::min(config.upgrade_bitrate, config.max_bitrate)
+                && config.adapt_resolution && resolution_level + 1 < config.nb_resolution_levels) {
+            // The quality comes back in the reverse order: resolution first, then fps
+            resolution_level++;
+            clear_count = upgrade_count = 0;
+            decision.action = "resolution_up";
+            decision.reason = "link clear";
+        } else if (upgrade_count >= config.upgrade_after && bitrate >= std::min(config.upgrade_bitrate, config.max_bitrate)
+                && config.adapt_fps && fps_level + 1 < static_cast<int>(config.fps_levels.size())) {
+            fps_level++;
+            clear_count = upgrade_count = 0;
+            decision.action = "fps_up";
+            decision.reason = "link clear";
+        } else if (report.has_feedback && window.loss > config.loss_hold) {
+            char text[64];
+            snprintf(text, sizeof(text), "loss %.1f%%", window.loss * 100.f);
+            decision.action = "hold";
+            decision.reason = text;
+        } else if (clear_count >= config.increase_after && bitrate < config.max_bitrate) {
+            // Far from any bitrate which congested the link, the increases are multiplicative
+            const bool near_failure = report.time_s - failed_s < config.probe_backoff_s;
+            int target = near_failure ? bitrate + config.increase_step : std::max(bitrate + config.increase_step, static_cast<int>(bitrate * config.increase_factor));
+            if (config.fast_recovery && recovery_bitrate > target) target = (bitrate + recovery_bitrate) / 2;
+            else recovery_bitrate = 0;
+            if (near_failure) target = std::min(target, failed_bitrate - config.increase_step);
+            if (target > bitrate) {
+                increased_from = bitrate;
+                bitrate = std::min(config.max_bitrate, target);
+                clear_count = 0;
+                last_increase_s = report.time_s;
+                decision.action = "increase";
+                decision.reason = "link clear";
+            } else {
+                decision.action = "hold";
+                decision.reason = "below the bitrate which congested the link";
+            }
+        } else {
+            decision.action = "hold";
+            decision.reason = (bitrate < config.max_bitrate) ? "waiting for clear intervals" : "at maximum";
+        }
+    }
+
+    decision.bitrate = bitrate;
+    decision.fps = getFps();
+    decision.resolution_level = resolution_level;
+    decision.changed = bitrate != previous_bitrate || fps_level != previous_fps_level || resolution_level != previous_resolution;
+    if (decision.changed) last_change_s = report.time_s;
+
+    if (log) {
+        char line[256];
+        snprintf(line, sizeof(line), "%.2f,%d,%d,%d,%s,%.1f,%.1f,%.4f,%.1f,", decision.time_s, decision.bitrate, decision.fps,
+                decision.resolution_level, decision.action.c_str(), report.sent_fps, report.has_feedback ? report.received_fps : -1.f,
+                report.has_feedback ? report.loss : -1.f, decision.queuing_delay_ms);
+        *log << line << decision.reason << std::endl;
+    }
+    return decision;
+}
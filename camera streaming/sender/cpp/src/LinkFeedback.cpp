@@ -0,0 +1,86 @@
+#include "LinkFeedback.hpp"
+
+#include <cstdio>
+
+#ifdef _WIN32
+#include <winsock2.h>
+typedef int socklen_t;
+#else
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+std::string formatFeedback(const LinkReport& report) {
+    char text[96];
+    snprintf(text, sizeof(text), "ZEDFB %.2f %.4f %.2f", report.received_fps, report.loss, report.latency_ms);
+    return text;
+}
+
+bool parseFeedback(const std::string& message, LinkReport& report) {
+    float fps, loss, latency;
+    if (sscanf(message.c_str(), "ZEDFB %f %f %f", &fps, &loss, &latency) != 3) return false;
+    report.has_feedback = true;
+    report.received_fps = fps;
+    report.loss = loss;
+    report.latency_ms = latency;
+    return true;
+}
+
+FeedbackListener::~FeedbackListener() {
+    close();
+}
+
+bool FeedbackListener::open(unsigned short port) {
+    close();
+#ifdef _WIN32
+    WSADATA wsa_data;
+    if (WSAStartup(MAKEWORD(2, 2), &wsa_data) != 0) return false;
+#endif
+    long long s = static_cast<long long>(socket(AF_INET, SOCK_DGRAM, 0));
+    if (s < 0) return false;
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(port);
+    bool ok = bind(s, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0;
+#ifdef _WIN32
+    u_long non_blocking = 1;
+    ok = ok && ioctlsocket(s, FIONBIO, &non_blocking) == 0;
+#else
+    ok = ok && fcntl(static_cast<int>(s), F_SETFL, fcntl(static_cast<int>(s), F_GETFL, 0) | O_NONBLOCK) == 0;
+#endif
+    sock = s;
+    if (!ok) close();
+    return ok;
+}
+
+void FeedbackListener::close() {
+    if (sock < 0) return;
+#ifdef _WIN32
+    closesocket(static_cast<SOCKET>(sock));
+    WSACleanup();
+#else
+    ::close(static_cast<int>(sock));
+#endif
+    sock = -1;
+}
+
+bool FeedbackListener::isOpened() const {
+    return sock >= 0;
+}
+
+bool FeedbackListener::poll(LinkReport& report) {
+    if (sock < 0) return false;
+    bool received = false;
+    char buffer[256];
+    while (true) {
+        int size = static_cast<int>(recv(sock, buffer, sizeof(buffer) - 1, 0));
+        if (size <= 0) break;
+        buffer[size] = '\0';
+        received |= parseFeedback(buffer, report);
+    }
+    return received;
+}
@@ -0,0 +1,142 @@
+#include "LinkModel.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+
+bool LinkTrace::load(const std::string& path, LinkTrace& trace) {
+    std::ifstream file(path);
+    if (!file.is_open()) return false;
+    trace.name = path;
+    trace.samples.clear();
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        std::replace(line.begin(), line.end(), ',', ' ');
+        std::istringstream ss(line);
+        LinkSample s;
+        if (!(ss >> s.time_s >> s.bandwidth_kbps >> s.latency_ms >> s.packet_loss)) continue; // header
+        trace.samples.push_back(s);
+    }
+    std::sort(trace.samples.begin(), trace.samples.end(), [](const LinkSample& a, const LinkSample& b) { return a.time_s < b.time_s; });
+    return trace.samples.size() > 1;
+}
+
+std::vector<std::string> LinkTrace::builtinNames() {
+    return {"stable", "step", "wifi", "lossy", "oscillating", "congested"};
+}
+
+bool LinkTrace::builtin(const std::string& name, LinkTrace& trace) {
+    trace.name = name;
+    trace.samples.clear();
+    auto add = [&](double t, float bw, float latency, float loss) {
+        LinkSample s;
+        s.time_s = t;
+        s.bandwidth_kbps = bw;
+        s.latency_ms = latency;
+        s.packet_loss = loss;
+        trace.samples.push_back(s);
+    };
+    if (name == "stable") {
+        // Wired link, more than the camera needs
+        add(0, 20000, 5, 0);
+        add(120, 20000, 5, 0);
+    } else if (name == "step") {
+        // The link falls to a third of its capacity, then comes back
+        add(0, 12000, 20, 0);
+        add(40, 4000, 20, 0);
+        add(80, 12000, 20, 0);
+        add(120, 12000, 20, 0);
+    } else if (name == "wifi") {
+        // Congested Wi-Fi: capacity changing every few seconds, short deep fades, some loss
+        std::mt19937 rng(3);
+        std::uniform_real_distribution<float> bw(5000.f, 14000.f);
+        for (int t = 0; t < 180; t += 4) {
+            bool fade = (t % 36) == 20;
+            add(t, fade ? 1500.f : bw(rng), fade ? 60.f : 15.f, fade ? 0.02f : 0.002f);
+        }
+        add(180, 8000, 15, 0.002f);
+    } else if (name == "lossy") {
+        // Enough capacity, but the random loss alone breaks frames
+        add(0, 15000, 30, 0.005f);
+        add(60, 15000, 30, 0.0005f);
+        add(120, 15000, 30, 0.0005f);
+    } else if (name == "oscillating") {
+        // Capacity alternating between high and low every 10s
+        for (int t = 0; t < 120; t += 10)
+            add(t, (t / 10) % 2 ? 3000.f : 10000.f, 20, 0);
+        add(120, 10000, 20, 0);
+    } else if (name == "congested") {
+        // Crowded cell: for a minute, the uplink carries a fraction of the stream
+        add(0, 12000, 40, 0.001f);
+        add(30, 2000, 60, 0.005f);
+        add(90, 12000, 40, 0.001f);
+        add(150, 12000, 40, 0.001f);
+    } else
+        return false;
+    return true;
+}
+
+const LinkSample& LinkTrace::at(double time_s) const {
+    // Last sample at or before time_s
+    auto it = std::upper_bound(samples.begin(), samples.end(), time_s, [](double t, const LinkSample& s) { return t < s.time_s; });
+    return (it == samples.begin()) ? samples.front() : *(it - 1);
+}
+
+LinkSimulator::LinkSimulator(const LinkTrace& trace_, float buffer_ms_, float packet_kbits_, unsigned seed, float deadline_ms_)
+    : trace(trace_), buffer_ms(buffer_ms_), packet_kbits(packet_kbits_), deadline_ms(deadline_ms_), rng(seed) {}
+
+LinkReport LinkSimulator::step(double dt_s, int bitrate_kbps, int fps) {
+    std::uniform_real_distribution<double> uniform(0., 1.);
+    const double end_s = time_s + dt_s;
+    const double frame_kbits = static_cast<double>(bitrate_kbps) / std::max(1, fps);
+    uint64_t sent = 0, received = 0;
+    double delay_sum = 0.;
+
+    while (next_frame_s < end_s) {
+        const LinkSample& link = trace.at(next_frame_s);
+        const double bandwidth = std::max(1.f, link.bandwidth_kbps);
+        // The queue drained since the previous frame
+        queue_kbits = std::max(0., queue_kbits - bandwidth * (next_frame_s - queue_update_s));
+        stats.capacity_kbits += bandwidth * (next_frame_s - queue_update_s);
+        queue_update_s = next_frame_s;
+
+        sent++;
+        stats.sent_kbits += frame_kbits;
+        const double capacity = bandwidth * buffer_ms * 1e-3;
+        const double nb_packets = std::ceil(frame_kbits / packet_kbits);
+        const double frame_loss = 1. - std::pow(1. - link.packet_loss, nb_packets);
+        if (queue_kbits + frame_kbits > capacity) {
+            stats.nb_frames_lost++;        // tail drop
+        } else {
+            queue_kbits += frame_kbits;
+            if (uniform(rng) < frame_loss)
+                stats.nb_frames_lost++;
+            else {
+                float delay = static_cast<float>(queue_kbits / bandwidth * 1e3 + link.latency_ms);
+                received++;
+                delay_sum += delay;
+                stats.delivered_kbits += frame_kbits;
+                if (delay <= deadline_ms) stats.on_time_kbits += frame_kbits;
+                stats.delays_ms.push_back(delay);
+            }
+        }
+        if (queue_kbits / bandwidth > 0.5) stats.stall_s += 1. / std::max(1, fps);
+        next_frame_s += 1. / std::max(1, fps);
+    }
+    time_s = end_s;
+    stats.duration_s = time_s;
+    stats.nb_frames_sent += sent;
+
+    LinkReport report;
+    report.time_s = time_s;
+    report.sent_fps = static_cast<float>(sent / dt_s);
+    report.has_feedback = true;
+    report.received_fps = static_cast<float>(received / dt_s);
+    report.loss = sent ? 1.f - static_cast<float>(received) / sent : 0.f;
+    // Without any frame, the latency is the one of the last frame in the queue
+    report.latency_ms = received ? static_cast<float>(delay_sum / received)
+                                 : static_cast<float>(queue_kbits / std::max(1.f, trace.at(time_s).bandwidth_kbps) * 1e3 + trace.at(time_s).latency_ms);
+    return report;
+}
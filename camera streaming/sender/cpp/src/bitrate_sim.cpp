@@ -0,0 +1,163 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+/***********************************************************************
+ ** Offline test of the BitrateController on simulated links, no ZED  **
+ ** needed: the fixed 8000kbits/s of the sample is compared to the    **
+ ** adaptive bitrate (and fps) on bandwidth/latency/loss traces, and  **
+ ** each trace is checked against the expected gains.                 **
+ ***********************************************************************/
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "BitrateController.hpp"
+#include "LinkModel.hpp"
+
+struct RunResult {
+    LinkSimStats stats;
+    int nb_changes = 0;
+    int nb_fps_down = 0;
+    int final_fps = 0;
+
+    double goodput() const { return stats.on_time_kbits / std::max(1e-3, stats.duration_s); }
+    float lostRatio() const { return static_cast<float>(stats.nb_frames_lost) / std::max<uint64_t>(1, stats.nb_frames_sent); }
+    float delayPercentile(int p) const {
+        std::vector<float> delays = stats.delays_ms;
+        if (delays.empty()) return 0.f;
+        std::sort(delays.begin(), delays.end());
+        return delays[std::min(delays.size() - 1, delays.size() * p / 100)];
+    }
+};
+
+static RunResult run(const LinkTrace& trace, bool adaptive, bool adapt_fps, std::ostream* log) {
+    BitrateConfig config;
+    config.adapt_fps = adapt_fps;
+    BitrateController controller(config, 30);
+    controller.setLog(log);
+    LinkSimulator link(trace);
+    RunResult result;
+    int bitrate = adaptive ? controller.getBitrate() : config.start_bitrate;
+    int fps = 30;
+    while (link.getTime() < trace.getDuration()) {
+        LinkReport report = link.step(1., bitrate, fps);
+        if (!adaptive) continue;
+        BitrateDecision decision = controller.update(report);
+        if (decision.changed) result.nb_changes++;
+        if (decision.fps < fps) result.nb_fps_down++;
+        bitrate = decision.bitrate;
+        fps = decision.fps;
+    }
+    result.stats = link.getStats();
+    result.final_fps = fps;
+    return result;
+}
+
+static void print(const std::string& label, const RunResult& r) {
+    const LinkSimStats& s = r.stats;
+    printf("  %-14s %9.0f %9.0f %8.1f%% %8.1f%% %9.0f %9.0f %8.1f %8d\n", label.c_str(), r.goodput(), s.delivered_kbits / s.duration_s,
+            100. * s.delivered_kbits / std::max(1., s.capacity_kbits), 100. * r.lostRatio(), r.delayPercentile(50), r.delayPercentile(95),
+            s.stall_s, r.nb_changes);
+}
+
+static bool check(bool condition, const std::string& what) {
+    printf("  %-60s %s\n", what.c_str(), condition ? "ok" : "FAILED");
+    return condition;
+}
+
+///
+/// \brief What the adaptive bitrate has to achieve on a trace, compared to the fixed bitrate
+///
+struct Expectation {
+    float goodput_ratio = 1.f;          ///< goodput at least this ratio of the fixed one
+    bool fps_down = false;              ///< with --adaptive-fps, the fps is lowered then raised back
+};
+
+static Expectation expectation(const std::string& trace) {
+    Expectation e;
+    // The capacity swings around 8000kbits/s faster than the increases can follow (one every 5s at most, each one
+    // restarts the stream): the fixed bitrate keeps more of the good periods, the adaptive one trades a part of it for
+    // the delay and the lost frames
+    if (trace == "wifi" || trace == "oscillating") e.goodput_ratio = 0.7f;
+    // A minute far below the bitrate of the stream, long enough to lower the fps then raise it back
+    if (trace == "congested") e.fps_down = true;
+    return e;
+}
+
+static bool checkRun(const std::string& label, const RunResult& r, const RunResult& fixed, const Expectation& e) {
+    bool ok = true;
+    char text[128];
+    snprintf(text, sizeof(text), "%s: goodput %.0f, at least %.0f%% of the fixed %.0f", label.c_str(), r.goodput(), 100.f * e.goodput_ratio,
+            fixed.goodput());
+    ok &= check(r.goodput() >= e.goodput_ratio * fixed.goodput(), text);
+    // Below the delay of a full queue, low anyway when the link carries the fixed bitrate
+    const float max_p95 = std::max(100.f, 0.9f * fixed.delayPercentile(95));
+    snprintf(text, sizeof(text), "%s: p95 delay %.0fms, at most %.0fms", label.c_str(), r.delayPercentile(95), max_p95);
+    ok &= check(r.delayPercentile(95) <= max_p95, text);
+    // One change every 4s on average: the increases alone come every 5s at most, more is the bitrate following the link noise
+    const int max_changes = static_cast<int>(r.stats.duration_s / 4.);
+    snprintf(text, sizeof(text), "%s: %d changes, at most %d", label.c_str(), r.nb_changes, max_changes);
+    ok &= check(r.nb_changes <= max_changes, text);
+    return ok;
+}
+
+int main(int argc, char **argv) {
+    // [trace.csv or builtin name] [decisions.csv]
+    std::vector<LinkTrace> traces;
+    if (argc > 1) {
+        LinkTrace trace;
+        if (!LinkTrace::builtin(argv[1], trace) && !LinkTrace::load(argv[1], trace)) {
+            std::cout << "[Sample][Error] Can not read the trace " << argv[1] << std::endl;
+            return EXIT_FAILURE;
+        }
+        traces.push_back(trace);
+    } else
+        for (auto& name : LinkTrace::builtinNames()) {
+            LinkTrace trace;
+            LinkTrace::builtin(name, trace);
+            traces.push_back(trace);
+        }
+
+    std::ofstream log_file;
+    if (argc > 2) log_file.open(argv[2]);
+
+    bool ok = true;
+    for (auto& trace : traces) {
+        std::cout << "Trace \"" << trace.getName() << "\", " << trace.getDuration() << "s" << std::endl;
+        printf("  %-14s %9s %9s %9s %9s %9s %9s %8s %8s\n", "", "goodput", "delivered", "use", "lost", "p50 (ms)", "p95 (ms)", "stall(s)", "changes");
+        RunResult fixed = run(trace, false, false, nullptr);
+        RunResult adaptive = run(trace, true, false, log_file.is_open() ? &log_file : nullptr);
+        RunResult adaptive_fps = run(trace, true, true, nullptr);
+        print("fixed 8000", fixed);
+        print("adaptive", adaptive);
+        print("adaptive+fps", adaptive_fps);
+
+        const Expectation e = expectation(trace.getName());
+        ok &= checkRun("adaptive", adaptive, fixed, e);
+        ok &= checkRun("adaptive+fps", adaptive_fps, fixed, e);
+        if (e.fps_down)
+            ok &= check(adaptive_fps.nb_fps_down > 0 && adaptive_fps.final_fps == 30, "adaptive+fps: fps lowered during the congestion, then raised back");
+    }
+    std::cout << (ok ? "PASSED" : "FAILED") << std::endl;
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -26,21 +26,38 @@
 // Standard includes
 #include <stdio.h>
 #include <string.h>
+#include <chrono>
+#include <fstream>
+#include <vector>
 
 // ZED includes
 #include <sl/Camera.hpp>
 
 // Sample includes
+#include "BitrateController.hpp"
+#include "LinkFeedback.hpp"
 #include "utils.hpp"
+#include "ZedFrameSource.hpp"
 
 // Using namespace
 using namespace sl;
 using namespace std;
 
 void print(string msg_prefix, ERROR_CODE err_code = ERROR_CODE::SUCCESS, string msg_suffix = "");
-int parseArgs(int argc, char **argv, sl::InitParameters& param);
+
+struct AdaptiveOptions {
+    bool enabled = false;
+    BitrateConfig config;
+    int feedback_port = 0;
+    string log_path;
+};
+bool parseAdaptiveArgs(int& argc, char **argv, AdaptiveOptions& options);
 
 int main(int argc, char **argv) {
+    // The adaptive bitrate options are removed from argv, the others keep their position
+    AdaptiveOptions adaptive;
+    if (!parseAdaptiveArgs(argc, argv, adaptive)) return EXIT_FAILURE;
+
     // Create a ZED camera
     Camera zed;
 
@@ -49,7 +66,9 @@ int main(int argc, char **argv) {
     init_parameters.camera_resolution = sl::RESOLUTION::HD720;
     init_parameters.depth_mode = DEPTH_MODE::NONE;
     init_parameters.sdk_verbose = true;
-    int res_arg = parseArgs(argc, argv, init_parameters);
+    // Input of the sample: SVO file, IP[:port] of a stream, camera resolution or --source (FrameSource.hpp)
+    FrameSourceOptions source;
+    if (!source.parse(argc, argv) || !applyFrameSource(source, init_parameters)) return EXIT_FAILURE;
 
     // Open the camera
     auto returned_state = zed.open(init_parameters);
@@ -62,8 +81,8 @@ int main(int argc, char **argv) {
     stream_params.codec = STREAMING_CODEC::H264;
     stream_params.bitrate = 8000;
     stream_params.chunk_size = 4096;
-    if (argc == 2 && res_arg == 1) stream_params.port = atoi(argv[1]);
-    if (argc > 2) stream_params.port = atoi(argv[2]);
+    // The input is removed from argv by the parse, the port follows it
+    if (argc > 1) stream_params.port = atoi(argv[1]);
 
     returned_state = zed.enableStreaming(stream_params);
     if (returned_state != ERROR_CODE::SUCCESS) {
@@ -73,11 +92,55 @@ int main(int argc, char **argv) {
 
     print("Streaming on port " + to_string(stream_params.port));
 
+    // Adaptive bitrate: once per second, the controller gets the sender FPS and the receiver report (if any),
+    // a new bitrate or framerate restarts the streaming
+    const int camera_fps = static_cast<int>(zed.getCameraInformation().camera_configuration.fps);
+    adaptive.config.start_bitrate = stream_params.bitrate;
+    BitrateController controller(adaptive.config, camera_fps);
+    ofstream log_file;
+    if (adaptive.enabled && !adaptive.log_path.empty()) {
+        log_file.open(adaptive.log_path);
+        controller.setLog(&log_file);
+    }
+    FeedbackListener feedback;
+    if (adaptive.enabled && adaptive.feedback_port > 0) {
+        if (feedback.open(adaptive.feedback_port))
+            print("Waiting for receiver feedback on UDP port " + to_string(adaptive.feedback_port));
+        else
+            print("Feedback port " + to_string(adaptive.feedback_port) + " unavailable, sender statistics only", ERROR_CODE::FAILURE);
+    }
+    LinkReport feedback_report;
+    auto start = chrono::steady_clock::now(), last_update = start, last_feedback = start - chrono::hours(1);
+
     SetCtrlHandler();
 
     while (!exit_app) {
         if (zed.grab() != ERROR_CODE::SUCCESS)
             sleep_ms(1);
+
+        if (!adaptive.enabled) continue;
+        auto now = chrono::steady_clock::now();
+        if (feedback.poll(feedback_report)) last_feedback = now;
+        if (now - last_update < chrono::seconds(1)) continue;
+        last_update = now;
+
+        LinkReport report = feedback_report;
+        report.time_s = chrono::duration<double>(now - start).count();
+        report.sent_fps = zed.getCurrentFPS();
+        // A report older than 3s is not the current state of the link
+        report.has_feedback = now - last_feedback < chrono::seconds(3);
+        BitrateDecision decision = controller.update(report);
+        if (!decision.changed) continue;
+
+        print("Bitrate " + to_string(decision.bitrate) + " kbits/s, " + to_string(decision.fps) + " FPS (" + decision.action + ": " + decision.reason + ")");
+        zed.disableStreaming();
+        stream_params.bitrate = decision.bitrate;
+        stream_params.target_framerate = decision.fps;
+        returned_state = zed.enableStreaming(stream_params);
+        if (returned_state != ERROR_CODE::SUCCESS) {
+            print("Streaming restart error: ", returned_state);
+            break;
+        }
     }
 
     // disable Streaming
@@ -104,41 +167,38 @@ void print(string msg_prefix, ERROR_CODE err_code, string msg_suffix) {
     cout << endl;
 }
 
-int parseArgs(int argc, char **argv, sl::InitParameters& param) {
-    if (argc > 1 && string(argv[1]).find(".svo") != string::npos) {
-        // SVO input mode
-        param.input.setFromSVOFile(argv[1]);
-        cout << "[Sample] Using SVO File input: " << argv[1] << endl;
-    } else if (argc > 1 && string(argv[1]).find(".svo") == string::npos) {
-        string arg = string(argv[1]);
-        unsigned int a, b, c, d, port;
-        if (sscanf(arg.c_str(), "%u.%u.%u.%u:%d", &a, &b, &c, &d, &port) == 5) {
-            // Stream input mode - IP + port
-            string ip_adress = to_string(a) + "." + to_string(b) + "." + to_string(c) + "." + to_string(d);
-            param.input.setFromStream(sl::String(ip_adress.c_str()), port);
-            cout << "[Sample] Using Stream input, IP : " << ip_adress << ", port : " << port << endl;
-        } else if (sscanf(arg.c_str(), "%u.%u.%u.%u", &a, &b, &c, &d) == 4) {
-            // Stream input mode - IP only
-            param.input.setFromStream(sl::String(argv[1]));
-            cout << "[Sample] Using Stream input, IP : " << argv[1] << endl;
-        } else if (arg.find("HD2K") != string::npos) {
-            param.camera_resolution = sl::RESOLUTION::HD2K;
-            cout << "[Sample] Using Camera in resolution HD2K" << endl;
-        } else if (arg.find("HD1080") != string::npos) {
-            param.camera_resolution = sl::RESOLUTION::HD1080;
-            cout << "[Sample] Using Camera in resolution HD1080" << endl;
-        } else if (arg.find("HD720") != string::npos) {
-            param.camera_resolution = sl::RESOLUTION::HD720;
-            cout << "[Sample] Using Camera in resolution HD720" << endl;
-        } else if (arg.find("VGA") != string::npos) {
-            param.camera_resolution = sl::RESOLUTION::VGA;
-            cout << "[Sample] Using Camera in resolution VGA" << endl;
-        } else
-            return 1;
-    } else {
-        // Default
-        return 1;
+bool parseAdaptiveArgs(int& argc, char **argv, AdaptiveOptions& options) {
+    int nb_args = 1;
+    for (int i = 1; i < argc; i++) {
+        string arg(argv[i]);
+        if ((arg == "--bitrate-range" || arg == "--feedback-port" || arg == "--log") && i + 1 >= argc) {
+            print(arg + " needs a value", ERROR_CODE::INVALID_FUNCTION_CALL);
+            return false;
+        }
+        if (arg == "--adaptive")
+            options.enabled = true;
+        else if (arg == "--adaptive-fps")
+            options.enabled = options.config.adapt_fps = true;
+        else if (arg == "--bitrate-range") {
+            // <min>-<max> in kbits/s, nothing after it
+            int min_bitrate = 0, max_bitrate = 0, length = 0;
+            const char* range = argv[++i];
+            if (sscanf(range, "%d-%d%n", &min_bitrate, &max_bitrate, &length) != 2 || range[length] != '\0'
+                    || min_bitrate <= 0 || max_bitrate < min_bitrate) {
+                print("Invalid --bitrate-range " + string(range) + ", expected <min>-<max> in kbits/s, such as 1000-16000",
+                        ERROR_CODE::INVALID_FUNCTION_CALL);
+                return false;
+            }
+            options.config.min_bitrate = min_bitrate;
+            options.config.max_bitrate = max_bitrate;
+        } else if (arg == "--feedback-port")
+            options.feedback_port = atoi(argv[++i]);
+        else if (arg == "--log")
+            options.log_path = argv[++i];
+        else
+            argv[nb_args++] = argv[i];
     }
-    return 0;
+    argc = nb_args;
+    return true;
 }
 
@@ -0,0 +1,35 @@
+# One headless run of a sample, for the zed_samples_headless targets of the root CMakeLists.txt. On a SVO file:
+#   cmake -DSAMPLE=<executable> -DSVO=<file.svo> -DRESULTS=<results.txt> -P HeadlessRun.cmake
+# or on the frames of a FrameSource without camera (synthetic, images, raw container), from the folder of the sample files:
+#   cmake -DSAMPLE=<executable> -DSOURCE=synthetic -DFRAMES=<N> -DRESULTS=<results.txt> [-DWORKING_DIRECTORY=<dir>] -P HeadlessRun.cmake
+# Fails if the sample does not end by itself at the end of the input, returns an error, or writes no result
+
+get_filename_component(SAMPLE_NAME "${SAMPLE}" NAME_WE)
+if (SOURCE)
+    set(INPUT_ARGS --source ${SOURCE} --frames ${FRAMES})
+else()
+    set(INPUT_ARGS "${SVO}")
+endif()
+if (NOT WORKING_DIRECTORY)
+    set(WORKING_DIRECTORY "${CMAKE_CURRENT_BINARY_DIR}")
+endif()
+file(REMOVE "${RESULTS}")
+execute_process(COMMAND "${SAMPLE}" --headless --sink "file:${RESULTS}" ${INPUT_ARGS}
+                WORKING_DIRECTORY "${WORKING_DIRECTORY}"
+                RESULT_VARIABLE RUN_RESULT
+                OUTPUT_VARIABLE RUN_OUTPUT
+                ERROR_VARIABLE RUN_OUTPUT
+                TIMEOUT 900)
+if (NOT RUN_RESULT EQUAL 0)
+    message(FATAL_ERROR "${SAMPLE_NAME}: headless run failed (${RUN_RESULT})\n${RUN_OUTPUT}")
+endif()
+
+set(NB_RESULTS 0)
+if (EXISTS "${RESULTS}")
+    file(STRINGS "${RESULTS}" RESULT_LINES)
+    list(LENGTH RESULT_LINES NB_RESULTS)
+endif()
+if (NB_RESULTS EQUAL 0)
+    message(FATAL_ERROR "${SAMPLE_NAME}: no result written\n${RUN_OUTPUT}")
+endif()
+message(STATUS "${SAMPLE_NAME}: ${NB_RESULTS} frames")
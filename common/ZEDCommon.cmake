@@ -0,0 +1,72 @@
+# Components shared by the samples, compiled with the sources of each sample:
+#   include(${CMAKE_CURRENT_SOURCE_DIR}/<path to the repository>/common/ZEDCommon.cmake)
+# then add the files of the components used to the executable.
+
+SET(ZED_COMMON_DIR ${CMAKE_CURRENT_LIST_DIR})
+include_directories(${ZED_COMMON_DIR}/include)
+
+# GLPresenter: upload of the frames to OpenGL textures, in RGBA order (ImageFormat). Define GL_PRESENTER_CUDA in the samples built with CUDA
+SET(GL_PRESENTER_FILES ${ZED_COMMON_DIR}/include/GLPresenter.hpp ${ZED_COMMON_DIR}/src/GLPresenter.cpp
+                       ${ZED_COMMON_DIR}/include/ImageFormat.hpp ${ZED_COMMON_DIR}/src/ImageFormat.cpp)
+
+# SharedFrameRing: ring of frames in shared memory, one writer and readers in other processes. Link pthread and rt on Linux
+SET(SHARED_FRAME_RING_FILES ${ZED_COMMON_DIR}/include/SharedFrameRing.hpp ${ZED_COMMON_DIR}/src/SharedFrameRing.cpp)
+
+# DisplayMode: --headless, --preview N and --sink options of the samples, results sent to a ResultSink
+SET(DISPLAY_MODE_FILES ${ZED_COMMON_DIR}/include/DisplayMode.hpp ${ZED_COMMON_DIR}/src/DisplayMode.cpp
+                       ${ZED_COMMON_DIR}/include/ResultSink.hpp ${ZED_COMMON_DIR}/src/ResultSink.cpp ${SHARED_FRAME_RING_FILES})
+
+# MatBridge: sl::Mat <-> cv::Mat and cv::cuda::GpuMat views without copy, PinnedStaging for the downloads of GPU frames.
+# Needs the ZED SDK, OpenCV and the CUDA runtime
+SET(MAT_BRIDGE_FILES ${ZED_COMMON_DIR}/include/MatBridge.hpp ${ZED_COMMON_DIR}/src/MatBridge.cpp)
+
+# FrameContainer: raw container of LEFT images and DEPTH maps written by the SVO export (mode 5), memory mapped.
+# Define WITH_LZ4 / WITH_ZSTD and link the libraries to read or write the compressed containers
+SET(FRAME_CONTAINER_FILES ${ZED_COMMON_DIR}/include/FrameContainer.hpp ${ZED_COMMON_DIR}/src/FrameContainer.cpp)
+
+# FrameSource: --source, --frames, --prefetch options and input argument of the samples, frames of a camera, SVO, stream,
+# image directory, raw container or synthetic generator. Link pthread. Define FRAME_SOURCE_ZED and add FRAME_SOURCE_ZED_FILES
+# in the samples built with the ZED SDK, FRAME_SOURCE_OPENCV in the ones built with OpenCV for the image directories
+SET(FRAME_SOURCE_FILES ${ZED_COMMON_DIR}/include/FrameSource.hpp ${ZED_COMMON_DIR}/src/FrameSource.cpp ${FRAME_CONTAINER_FILES})
+SET(FRAME_SOURCE_ZED_FILES ${ZED_COMMON_DIR}/include/ZedFrameSource.hpp ${ZED_COMMON_DIR}/src/ZedFrameSource.cpp)
+
+# SensorStream: thread reading the IMU of a camera (or of a mock source) at its rate, new samples given to callbacks and queued.
+# Needs the ZED SDK. Link pthread
+SET(SENSOR_STREAM_FILES ${ZED_COMMON_DIR}/include/SensorStream.hpp ${ZED_COMMON_DIR}/src/SensorStream.cpp)
+
+# StageTrace: --trace and --trace-stats options of the samples, latency of the stages of their loops (STAGE_SPAN)
+SET(STAGE_TRACE_FILES ${ZED_COMMON_DIR}/include/StageTrace.hpp ${ZED_COMMON_DIR}/src/StageTrace.cpp)
+
+# BenchSuite: harness of the benchmarks of the samples, results as a table and as JSON (Google Benchmark layout)
+SET(BENCH_SUITE_FILES ${ZED_COMMON_DIR}/include/BenchSuite.hpp ${ZED_COMMON_DIR}/src/BenchSuite.cpp)
+
+# Adds a benchmark executable to the suites run by the zed_samples_bench target of the root CMakeLists.txt.
+# Nothing to do when the sample is built on its own
+macro(zed_add_bench_suite name)
+    if (DEFINED BENCH_LIST)
+        LIST(APPEND BENCH_LIST ${name})
+        SET(BENCH_LIST "${BENCH_LIST}" PARENT_SCOPE)
+    endif()
+endmacro()
+
+# Adds a sample to the headless runs of the zed_samples_headless target of the root CMakeLists.txt: the sample plays the
+# ZED_SAMPLES_SVO file with --headless, its results are written in headless/<name>.txt of the build directory and checked
+# by HeadlessRun.cmake. Nothing to do when the sample is built on its own
+macro(zed_add_headless_run name)
+    if (DEFINED HEADLESS_RUN_LIST)
+        LIST(APPEND HEADLESS_RUN_LIST ${name})
+        SET(HEADLESS_RUN_LIST "${HEADLESS_RUN_LIST}" PARENT_SCOPE)
+    endif()
+endmacro()
+
+# Adds a sample reading a FrameSource to the headless runs of the zed_samples_headless_synthetic target of the root
+# CMakeLists.txt: the sample runs on --source synthetic --frames 90 with --headless, from the folder given as second
+# argument if any (model files, ...), and is checked by HeadlessRun.cmake as above. Needs no camera nor SVO.
+# Nothing to do when the sample is built on its own
+macro(zed_add_headless_synthetic_run name)
+    if (DEFINED HEADLESS_SYNTHETIC_RUN_LIST)
+        LIST(APPEND HEADLESS_SYNTHETIC_RUN_LIST ${name})
+        SET(HEADLESS_SYNTHETIC_RUN_LIST "${HEADLESS_SYNTHETIC_RUN_LIST}" PARENT_SCOPE)
+        SET(HEADLESS_RUN_DIR_${name} "${ARGN}" PARENT_SCOPE)
+    endif()
+endmacro()
@@ -0,0 +1,110 @@
+#ifndef __BENCH_SUITE_HPP__
+#define __BENCH_SUITE_HPP__
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+///
+/// \brief keeps the compiler from removing a computation whose result is not used
+///
+template<typename T>
+inline void doNotOptimize(const T& value) {
+#if defined(_MSC_VER)
+    static const volatile void* sink;
+    sink = &value;
+#else
+    asm volatile("" : : "r,m"(value) : "memory");
+#endif
+}
+
+///
+/// \brief Result of a benchmark, times per iteration in ns
+///
+struct BenchResult {
+    std::string name;
+    int64_t iterations = 0;     ///< iterations timed, over all the samples
+    int samples = 0;
+    double median = 0, min = 0, max = 0, mean = 0, stddev = 0;
+    double cpu_time = 0;        ///< process CPU time per iteration, more than median when the body runs threads
+    double items_per_second = 0, bytes_per_second = 0;
+};
+
+///
+/// \brief The BenchSuite class
+/// Small harness of the benchmarks of the samples, on synthetic inputs: each benchmark runs its body in batches long
+/// enough for the clock, the time of each batch is a sample. The results are printed as a table and written as JSON,
+/// in the layout of Google Benchmark (name, iterations, real_time, cpu_time, time_unit) for the regression tools.
+///     BenchSuite suite("ZED_Sample_Bench");
+///     suite.add("resize/HD720", [&]() { cv::resize(image, small, small.size()); }).items(1);
+///     return suite.run(argc, argv);
+/// Command line of the suites:
+///     --filter <text>    runs the benchmarks whose name contains the text
+///     --min-time <s>     time of each benchmark, 0.5 s by default
+///     --samples N        batches timed per benchmark, 10 by default
+///     --json <path>      writes the results, - for the standard output
+///     --list             prints the names of the benchmarks
+///
+class BenchSuite {
+public:
+    ///
+    /// \brief Benchmark registered in the suite, its throughput is set after add()
+    ///
+    class Bench {
+    public:
+        ///
+        /// \brief items (frames, objects, boxes, ...) processed by each iteration, reported per second
+        ///
+        Bench& items(double per_iteration) { items_per_iteration = per_iteration; return *this; }
+        Bench& bytes(double per_iteration) { bytes_per_iteration = per_iteration; return *this; }
+
+    private:
+        friend class BenchSuite;
+        std::string name;
+        std::function<void()> body;
+        double items_per_iteration = 0, bytes_per_iteration = 0;
+    };
+
+    explicit BenchSuite(const std::string& name);
+
+    ///
+    /// \brief registers a benchmark, body runs one iteration. The inputs are prepared before, outside of body
+    ///
+    Bench& add(const std::string& name, std::function<void()> body);
+    ///
+    /// \brief information on the run (kernel selected, library versions, ...) added to the context of the JSON
+    ///
+    void setContext(const std::string& key, const std::string& value);
+    ///
+    /// \brief checks a result of the code measured, before its benchmark: a wrong result fails the suite, the
+    /// timings of a wrong code are meaningless
+    ///
+    bool check(bool condition, const std::string& what);
+
+    ///
+    /// \brief runs the benchmarks selected by the command line
+    /// \return EXIT_SUCCESS, or EXIT_FAILURE if an option is invalid, a check failed or the JSON cannot be written
+    ///
+    int run(int argc, char** argv);
+    static const char* usage();
+
+    const std::vector<BenchResult>& results() const { return bench_results; }
+
+private:
+    BenchResult measure(Bench& bench);
+    bool writeJson(const std::string& path) const;
+
+    std::string suite_name, executable;
+    // deque: the references returned by add() stay valid
+    std::deque<Bench> benchs;
+    std::vector<std::pair<std::string, std::string>> context;
+    std::vector<BenchResult> bench_results;
+    double min_time = 0.5;
+    int nb_samples = 10;
+    int nb_failed_checks = 0;
+};
+
+#endif /* __BENCH_SUITE_HPP__ */
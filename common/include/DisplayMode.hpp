@@ -0,0 +1,73 @@
+#ifndef __DISPLAY_MODE_HPP__
+#define __DISPLAY_MODE_HPP__
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "ResultSink.hpp"
+
+///
+/// \brief The DisplayMode class
+/// Runtime choice of the display of a sample, taken from its command line:
+///  - WINDOW : the sample windows (OpenGL, cv::imshow) are rendered at each frame
+///  - PREVIEW (--preview N) : the windows are rendered every N frames only, the processing runs at full rate
+///  - HEADLESS (--headless, or ZED_SAMPLES_HEADLESS=1, or no display server) : no GL context, no window, the loop
+///    stops on Ctrl+C. The results go to the sink, if any.
+/// --sink file:<path> | shm:<name> sends the results of each frame to a sink (ResultSink.hpp), in any mode.
+///
+/// The loops of the samples become:
+///     while (display.nextFrame()) {
+///         if (display.renderFrame() && !viewer.isAvailable()) break;
+///         // grab and process
+///         if (display.renderFrame()) viewer.update(...);
+///         if (display.hasSink()) display.publish(timestamp, text);
+///     }
+///
+class DisplayMode {
+public:
+    enum class Mode {
+        WINDOW,
+        PREVIEW,
+        HEADLESS
+    };
+
+    ///
+    /// \brief reads and removes the display options from the command line, so that the samples parse the remaining
+    /// arguments as before. Prints the error and returns false if an option is invalid or the sink cannot be opened.
+    ///
+    bool parse(int& argc, char** argv);
+    static const char* usage();
+
+    Mode mode() const { return current_mode; }
+    bool headless() const { return current_mode == Mode::HEADLESS; }
+    const char* modeName() const;
+
+    ///
+    /// \brief starts the next frame of the loop, false once the sample is interrupted (Ctrl+C, headless only)
+    ///
+    bool nextFrame();
+    ///
+    /// \brief true if the windows are rendered at the current frame
+    ///
+    bool renderFrame() const { return current_mode == Mode::WINDOW || (current_mode == Mode::PREVIEW && frame % preview_period == 0); }
+    uint64_t frameCount() const { return frame; }
+
+    bool hasSink() const { return sink != nullptr; }
+    void setSink(std::unique_ptr<ResultSink> new_sink) { sink = std::move(new_sink); }
+    ///
+    /// \brief sends the result of the current frame to the sink
+    ///
+    bool publish(uint64_t timestamp, const std::string& text);
+    bool publish(FrameResult& result);
+
+private:
+    Mode current_mode = Mode::WINDOW;
+    int preview_period = 1;
+    // Index of the current frame, from 0
+    uint64_t frame = 0;
+    bool started = false;
+    std::unique_ptr<ResultSink> sink;
+};
+
+#endif /* __DISPLAY_MODE_HPP__ */
@@ -0,0 +1,209 @@
+#ifndef __FRAME_CONTAINER_HPP__
+#define __FRAME_CONTAINER_HPP__
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+///
+/// Raw frame container: LEFT images and DEPTH maps of a whole SVO stored in a single preallocated file.
+///
+/// Layout (all offsets are multiples of FRAME_CONTAINER_ALIGNMENT):
+///   [ContainerHeader][FrameIndexEntry x capacity][frame 0][frame 1]...[frame capacity-1]
+/// Every frame has the same stride: image bytes followed by depth bytes, so frame i is at data_offset + i * frame_stride.
+/// When a compression is used, the stride is the worst case compressed size and the actual sizes are stored in the index.
+/// The file is then sparse: a frame only takes the disk blocks of its compressed size.
+///
+#define FRAME_CONTAINER_MAGIC "ZEDFRAW"
+#define FRAME_CONTAINER_VERSION 1
+#define FRAME_CONTAINER_ALIGNMENT 4096
+
+enum class DEPTH_FORMAT : uint32_t {
+    F32 = 0, ///< float depth, in the SVO export unit (millimeters)
+    U16 = 1  ///< uint16 depth, value = depth / depth_unit. Invalid or out of range depth is stored as 0
+};
+
+enum class FRAME_COMPRESSION : uint32_t {
+    NONE = 0,
+    LZ4 = 1, ///< needs the sample to be built with LZ4
+    ZSTD = 2 ///< needs the sample to be built with Zstandard
+};
+
+#pragma pack(push, 1)
+struct ContainerHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t width;
+    uint32_t height;
+    uint32_t image_channels;    ///< 4 : BGRA 8 bits
+    DEPTH_FORMAT depth_format;
+    float depth_unit;           ///< U16 only: depth unit of one step
+    FRAME_COMPRESSION compression;
+    uint32_t reserved;
+    uint64_t capacity;          ///< number of frame slots
+    uint64_t nb_frames;         ///< number of written slots, updated on close
+    uint64_t frame_stride;      ///< bytes between two frames
+    uint64_t image_bytes;       ///< uncompressed image size
+    uint64_t depth_bytes;       ///< uncompressed depth size
+    uint64_t index_offset;
+    uint64_t data_offset;
+};
+
+struct FrameIndexEntry {
+    uint64_t timestamp;         ///< image timestamp, in nanoseconds. 0 if the slot was never written
+    uint32_t svo_position;
+    uint32_t image_size;        ///< stored (possibly compressed) size
+    uint32_t depth_size;        ///< stored (possibly compressed) size
+    uint32_t reserved;
+};
+#pragma pack(pop)
+
+///
+/// \brief Frame format of a container
+///
+struct ContainerParameters {
+    uint32_t width = 0, height = 0;
+    DEPTH_FORMAT depth_format = DEPTH_FORMAT::F32;
+    float depth_unit = 1.f;
+    FRAME_COMPRESSION compression = FRAME_COMPRESSION::NONE;
+};
+
+///
+/// \brief parse a container format string: "f32", "u16", "u16:<unit>", optionally followed by "-lz4" or "-zstd"
+/// e.g. "u16:0.5-lz4" stores half millimeters as uint16 and compresses each frame with LZ4
+/// \return false if the string is invalid or the compression is not available in this build
+///
+bool parseContainerFormat(const std::string& format, ContainerParameters& params);
+
+///
+/// \brief is the compression available in this build
+///
+bool isCompressionAvailable(FRAME_COMPRESSION compression);
+
+///
+/// \brief Read/write mapping of a whole file (mmap or MapViewOfFile)
+///
+class MappedFile {
+public:
+    MappedFile() {}
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ///
+    /// \brief create (or overwrite) a file of the given size and map it
+    /// \param preallocate : allocate all its blocks on disk now. Otherwise the file is sparse, the blocks are allocated
+    /// when the pages are written (a full disk then makes the writes through the mapping fail)
+    ///
+    bool create(const std::string& path, uint64_t size, bool preallocate = true);
+
+    ///
+    /// \brief map an existing file in read only mode
+    ///
+    bool open(const std::string& path);
+
+    ///
+    /// \brief unmap, and shrink the file to new_size if not 0 (writable mapping only)
+    ///
+    void close(uint64_t new_size = 0);
+
+    uint8_t* data() const { return ptr; }
+    uint64_t size() const { return length; }
+    bool isOpened() const { return ptr != nullptr; }
+
+private:
+    uint8_t* ptr = nullptr;
+    uint64_t length = 0;
+    bool writable = false;
+    std::string file_path;
+#ifdef _WIN32
+    void* file_handle = nullptr;
+    void* mapping_handle = nullptr;
+#else
+    int fd = -1;
+#endif
+};
+
+///
+/// \brief The FrameContainerWriter class
+/// The file is allocated once for capacity frames then filled through the mapping, no per frame allocation nor file creation.
+/// writeFrame() can be called concurrently for different slots (e.g. from several encoder threads or SVO segments).
+///
+class FrameContainerWriter {
+public:
+    ~FrameContainerWriter();
+
+    bool create(const std::string& path, const ContainerParameters& params, uint64_t capacity);
+
+    ///
+    /// \brief write a frame in its slot
+    /// \param slot : frame slot, usually the SVO position
+    /// \param image : BGRA 8 bits image, image_step bytes per row
+    /// \param depth : F32 depth map, depth_step bytes per row
+    /// \param scratch : per thread buffer, only used with a compression or U16 depth
+    ///
+    bool writeFrame(uint64_t slot, uint64_t timestamp, const uint8_t* image, size_t image_step,
+            const float* depth, size_t depth_step, std::vector<uint8_t>& scratch);
+
+    ///
+    /// \brief write the frame count in the header, flush and unmap. The file is shrunk to the last written slot
+    ///
+    void close();
+
+    const ContainerHeader& getHeader() const { return *header; }
+    uint64_t getNbWritten() const { return nb_written; }
+
+private:
+    MappedFile file;
+    ContainerHeader* header = nullptr;
+    FrameIndexEntry* index = nullptr;
+    std::atomic<uint64_t> nb_written{0};
+    std::atomic<uint64_t> last_slot{0};
+};
+
+///
+/// \brief The FrameContainerReader class
+/// Gives zero-copy access to uncompressed frames directly from the mapping.
+///
+class FrameContainerReader {
+public:
+    ///
+    /// \brief map the file and check its header and index. A truncated or corrupted file is refused
+    ///
+    bool open(const std::string& path);
+    void close();
+
+    const ContainerHeader& getHeader() const { return *header; }
+    uint64_t getNbFrames() const { return header ? header->nb_frames : 0; }
+    const FrameIndexEntry& getEntry(uint64_t i) const { return index[i]; }
+
+    ///
+    /// \brief pointer to the stored image and depth of frame i. For compressed containers, use decode()
+    ///
+    const uint8_t* image(uint64_t i) const { return frame(i); }
+    const void* depth(uint64_t i) const { return frame(i) + index[i].image_size; }
+
+    ///
+    /// \brief copy (and decompress if needed) frame i in user buffers of image_bytes and depth_bytes
+    ///
+    bool decode(uint64_t i, uint8_t* image_out, void* depth_out) const;
+
+    ///
+    /// \brief index of the first written frame with a timestamp >= ts (binary search), getNbFrames() if none
+    ///
+    uint64_t findTimestamp(uint64_t ts) const;
+
+private:
+    const uint8_t* frame(uint64_t i) const { return file.data() + header->data_offset + i * header->frame_stride; }
+    ///
+    /// \brief header and index consistent with the file size, so that no access to the frames leaves the mapping
+    ///
+    bool isValid() const;
+
+    MappedFile file;
+    const ContainerHeader* header = nullptr;
+    const FrameIndexEntry* index = nullptr;
+};
+
+#endif
@@ -0,0 +1,294 @@
+#ifndef __FRAME_SOURCE_HPP__
+#define __FRAME_SOURCE_HPP__
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "FrameContainer.hpp"
+
+///
+/// \brief Image of a frame bundle, rows of step bytes. The buffer is kept from frame to frame: a source of
+/// constant resolution does not allocate after its first frame
+///
+struct FrameImage {
+    int width = 0;
+    int height = 0;
+    int channels = 0;
+    int element_bytes = 0;      ///< bytes per channel: 1 (uint8) or 4 (float)
+    size_t step = 0;            ///< bytes per row
+    std::vector<uint8_t> data;
+
+    void allocate(int width, int height, int channels, int element_bytes);
+    void release();
+    bool empty() const { return data.empty(); }
+
+    template<typename T>
+    T* row(int y) { return reinterpret_cast<T*>(data.data() + static_cast<size_t>(y) * step); }
+    template<typename T>
+    const T* row(int y) const { return reinterpret_cast<const T*>(data.data() + static_cast<size_t>(y) * step); }
+};
+
+///
+/// \brief Camera pose in the world frame of the source, valid when the source tracks its position
+///
+struct FramePose {
+    bool valid = false;
+    float translation[3] = {0.f, 0.f, 0.f};
+    float orientation[4] = {0.f, 0.f, 0.f, 1.f};   ///< quaternion x, y, z, w
+};
+
+///
+/// \brief What a source yields at each frame
+///
+struct FrameBundle {
+    uint64_t index = 0;         ///< frames read from the source so far, from 0
+    uint64_t timestamp = 0;     ///< capture time, in ns
+    FrameImage image;           ///< LEFT image, BGRA 8 bits
+    FrameImage depth;           ///< depth map, float. Millimeters for the file and synthetic sources, the coordinate unit of the camera otherwise. Empty if the source has none
+    FramePose pose;
+};
+
+enum class FRAME_STATUS {
+    FRAME,      ///< a new frame was read
+    END,        ///< end of the file, or --frames reached
+    FAILED      ///< the source cannot give frames anymore
+};
+
+///
+/// \brief Kind of source, from the command line
+///
+enum class FRAME_SOURCE {
+    CAMERA,     ///< live ZED camera
+    SVO,        ///< SVO file
+    STREAM,     ///< ZED stream, from a sender sample
+    IMAGES,     ///< directory of images, e.g. left000000.png + depth000000.png from the SVO export (modes 2 to 4)
+    RAW,        ///< raw frame container from the SVO export (mode 5)
+    SYNTHETIC   ///< deterministic generated frames, no file nor device
+};
+
+///
+/// \brief The FrameSourceOptions class
+/// Input of a sample, the same command line for all the samples:
+///     --source camera[:<resolution>] | svo:<file.svo> | stream:<ip>[:<port>] | images:<directory> | raw:<file.zraw> | synthetic[:<width>x<height>]
+///     --frames N       ends the source after N frames
+///     --prefetch N     reads up to N frames ahead in a thread (PrefetchSource)
+///     --fps N          frame rate of the timestamps of the synthetic and image sources
+/// The input argument of the samples keeps working in place of --source: a SVO file, an IP with an optional port,
+/// or a camera resolution (HD2K, HD1080, HD720, VGA).
+///
+struct FrameSourceOptions {
+    FRAME_SOURCE kind = FRAME_SOURCE::CAMERA;
+    std::string path;           ///< SVO file, image directory or container
+    std::string ip;
+    int port = 0;               ///< 0: default port of the stream
+    std::string resolution;     ///< camera resolution, empty for the default of the sample
+    int width = 672, height = 376;  ///< synthetic frames
+    int fps = 30;               ///< frame rate of the timestamps of the synthetic and image sources
+    int64_t max_frames = -1;    ///< -1: no limit
+    int prefetch = 0;           ///< 0: frames read on demand
+
+    ///
+    /// \brief reads and removes the source options and the input argument of the sample (argv[1]) from the command
+    /// line, the sample parses the remaining arguments as before. Prints the error and returns false if an option
+    /// is invalid.
+    ///
+    bool parse(int& argc, char** argv);
+    ///
+    /// \brief reads an input argument of the samples: SVO file, IP[:port] or camera resolution
+    /// \return false if the argument is not an input (the sample may use it for something else)
+    ///
+    bool parseInput(const std::string& arg);
+    ///
+    /// \brief reads the value of --source, false if invalid
+    ///
+    bool parseSource(const std::string& spec);
+    static const char* usage();
+
+    ///
+    /// \brief true for the inputs opened by sl::Camera: live camera, SVO and stream
+    ///
+    bool usesCamera() const { return kind == FRAME_SOURCE::CAMERA || kind == FRAME_SOURCE::SVO || kind == FRAME_SOURCE::STREAM; }
+    std::string describe() const;
+};
+
+///
+/// \brief parses "a.b.c.d" or "a.b.c.d:port", each number in range. port is left unchanged without ":port"
+///
+bool parseIPv4(const std::string& text, std::string& ip, int& port);
+
+///
+/// \brief The FrameSource class
+/// Frames of any input, for the parts of the samples that only need images, depth and pose: detectors,
+/// trackers, exporters and viewers run the same on a camera, a file or generated frames, with or without GPU.
+///     auto source = FrameSource::create(options);
+///     FrameBundle frame;
+///     if (!source || !source->open()) return EXIT_FAILURE;
+///     while (source->read(frame) == FRAME_STATUS::FRAME) { ... }
+///
+class FrameSource {
+public:
+    virtual ~FrameSource() = default;
+
+    ///
+    /// \brief the source of the options, in a PrefetchSource if options.prefetch > 0. The camera sources need the
+    /// sample to be built with the ZED SDK (FRAME_SOURCE_ZED), the image directories with OpenCV (FRAME_SOURCE_OPENCV).
+    /// Prints the error and returns nullptr if the source is not available in this build.
+    ///
+    static std::unique_ptr<FrameSource> create(const FrameSourceOptions& options);
+
+    virtual bool open() = 0;
+    virtual void close() {}
+    ///
+    /// \brief the next frame, in the buffers of the bundle
+    ///
+    FRAME_STATUS read(FrameBundle& frame);
+    ///
+    /// \brief number of frames of a file source, -1 if unknown (camera, stream)
+    ///
+    virtual int64_t length() const { return -1; }
+    virtual std::string describe() const = 0;
+
+    void setMaxFrames(int64_t max) { max_frames = max; }
+    uint64_t framesRead() const { return nb_read; }
+
+protected:
+    virtual FRAME_STATUS readFrame(FrameBundle& frame) = 0;
+
+private:
+    int64_t max_frames = -1;
+    uint64_t nb_read = 0;
+};
+
+///
+/// \brief The SyntheticSource class
+/// Deterministic frames: the same index always gives the same bundle, on any host. A gradient with a square
+/// moving over it at 1 m in front of a wall at 2 m, the camera turning around the origin.
+///
+class SyntheticSource : public FrameSource {
+public:
+    SyntheticSource(int width, int height, int fps = 30);
+
+    bool open() override { return width > 0 && height > 0; }
+    std::string describe() const override;
+
+    ///
+    /// \brief position of the square in the image at a frame, for the checks of the pipelines
+    ///
+    void squareAt(uint64_t index, int& x, int& y, int& size) const;
+
+protected:
+    FRAME_STATUS readFrame(FrameBundle& frame) override;
+
+private:
+    int width, height, fps;
+    uint64_t next = 0;
+};
+
+///
+/// \brief The ImageSequenceSource class
+/// Sorted images of a directory: left*.png / left*.jpg of the SVO export, their depth*.png (16 bits, millimeters)
+/// when present, or else any *.png / *.jpg. No pose, the timestamps follow the fps of the options.
+/// Needs OpenCV (FRAME_SOURCE_OPENCV), open() fails otherwise.
+///
+class ImageSequenceSource : public FrameSource {
+public:
+    ImageSequenceSource(const std::string& directory, int fps = 30);
+
+    bool open() override;
+    int64_t length() const override { return static_cast<int64_t>(images.size()); }
+    std::string describe() const override;
+
+protected:
+    FRAME_STATUS readFrame(FrameBundle& frame) override;
+
+private:
+    std::string directory;
+    int fps;
+    std::vector<std::string> images, depths;
+    size_t next = 0;
+};
+
+///
+/// \brief The ContainerSource class
+/// Frames of a raw container of the SVO export, with their timestamps. The compressed containers need the
+/// sample to be built with the same compression (WITH_LZ4, WITH_ZSTD).
+///
+class ContainerSource : public FrameSource {
+public:
+    explicit ContainerSource(const std::string& path);
+
+    bool open() override;
+    void close() override { reader.close(); }
+    int64_t length() const override { return static_cast<int64_t>(reader.getNbFrames()); }
+    std::string describe() const override;
+
+protected:
+    FRAME_STATUS readFrame(FrameBundle& frame) override;
+
+private:
+    std::string path;
+    FrameContainerReader reader;
+    std::vector<uint8_t> depth_buffer;
+    uint64_t next = 0;
+};
+
+///
+/// \brief The PrefetchSource class
+/// Reads the frames of another source in a thread, up to depth frames ahead: the decoding of the files and the
+/// grab of the camera overlap the processing of the sample. The bundles are recycled, read() swaps their buffers
+/// with the ones of the caller, no copy nor allocation once the pool is full.
+/// A live source (drop_late) never waits for the sample: when the queue is full, the oldest frame is dropped so
+/// that read() gives the newest ones. A file source waits, no frame is lost.
+///
+class PrefetchSource : public FrameSource {
+public:
+    PrefetchSource(std::unique_ptr<FrameSource> source, int depth, bool drop_late);
+    ~PrefetchSource();
+
+    bool open() override;
+    void close() override;
+    int64_t length() const override { return source->length(); }
+    std::string describe() const override;
+
+    ///
+    /// \brief frames dropped because the sample was late, live sources only
+    ///
+    uint64_t droppedFrames() const;
+    FrameSource& inner() { return *source; }
+
+protected:
+    FRAME_STATUS readFrame(FrameBundle& frame) override;
+
+private:
+    void readerLoop();
+
+    std::unique_ptr<FrameSource> source;
+    size_t depth;
+    bool drop_late;
+    std::thread reader;
+    mutable std::mutex mtx;
+    std::condition_variable ready_cv, free_cv;
+    std::deque<std::unique_ptr<FrameBundle>> ready, free_bundles;
+    FRAME_STATUS last_status = FRAME_STATUS::FRAME;
+    bool stopping = false;
+    uint64_t nb_dropped = 0;
+};
+
+#if defined (__OPENCV_ALL_HPP__) || defined(OPENCV_ALL_HPP)
+///
+/// \brief cv::Mat on the buffer of a FrameImage, no copy: CV_8UC4 for the images, CV_32FC1 for the depth
+///
+inline cv::Mat toCvMat(FrameImage& image) {
+    if (image.empty()) return cv::Mat();
+    return cv::Mat(image.height, image.width, CV_MAKETYPE(image.element_bytes == 4 ? CV_32F : CV_8U, image.channels), image.data.data(), image.step);
+}
+#endif
+
+#endif /* __FRAME_SOURCE_HPP__ */
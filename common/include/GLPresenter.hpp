@@ -0,0 +1,133 @@
+#ifndef __GL_PRESENTER_HPP__
+#define __GL_PRESENTER_HPP__
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "ImageFormat.hpp"
+
+// Defined by the samples built with CUDA: frames in GPU memory are copied through the CUDA-OpenGL interoperability
+#ifdef GL_PRESENTER_CUDA
+#include <cuda_runtime.h>
+#include <cuda_gl_interop.h>
+#endif
+
+///
+/// \brief The GLPresenter class
+/// Uploads the frames of a sample to OpenGL textures for display, without blocking the draw.
+/// The frames go to a ring of slots, each with its own texture: the upload of frame N+1 fills a slot while
+/// the draw of frame N reads another one.
+///  - CUDA_INTEROP : frames in GPU memory, the textures are registered to CUDA. The copy is asynchronous on the
+///    stream of the caller, a CUDA event per slot tells when its texture can be drawn.
+///  - PERSISTENT_PBO : frames in host memory, copied into pixel buffers mapped once (GL 4.4 / ARB_buffer_storage),
+///    then to the texture by the GL driver. A fence per slot tells when its buffer can be written again.
+///  - MAPPED_PBO : same, the pixel buffers are mapped at each frame (older GL).
+///  - DIRECT : glTexSubImage2D from host memory, the driver copies the frame before returning.
+/// The channels are put in RGBA order as told by negotiateUpload (ImageFormat.hpp): the textures of BGRA frames are
+/// swizzled, the draws sample RGBA without a dedicated shader. Only the SHADER channel path, frames in GPU memory on a
+/// context without swizzle, leaves the swap to the draw: see format().
+/// The uploads, texture() and release() need the GL context current, except upload(device) which only calls CUDA.
+///
+class GLPresenter {
+public:
+    enum class Path {
+        NONE,
+        CUDA_INTEROP,
+        PERSISTENT_PBO,
+        MAPPED_PBO,
+        DIRECT
+    };
+
+    struct Stats {
+        uint64_t frames = 0;
+        // Uploads that had to wait for their slot: the display is slower than the frames
+        uint64_t stalls = 0;
+        // Time spent by the caller in the uploads
+        double upload_ms = 0.;
+    };
+
+    GLPresenter() {}
+    ~GLPresenter();
+    GLPresenter(const GLPresenter&) = delete;
+    GLPresenter& operator=(const GLPresenter&) = delete;
+
+    ///
+    /// \brief creates the textures and buffers of the slots. device_frames : the frames are in GPU memory
+    /// (CUDA_INTEROP, only with GL_PRESENTER_CUDA), otherwise the best host path of the GL context.
+    /// source : layout of the frames, the channel path is negotiated with the GL context.
+    ///
+    bool init(int width, int height, bool device_frames, PixelFormat source = PixelFormat::RGBA, int nb_slots = 3);
+    ///
+    /// \brief same with a given path, to compare them
+    ///
+    bool init(int width, int height, Path path, PixelFormat source = PixelFormat::RGBA, int nb_slots = 3);
+    ///
+    /// \brief same with a given path and channel path (makeUploadFormat)
+    ///
+    bool init(int width, int height, Path path, const UploadFormat& format, int nb_slots = 3);
+    void release();
+
+    ///
+    /// \brief copies a frame in host memory of width x height pixels, step_bytes between its rows.
+    /// The frame can be modified as soon as it returns. Converted on the way if the channel path is CPU_CONVERSION.
+    ///
+    bool uploadHost(const void* data, size_t step_bytes);
+#ifdef GL_PRESENTER_CUDA
+    ///
+    /// \brief copies a frame in GPU memory, after the work already queued on stream. Give the stream that writes
+    /// the frame (sl::Camera::getCUDAStream() for the retrieve functions): the next write waits for the copy,
+    /// not the host.
+    ///
+    bool uploadDevice(const void* data, size_t step_bytes, cudaStream_t stream = 0);
+#endif
+
+    ///
+    /// \brief texture of the latest frame ready to be drawn, 0 before the first upload
+    ///
+    GLuint texture();
+
+    Path path() const { return current_path; }
+    const char* pathName() const { return pathName(current_path); }
+    static const char* pathName(Path path);
+    // Best path of the current GL context for frames in host memory
+    static Path hostPath();
+
+    // Layout of the textures, how the channels of the frames are put in RGBA order
+    const UploadFormat& format() const { return upload_format; }
+
+    const Stats& stats() const { return statistics; }
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+
+private:
+    struct Slot {
+        GLuint texture = 0;
+        GLuint pbo = 0;
+        void* mapped = nullptr;
+        GLsync fence = nullptr;
+#ifdef GL_PRESENTER_CUDA
+        cudaGraphicsResource* resource = nullptr;
+        cudaEvent_t ready = nullptr;
+#endif
+        bool pending = false;
+    };
+
+    // Next slot to fill, after waiting for the previous use of its resources
+    Slot& acquireSlot();
+
+    std::vector<Slot> slots;
+    Path current_path = Path::NONE;
+    UploadFormat upload_format;
+    // Converted frame of the DIRECT path with CPU conversion
+    std::vector<unsigned char> staging;
+    int width = 0, height = 0;
+    int next_slot = 0;
+    // Latest uploaded slot, and latest slot known to be ready
+    int latest_slot = -1, front_slot = -1;
+    Stats statistics;
+};
+
+#endif /* __GL_PRESENTER_HPP__ */
@@ -0,0 +1,74 @@
+#ifndef __IMAGE_FORMAT_HPP__
+#define __IMAGE_FORMAT_HPP__
+
+#include <cstddef>
+
+#include <GL/glew.h>
+
+///
+/// \brief Layout of the pixels of the frames given to the display
+///
+enum class PixelFormat {
+    RGBA, // refocus output, XYZRGBA colors
+    BGRA, // sl::VIEW::LEFT / RIGHT (sl::MAT_TYPE::U8_C4)
+    GRAY  // sl::MAT_TYPE::U8_C1
+};
+
+///
+/// \brief How the channels of the frames reach the RGBA order of the texture sampling, from the cheapest
+///
+enum class ChannelPath {
+    NATIVE,         // already in order
+    SWIZZLE,        // the texture holds the bytes as they are, the sampler reorders them (GL_TEXTURE_SWIZZLE_RGBA)
+    UPLOAD_FORMAT,  // the driver reorders them in the copy to the texture (GL_BGRA)
+    CPU_CONVERSION, // converted on the CPU before the upload, when GL cannot read them
+    SHADER          // the texture holds the bytes as they are, the draw has to apply the swizzle
+};
+
+struct GLCapabilities {
+    // GL 3.3 or ARB/EXT_texture_swizzle
+    bool texture_swizzle = false;
+
+    // Capabilities of the current GL context
+    static GLCapabilities current();
+};
+
+struct UploadFormat {
+    PixelFormat source = PixelFormat::RGBA;
+    ChannelPath channels = ChannelPath::NATIVE;
+    GLint internal_format = GL_RGBA8;
+    // Format and bytes per pixel of the data given to glTexSubImage2D, after the conversion if any
+    GLenum format = GL_RGBA;
+    size_t pixel_bytes = 4;
+    // Texture channel read by the R, G, B and A of the sampling
+    GLint swizzle[4] = {GL_RED, GL_GREEN, GL_BLUE, GL_ALPHA};
+
+    bool swizzled() const;
+    // "BGRA, texture swizzle"
+    const char* name() const;
+};
+
+size_t pixelBytes(PixelFormat format);
+const char* pixelFormatName(PixelFormat format);
+const char* channelPathName(ChannelPath path);
+
+///
+/// \brief the format of the textures for a given channel path. Returns false when the path cannot give RGBA
+/// from the source (a GRAY texture in GL_BGRA format).
+///
+bool makeUploadFormat(PixelFormat source, ChannelPath channels, UploadFormat& format);
+
+///
+/// \brief cheapest channel path of the source on a context. device_frames : the frames are copied by CUDA,
+/// as they are: no upload format nor CPU conversion. The CPU conversion is only chosen when nothing else works
+/// (GRAY frames without swizzle), the shader only for frames in GPU memory without swizzle.
+///
+UploadFormat negotiateUpload(PixelFormat source, bool device_frames, const GLCapabilities& capabilities);
+
+///
+/// \brief copies height rows of width pixels in the layout of the uploads (tightly packed), converted if the
+/// channel path is CPU_CONVERSION. src_step : bytes between the source rows.
+///
+void convertRows(const UploadFormat& format, void* dst, const void* src, size_t src_step, int width, int height);
+
+#endif /* __IMAGE_FORMAT_HPP__ */
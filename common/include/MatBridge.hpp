@@ -0,0 +1,132 @@
+#ifndef __MAT_BRIDGE_HPP__
+#define __MAT_BRIDGE_HPP__
+
+#include <cstddef>
+
+#include <cuda_runtime.h>
+#include <sl/Camera.hpp>
+#include <opencv2/opencv.hpp>
+#include <opencv2/core/cuda.hpp>
+
+// MAT_TYPE::U16_C1 and S8_C4 came with the ZED SDK 3.5
+#if ZED_SDK_MAJOR_VERSION > 3 || (ZED_SDK_MAJOR_VERSION == 3 && ZED_SDK_MINOR_VERSION >= 5)
+#define MAT_BRIDGE_U16_S8 1
+#endif
+
+///
+/// \brief OpenCV type of a sl::MAT_TYPE, -1 if OpenCV has none. constexpr, usable in static_assert
+///
+constexpr int cvType(sl::MAT_TYPE type) {
+    return type == sl::MAT_TYPE::F32_C1 ? CV_32FC1 :
+           type == sl::MAT_TYPE::F32_C2 ? CV_32FC2 :
+           type == sl::MAT_TYPE::F32_C3 ? CV_32FC3 :
+           type == sl::MAT_TYPE::F32_C4 ? CV_32FC4 :
+           type == sl::MAT_TYPE::U8_C1 ? CV_8UC1 :
+           type == sl::MAT_TYPE::U8_C2 ? CV_8UC2 :
+           type == sl::MAT_TYPE::U8_C3 ? CV_8UC3 :
+           type == sl::MAT_TYPE::U8_C4 ? CV_8UC4 :
+#ifdef MAT_BRIDGE_U16_S8
+           type == sl::MAT_TYPE::U16_C1 ? CV_16UC1 :
+           type == sl::MAT_TYPE::S8_C4 ? CV_8SC4 :
+#endif
+           -1;
+}
+
+///
+/// \brief sl::MAT_TYPE of an OpenCV type, false if the ZED SDK has none (CV_64F, CV_32S, ...)
+///
+bool slType(int cv_type, sl::MAT_TYPE& type);
+
+///
+/// \brief sl::MAT_TYPE and OpenCV type of an element of sl::Mat::getPtr<T>(). Only defined for the element types of
+/// the ZED SDK: a typed view of another type does not compile.
+///
+template<typename T> struct MatElement;
+template<> struct MatElement<sl::float1> { static constexpr sl::MAT_TYPE type = sl::MAT_TYPE::F32_C1; };
+template<> struct MatElement<sl::float2> { static constexpr sl::MAT_TYPE type = sl::MAT_TYPE::F32_C2; };
+template<> struct MatElement<sl::float3> { static constexpr sl::MAT_TYPE type = sl::MAT_TYPE::F32_C3; };
+template<> struct MatElement<sl::float4> { static constexpr sl::MAT_TYPE type = sl::MAT_TYPE::F32_C4; };
+template<> struct MatElement<sl::uchar1> { static constexpr sl::MAT_TYPE type = sl::MAT_TYPE::U8_C1; };
+template<> struct MatElement<sl::uchar2> { static constexpr sl::MAT_TYPE type = sl::MAT_TYPE::U8_C2; };
+template<> struct MatElement<sl::uchar3> { static constexpr sl::MAT_TYPE type = sl::MAT_TYPE::U8_C3; };
+template<> struct MatElement<sl::uchar4> { static constexpr sl::MAT_TYPE type = sl::MAT_TYPE::U8_C4; };
+#ifdef MAT_BRIDGE_U16_S8
+template<> struct MatElement<sl::ushort1> { static constexpr sl::MAT_TYPE type = sl::MAT_TYPE::U16_C1; };
+template<> struct MatElement<sl::char4> { static constexpr sl::MAT_TYPE type = sl::MAT_TYPE::S8_C4; };
+#endif
+
+///
+/// \brief cv::Mat on the memory of a sl::Mat, no copy: the view is valid while the sl::Mat keeps its buffer.
+/// The type and the step (sl::Mat::getStepBytes, the GPU buffers are pitched) come from the sl::Mat.
+/// Empty if the sl::Mat is not allocated in host memory or its type has no OpenCV equivalent.
+///
+cv::Mat toCvMat(sl::Mat& input);
+
+///
+/// \brief toCvMat() of an element type known at compile time, empty if the sl::Mat holds another type
+///
+template<typename T>
+cv::Mat toCvMat(sl::Mat& input) {
+    static_assert(sizeof(T) == CV_ELEM_SIZE(cvType(MatElement<T>::type)), "sl and cv elements of different size");
+    return input.getDataType() == MatElement<T>::type ? toCvMat(input) : cv::Mat();
+}
+
+///
+/// \brief cv::cuda::GpuMat on the GPU memory of a sl::Mat, no copy. Empty if the sl::Mat is not allocated in GPU
+/// memory or its type has no OpenCV equivalent.
+///
+cv::cuda::GpuMat toGpuMat(sl::Mat& input);
+
+///
+/// \brief sl::Mat on the memory of a cv::Mat (MEM::CPU) or of a cv::cuda::GpuMat (MEM::GPU), no copy: the ZED SDK
+/// retrieves the images directly in the buffers of the application, ROIs included. Not initialized if the
+/// type has no ZED SDK equivalent.
+///
+sl::Mat toSlMat(const cv::Mat& input);
+sl::Mat toSlMat(const cv::cuda::GpuMat& input);
+
+///
+/// \brief The PinnedStaging class
+/// Page-locked host buffer where the sl::Mat in GPU memory are downloaded asynchronously, on the CUDA stream
+/// of the camera: the host keeps working during the copy, then reads the frame from the buffer once ready().
+/// The buffer is only reallocated when a larger frame comes, the downloads of a stream do not allocate.
+///
+class PinnedStaging {
+public:
+    PinnedStaging() = default;
+    ~PinnedStaging();
+    PinnedStaging(const PinnedStaging&) = delete;
+    PinnedStaging& operator=(const PinnedStaging&) = delete;
+
+    ///
+    /// \brief queues the copy of a sl::Mat in GPU memory on the stream, the rows are packed in the buffer.
+    /// The previous content of the buffer must not be used anymore. False if the sl::Mat is not in GPU memory,
+    /// or the copy cannot be queued.
+    ///
+    bool download(sl::Mat& input, cudaStream_t stream = 0);
+    ///
+    /// \brief true once the last download is done, without waiting
+    ///
+    bool ready() const;
+    ///
+    /// \brief waits for the last download, false if it failed
+    ///
+    bool wait();
+
+    ///
+    /// \brief the frame of the last download, in the buffer. Valid after ready() or wait(), until the next download
+    ///
+    cv::Mat cvView() const;
+    sl::Mat slView() const;
+
+    size_t capacity() const { return buffer_size; }
+
+private:
+    void* buffer = nullptr;
+    size_t buffer_size = 0;
+    cudaEvent_t done = nullptr;
+    int width = 0, height = 0, type = -1;
+    size_t step = 0;
+};
+
+#endif /* __MAT_BRIDGE_HPP__ */
@@ -0,0 +1,96 @@
+#ifndef __RESULT_SINK_HPP__
+#define __RESULT_SINK_HPP__
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "SharedFrameRing.hpp"
+
+///
+/// \brief Result of a frame of a sample, for the processes using it without display
+///
+struct FrameResult {
+    uint64_t frame = 0;
+    uint64_t timestamp = 0;         ///< capture time of the frame, in ns
+    std::string text;               ///< one line, the sample specific result (detected objects, pose, ...)
+    // Optional image of the result, in host memory
+    const void* image = nullptr;
+    int width = 0;
+    int height = 0;
+    int channels = 0;               ///< bytes per pixel
+    size_t step = 0;                ///< bytes per row
+};
+
+///
+/// \brief The ResultSink class
+/// Where the samples running headless send their results, instead of the windows
+///
+class ResultSink {
+public:
+    virtual ~ResultSink() {}
+    virtual bool write(const FrameResult& result) = 0;
+
+    ///
+    /// \brief creates the sink of a specification: "file:<path>" (text lines, "file:-" for the standard output)
+    /// or "shm:<name>" (SharedFrameRing). nullptr if the specification is invalid or the sink cannot be opened
+    ///
+    static std::unique_ptr<ResultSink> create(const std::string& spec);
+};
+
+///
+/// \brief "<frame> <timestamp> <text>" lines in a file, the images are ignored
+///
+class FileSink : public ResultSink {
+public:
+    ~FileSink();
+    bool open(const std::string& path);
+    bool write(const FrameResult& result) override;
+
+private:
+    FILE* file = nullptr;
+    bool owner = false;
+};
+
+///
+/// \brief Results in a SharedFrameRing, read in place by the processes of the same host.
+/// A frame of the ring holds the image rows (info.step bytes each) followed by the text, info.reserved is the size of
+/// the text. The ring is created at the first result, its slots sized for this image and TEXT_CAPACITY bytes of text.
+///
+class SharedMemorySink : public ResultSink {
+public:
+    static const size_t TEXT_CAPACITY = 4096;
+
+    explicit SharedMemorySink(const std::string& name, int nb_slots = 4) : name(name), nb_slots(nb_slots) {}
+    bool write(const FrameResult& result) override;
+
+    ///
+    /// \brief text of a frame read from the ring
+    ///
+    static std::string text(const SharedFrameView& view);
+
+private:
+    std::string name;
+    int nb_slots;
+    SharedFrameRing ring;
+};
+
+///
+/// \brief Results given to a function of the application, in the thread of the sample
+///
+class CallbackSink : public ResultSink {
+public:
+    explicit CallbackSink(std::function<void(const FrameResult&)> callback) : callback(std::move(callback)) {}
+    bool write(const FrameResult& result) override {
+        callback(result);
+        return true;
+    }
+
+private:
+    std::function<void(const FrameResult&)> callback;
+};
+
+#endif /* __RESULT_SINK_HPP__ */
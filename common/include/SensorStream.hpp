@@ -0,0 +1,174 @@
+#ifndef __SENSOR_STREAM_HPP__
+#define __SENSOR_STREAM_HPP__
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <sl/Camera.hpp>
+
+// Basic structure to compare timestamps of a sensor. Determines if a specific sensor data has been updated or not.
+struct TimestampHandler {
+
+    // Compare the new timestamp to the last valid one. If it is higher, save it as new reference.
+    inline bool isNew(sl::Timestamp& ts_curr, sl::Timestamp& ts_ref) {
+        bool new_ = ts_curr > ts_ref;
+        if (new_) ts_ref = ts_curr;
+        return new_;
+    }
+    // Specific function for IMUData.
+    inline bool isNew(sl::SensorsData::IMUData& imu_data) {
+        return isNew(imu_data.timestamp, ts_imu);
+    }
+    // Specific function for MagnetometerData.
+    inline bool isNew(sl::SensorsData::MagnetometerData& mag_data) {
+        return isNew(mag_data.timestamp, ts_mag);
+    }
+    // Specific function for BarometerData.
+    inline bool isNew(sl::SensorsData::BarometerData& baro_data) {
+        return isNew(baro_data.timestamp, ts_baro);
+    }
+
+    sl::Timestamp ts_imu = 0, ts_baro = 0, ts_mag = 0; // Initial values
+};
+
+///
+/// \brief Where the SensorStream reads the sensors from, a camera or a mock
+///
+class SensorSource {
+public:
+    virtual ~SensorSource() {}
+    ///
+    /// \brief latest sensors data, as sl::Camera::getSensorsData(data, TIME_REFERENCE::CURRENT)
+    ///
+    virtual sl::ERROR_CODE getSensorsData(sl::SensorsData& data) = 0;
+    ///
+    /// \brief IMU sampling rate in Hz, from the SensorParameters of the camera
+    ///
+    virtual float getImuRate() = 0;
+};
+
+///
+/// \brief Sensors of an opened camera
+///
+class CameraSensorSource : public SensorSource {
+public:
+    CameraSensorSource(sl::Camera& zed_) : zed(zed_) {}
+    sl::ERROR_CODE getSensorsData(sl::SensorsData& data) override {
+        return zed.getSensorsData(data, sl::TIME_REFERENCE::CURRENT);
+    }
+    float getImuRate() override {
+        return zed.getCameraInformation().sensors_configuration.accelerometer_parameters.sampling_rate;
+    }
+
+private:
+    sl::Camera& zed;
+};
+
+///
+/// \brief Synthetic IMU at a fixed rate, without camera. Like the camera, it only gives the latest sample
+///
+class MockSensorSource : public SensorSource {
+public:
+    MockSensorSource(float rate_ = 400.f) : rate(rate_), start(std::chrono::steady_clock::now()) {}
+    sl::ERROR_CODE getSensorsData(sl::SensorsData& data) override;
+    float getImuRate() override { return rate; }
+
+private:
+    float rate;
+    std::chrono::steady_clock::time_point start;
+};
+
+///
+/// \brief One new IMU sample, with the data of the other sensors at that time
+///
+struct SensorSample {
+    sl::SensorsData data;
+    bool new_magnetometer = false;  ///< data.magnetometer was updated since the previous sample
+    bool new_barometer = false;     ///< data.barometer was updated since the previous sample
+};
+
+///
+/// \brief Counters of a SensorStream
+///
+struct SensorStreamStats {
+    uint64_t nb_polls = 0;          ///< calls to getSensorsData
+    uint64_t nb_samples = 0;        ///< new IMU samples delivered
+    uint64_t nb_duplicates = 0;     ///< polls which returned an already delivered sample
+    uint64_t nb_missed = 0;         ///< samples never seen, estimated from the gaps between timestamps
+    uint64_t nb_dropped = 0;        ///< samples removed from the queue because nobody read them in time
+};
+
+///
+/// \brief The SensorStream class
+/// Reads a SensorSource from its own thread, sleeping between two IMU samples instead of spinning: after a new sample,
+/// it sleeps most of the sampling period given by the SensorParameters, then polls finely until the next one.
+/// The duplicates are filtered with a TimestampHandler. The new samples are given to the subscribers (called from the
+/// stream thread, they must be quick) and stored in a bounded queue read with pop().
+/// The callbacks are called without the lock of the stream: they may call getStats(), subscribe() and unsubscribe().
+///
+class SensorStream {
+public:
+    typedef std::function<void(const SensorSample&)> Callback;
+
+    ///
+    /// \param queue_size : samples kept for pop(), the oldest are dropped when it is full. 0 disables the queue
+    ///
+    SensorStream(SensorSource& source, size_t queue_size = 256);
+    ~SensorStream();
+
+    ///
+    /// \return an id for unsubscribe()
+    ///
+    int subscribe(Callback callback);
+    ///
+    /// \brief the callback is not called anymore once unsubscribe() returns. From another thread, it waits for the
+    /// callbacks being called to return. From a callback, it returns at once
+    ///
+    void unsubscribe(int id);
+
+    void start();
+    void stop();
+
+    ///
+    /// \brief wait for the next sample of the queue
+    /// \return false after timeout_ms, or if the stream is stopped
+    ///
+    bool pop(SensorSample& sample, int timeout_ms);
+
+    SensorStreamStats getStats();
+
+private:
+    void run();
+    void deliver(const SensorSample& sample);
+
+    SensorSource& source;
+    size_t queue_size;
+
+    std::thread worker;
+    std::atomic<bool> running{false};
+
+    std::mutex mtx;
+    std::condition_variable queue_cv;
+    std::deque<SensorSample> queue;
+    std::map<int, Callback> subscribers;
+    int next_id = 0;
+    SensorStreamStats stats;
+    std::thread::id stream_thread;
+
+    // Held by the stream thread while it calls the callbacks, unsubscribe() waits on it
+    std::mutex callback_mtx;
+    // Copy of the subscribers called by the stream thread, updated when the generation changes
+    std::vector<std::pair<int, Callback>> callbacks;
+    uint64_t generation = 0, callbacks_generation = 0;
+};
+
+#endif
@@ -0,0 +1,110 @@
+#ifndef __SHARED_FRAME_RING_HPP__
+#define __SHARED_FRAME_RING_HPP__
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+///
+/// \brief Description of a frame of the ring
+///
+struct SharedFrameInfo {
+    uint64_t timestamp = 0;     ///< sender capture time, in ns
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t step = 0;          ///< bytes per row
+    uint32_t channels = 0;
+    uint32_t size = 0;          ///< bytes of data
+    uint32_t reserved = 0;
+};
+
+///
+/// \brief A frame read in place from the ring, valid until the writer reuses its slot (see SharedFrameRing::isValid)
+///
+struct SharedFrameView {
+    uint64_t seq = 0;
+    SharedFrameInfo info;
+    const uint8_t* data = nullptr;
+};
+
+///
+/// \brief The SharedFrameRing class
+/// Ring of decoded frames in shared memory, written by one process (the relay) and read by any number of processes
+/// on the same host, without copy nor decoding. The writer never waits for the readers: each slot is protected by
+/// a sequence number (seqlock), a reader gets the newest frame and checks after use that its slot was not rewritten
+/// meanwhile. With N slots at 30FPS, a reader has (N - 1) / 30 s to use a frame in place.
+/// On Linux, readers sleep on a futex until the next frame, elsewhere they poll every millisecond.
+///
+class SharedFrameRing {
+public:
+    SharedFrameRing() = default;
+    ~SharedFrameRing();
+    SharedFrameRing(const SharedFrameRing&) = delete;
+    SharedFrameRing& operator=(const SharedFrameRing&) = delete;
+
+    ///
+    /// \brief writer side, creates (or replaces) the shared memory
+    /// \param name : name of the shared memory, without '/'
+    /// \param slot_size : maximum size of a frame, in bytes
+    ///
+    bool create(const std::string& name, int nb_slots, size_t slot_size);
+
+    ///
+    /// \brief reader side, maps an existing ring
+    ///
+    bool open(const std::string& name);
+
+    void close();
+
+    ///
+    /// \brief writer side, copies the frame in the next slot and wakes up the readers
+    /// \return the sequence number of the frame, 0 if it does not fit in a slot
+    ///
+    uint64_t write(const void* data, const SharedFrameInfo& info);
+    ///
+    /// \brief writer side, fill writes the info.size bytes of the frame directly in the slot, instead of a copy from a buffer
+    ///
+    uint64_t write(const SharedFrameInfo& info, const std::function<void(uint8_t*)>& fill);
+
+    ///
+    /// \brief reader side, the newest frame if newer than last_seq, waits up to timeout_ms for it
+    /// \param last_seq : sequence of the last frame read by this reader, updated
+    /// \param nb_skipped : incremented by the number of frames this reader missed
+    ///
+    bool acquire(uint64_t& last_seq, SharedFrameView& view, int timeout_ms, uint64_t* nb_skipped = nullptr);
+
+    ///
+    /// \brief reader side, true if the slot of the view was not rewritten since acquire()
+    /// To be called after using the data: if false, the data may be torn and has to be dropped
+    ///
+    bool isValid(const SharedFrameView& view) const;
+
+    ///
+    /// \brief reader side, acquire() then copy, the copy is always consistent
+    ///
+    bool read(uint64_t& last_seq, std::vector<uint8_t>& data, SharedFrameInfo& info, int timeout_ms, uint64_t* nb_skipped = nullptr);
+
+    uint64_t getSequence() const;
+    int getNbSlots() const;
+    size_t getSlotSize() const;
+
+private:
+    struct Header;
+    struct Slot;
+    Slot* slot(uint64_t seq) const;
+    bool map(const std::string& name, size_t size, bool create);
+
+    std::string shm_name;
+    bool owner = false;
+    void* memory = nullptr;
+    size_t memory_size = 0;
+    Header* header = nullptr;
+    size_t slot_stride = 0;
+#ifdef _WIN32
+    void* mapping = nullptr;
+#endif
+};
+
+#endif
@@ -0,0 +1,127 @@
+#ifndef __STAGE_TRACE_HPP__
+#define __STAGE_TRACE_HPP__
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+///
+/// \brief Latency of a stage over the spans recorded, in ns. The percentiles come from a log-linear histogram,
+/// within 3% of the exact values
+///
+struct StageStats {
+    std::string name;
+    uint64_t count = 0;
+    double mean = 0;
+    uint64_t min = 0, p50 = 0, p95 = 0, p99 = 0, max = 0;
+};
+
+///
+/// \brief The StageTrace class
+/// Where the time of a frame goes: the stages of the loops of the samples (grab, retrieveImage, inference, viewer
+/// update, ...) are timed by StageSpan scopes. Each thread records its spans in its own ring and histograms, no lock
+/// nor allocation once the thread has recorded each of its stages. Nothing is recorded unless the tracing is enabled
+/// from the command line:
+///     --trace <file.json>   Chrome trace of the spans (chrome://tracing, ui.perfetto.dev), with the statistics
+///     --trace-stats         count, mean, p50, p95, p99 and max of each stage, printed at the end of the sample
+/// The loops of the samples become:
+///     StageTrace trace;
+///     if (!trace.parse(argc, argv)) return EXIT_FAILURE;
+///     while (...) {
+///         STAGE_SPAN("grab");
+///         zed.grab();
+///         ...
+///     }
+///     trace.finish();
+/// The trace keeps the last TRACE_CAPACITY spans of each thread, the statistics count all of them.
+///
+class StageTrace {
+public:
+    static const size_t TRACE_CAPACITY = 1 << 16;
+
+    ~StageTrace() { finish(); }
+
+    ///
+    /// \brief reads and removes the trace options from the command line and starts the recording if any is given.
+    /// Prints the error and returns false if an option is invalid.
+    ///
+    bool parse(int& argc, char** argv);
+    static const char* usage();
+    ///
+    /// \brief stops the recording, writes the trace and prints the statistics asked on the command line. Call it once
+    /// the loop is over, after the threads that record spans are stopped
+    ///
+    void finish();
+
+    static bool enabled() { return recording.load(std::memory_order_relaxed); }
+    ///
+    /// \brief starts / stops the recording, without the command line. start() also sets the origin of the trace
+    ///
+    static void start();
+    static void stop();
+    ///
+    /// \brief forgets the spans and statistics recorded so far
+    ///
+    static void clear();
+
+    static uint64_t now() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+    ///
+    /// \brief records a span of the calling thread. stage must be a static string (a literal): only its address is kept
+    ///
+    static void record(const char* stage, uint64_t start_ns, uint64_t end_ns);
+    ///
+    /// \brief name of the calling thread in the trace. Does nothing when the tracing is disabled
+    ///
+    static void nameThread(const std::string& name);
+
+    ///
+    /// \brief statistics of each stage, all threads merged, in the order of their first span
+    ///
+    static std::vector<StageStats> stats();
+    static std::string formatStats();
+    static bool writeChromeTrace(const std::string& path, const std::string& process_name = "ZED sample");
+
+private:
+    static std::atomic<bool> recording;
+
+    std::string trace_path, process_name;
+    bool print_stats = false;
+    bool started = false;
+};
+
+///
+/// \brief The StageSpan class
+/// Times its scope as a span of a stage, or until end(). Costs a relaxed load when the tracing is disabled.
+///
+class StageSpan {
+public:
+    explicit StageSpan(const char* stage) : stage(stage), start(StageTrace::enabled() ? StageTrace::now() : 0) {}
+    ~StageSpan() { end(); }
+
+    StageSpan(const StageSpan&) = delete;
+    StageSpan& operator=(const StageSpan&) = delete;
+
+    void end() {
+        if (start) {
+            StageTrace::record(stage, start, StageTrace::now());
+            start = 0;
+        }
+    }
+
+private:
+    const char* stage;
+    uint64_t start;
+};
+
+#define STAGE_SPAN_CONCAT_(a, b) a##b
+#define STAGE_SPAN_CONCAT(a, b) STAGE_SPAN_CONCAT_(a, b)
+///
+/// \brief times the rest of the enclosing scope as a span of stage
+///
+#define STAGE_SPAN(stage) StageSpan STAGE_SPAN_CONCAT(stage_span_, __LINE__)(stage)
+
+#endif /* __STAGE_TRACE_HPP__ */
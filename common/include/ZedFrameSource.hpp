@@ -0,0 +1,60 @@
+#ifndef __ZED_FRAME_SOURCE_HPP__
+#define __ZED_FRAME_SOURCE_HPP__
+
+#include <sl/Camera.hpp>
+
+#include "FrameSource.hpp"
+
+///
+/// \brief sets the input (camera resolution, SVO file or stream) of the InitParameters from the options, in place
+/// of the parseArgs of the samples grabbing the camera themselves. Prints the error and returns false if the options are
+/// not an input of sl::Camera, or if they set --frames, --prefetch or --fps, only used by the FrameSource readers.
+///
+bool applyFrameSource(const FrameSourceOptions& options, sl::InitParameters& init_parameters);
+
+///
+/// \brief The ZedFrameSource class
+/// Live camera, SVO file or stream through sl::Camera: LEFT image, DEPTH when the depth mode is not NONE,
+/// and the pose in the world frame when the positional tracking is enabled.
+/// In a PrefetchSource, the camera is grabbed by the thread of the prefetch: the sample must not use camera()
+/// while the source is opened.
+///
+class ZedFrameSource : public FrameSource {
+public:
+    ///
+    /// \param init_parameters : parameters of the sample, the input is replaced by the one of the options
+    ///
+    explicit ZedFrameSource(const FrameSourceOptions& options, const sl::InitParameters& init_parameters = sl::InitParameters());
+    ~ZedFrameSource();
+
+    ///
+    /// \brief enables the positional tracking at open(), the bundles then have a pose
+    ///
+    void setTracking(bool enable) { tracking = enable; }
+    ///
+    /// \brief retrieves the DEPTH in the bundles (default), the depth mode being not NONE. Disabled when the sample
+    /// uses the depth through the SDK only (objects, point cloud), to save its copy at each frame
+    ///
+    void setDepth(bool enable) { depth = enable; }
+
+    bool open() override;
+    void close() override;
+    int64_t length() const override;
+    std::string describe() const override { return options.describe(); }
+
+    sl::Camera& camera() { return zed; }
+
+protected:
+    FRAME_STATUS readFrame(FrameBundle& frame) override;
+
+private:
+    FrameSourceOptions options;
+    sl::InitParameters init_parameters;
+    // getSVONumberOfFrames() is not const
+    mutable sl::Camera zed;
+    sl::Pose pose;
+    bool tracking = false;
+    bool depth = true;
+};
+
+#endif /* __ZED_FRAME_SOURCE_HPP__ */
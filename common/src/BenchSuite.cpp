@@ -0,0 +1,278 @@
+#include "BenchSuite.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+// Longest batch: a benchmark of a few ns runs at most this many iterations between two clock reads
+const int64_t MAX_BATCH = 1000000000;
+
+double elapsedNs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+}
+
+std::string hostName() {
+#if defined(_WIN32)
+    char name[MAX_COMPUTERNAME_LENGTH + 1];
+    DWORD size = sizeof(name);
+    return GetComputerNameA(name, &size) ? name : "";
+#else
+    char name[256] = {0};
+    return gethostname(name, sizeof(name) - 1) == 0 ? name : "";
+#endif
+}
+
+std::string compiler() {
+#if defined(_MSC_VER)
+    return "MSVC " + std::to_string(_MSC_VER);
+#elif defined(__clang__)
+    return "clang " __clang_version__;
+#elif defined(__GNUC__)
+    return "gcc " __VERSION__;
+#else
+    return "unknown";
+#endif
+}
+
+std::string jsonString(const std::string& text) {
+    std::string out = "\"";
+    for (char c : text) {
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    char code[8];
+                    snprintf(code, sizeof(code), "\\u%04x", c);
+                    out += code;
+                } else
+                    out += c;
+        }
+    }
+    return out + "\"";
+}
+
+// Time with its unit, for the table
+std::string formatTime(double ns) {
+    char text[32];
+    if (ns < 1e3) snprintf(text, sizeof(text), "%.1f ns", ns);
+    else if (ns < 1e6) snprintf(text, sizeof(text), "%.2f us", ns / 1e3);
+    else if (ns < 1e9) snprintf(text, sizeof(text), "%.2f ms", ns / 1e6);
+    else snprintf(text, sizeof(text), "%.2f s", ns / 1e9);
+    return text;
+}
+
+std::string formatRate(double per_second, const char* unit) {
+    char text[32];
+    if (per_second >= 1e9) snprintf(text, sizeof(text), "%.2fG%s/s", per_second / 1e9, unit);
+    else if (per_second >= 1e6) snprintf(text, sizeof(text), "%.2fM%s/s", per_second / 1e6, unit);
+    else if (per_second >= 1e3) snprintf(text, sizeof(text), "%.2fk%s/s", per_second / 1e3, unit);
+    else snprintf(text, sizeof(text), "%.1f%s/s", per_second, unit);
+    return text;
+}
+}
+
+BenchSuite::BenchSuite(const std::string& name) : suite_name(name) {
+}
+
+BenchSuite::Bench& BenchSuite::add(const std::string& name, std::function<void()> body) {
+    benchs.emplace_back();
+    benchs.back().name = name;
+    benchs.back().body = std::move(body);
+    return benchs.back();
+}
+
+void BenchSuite::setContext(const std::string& key, const std::string& value) {
+    context.emplace_back(key, value);
+}
+
+bool BenchSuite::check(bool condition, const std::string& what) {
+    if (!condition) {
+        std::cout << "[Sample][Error] " << suite_name << ": " << what << std::endl;
+        nb_failed_checks++;
+    }
+    return condition;
+}
+
+const char* BenchSuite::usage() {
+    return "[--filter <text>] [--min-time <seconds>] [--samples N] [--json <path> | -] [--list]";
+}
+
+int BenchSuite::run(int argc, char** argv) {
+    std::string filter, json_path;
+    bool list = false;
+    executable = argc > 0 ? argv[0] : suite_name;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--filter" && has_value) filter = argv[++i];
+        else if (arg == "--min-time" && has_value) min_time = atof(argv[++i]);
+        else if (arg == "--samples" && has_value) nb_samples = atoi(argv[++i]);
+        else if (arg == "--json" && has_value) json_path = argv[++i];
+        else if (arg == "--list") list = true;
+        else {
+            std::cout << "Usage : ./" << suite_name << " " << usage() << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+    if (min_time <= 0 || nb_samples < 1) {
+        std::cout << "[Sample][Error] --min-time and --samples must be positive" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    if (list) {
+        for (auto& bench : benchs)
+            if (bench.name.find(filter) != std::string::npos) std::cout << bench.name << std::endl;
+        return EXIT_SUCCESS;
+    }
+    if (nb_failed_checks) {
+        std::cout << "[Sample][Error] " << nb_failed_checks << " check(s) failed, no benchmark run" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // The table goes to stderr when the JSON is written to stdout
+    std::ostream& table = json_path == "-" ? std::cerr : std::cout;
+    size_t name_width = 10;
+    for (auto& bench : benchs) name_width = std::max(name_width, bench.name.size());
+    char line[256];
+    snprintf(line, sizeof(line), "%-*s %12s %12s %12s %12s %12s", static_cast<int>(name_width), suite_name.c_str(), "median", "min", "max", "iterations", "throughput");
+    table << line << std::endl;
+
+    bench_results.clear();
+    for (auto& bench : benchs) {
+        if (bench.name.find(filter) == std::string::npos) continue;
+        auto result = measure(bench);
+        std::string throughput = result.items_per_second > 0 ? formatRate(result.items_per_second, "")
+                : result.bytes_per_second > 0 ? formatRate(result.bytes_per_second, "B") : "";
+        snprintf(line, sizeof(line), "%-*s %12s %12s %12s %12lld %12s", static_cast<int>(name_width), result.name.c_str(),
+                formatTime(result.median).c_str(), formatTime(result.min).c_str(), formatTime(result.max).c_str(),
+                static_cast<long long>(result.iterations), throughput.c_str());
+        table << line << std::endl;
+        bench_results.push_back(result);
+    }
+
+    if (!json_path.empty() && !writeJson(json_path)) {
+        std::cout << "[Sample][Error] Cannot write " << json_path << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+BenchResult BenchSuite::measure(Bench& bench) {
+    BenchResult result;
+    result.name = bench.name;
+
+    // Batch long enough for the clock: the samples of the benchmark share min_time
+    const double target = min_time * 1e9 / nb_samples;
+    int64_t batch = 1;
+    for (;;) {
+        auto start = std::chrono::steady_clock::now();
+        for (int64_t i = 0; i < batch; i++) bench.body();
+        double elapsed = elapsedNs(start);
+        if (elapsed >= target || batch >= MAX_BATCH) break;
+        // Towards the target, at most 10x per step in case the first runs were slow (cold caches, allocations)
+        double factor = elapsed > 0 ? target / elapsed * 1.2 : 10.;
+        batch = std::min(MAX_BATCH, static_cast<int64_t>(std::ceil(batch * std::min(10., std::max(1.5, factor)))));
+    }
+
+    std::vector<double> times(nb_samples);
+    std::clock_t cpu_start = std::clock();
+    for (auto& time : times) {
+        auto start = std::chrono::steady_clock::now();
+        for (int64_t i = 0; i < batch; i++) bench.body();
+        time = elapsedNs(start) / batch;
+    }
+    double cpu_ns = static_cast<double>(std::clock() - cpu_start) * 1e9 / CLOCKS_PER_SEC;
+
+    result.samples = nb_samples;
+    result.iterations = batch * nb_samples;
+    result.cpu_time = cpu_ns / result.iterations;
+    double sum = 0;
+    for (double time : times) sum += time;
+    result.mean = sum / nb_samples;
+    double variance = 0;
+    for (double time : times) variance += (time - result.mean) * (time - result.mean);
+    result.stddev = nb_samples > 1 ? std::sqrt(variance / (nb_samples - 1)) : 0.;
+    std::sort(times.begin(), times.end());
+    result.min = times.front();
+    result.max = times.back();
+    result.median = nb_samples % 2 ? times[nb_samples / 2] : (times[nb_samples / 2 - 1] + times[nb_samples / 2]) / 2;
+    if (result.median > 0) {
+        result.items_per_second = bench.items_per_iteration * 1e9 / result.median;
+        result.bytes_per_second = bench.bytes_per_iteration * 1e9 / result.median;
+    }
+    return result;
+}
+
+bool BenchSuite::writeJson(const std::string& path) const {
+    char date[32];
+    std::time_t now = std::time(nullptr);
+    std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S%z", std::localtime(&now));
+
+    std::ostringstream json;
+    json.precision(6);
+    json << std::fixed;
+    json << "{\n  \"context\": {\n";
+    json << "    \"date\": " << jsonString(date) << ",\n";
+    json << "    \"host_name\": " << jsonString(hostName()) << ",\n";
+    json << "    \"executable\": " << jsonString(executable) << ",\n";
+    json << "    \"suite\": " << jsonString(suite_name) << ",\n";
+    json << "    \"num_cpus\": " << std::thread::hardware_concurrency() << ",\n";
+    json << "    \"compiler\": " << jsonString(compiler()) << ",\n";
+#if defined(NDEBUG)
+    json << "    \"library_build_type\": \"release\"";
+#else
+    json << "    \"library_build_type\": \"debug\"";
+#endif
+    for (auto& entry : context)
+        json << ",\n    " << jsonString(entry.first) << ": " << jsonString(entry.second);
+    json << "\n  },\n  \"benchmarks\": [";
+
+    for (size_t i = 0; i < bench_results.size(); i++) {
+        auto& result = bench_results[i];
+        json << (i ? ",\n" : "\n") << "    {\n";
+        json << "      \"name\": " << jsonString(result.name) << ",\n";
+        json << "      \"run_name\": " << jsonString(result.name) << ",\n";
+        json << "      \"run_type\": \"iteration\",\n";
+        json << "      \"repetitions\": 1,\n";
+        json << "      \"threads\": 1,\n";
+        json << "      \"iterations\": " << result.iterations << ",\n";
+        json << "      \"samples\": " << result.samples << ",\n";
+        json << "      \"real_time\": " << result.median << ",\n";
+        json << "      \"cpu_time\": " << result.cpu_time << ",\n";
+        json << "      \"time_unit\": \"ns\",\n";
+        json << "      \"min_time\": " << result.min << ",\n";
+        json << "      \"max_time\": " << result.max << ",\n";
+        json << "      \"mean_time\": " << result.mean << ",\n";
+        json << "      \"stddev_time\": " << result.stddev;
+        if (result.items_per_second > 0) json << ",\n      \"items_per_second\": " << result.items_per_second;
+        if (result.bytes_per_second > 0) json << ",\n      \"bytes_per_second\": " << result.bytes_per_second;
+        json << "\n    }";
+    }
+    json << "\n  ]\n}\n";
+
+    if (path == "-") {
+        std::cout << json.str();
+        return static_cast<bool>(std::cout);
+    }
+    std::ofstream file(path);
+    file << json.str();
+    return static_cast<bool>(file);
+}
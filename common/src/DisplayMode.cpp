@@ -0,0 +1,97 @@
+#include "DisplayMode.hpp"
+
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+namespace {
+volatile std::sig_atomic_t interrupted = 0;
+
+void onInterrupt(int) {
+    interrupted = 1;
+}
+
+bool envEnabled(const char* name) {
+    const char* value = getenv(name);
+    return value && *value && strcmp(value, "0") != 0;
+}
+
+bool hasDisplayServer() {
+#if defined(__linux__)
+    return envEnabled("DISPLAY") || envEnabled("WAYLAND_DISPLAY");
+#else
+    return true;
+#endif
+}
+}
+
+bool DisplayMode::parse(int& argc, char** argv) {
+    bool headless = envEnabled("ZED_SAMPLES_HEADLESS");
+    int nb_args = 1;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--headless")
+            headless = true;
+        else if (arg == "--preview" && i + 1 < argc) {
+            preview_period = atoi(argv[++i]);
+            if (preview_period < 1) {
+                std::cout << "[Sample][Error] --preview needs a period of at least 1 frame" << std::endl;
+                return false;
+            }
+        } else if (arg == "--sink" && i + 1 < argc) {
+            sink = ResultSink::create(argv[++i]);
+            if (!sink) {
+                std::cout << "[Sample][Error] Invalid or unavailable sink '" << argv[i] << "'" << std::endl;
+                return false;
+            }
+        } else
+            argv[nb_args++] = argv[i];
+    }
+    argc = nb_args;
+    argv[argc] = nullptr;
+
+    if (!headless && !hasDisplayServer()) {
+        std::cout << "[Sample] No display server found, running headless" << std::endl;
+        headless = true;
+    }
+    current_mode = headless ? Mode::HEADLESS : (preview_period > 1 ? Mode::PREVIEW : Mode::WINDOW);
+    if (headless) {
+        // Without window to close, Ctrl+C ends the loop and the sample closes the camera
+        std::signal(SIGINT, onInterrupt);
+        std::cout << "[Sample] Running headless, press Ctrl+C to exit" << std::endl;
+    } else if (current_mode == Mode::PREVIEW)
+        std::cout << "[Sample] Preview, the windows are rendered every " << preview_period << " frames" << std::endl;
+    return true;
+}
+
+const char* DisplayMode::usage() {
+    return "[--headless | --preview N] [--sink file:<path> | shm:<name>]";
+}
+
+const char* DisplayMode::modeName() const {
+    switch (current_mode) {
+        case Mode::WINDOW: return "window";
+        case Mode::PREVIEW: return "preview";
+        default: return "headless";
+    }
+}
+
+bool DisplayMode::nextFrame() {
+    if (started) frame++;
+    started = true;
+    return !interrupted;
+}
+
+bool DisplayMode::publish(uint64_t timestamp, const std::string& text) {
+    FrameResult result;
+    result.timestamp = timestamp;
+    result.text = text;
+    return publish(result);
+}
+
+bool DisplayMode::publish(FrameResult& result) {
+    if (!sink) return false;
+    result.frame = frame;
+    return sink->write(result);
+}
@@ -0,0 +1,470 @@
+#include "FrameContainer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <Windows.h>
+#include <winioctl.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef WITH_LZ4
+#include <lz4.h>
+#endif
+#ifdef WITH_ZSTD
+#include <zstd.h>
+#endif
+
+static uint64_t alignUp(uint64_t v) {
+    return (v + FRAME_CONTAINER_ALIGNMENT - 1) / FRAME_CONTAINER_ALIGNMENT * FRAME_CONTAINER_ALIGNMENT;
+}
+
+static uint64_t compressBound(FRAME_COMPRESSION compression, uint64_t size) {
+    switch (compression) {
+#ifdef WITH_LZ4
+        case FRAME_COMPRESSION::LZ4: return LZ4_compressBound(static_cast<int>(size));
+#endif
+#ifdef WITH_ZSTD
+        case FRAME_COMPRESSION::ZSTD: return ZSTD_compressBound(size);
+#endif
+        default: return size;
+    }
+}
+
+// Return the compressed size, 0 on error
+static uint64_t compress(FRAME_COMPRESSION compression, const uint8_t* src, uint64_t size, uint8_t* dst, uint64_t capacity) {
+    switch (compression) {
+#ifdef WITH_LZ4
+        case FRAME_COMPRESSION::LZ4: {
+            int ret = LZ4_compress_default(reinterpret_cast<const char*>(src), reinterpret_cast<char*>(dst), static_cast<int>(size), static_cast<int>(capacity));
+            return ret > 0 ? ret : 0;
+        }
+#endif
+#ifdef WITH_ZSTD
+        case FRAME_COMPRESSION::ZSTD: {
+            size_t ret = ZSTD_compress(dst, capacity, src, size, 1);
+            return ZSTD_isError(ret) ? 0 : ret;
+        }
+#endif
+        default:
+            if (size > capacity) return 0;
+            memcpy(dst, src, size);
+            return size;
+    }
+}
+
+static bool decompress(FRAME_COMPRESSION compression, const uint8_t* src, uint64_t size, uint8_t* dst, uint64_t expected) {
+    switch (compression) {
+#ifdef WITH_LZ4
+        case FRAME_COMPRESSION::LZ4:
+            return LZ4_decompress_safe(reinterpret_cast<const char*>(src), reinterpret_cast<char*>(dst), static_cast<int>(size), static_cast<int>(expected)) == static_cast<int>(expected);
+#endif
+#ifdef WITH_ZSTD
+        case FRAME_COMPRESSION::ZSTD:
+            return ZSTD_decompress(dst, expected, src, size) == expected;
+#endif
+        case FRAME_COMPRESSION::NONE:
+            if (size != expected) return false;
+            memcpy(dst, src, size);
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool isCompressionAvailable(FRAME_COMPRESSION compression) {
+    switch (compression) {
+        case FRAME_COMPRESSION::NONE: return true;
+#ifdef WITH_LZ4
+        case FRAME_COMPRESSION::LZ4: return true;
+#endif
+#ifdef WITH_ZSTD
+        case FRAME_COMPRESSION::ZSTD: return true;
+#endif
+        default: return false;
+    }
+}
+
+bool parseContainerFormat(const std::string& format, ContainerParameters& params) {
+    std::string depth = format;
+    params.compression = FRAME_COMPRESSION::NONE;
+    size_t dash = format.find('-');
+    if (dash != std::string::npos) {
+        std::string compression = format.substr(dash + 1);
+        depth = format.substr(0, dash);
+        if (compression == "lz4") params.compression = FRAME_COMPRESSION::LZ4;
+        else if (compression == "zstd") params.compression = FRAME_COMPRESSION::ZSTD;
+        else return false;
+    }
+
+    params.depth_unit = 1.f;
+    if (depth == "f32") {
+        params.depth_format = DEPTH_FORMAT::F32;
+    } else if (depth.compare(0, 3, "u16") == 0) {
+        params.depth_format = DEPTH_FORMAT::U16;
+        if (depth.size() > 3) {
+            if (depth[3] != ':') return false;
+            params.depth_unit = static_cast<float>(atof(depth.c_str() + 4));
+            if (!(params.depth_unit > 0.f)) return false;
+        }
+    } else
+        return false;
+
+    return isCompressionAvailable(params.compression);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// MappedFile
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::create(const std::string& path, uint64_t size, bool preallocate) {
+    close();
+    HANDLE f = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (f == INVALID_HANDLE_VALUE) return false;
+    DWORD returned = 0;
+    if (!preallocate && !DeviceIoControl(f, FSCTL_SET_SPARSE, NULL, 0, NULL, 0, &returned, NULL)) {
+        CloseHandle(f);
+        return false;
+    }
+    LARGE_INTEGER li;
+    li.QuadPart = size;
+    if (!SetFilePointerEx(f, li, NULL, FILE_BEGIN) || !SetEndOfFile(f)) {
+        CloseHandle(f);
+        return false;
+    }
+    HANDLE m = CreateFileMappingA(f, NULL, PAGE_READWRITE, li.HighPart, li.LowPart, NULL);
+    if (!m) {
+        CloseHandle(f);
+        return false;
+    }
+    ptr = static_cast<uint8_t*>(MapViewOfFile(m, FILE_MAP_WRITE, 0, 0, size));
+    file_handle = f;
+    mapping_handle = m;
+    length = size;
+    writable = true;
+    file_path = path;
+    if (!ptr) close();
+    return ptr != nullptr;
+}
+
+bool MappedFile::open(const std::string& path) {
+    close();
+    HANDLE f = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (f == INVALID_HANDLE_VALUE) return false;
+    LARGE_INTEGER li;
+    if (!GetFileSizeEx(f, &li) || li.QuadPart == 0) {
+        CloseHandle(f);
+        return false;
+    }
+    HANDLE m = CreateFileMappingA(f, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (!m) {
+        CloseHandle(f);
+        return false;
+    }
+    ptr = static_cast<uint8_t*>(MapViewOfFile(m, FILE_MAP_READ, 0, 0, 0));
+    file_handle = f;
+    mapping_handle = m;
+    length = li.QuadPart;
+    writable = false;
+    file_path = path;
+    if (!ptr) close();
+    return ptr != nullptr;
+}
+
+void MappedFile::close(uint64_t new_size) {
+    if (ptr) {
+        if (writable) FlushViewOfFile(ptr, 0);
+        UnmapViewOfFile(ptr);
+    }
+    if (mapping_handle) CloseHandle(mapping_handle);
+    if (file_handle) {
+        if (ptr && writable && new_size && new_size < length) {
+            LARGE_INTEGER li;
+            li.QuadPart = new_size;
+            if (SetFilePointerEx(file_handle, li, NULL, FILE_BEGIN)) SetEndOfFile(file_handle);
+        }
+        CloseHandle(file_handle);
+    }
+    ptr = nullptr;
+    file_handle = mapping_handle = nullptr;
+    length = 0;
+}
+
+#else // unix
+
+bool MappedFile::create(const std::string& path, uint64_t size, bool preallocate) {
+    close();
+    fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return false;
+    // Allocate the blocks now, so that writing a frame never waits for the file system. Otherwise the file is sparse:
+    // only the pages written take disk space
+#ifdef __linux__
+    int err = preallocate ? posix_fallocate(fd, 0, size) : ftruncate(fd, size);
+#else
+    int err = ftruncate(fd, size);
+#endif
+    if (err != 0) {
+        ::close(fd);
+        fd = -1;
+        return false;
+    }
+    void* p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (p == MAP_FAILED) {
+        ::close(fd);
+        fd = -1;
+        return false;
+    }
+    ptr = static_cast<uint8_t*>(p);
+    length = size;
+    writable = true;
+    file_path = path;
+    return true;
+}
+
+bool MappedFile::open(const std::string& path) {
+    close();
+    fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0) {
+        ::close(fd);
+        fd = -1;
+        return false;
+    }
+    void* p = mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    if (p == MAP_FAILED) {
+        ::close(fd);
+        fd = -1;
+        return false;
+    }
+    ptr = static_cast<uint8_t*>(p);
+    length = info.st_size;
+    writable = false;
+    file_path = path;
+    return true;
+}
+
+void MappedFile::close(uint64_t new_size) {
+    if (ptr) {
+        if (writable) msync(ptr, length, MS_SYNC);
+        munmap(ptr, length);
+        if (writable && new_size && new_size < length) {
+            if (ftruncate(fd, new_size) != 0)
+                std::cout << "[Sample][Warning] Cannot shrink " << file_path << std::endl;
+        }
+    }
+    if (fd >= 0) ::close(fd);
+    ptr = nullptr;
+    fd = -1;
+    length = 0;
+}
+
+#endif
+
+/////////////////////////////////////////////////////////////////////////////
+// FrameContainerWriter
+
+FrameContainerWriter::~FrameContainerWriter() {
+    close();
+}
+
+bool FrameContainerWriter::create(const std::string& path, const ContainerParameters& params, uint64_t capacity) {
+    if (!isCompressionAvailable(params.compression) || capacity == 0) return false;
+
+    uint64_t pixels = static_cast<uint64_t>(params.width) * params.height;
+    uint64_t image_bytes = pixels * 4;
+    uint64_t depth_bytes = pixels * (params.depth_format == DEPTH_FORMAT::F32 ? sizeof(float) : sizeof(uint16_t));
+    uint64_t stride = alignUp(compressBound(params.compression, image_bytes) + compressBound(params.compression, depth_bytes));
+    uint64_t index_offset = alignUp(sizeof(ContainerHeader));
+    uint64_t data_offset = index_offset + alignUp(capacity * sizeof(FrameIndexEntry));
+
+    // The stride of the compressed frames is their worst case size: their file is sparse, each frame only takes the
+    // blocks of its compressed size on disk. The uncompressed ones are allocated up front
+    bool preallocate = params.compression == FRAME_COMPRESSION::NONE;
+    if (!file.create(path, data_offset + capacity * stride, preallocate)) {
+        std::cout << "[Sample][Error] Cannot " << (preallocate ? "allocate " : "create ") << path << " ("
+                  << (data_offset + capacity * stride) / (1024 * 1024) << " MB)" << std::endl;
+        return false;
+    }
+
+    header = reinterpret_cast<ContainerHeader*>(file.data());
+    memset(header, 0, sizeof(ContainerHeader));
+    memcpy(header->magic, FRAME_CONTAINER_MAGIC, sizeof(FRAME_CONTAINER_MAGIC));
+    header->version = FRAME_CONTAINER_VERSION;
+    header->width = params.width;
+    header->height = params.height;
+    header->image_channels = 4;
+    header->depth_format = params.depth_format;
+    header->depth_unit = params.depth_unit;
+    header->compression = params.compression;
+    header->capacity = capacity;
+    header->frame_stride = stride;
+    header->image_bytes = image_bytes;
+    header->depth_bytes = depth_bytes;
+    header->index_offset = index_offset;
+    header->data_offset = data_offset;
+
+    index = reinterpret_cast<FrameIndexEntry*>(file.data() + index_offset);
+    memset(index, 0, capacity * sizeof(FrameIndexEntry));
+    nb_written = 0;
+    last_slot = 0;
+    return true;
+}
+
+bool FrameContainerWriter::writeFrame(uint64_t slot, uint64_t timestamp, const uint8_t* image, size_t image_step,
+        const float* depth, size_t depth_step, std::vector<uint8_t>& scratch) {
+    if (!header || slot >= header->capacity) return false;
+
+    const uint32_t w = header->width, h = header->height;
+    const size_t image_row = w * 4;
+    const size_t depth_row = w * (header->depth_format == DEPTH_FORMAT::F32 ? sizeof(float) : sizeof(uint16_t));
+    const bool compressed = header->compression != FRAME_COMPRESSION::NONE;
+    uint8_t* dst = file.data() + header->data_offset + slot * header->frame_stride;
+    uint64_t remaining = header->frame_stride;
+
+    // Uncompressed frames are written row by row directly in the mapping, compressed ones go through a contiguous scratch buffer
+    if (compressed && scratch.size() < std::max(header->image_bytes, header->depth_bytes))
+        scratch.resize(std::max(header->image_bytes, header->depth_bytes));
+
+    uint8_t* packed = compressed ? scratch.data() : dst;
+    for (uint32_t y = 0; y < h; y++)
+        memcpy(packed + y * image_row, image + y * image_step, image_row);
+    uint64_t image_size = compressed ? compress(header->compression, packed, header->image_bytes, dst, remaining) : header->image_bytes;
+    if (image_size == 0) return false;
+    dst += image_size;
+    remaining -= image_size;
+
+    packed = compressed ? scratch.data() : dst;
+    if (header->depth_format == DEPTH_FORMAT::F32) {
+        for (uint32_t y = 0; y < h; y++)
+            memcpy(packed + y * depth_row, reinterpret_cast<const uint8_t*>(depth) + y * depth_step, depth_row);
+    } else {
+        const float inv_unit = 1.f / header->depth_unit;
+        for (uint32_t y = 0; y < h; y++) {
+            const float* src = reinterpret_cast<const float*>(reinterpret_cast<const uint8_t*>(depth) + y * depth_step);
+            uint16_t* out = reinterpret_cast<uint16_t*>(packed + y * depth_row);
+            for (uint32_t x = 0; x < w; x++) {
+                float v = src[x] * inv_unit + 0.5f;
+                // NaN and +/-inf fail the first test
+                out[x] = (v >= 0.f && v < 65535.5f) ? static_cast<uint16_t>(v) : 0;
+            }
+        }
+    }
+    uint64_t depth_size = compressed ? compress(header->compression, packed, header->depth_bytes, dst, remaining) : header->depth_bytes;
+    if (depth_size == 0) return false;
+
+    FrameIndexEntry& entry = index[slot];
+    entry.svo_position = static_cast<uint32_t>(slot);
+    entry.image_size = static_cast<uint32_t>(image_size);
+    entry.depth_size = static_cast<uint32_t>(depth_size);
+    entry.timestamp = timestamp;
+
+    nb_written++;
+    uint64_t last = last_slot;
+    while (slot + 1 > last && !last_slot.compare_exchange_weak(last, slot + 1));
+    return true;
+}
+
+void FrameContainerWriter::close() {
+    if (!header) return;
+    header->nb_frames = last_slot;
+    uint64_t used = header->data_offset + header->nb_frames * header->frame_stride;
+    header = nullptr;
+    index = nullptr;
+    file.close(used);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// FrameContainerReader
+
+bool FrameContainerReader::open(const std::string& path) {
+    close();
+    if (!file.open(path)) return false;
+    if (file.size() < sizeof(ContainerHeader)) {
+        close();
+        return false;
+    }
+    header = reinterpret_cast<const ContainerHeader*>(file.data());
+    if (!isValid()) {
+        std::cout << "[Sample][Error] " << path << " is not a valid frame container" << std::endl;
+        close();
+        return false;
+    }
+    index = reinterpret_cast<const FrameIndexEntry*>(file.data() + header->index_offset);
+    return true;
+}
+
+bool FrameContainerReader::isValid() const {
+    const uint64_t size = file.size();
+    const ContainerHeader& h = *header;
+    if (memcmp(h.magic, FRAME_CONTAINER_MAGIC, sizeof(FRAME_CONTAINER_MAGIC)) != 0 || h.version != FRAME_CONTAINER_VERSION
+            || !isCompressionAvailable(h.compression) || h.nb_frames > h.capacity)
+        return false;
+    // Index and data inside the file, without overflow on corrupted values
+    if (h.index_offset < sizeof(ContainerHeader) || h.index_offset > size
+            || h.capacity > (size - h.index_offset) / sizeof(FrameIndexEntry)
+            || h.data_offset < h.index_offset + h.capacity * sizeof(FrameIndexEntry) || h.data_offset > size)
+        return false;
+    if (h.nb_frames && (h.frame_stride == 0 || h.nb_frames > (size - h.data_offset) / h.frame_stride))
+        return false;
+    uint64_t pixels = static_cast<uint64_t>(h.width) * h.height;
+    uint64_t depth_bytes = pixels * (h.depth_format == DEPTH_FORMAT::F32 ? sizeof(float) : sizeof(uint16_t));
+    if (h.image_bytes != pixels * 4 || h.depth_bytes != depth_bytes)
+        return false;
+    // Stored sizes of the written frames inside their slot
+    const FrameIndexEntry* entries = reinterpret_cast<const FrameIndexEntry*>(file.data() + h.index_offset);
+    for (uint64_t i = 0; i < h.nb_frames; i++) {
+        const FrameIndexEntry& entry = entries[i];
+        if (entry.timestamp == 0) continue;
+        if (static_cast<uint64_t>(entry.image_size) + entry.depth_size > h.frame_stride) return false;
+        if (h.compression == FRAME_COMPRESSION::NONE && (entry.image_size != h.image_bytes || entry.depth_size != h.depth_bytes)) return false;
+    }
+    return true;
+}
+
+void FrameContainerReader::close() {
+    file.close();
+    header = nullptr;
+    index = nullptr;
+}
+
+bool FrameContainerReader::decode(uint64_t i, uint8_t* image_out, void* depth_out) const {
+    if (!header || i >= header->nb_frames || index[i].timestamp == 0) return false;
+    const FrameIndexEntry& entry = index[i];
+    const uint8_t* src = frame(i);
+    return decompress(header->compression, src, entry.image_size, image_out, header->image_bytes)
+        && decompress(header->compression, src + entry.image_size, entry.depth_size, static_cast<uint8_t*>(depth_out), header->depth_bytes);
+}
+
+uint64_t FrameContainerReader::findTimestamp(uint64_t ts) const {
+    // Slots are written in SVO order, so the timestamps of the written slots are increasing. Unwritten slots (0) are skipped.
+    uint64_t lo = 0, hi = getNbFrames();
+    while (lo < hi) {
+        uint64_t mid = lo + (hi - lo) / 2;
+        uint64_t probe = mid;
+        while (probe < hi && index[probe].timestamp == 0) probe++;
+        if (probe == hi) {
+            hi = mid;
+        } else if (index[probe].timestamp < ts) {
+            lo = probe + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    while (lo < getNbFrames() && index[lo].timestamp == 0) lo++;
+    return lo;
+}
@@ -0,0 +1,502 @@
+#ifdef FRAME_SOURCE_OPENCV
+#include <opencv2/opencv.hpp>
+#endif
+
+#include "FrameSource.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#ifdef FRAME_SOURCE_ZED
+#include "ZedFrameSource.hpp"
+#endif
+
+namespace {
+const char* RESOLUTIONS[] = {"HD2K", "HD1080", "HD720", "VGA"};
+const double PI = 3.14159265358979323846;
+
+// Whole string is an integer in [min, max]
+bool parseInt(const std::string& text, int min, int max, int& value) {
+    if (text.empty() || text.size() > 9 || text.find_first_not_of("0123456789") != std::string::npos) return false;
+    int parsed = atoi(text.c_str());
+    if (parsed < min || parsed > max) return false;
+    value = parsed;
+    return true;
+}
+
+uint64_t frameTimestamp(uint64_t index, int fps) {
+    // Starts at one frame period: 0 is an unwritten slot in the raw containers
+    return (index + 1) * 1000000000ull / static_cast<uint64_t>(fps);
+}
+
+// 16 bits depth of the SVO export: 0 is an invalid pixel, NAN as in the depth of the ZED SDK
+void depthFromU16(const uint16_t* src, size_t count, float unit, float* dst) {
+    for (size_t i = 0; i < count; i++)
+        dst[i] = src[i] ? src[i] * unit : NAN;
+}
+}
+
+void FrameImage::allocate(int width_, int height_, int channels_, int element_bytes_) {
+    width = width_;
+    height = height_;
+    channels = channels_;
+    element_bytes = element_bytes_;
+    step = static_cast<size_t>(width) * channels * element_bytes;
+    // Keeps its capacity: no allocation while the resolution does not grow
+    data.resize(step * height);
+}
+
+void FrameImage::release() {
+    width = height = channels = element_bytes = 0;
+    step = 0;
+    data.clear();
+}
+
+bool parseIPv4(const std::string& text, std::string& ip, int& port) {
+    size_t colon = text.find(':');
+    std::string address = text.substr(0, colon);
+    int parsed_port = port;
+    if (colon != std::string::npos && !parseInt(text.substr(colon + 1), 1, 65535, parsed_port)) return false;
+
+    size_t start = 0;
+    for (int i = 0; i < 4; i++) {
+        size_t end = i < 3 ? address.find('.', start) : address.size();
+        int byte;
+        if (end == std::string::npos || !parseInt(address.substr(start, end - start), 0, 255, byte)) return false;
+        start = end + 1;
+    }
+    ip = address;
+    port = parsed_port;
+    return true;
+}
+
+bool FrameSourceOptions::parse(int& argc, char** argv) {
+    bool has_source = false;
+    int nb_args = 1;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--source" && i + 1 < argc) {
+            if (!parseSource(argv[++i])) {
+                std::cout << "[Sample][Error] Invalid source '" << argv[i] << "', expected " << usage() << std::endl;
+                return false;
+            }
+            has_source = true;
+        } else if (arg == "--frames" && i + 1 < argc) {
+            int frames;
+            if (!parseInt(argv[++i], 1, 1000000000, frames)) {
+                std::cout << "[Sample][Error] --frames needs a number of frames of at least 1" << std::endl;
+                return false;
+            }
+            max_frames = frames;
+        } else if (arg == "--prefetch" && i + 1 < argc) {
+            if (!parseInt(argv[++i], 0, 1024, prefetch)) {
+                std::cout << "[Sample][Error] --prefetch needs a number of frames between 0 and 1024" << std::endl;
+                return false;
+            }
+        } else if (arg == "--fps" && i + 1 < argc) {
+            if (!parseInt(argv[++i], 1, 1000, fps)) {
+                std::cout << "[Sample][Error] --fps needs a frame rate between 1 and 1000" << std::endl;
+                return false;
+            }
+        } else
+            argv[nb_args++] = argv[i];
+    }
+    argc = nb_args;
+    argv[argc] = nullptr;
+
+    // Input argument of the samples, first after the options
+    if (!has_source && argc > 1 && parseInput(argv[1])) {
+        for (int i = 1; i < argc; i++) argv[i] = argv[i + 1];
+        argc--;
+        has_source = true;
+    }
+    if (has_source) std::cout << "[Sample] Using " << describe() << std::endl;
+    return true;
+}
+
+bool FrameSourceOptions::parseInput(const std::string& arg) {
+    if (arg.find(".svo") != std::string::npos) {
+        kind = FRAME_SOURCE::SVO;
+        path = arg;
+        return true;
+    }
+    if (parseIPv4(arg, ip, port)) {
+        kind = FRAME_SOURCE::STREAM;
+        return true;
+    }
+    for (auto name : RESOLUTIONS)
+        if (arg.find(name) != std::string::npos) {
+            kind = FRAME_SOURCE::CAMERA;
+            resolution = name;
+            return true;
+        }
+    return false;
+}
+
+bool FrameSourceOptions::parseSource(const std::string& spec) {
+    size_t colon = spec.find(':');
+    std::string type = spec.substr(0, colon);
+    std::string value = colon == std::string::npos ? "" : spec.substr(colon + 1);
+    if (type == "camera") {
+        kind = FRAME_SOURCE::CAMERA;
+        if (value.empty()) return true;
+        for (auto name : RESOLUTIONS)
+            if (value == name) {
+                resolution = name;
+                return true;
+            }
+        return false;
+    }
+    if (type == "stream") {
+        kind = FRAME_SOURCE::STREAM;
+        return parseIPv4(value, ip, port);
+    }
+    if (type == "synthetic") {
+        kind = FRAME_SOURCE::SYNTHETIC;
+        if (value.empty()) return true;
+        size_t x = value.find('x');
+        return x != std::string::npos && parseInt(value.substr(0, x), 16, 16384, width) && parseInt(value.substr(x + 1), 16, 16384, height);
+    }
+    if (value.empty()) return false;
+    path = value;
+    if (type == "svo") kind = FRAME_SOURCE::SVO;
+    else if (type == "images") kind = FRAME_SOURCE::IMAGES;
+    else if (type == "raw") kind = FRAME_SOURCE::RAW;
+    else return false;
+    return true;
+}
+
+const char* FrameSourceOptions::usage() {
+    return "[--source camera[:HD2K|HD1080|HD720|VGA] | svo:<file.svo> | stream:<ip>[:<port>] | images:<directory> | raw:<file.zraw> | synthetic[:<width>x<height>]]"
+           " [--frames N] [--prefetch N] [--fps N]";
+}
+
+std::string FrameSourceOptions::describe() const {
+    switch (kind) {
+        case FRAME_SOURCE::CAMERA: return resolution.empty() ? "camera" : "camera in resolution " + resolution;
+        case FRAME_SOURCE::SVO: return "SVO file " + path;
+        case FRAME_SOURCE::STREAM: return "stream " + ip + (port ? ":" + std::to_string(port) : "");
+        case FRAME_SOURCE::IMAGES: return "images of " + path;
+        case FRAME_SOURCE::RAW: return "raw container " + path;
+        default: return "synthetic frames " + std::to_string(width) + "x" + std::to_string(height);
+    }
+}
+
+std::unique_ptr<FrameSource> FrameSource::create(const FrameSourceOptions& options) {
+    std::unique_ptr<FrameSource> source;
+    switch (options.kind) {
+        case FRAME_SOURCE::SYNTHETIC:
+            source.reset(new SyntheticSource(options.width, options.height, options.fps));
+            break;
+        case FRAME_SOURCE::IMAGES:
+#ifdef FRAME_SOURCE_OPENCV
+            source.reset(new ImageSequenceSource(options.path, options.fps));
+            break;
+#else
+            std::cout << "[Sample][Error] The image sources need OpenCV, this program is built without it" << std::endl;
+            return nullptr;
+#endif
+        case FRAME_SOURCE::RAW:
+            source.reset(new ContainerSource(options.path));
+            break;
+        default:
+#ifdef FRAME_SOURCE_ZED
+            source.reset(new ZedFrameSource(options));
+            break;
+#else
+            std::cout << "[Sample][Error] The " << options.describe() << " needs the ZED SDK, this program is built without it" << std::endl;
+            return nullptr;
+#endif
+    }
+    source->setMaxFrames(options.max_frames);
+    if (options.prefetch > 0) {
+        // The camera and the stream run at their own rate, the files wait for the sample
+        bool live = options.kind == FRAME_SOURCE::CAMERA || options.kind == FRAME_SOURCE::STREAM;
+        source.reset(new PrefetchSource(std::move(source), options.prefetch, live));
+    }
+    return source;
+}
+
+FRAME_STATUS FrameSource::read(FrameBundle& frame) {
+    if (max_frames >= 0 && nb_read >= static_cast<uint64_t>(max_frames)) return FRAME_STATUS::END;
+    FRAME_STATUS status = readFrame(frame);
+    if (status == FRAME_STATUS::FRAME) frame.index = nb_read++;
+    return status;
+}
+
+SyntheticSource::SyntheticSource(int width_, int height_, int fps_) : width(width_), height(height_), fps(std::max(1, fps_)) {
+}
+
+std::string SyntheticSource::describe() const {
+    return "synthetic frames " + std::to_string(width) + "x" + std::to_string(height);
+}
+
+void SyntheticSource::squareAt(uint64_t index, int& x, int& y, int& size) const {
+    size = std::max(1, height / 4);
+    x = static_cast<int>((index * 4) % static_cast<uint64_t>(std::max(1, width - size)));
+    y = (height - size) / 2;
+}
+
+FRAME_STATUS SyntheticSource::readFrame(FrameBundle& frame) {
+    const uint64_t index = next++;
+    int square_x, square_y, square_size;
+    squareAt(index, square_x, square_y, square_size);
+
+    frame.timestamp = frameTimestamp(index, fps);
+    frame.image.allocate(width, height, 4, 1);
+    frame.depth.allocate(width, height, 1, 4);
+    for (int y = 0; y < height; y++) {
+        uint8_t* pixel = frame.image.row<uint8_t>(y);
+        float* depth = frame.depth.row<float>(y);
+        const bool square_row = y >= square_y && y < square_y + square_size;
+        for (int x = 0; x < width; x++, pixel += 4) {
+            const bool square = square_row && x >= square_x && x < square_x + square_size;
+            pixel[0] = square ? 255 : static_cast<uint8_t>(x + index);
+            pixel[1] = square ? 255 : static_cast<uint8_t>(y);
+            pixel[2] = square ? 255 : static_cast<uint8_t>(index * 7);
+            pixel[3] = 255;
+            depth[x] = square ? 1000.f : 2000.f;
+        }
+    }
+
+    // One turn in 10 seconds on a circle of 1 m, looking at its center
+    const double angle = 2. * PI * static_cast<double>(index) / (10. * fps);
+    frame.pose.valid = true;
+    frame.pose.translation[0] = static_cast<float>(1000. * sin(angle));
+    frame.pose.translation[1] = 0.f;
+    frame.pose.translation[2] = static_cast<float>(1000. * cos(angle));
+    frame.pose.orientation[0] = 0.f;
+    frame.pose.orientation[1] = static_cast<float>(sin(angle / 2.));
+    frame.pose.orientation[2] = 0.f;
+    frame.pose.orientation[3] = static_cast<float>(cos(angle / 2.));
+    return FRAME_STATUS::FRAME;
+}
+
+ImageSequenceSource::ImageSequenceSource(const std::string& directory_, int fps_) : directory(directory_), fps(std::max(1, fps_)) {
+    while (directory.size() > 1 && (directory.back() == '/' || directory.back() == '\\')) directory.pop_back();
+}
+
+std::string ImageSequenceSource::describe() const {
+    return "images of " + directory;
+}
+
+bool ImageSequenceSource::open() {
+#ifdef FRAME_SOURCE_OPENCV
+    images.clear();
+    depths.clear();
+    next = 0;
+    // Frames of the SVO export first, their depth maps next to them
+    for (auto pattern : {"/left*.png", "/left*.jpg"}) {
+        cv::glob(directory + pattern, images, false);
+        if (!images.empty()) break;
+    }
+    bool exported = !images.empty();
+    for (auto pattern : {"/*.png", "/*.jpg"}) {
+        if (!images.empty()) break;
+        cv::glob(directory + pattern, images, false);
+    }
+    if (images.empty()) {
+        std::cout << "[Sample][Error] No left*.png, left*.jpg, *.png nor *.jpg image in " << directory << std::endl;
+        return false;
+    }
+    for (auto& image : images) {
+        std::string depth;
+        size_t name = image.find_last_of("/\\") + 1;
+        if (exported) {
+            depth = image.substr(0, name) + "depth" + image.substr(name + 4);
+            depth = depth.substr(0, depth.find_last_of('.')) + ".png";
+            if (!std::ifstream(depth)) depth.clear();
+        }
+        depths.push_back(depth);
+    }
+    return true;
+#else
+    std::cout << "[Sample][Error] The image sources need OpenCV, this program is built without it" << std::endl;
+    return false;
+#endif
+}
+
+FRAME_STATUS ImageSequenceSource::readFrame(FrameBundle& frame) {
+#ifdef FRAME_SOURCE_OPENCV
+    if (next >= images.size()) return FRAME_STATUS::END;
+    const size_t index = next++;
+    cv::Mat image = cv::imread(images[index], cv::IMREAD_UNCHANGED);
+    if (image.empty()) {
+        std::cout << "[Sample][Error] Cannot read the image " << images[index] << std::endl;
+        return FRAME_STATUS::FAILED;
+    }
+    if (image.depth() != CV_8U) image.convertTo(image, CV_8U, image.depth() == CV_16U ? 1. / 256. : 1.);
+
+    frame.timestamp = frameTimestamp(index, fps);
+    frame.image.allocate(image.cols, image.rows, 4, 1);
+    // Converted in the buffer of the bundle, same size and type: OpenCV does not reallocate
+    cv::Mat bgra = toCvMat(frame.image);
+    switch (image.channels()) {
+        case 1: cv::cvtColor(image, bgra, cv::COLOR_GRAY2BGRA); break;
+        case 3: cv::cvtColor(image, bgra, cv::COLOR_BGR2BGRA); break;
+        default: image.copyTo(bgra); break;
+    }
+
+    frame.depth.release();
+    if (!depths[index].empty()) {
+        // 16 bits depth in millimeters (export mode 4), the 8 bits depth views of mode 3 are not depth
+        cv::Mat depth = cv::imread(depths[index], cv::IMREAD_ANYDEPTH);
+        if (depth.type() == CV_16UC1 && depth.size() == image.size()) {
+            frame.depth.allocate(depth.cols, depth.rows, 1, 4);
+            for (int y = 0; y < depth.rows; y++)
+                depthFromU16(depth.ptr<uint16_t>(y), depth.cols, 1.f, frame.depth.row<float>(y));
+        }
+    }
+    frame.pose.valid = false;
+    return FRAME_STATUS::FRAME;
+#else
+    (void) frame;
+    return FRAME_STATUS::FAILED;
+#endif
+}
+
+ContainerSource::ContainerSource(const std::string& path_) : path(path_) {
+}
+
+std::string ContainerSource::describe() const {
+    return "raw container " + path;
+}
+
+bool ContainerSource::open() {
+    next = 0;
+    if (!reader.open(path)) {
+        std::cout << "[Sample][Error] Cannot open the raw container " << path << std::endl;
+        return false;
+    }
+    const ContainerHeader& header = reader.getHeader();
+    const uint64_t nb_pixels = static_cast<uint64_t>(header.width) * header.height;
+    const uint64_t depth_size = header.depth_format == DEPTH_FORMAT::U16 ? sizeof(uint16_t) : sizeof(float);
+    if (header.image_channels != 4 || header.image_bytes != nb_pixels * 4 || header.depth_bytes != nb_pixels * depth_size
+            || !isCompressionAvailable(header.compression)) {
+        std::cout << "[Sample][Error] " << path << ": unsupported image format or compression not available in this build" << std::endl;
+        reader.close();
+        return false;
+    }
+    return true;
+}
+
+FRAME_STATUS ContainerSource::readFrame(FrameBundle& frame) {
+    // Slots never written by the export (frames it could not grab) are skipped
+    while (next < reader.getNbFrames() && reader.getEntry(next).timestamp == 0) next++;
+    if (next >= reader.getNbFrames()) return FRAME_STATUS::END;
+    const uint64_t slot = next++;
+
+    const ContainerHeader& header = reader.getHeader();
+    const int width = static_cast<int>(header.width), height = static_cast<int>(header.height);
+    frame.image.allocate(width, height, 4, 1);
+    frame.depth.allocate(width, height, 1, 4);
+    const bool u16 = header.depth_format == DEPTH_FORMAT::U16;
+    if (u16) depth_buffer.resize(header.depth_bytes);
+    if (!reader.decode(slot, frame.image.data.data(), u16 ? depth_buffer.data() : frame.depth.data.data())) {
+        std::cout << "[Sample][Error] Cannot decode the frame " << slot << " of " << path << std::endl;
+        return FRAME_STATUS::FAILED;
+    }
+    if (u16) depthFromU16(reinterpret_cast<const uint16_t*>(depth_buffer.data()), static_cast<size_t>(width) * height, header.depth_unit, reinterpret_cast<float*>(frame.depth.data.data()));
+    frame.timestamp = reader.getEntry(slot).timestamp;
+    frame.pose.valid = false;
+    return FRAME_STATUS::FRAME;
+}
+
+PrefetchSource::PrefetchSource(std::unique_ptr<FrameSource> source_, int depth_, bool drop_late_)
+    : source(std::move(source_)), depth(static_cast<size_t>(std::max(1, depth_))), drop_late(drop_late_) {
+}
+
+PrefetchSource::~PrefetchSource() {
+    close();
+}
+
+std::string PrefetchSource::describe() const {
+    return source->describe() + ", " + std::to_string(depth) + " frames prefetched";
+}
+
+bool PrefetchSource::open() {
+    close();
+    if (!source->open()) return false;
+    stopping = false;
+    last_status = FRAME_STATUS::FRAME;
+    nb_dropped = 0;
+    // depth frames queued and the one being read
+    for (size_t i = 0; i <= depth; i++)
+        free_bundles.emplace_back(new FrameBundle());
+    reader = std::thread(&PrefetchSource::readerLoop, this);
+    return true;
+}
+
+void PrefetchSource::close() {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        stopping = true;
+    }
+    free_cv.notify_all();
+    ready_cv.notify_all();
+    if (reader.joinable()) reader.join();
+    source->close();
+    ready.clear();
+    free_bundles.clear();
+}
+
+uint64_t PrefetchSource::droppedFrames() const {
+    std::lock_guard<std::mutex> lock(mtx);
+    return nb_dropped;
+}
+
+void PrefetchSource::readerLoop() {
+    while (true) {
+        std::unique_ptr<FrameBundle> bundle;
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            if (!drop_late) free_cv.wait(lock, [this] { return !free_bundles.empty() || stopping; });
+            if (stopping) return;
+            if (!free_bundles.empty()) {
+                bundle = std::move(free_bundles.front());
+                free_bundles.pop_front();
+            } else {
+                // The sample is late: the oldest frame is replaced by a new one
+                bundle = std::move(ready.front());
+                ready.pop_front();
+                nb_dropped++;
+            }
+        }
+        FRAME_STATUS status = source->read(*bundle);
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            if (status == FRAME_STATUS::FRAME)
+                ready.push_back(std::move(bundle));
+            else {
+                free_bundles.push_back(std::move(bundle));
+                last_status = status;
+            }
+        }
+        ready_cv.notify_one();
+        if (status != FRAME_STATUS::FRAME) return;
+    }
+}
+
+FRAME_STATUS PrefetchSource::readFrame(FrameBundle& frame) {
+    std::unique_ptr<FrameBundle> bundle;
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        ready_cv.wait(lock, [this] { return !ready.empty() || last_status != FRAME_STATUS::FRAME || stopping; });
+        if (ready.empty()) return stopping ? FRAME_STATUS::FAILED : last_status;
+        bundle = std::move(ready.front());
+        ready.pop_front();
+    }
+    // The caller gets the buffers of the frame, the bundle goes back to the pool with the previous buffers of the caller
+    std::swap(*bundle, frame);
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        free_bundles.push_back(std::move(bundle));
+    }
+    free_cv.notify_one();
+    return FRAME_STATUS::FRAME;
+}
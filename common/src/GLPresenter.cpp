@@ -0,0 +1,243 @@
+#include "GLPresenter.hpp"
+
+#include <chrono>
+
+namespace {
+    // Waits of the fences, the driver is flushed on the first one
+    const GLuint64 FENCE_TIMEOUT_NS = 1000000000ull;
+
+    double elapsedMs(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+GLPresenter::~GLPresenter() {
+    release();
+}
+
+const char* GLPresenter::pathName(Path path) {
+    switch (path) {
+        case Path::CUDA_INTEROP: return "CUDA interop";
+        case Path::PERSISTENT_PBO: return "persistent mapped PBO";
+        case Path::MAPPED_PBO: return "mapped PBO";
+        case Path::DIRECT: return "glTexSubImage2D";
+        default: return "none";
+    }
+}
+
+GLPresenter::Path GLPresenter::hostPath() {
+    if (GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage) return Path::PERSISTENT_PBO;
+    if (GLEW_VERSION_3_0 || GLEW_ARB_map_buffer_range) return Path::MAPPED_PBO;
+    return Path::DIRECT;
+}
+
+bool GLPresenter::init(int width_, int height_, bool device_frames, PixelFormat source, int nb_slots) {
+#ifdef GL_PRESENTER_CUDA
+    if (device_frames) return init(width_, height_, Path::CUDA_INTEROP, source, nb_slots);
+#else
+    if (device_frames) return false;
+#endif
+    return init(width_, height_, hostPath(), source, nb_slots);
+}
+
+bool GLPresenter::init(int width_, int height_, Path path, PixelFormat source, int nb_slots) {
+    return init(width_, height_, path, negotiateUpload(source, path == Path::CUDA_INTEROP, GLCapabilities::current()), nb_slots);
+}
+
+bool GLPresenter::init(int width_, int height_, Path path, const UploadFormat& format, int nb_slots) {
+    release();
+    if (width_ <= 0 || height_ <= 0 || nb_slots < 1 || path == Path::NONE) return false;
+#ifndef GL_PRESENTER_CUDA
+    if (path == Path::CUDA_INTEROP) return false;
+#endif
+    // CUDA copies the bytes as they are
+    if (path == Path::CUDA_INTEROP && (format.channels == ChannelPath::UPLOAD_FORMAT || format.channels == ChannelPath::CPU_CONVERSION)) return false;
+    width = width_;
+    height = height_;
+    current_path = path;
+    upload_format = format;
+    const GLsizeiptr frame_bytes = static_cast<GLsizeiptr>(width) * height * upload_format.pixel_bytes;
+
+    slots.resize(nb_slots);
+    bool ok = true;
+    for (auto& slot : slots) {
+        glGenTextures(1, &slot.texture);
+        glBindTexture(GL_TEXTURE_2D, slot.texture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        // The sampler reorders the channels: no conversion at the uploads nor in the shaders of the draws
+        if (upload_format.channels == ChannelPath::SWIZZLE)
+            glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, upload_format.swizzle);
+        glTexImage2D(GL_TEXTURE_2D, 0, upload_format.internal_format, width, height, 0, upload_format.format, GL_UNSIGNED_BYTE, NULL);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        if (path == Path::PERSISTENT_PBO || path == Path::MAPPED_PBO) {
+            glGenBuffers(1, &slot.pbo);
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.pbo);
+            if (path == Path::PERSISTENT_PBO) {
+                const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+                glBufferStorage(GL_PIXEL_UNPACK_BUFFER, frame_bytes, NULL, flags);
+                slot.mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, frame_bytes, flags);
+                ok &= slot.mapped != nullptr;
+            } else
+                glBufferData(GL_PIXEL_UNPACK_BUFFER, frame_bytes, NULL, GL_STREAM_DRAW);
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        }
+#ifdef GL_PRESENTER_CUDA
+        if (path == Path::CUDA_INTEROP) {
+            ok &= cudaGraphicsGLRegisterImage(&slot.resource, slot.texture, GL_TEXTURE_2D, cudaGraphicsRegisterFlagsWriteDiscard) == cudaSuccess;
+            ok &= cudaEventCreateWithFlags(&slot.ready, cudaEventDisableTiming) == cudaSuccess;
+        }
+#endif
+    }
+    ok &= glGetError() == GL_NO_ERROR;
+    if (!ok) release();
+    return ok;
+}
+
+void GLPresenter::release() {
+    for (auto& slot : slots) {
+#ifdef GL_PRESENTER_CUDA
+        if (slot.ready) {
+            cudaEventSynchronize(slot.ready);
+            cudaEventDestroy(slot.ready);
+        }
+        if (slot.resource) cudaGraphicsUnregisterResource(slot.resource);
+#endif
+        if (slot.fence) glDeleteSync(slot.fence);
+        if (slot.pbo) {
+            if (slot.mapped) {
+                glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.pbo);
+                glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+                glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            }
+            glDeleteBuffers(1, &slot.pbo);
+        }
+        if (slot.texture) glDeleteTextures(1, &slot.texture);
+    }
+    slots.clear();
+    staging.clear();
+    staging.shrink_to_fit();
+    current_path = Path::NONE;
+    upload_format = UploadFormat();
+    next_slot = 0;
+    latest_slot = front_slot = -1;
+}
+
+GLPresenter::Slot& GLPresenter::acquireSlot() {
+    Slot& slot = slots[next_slot];
+    if (slot.fence) {
+        // The GL commands reading its buffer are done
+        GLenum status = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+        if (status == GL_TIMEOUT_EXPIRED) {
+            statistics.stalls++;
+            while (status == GL_TIMEOUT_EXPIRED)
+                status = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, FENCE_TIMEOUT_NS);
+        }
+        glDeleteSync(slot.fence);
+        slot.fence = nullptr;
+    }
+#ifdef GL_PRESENTER_CUDA
+    if (slot.pending && cudaEventQuery(slot.ready) == cudaErrorNotReady) {
+        statistics.stalls++;
+        cudaEventSynchronize(slot.ready);
+    }
+#endif
+    return slot;
+}
+
+bool GLPresenter::uploadHost(const void* data, size_t step_bytes) {
+    if (current_path != Path::PERSISTENT_PBO && current_path != Path::MAPPED_PBO && current_path != Path::DIRECT) return false;
+    auto start = std::chrono::steady_clock::now();
+    Slot& slot = acquireSlot();
+    glBindTexture(GL_TEXTURE_2D, slot.texture);
+    // Rows of 1 byte pixels are not aligned on 4 bytes
+    if (upload_format.pixel_bytes != 4) glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    if (current_path == Path::DIRECT) {
+        if (upload_format.channels == ChannelPath::CPU_CONVERSION) {
+            staging.resize(static_cast<size_t>(width) * height * upload_format.pixel_bytes);
+            convertRows(upload_format, staging.data(), data, step_bytes, width, height);
+            data = staging.data();
+        } else
+            glPixelStorei(GL_UNPACK_ROW_LENGTH, static_cast<GLint>(step_bytes / upload_format.pixel_bytes));
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, upload_format.format, GL_UNSIGNED_BYTE, data);
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    } else {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.pbo);
+        const GLsizeiptr frame_bytes = static_cast<GLsizeiptr>(width) * height * upload_format.pixel_bytes;
+        void* dst = slot.mapped;
+        // The fence of the slot is signaled: no need for the driver to synchronize the mapping
+        if (current_path == Path::MAPPED_PBO)
+            dst = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, frame_bytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+        if (dst) convertRows(upload_format, dst, data, step_bytes, width, height);
+        if (current_path == Path::MAPPED_PBO && dst) glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        // Asynchronous: the driver reads the buffer when the texture is needed
+        if (dst) glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, upload_format.format, GL_UNSIGNED_BYTE, NULL);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        if (!dst) {
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+            glBindTexture(GL_TEXTURE_2D, 0);
+            return false;
+        }
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    // The GL commands are ordered: the next draws see the new texture
+    latest_slot = front_slot = next_slot;
+    next_slot = (next_slot + 1) % static_cast<int>(slots.size());
+    statistics.frames++;
+    statistics.upload_ms += elapsedMs(start);
+    return true;
+}
+
+#ifdef GL_PRESENTER_CUDA
+bool GLPresenter::uploadDevice(const void* data, size_t step_bytes, cudaStream_t stream) {
+    if (current_path != Path::CUDA_INTEROP) return false;
+    auto start = std::chrono::steady_clock::now();
+    Slot& slot = acquireSlot();
+    // The ring went round faster than the draws: the front slot is about to be written
+    if (next_slot == front_slot) front_slot = -1;
+    // Map, copy and unmap are queued on the stream, the mapping waits for the GL commands still reading the texture
+    cudaArray_t array;
+    bool ok = cudaGraphicsMapResources(1, &slot.resource, stream) == cudaSuccess;
+    ok = ok && cudaGraphicsSubResourceGetMappedArray(&array, slot.resource, 0, 0) == cudaSuccess;
+    ok = ok && cudaMemcpy2DToArrayAsync(array, 0, 0, data, step_bytes, width * upload_format.pixel_bytes, height, cudaMemcpyDeviceToDevice, stream) == cudaSuccess;
+    ok = cudaGraphicsUnmapResources(1, &slot.resource, stream) == cudaSuccess && ok;
+    ok = ok && cudaEventRecord(slot.ready, stream) == cudaSuccess;
+    slot.pending = ok;
+    if (!ok) return false;
+
+    latest_slot = next_slot;
+    next_slot = (next_slot + 1) % static_cast<int>(slots.size());
+    statistics.frames++;
+    statistics.upload_ms += elapsedMs(start);
+    return true;
+}
+#endif
+
+GLuint GLPresenter::texture() {
+    if (latest_slot < 0) return 0;
+#ifdef GL_PRESENTER_CUDA
+    if (current_path == Path::CUDA_INTEROP && front_slot != latest_slot) {
+        // Newest slot whose copy is done, from the latest upload back to the current front
+        const int nb_slots = static_cast<int>(slots.size());
+        for (int i = latest_slot; i != front_slot; i = (i + nb_slots - 1) % nb_slots) {
+            if (slots[i].pending && cudaEventQuery(slots[i].ready) == cudaSuccess) {
+                front_slot = i;
+                break;
+            }
+            // Nothing to draw yet: wait for the first frame
+            if (front_slot < 0 && i == (latest_slot + 1) % nb_slots) break;
+        }
+        if (front_slot < 0) {
+            cudaEventSynchronize(slots[latest_slot].ready);
+            front_slot = latest_slot;
+        }
+    }
+#endif
+    return slots[front_slot].texture;
+}
@@ -0,0 +1,124 @@
+#include "ImageFormat.hpp"
+
+#include <cstring>
+
+GLCapabilities GLCapabilities::current() {
+    GLCapabilities capabilities;
+    capabilities.texture_swizzle = GLEW_VERSION_3_3 || GLEW_ARB_texture_swizzle || GLEW_EXT_texture_swizzle;
+    return capabilities;
+}
+
+size_t pixelBytes(PixelFormat format) {
+    return format == PixelFormat::GRAY ? 1 : 4;
+}
+
+const char* pixelFormatName(PixelFormat format) {
+    switch (format) {
+        case PixelFormat::RGBA: return "RGBA";
+        case PixelFormat::BGRA: return "BGRA";
+        default: return "GRAY";
+    }
+}
+
+const char* channelPathName(ChannelPath path) {
+    switch (path) {
+        case ChannelPath::NATIVE: return "native";
+        case ChannelPath::SWIZZLE: return "texture swizzle";
+        case ChannelPath::UPLOAD_FORMAT: return "upload format";
+        case ChannelPath::CPU_CONVERSION: return "CPU conversion";
+        default: return "shader";
+    }
+}
+
+bool UploadFormat::swizzled() const {
+    return swizzle[0] != GL_RED || swizzle[1] != GL_GREEN || swizzle[2] != GL_BLUE || swizzle[3] != GL_ALPHA;
+}
+
+const char* UploadFormat::name() const {
+    static const char* names[3][5] = {
+        {"RGBA, native", "RGBA, texture swizzle", "RGBA, upload format", "RGBA, CPU conversion", "RGBA, shader"},
+        {"BGRA, native", "BGRA, texture swizzle", "BGRA, upload format", "BGRA, CPU conversion", "BGRA, shader"},
+        {"GRAY, native", "GRAY, texture swizzle", "GRAY, upload format", "GRAY, CPU conversion", "GRAY, shader"}
+    };
+    return names[static_cast<int>(source)][static_cast<int>(channels)];
+}
+
+static void setSwizzle(UploadFormat& format, GLint r, GLint g, GLint b, GLint a) {
+    format.swizzle[0] = r;
+    format.swizzle[1] = g;
+    format.swizzle[2] = b;
+    format.swizzle[3] = a;
+}
+
+bool makeUploadFormat(PixelFormat source, ChannelPath channels, UploadFormat& format) {
+    format = UploadFormat();
+    format.source = source;
+    format.channels = channels;
+    switch (channels) {
+        case ChannelPath::NATIVE:
+            return source == PixelFormat::RGBA;
+        case ChannelPath::SWIZZLE:
+        case ChannelPath::SHADER:
+            // The texture holds the bytes of the frames as they are
+            if (source == PixelFormat::BGRA)
+                setSwizzle(format, GL_BLUE, GL_GREEN, GL_RED, GL_ALPHA);
+            else if (source == PixelFormat::GRAY) {
+                format.internal_format = GL_R8;
+                format.format = GL_RED;
+                format.pixel_bytes = 1;
+                setSwizzle(format, GL_RED, GL_RED, GL_RED, GL_ONE);
+            }
+            return true;
+        case ChannelPath::UPLOAD_FORMAT:
+            format.format = GL_BGRA;
+            return source == PixelFormat::BGRA;
+        case ChannelPath::CPU_CONVERSION:
+            return true;
+        default:
+            return false;
+    }
+}
+
+UploadFormat negotiateUpload(PixelFormat source, bool device_frames, const GLCapabilities& capabilities) {
+    ChannelPath channels;
+    if (source == PixelFormat::RGBA) channels = ChannelPath::NATIVE;
+    else if (capabilities.texture_swizzle) channels = ChannelPath::SWIZZLE;
+    // CUDA copies the bytes as they are, only the draw can reorder them
+    else if (device_frames) channels = ChannelPath::SHADER;
+    else if (source == PixelFormat::BGRA) channels = ChannelPath::UPLOAD_FORMAT;
+    else channels = ChannelPath::CPU_CONVERSION;
+    UploadFormat format;
+    makeUploadFormat(source, channels, format);
+    return format;
+}
+
+void convertRows(const UploadFormat& format, void* dst, const void* src, size_t src_step, int width, int height) {
+    const size_t row_bytes = width * format.pixel_bytes;
+    if (format.channels != ChannelPath::CPU_CONVERSION || format.source == PixelFormat::RGBA) {
+        if (src_step == row_bytes) {
+            memcpy(dst, src, row_bytes * height);
+            return;
+        }
+        for (int y = 0; y < height; y++)
+            memcpy(static_cast<unsigned char*>(dst) + y * row_bytes, static_cast<const unsigned char*>(src) + y * src_step, row_bytes);
+        return;
+    }
+
+    for (int y = 0; y < height; y++) {
+        const unsigned char* in = static_cast<const unsigned char*>(src) + y * src_step;
+        unsigned char* out = static_cast<unsigned char*>(dst) + y * row_bytes;
+        if (format.source == PixelFormat::BGRA) {
+            for (int x = 0; x < width; x++, in += 4, out += 4) {
+                out[0] = in[2];
+                out[1] = in[1];
+                out[2] = in[0];
+                out[3] = in[3];
+            }
+        } else {
+            for (int x = 0; x < width; x++, in++, out += 4) {
+                out[0] = out[1] = out[2] = in[0];
+                out[3] = 255;
+            }
+        }
+    }
+}
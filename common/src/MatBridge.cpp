@@ -0,0 +1,118 @@
+#include "MatBridge.hpp"
+
+// The element sizes of the two libraries must agree, the views share the buffers
+static_assert(CV_ELEM_SIZE(cvType(sl::MAT_TYPE::F32_C4)) == sizeof(sl::float4), "F32_C4");
+static_assert(CV_ELEM_SIZE(cvType(sl::MAT_TYPE::F32_C3)) == sizeof(sl::float3), "F32_C3");
+static_assert(CV_ELEM_SIZE(cvType(sl::MAT_TYPE::U8_C4)) == sizeof(sl::uchar4), "U8_C4");
+static_assert(CV_ELEM_SIZE(cvType(sl::MAT_TYPE::U8_C1)) == sizeof(sl::uchar1), "U8_C1");
+#ifdef MAT_BRIDGE_U16_S8
+static_assert(CV_ELEM_SIZE(cvType(sl::MAT_TYPE::U16_C1)) == sizeof(sl::ushort1), "U16_C1");
+#endif
+
+namespace {
+const sl::MAT_TYPE MAT_TYPES[] = {
+    sl::MAT_TYPE::F32_C1, sl::MAT_TYPE::F32_C2, sl::MAT_TYPE::F32_C3, sl::MAT_TYPE::F32_C4,
+    sl::MAT_TYPE::U8_C1, sl::MAT_TYPE::U8_C2, sl::MAT_TYPE::U8_C3, sl::MAT_TYPE::U8_C4,
+#ifdef MAT_BRIDGE_U16_S8
+    sl::MAT_TYPE::U16_C1, sl::MAT_TYPE::S8_C4,
+#endif
+};
+
+sl::uchar1* dataIn(sl::Mat& input, sl::MEM memory) {
+    if (!input.isInit() || !(static_cast<int>(input.getMemoryType()) & static_cast<int>(memory))) return nullptr;
+    return input.getPtr<sl::uchar1>(memory);
+}
+}
+
+bool slType(int cv_type, sl::MAT_TYPE& type) {
+    for (auto candidate : MAT_TYPES)
+        if (cvType(candidate) == cv_type) {
+            type = candidate;
+            return true;
+        }
+    return false;
+}
+
+cv::Mat toCvMat(sl::Mat& input) {
+    const int type = cvType(input.getDataType());
+    sl::uchar1* data = dataIn(input, sl::MEM::CPU);
+    if (type < 0 || !data) return cv::Mat();
+    return cv::Mat(static_cast<int>(input.getHeight()), static_cast<int>(input.getWidth()), type, data, input.getStepBytes(sl::MEM::CPU));
+}
+
+cv::cuda::GpuMat toGpuMat(sl::Mat& input) {
+    const int type = cvType(input.getDataType());
+    sl::uchar1* data = dataIn(input, sl::MEM::GPU);
+    if (type < 0 || !data) return cv::cuda::GpuMat();
+    return cv::cuda::GpuMat(static_cast<int>(input.getHeight()), static_cast<int>(input.getWidth()), type, data, input.getStepBytes(sl::MEM::GPU));
+}
+
+sl::Mat toSlMat(const cv::Mat& input) {
+    sl::MAT_TYPE type;
+    if (input.empty() || !slType(input.type(), type)) return sl::Mat();
+    return sl::Mat(sl::Resolution(input.cols, input.rows), type, input.data, input.step, sl::MEM::CPU);
+}
+
+sl::Mat toSlMat(const cv::cuda::GpuMat& input) {
+    sl::MAT_TYPE type;
+    if (input.empty() || !slType(input.type(), type)) return sl::Mat();
+    return sl::Mat(sl::Resolution(input.cols, input.rows), type, input.data, input.step, sl::MEM::GPU);
+}
+
+PinnedStaging::~PinnedStaging() {
+    if (done) cudaEventDestroy(done);
+    if (buffer) cudaFreeHost(buffer);
+}
+
+bool PinnedStaging::download(sl::Mat& input, cudaStream_t stream) {
+    type = -1;
+    const int input_type = cvType(input.getDataType());
+    sl::uchar1* data = dataIn(input, sl::MEM::GPU);
+    if (input_type < 0 || !data) return false;
+
+    const size_t row_bytes = input.getWidth() * input.getPixelBytes();
+    const size_t size = row_bytes * input.getHeight();
+    if (size > buffer_size) {
+        // The previous download may still write in the buffer
+        if (done) cudaEventSynchronize(done);
+        if (buffer) cudaFreeHost(buffer);
+        buffer_size = 0;
+        if (cudaHostAlloc(&buffer, size, cudaHostAllocDefault) != cudaSuccess) {
+            buffer = nullptr;
+            return false;
+        }
+        buffer_size = size;
+    }
+    if (!done && cudaEventCreateWithFlags(&done, cudaEventDisableTiming) != cudaSuccess) {
+        done = nullptr;
+        return false;
+    }
+    if (cudaMemcpy2DAsync(buffer, row_bytes, data, input.getStepBytes(sl::MEM::GPU), row_bytes, input.getHeight(), cudaMemcpyDeviceToHost, stream) != cudaSuccess
+            || cudaEventRecord(done, stream) != cudaSuccess)
+        return false;
+
+    width = static_cast<int>(input.getWidth());
+    height = static_cast<int>(input.getHeight());
+    type = input_type;
+    step = row_bytes;
+    return true;
+}
+
+bool PinnedStaging::ready() const {
+    return type >= 0 && cudaEventQuery(done) == cudaSuccess;
+}
+
+bool PinnedStaging::wait() {
+    return type >= 0 && cudaEventSynchronize(done) == cudaSuccess;
+}
+
+cv::Mat PinnedStaging::cvView() const {
+    if (type < 0) return cv::Mat();
+    return cv::Mat(height, width, type, buffer, step);
+}
+
+sl::Mat PinnedStaging::slView() const {
+    sl::MAT_TYPE sl_type;
+    if (type < 0 || !slType(type, sl_type)) return sl::Mat();
+    return sl::Mat(sl::Resolution(width, height), sl_type, static_cast<sl::uchar1*>(buffer), step, sl::MEM::CPU);
+}
@@ -0,0 +1,67 @@
+#include "ResultSink.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+const size_t SharedMemorySink::TEXT_CAPACITY;
+
+std::unique_ptr<ResultSink> ResultSink::create(const std::string& spec) {
+    if (spec.compare(0, 5, "file:") == 0 && spec.size() > 5) {
+        FileSink* file = new FileSink();
+        std::unique_ptr<ResultSink> sink(file);
+        if (!file->open(spec.substr(5))) return nullptr;
+        return sink;
+    }
+    if (spec.compare(0, 4, "shm:") == 0 && spec.size() > 4)
+        return std::unique_ptr<ResultSink>(new SharedMemorySink(spec.substr(4)));
+    return nullptr;
+}
+
+FileSink::~FileSink() {
+    if (owner && file) fclose(file);
+}
+
+bool FileSink::open(const std::string& path) {
+    if (owner && file) fclose(file);
+    owner = path != "-";
+    file = owner ? fopen(path.c_str(), "w") : stdout;
+    return file != nullptr;
+}
+
+bool FileSink::write(const FrameResult& result) {
+    if (!file) return false;
+    fprintf(file, "%llu %llu %s\n", (unsigned long long)result.frame, (unsigned long long)result.timestamp, result.text.c_str());
+    // Line by line: the results are read while the sample runs
+    return fflush(file) == 0;
+}
+
+bool SharedMemorySink::write(const FrameResult& result) {
+    const size_t row_bytes = static_cast<size_t>(result.width) * result.channels;
+    const size_t image_bytes = result.image ? row_bytes * result.height : 0;
+    if (!ring.getNbSlots() && !ring.create(name, nb_slots, image_bytes + TEXT_CAPACITY)) return false;
+
+    const size_t text_bytes = std::min(result.text.size(), TEXT_CAPACITY);
+    if (image_bytes + text_bytes > ring.getSlotSize()) return false;
+
+    SharedFrameInfo info;
+    info.timestamp = result.timestamp;
+    if (image_bytes) {
+        info.width = result.width;
+        info.height = result.height;
+        info.channels = result.channels;
+        info.step = static_cast<uint32_t>(row_bytes);
+    }
+    info.size = static_cast<uint32_t>(image_bytes + text_bytes);
+    info.reserved = static_cast<uint32_t>(text_bytes);
+    // Packed rows then the text, copied once, straight in the slot: the readers use the ring in place
+    return ring.write(info, [&](uint8_t* data) {
+        for (int y = 0; image_bytes && y < result.height; y++)
+            memcpy(data + y * row_bytes, static_cast<const uint8_t*>(result.image) + y * result.step, row_bytes);
+        memcpy(data + image_bytes, result.text.data(), text_bytes);
+    }) != 0;
+}
+
+std::string SharedMemorySink::text(const SharedFrameView& view) {
+    if (!view.data || view.info.reserved > view.info.size) return std::string();
+    return std::string(reinterpret_cast<const char*>(view.data) + view.info.size - view.info.reserved, view.info.reserved);
+}
@@ -0,0 +1,147 @@
+#include "SensorStream.hpp"
+
+#include <cmath>
+
+sl::ERROR_CODE MockSensorSource::getSensorsData(sl::SensorsData& data) {
+    // Index of the latest sample at the current time
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    uint64_t index = static_cast<uint64_t>(elapsed * rate);
+    float t = static_cast<float>(index / rate);
+
+    data.imu.is_available = true;
+    data.imu.timestamp.setNanoseconds(static_cast<unsigned long long>(index * (1e9 / rate)) + 1);
+    for (int i = 0; i < 3; i++) {
+        data.imu.angular_velocity[i] = 10.f * std::sin(t + i);
+        data.imu.linear_acceleration[i] = (i == 1) ? -9.81f : 0.1f * std::cos(t + i);
+    }
+    return sl::ERROR_CODE::SUCCESS;
+}
+
+SensorStream::SensorStream(SensorSource& source_, size_t queue_size_) : source(source_), queue_size(queue_size_) {
+}
+
+SensorStream::~SensorStream() {
+    stop();
+}
+
+int SensorStream::subscribe(Callback callback) {
+    std::lock_guard<std::mutex> lock(mtx);
+    subscribers[next_id] = callback;
+    generation++;
+    return next_id++;
+}
+
+void SensorStream::unsubscribe(int id) {
+    bool from_callback;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        subscribers.erase(id);
+        generation++;
+        from_callback = std::this_thread::get_id() == stream_thread;
+    }
+    // deliver() checks that a callback is still subscribed before calling it, waiting for the callbacks being called
+    // is enough. Not from the stream thread: it would wait for itself
+    if (!from_callback)
+        std::lock_guard<std::mutex> wait_callbacks(callback_mtx);
+}
+
+void SensorStream::start() {
+    if (running) return;
+    running = true;
+    worker = std::thread(&SensorStream::run, this);
+}
+
+void SensorStream::stop() {
+    running = false;
+    queue_cv.notify_all();
+    if (worker.joinable()) worker.join();
+}
+
+bool SensorStream::pop(SensorSample& sample, int timeout_ms) {
+    std::unique_lock<std::mutex> lock(mtx);
+    queue_cv.wait_for(lock, std::chrono::milliseconds(timeout_ms), [this] { return !queue.empty() || !running; });
+    if (queue.empty()) return false;
+    sample = queue.front();
+    queue.pop_front();
+    return true;
+}
+
+SensorStreamStats SensorStream::getStats() {
+    std::lock_guard<std::mutex> lock(mtx);
+    return stats;
+}
+
+void SensorStream::deliver(const SensorSample& sample) {
+    std::lock_guard<std::mutex> callback_lock(callback_mtx);
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        stats.nb_samples++;
+        if (queue_size > 0) {
+            if (queue.size() >= queue_size) {
+                queue.pop_front();
+                stats.nb_dropped++;
+            }
+            queue.push_back(sample);
+            queue_cv.notify_one();
+        }
+        if (callbacks_generation != generation) {
+            callbacks.assign(subscribers.begin(), subscribers.end());
+            callbacks_generation = generation;
+        }
+    }
+
+    // The callbacks run without the lock, they may use the stream
+    for (auto& it : callbacks) {
+        {
+            // Unsubscribed by a previous callback
+            std::lock_guard<std::mutex> lock(mtx);
+            if (callbacks_generation != generation && !subscribers.count(it.first)) continue;
+        }
+        it.second(sample);
+    }
+}
+
+void SensorStream::run() {
+    float rate = source.getImuRate();
+    if (!(rate > 0.f)) rate = 400.f; // unknown, assume the fastest IMU
+    const std::chrono::nanoseconds period(static_cast<int64_t>(1e9 / rate));
+    const std::chrono::nanoseconds fine_poll = period / 10;
+
+    TimestampHandler ts;
+    SensorSample sample;
+    uint64_t last_ts = 0;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        stream_thread = std::this_thread::get_id();
+    }
+
+    while (running) {
+        bool new_sample = false;
+        uint64_t nb_missed = 0;
+        if (source.getSensorsData(sample.data) == sl::ERROR_CODE::SUCCESS) {
+            if (ts.isNew(sample.data.imu)) {
+                uint64_t current_ts = sample.data.imu.timestamp.getNanoseconds();
+                if (last_ts > 0) {
+                    // A gap of more than 1.5 periods means that samples were replaced before being read
+                    double gap = static_cast<double>(current_ts - last_ts) / period.count();
+                    if (gap > 1.5) nb_missed = static_cast<uint64_t>(std::lround(gap)) - 1;
+                }
+                last_ts = current_ts;
+                sample.new_magnetometer = ts.isNew(sample.data.magnetometer);
+                sample.new_barometer = ts.isNew(sample.data.barometer);
+                new_sample = true;
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            stats.nb_polls++;
+            if (!new_sample) stats.nb_duplicates++;
+            stats.nb_missed += nb_missed;
+        }
+        if (new_sample) deliver(sample);
+
+        // The next sample is one period away: sleep most of it, then poll finely until it arrives
+        std::this_thread::sleep_for(new_sample ? period * 8 / 10 : fine_poll);
+    }
+}
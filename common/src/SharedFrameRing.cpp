@@ -0,0 +1,265 @@
+#include "SharedFrameRing.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <new>
+#include <thread>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#ifdef __linux__
+#include <climits>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+namespace {
+const uint32_t RING_MAGIC = 0x5A524E47;     // "ZRNG"
+const uint32_t RING_VERSION = 1;
+const size_t HEADER_SIZE = 4096;
+const size_t SLOT_HEADER_SIZE = 64;
+
+size_t alignUp(size_t value, size_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+void notifyWait(std::atomic<uint32_t>* word, uint32_t value, int timeout_ms) {
+#ifdef __linux__
+    // Shared (not private) futex, the waiters are in other processes
+    timespec timeout;
+    timeout.tv_sec = timeout_ms / 1000;
+    timeout.tv_nsec = (timeout_ms % 1000) * 1000000L;
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAIT, value, &timeout, nullptr, 0);
+#else
+    (void)word;
+    (void)value;
+    std::this_thread::sleep_for(std::chrono::milliseconds(std::min(timeout_ms, 1)));
+#endif
+}
+
+void notifyWake(std::atomic<uint32_t>* word) {
+#ifdef __linux__
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+#else
+    (void)word;
+#endif
+}
+}
+
+struct SharedFrameRing::Header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t nb_slots;
+    uint32_t reserved;
+    uint64_t slot_size;
+    uint64_t slot_stride;
+    std::atomic<uint64_t> write_seq;
+    std::atomic<uint32_t> notify;       // incremented at each frame, the futex of the readers
+};
+
+struct SharedFrameRing::Slot {
+    std::atomic<uint64_t> seq;          // 0 while the writer fills the slot
+    SharedFrameInfo info;
+};
+
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "the futex word has to be a plain 32 bits integer");
+
+SharedFrameRing::~SharedFrameRing() {
+    close();
+}
+
+bool SharedFrameRing::map(const std::string& name, size_t size, bool create) {
+#ifdef _WIN32
+    std::string path = "Local\\" + name;
+    if (create) {
+        mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, static_cast<DWORD>(static_cast<uint64_t>(size) >> 32),
+                static_cast<DWORD>(size & 0xFFFFFFFF), path.c_str());
+    } else
+        mapping = OpenFileMappingA(FILE_MAP_READ, FALSE, path.c_str());
+    if (!mapping) return false;
+    memory = MapViewOfFile(mapping, create ? FILE_MAP_ALL_ACCESS : FILE_MAP_READ, 0, 0, 0);
+    if (!memory) {
+        CloseHandle(mapping);
+        mapping = nullptr;
+        return false;
+    }
+    if (!create) {
+        MEMORY_BASIC_INFORMATION region;
+        VirtualQuery(memory, &region, sizeof(region));
+        size = region.RegionSize;
+    }
+#else
+    std::string path = "/" + name;
+    int fd;
+    if (create) {
+        shm_unlink(path.c_str());     // a ring left by a relay that crashed
+        fd = shm_open(path.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+        if (fd >= 0 && ftruncate(fd, static_cast<off_t>(size)) != 0) {
+            ::close(fd);
+            shm_unlink(path.c_str());
+            return false;
+        }
+    } else {
+        fd = shm_open(path.c_str(), O_RDONLY, 0);
+        struct stat st;
+        if (fd >= 0 && fstat(fd, &st) == 0)
+            size = static_cast<size_t>(st.st_size);
+    }
+    if (fd < 0) return false;
+    // The readers map the ring read only, they cannot corrupt it for the others
+    memory = mmap(nullptr, size, create ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (memory == MAP_FAILED) {
+        memory = nullptr;
+        if (create) shm_unlink(path.c_str());
+        return false;
+    }
+#endif
+    memory_size = size;
+    shm_name = name;
+    owner = create;
+    header = static_cast<Header*>(memory);
+    return true;
+}
+
+bool SharedFrameRing::create(const std::string& name, int nb_slots, size_t slot_size) {
+    static_assert(sizeof(Slot) <= SLOT_HEADER_SIZE, "the slot header does not fit");
+    close();
+    if (nb_slots < 2 || slot_size == 0) return false;
+    const size_t stride = alignUp(SLOT_HEADER_SIZE + slot_size, 4096);
+    if (!map(name, HEADER_SIZE + stride * nb_slots, true)) return false;
+
+    header = new (memory) Header();
+    header->version = RING_VERSION;
+    header->nb_slots = static_cast<uint32_t>(nb_slots);
+    header->slot_size = slot_size;
+    header->slot_stride = stride;
+    header->write_seq.store(0, std::memory_order_relaxed);
+    header->notify.store(0, std::memory_order_relaxed);
+    slot_stride = stride;
+    for (int s = 0; s < nb_slots; s++) new (slot(s)) Slot();
+    // Readers check the magic, it is written last
+    std::atomic_thread_fence(std::memory_order_release);
+    header->magic = RING_MAGIC;
+    return true;
+}
+
+bool SharedFrameRing::open(const std::string& name) {
+    close();
+    if (!map(name, 0, false)) return false;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (memory_size < HEADER_SIZE || header->magic != RING_MAGIC || header->version != RING_VERSION
+            || memory_size < HEADER_SIZE + header->slot_stride * header->nb_slots) {
+        close();
+        return false;
+    }
+    slot_stride = header->slot_stride;
+    return true;
+}
+
+void SharedFrameRing::close() {
+    if (!memory) return;
+#ifdef _WIN32
+    UnmapViewOfFile(memory);
+    CloseHandle(mapping);
+    mapping = nullptr;
+#else
+    munmap(memory, memory_size);
+    if (owner) shm_unlink(("/" + shm_name).c_str());
+#endif
+    memory = nullptr;
+    header = nullptr;
+    memory_size = 0;
+    owner = false;
+}
+
+SharedFrameRing::Slot* SharedFrameRing::slot(uint64_t seq) const {
+    return reinterpret_cast<Slot*>(static_cast<uint8_t*>(memory) + HEADER_SIZE + slot_stride * (seq % header->nb_slots));
+}
+
+uint64_t SharedFrameRing::write(const void* data, const SharedFrameInfo& info) {
+    return write(info, [&](uint8_t* slot_data) { memcpy(slot_data, data, info.size); });
+}
+
+uint64_t SharedFrameRing::write(const SharedFrameInfo& info, const std::function<void(uint8_t*)>& fill) {
+    if (!owner || info.size > header->slot_size) return 0;
+    const uint64_t seq = header->write_seq.load(std::memory_order_relaxed) + 1;
+    Slot* s = slot(seq);
+    // Seqlock: the slot is marked as being written before its content changes
+    s->seq.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    s->info = info;
+    fill(reinterpret_cast<uint8_t*>(s) + SLOT_HEADER_SIZE);
+    s->seq.store(seq, std::memory_order_release);
+
+    header->write_seq.store(seq, std::memory_order_release);
+    header->notify.fetch_add(1, std::memory_order_release);
+    notifyWake(&header->notify);
+    return seq;
+}
+
+bool SharedFrameRing::acquire(uint64_t& last_seq, SharedFrameView& view, int timeout_ms, uint64_t* nb_skipped) {
+    if (!header) return false;
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    while (true) {
+        const uint32_t notify = header->notify.load(std::memory_order_acquire);
+        const uint64_t seq = header->write_seq.load(std::memory_order_acquire);
+        if (seq > last_seq) {
+            Slot* s = slot(seq);
+            if (s->seq.load(std::memory_order_acquire) == seq) {
+                view.info = s->info;
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (s->seq.load(std::memory_order_relaxed) == seq) {
+                    view.seq = seq;
+                    view.data = reinterpret_cast<const uint8_t*>(s) + SLOT_HEADER_SIZE;
+                    if (nb_skipped && last_seq > 0) *nb_skipped += seq - last_seq - 1;
+                    last_seq = seq;
+                    return true;
+                }
+            }
+            continue;   // the writer is already on this slot again, a newer frame is there
+        }
+        const auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+        if (remaining <= 0) return false;
+        notifyWait(&header->notify, notify, static_cast<int>(remaining));
+    }
+}
+
+bool SharedFrameRing::isValid(const SharedFrameView& view) const {
+    if (!header || !view.data) return false;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return slot(view.seq)->seq.load(std::memory_order_relaxed) == view.seq;
+}
+
+bool SharedFrameRing::read(uint64_t& last_seq, std::vector<uint8_t>& data, SharedFrameInfo& info, int timeout_ms, uint64_t* nb_skipped) {
+    SharedFrameView view;
+    while (acquire(last_seq, view, timeout_ms, nb_skipped)) {
+        data.assign(view.data, view.data + view.info.size);
+        if (isValid(view)) {
+            info = view.info;
+            return true;
+        }
+        // Overwritten during the copy, a newer frame is available
+    }
+    return false;
+}
+
+uint64_t SharedFrameRing::getSequence() const {
+    return header ? header->write_seq.load(std::memory_order_acquire) : 0;
+}
+
+int SharedFrameRing::getNbSlots() const {
+    return header ? static_cast<int>(header->nb_slots) : 0;
+}
+
+size_t SharedFrameRing::getSlotSize() const {
+    return header ? static_cast<size_t>(header->slot_size) : 0;
+}
@@ -0,0 +1,363 @@
+#include "StageTrace.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+std::atomic<bool> StageTrace::recording(false);
+const size_t StageTrace::TRACE_CAPACITY;
+
+namespace {
+const uint64_t RING_MASK = StageTrace::TRACE_CAPACITY - 1;
+// Stages timed per thread, the next ones are traced but not in the statistics
+const int MAX_STAGES = 64;
+// Log-linear histogram: the values under 16 ns exactly, then 16 buckets per power of two (3% wide at most)
+const int SUB_BITS = 4;
+const int NB_SUB = 1 << SUB_BITS;
+const int NB_BUCKETS = NB_SUB + (64 - SUB_BITS) * NB_SUB;
+
+int highestBit(uint64_t value) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanReverse64(&index, value);
+    return static_cast<int>(index);
+#else
+    return 63 - __builtin_clzll(value);
+#endif
+}
+
+int bucketOf(uint64_t value) {
+    if (value < NB_SUB) return static_cast<int>(value);
+    int exponent = highestBit(value);
+    return NB_SUB + (exponent - SUB_BITS) * NB_SUB + static_cast<int>((value >> (exponent - SUB_BITS)) & (NB_SUB - 1));
+}
+
+// Middle of the values of a bucket
+uint64_t bucketValue(int bucket) {
+    if (bucket < NB_SUB) return bucket;
+    int shift = (bucket - NB_SUB) / NB_SUB;
+    uint64_t lower = static_cast<uint64_t>(NB_SUB + (bucket - NB_SUB) % NB_SUB) << shift;
+    return lower + ((1ULL << shift) >> 1);
+}
+
+struct Span {
+    const char* stage;
+    uint64_t start, end;
+};
+
+// Written by its thread only: the counters are atomics for the readers of stats(), updated with relaxed loads and
+// stores, no read-modify-write
+struct StageHistogram {
+    explicit StageHistogram(const char* name) : name(name) {
+        for (auto& bucket : buckets) bucket.store(0, std::memory_order_relaxed);
+    }
+
+    void add(uint64_t value) {
+        auto bump = [](std::atomic<uint64_t>& counter, uint64_t delta) {
+            counter.store(counter.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+        };
+        bump(buckets[bucketOf(value)], 1);
+        bump(count, 1);
+        bump(sum, value);
+        if (value < min.load(std::memory_order_relaxed)) min.store(value, std::memory_order_relaxed);
+        if (value > max.load(std::memory_order_relaxed)) max.store(value, std::memory_order_relaxed);
+    }
+
+    void reset() {
+        for (auto& bucket : buckets) bucket.store(0, std::memory_order_relaxed);
+        count.store(0, std::memory_order_relaxed);
+        sum.store(0, std::memory_order_relaxed);
+        min.store(UINT64_MAX, std::memory_order_relaxed);
+        max.store(0, std::memory_order_relaxed);
+    }
+
+    const char* name;
+    std::atomic<uint64_t> count{0}, sum{0}, min{UINT64_MAX}, max{0};
+    std::atomic<uint64_t> buckets[NB_BUCKETS];
+};
+
+// Spans and statistics of a thread, kept after the end of the thread for the export
+struct ThreadRecord {
+    ThreadRecord() : ring(StageTrace::TRACE_CAPACITY) {}
+
+    StageHistogram* histogram(const char* stage) {
+        int nb = nb_stages.load(std::memory_order_relaxed);
+        if (last < nb && stages[last]->name == stage) return stages[last].get();
+        for (int i = 0; i < nb; i++) {
+            if (stages[i]->name == stage) {
+                last = i;
+                return stages[i].get();
+            }
+        }
+        if (nb == MAX_STAGES) return nullptr;
+        stages[nb].reset(new StageHistogram(stage));
+        nb_stages.store(nb + 1, std::memory_order_release);
+        last = nb;
+        return stages[nb].get();
+    }
+
+    int id = 0;
+    std::string name;
+    std::vector<Span> ring;
+    std::atomic<uint64_t> head{0};
+    std::unique_ptr<StageHistogram> stages[MAX_STAGES];
+    std::atomic<int> nb_stages{0};
+    int last = 0;
+};
+
+struct Registry {
+    std::mutex mtx;
+    std::vector<std::shared_ptr<ThreadRecord>> threads;
+    uint64_t origin = 0;
+};
+
+Registry& registry() {
+    static Registry instance;
+    return instance;
+}
+
+thread_local ThreadRecord* current_thread = nullptr;
+
+ThreadRecord& threadRecord() {
+    if (!current_thread) {
+        auto record = std::make_shared<ThreadRecord>();
+        auto& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mtx);
+        record->id = static_cast<int>(reg.threads.size()) + 1;
+        reg.threads.push_back(record);
+        current_thread = record.get();
+    }
+    return *current_thread;
+}
+
+std::string jsonString(const char* text) {
+    std::string out = "\"";
+    for (; *text; text++) {
+        char c = *text;
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char code[8];
+            snprintf(code, sizeof(code), "\\u%04x", c);
+            out += code;
+        } else
+            out += c;
+    }
+    return out + "\"";
+}
+
+std::string formatTime(double ns) {
+    char text[32];
+    if (ns < 1e3) snprintf(text, sizeof(text), "%.0f ns", ns);
+    else if (ns < 1e6) snprintf(text, sizeof(text), "%.2f us", ns / 1e3);
+    else if (ns < 1e9) snprintf(text, sizeof(text), "%.2f ms", ns / 1e6);
+    else snprintf(text, sizeof(text), "%.2f s", ns / 1e9);
+    return text;
+}
+}
+
+bool StageTrace::parse(int& argc, char** argv) {
+    int nb_args = 1;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--trace") {
+            if (i + 1 >= argc) {
+                std::cout << "[Sample][Error] --trace needs the path of the trace file" << std::endl;
+                return false;
+            }
+            trace_path = argv[++i];
+        } else if (arg == "--trace-stats")
+            print_stats = true;
+        else
+            argv[nb_args++] = argv[i];
+    }
+    argc = nb_args;
+    argv[argc] = nullptr;
+
+    process_name = argc > 0 ? argv[0] : "ZED sample";
+    size_t slash = process_name.find_last_of("/\\");
+    if (slash != std::string::npos) process_name = process_name.substr(slash + 1);
+
+    if (!trace_path.empty() || print_stats) {
+        start();
+        nameThread("main");
+        started = true;
+        std::cout << "[Sample] Tracing the stages of the loop" << (trace_path.empty() ? "" : ", trace written to " + trace_path) << std::endl;
+    }
+    return true;
+}
+
+const char* StageTrace::usage() {
+    return "[--trace <file.json>] [--trace-stats]";
+}
+
+void StageTrace::finish() {
+    if (!started) return;
+    started = false;
+    stop();
+    if (!trace_path.empty()) {
+        if (writeChromeTrace(trace_path, process_name))
+            std::cout << "[Sample] Trace written to " << trace_path << std::endl;
+        else
+            std::cout << "[Sample][Error] Cannot write the trace " << trace_path << std::endl;
+    }
+    std::cout << formatStats();
+}
+
+void StageTrace::start() {
+    auto& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mtx);
+    reg.origin = now();
+    recording.store(true, std::memory_order_relaxed);
+}
+
+void StageTrace::stop() {
+    recording.store(false, std::memory_order_relaxed);
+}
+
+void StageTrace::clear() {
+    auto& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mtx);
+    for (auto& thread : reg.threads) {
+        thread->head.store(0, std::memory_order_relaxed);
+        int nb = thread->nb_stages.load(std::memory_order_acquire);
+        for (int i = 0; i < nb; i++) thread->stages[i]->reset();
+    }
+}
+
+void StageTrace::record(const char* stage, uint64_t start_ns, uint64_t end_ns) {
+    // A span that ends once the recording is stopped is dropped, the export may be reading the rings
+    if (!enabled()) return;
+    ThreadRecord& thread = threadRecord();
+    uint64_t head = thread.head.load(std::memory_order_relaxed);
+    Span& span = thread.ring[head & RING_MASK];
+    span.stage = stage;
+    span.start = start_ns;
+    span.end = end_ns;
+    thread.head.store(head + 1, std::memory_order_release);
+    if (StageHistogram* histogram = thread.histogram(stage)) histogram->add(end_ns - start_ns);
+}
+
+void StageTrace::nameThread(const std::string& name) {
+    // Without tracing, the threads that never record a span have no record to allocate
+    if (!enabled()) return;
+    ThreadRecord& thread = threadRecord();
+    std::lock_guard<std::mutex> lock(registry().mtx);
+    thread.name = name;
+}
+
+std::vector<StageStats> StageTrace::stats() {
+    struct Merged {
+        const char* name;
+        uint64_t count = 0, sum = 0, min = UINT64_MAX, max = 0;
+        std::vector<uint64_t> buckets;
+    };
+    std::vector<Merged> merged;
+
+    auto& reg = registry();
+    {
+        std::lock_guard<std::mutex> lock(reg.mtx);
+        for (auto& thread : reg.threads) {
+            int nb = thread->nb_stages.load(std::memory_order_acquire);
+            for (int i = 0; i < nb; i++) {
+                const StageHistogram& histogram = *thread->stages[i];
+                // The same stage can be named by several literals of the same text
+                auto it = merged.begin();
+                while (it != merged.end() && strcmp(it->name, histogram.name) != 0) ++it;
+                if (it == merged.end()) {
+                    merged.emplace_back();
+                    it = merged.end() - 1;
+                    it->name = histogram.name;
+                    it->buckets.assign(NB_BUCKETS, 0);
+                }
+                it->count += histogram.count.load(std::memory_order_relaxed);
+                it->sum += histogram.sum.load(std::memory_order_relaxed);
+                it->min = std::min(it->min, histogram.min.load(std::memory_order_relaxed));
+                it->max = std::max(it->max, histogram.max.load(std::memory_order_relaxed));
+                for (int b = 0; b < NB_BUCKETS; b++) it->buckets[b] += histogram.buckets[b].load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    std::vector<StageStats> result;
+    for (auto& stage : merged) {
+        if (!stage.count) continue;
+        StageStats stats;
+        stats.name = stage.name;
+        stats.count = stage.count;
+        stats.mean = static_cast<double>(stage.sum) / stage.count;
+        stats.min = stage.min;
+        stats.max = stage.max;
+        // Value of the bucket holding the span of rank ceil(q * count), within the exact bounds
+        auto percentile = [&stage](double q) {
+            uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(q * stage.count + 0.999999));
+            uint64_t seen = 0;
+            for (int b = 0; b < NB_BUCKETS; b++) {
+                seen += stage.buckets[b];
+                if (seen >= rank) return std::min(stage.max, std::max(stage.min, bucketValue(b)));
+            }
+            return stage.max;
+        };
+        stats.p50 = percentile(0.50);
+        stats.p95 = percentile(0.95);
+        stats.p99 = percentile(0.99);
+        result.push_back(stats);
+    }
+    return result;
+}
+
+std::string StageTrace::formatStats() {
+    auto all = stats();
+    size_t name_width = 5;
+    for (auto& stage : all) name_width = std::max(name_width, stage.name.size());
+    std::ostringstream out;
+    char line[256];
+    snprintf(line, sizeof(line), "%-*s %10s %10s %10s %10s %10s %10s\n", static_cast<int>(name_width), "stage", "count", "mean", "p50", "p95", "p99", "max");
+    out << line;
+    for (auto& stage : all) {
+        snprintf(line, sizeof(line), "%-*s %10llu %10s %10s %10s %10s %10s\n", static_cast<int>(name_width), stage.name.c_str(),
+                static_cast<unsigned long long>(stage.count), formatTime(stage.mean).c_str(), formatTime(static_cast<double>(stage.p50)).c_str(),
+                formatTime(static_cast<double>(stage.p95)).c_str(), formatTime(static_cast<double>(stage.p99)).c_str(), formatTime(static_cast<double>(stage.max)).c_str());
+        out << line;
+    }
+    return out.str();
+}
+
+bool StageTrace::writeChromeTrace(const std::string& path, const std::string& process_name) {
+    std::ofstream file(path);
+    if (!file) return false;
+
+    // Complete events ("X"), in microseconds from the start of the recording
+    auto& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mtx);
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    file << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":" << jsonString(process_name.c_str()) << "}}";
+    char event[512];
+    for (auto& thread : reg.threads) {
+        std::string name = thread->name.empty() ? "thread " + std::to_string(thread->id) : thread->name;
+        file << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << thread->id << ",\"args\":{\"name\":" << jsonString(name.c_str()) << "}}";
+
+        uint64_t head = thread->head.load(std::memory_order_acquire);
+        uint64_t first = head > TRACE_CAPACITY ? head - TRACE_CAPACITY : 0;
+        for (uint64_t i = first; i < head; i++) {
+            const Span& span = thread->ring[i & RING_MASK];
+            double ts = (static_cast<double>(span.start) - static_cast<double>(reg.origin)) / 1e3;
+            double dur = static_cast<double>(span.end - span.start) / 1e3;
+            snprintf(event, sizeof(event), ",\n{\"name\":%s,\"cat\":\"stage\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                    jsonString(span.stage).c_str(), thread->id, ts, dur);
+            file << event;
+        }
+    }
+    file << "\n]}\n";
+    return static_cast<bool>(file);
+}
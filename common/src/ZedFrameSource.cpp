@@ -0,0 +1,114 @@
+#include "ZedFrameSource.hpp"
+
+#include <iostream>
+
+namespace {
+// Failed grabs in a row before a live source gives up
+const int MAX_GRAB_FAILURES = 100;
+
+bool toResolution(const std::string& name, sl::RESOLUTION& resolution) {
+    if (name == "HD2K") resolution = sl::RESOLUTION::HD2K;
+    else if (name == "HD1080") resolution = sl::RESOLUTION::HD1080;
+    else if (name == "HD720") resolution = sl::RESOLUTION::HD720;
+    else if (name == "VGA") resolution = sl::RESOLUTION::VGA;
+    else return false;
+    return true;
+}
+
+bool applyInput(const FrameSourceOptions& options, sl::InitParameters& init_parameters) {
+    switch (options.kind) {
+        case FRAME_SOURCE::CAMERA:
+            toResolution(options.resolution, init_parameters.camera_resolution);
+            return true;
+        case FRAME_SOURCE::SVO:
+            init_parameters.input.setFromSVOFile(options.path.c_str());
+            return true;
+        case FRAME_SOURCE::STREAM:
+            if (options.port) init_parameters.input.setFromStream(sl::String(options.ip.c_str()), options.port);
+            else init_parameters.input.setFromStream(sl::String(options.ip.c_str()));
+            return true;
+        default:
+            std::cout << "[Sample][Error] This sample needs a camera, a SVO file or a stream, not " << options.describe() << std::endl;
+            return false;
+    }
+}
+}
+
+bool applyFrameSource(const FrameSourceOptions& options, sl::InitParameters& init_parameters) {
+    // The sample grabs the camera itself: the options of the FrameSource readers would be ignored
+    if (options.max_frames >= 0 || options.prefetch > 0 || options.fps != FrameSourceOptions().fps) {
+        std::cout << "[Sample][Error] --frames, --prefetch and --fps are options of the samples reading a FrameSource, not of this one" << std::endl;
+        return false;
+    }
+    return applyInput(options, init_parameters);
+}
+
+ZedFrameSource::ZedFrameSource(const FrameSourceOptions& options_, const sl::InitParameters& init_parameters_)
+    : options(options_), init_parameters(init_parameters_) {
+}
+
+ZedFrameSource::~ZedFrameSource() {
+    close();
+}
+
+bool ZedFrameSource::open() {
+    if (!applyInput(options, init_parameters)) return false;
+    auto returned_state = zed.open(init_parameters);
+    if (returned_state != sl::ERROR_CODE::SUCCESS) {
+        std::cout << "[Sample][Error] Cannot open the " << options.describe() << ": " << sl::toString(returned_state) << std::endl;
+        return false;
+    }
+    if (tracking && init_parameters.depth_mode != sl::DEPTH_MODE::NONE) {
+        returned_state = zed.enablePositionalTracking();
+        if (returned_state != sl::ERROR_CODE::SUCCESS) {
+            std::cout << "[Sample][Error] Cannot enable the positional tracking: " << sl::toString(returned_state) << std::endl;
+            zed.close();
+            return false;
+        }
+    }
+    return true;
+}
+
+void ZedFrameSource::close() {
+    if (zed.isOpened()) zed.close();
+}
+
+int64_t ZedFrameSource::length() const {
+    return options.kind == FRAME_SOURCE::SVO ? zed.getSVONumberOfFrames() : -1;
+}
+
+FRAME_STATUS ZedFrameSource::readFrame(FrameBundle& frame) {
+    for (int failures = 0;; failures++) {
+        auto returned_state = zed.grab();
+        if (returned_state == sl::ERROR_CODE::SUCCESS) break;
+        if (returned_state == sl::ERROR_CODE::END_OF_SVOFILE_REACHED) return FRAME_STATUS::END;
+        if (failures == MAX_GRAB_FAILURES) {
+            std::cout << "[Sample][Error] Grab of the " << options.describe() << ": " << sl::toString(returned_state) << std::endl;
+            return FRAME_STATUS::FAILED;
+        }
+    }
+
+    // Retrieved in the buffers of the bundle, no copy
+    auto resolution = zed.getCameraInformation().camera_configuration.resolution;
+    const int width = static_cast<int>(resolution.width), height = static_cast<int>(resolution.height);
+    frame.image.allocate(width, height, 4, 1);
+    sl::Mat image(resolution, sl::MAT_TYPE::U8_C4, frame.image.data.data(), frame.image.step, sl::MEM::CPU);
+    zed.retrieveImage(image, sl::VIEW::LEFT, sl::MEM::CPU);
+
+    if (depth && init_parameters.depth_mode != sl::DEPTH_MODE::NONE) {
+        frame.depth.allocate(width, height, 1, 4);
+        sl::Mat depth(resolution, sl::MAT_TYPE::F32_C1, frame.depth.data.data(), frame.depth.step, sl::MEM::CPU);
+        zed.retrieveMeasure(depth, sl::MEASURE::DEPTH, sl::MEM::CPU);
+    } else
+        frame.depth.release();
+
+    frame.timestamp = zed.getTimestamp(sl::TIME_REFERENCE::IMAGE).getNanoseconds();
+    frame.pose.valid = tracking && zed.getPosition(pose, sl::REFERENCE_FRAME::WORLD) == sl::POSITIONAL_TRACKING_STATE::OK;
+    if (frame.pose.valid) {
+        auto translation = pose.getTranslation();
+        auto orientation = pose.getOrientation();
+        for (int i = 0; i < 3; i++) frame.pose.translation[i] = translation[i];
+        for (int i = 0; i < 4; i++) frame.pose.orientation[i] = orientation[i];
+    }
+    return FRAME_STATUS::FRAME;
+}
@@ -0,0 +1,69 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+/***********************************************************************
+ ** Frames of the synthetic source at the ZED resolutions, read on    **
+ ** demand and through a PrefetchSource. The input of every sample    **
+ ** runs with its --source synthetic option, no camera nor file.      **
+ ***********************************************************************/
+
+#include <list>
+#include <memory>
+#include <string>
+
+#include "FrameSource.hpp"
+#include "BenchSuite.hpp"
+
+int main(int argc, char **argv) {
+    BenchSuite suite("ZED_Frame_Source_Bench");
+
+    struct { const char* name; int width, height; } resolutions[] = {
+        {"VGA", 672, 376}, {"HD720", 1280, 720}, {"HD1080", 1920, 1080}
+    };
+    // Sources and bundles kept alive by the lambdas of the suite
+    std::list<std::unique_ptr<FrameSource>> sources;
+    std::list<FrameBundle> frames;
+
+    for (auto& res : resolutions) {
+        double frame_bytes = res.width * res.height * (4. + 4.);
+        for (int prefetch : {0, 3}) {
+            FrameSourceOptions options;
+            options.kind = FRAME_SOURCE::SYNTHETIC;
+            options.width = res.width;
+            options.height = res.height;
+            options.prefetch = prefetch;
+            sources.push_back(FrameSource::create(options));
+            auto& source = *sources.back();
+            frames.emplace_back();
+            auto& frame = frames.back();
+            bool valid = source.open() && source.read(frame) == FRAME_STATUS::FRAME;
+            suite.check(valid && frame.image.width == res.width && frame.depth.height == res.height, std::string("synthetic frame at ") + res.name);
+
+            std::string name = std::string(prefetch ? "read/prefetch/" : "read/synthetic/") + res.name;
+            suite.add(name, [&source, &frame]() {
+                doNotOptimize(source.read(frame));
+            }).bytes(frame_bytes);
+        }
+    }
+
+    int status = suite.run(argc, argv);
+    for (auto& source : sources) source->close();
+    return status;
+}
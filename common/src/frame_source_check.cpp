@@ -0,0 +1,352 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+/*****************************************************************************************
+ ** Check of the frame sources of the samples, CPU only: no camera, ZED SDK nor CUDA.    **
+ ** The command line parser is run on the inputs of the samples, the synthetic frames    **
+ ** are checked for determinism, a raw container is written then read back, and the     **
+ ** prefetch is compared with the direct reads. With OpenCV, an image directory as       **
+ ** written by the SVO export is read back too.                                          **
+ *****************************************************************************************/
+
+#ifdef FRAME_SOURCE_OPENCV
+#include <opencv2/opencv.hpp>
+#endif
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "FrameSource.hpp"
+
+#ifndef _WIN32
+#include <sys/stat.h>
+#endif
+
+using namespace std;
+
+static const int WIDTH = 320, HEIGHT = 180;
+
+static bool check(bool condition, const string& what) {
+    printf("  %-60s %s\n", what.c_str(), condition ? "ok" : "FAILED");
+    return condition;
+}
+
+// Command line of a sample, parsed by new options
+static bool parseArgs(FrameSourceOptions& options, vector<string> args, int& argc, vector<char*>& argv) {
+    args.insert(args.begin(), "ZED_Sample");
+    static vector<string> storage;
+    storage = args;
+    argv.clear();
+    for (auto& arg : storage) argv.push_back(&arg[0]);
+    argv.push_back(nullptr);
+    argc = static_cast<int>(storage.size());
+    options = FrameSourceOptions();
+    return options.parse(argc, argv.data());
+}
+
+static bool sameImage(const FrameImage& a, const FrameImage& b) {
+    return a.width == b.width && a.height == b.height && a.channels == b.channels && a.data == b.data;
+}
+
+static bool sameFrame(const FrameBundle& a, const FrameBundle& b) {
+    return a.timestamp == b.timestamp && sameImage(a.image, b.image) && sameImage(a.depth, b.depth) && a.pose.valid == b.pose.valid
+        && !memcmp(a.pose.translation, b.pose.translation, sizeof(a.pose.translation))
+        && !memcmp(a.pose.orientation, b.pose.orientation, sizeof(a.pose.orientation));
+}
+
+// Stand-in for the processing of a sample
+static uint64_t process(const FrameBundle& frame, int work_us) {
+    uint64_t sum = 0;
+    for (size_t i = 1; i < frame.image.data.size(); i += 4) sum += frame.image.data[i];
+    this_thread::sleep_for(chrono::microseconds(work_us));
+    return sum;
+}
+
+int main(int argc, char **argv) {
+    int nb_frames = 60;
+    for (int i = 1; i < argc; i++) {
+        string arg(argv[i]);
+        if (arg == "--frames" && i + 1 < argc) nb_frames = max(8, atoi(argv[++i]));
+        else {
+            printf("Usage : ./ZED_Frame_Source_Check [--frames 60]\n");
+            return EXIT_FAILURE;
+        }
+    }
+    bool ok = true;
+
+    printf("Command line\n");
+    {
+        FrameSourceOptions options;
+        int sample_argc;
+        vector<char*> sample_argv;
+        ok &= check(parseArgs(options, {"path/to/file.svo", "extra"}, sample_argc, sample_argv) && options.kind == FRAME_SOURCE::SVO
+            && options.path == "path/to/file.svo", "SVO input argument");
+        ok &= check(sample_argc == 2 && string(sample_argv[1]) == "extra", "input removed, sample arguments kept");
+        ok &= check(parseArgs(options, {"192.168.1.12:30002"}, sample_argc, sample_argv) && options.kind == FRAME_SOURCE::STREAM
+            && options.ip == "192.168.1.12" && options.port == 30002, "IP:port input argument");
+        ok &= check(parseArgs(options, {"10.0.0.1"}, sample_argc, sample_argv) && options.kind == FRAME_SOURCE::STREAM && options.port == 0,
+            "IP input argument, default port");
+        ok &= check(parseArgs(options, {"HD720"}, sample_argc, sample_argv) && options.kind == FRAME_SOURCE::CAMERA && options.resolution == "HD720",
+            "resolution input argument");
+        ok &= check(parseArgs(options, {"30000"}, sample_argc, sample_argv) && options.kind == FRAME_SOURCE::CAMERA && sample_argc == 2,
+            "other argument left to the sample");
+        for (auto ip : {"256.1.1.1", "1.2.3", "1.2.3.4.5", "1.2.3.4:", "1.2.3.4:70000", "1.2.3.4:12a", "a.b.c.d"}) {
+            string parsed;
+            int port = 0;
+            ok &= check(!parseIPv4(ip, parsed, port), string("invalid IP ") + ip + " rejected");
+        }
+        ok &= check(parseArgs(options, {"--frames", "10", "--source", "synthetic:640x360", "--prefetch", "3", "HD720"}, sample_argc, sample_argv)
+            && options.kind == FRAME_SOURCE::SYNTHETIC && options.width == 640 && options.height == 360 && options.max_frames == 10 && options.prefetch == 3
+            && sample_argc == 2, "--source, --frames and --prefetch, input argument kept after --source");
+        ok &= check(parseArgs(options, {"--source", "images:exported/"}, sample_argc, sample_argv) && options.kind == FRAME_SOURCE::IMAGES
+            && options.path == "exported/", "--source images");
+        ok &= check(parseArgs(options, {"--source", "raw:file.zraw"}, sample_argc, sample_argv) && options.kind == FRAME_SOURCE::RAW, "--source raw");
+        ok &= check(parseArgs(options, {"--source", "camera:HD1080"}, sample_argc, sample_argv) && options.usesCamera() && options.resolution == "HD1080",
+            "--source camera");
+        for (auto spec : {"camera:HD4K", "svo:", "stream:1.2.3", "synthetic:640", "synthetic:8x8", "webcam"})
+            ok &= check(!parseArgs(options, {"--source", spec}, sample_argc, sample_argv), string("invalid source ") + spec + " rejected");
+        ok &= check(!parseArgs(options, {"--frames", "0"}, sample_argc, sample_argv), "--frames 0 rejected");
+        options.kind = FRAME_SOURCE::CAMERA;
+        ok &= check(FrameSource::create(options) == nullptr, "camera not available without the ZED SDK");
+    }
+
+    printf("Synthetic frames\n");
+    {
+        SyntheticSource a(WIDTH, HEIGHT), b(WIDTH, HEIGHT);
+        a.open();
+        b.open();
+        FrameBundle frame_a, frame_b;
+        bool same = true, increasing = true, square = true;
+        uint64_t last_timestamp = 0;
+        for (int i = 0; i < nb_frames; i++) {
+            same &= a.read(frame_a) == FRAME_STATUS::FRAME && b.read(frame_b) == FRAME_STATUS::FRAME && sameFrame(frame_a, frame_b);
+            increasing &= frame_a.timestamp > last_timestamp && frame_a.index == static_cast<uint64_t>(i);
+            last_timestamp = frame_a.timestamp;
+            int x, y, size;
+            a.squareAt(i, x, y, size);
+            const int cx = x + size / 2, cy = y + size / 2;
+            square &= frame_a.image.row<uint8_t>(cy)[cx * 4 + 2] == 255 && frame_a.depth.row<float>(cy)[cx] == 1000.f
+                && frame_a.depth.row<float>(0)[0] == 2000.f;
+        }
+        ok &= check(same, "two sources give the same frames");
+        ok &= check(increasing, "indices and timestamps increase");
+        ok &= check(square && frame_a.pose.valid, "square at 1 m on a wall at 2 m, pose");
+
+        FrameSourceOptions options;
+        options.kind = FRAME_SOURCE::SYNTHETIC;
+        options.max_frames = 5;
+        auto limited = FrameSource::create(options);
+        int count = 0;
+        bool opened = limited && limited->open();
+        while (opened && limited->read(frame_a) == FRAME_STATUS::FRAME) count++;
+        ok &= check(count == 5 && limited->read(frame_a) == FRAME_STATUS::END, "--frames ends the source");
+    }
+
+    printf("Raw container\n");
+    {
+        const string path = "zed_frame_source_check.zraw";
+        for (int format = 0; format < 2; format++) {
+            ContainerParameters params;
+            params.width = WIDTH;
+            params.height = HEIGHT;
+            params.depth_format = format ? DEPTH_FORMAT::U16 : DEPTH_FORMAT::F32;
+            params.depth_unit = format ? 0.5f : 1.f;
+            const string name = format ? "u16:0.5" : "f32";
+
+            // One slot left unwritten, as a frame the export could not grab
+            SyntheticSource synthetic(WIDTH, HEIGHT);
+            synthetic.open();
+            vector<FrameBundle> written;
+            FrameContainerWriter writer;
+            bool created = writer.create(path, params, nb_frames);
+            vector<uint8_t> scratch;
+            for (int i = 0; created && i < nb_frames; i++) {
+                FrameBundle frame;
+                synthetic.read(frame);
+                if (i == 3) continue;
+                created &= writer.writeFrame(i, frame.timestamp, frame.image.data.data(), frame.image.step,
+                    reinterpret_cast<const float*>(frame.depth.data.data()), frame.depth.step, scratch);
+                written.push_back(std::move(frame));
+            }
+            writer.close();
+            ok &= check(created, name + ": container written");
+
+            ContainerSource source(path);
+            FrameBundle frame;
+            size_t nb_read = 0;
+            bool same = source.open();
+            while (same && source.read(frame) == FRAME_STATUS::FRAME) {
+                same &= nb_read < written.size() && frame.timestamp == written[nb_read].timestamp && sameImage(frame.image, written[nb_read].image);
+                // 1000 and 2000 mm are multiples of the unit, exact in both formats
+                same &= sameImage(frame.depth, written[nb_read].depth);
+                nb_read++;
+            }
+            source.close();
+            ok &= check(same && nb_read == written.size(), name + ": frames read back, unwritten slot skipped");
+        }
+
+        // Truncated and corrupted copies of the last container are refused, no access out of the mapping
+        vector<char> bytes;
+        {
+            ifstream in(path, ios::binary | ios::ate);
+            bytes.resize(static_cast<size_t>(in.tellg()));
+            in.seekg(0);
+            in.read(bytes.data(), bytes.size());
+        }
+        auto opens = [&path](const vector<char>& content) {
+            ofstream(path, ios::binary | ios::trunc).write(content.data(), content.size());
+            FrameContainerReader reader;
+            return reader.open(path);
+        };
+        ContainerHeader header;
+        memcpy(&header, bytes.data(), sizeof(header));
+        ok &= check(opens(bytes), "container copy opened");
+        ok &= check(!opens(vector<char>(bytes.begin(), bytes.begin() + bytes.size() / 2)), "truncated container rejected");
+        ok &= check(!opens(vector<char>(bytes.begin(), bytes.begin() + header.index_offset + 16)), "container truncated in its index rejected");
+        vector<char> corrupted = bytes;
+        uint64_t capacity = 1ull << 60;
+        memcpy(corrupted.data() + offsetof(ContainerHeader, capacity), &capacity, sizeof(capacity));
+        ok &= check(!opens(corrupted), "index larger than the file rejected");
+        corrupted = bytes;
+        uint32_t image_size = static_cast<uint32_t>(header.frame_stride);
+        memcpy(corrupted.data() + header.index_offset + offsetof(FrameIndexEntry, image_size), &image_size, sizeof(image_size));
+        ok &= check(!opens(corrupted), "frame larger than its slot rejected");
+        remove(path.c_str());
+        ok &= check(!ContainerSource(path).open(), "missing container rejected");
+
+#ifndef _WIN32
+        // Compressed containers are sparse: 64 GB of worst case slots, only the written pages on disk
+        {
+            MappedFile sparse;
+            bool created = sparse.create(path, 64ull << 30, false);
+            if (created) memset(sparse.data() + (32ull << 30), 1, 4096);
+            struct stat info;
+            created &= stat(path.c_str(), &info) == 0 && static_cast<uint64_t>(info.st_blocks) * 512 < (16 << 20);
+            sparse.close();
+            ok &= check(created, "sparse file: 64 GB, only the written pages allocated");
+            remove(path.c_str());
+        }
+#endif
+    }
+
+    printf("Prefetch, %d frames\n", nb_frames);
+    {
+        // Files: every frame, in order, the buffers of the caller are recycled
+        PrefetchSource prefetch(unique_ptr<FrameSource>(new SyntheticSource(WIDTH, HEIGHT)), 4, false);
+        SyntheticSource direct(WIDTH, HEIGHT);
+        bool same = prefetch.open() && direct.open();
+        FrameBundle frame, expected;
+        int count = 0;
+        while (same && prefetch.read(frame) == FRAME_STATUS::FRAME && count < nb_frames) {
+            same &= direct.read(expected) == FRAME_STATUS::FRAME && sameFrame(frame, expected) && frame.index == static_cast<uint64_t>(count);
+            count++;
+        }
+        prefetch.close();
+        ok &= check(same && count == nb_frames && prefetch.droppedFrames() == 0, "file source: same frames as the direct reads");
+
+        PrefetchSource ended(unique_ptr<FrameSource>(new SyntheticSource(WIDTH, HEIGHT)), 2, false);
+        ended.inner().setMaxFrames(7);
+        count = 0;
+        bool opened = ended.open();
+        while (opened && ended.read(frame) == FRAME_STATUS::FRAME) count++;
+        ok &= check(count == 7 && ended.read(frame) == FRAME_STATUS::END, "end of the source after the queued frames");
+
+        // Live: a late sample gets the newest frames
+        PrefetchSource live(unique_ptr<FrameSource>(new SyntheticSource(WIDTH, HEIGHT)), 2, true);
+        live.open();
+        uint64_t last_timestamp = 0;
+        bool increasing = true;
+        for (int i = 0; i < 10; i++) {
+            live.read(frame);
+            increasing &= frame.timestamp > last_timestamp;
+            last_timestamp = frame.timestamp;
+            this_thread::sleep_for(chrono::milliseconds(5));
+        }
+        live.close();
+        ok &= check(increasing && live.droppedFrames() > 0, "live source: late frames dropped, newest first");
+
+        // Read and processing overlap: 2 ms of work per frame
+        const int work_us = 2000;
+        double seconds[2];
+        for (int prefetched = 0; prefetched < 2; prefetched++) {
+            FrameSourceOptions options;
+            options.kind = FRAME_SOURCE::SYNTHETIC;
+            options.width = 1280;
+            options.height = 720;
+            options.max_frames = nb_frames;
+            options.prefetch = prefetched ? 4 : 0;
+            auto source = FrameSource::create(options);
+            auto start = chrono::steady_clock::now();
+            uint64_t sum = 0;
+            bool opened = source->open();
+            while (opened && source->read(frame) == FRAME_STATUS::FRAME) sum += process(frame, work_us);
+            seconds[prefetched] = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            printf("  HD720 %-10s %6.2f ms/frame (checksum %llu)\n", prefetched ? "prefetch" : "direct", 1000. * seconds[prefetched] / nb_frames,
+                static_cast<unsigned long long>(sum));
+            source->close();
+        }
+    }
+
+#ifdef FRAME_SOURCE_OPENCV
+    printf("Image directory\n");
+    {
+        // Layout of the SVO export, mode 4: left%06d.png and 16 bits depth%06d.png in millimeters
+        const string directory = ".";
+        SyntheticSource synthetic(WIDTH, HEIGHT);
+        synthetic.open();
+        vector<FrameBundle> written(4);
+        for (int i = 0; i < 4; i++) {
+            synthetic.read(written[i]);
+            char name[32];
+            snprintf(name, sizeof(name), "%06d.png", i);
+            cv::Mat depth16;
+            toCvMat(written[i].depth).convertTo(depth16, CV_16UC1);
+            cv::imwrite(directory + "/left" + name, toCvMat(written[i].image));
+            cv::imwrite(directory + "/depth" + name, depth16);
+        }
+        ImageSequenceSource source(directory);
+        FrameBundle frame;
+        int count = 0;
+        bool same = source.open() && source.length() == 4;
+        while (same && source.read(frame) == FRAME_STATUS::FRAME) {
+            same &= sameImage(frame.image, written[count].image) && sameImage(frame.depth, written[count].depth);
+            count++;
+        }
+        ok &= check(same && count == 4, "left and depth images read back");
+        for (int i = 0; i < 4; i++) {
+            char name[32];
+            snprintf(name, sizeof(name), "%06d.png", i);
+            remove((directory + "/left" + name).c_str());
+            remove((directory + "/depth" + name).c_str());
+        }
+    }
+#endif
+
+    printf(ok ? "PASSED\n" : "FAILED\n");
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
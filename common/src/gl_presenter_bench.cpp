@@ -0,0 +1,324 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+/*****************************************************************************************
+ ** Headless benchmark of the GLPresenter upload paths: no window nor display, the GL    **
+ ** context is an EGL surfaceless one (Mesa llvmpipe on hosts without GPU).              **
+ ** Each frame is uploaded then drawn in an offscreen framebuffer, the throughput of     **
+ ** upload + draw is reported for each path at the ZED resolutions. The texture content  **
+ ** is read back and checked for each path.                                              **
+ ** The channel paths of ImageFormat are then compared on BGRA and GRAY frames at HD2K:    **
+ ** upload + draw at full size, the drawn image is read back and checked against the     **
+ ** RGBA conversion of the frame.                                                        **
+ *****************************************************************************************/
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include "GLPresenter.hpp"
+
+using namespace std;
+
+static bool createHeadlessContext() {
+    EGLDisplay display = EGL_NO_DISPLAY;
+    // Surfaceless platform first: no X server needed
+    auto getPlatformDisplay = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+    if (getPlatformDisplay) display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+    if (display == EGL_NO_DISPLAY) display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    EGLint major = 0, minor = 0;
+    if (display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor) || !eglBindAPI(EGL_OPENGL_API)) return false;
+
+    const EGLint config_attributes[] = {EGL_SURFACE_TYPE, EGL_PBUFFER_BIT, EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE};
+    EGLConfig config = nullptr;
+    EGLint nb_configs = 0;
+    eglChooseConfig(display, config_attributes, &config, 1, &nb_configs);
+    // Compatibility profile: the samples draw with the fixed pipeline
+    const EGLint context_attributes[] = {EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_COMPATIBILITY_PROFILE_BIT, EGL_NONE};
+    EGLContext context = eglCreateContext(display, nb_configs ? config : nullptr, EGL_NO_CONTEXT, context_attributes);
+    return context != EGL_NO_CONTEXT && eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context);
+}
+
+// Frame of the given index, 4 bytes per pixel, step_pixels between rows
+static void fillFrame(vector<uint8_t>& frame, int width, int height, int step_pixels, int index) {
+    for (int y = 0; y < height; y++) {
+        uint8_t* row = frame.data() + static_cast<size_t>(y) * step_pixels * 4;
+        for (int x = 0; x < width; x++) {
+            row[x * 4] = static_cast<uint8_t>(x + index);
+            row[x * 4 + 1] = static_cast<uint8_t>(y);
+            row[x * 4 + 2] = static_cast<uint8_t>(index * 7);
+            row[x * 4 + 3] = 255;
+        }
+    }
+}
+
+static void drawQuad(GLuint texture) {
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glBegin(GL_QUADS);
+    glTexCoord2f(0.0, 1.0);
+    glVertex2f(-1.0, -1.0);
+    glTexCoord2f(1.0, 1.0);
+    glVertex2f(1.0, -1.0);
+    glTexCoord2f(1.0, 0.0);
+    glVertex2f(1.0, 1.0);
+    glTexCoord2f(0.0, 0.0);
+    glVertex2f(-1.0, 1.0);
+    glEnd();
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+// Fragment shader applying the swizzle of the format, for the SHADER channel path
+static GLuint createSwizzleProgram(const UploadFormat& format) {
+    string channels;
+    for (int i = 0; i < 4; i++) {
+        switch (format.swizzle[i]) {
+            case GL_RED: channels += "color.r"; break;
+            case GL_GREEN: channels += "color.g"; break;
+            case GL_BLUE: channels += "color.b"; break;
+            case GL_ALPHA: channels += "color.a"; break;
+            case GL_ZERO: channels += "0.0"; break;
+            default: channels += "1.0"; break;
+        }
+        if (i < 3) channels += ", ";
+    }
+    const string source = "uniform sampler2D texImage;\n"
+            " void main() {\n"
+            " vec4 color = texture2D(texImage, gl_TexCoord[0].st);\n"
+            " gl_FragColor = vec4(" + channels + ");\n}";
+    const char* source_ptr = source.c_str();
+    GLuint shader = glCreateShader(GL_FRAGMENT_SHADER);
+    glShaderSource(shader, 1, &source_ptr, NULL);
+    glCompileShader(shader);
+    GLuint program = glCreateProgram();
+    glAttachShader(program, shader);
+    glLinkProgram(program);
+    glDeleteShader(shader);
+    GLint link_status = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &link_status);
+    if (link_status != GL_TRUE) {
+        glDeleteProgram(program);
+        return 0;
+    }
+    glUseProgram(program);
+    glUniform1i(glGetUniformLocation(program, "texImage"), 0);
+    glUseProgram(0);
+    return program;
+}
+
+struct Result {
+    double ms_per_frame = 0.;
+    double upload_ms = 0.;
+    uint64_t stalls = 0;
+    bool valid = false;
+};
+
+static Result run(GLPresenter::Path path, int width, int height, int nb_frames) {
+    Result result;
+    GLPresenter presenter;
+    if (!presenter.init(width, height, path)) return result;
+
+    // Offscreen target of the draws, a quarter of the frame as a display window would be
+    GLuint fbo = 0, color = 0;
+    const int view_w = max(1, width / 2), view_h = max(1, height / 2);
+    glGenTextures(1, &color);
+    glBindTexture(GL_TEXTURE_2D, color);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, view_w, view_h, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glGenFramebuffers(1, &fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, color, 0);
+    glViewport(0, 0, view_w, view_h);
+    glEnable(GL_TEXTURE_2D);
+
+    // Rows padded as the sl::Mat ones
+    const int step_pixels = (width + 63) / 64 * 64;
+    const int nb_sources = 4;
+    vector<vector<uint8_t>> frames(nb_sources, vector<uint8_t>(static_cast<size_t>(step_pixels) * height * 4));
+    for (int i = 0; i < nb_sources; i++) fillFrame(frames[i], width, height, step_pixels, i);
+
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < nb_frames; i++) {
+        presenter.uploadHost(frames[i % nb_sources].data(), step_pixels * 4);
+        drawQuad(presenter.texture());
+        glFlush();
+    }
+    glFinish();
+    result.ms_per_frame = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count() / nb_frames;
+    result.upload_ms = presenter.stats().upload_ms / nb_frames;
+    result.stalls = presenter.stats().stalls;
+
+    // The texture drawn last holds the last frame, without the padding of its rows
+    vector<uint8_t> pixels(static_cast<size_t>(width) * height * 4), expected(pixels.size());
+    glBindTexture(GL_TEXTURE_2D, presenter.texture());
+    glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+    glBindTexture(GL_TEXTURE_2D, 0);
+    const vector<uint8_t>& last = frames[(nb_frames - 1) % nb_sources];
+    for (int y = 0; y < height; y++)
+        memcpy(expected.data() + static_cast<size_t>(y) * width * 4, last.data() + static_cast<size_t>(y) * step_pixels * 4, width * 4);
+    result.valid = pixels == expected && glGetError() == GL_NO_ERROR;
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glDeleteFramebuffers(1, &fbo);
+    glDeleteTextures(1, &color);
+    return result;
+}
+
+// RGBA value of a pixel of a frame
+static void toRGBA(PixelFormat source, const uint8_t* pixel, uint8_t* rgba) {
+    if (source == PixelFormat::GRAY) {
+        rgba[0] = rgba[1] = rgba[2] = pixel[0];
+        rgba[3] = 255;
+    } else if (source == PixelFormat::BGRA) {
+        rgba[0] = pixel[2];
+        rgba[1] = pixel[1];
+        rgba[2] = pixel[0];
+        rgba[3] = pixel[3];
+    } else
+        memcpy(rgba, pixel, 4);
+}
+
+// Upload + draw of frames of the format at full size, the drawn image must be their RGBA conversion
+static Result runChannels(GLPresenter::Path path, const UploadFormat& format, int width, int height, int nb_frames) {
+    Result result;
+    GLPresenter presenter;
+    if (!presenter.init(width, height, path, format)) return result;
+    GLuint program = 0;
+    if (format.channels == ChannelPath::SHADER && !(program = createSwizzleProgram(format))) return result;
+
+    GLuint fbo = 0, color = 0;
+    glGenTextures(1, &color);
+    glBindTexture(GL_TEXTURE_2D, color);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glGenFramebuffers(1, &fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, color, 0);
+    glViewport(0, 0, width, height);
+    glEnable(GL_TEXTURE_2D);
+
+    const size_t pixel_bytes = pixelBytes(format.source);
+    const size_t step_bytes = (width * pixel_bytes + 255) / 256 * 256;
+    const int nb_sources = 4;
+    vector<vector<uint8_t>> frames(nb_sources, vector<uint8_t>(step_bytes * height));
+    for (int i = 0; i < nb_sources; i++)
+        for (int y = 0; y < height; y++)
+            for (size_t b = 0; b < width * pixel_bytes; b++)
+                frames[i][y * step_bytes + b] = static_cast<uint8_t>(b * 3 + y + i * 11 + (b % 4 == 3 ? 128 : 0));
+
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < nb_frames; i++) {
+        presenter.uploadHost(frames[i % nb_sources].data(), step_bytes);
+        // The draw of the SHADER path switches of program at each frame
+        if (program) glUseProgram(program);
+        drawQuad(presenter.texture());
+        if (program) glUseProgram(0);
+        glFlush();
+    }
+    glFinish();
+    result.ms_per_frame = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count() / nb_frames;
+    result.upload_ms = presenter.stats().upload_ms / nb_frames;
+    result.stalls = presenter.stats().stalls;
+
+    // The quad is drawn upside down: the first row read is the last one of the frame
+    vector<uint8_t> pixels(static_cast<size_t>(width) * height * 4);
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+    const vector<uint8_t>& last = frames[(nb_frames - 1) % nb_sources];
+    result.valid = glGetError() == GL_NO_ERROR;
+    for (int y = 0; y < height && result.valid; y++) {
+        for (int x = 0; x < width && result.valid; x++) {
+            uint8_t expected[4];
+            toRGBA(format.source, last.data() + (height - 1 - y) * step_bytes + x * pixel_bytes, expected);
+            result.valid = memcmp(expected, pixels.data() + (static_cast<size_t>(y) * width + x) * 4, 4) == 0;
+        }
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glDeleteFramebuffers(1, &fbo);
+    glDeleteTextures(1, &color);
+    if (program) glDeleteProgram(program);
+    return result;
+}
+
+int main(int argc, char **argv) {
+    int nb_frames = 200;
+    for (int i = 1; i < argc; i++) {
+        string arg(argv[i]);
+        if (arg == "--frames" && i + 1 < argc) nb_frames = max(1, atoi(argv[++i]));
+        else {
+            printf("Usage : ./ZED_GL_Presenter_Bench [--frames 200]\n");
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (!createHeadlessContext() || glewInit() != GLEW_OK) {
+        printf("[Sample][Error] Cannot create a headless OpenGL context\n");
+        return EXIT_FAILURE;
+    }
+    printf("%s, OpenGL %s, %d frames\n", glGetString(GL_RENDERER), glGetString(GL_VERSION), nb_frames);
+    printf("Host path of this context: %s\n", GLPresenter::pathName(GLPresenter::hostPath()));
+
+    struct { const char* name; int width, height; } resolutions[] = {
+        {"VGA", 672, 376}, {"HD720", 1280, 720}, {"HD1080", 1920, 1080}, {"HD2K", 2208, 1242}
+    };
+    const GLPresenter::Path paths[] = {GLPresenter::Path::DIRECT, GLPresenter::Path::MAPPED_PBO, GLPresenter::Path::PERSISTENT_PBO};
+    bool ok = true;
+    printf("  %-8s %-22s %10s %10s %10s %8s %s\n", "", "path", "frame", "upload", "MB/s", "stalls", "content");
+    for (auto& res : resolutions) {
+        for (auto path : paths) {
+            Result result = run(path, res.width, res.height, nb_frames);
+            const double megabytes = res.width * res.height * 4 / 1e6;
+            printf("  %-8s %-22s %7.2f ms %7.2f ms %10.0f %8llu %s\n", res.name, GLPresenter::pathName(path), result.ms_per_frame,
+                    result.upload_ms, megabytes / (result.ms_per_frame / 1e3), static_cast<unsigned long long>(result.stalls),
+                    result.valid ? "identical" : "MISMATCH");
+            ok &= result.valid;
+        }
+    }
+
+    // Channel paths at HD2K, with the host path of the context and without pixel buffer
+    const int width = 2208, height = 1242;
+    const GLCapabilities capabilities = GLCapabilities::current();
+    const ChannelPath channel_paths[] = {ChannelPath::SWIZZLE, ChannelPath::UPLOAD_FORMAT, ChannelPath::CPU_CONVERSION, ChannelPath::SHADER};
+    printf("\nHD2K frames, channels in RGBA order (negotiated path marked *)\n");
+    printf("  %-6s %-22s %-16s %10s %10s %10s %s\n", "", "path", "channels", "frame", "upload", "MB/s", "content");
+    for (auto source : {PixelFormat::BGRA, PixelFormat::GRAY}) {
+        const ChannelPath negotiated = negotiateUpload(source, false, capabilities).channels;
+        for (auto path : {GLPresenter::hostPath(), GLPresenter::Path::DIRECT}) {
+            for (auto channels : channel_paths) {
+                UploadFormat format;
+                if (!makeUploadFormat(source, channels, format)) continue;
+                if (channels == ChannelPath::SWIZZLE && !capabilities.texture_swizzle) continue;
+                Result result = runChannels(path, format, width, height, nb_frames);
+                const double megabytes = width * height * pixelBytes(source) / 1e6;
+                printf("  %-6s %-22s %-15s%s %7.2f ms %7.2f ms %10.0f %s\n", pixelFormatName(source), GLPresenter::pathName(path),
+                        channelPathName(channels), channels == negotiated ? "*" : " ", result.ms_per_frame, result.upload_ms,
+                        megabytes / (result.ms_per_frame / 1e3), result.valid ? "identical" : "MISMATCH");
+                ok &= result.valid;
+            }
+        }
+    }
+    printf("%s\n", ok ? "PASSED" : "FAILED");
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
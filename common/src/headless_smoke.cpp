@@ -0,0 +1,214 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+/*****************************************************************************************
+ ** Smoke test of the display modes of the samples, CPU only: no display, ZED SDK, GL    **
+ ** nor CUDA. Synthetic BGRA frames go through the loop of the samples (DisplayMode) in  **
+ ** each mode, the frames rendered are counted and the results of each frame are sent    **
+ ** to each sink (file, shared memory, callback), then read back and checked.            **
+ *****************************************************************************************/
+
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "DisplayMode.hpp"
+
+using namespace std;
+
+static const int WIDTH = 672, HEIGHT = 376;
+
+// Frame of the given index, BGRA
+static void fillFrame(vector<uint8_t>& frame, int index) {
+    for (int y = 0; y < HEIGHT; y++) {
+        uint8_t* row = frame.data() + static_cast<size_t>(y) * WIDTH * 4;
+        for (int x = 0; x < WIDTH; x++) {
+            row[x * 4] = static_cast<uint8_t>(x + index);
+            row[x * 4 + 1] = static_cast<uint8_t>(y);
+            row[x * 4 + 2] = static_cast<uint8_t>(index * 7);
+            row[x * 4 + 3] = 255;
+        }
+    }
+}
+
+// Stand-in for the processing of a sample: mean of the green channel
+static string process(const vector<uint8_t>& frame) {
+    uint64_t sum = 0;
+    for (size_t i = 1; i < frame.size(); i += 4) sum += frame[i];
+    return "mean_g=" + to_string(sum / (frame.size() / 4));
+}
+
+static bool check(bool condition, const string& what) {
+    printf("  %-56s %s\n", what.c_str(), condition ? "ok" : "FAILED");
+    return condition;
+}
+
+// Loop of a sample on nb_frames synthetic frames, returns the number of frames rendered
+static int runLoop(DisplayMode& display, int nb_frames, bool with_image) {
+    vector<uint8_t> frame(static_cast<size_t>(WIDTH) * HEIGHT * 4);
+    int nb_rendered = 0;
+    while (display.nextFrame() && display.frameCount() < static_cast<uint64_t>(nb_frames)) {
+        const int index = static_cast<int>(display.frameCount());
+        fillFrame(frame, index);
+        FrameResult result;
+        result.timestamp = 1000000ull * index;
+        result.text = process(frame);
+        if (with_image) {
+            result.image = frame.data();
+            result.width = WIDTH;
+            result.height = HEIGHT;
+            result.channels = 4;
+            result.step = static_cast<size_t>(WIDTH) * 4;
+        }
+        if (display.renderFrame()) nb_rendered++;
+        if (display.hasSink()) display.publish(result);
+    }
+    return nb_rendered;
+}
+
+// Command line of a sample, parsed by a new DisplayMode
+static bool parseArgs(DisplayMode& display, vector<string> args, int& argc, vector<char*>& argv) {
+    args.insert(args.begin(), "ZED_Sample");
+    static vector<string> storage;
+    storage = args;
+    argv.clear();
+    for (auto& arg : storage) argv.push_back(&arg[0]);
+    argv.push_back(nullptr);
+    argc = static_cast<int>(storage.size());
+    return display.parse(argc, argv.data());
+}
+
+int main(int argc, char **argv) {
+    int nb_frames = 120;
+    for (int i = 1; i < argc; i++) {
+        string arg(argv[i]);
+        if (arg == "--frames" && i + 1 < argc) nb_frames = max(2, atoi(argv[++i]));
+        else {
+            printf("Usage : ./ZED_Headless_Smoke [--frames 120]\n");
+            return EXIT_FAILURE;
+        }
+    }
+    bool ok = true;
+#ifdef __linux__
+    // Nothing is opened, the smoke test only checks which frames would be rendered: the window and preview modes
+    // must not fall back to headless on hosts without display server
+    setenv("DISPLAY", ":0", 0);
+#endif
+
+    printf("Command line\n");
+    {
+        DisplayMode display;
+        int sample_argc;
+        vector<char*> sample_argv;
+        ok &= check(parseArgs(display, {"--headless", "file.svo", "--sink", "file:-"}, sample_argc, sample_argv), "parsed");
+        ok &= check(sample_argc == 2 && string(sample_argv[1]) == "file.svo", "sample arguments kept");
+        ok &= check(display.headless() && display.hasSink(), "headless with a sink");
+        DisplayMode invalid;
+        ok &= check(!parseArgs(invalid, {"--preview", "0"}, sample_argc, sample_argv), "--preview 0 rejected");
+        ok &= check(!parseArgs(invalid, {"--sink", "udp:1234"}, sample_argc, sample_argv), "unknown sink rejected");
+    }
+
+    printf("Rendered frames, %d frames\n", nb_frames);
+    {
+        const char* modes[][2] = {{"--preview", "1"}, {"--preview", "10"}, {"--headless", ""}};
+        const int expected[] = {nb_frames, (nb_frames + 9) / 10, 0};
+        for (int m = 0; m < 3; m++) {
+            DisplayMode display;
+            int sample_argc;
+            vector<char*> sample_argv;
+            vector<string> args = {modes[m][0]};
+            if (*modes[m][1]) args.push_back(modes[m][1]);
+            parseArgs(display, args, sample_argc, sample_argv);
+            auto start = chrono::steady_clock::now();
+            int nb_rendered = runLoop(display, nb_frames, false);
+            double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+            printf("  %-8s %5.2f ms/frame, %d rendered\n", display.modeName(), ms / nb_frames, nb_rendered);
+            ok &= check(nb_rendered == expected[m], string(display.modeName()) + " renders " + to_string(expected[m]) + " frames");
+        }
+    }
+
+    printf("Sinks\n");
+    {
+        const string path = "zed_headless_smoke.txt";
+        DisplayMode display;
+        int sample_argc;
+        vector<char*> sample_argv;
+        ok &= check(parseArgs(display, {"--headless", "--sink", "file:" + path}, sample_argc, sample_argv), "file sink opened");
+        runLoop(display, nb_frames, false);
+        display.setSink(nullptr);
+        ifstream file(path);
+        string line, last;
+        int nb_lines = 0;
+        while (getline(file, line)) {
+            nb_lines++;
+            last = line;
+        }
+        remove(path.c_str());
+        ok &= check(nb_lines == nb_frames, "file: one line per frame");
+        ok &= check(last.compare(0, to_string(nb_frames - 1).size() + 1, to_string(nb_frames - 1) + " ") == 0, "file: frame index");
+    }
+    {
+        const string name = "zed_headless_smoke";
+        DisplayMode display;
+        display.setSink(ResultSink::create("shm:" + name));
+        runLoop(display, nb_frames, true);
+        SharedFrameRing reader;
+        SharedFrameView view;
+        uint64_t last_seq = 0;
+        bool read = reader.open(name) && reader.acquire(last_seq, view, 100);
+        ok &= check(read, "shared memory: newest result read");
+        if (read) {
+            vector<uint8_t> frame(static_cast<size_t>(WIDTH) * HEIGHT * 4);
+            fillFrame(frame, nb_frames - 1);
+            ok &= check(view.seq == static_cast<uint64_t>(nb_frames), "shared memory: one frame per result");
+            ok &= check(view.info.width == WIDTH && view.info.height == HEIGHT && !memcmp(view.data, frame.data(), frame.size()), "shared memory: image");
+            ok &= check(SharedMemorySink::text(view) == process(frame) && reader.isValid(view), "shared memory: text");
+        }
+    }
+    {
+        DisplayMode display;
+        uint64_t nb_results = 0, last_frame = 0;
+        display.setSink(unique_ptr<ResultSink>(new CallbackSink([&](const FrameResult& result) {
+            nb_results++;
+            last_frame = result.frame;
+        })));
+        runLoop(display, nb_frames, false);
+        ok &= check(nb_results == static_cast<uint64_t>(nb_frames) && last_frame == static_cast<uint64_t>(nb_frames - 1), "callback: one call per frame");
+    }
+
+    printf("Interruption\n");
+    {
+        DisplayMode display;
+        int sample_argc;
+        vector<char*> sample_argv;
+        parseArgs(display, {"--headless"}, sample_argc, sample_argv);
+        bool running = display.nextFrame();
+        raise(SIGINT);
+        ok &= check(running && !display.nextFrame(), "Ctrl+C ends the headless loop");
+    }
+
+    printf("%s\n", ok ? "PASSED" : "FAILED");
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,192 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+/*****************************************************************************************
+ ** Check of the sl::Mat <-> cv::Mat bridge (MatBridge.hpp), no camera needed: type      **
+ ** mapping of every MAT_TYPE, views of both libraries on the same buffers at widths     **
+ ** that are not a multiple of the alignment (steps, ROIs), then, if a GPU is present,   **
+ ** GpuMat views of the pitched GPU buffers and downloads through PinnedStaging.         **
+ *****************************************************************************************/
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include "MatBridge.hpp"
+
+using namespace std;
+
+// Mapping checked by the compiler
+static_assert(cvType(sl::MAT_TYPE::U8_C4) == CV_8UC4, "U8_C4 is CV_8UC4");
+static_assert(cvType(sl::MAT_TYPE::F32_C1) == CV_32FC1, "F32_C1 is CV_32FC1");
+static_assert(MatElement<sl::float4>::type == sl::MAT_TYPE::F32_C4, "float4 is F32_C4");
+
+// Widths of the views: tightly packed, odd, and not a multiple of the alignment of the GPU rows
+static const int WIDTHS[] = {64, 333, 1283};
+static const int HEIGHT = 37;
+
+static bool check(bool condition, const string& what) {
+    printf("  %-64s %s\n", what.c_str(), condition ? "ok" : "FAILED");
+    return condition;
+}
+
+static string typeName(sl::MAT_TYPE type) {
+    switch (type) {
+        case sl::MAT_TYPE::F32_C1: return "F32_C1";
+        case sl::MAT_TYPE::F32_C2: return "F32_C2";
+        case sl::MAT_TYPE::F32_C3: return "F32_C3";
+        case sl::MAT_TYPE::F32_C4: return "F32_C4";
+        case sl::MAT_TYPE::U8_C1: return "U8_C1";
+        case sl::MAT_TYPE::U8_C2: return "U8_C2";
+        case sl::MAT_TYPE::U8_C3: return "U8_C3";
+        case sl::MAT_TYPE::U8_C4: return "U8_C4";
+#ifdef MAT_BRIDGE_U16_S8
+        case sl::MAT_TYPE::U16_C1: return "U16_C1";
+        case sl::MAT_TYPE::S8_C4: return "S8_C4";
+#endif
+        default: return "MAT_TYPE " + to_string(static_cast<int>(type));
+    }
+}
+
+// Writes a pattern through the cv::Mat view, returns false if the sl::Mat does not read it back at the same place
+static bool sharedPixels(sl::Mat& image, cv::Mat& view) {
+    const size_t pixel_bytes = image.getPixelBytes();
+    for (int y = 0; y < view.rows; y++)
+        for (size_t b = 0; b < view.cols * pixel_bytes; b++)
+            view.ptr<uchar>(y)[b] = static_cast<uchar>(y * 31 + b);
+    const uchar* data = image.getPtr<sl::uchar1>(sl::MEM::CPU);
+    for (int y = 0; y < view.rows; y++)
+        for (size_t b = 0; b < view.cols * pixel_bytes; b++)
+            if (data[y * image.getStepBytes(sl::MEM::CPU) + b] != static_cast<uchar>(y * 31 + b)) return false;
+    return true;
+}
+
+int main(int argc, char **argv) {
+    (void)argv;
+    if (argc > 1) {
+        printf("Usage : ./ZED_Mat_Bridge_Check\n");
+        return EXIT_FAILURE;
+    }
+    bool ok = true;
+    const sl::MAT_TYPE types[] = {sl::MAT_TYPE::F32_C1, sl::MAT_TYPE::F32_C2, sl::MAT_TYPE::F32_C3, sl::MAT_TYPE::F32_C4,
+                                  sl::MAT_TYPE::U8_C1, sl::MAT_TYPE::U8_C2, sl::MAT_TYPE::U8_C3, sl::MAT_TYPE::U8_C4,
+#ifdef MAT_BRIDGE_U16_S8
+                                  sl::MAT_TYPE::U16_C1, sl::MAT_TYPE::S8_C4,
+#endif
+                                 };
+
+    printf("Type mapping\n");
+    for (auto type : types) {
+        sl::MAT_TYPE back;
+        sl::Mat image(sl::Resolution(1, 1), type, sl::MEM::CPU);
+        ok &= check(cvType(type) >= 0 && slType(cvType(type), back) && back == type
+                    && static_cast<size_t>(CV_ELEM_SIZE(cvType(type))) == image.getPixelBytes(), typeName(type) + " <-> cv type, same element size");
+    }
+    sl::MAT_TYPE unused;
+    ok &= check(!slType(CV_64FC1, unused) && !slType(CV_32SC1, unused) && !slType(CV_16SC1, unused), "OpenCV types without ZED type rejected");
+
+    printf("Host views\n");
+    for (auto type : types)
+        for (int width : WIDTHS) {
+            const string name = typeName(type) + " " + to_string(width) + "x" + to_string(HEIGHT);
+            sl::Mat image(sl::Resolution(width, HEIGHT), type, sl::MEM::CPU);
+            cv::Mat view = toCvMat(image);
+            ok &= check(view.type() == cvType(type) && view.cols == width && view.rows == HEIGHT
+                        && view.data == image.getPtr<sl::uchar1>(sl::MEM::CPU) && view.step == image.getStepBytes(sl::MEM::CPU)
+                        && sharedPixels(image, view), name + ": cv view, same buffer and step");
+        }
+    {
+        sl::Mat image(sl::Resolution(WIDTHS[1], HEIGHT), sl::MAT_TYPE::F32_C4, sl::MEM::CPU);
+        ok &= check(!toCvMat<sl::float4>(image).empty() && toCvMat<sl::uchar4>(image).empty(), "typed view: element type checked");
+        sl::Mat empty;
+        ok &= check(toCvMat(empty).empty(), "no view of an empty sl::Mat");
+    }
+    {
+        // The ZED SDK retrieves into the right half of a side by side image: ROI with the step of the full image
+        cv::Mat side_by_side(HEIGHT, WIDTHS[1] * 2, CV_8UC4, cv::Scalar::all(0));
+        cv::Mat right = side_by_side(cv::Rect(WIDTHS[1], 0, WIDTHS[1], HEIGHT));
+        sl::Mat image = toSlMat(right);
+        ok &= check(image.isInit() && image.getDataType() == sl::MAT_TYPE::U8_C4 && image.getWidth() == static_cast<size_t>(WIDTHS[1])
+                    && image.getStepBytes(sl::MEM::CPU) == side_by_side.step && image.getPtr<sl::uchar1>(sl::MEM::CPU) == right.data,
+                    "sl view of a cv ROI, step of the full image");
+        image.setTo(sl::uchar4(1, 2, 3, 4), sl::MEM::CPU);
+        ok &= check(side_by_side.at<cv::Vec4b>(HEIGHT - 1, WIDTHS[1] - 1) == cv::Vec4b(0, 0, 0, 0)
+                    && side_by_side.at<cv::Vec4b>(HEIGHT - 1, WIDTHS[1]) == cv::Vec4b(1, 2, 3, 4), "sl view writes the ROI only");
+        cv::Mat unsupported(HEIGHT, WIDTHS[0], CV_64FC1);
+        ok &= check(!toSlMat(unsupported).isInit(), "no sl view of a CV_64F image");
+    }
+
+    int nb_devices = 0;
+    if (cudaGetDeviceCount(&nb_devices) != cudaSuccess || nb_devices == 0) {
+        printf("No CUDA device, GPU views and PinnedStaging not checked\n");
+        printf("%s\n", ok ? "PASSED" : "FAILED");
+        return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    printf("GPU views\n");
+    for (int width : WIDTHS) {
+        sl::Mat image(sl::Resolution(width, HEIGHT), sl::MAT_TYPE::U8_C4, sl::MEM::GPU);
+        cv::cuda::GpuMat view = toGpuMat(image);
+        ok &= check(view.type() == CV_8UC4 && view.cols == width && view.data == image.getPtr<sl::uchar1>(sl::MEM::GPU)
+                    && view.step == image.getStepBytes(sl::MEM::GPU) && toCvMat(image).empty(),
+                    to_string(width) + " px: GpuMat view, pitch of " + to_string(image.getStepBytes(sl::MEM::GPU)) + " bytes");
+        sl::Mat back = toSlMat(view);
+        ok &= check(back.isInit() && back.getPtr<sl::uchar1>(sl::MEM::GPU) == view.data && back.getStepBytes(sl::MEM::GPU) == view.step,
+                    to_string(width) + " px: sl view of the GpuMat");
+    }
+
+    printf("PinnedStaging\n");
+    {
+        sl::Mat image(sl::Resolution(WIDTHS[2], HEIGHT), sl::MAT_TYPE::F32_C4, sl::MEM::GPU);
+        image.setTo(sl::float4(1.f, 2.f, 3.f, 4.f), sl::MEM::GPU);
+        PinnedStaging staging;
+        bool queued = staging.download(image);
+        ok &= check(queued && staging.wait(), "download queued and done");
+        cv::Mat frame = staging.cvView();
+        ok &= check(frame.type() == CV_32FC4 && frame.cols == WIDTHS[2] && frame.step == WIDTHS[2] * sizeof(sl::float4)
+                    && frame.at<cv::Vec4f>(HEIGHT - 1, WIDTHS[2] - 1) == cv::Vec4f(1.f, 2.f, 3.f, 4.f), "rows packed, content of the GPU frame");
+        ok &= check(staging.slView().getDataType() == sl::MAT_TYPE::F32_C4, "sl view of the staging buffer");
+
+        const size_t capacity = staging.capacity();
+        sl::Mat smaller(sl::Resolution(WIDTHS[0], HEIGHT), sl::MAT_TYPE::F32_C4, sl::MEM::GPU);
+        ok &= check(staging.download(smaller) && staging.wait() && staging.capacity() == capacity
+                    && staging.cvView().cols == WIDTHS[0], "smaller frame: same buffer");
+
+        sl::Mat host_only(sl::Resolution(WIDTHS[0], HEIGHT), sl::MAT_TYPE::F32_C4, sl::MEM::CPU);
+        ok &= check(!staging.download(host_only) && staging.cvView().empty(), "download of a host sl::Mat rejected");
+
+        // Copy time of the host only, the download runs on the stream while the host works
+        const int nb_downloads = 100;
+        auto start = chrono::steady_clock::now();
+        double queue_us = 0.;
+        for (int i = 0; i < nb_downloads; i++) {
+            auto t0 = chrono::steady_clock::now();
+            staging.download(image);
+            queue_us += chrono::duration<double, micro>(chrono::steady_clock::now() - t0).count();
+            staging.wait();
+        }
+        double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        printf("  %dx%d F32_C4: %.1f us to queue, %.2f ms per download\n", WIDTHS[2], HEIGHT, queue_us / nb_downloads, ms / nb_downloads);
+    }
+
+    printf("%s\n", ok ? "PASSED" : "FAILED");
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,224 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+/*****************************************************************************************
+ ** Check of the SensorStream (SensorStream.hpp) without camera: the mock 400Hz IMU and  **
+ ** a scripted source for the duplicates and the missed samples, the queue, and the      **
+ ** callbacks using the stream (stats, subscribe, unsubscribe) from the stream thread.   **
+ *****************************************************************************************/
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "SensorStream.hpp"
+
+using namespace std;
+
+static bool check(bool condition, const string& what) {
+    printf("  %-60s %s\n", what.c_str(), condition ? "ok" : "FAILED");
+    return condition;
+}
+
+///
+/// \brief Returns the IMU timestamps of a script, one per poll, then repeats the last one.
+/// The magnetometer is updated with the sample of index magnetometer_at only
+///
+class ScriptedSensorSource : public SensorSource {
+public:
+    ScriptedSensorSource(vector<uint64_t> script_, float rate_, size_t magnetometer_at_)
+        : script(script_), rate(rate_), magnetometer_at(magnetometer_at_) {}
+
+    sl::ERROR_CODE getSensorsData(sl::SensorsData& data) override {
+        size_t i = std::min(position.load(), script.size() - 1);
+        position++;
+        data.imu.is_available = true;
+        data.imu.timestamp.setNanoseconds(script[i]);
+        data.magnetometer.timestamp.setNanoseconds(i >= magnetometer_at ? script[magnetometer_at] : 0);
+        return sl::ERROR_CODE::SUCCESS;
+    }
+    float getImuRate() override { return rate; }
+
+    bool done() const { return position >= script.size(); }
+
+private:
+    vector<uint64_t> script;
+    float rate;
+    size_t magnetometer_at;
+    std::atomic<size_t> position{0};
+};
+
+///
+/// \brief Ends the process if a step of the check does not end in time: a deadlock fails the check instead of hanging it
+///
+class Watchdog {
+public:
+    Watchdog() : worker(&Watchdog::run, this) {}
+    ~Watchdog() {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            running = false;
+        }
+        cv.notify_all();
+        worker.join();
+    }
+    void arm(const string& what_) {
+        std::lock_guard<std::mutex> lock(mtx);
+        what = what_;
+        deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    }
+
+private:
+    void run() {
+        std::unique_lock<std::mutex> lock(mtx);
+        while (running) {
+            if (cv.wait_until(lock, deadline, [this] { return !running; })) break;
+            if (std::chrono::steady_clock::now() >= deadline) {
+                printf("  %-60s %s\nFAILED\n", (what + ": deadlock").c_str(), "FAILED");
+                fflush(stdout);
+                std::_Exit(EXIT_FAILURE);
+            }
+        }
+    }
+
+    std::mutex mtx;
+    std::condition_variable cv;
+    bool running = true;
+    string what;
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    std::thread worker;
+};
+
+int main(int argc, char **) {
+    if (argc > 1) {
+        printf("Usage : ./ZED_Sensor_Stream_Check\n");
+        return EXIT_FAILURE;
+    }
+    bool ok = true;
+    Watchdog watchdog;
+
+    printf("Mock IMU\n");
+    {
+        watchdog.arm("mock IMU");
+        MockSensorSource source(400.f);
+        SensorStream stream(source, 4096);
+        stream.start();
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        stream.stop();
+
+        vector<uint64_t> timestamps;
+        SensorSample sample;
+        while (stream.pop(sample, 0)) timestamps.push_back(sample.data.imu.timestamp.getNanoseconds());
+        bool increasing = !timestamps.empty();
+        for (size_t i = 1; i < timestamps.size(); i++) increasing &= timestamps[i] > timestamps[i - 1];
+        auto stats = stream.getStats();
+        ok &= check(increasing && stats.nb_samples == timestamps.size(), "new samples only, in order");
+        // 200 samples in 500ms, the missed ones included: loose bounds for the loaded hosts
+        ok &= check(stats.nb_samples + stats.nb_missed >= 150 && stats.nb_samples + stats.nb_missed <= 210, "samples at the IMU rate");
+        ok &= check(stats.nb_polls < 20 * (stats.nb_samples + stats.nb_missed), "sleeps between the samples, no busy polling");
+        ok &= check(!stream.pop(sample, 10), "stopped stream: pop returns");
+    }
+
+    printf("Duplicates and missed samples\n");
+    {
+        watchdog.arm("scripted source");
+        const uint64_t period = 2500000; // 400Hz
+        // Samples 1, 2, 3, 6, 7: 4 and 5 were missed
+        ScriptedSensorSource source({1 * period, 1 * period, 2 * period, 3 * period, 3 * period, 3 * period, 6 * period, 7 * period}, 400.f, 3);
+        SensorStream stream(source, 16);
+        stream.start();
+        while (!source.done()) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        stream.stop();
+
+        vector<SensorSample> samples;
+        SensorSample sample;
+        while (stream.pop(sample, 0)) samples.push_back(sample);
+        auto stats = stream.getStats();
+        ok &= check(samples.size() == 5 && stats.nb_samples == 5, "duplicates filtered");
+        ok &= check(stats.nb_duplicates >= 3 && stats.nb_polls == stats.nb_samples + stats.nb_duplicates, "duplicates counted");
+        ok &= check(stats.nb_missed == 2, "missed samples estimated from the gap");
+        ok &= check(samples.size() == 5 && !samples[0].new_magnetometer && samples[2].new_magnetometer && !samples[3].new_magnetometer,
+            "magnetometer update flagged once");
+    }
+
+    printf("Queue\n");
+    {
+        watchdog.arm("queue");
+        MockSensorSource source(400.f);
+        SensorStream stream(source, 4);
+        stream.start();
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        SensorSample sample;
+        int nb_popped = 0;
+        while (stream.pop(sample, 0) && nb_popped < 10) nb_popped++;
+        ok &= check(nb_popped <= 5 && stream.getStats().nb_dropped > 0, "bounded queue, oldest samples dropped");
+        ok &= check(stream.pop(sample, 100), "pop waits for the next sample");
+        stream.stop();
+    }
+
+    printf("Callbacks\n");
+    {
+        watchdog.arm("callbacks using the stream");
+        MockSensorSource source(400.f);
+        SensorStream stream(source, 0);
+        std::atomic<int> nb_calls{0}, nb_added_calls{0};
+        std::atomic<uint64_t> stats_samples{0};
+        int self_id = -1;
+        bool added = false;
+        self_id = stream.subscribe([&](const SensorSample&) {
+            // Stats, subscribe and unsubscribe from the stream thread
+            stats_samples = stream.getStats().nb_samples;
+            if (!added) {
+                added = true;
+                stream.subscribe([&](const SensorSample&) { nb_added_calls++; });
+            }
+            if (++nb_calls == 10) stream.unsubscribe(self_id);
+        });
+        stream.start();
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        ok &= check(nb_calls == 10 && stats_samples >= 10, "callback using getStats, subscribe and unsubscribe");
+        ok &= check(nb_added_calls > 10, "subscribed from a callback");
+
+        watchdog.arm("unsubscribe from another thread");
+        std::atomic<bool> in_callback{false};
+        std::atomic<int> nb_slow_calls{0};
+        int slow_id = stream.subscribe([&](const SensorSample&) {
+            in_callback = true;
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            nb_slow_calls++;
+            in_callback = false;
+        });
+        while (nb_slow_calls < 3) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        while (!in_callback) std::this_thread::yield();
+        stream.unsubscribe(slow_id);
+        bool returned_after = !in_callback;
+        int nb_at_unsubscribe = nb_slow_calls;
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        ok &= check(returned_after && nb_slow_calls == nb_at_unsubscribe, "unsubscribe waits for the callback, no call after it");
+        stream.stop();
+    }
+
+    printf(ok ? "PASSED\n" : "FAILED\n");
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,96 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+/***********************************************************************
+ ** Cost of the StageSpan scopes of the sample loops, disabled and    **
+ ** recording, and of the statistics and trace export. The spans must **
+ ** cost less than 1 us each for the traces of the samples to be      **
+ ** meaningful: the suite fails above.                                **
+ ***********************************************************************/
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+#include "StageTrace.hpp"
+#include "BenchSuite.hpp"
+
+static const char* const STAGES[] = {"grab", "retrieveImage", "retrieveMeasure", "inference", "retrieveObjects", "viewer", "imshow", "export"};
+
+int main(int argc, char **argv) {
+    BenchSuite suite("ZED_Stage_Trace_Bench");
+
+    // Statistics of known spans: 1 to 100 us, uniform
+    StageTrace::start();
+    StageTrace::nameThread("main");
+    for (uint64_t i = 0; i < 1000; i++) StageTrace::record("known", 0, (i % 100 + 1) * 1000);
+    auto stats = StageTrace::stats();
+    bool valid = stats.size() == 1 && stats[0].name == "known" && stats[0].count == 1000 && stats[0].min == 1000 && stats[0].max == 100000;
+    auto within = [](uint64_t value, double expected) { return value > expected * 0.96 && value < expected * 1.04; };
+    suite.check(valid && within(stats[0].p50, 50000) && within(stats[0].p95, 95000) && within(stats[0].p99, 99000) && stats[0].mean == 50500,
+                "percentiles of the stage statistics");
+
+    // Export, read back
+    std::string trace_path = "stage_trace_bench.json";
+    bool written = StageTrace::writeChromeTrace(trace_path, "ZED_Stage_Trace_Bench");
+    std::ifstream trace(trace_path);
+    std::string content((std::istreambuf_iterator<char>(trace)), std::istreambuf_iterator<char>());
+    suite.check(written && content.find("\"traceEvents\"") != std::string::npos && content.find("\"name\":\"known\",\"cat\":\"stage\",\"ph\":\"X\"") != std::string::npos
+                && content.find("\"name\":\"main\"") != std::string::npos, "Chrome trace of the spans");
+    std::remove(trace_path.c_str());
+
+    // Budget of a span, measured on its own before the benchmarks
+    const int nb_spans = 200000;
+    StageTrace::clear();
+    uint64_t start = StageTrace::now();
+    for (int i = 0; i < nb_spans; i++) {
+        StageSpan span(STAGES[i & 7]);
+    }
+    double span_ns = static_cast<double>(StageTrace::now() - start) / nb_spans;
+    char budget[64];
+    snprintf(budget, sizeof(budget), "%.0f ns", span_ns);
+    suite.setContext("span_cost", budget);
+    suite.check(span_ns < 1000., std::string("a span costs less than 1 us (") + budget + ")");
+
+    suite.add("span/disabled", []() {
+        StageTrace::stop();
+        StageSpan span("grab");
+    }).items(1);
+    // The recording starts at the first iteration, after the disabled benchmark
+    suite.add("span/recording", []() {
+        if (!StageTrace::enabled()) StageTrace::start();
+        StageSpan span("grab");
+    }).items(1);
+    int next = 0;
+    suite.add("span/recording/8_stages", [&next]() {
+        if (!StageTrace::enabled()) StageTrace::start();
+        StageSpan span(STAGES[next++ & 7]);
+    }).items(1);
+    suite.add("clock/now", []() {
+        doNotOptimize(StageTrace::now());
+    }).items(1);
+    suite.add("stats/8_stages", []() {
+        doNotOptimize(StageTrace::stats().size());
+    }).items(1);
+
+    int status = suite.run(argc, argv);
+    StageTrace::stop();
+    return status;
+}
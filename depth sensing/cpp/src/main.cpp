@@ -27,6 +27,8 @@
 #include <sl/Camera.hpp>
 
 // Sample includes
+#include "DisplayMode.hpp"
+#include "ZedFrameSource.hpp"
 #include "GLViewer.hpp"
 
 // Using std and sl namespaces
@@ -34,15 +36,18 @@ using namespace std;
 using namespace sl;
 
 
-void parseArgs(int argc, char **argv, sl::InitParameters& param);
-
 int main(int argc, char **argv) {
     Camera zed;
     // Set configuration parameters for the ZED
     InitParameters init_parameters;
     init_parameters.depth_mode = DEPTH_MODE::ULTRA;
     init_parameters.coordinate_system = COORDINATE_SYSTEM::RIGHT_HANDED_Y_UP; // OpenGL's coordinate system is right_handed
-    parseArgs(argc, argv, init_parameters);
+    // --headless, --preview N, --sink
+    DisplayMode display;
+    if (!display.parse(argc, argv)) return EXIT_FAILURE;
+    // Input of the sample: SVO file, IP[:port] of a stream, camera resolution or --source (FrameSource.hpp)
+    FrameSourceOptions source;
+    if (!source.parse(argc, argv) || !applyFrameSource(source, init_parameters)) return EXIT_FAILURE;
 
     // Open the camera
     auto returned_state = zed.open(init_parameters);
@@ -55,11 +60,13 @@ int main(int argc, char **argv) {
 
     // Point cloud viewer
     GLViewer viewer;
-    // Initialize point cloud viewer 
-    GLenum errgl = viewer.init(argc, argv, camera_config.calibration_parameters.left_cam);
-    if (errgl != GLEW_OK) {
-        print("Error OpenGL: " + std::string((char*)glewGetErrorString(errgl)));
-        return EXIT_FAILURE;
+    // Initialize point cloud viewer, no GL context when headless
+    if (!display.headless()) {
+        GLenum errgl = viewer.init(argc, argv, camera_config.calibration_parameters.left_cam);
+        if (errgl != GLEW_OK) {
+            print("Error OpenGL: " + std::string((char*)glewGetErrorString(errgl)));
+            return EXIT_FAILURE;
+        }
     }
 
     RuntimeParameters runParameters;
@@ -71,13 +78,23 @@ int main(int argc, char **argv) {
     Mat point_cloud(camera_config.resolution, MAT_TYPE::F32_C4, MEM::GPU);
 
     // Main Loop
-    while (viewer.isAvailable()) {        
+    while (display.nextFrame()) {
+        if (display.renderFrame() && !viewer.isAvailable()) break;
         // Check that a new image is successfully acquired
-        if (zed.grab(runParameters) == ERROR_CODE::SUCCESS) {
+        returned_state = zed.grab(runParameters);
+        if (returned_state == ERROR_CODE::SUCCESS) {
             // retrieve the current 3D coloread point cloud in GPU
             zed.retrieveMeasure(point_cloud, MEASURE::XYZRGBA, MEM::GPU);
-            viewer.updatePointCloud(point_cloud);
-        }
+            if (display.renderFrame()) viewer.updatePointCloud(point_cloud);
+            if (display.hasSink()) {
+                // Point at the center of the image, a single value read from the GPU
+                sl::float4 center;
+                point_cloud.getValue(point_cloud.getWidth() / 2, point_cloud.getHeight() / 2, &center, MEM::GPU);
+                display.publish(zed.getTimestamp(TIME_REFERENCE::IMAGE).getNanoseconds(),
+                        "center " + to_string(center.x) + " " + to_string(center.y) + " " + to_string(center.z));
+            }
+        } else if (returned_state == ERROR_CODE::END_OF_SVOFILE_REACHED && display.headless())
+            break;
     }
     // free allocated memory before closing the ZED
     point_cloud.free();
@@ -88,40 +105,5 @@ int main(int argc, char **argv) {
     return EXIT_SUCCESS;
 }
 
-void parseArgs(int argc, char **argv, sl::InitParameters& param) {
-    if (argc > 1 && string(argv[1]).find(".svo") != string::npos) {
-        // SVO input mode
-        param.input.setFromSVOFile(argv[1]);
-        cout << "[Sample] Using SVO File input: " << argv[1] << endl;
-    } else if (argc > 1 && string(argv[1]).find(".svo") == string::npos) {
-        string arg = string(argv[1]);
-        unsigned int a, b, c, d, port;
-        if (sscanf(arg.c_str(), "%u.%u.%u.%u:%d", &a, &b, &c, &d, &port) == 5) {
-            // Stream input mode - IP + port
-            string ip_adress = to_string(a) + "." + to_string(b) + "." + to_string(c) + "." + to_string(d);
-            param.input.setFromStream(sl::String(ip_adress.c_str()), port);
-            cout << "[Sample] Using Stream input, IP : " << ip_adress << ", port : " << port << endl;
-        } else if (sscanf(arg.c_str(), "%u.%u.%u.%u", &a, &b, &c, &d) == 4) {
-            // Stream input mode - IP only
-            param.input.setFromStream(sl::String(argv[1]));
-            cout << "[Sample] Using Stream input, IP : " << argv[1] << endl;
-        } else if (arg.find("HD2K") != string::npos) {
-            param.camera_resolution = sl::RESOLUTION::HD2K;
-            cout << "[Sample] Using Camera in resolution HD2K" << endl;
-        } else if (arg.find("HD1080") != string::npos) {
-            param.camera_resolution = sl::RESOLUTION::HD1080;
-            cout << "[Sample] Using Camera in resolution HD1080" << endl;
-        } else if (arg.find("HD720") != string::npos) {
-            param.camera_resolution = sl::RESOLUTION::HD720;
-            cout << "[Sample] Using Camera in resolution HD720" << endl;
-        } else if (arg.find("VGA") != string::npos) {
-            param.camera_resolution = sl::RESOLUTION::VGA;
-            cout << "[Sample] Using Camera in resolution VGA" << endl;
-        }
-    } else {
-        // Default
-    }
-}
-
 
 
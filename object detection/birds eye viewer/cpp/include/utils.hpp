@@ -79,31 +79,5 @@ inline void drawVerticalLine(
     cv::line(left_display, pt4, end_pt, clr, thickness);
 }
 
-inline cv::Mat slMat2cvMat(sl::Mat& input) {
-    // Mapping between MAT_TYPE and CV_TYPE
-    int cv_type = -1;
-    switch (input.getDataType()) {
-        case sl::MAT_TYPE::F32_C1: cv_type = CV_32FC1;
-            break;
-        case sl::MAT_TYPE::F32_C2: cv_type = CV_32FC2;
-            break;
-        case sl::MAT_TYPE::F32_C3: cv_type = CV_32FC3;
-            break;
-        case sl::MAT_TYPE::F32_C4: cv_type = CV_32FC4;
-            break;
-        case sl::MAT_TYPE::U8_C1: cv_type = CV_8UC1;
-            break;
-        case sl::MAT_TYPE::U8_C2: cv_type = CV_8UC2;
-            break;
-        case sl::MAT_TYPE::U8_C3: cv_type = CV_8UC3;
-            break;
-        case sl::MAT_TYPE::U8_C4: cv_type = CV_8UC4;
-            break;
-        default: break;
-    }
-
-    return cv::Mat(input.getHeight(), input.getWidth(), cv_type, input.getPtr<sl::uchar1>(sl::MEM::CPU));
-}
-
 
 #endif
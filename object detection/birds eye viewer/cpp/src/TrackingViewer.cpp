@@ -1,4 +1,5 @@
 #include "TrackingViewer.hpp"
+#include "MatBridge.hpp"
 
 // -------------------------------------------------
 //            2D LEFT VIEW
@@ -67,7 +68,7 @@ void render_2D(cv::Mat &left_display, sl::float2 img_scale, std::vector<sl::Obje
             if (render_mask && obj.mask.isInit()) {
                 // Here, obj.mask is the object segmentation mask inside the object bbox, computed on the native resolution
                 // The resize is needed to get the mask on the display resolution
-				cv::resize(slMat2cvMat(obj.mask), mask(roi), roi.size());
+				cv::resize(toCvMat(obj.mask), mask(roi), roi.size());
 				overlay(roi).setTo(base_color, mask(roi));
             } else
                 overlay(roi).setTo(base_color);            
@@ -0,0 +1,164 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+/***********************************************************************
+ ** Per frame work of the sample on synthetic objects, no camera nor  **
+ ** window: batching queue (push of the trajectories, pop of the      **
+ ** objects), 2D view of the objects on the left image and bird's eye **
+ ** tracking view, with and without tracking.                         **
+ ***********************************************************************/
+
+#include <list>
+#include <random>
+#include <vector>
+
+#include <sl/Camera.hpp>
+
+#include "BatchSystemHandler.hpp"
+#include "TrackingViewer.hpp"
+#include "BenchSuite.hpp"
+
+using namespace std;
+
+static const uint64_t FRAME_NS = 33333333ULL;
+
+// Objects walking in front of the camera (RIGHT_HANDED_Y_UP, millimeters), boxes in a 1280x720 image
+static vector<sl::ObjectData> makeObjects(int nb_objects, mt19937& rng) {
+    uniform_real_distribution<float> x(-3000.f, 3000.f), z(-9000.f, -1000.f), u(0.f, 1180.f), v(0.f, 520.f), size(60.f, 200.f);
+    vector<sl::ObjectData> objects(nb_objects);
+    for (int i = 0; i < nb_objects; i++) {
+        auto& obj = objects[i];
+        obj.id = i;
+        obj.label = sl::OBJECT_CLASS::PERSON;
+        obj.tracking_state = sl::OBJECT_TRACKING_STATE::OK;
+        obj.position = sl::float3(x(rng), 0.f, z(rng));
+        float left = u(rng), top = v(rng), width = size(rng) / 2, height = size(rng);
+        obj.bounding_box_2d = {sl::uint2(left, top), sl::uint2(left + width, top), sl::uint2(left + width, top + height), sl::uint2(left, top + height)};
+        for (int c = 0; c < 8; c++)
+            obj.bounding_box.push_back(sl::float3(obj.position.x + (c & 1 ? 250.f : -250.f), c & 2 ? 1800.f : 0.f, obj.position.z + (c & 4 ? 250.f : -250.f)));
+    }
+    return objects;
+}
+
+// Trajectories of the batching system: nb_samples positions of each object, one per frame
+static vector<sl::ObjectsBatch> makeBatch(const vector<sl::ObjectData>& objects, int nb_samples, uint64_t start_ns) {
+    vector<sl::ObjectsBatch> batch(objects.size());
+    for (size_t i = 0; i < objects.size(); i++) {
+        auto& traj = batch[i];
+        traj.id = objects[i].id;
+        traj.label = objects[i].label;
+        traj.tracking_state = objects[i].tracking_state;
+        for (int s = 0; s < nb_samples; s++) {
+            sl::float3 position = objects[i].position;
+            position.x += 20.f * s;
+            traj.timestamps.push_back(sl::Timestamp(start_ns + s * FRAME_NS));
+            traj.positions.push_back(position);
+            traj.bounding_boxes.push_back(objects[i].bounding_box);
+            traj.bounding_boxes_2d.push_back(objects[i].bounding_box_2d);
+        }
+    }
+    return batch;
+}
+
+int main(int argc, char **argv) {
+    BenchSuite suite("ZED_Birds_Eye_Bench");
+    suite.setContext("opencv", CV_VERSION);
+    cv::setNumThreads(1);
+    mt19937 rng(42);
+
+    // Batching: a second of trajectories at 30 fps pushed, then popped frame by frame.
+    // The image retention is not measured, it keeps the point clouds on the GPU
+    const int nb_samples = 30;
+    const int object_counts[] = {5, 20, 50};
+    list<vector<sl::ObjectsBatch>> batches;
+    for (int nb_objects : object_counts) {
+        batches.push_back(makeBatch(makeObjects(nb_objects, rng), nb_samples, 1000 * FRAME_NS));
+        auto& batch = batches.back();
+        BatchSystemHandler handler(4);
+        handler.push(batch);
+        sl::Objects objects;
+        int nb_frames = 0;
+        for (handler.pop(objects); !objects.object_list.empty(); handler.pop(objects)) {
+            nb_frames++;
+            if (objects.object_list.size() != static_cast<size_t>(nb_objects)) nb_frames = -nb_samples;
+        }
+        suite.check(nb_frames == nb_samples, "batching gives one sl::Objects per frame with all the objects");
+
+        suite.add("batch_push_pop/" + to_string(nb_objects), [&batch]() {
+            BatchSystemHandler handler(4);
+            handler.push(batch);
+            sl::Objects objects;
+            for (handler.pop(objects); !objects.object_list.empty(); handler.pop(objects))
+                doNotOptimize(objects.object_list.data());
+        }).items(nb_samples);
+    }
+
+    // Views of the sample at its display resolution
+    sl::Resolution display_resolution(1280, 720), tracks_resolution(400, 720);
+    sl::float2 img_scale(1.f, 1.f);
+    cv::Mat left(display_resolution.height, display_resolution.width, CV_8UC4), left_render;
+    cv::randu(left, cv::Scalar::all(0), cv::Scalar::all(255));
+    cv::Mat tracking_view;
+
+    sl::CalibrationParameters calibration;
+    calibration.left_cam.image_size = display_resolution;
+    calibration.left_cam.fx = calibration.left_cam.fy = 700.f;
+    calibration.left_cam.cx = display_resolution.width / 2.f;
+    calibration.left_cam.cy = display_resolution.height / 2.f;
+    sl::Pose camera_pose;
+    camera_pose.pose_data.setIdentity();
+
+    list<sl::Objects> scenes;
+    list<TrackingViewer> viewers;
+    for (int nb_objects : object_counts) {
+        scenes.emplace_back();
+        auto& scene = scenes.back();
+        scene.object_list = makeObjects(nb_objects, rng);
+        scene.is_new = scene.is_tracked = true;
+        for (auto& obj : scene.object_list) {
+            obj.mask.alloc(sl::Resolution(obj.bounding_box_2d[2].x - obj.bounding_box_2d[0].x, obj.bounding_box_2d[2].y - obj.bounding_box_2d[0].y), sl::MAT_TYPE::U8_C1, sl::MEM::CPU);
+            obj.mask.setTo<sl::uchar1>(255, sl::MEM::CPU);
+        }
+
+        string count = "/" + to_string(nb_objects);
+        suite.add("render_2D/boxes" + count, [&scene, &left, &left_render, img_scale]() {
+            left.copyTo(left_render);
+            render_2D(left_render, img_scale, scene.object_list, false, true);
+        }).items(1);
+        suite.add("render_2D/masks" + count, [&scene, &left, &left_render, img_scale]() {
+            left.copyTo(left_render);
+            render_2D(left_render, img_scale, scene.object_list, true, true);
+        }).items(1);
+
+        for (bool tracking : {false, true}) {
+            viewers.emplace_back(tracks_resolution, 30, 10.f * 1000.f, 3);
+            auto& viewer = viewers.back();
+            viewer.setCameraCalibration(calibration);
+            // A new frame at each call: the tracklets reach the 3 s of history of the sample and stay there
+            uint64_t frame = 0;
+            suite.add(string("generate_view/") + (tracking ? "tracking" : "positions") + count, [&viewer, &scene, &tracking_view, camera_pose, tracking, frame]() mutable {
+                scene.timestamp.setNanoseconds(++frame * FRAME_NS);
+                viewer.generate_view(scene, camera_pose, tracking_view, tracking);
+            }).items(1);
+        }
+    }
+
+    return suite.run(argc, argv);
+}
@@ -27,11 +27,6 @@
 #include <iostream>
 #include <fstream>
 
-// Flag to disable the GUI to increase detection performances
-// On low-end hardware such as Jetson Nano, the GUI significantly slows
-// down the detection and increase the memory consumption
-#define ENABLE_GUI 1
-
 // Flag to enable/disable the batch option in Object Detection module
 // Batching system allows to reconstruct trajectories from the object detection module by adding Re-Identification / Appareance matching.
 // For example, if an object is not seen during some time, it can be re-ID to a previous ID if the matching score is high enough
@@ -47,17 +42,17 @@
 #include "BatchSystemHandler.hpp"
 #endif
 
-#if ENABLE_GUI
+#include "DisplayMode.hpp"
+#include "ZedFrameSource.hpp"
 #include "GLViewer.hpp"
+#include "MatBridge.hpp"
 #include "TrackingViewer.hpp"
-#endif
 
 // Using std and sl namespaces
 using namespace std;
 using namespace sl;
 bool is_playback = false;
 void print(string msg_prefix, ERROR_CODE err_code = ERROR_CODE::SUCCESS, string msg_suffix = "");
-void parseArgs(int argc, char **argv, InitParameters& param);
 
 int main(int argc, char **argv) {
 
@@ -76,8 +71,16 @@ int main(int argc, char **argv) {
     init_parameters.depth_mode = isJetson ? DEPTH_MODE::PERFORMANCE : DEPTH_MODE::ULTRA;
     init_parameters.depth_maximum_distance = 10.0f * 1000.0f;
     init_parameters.coordinate_system = COORDINATE_SYSTEM::RIGHT_HANDED_Y_UP; // OpenGL's coordinate system is right_handed
-	
-    parseArgs(argc, argv, init_parameters);
+
+    // --headless disables the GUI to increase detection performances, --preview N renders it every N frames
+    // On low-end hardware such as Jetson Nano, the GUI significantly slows
+    // down the detection and increase the memory consumption
+    DisplayMode display;
+    if (!display.parse(argc, argv)) return EXIT_FAILURE;
+    // Input of the sample: SVO file, IP[:port] of a stream, camera resolution or --source (FrameSource.hpp)
+    FrameSourceOptions source;
+    if (!source.parse(argc, argv) || !applyFrameSource(source, init_parameters)) return EXIT_FAILURE;
+    is_playback = source.kind == FRAME_SOURCE::SVO;
 
     // Open the camera
     auto returned_state  = zed.open(init_parameters);
@@ -126,8 +129,6 @@ int main(int argc, char **argv) {
     Objects objects;
     bool quit = false;
 
-#if ENABLE_GUI
-
     Resolution display_resolution(min((int)camera_config.resolution.width, 1280) , min((int)camera_config.resolution.height, 720));
     Resolution tracks_resolution(400, display_resolution.height);
     // create a global image to store both image and tracks view
@@ -138,7 +139,7 @@ int main(int argc, char **argv) {
     auto image_track_ocv = global_image(cv::Rect(display_resolution.width, 0, tracks_resolution.width, tracks_resolution.height));
     // init an sl::Mat from the ocv image ref (which is in fact the memory of global_image)
     cv::Mat image_render_left = cv::Mat(display_resolution.height,display_resolution.width,CV_8UC4,1);
-    Mat image_left(display_resolution, MAT_TYPE::U8_C4, image_render_left.data, image_render_left.step);
+    Mat image_left = toSlMat(image_render_left);
     sl::float2 img_scale(display_resolution.width / (float)camera_config.resolution.width, display_resolution.height / (float)camera_config.resolution.height);
 
 
@@ -147,16 +148,18 @@ int main(int argc, char **argv) {
     track_view_generator.setCameraCalibration(camera_config.calibration_parameters);
 
     string window_name = "ZED| 2D View and Birds view";
-    cv::namedWindow(window_name, cv::WINDOW_NORMAL); // Create Window
-    cv::createTrackbar("Confidence", window_name, &detection_confidence, 100);
-
     char key = ' ';
     Resolution pc_resolution(min((int)camera_config.resolution.width, 720) , min((int)camera_config.resolution.height, 404));
     auto camera_parameters = zed.getCameraInformation(pc_resolution).camera_configuration.calibration_parameters.left_cam;
-    Mat point_cloud(pc_resolution, MAT_TYPE::F32_C4, MEM::GPU);
+    Mat point_cloud;
     GLViewer viewer;
-    viewer.init(argc, argv, camera_parameters, detection_parameters.enable_tracking);
-#endif
+    // No window nor GL context when headless
+    if (!display.headless()) {
+        cv::namedWindow(window_name, cv::WINDOW_NORMAL); // Create Window
+        cv::createTrackbar("Confidence", window_name, &detection_confidence, 100);
+        point_cloud.alloc(pc_resolution, MAT_TYPE::F32_C4, MEM::GPU);
+        viewer.init(argc, argv, camera_parameters, detection_parameters.enable_tracking);
+    }
 
     RuntimeParameters runtime_parameters;
     runtime_parameters.confidence_threshold = 50;
@@ -167,12 +170,7 @@ int main(int argc, char **argv) {
     Pose cam_w_pose;
     cam_w_pose.pose_data.setIdentity();
 
-    bool gl_viewer_available=true;
-    while (
-#if ENABLE_GUI
-            gl_viewer_available &&
-#endif
-            !quit && zed.grab(runtime_parameters) == ERROR_CODE::SUCCESS) {
+    while (!quit && display.nextFrame() && zed.grab(runtime_parameters) == ERROR_CODE::SUCCESS) {
 
         // update confidence threshold based on TrackBar
         if(detection_parameters_rt.object_class_filter.empty())
@@ -184,85 +182,93 @@ int main(int argc, char **argv) {
         returned_state = zed.retrieveObjects(objects, detection_parameters_rt);
 
         if ((returned_state == ERROR_CODE::SUCCESS) && objects.is_new) {            
-#if ENABLE_GUI
-            zed.retrieveMeasure(point_cloud, MEASURE::XYZRGBA, MEM::GPU, pc_resolution);
-            zed.getPosition(cam_w_pose, REFERENCE_FRAME::WORLD);
-            zed.retrieveImage(image_left, VIEW::LEFT, MEM::CPU, display_resolution);
-
-            bool update_render_view = true;
-            bool update_3d_view = true;
-            bool update_tracking_view = true;
+            if (!display.headless()) {
+                // With the image retention of the batching, the views are pushed at each frame
+                if (display.renderFrame() || USE_BATCHING) {
+                    zed.retrieveMeasure(point_cloud, MEASURE::XYZRGBA, MEM::GPU, pc_resolution);
+                    zed.getPosition(cam_w_pose, REFERENCE_FRAME::WORLD);
+                    zed.retrieveImage(image_left, VIEW::LEFT, MEM::CPU, display_resolution);
+                }
+
+                bool update_render_view = display.renderFrame();
+                bool update_3d_view = display.renderFrame();
+                bool update_tracking_view = display.renderFrame();
 
 #if USE_BATCHING
-            zed.getPosition(cam_c_pose, REFERENCE_FRAME::CAMERA);
-            std::vector<sl::ObjectsBatch> objectsBatch;
-            zed.getObjectsBatch(objectsBatch);
-            batchHandler.push(cam_c_pose, cam_w_pose, image_left, point_cloud, objectsBatch);
-            batchHandler.pop(cam_c_pose, cam_w_pose, image_left, point_cloud, objects);
-            update_tracking_view = objects.is_new;
-            update_render_view = WITH_IMAGE_RETENTION?objects.is_new:true;
-            update_3d_view = WITH_IMAGE_RETENTION?objects.is_new:true;
+                zed.getPosition(cam_c_pose, REFERENCE_FRAME::CAMERA);
+                std::vector<sl::ObjectsBatch> objectsBatch;
+                zed.getObjectsBatch(objectsBatch);
+                batchHandler.push(cam_c_pose, cam_w_pose, image_left, point_cloud, objectsBatch);
+                batchHandler.pop(cam_c_pose, cam_w_pose, image_left, point_cloud, objects);
+                update_tracking_view = update_tracking_view && objects.is_new;
+                update_render_view = update_render_view && (WITH_IMAGE_RETENTION?objects.is_new:true);
+                update_3d_view = update_3d_view && (WITH_IMAGE_RETENTION?objects.is_new:true);
 #endif
 
-            if (update_render_view) {
-            image_render_left.copyTo(image_left_ocv);
-            render_2D(image_left_ocv, img_scale, objects.object_list, true, detection_parameters.enable_tracking);
-            }
+                if (update_render_view) {
+                image_render_left.copyTo(image_left_ocv);
+                render_2D(image_left_ocv, img_scale, objects.object_list, true, detection_parameters.enable_tracking);
+                }
 
-            if (update_3d_view)
-                viewer.updateData(point_cloud, objects.object_list, cam_w_pose.pose_data);
+                if (update_3d_view)
+                    viewer.updateData(point_cloud, objects.object_list, cam_w_pose.pose_data);
 
-            if (update_tracking_view)
-                track_view_generator.generate_view(objects, cam_w_pose, image_track_ocv, objects.is_tracked);
-#else
+                if (update_tracking_view)
+                    track_view_generator.generate_view(objects, cam_w_pose, image_track_ocv, objects.is_tracked);
+            } else {
 #if USE_BATCHING
-            std::vector<sl::ObjectsBatch> objectsBatch;
-            zed.getObjectsBatch(objectsBatch);
-            batchHandler.push(objectsBatch);
-            batchHandler.pop(objects);
-#endif
-            cout << "Detected " << objects.object_list.size() << " Object(s)" << endl;
+                std::vector<sl::ObjectsBatch> objectsBatch;
+                zed.getObjectsBatch(objectsBatch);
+                batchHandler.push(objectsBatch);
+                batchHandler.pop(objects);
 #endif
+                cout << "Detected " << objects.object_list.size() << " Object(s)" << endl;
+            }
+
+            if (display.hasSink()) {
+                string text = to_string(objects.object_list.size()) + " objects";
+                for (auto& obj : objects.object_list)
+                    text += " " + to_string(obj.id) + ":" + toString(obj.label).c_str() + " " + to_string(obj.position.x) + " " +
+                        to_string(obj.position.y) + " " + to_string(obj.position.z);
+                display.publish(objects.timestamp.getNanoseconds(), text);
+            }
         }
 
         if (is_playback && zed.getSVOPosition() == zed.getSVONumberOfFrames()) {
             quit = true;
         }
 
-#if ENABLE_GUI
-        gl_viewer_available = viewer.isAvailable();
-        // as image_left_ocv and image_track_ocv are both ref of global_image, no need to update it
-        cv::imshow(window_name, global_image);
-        key = cv::waitKey(10);
-        if (key == 'i') {
-            track_view_generator.zoomIn();
-        } else if (key == 'o') {
-            track_view_generator.zoomOut();
-        } else if (key == 'q') {
-            quit = true;
-        } else if (key == 'p') {
-            detection_parameters_rt.object_class_filter.clear();
-            detection_parameters_rt.object_class_filter.push_back(OBJECT_CLASS::PERSON);
-            detection_parameters_rt.object_class_detection_confidence_threshold[OBJECT_CLASS::PERSON] = detection_confidence;
-            cout << "Person only" << endl;
-        } else if (key == 'v') {
-            detection_parameters_rt.object_class_filter.clear();
-            detection_parameters_rt.object_class_filter.push_back(OBJECT_CLASS::VEHICLE);
-            detection_parameters_rt.object_class_detection_confidence_threshold[OBJECT_CLASS::VEHICLE] = detection_confidence;
-            cout << "Vehicle only" << endl;
-        } else if (key == 'c') {
-            detection_parameters_rt.object_class_filter.clear();
-            detection_parameters_rt.object_class_detection_confidence_threshold.clear();
-            cout << "Clear Filters" << endl;
+        if (display.renderFrame()) {
+            if (!viewer.isAvailable()) quit = true;
+            // as image_left_ocv and image_track_ocv are both ref of global_image, no need to update it
+            cv::imshow(window_name, global_image);
+            key = cv::waitKey(10);
+            if (key == 'i') {
+                track_view_generator.zoomIn();
+            } else if (key == 'o') {
+                track_view_generator.zoomOut();
+            } else if (key == 'q') {
+                quit = true;
+            } else if (key == 'p') {
+                detection_parameters_rt.object_class_filter.clear();
+                detection_parameters_rt.object_class_filter.push_back(OBJECT_CLASS::PERSON);
+                detection_parameters_rt.object_class_detection_confidence_threshold[OBJECT_CLASS::PERSON] = detection_confidence;
+                cout << "Person only" << endl;
+            } else if (key == 'v') {
+                detection_parameters_rt.object_class_filter.clear();
+                detection_parameters_rt.object_class_filter.push_back(OBJECT_CLASS::VEHICLE);
+                detection_parameters_rt.object_class_detection_confidence_threshold[OBJECT_CLASS::VEHICLE] = detection_confidence;
+                cout << "Vehicle only" << endl;
+            } else if (key == 'c') {
+                detection_parameters_rt.object_class_filter.clear();
+                detection_parameters_rt.object_class_detection_confidence_threshold.clear();
+                cout << "Clear Filters" << endl;
+            }
         }
-
-#endif
     }
-#if ENABLE_GUI
     viewer.exit();
     point_cloud.free();
     image_left.free();
-#endif
 #if USE_BATCHING
     batchHandler.clear();
 #endif
@@ -285,37 +291,3 @@ void print(string msg_prefix, ERROR_CODE err_code, string msg_suffix) {
         cout << " " << msg_suffix;
     cout << endl;
 }
-
-void parseArgs(int argc, char **argv, InitParameters& param) {
-    if (argc > 1 && string(argv[1]).find(".svo") != string::npos) {
-        // SVO input mode
-        param.input.setFromSVOFile(argv[1]);
-        is_playback = true;
-        cout << "[Sample] Using SVO File input: " << argv[1] << endl;
-    } else if (argc > 1 && string(argv[1]).find(".svo") == string::npos) {
-        string arg = string(argv[1]);
-        unsigned int a, b, c, d, port;
-        if (sscanf(arg.c_str(), "%u.%u.%u.%u:%d", &a, &b, &c, &d, &port) == 5) {
-            // Stream input mode - IP + port
-            string ip_adress = to_string(a) + "." + to_string(b) + "." + to_string(c) + "." + to_string(d);
-            param.input.setFromStream(sl::String(ip_adress.c_str()), port);
-            cout << "[Sample] Using Stream input, IP : " << ip_adress << ", port : " << port << endl;
-        } else if (sscanf(arg.c_str(), "%u.%u.%u.%u", &a, &b, &c, &d) == 4) {
-            // Stream input mode - IP only
-            param.input.setFromStream(sl::String(argv[1]));
-            cout << "[Sample] Using Stream input, IP : " << argv[1] << endl;
-        } else if (arg.find("HD2K") != string::npos) {
-            param.camera_resolution = RESOLUTION::HD2K;
-            cout << "[Sample] Using Camera in resolution HD2K" << endl;
-        } else if (arg.find("HD1080") != string::npos) {
-            param.camera_resolution = RESOLUTION::HD1080;
-            cout << "[Sample] Using Camera in resolution HD1080" << endl;
-        } else if (arg.find("HD720") != string::npos) {
-            param.camera_resolution = RESOLUTION::HD720;
-            cout << "[Sample] Using Camera in resolution HD720" << endl;
-        } else if (arg.find("VGA") != string::npos) {
-            param.camera_resolution = RESOLUTION::VGA;
-            cout << "[Sample] Using Camera in resolution VGA" << endl;
-        }
-    }
-}
@@ -15,7 +15,9 @@
 
 #include <sl/Camera.hpp>
 
+#include "DisplayMode.hpp"
 #include "GLViewer.hpp"
+#include "ZedFrameSource.hpp"
 
 constexpr float CONFIDENCE_THRESHOLD = 0;
 constexpr float NMS_THRESHOLD = 0.4;
@@ -54,7 +56,107 @@ std::vector<sl::uint2> cvt(const cv::Rect &bbox_in){
     return bbox_out;
 }
 
+struct Detection {
+    cv::Rect rect;          ///< in the pixels of the frame
+    int label;
+    float score;
+};
+
+///
+/// \brief The Detector class
+/// YOLO network of OpenCV DNN on the BGRA frames of the source, its buffers kept from frame to frame
+///
+class Detector {
+public:
+    bool load(const std::string& cfg, const std::string& weights) {
+        net = cv::dnn::readNetFromDarknet(cfg, weights);
+        if (net.empty()) return false;
+        net.setPreferableBackend(cv::dnn::DNN_BACKEND_CUDA);
+        net.setPreferableTarget(cv::dnn::DNN_TARGET_CUDA);
+        // net.setPreferableBackend(cv::dnn::DNN_BACKEND_OPENCV);
+        // net.setPreferableTarget(cv::dnn::DNN_TARGET_CPU);
+        output_names = net.getUnconnectedOutLayersNames();
+        return true;
+    }
+
+    ///
+    /// \brief detections of each class in frame, after the non maximum suppression
+    ///
+    const std::vector<Detection>& run(const cv::Mat& frame) {
+        // The network takes 3 channels: resized first, then converted to RGB on the pixels of its input only
+        cv::resize(frame, resized, cv::Size(INFERENCE_SIZE, INFERENCE_SIZE));
+        cv::cvtColor(resized, resized, cv::COLOR_BGRA2RGB);
+
+        cv::dnn::blobFromImage(resized, blob, 0.00392, cv::Size(INFERENCE_SIZE, INFERENCE_SIZE), cv::Scalar(), false, false, CV_32F);
+        net.setInput(blob);
+        net.forward(outputs, output_names);
+
+        for (int c = 0; c < NUM_CLASSES; c++) {
+            boxes[c].clear();
+            scores[c].clear();
+        }
+        for (auto& output : outputs) {
+            const auto num_boxes = output.rows;
+            for (int i = 0; i < num_boxes; i++) {
+                auto x = output.at<float>(i, 0) * frame.cols;
+                auto y = output.at<float>(i, 1) * frame.rows;
+                auto width = output.at<float>(i, 2) * frame.cols;
+                auto height = output.at<float>(i, 3) * frame.rows;
+                cv::Rect rect(x - width / 2, y - height / 2, width, height);
+
+                for (int c = 0; c < NUM_CLASSES; c++) {
+                    auto confidence = *output.ptr<float>(i, 5 + c);
+                    if (confidence >= CONFIDENCE_THRESHOLD) {
+                        boxes[c].push_back(rect);
+                        scores[c].push_back(confidence);
+                    }
+                }
+            }
+        }
+
+        detections.clear();
+        for (int c = 0; c < NUM_CLASSES; c++) {
+            cv::dnn::NMSBoxes(boxes[c], scores[c], 0.0, NMS_THRESHOLD, indices);
+            for (auto idx : indices) detections.push_back({boxes[c][idx], c, scores[c][idx]});
+        }
+        return detections;
+    }
+
+private:
+    cv::dnn::Net net;
+    std::vector<cv::String> output_names;
+    cv::Mat resized, blob;
+    std::vector<cv::Mat> outputs;
+    std::vector<cv::Rect> boxes[NUM_CLASSES];
+    std::vector<float> scores[NUM_CLASSES];
+    std::vector<int> indices;
+    std::vector<Detection> detections;
+};
+
+std::string className(const std::vector<std::string>& class_names, int label) {
+    return label >= 0 && label < (int) class_names.size() ? class_names[label] : std::to_string(label);
+}
+
+void drawDetection(cv::Mat& frame, const Detection& detection, const std::vector<std::string>& class_names) {
+    const auto color = colors[detection.label % NUM_COLORS];
+    const auto& rect = detection.rect;
+    cv::rectangle(frame, rect, color, 3);
+
+    std::ostringstream label_ss;
+    label_ss << className(class_names, detection.label) << ": " << std::fixed << std::setprecision(2) << detection.score;
+    auto label = label_ss.str();
+
+    int baseline;
+    auto label_bg_sz = cv::getTextSize(label.c_str(), cv::FONT_HERSHEY_COMPLEX_SMALL, 1, 1, &baseline);
+    cv::rectangle(frame, cv::Point(rect.x, rect.y - label_bg_sz.height - baseline - 10), cv::Point(rect.x + label_bg_sz.width, rect.y), color, cv::FILLED);
+    cv::putText(frame, label.c_str(), cv::Point(rect.x, rect.y - baseline - 5), cv::FONT_HERSHEY_COMPLEX_SMALL, 1, cv::Scalar(0, 0, 0));
+}
+
 int main(int argc, char** argv) {
+    // --headless, --preview N, --sink
+    DisplayMode display;
+    if (!display.parse(argc, argv)) return EXIT_FAILURE;
+
     std::vector<std::string> class_names;
     {
         std::ifstream class_file("coco.names.txt");
@@ -68,43 +170,58 @@ int main(int argc, char** argv) {
         }
     }
 
-    /// Opening the ZED camera before the model deserialization to avoid cuda context issue
-    sl::Camera zed;
     sl::InitParameters init_parameters;
     init_parameters.camera_resolution = sl::RESOLUTION::HD1080;
     init_parameters.depth_mode = sl::DEPTH_MODE::ULTRA;
     init_parameters.coordinate_system = sl::COORDINATE_SYSTEM::RIGHT_HANDED_Y_UP; // OpenGL's coordinate system is right_handed
 
-    if (argc >= 2) {
-        std::string zed_opt = argv[1];
-        if (zed_opt.find(".svo") != std::string::npos)
-            init_parameters.input.setFromSVOFile(zed_opt.c_str());
-    }
-    // Open the camera
-    auto returned_state = zed.open(init_parameters);
-    if (returned_state != sl::ERROR_CODE::SUCCESS) {
-        print("Camera Open", returned_state, "Exit program.");
-        return EXIT_FAILURE;
-    }
-    zed.enablePositionalTracking();
-    // Custom OD
-    sl::ObjectDetectionParameters detection_parameters;
-    detection_parameters.enable_tracking = true;
-    // Let's define the model as custom box object to specify that the inference is done externally
-    detection_parameters.detection_model = sl::DETECTION_MODEL::CUSTOM_BOX_OBJECTS;
-    returned_state = zed.enableObjectDetection(detection_parameters);
-    if (returned_state != sl::ERROR_CODE::SUCCESS) {
-        print("enableObjectDetection", returned_state, "\nExit program.");
-        zed.close();
-        return EXIT_FAILURE;
-    }
-    auto camera_config = zed.getCameraInformation().camera_configuration;
-    sl::Resolution pc_resolution(std::min((int) camera_config.resolution.width, 720), std::min((int) camera_config.resolution.height, 404));
-    auto camera_info = zed.getCameraInformation(pc_resolution).camera_configuration;
-    // Create OpenGL Viewer
+    // Input of the sample: SVO file, IP[:port] of a stream, camera resolution or --source (FrameSource.hpp).
+    // The camera inputs add the 3D localization and the tracking of the SDK to the 2D detections, the other sources
+    // (images, raw container, synthetic frames) give the 2D detections only
+    FrameSourceOptions source;
+    if (!source.parse(argc, argv)) return EXIT_FAILURE;
+    std::unique_ptr<FrameSource> frames;
+    ZedFrameSource* zed_source = nullptr;
+    if (source.usesCamera()) {
+        // The detections are ingested for the frame just grabbed: no grab ahead in a thread
+        if (source.prefetch > 0) {
+            std::cout << "[Sample][Error] --prefetch is not available with a camera, SVO or stream input, the SDK tracks the detections of the last grab" << std::endl;
+            return EXIT_FAILURE;
+        }
+        zed_source = new ZedFrameSource(source, init_parameters);
+        zed_source->setTracking(true);
+        // The depth is used by the SDK only, for the 3D of the objects
+        zed_source->setDepth(false);
+        zed_source->setMaxFrames(source.max_frames);
+        frames.reset(zed_source);
+    } else
+        frames = FrameSource::create(source);
+
+    /// Opening the ZED camera before the model deserialization to avoid cuda context issue
+    if (!frames || !frames->open()) return EXIT_FAILURE;
+    sl::Camera* zed = zed_source ? &zed_source->camera() : nullptr;
+
     GLViewer viewer;
-    viewer.init(argc, argv, camera_info.calibration_parameters.left_cam, true);
-    sl::Mat left_sl, point_cloud;
+    sl::Resolution pc_resolution;
+    if (zed) {
+        // Custom OD
+        sl::ObjectDetectionParameters detection_parameters;
+        detection_parameters.enable_tracking = true;
+        // Let's define the model as custom box object to specify that the inference is done externally
+        detection_parameters.detection_model = sl::DETECTION_MODEL::CUSTOM_BOX_OBJECTS;
+        auto returned_state = zed->enableObjectDetection(detection_parameters);
+        if (returned_state != sl::ERROR_CODE::SUCCESS) {
+            print("enableObjectDetection", returned_state, "\nExit program.");
+            return EXIT_FAILURE;
+        }
+        auto camera_config = zed->getCameraInformation().camera_configuration;
+        pc_resolution = sl::Resolution(std::min((int) camera_config.resolution.width, 720), std::min((int) camera_config.resolution.height, 404));
+        auto camera_info = zed->getCameraInformation(pc_resolution).camera_configuration;
+        // Create OpenGL Viewer, no window nor GL context when headless
+        if (!display.headless()) viewer.init(argc, argv, camera_info.calibration_parameters.left_cam, true);
+    }
+    const bool gl_viewer = zed && !display.headless();
+    sl::Mat point_cloud;
     sl::ObjectDetectionRuntimeParameters objectTracker_parameters_rt;
     sl::Objects objects;
     sl::Pose cam_w_pose;
@@ -112,97 +229,76 @@ int main(int argc, char** argv) {
     // ---------
 
     // Weight can be downloaded from https://github.com/AlexeyAB/darknet/releases/download/darknet_yolo_v3_optimal/yolov4.weights
-    auto net = cv::dnn::readNetFromDarknet("yolov4.cfg", "yolov4.weights");
-    net.setPreferableBackend(cv::dnn::DNN_BACKEND_CUDA);
-    net.setPreferableTarget(cv::dnn::DNN_TARGET_CUDA);
-    // net.setPreferableBackend(cv::dnn::DNN_BACKEND_OPENCV);
-    // net.setPreferableTarget(cv::dnn::DNN_TARGET_CPU);
-    auto output_names = net.getUnconnectedOutLayersNames();
-
-    cv::Mat frame, blob;
-    std::vector<cv::Mat> detections;
-    while (viewer.isAvailable()) {
-        if (zed.grab() == sl::ERROR_CODE::SUCCESS) {
-
-            zed.retrieveImage(left_sl, sl::VIEW::LEFT);
-
-            // Preparing inference
-            cv::Mat left_cv_rgba = slMat2cvMat(left_sl);
-            cv::cvtColor(left_cv_rgba, frame, cv::COLOR_BGRA2BGR);
-
-            cv::dnn::blobFromImage(frame, blob, 0.00392, cv::Size(INFERENCE_SIZE, INFERENCE_SIZE), cv::Scalar(), true, false, CV_32F);
-            net.setInput(blob);
-            net.forward(detections, output_names);
-
-            std::vector<int> indices[NUM_CLASSES];
-            std::vector<cv::Rect> boxes[NUM_CLASSES];
-            std::vector<float> scores[NUM_CLASSES];
-
-            for (auto& output : detections) {
-                const auto num_boxes = output.rows;
-                for (int i = 0; i < num_boxes; i++) {
-                    auto x = output.at<float>(i, 0) * frame.cols;
-                    auto y = output.at<float>(i, 1) * frame.rows;
-                    auto width = output.at<float>(i, 2) * frame.cols;
-                    auto height = output.at<float>(i, 3) * frame.rows;
-                    cv::Rect rect(x - width / 2, y - height / 2, width, height);
-
-                    for (int c = 0; c < NUM_CLASSES; c++) {
-                        auto confidence = *output.ptr<float>(i, 5 + c);
-                        if (confidence >= CONFIDENCE_THRESHOLD) {
-                            boxes[c].push_back(rect);
-                            scores[c].push_back(confidence);
-                        }
-                    }
-                }
-            }
+    Detector detector;
+    if (!detector.load("yolov4.cfg", "yolov4.weights")) {
+        std::cout << "[Sample][Error] Cannot load yolov4.cfg and yolov4.weights, run the sample from the folder of the model" << std::endl;
+        return EXIT_FAILURE;
+    }
 
-            for (int c = 0; c < NUM_CLASSES; c++)
-                cv::dnn::NMSBoxes(boxes[c], scores[c], 0.0, NMS_THRESHOLD, indices[c]);
-
-            std::vector<sl::CustomBoxObjectData> objects_in;
-            for (int c = 0; c < NUM_CLASSES; c++) {
-                for (size_t i = 0; i < indices[c].size(); ++i) {
-                    const auto color = colors[c % NUM_COLORS];
-
-                    auto idx = indices[c][i];
-                    const auto& rect = boxes[c][idx];
-                    auto& rect_score = scores[c][idx];
-
-                    // Fill the detections into the correct format
-                    sl::CustomBoxObjectData tmp;
-                    tmp.unique_object_id = sl::generate_unique_id();
-                    tmp.probability = rect_score;
-                    tmp.label = c;
-                    tmp.bounding_box_2d = cvt(rect);
-                    tmp.is_grounded = (c == 0); // Only the first class (person) is grounded, that is moving on the floor plane
-                    // others are tracked in full 3D space
-                    objects_in.push_back(tmp);
-                    //--
-
-                    cv::rectangle(frame, rect, color, 3);
-
-                    std::ostringstream label_ss;
-                    label_ss << class_names[c] << ": " << std::fixed << std::setprecision(2) << scores[c][idx];
-                    auto label = label_ss.str();
-
-                    int baseline;
-                    auto label_bg_sz = cv::getTextSize(label.c_str(), cv::FONT_HERSHEY_COMPLEX_SMALL, 1, 1, &baseline);
-                    cv::rectangle(frame, cv::Point(rect.x, rect.y - label_bg_sz.height - baseline - 10), cv::Point(rect.x + label_bg_sz.width, rect.y), color, cv::FILLED);
-                    cv::putText(frame, label.c_str(), cv::Point(rect.x, rect.y - baseline - 5), cv::FONT_HERSHEY_COMPLEX_SMALL, 1, cv::Scalar(0, 0, 0));
-                }
+    FrameBundle bundle;
+    std::vector<sl::CustomBoxObjectData> objects_in;
+    while (display.nextFrame()) {
+        if (display.renderFrame() && gl_viewer && !viewer.isAvailable()) break;
+        auto status = frames->read(bundle);
+        if (status != FRAME_STATUS::FRAME) {
+            // At the end of a SVO, the 3D view stays open until closed
+            if (status == FRAME_STATUS::END && gl_viewer) continue;
+            break;
+        }
+
+        // BGRA view of the image of the source, drawn as it is
+        cv::Mat frame(bundle.image.height, bundle.image.width, CV_8UC4, bundle.image.data.data(), bundle.image.step);
+        const auto& detections = detector.run(frame);
+
+        objects_in.clear();
+        for (auto& detection : detections) {
+            if (zed) {
+                // Fill the detections into the correct format
+                sl::CustomBoxObjectData tmp;
+                tmp.unique_object_id = sl::generate_unique_id();
+                tmp.probability = detection.score;
+                tmp.label = detection.label;
+                tmp.bounding_box_2d = cvt(detection.rect);
+                tmp.is_grounded = (detection.label == 0); // Only the first class (person) is grounded, that is moving on the floor plane
+                // others are tracked in full 3D space
+                objects_in.push_back(tmp);
             }
-            // Send the custom detected boxes to the ZED
-            zed.ingestCustomBoxObjects(objects_in);
+            if (display.renderFrame()) drawDetection(frame, detection, class_names);
+        }
 
+        if (display.renderFrame()) {
             cv::imshow("Objects", frame);
             cv::waitKey(10);
+        }
+
+        if (!zed) {
+            // 2D detections only, in pixels
+            if (display.hasSink()) {
+                std::string text = std::to_string(detections.size()) + " objects";
+                for (auto& detection : detections)
+                    text += " " + className(class_names, detection.label) + " " + std::to_string(detection.rect.x) + " " + std::to_string(detection.rect.y) +
+                        " " + std::to_string(detection.rect.width) + " " + std::to_string(detection.rect.height);
+                display.publish(bundle.timestamp, text);
+            }
+            continue;
+        }
 
-            // Retrieve the tracked objects, with 2D and 3D attributes
-            zed.retrieveObjects(objects, objectTracker_parameters_rt);
+        // Send the custom detected boxes to the ZED
+        zed->ingestCustomBoxObjects(objects_in);
+        // Retrieve the tracked objects, with 2D and 3D attributes
+        zed->retrieveObjects(objects, objectTracker_parameters_rt);
+        if (display.hasSink()) {
+            std::string text = std::to_string(objects.object_list.size()) + " objects";
+            for (auto& obj : objects.object_list)
+                text += " " + std::to_string(obj.id) + ":" + className(class_names, obj.raw_label) +
+                    " " + std::to_string(obj.position.x) + " " +
+                    std::to_string(obj.position.y) + " " + std::to_string(obj.position.z);
+            display.publish(objects.timestamp.getNanoseconds(), text);
+        }
+        if (display.renderFrame()) {
             // GL Viewer
-            zed.retrieveMeasure(point_cloud, sl::MEASURE::XYZRGBA, sl::MEM::GPU, pc_resolution);
-            zed.getPosition(cam_w_pose, sl::REFERENCE_FRAME::WORLD);
+            zed->retrieveMeasure(point_cloud, sl::MEASURE::XYZRGBA, sl::MEM::GPU, pc_resolution);
+            zed->getPosition(cam_w_pose, sl::REFERENCE_FRAME::WORLD);
             viewer.updateData(point_cloud, objects.object_list, cam_w_pose.pose_data);
         }
     }
@@ -21,6 +21,8 @@ static inline cv::Mat preprocess_img(cv::Mat& img, int input_w, int input_h) {
     }
     cv::Mat re(h, w, CV_8UC3);
     cv::resize(img, re, re.size(), 0, 0, cv::INTER_LINEAR);
+    // BGRA frames of the ZED are converted once resized: on the pixels of the network input only
+    if (re.channels() == 4) cv::cvtColor(re, re, cv::COLOR_BGRA2BGR);
     cv::Mat out(input_h, input_w, CV_8UC3, cv::Scalar(128, 128, 128));
     re.copyTo(out(cv::Rect(x, y, re.cols, re.rows)));
     return out;
@@ -0,0 +1,90 @@
+// Benchmark of the CPU side of the detector on synthetic inputs: letterbox of the ZED frames (preprocess_img),
+// NMS of the output of the yolo layer (nms) and boxes back in the image (get_rect). No GPU, engine nor camera.
+
+#include <random>
+#include <vector>
+
+#include "common.hpp"
+#include "utils.h"
+#include "BenchSuite.hpp"
+
+static const int DET_SIZE = sizeof (Yolo::Detection) / sizeof (float);
+static const int OUTPUT_SIZE = Yolo::MAX_OUTPUT_BBOX_COUNT * DET_SIZE + 1;
+
+// Output of the yolo layer: count, then the candidates. They come in clusters, as around real objects, so that the
+// NMS has boxes to suppress
+static std::vector<float> makeOutput(int nb_candidates, int nb_classes, std::mt19937& rng) {
+    std::vector<float> output(OUTPUT_SIZE, 0.f);
+    std::uniform_real_distribution<float> center(40.f, Yolo::INPUT_W - 40.f), size(16.f, 160.f), jitter(-8.f, 8.f), conf(0.1f, 1.f);
+    std::uniform_int_distribution<int> class_id(0, nb_classes - 1);
+    output[0] = static_cast<float>(nb_candidates);
+    Yolo::Detection cluster{};
+    for (int i = 0; i < nb_candidates; i++) {
+        if (i % 8 == 0) {
+            cluster.bbox[0] = center(rng);
+            cluster.bbox[1] = center(rng);
+            cluster.bbox[2] = size(rng);
+            cluster.bbox[3] = size(rng);
+            cluster.class_id = static_cast<float>(class_id(rng));
+        }
+        Yolo::Detection det = cluster;
+        det.bbox[0] += jitter(rng);
+        det.bbox[1] += jitter(rng);
+        det.conf = conf(rng);
+        memcpy(&output[1 + DET_SIZE * i], &det, sizeof (det));
+    }
+    return output;
+}
+
+int main(int argc, char** argv) {
+    BenchSuite suite("ZED_Yolov5_Postprocess_Bench");
+    suite.setContext("opencv", CV_VERSION);
+    // Single threaded, as the resize of a single frame in the sample loop
+    cv::setNumThreads(1);
+
+    struct { const char* name; int width, height; } resolutions[] = {
+        {"HD720", 1280, 720}, {"HD1080", 1920, 1080}, {"HD2K", 2208, 1242}
+    };
+    // The lambdas of the suite keep references to the frames
+    std::vector<cv::Mat> frames;
+    for (auto& res : resolutions) {
+        frames.emplace_back(res.height, res.width, CV_8UC4);
+        cv::randu(frames.back(), cv::Scalar::all(0), cv::Scalar::all(255));
+    }
+    for (size_t i = 0; i < frames.size(); i++) {
+        auto& frame = frames[i];
+        cv::Mat input = preprocess_img(frame, Yolo::INPUT_W, Yolo::INPUT_H);
+        suite.check(input.cols == Yolo::INPUT_W && input.rows == Yolo::INPUT_H && input.type() == CV_8UC3, "letterbox of the BGRA frame");
+        suite.add(std::string("preprocess_img/") + resolutions[i].name, [&frame]() {
+            doNotOptimize(preprocess_img(frame, Yolo::INPUT_W, Yolo::INPUT_H).data);
+        }).items(1);
+    }
+
+    std::mt19937 rng(42);
+    struct NmsCase { const char* name; int nb_candidates, nb_classes; };
+    static const NmsCase nms_cases[] = { {"100x4", 100, 4}, {"1000x4", 1000, 4}, {"1000x80", 1000, Yolo::CLASS_NUM} };
+    std::vector<std::vector<float>> outputs;
+    for (auto& nms_case : nms_cases) outputs.push_back(makeOutput(nms_case.nb_candidates, nms_case.nb_classes, rng));
+
+    std::vector<Yolo::Detection> res;
+    for (size_t i = 0; i < outputs.size(); i++) {
+        auto& output = outputs[i];
+        res.clear();
+        nms(res, output.data(), 0.5f, 0.4f);
+        suite.check(!res.empty() && res.size() < static_cast<size_t>(nms_cases[i].nb_candidates), std::string("nms keeps some of the boxes of ") + nms_cases[i].name);
+        suite.add(std::string("nms/") + nms_cases[i].name, [&res, &output]() {
+            res.clear();
+            nms(res, output.data(), 0.5f, 0.4f);
+        }).items(nms_cases[i].nb_candidates);
+    }
+
+    // Boxes kept by the NMS of 1000 candidates, back in a HD1080 frame
+    std::vector<Yolo::Detection> kept;
+    nms(kept, outputs[1].data(), 0.5f, 0.4f);
+    auto& hd1080 = frames[1];
+    suite.add("get_rect/HD1080", [&kept, &hd1080]() {
+        for (auto& det : kept) doNotOptimize(get_rect(hd1080, det.bbox));
+    }).items(static_cast<double>(kept.size()));
+
+    return suite.run(argc, argv);
+}
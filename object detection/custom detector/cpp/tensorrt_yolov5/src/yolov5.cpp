@@ -6,7 +6,10 @@
 #include "common.hpp"
 #include "utils.h"
 #include "calibrator.h"
+#include "DisplayMode.hpp"
 #include "GLViewer.hpp"
+#include "MatBridge.hpp"
+#include "StageTrace.hpp"
 
 #include <sl/Camera.hpp>
 
@@ -332,10 +335,16 @@ int main(int argc, char** argv) {
     std::string engine_name = "";
     bool is_p6 = false;
     float gd = 0.0f, gw = 0.0f;
+    // --headless, --preview N, --sink
+    DisplayMode display;
+    if (!display.parse(argc, argv)) return -1;
+    // --trace <file.json>, --trace-stats
+    StageTrace trace;
+    if (!trace.parse(argc, argv)) return -1;
     if (!parse_args(argc, argv, wts_name, engine_name, is_p6, gd, gw)) {
         std::cerr << "arguments not right!" << std::endl;
         std::cerr << "./yolov5 -s [.wts] [.engine] [s/m/l/x/s6/m6/l6/x6 or c/c6 gd gw]  // serialize model to plan file" << std::endl;
-        std::cerr << "./yolov5 -d [.engine] ZED_input_option  // deserialize plan file and run inference" << std::endl;
+        std::cerr << "./yolov5 -d [.engine] ZED_input_option " << DisplayMode::usage() << " " << StageTrace::usage() << "  // deserialize plan file and run inference" << std::endl;
         return -1;
     }
 
@@ -389,9 +398,9 @@ int main(int argc, char** argv) {
     auto camera_config = zed.getCameraInformation().camera_configuration;
     sl::Resolution pc_resolution(std::min((int) camera_config.resolution.width, 720), std::min((int) camera_config.resolution.height, 404));
     auto camera_info = zed.getCameraInformation(pc_resolution).camera_configuration;
-    // Create OpenGL Viewer
+    // Create OpenGL Viewer, no window nor GL context when headless
     GLViewer viewer;
-    viewer.init(argc, argv, camera_info.calibration_parameters.left_cam, true);
+    if (!display.headless()) viewer.init(argc, argv, camera_info.calibration_parameters.left_cam, true);
     // ---------
 
 
@@ -439,22 +448,29 @@ int main(int argc, char** argv) {
     assert(BATCH_SIZE == 1); // This sample only support batch 1 for now
 
     sl::Mat left_sl, point_cloud;
-    cv::Mat left_cv_rgb;
     sl::ObjectDetectionRuntimeParameters objectTracker_parameters_rt;
     sl::Objects objects;
     sl::Pose cam_w_pose;
     cam_w_pose.pose_data.setIdentity();
 
-    while (viewer.isAvailable()) {
-        if (zed.grab() == sl::ERROR_CODE::SUCCESS) {
+    while (display.nextFrame()) {
+        if (display.renderFrame() && !viewer.isAvailable()) break;
+        STAGE_SPAN("frame");
+        StageSpan grab_span("grab");
+        returned_state = zed.grab();
+        grab_span.end();
+        if (returned_state == sl::ERROR_CODE::SUCCESS) {
 
+            StageSpan retrieve_span("retrieveImage");
             zed.retrieveImage(left_sl, sl::VIEW::LEFT);
+            retrieve_span.end();
 
             // Preparing inference
-            cv::Mat left_cv_rgba = slMat2cvMat(left_sl);
-            cv::cvtColor(left_cv_rgba, left_cv_rgb, cv::COLOR_BGRA2BGR);
-            if (left_cv_rgb.empty()) continue;
-            cv::Mat pr_img = preprocess_img(left_cv_rgb, INPUT_W, INPUT_H); // letterbox BGR to RGB
+            // BGRA view of the image: no full resolution conversion, the letterbox converts the network input
+            cv::Mat left_cv_rgba = toCvMat<sl::uchar4>(left_sl);
+            if (left_cv_rgba.empty()) continue;
+            StageSpan preprocess_span("preprocess");
+            cv::Mat pr_img = preprocess_img(left_cv_rgba, INPUT_W, INPUT_H); // letterbox BGR to RGB
             int i = 0;
             int batch = 0;
             for (int row = 0; row < INPUT_H; ++row) {
@@ -468,17 +484,23 @@ int main(int argc, char** argv) {
                 }
             }
 
+            preprocess_span.end();
+
             // Running inference
+            StageSpan inference_span("inference");
             doInference(*context, stream, buffers, data, prob, BATCH_SIZE);
+            inference_span.end();
+            StageSpan nms_span("nms");
             std::vector<std::vector < Yolo::Detection >> batch_res(BATCH_SIZE);
             auto& res = batch_res[batch];
             nms(res, &prob[batch * OUTPUT_SIZE], CONF_THRESH, NMS_THRESH);
+            nms_span.end();
 
             // Preparing for ZED SDK ingesting
             std::vector<sl::CustomBoxObjectData> objects_in;
             for (auto &it : res) {
                 sl::CustomBoxObjectData tmp;
-                cv::Rect r = get_rect(left_cv_rgb, it.bbox);
+                cv::Rect r = get_rect(left_cv_rgba, it.bbox);
                 // Fill the detections into the correct format
                 tmp.unique_object_id = sl::generate_unique_id();
                 tmp.probability = it.conf;
@@ -489,25 +511,43 @@ int main(int argc, char** argv) {
                 objects_in.push_back(tmp);
             }
             // Send the custom detected boxes to the ZED
+            StageSpan ingest_span("ingestCustomBoxObjects");
             zed.ingestCustomBoxObjects(objects_in);
+            ingest_span.end();
 
 
-            // Displaying 'raw' objects
-            for (size_t j = 0; j < res.size(); j++) {
-                cv::Rect r = get_rect(left_cv_rgb, res[j].bbox);
-                cv::rectangle(left_cv_rgb, r, cv::Scalar(0x27, 0xC1, 0x36), 2);
-                cv::putText(left_cv_rgb, std::to_string((int) res[j].class_id), cv::Point(r.x, r.y - 1), cv::FONT_HERSHEY_PLAIN, 1.2, cv::Scalar(0xFF, 0xFF, 0xFF), 2);
+            if (display.renderFrame()) {
+                STAGE_SPAN("imshow");
+                // Displaying 'raw' objects
+                for (size_t j = 0; j < res.size(); j++) {
+                    cv::Rect r = get_rect(left_cv_rgba, res[j].bbox);
+                    cv::rectangle(left_cv_rgba, r, cv::Scalar(0x27, 0xC1, 0x36), 2);
+                    cv::putText(left_cv_rgba, std::to_string((int) res[j].class_id), cv::Point(r.x, r.y - 1), cv::FONT_HERSHEY_PLAIN, 1.2, cv::Scalar(0xFF, 0xFF, 0xFF), 2);
+                }
+                cv::imshow("Objects", left_cv_rgba);
+                cv::waitKey(10);
             }
-            cv::imshow("Objects", left_cv_rgb);
-            cv::waitKey(10);
 
             // Retrieve the tracked objects, with 2D and 3D attributes
+            StageSpan objects_span("retrieveObjects");
             zed.retrieveObjects(objects, objectTracker_parameters_rt);
-            // GL Viewer
-            zed.retrieveMeasure(point_cloud, sl::MEASURE::XYZRGBA, sl::MEM::GPU, pc_resolution);
-            zed.getPosition(cam_w_pose, sl::REFERENCE_FRAME::WORLD);
-            viewer.updateData(point_cloud, objects.object_list, cam_w_pose.pose_data);
-        }
+            objects_span.end();
+            if (display.hasSink()) {
+                std::string text = std::to_string(objects.object_list.size()) + " objects";
+                for (auto& obj : objects.object_list)
+                    text += " " + std::to_string(obj.id) + ":" + std::to_string(obj.raw_label) + " " + std::to_string(obj.position.x) + " " +
+                        std::to_string(obj.position.y) + " " + std::to_string(obj.position.z);
+                display.publish(objects.timestamp.getNanoseconds(), text);
+            }
+            if (display.renderFrame()) {
+                STAGE_SPAN("viewer");
+                // GL Viewer
+                zed.retrieveMeasure(point_cloud, sl::MEASURE::XYZRGBA, sl::MEM::GPU, pc_resolution);
+                zed.getPosition(cam_w_pose, sl::REFERENCE_FRAME::WORLD);
+                viewer.updateData(point_cloud, objects.object_list, cam_w_pose.pose_data);
+            }
+        } else if (returned_state == sl::ERROR_CODE::END_OF_SVOFILE_REACHED && display.headless())
+            break;
     }
 
     // Release stream and buffers
@@ -519,6 +559,7 @@ int main(int argc, char** argv) {
     engine->destroy();
     runtime->destroy();
     viewer.exit();
+    trace.finish();
 
     return 0;
 }
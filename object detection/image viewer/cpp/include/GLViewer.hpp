@@ -11,6 +11,8 @@
 #include <GL/glew.h>
 #include <GL/freeglut.h>
 
+#include "GLPresenter.hpp"
+
 #include <cuda.h>
 #include <cuda_gl_interop.h>
 
@@ -132,8 +134,7 @@ public:
 
 private:
     GLuint texID;
-    GLuint imageTex;
-    cudaGraphicsResource* cuda_gl_ressource;//cuda GL resource
+    GLPresenter presenter;
     ShaderData shaderImage;
     GLuint quad_vb;
 };
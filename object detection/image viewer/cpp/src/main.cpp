@@ -27,6 +27,8 @@
 #include <sl/Camera.hpp>
 
 // Sample includes
+#include "DisplayMode.hpp"
+#include "ZedFrameSource.hpp"
 #include "GLViewer.hpp"
 
 // Using std and sl namespaces
@@ -34,7 +36,6 @@ using namespace std;
 using namespace sl;
 
 void print(string msg_prefix, ERROR_CODE err_code = ERROR_CODE::SUCCESS, string msg_suffix = "");
-void parseArgs(int argc, char **argv, InitParameters& param);
 
 int main(int argc, char **argv) {
 
@@ -52,7 +53,12 @@ int main(int argc, char **argv) {
 	init_parameters.depth_mode = isJetson ? DEPTH_MODE::PERFORMANCE : DEPTH_MODE::ULTRA;
 	init_parameters.coordinate_system = COORDINATE_SYSTEM::RIGHT_HANDED_Y_UP;
 	init_parameters.coordinate_units = UNIT::METER;
-	parseArgs(argc, argv, init_parameters);
+	// --headless, --preview N, --sink
+	DisplayMode display;
+	if (!display.parse(argc, argv)) return EXIT_FAILURE;
+	// Input of the sample: SVO file, IP[:port] of a stream, camera resolution or --source (FrameSource.hpp)
+	FrameSourceOptions source;
+	if (!source.parse(argc, argv) || !applyFrameSource(source, init_parameters)) return EXIT_FAILURE;
 
 	// Open the camera
 	auto returned_state = zed.open(init_parameters);
@@ -86,9 +92,9 @@ int main(int argc, char **argv) {
 	}
 
 	auto camera_info = zed.getCameraInformation().camera_configuration;
-	// Create OpenGL Viewer
+	// Create OpenGL Viewer, no GL context when headless
 	GLViewer viewer;
-	viewer.init(argc, argv, camera_info.calibration_parameters.left_cam, obj_det_params.enable_tracking = true);
+	if (!display.headless()) viewer.init(argc, argv, camera_info.calibration_parameters.left_cam, obj_det_params.enable_tracking = true);
 
 	// Configure object detection runtime parameters
 	ObjectDetectionRuntimeParameters objectTracker_parameters_rt;
@@ -106,19 +112,31 @@ int main(int argc, char **argv) {
 
 	// Main Loop
 	bool need_floor_plane = positional_tracking_parameters.set_as_static;
-	while (viewer.isAvailable()) {
+	while (display.nextFrame()) {
+		if (display.renderFrame() && !viewer.isAvailable()) break;
 		// Grab images
-		if (zed.grab() == ERROR_CODE::SUCCESS) {
-
-			// Retrieve left image
-			zed.retrieveImage(image, VIEW::LEFT, MEM::GPU);
+		returned_state = zed.grab();
+		if (returned_state == ERROR_CODE::SUCCESS) {
 
 			// Retrieve Detected Human Bodies
 			zed.retrieveObjects(objects, objectTracker_parameters_rt);
 
-			//Update GL View
-			viewer.updateView(image, objects);
-		}
+			if (display.renderFrame()) {
+				// Retrieve left image, only displayed
+				zed.retrieveImage(image, VIEW::LEFT, MEM::GPU);
+				//Update GL View
+				viewer.updateView(image, objects);
+			}
+
+			if (display.hasSink()) {
+				string text = to_string(objects.object_list.size()) + " objects";
+				for (auto& obj : objects.object_list)
+					text += " " + to_string(obj.id) + ":" + toString(obj.label).c_str() + " " + to_string(obj.position.x) + " " +
+						to_string(obj.position.y) + " " + to_string(obj.position.z);
+				display.publish(objects.timestamp.getNanoseconds(), text);
+			}
+		} else if (returned_state == ERROR_CODE::END_OF_SVOFILE_REACHED && display.headless())
+			break;
 	}
 
 	// Release objects
@@ -132,44 +150,6 @@ int main(int argc, char **argv) {
 	return EXIT_SUCCESS;
 }
 
-void parseArgs(int argc, char **argv, InitParameters& param) {
-	if (argc > 1 && string(argv[1]).find(".svo") != string::npos) {
-		// SVO input mode
-		param.input.setFromSVOFile(argv[1]);
-		cout << "[Sample] Using SVO File input: " << argv[1] << endl;
-	}
-	else if (argc > 1 && string(argv[1]).find(".svo") == string::npos) {
-		string arg = string(argv[1]);
-		unsigned int a, b, c, d, port;
-		if (sscanf(arg.c_str(), "%u.%u.%u.%u:%d", &a, &b, &c, &d, &port) == 5) {
-			// Stream input mode - IP + port
-			string ip_adress = to_string(a) + "." + to_string(b) + "." + to_string(c) + "." + to_string(d);
-			param.input.setFromStream(String(ip_adress.c_str()), port);
-			cout << "[Sample] Using Stream input, IP : " << ip_adress << ", port : " << port << endl;
-		}
-		else if (sscanf(arg.c_str(), "%u.%u.%u.%u", &a, &b, &c, &d) == 4) {
-			// Stream input mode - IP only
-			param.input.setFromStream(String(argv[1]));
-			cout << "[Sample] Using Stream input, IP : " << argv[1] << endl;
-		}
-		else if (arg.find("HD2K") != string::npos) {
-			param.camera_resolution = RESOLUTION::HD2K;
-			cout << "[Sample] Using Camera in resolution HD2K" << endl;
-		}
-		else if (arg.find("HD1080") != string::npos) {
-			param.camera_resolution = RESOLUTION::HD1080;
-			cout << "[Sample] Using Camera in resolution HD1080" << endl;
-		}
-		else if (arg.find("HD720") != string::npos) {
-			param.camera_resolution = RESOLUTION::HD720;
-			cout << "[Sample] Using Camera in resolution HD720" << endl;
-		}
-		else if (arg.find("VGA") != string::npos) {
-			param.camera_resolution = RESOLUTION::VGA;
-			cout << "[Sample] Using Camera in resolution VGA" << endl;
-		}
-	}
-}
 
 void print(string msg_prefix, ERROR_CODE err_code, string msg_suffix) {
 	cout << "[Sample]";
@@ -0,0 +1,76 @@
+#ifndef BOX_BLUR_H
+#define BOX_BLUR_H
+
+/* box_blur.h.
+ *
+ * This file contains the parameters of the constant-time version of the
+ * depth-dependent blur (convolutionRowsBox / convolutionColumnsBox).
+ * The gaussian kernel of each radius is replaced by the convolution of 3 boxes
+ * closest to it, a bell shaped filter evaluated with 8 reads of the
+ * third order running sum of the line (repeated integration), whatever the radius.
+ * The running sums are unsigned 32 bits integers: they wrap around, but their
+ * differences are exact, the GPU and the CPU give the same images.
+ */
+
+#include <algorithm>
+#include <cmath>
+
+// Zero padding of the running sums on each side of a line: the 3 boxes of the kernel
+// of radius r span 2r+1 pixels at most, the 3 differences read 3 more pixels
+#define BOX_PADDING (KERNEL_RADIUS + 3)
+
+// Widths of the 3 boxes, their sum is odd so that the filter is centered on the pixel
+struct BoxWidths {
+    int a, b, c;
+};
+
+// Boxes of the kernel of radius kernel_radius: the closest to the gaussian (least squares) among the ones of about its
+// variance, within the 2r+1 pixels of the kernel
+inline BoxWidths boxWidths(const float* kernel_coefficients, int kernel_radius) {
+    BoxWidths best = {1, 1, 1};
+    if (kernel_radius <= 0) return best;
+    const int max_width = 2 * kernel_radius + 1;
+    float variance = 0.f;
+    for (int j = -kernel_radius; j <= kernel_radius; j++)
+        variance += kernel_coefficients[j + kernel_radius] * j * j;
+
+    float best_error = 1e30f;
+    float box[2][2 * (2 * KERNEL_RADIUS + 1)];
+    for (int a = 1; a <= max_width; a++)
+        for (int b = a; b <= max_width; b++)
+            for (int c = b; c <= max_width; c++) {
+                const int length = a + b + c - 2;
+                if (length % 2 == 0 || length > max_width) continue;
+                // Variance of a box of width w: (w^2 - 1) / 12, the variances of the boxes add up
+                if (fabsf((a * a + b * b + c * c - 3) / 12.f - variance) > 0.1f * variance + 0.1f) continue;
+                // Box a * box b * box c, then its distance to the gaussian, both centered
+                int size = a;
+                for (int j = 0; j < size; j++) box[0][j] = 1.f / a;
+                const int widths[2] = {b, c};
+                for (int w = 0; w < 2; w++) {
+                    const float* src = box[w];
+                    float* dst = box[1 - w];
+                    for (int j = 0; j < size + widths[w] - 1; j++) {
+                        dst[j] = 0.f;
+                        for (int k = std::max(0, j - widths[w] + 1); k <= std::min(j, size - 1); k++) dst[j] += src[k];
+                        dst[j] /= widths[w];
+                    }
+                    size += widths[w] - 1;
+                }
+                float error = 0.f;
+                for (int j = -kernel_radius; j <= kernel_radius; j++) {
+                    int k = j + length / 2;
+                    float diff = kernel_coefficients[j + kernel_radius] - ((k >= 0 && k < length) ? box[0][k] : 0.f);
+                    error += diff * diff;
+                }
+                if (error < best_error) {
+                    best_error = error;
+                    best.a = a;
+                    best.b = b;
+                    best.c = c;
+                }
+            }
+    return best;
+}
+
+#endif //BOX_BLUR_H
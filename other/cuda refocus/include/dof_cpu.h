@@ -0,0 +1,55 @@
+#ifndef DOF_CPU_H
+#define DOF_CPU_H
+
+/* dof_cpu.h.
+ *
+ * This file contains the CPU version of the functions of dof_gpu.h,
+ * for rendering depth of field on hosts without CUDA device.
+ * The images are the same as the ones of the CUDA kernels: same gaussian tables,
+ * same per-pixel kernel radius, same zero padding outside the image.
+ * The passes are vectorized (SSE2 / NEON) over the channels of a pixel, tiled and
+ * spread over the cores (OpenMP when enabled, std::thread otherwise).
+ * It does not depend on the ZED SDK nor CUDA, all the buffers are in host memory.
+ */
+
+#include <cstdint>
+#include <vector>
+
+#ifndef KERNEL_RADIUS
+#define KERNEL_RADIUS 32
+#endif
+
+namespace dof_cpu {
+
+// Same memory layout as sl::uchar4
+struct uchar4 {
+    uint8_t x, y, z, w;
+};
+
+// Gaussian coefficients of the kernel of radius kernel_index + 1, as built by the sample
+void gaussianKernel(int kernel_index, std::vector<float>& kernel_coefficients);
+
+// Copy gaussien kernel into the CPU tables
+void copyKernel(float *kernel_coefficients, int kernel_index);
+
+// Normalize depth between 0.f and 1.f, the invalid depths (NaN) keep the previous value of depth_out
+void normalizeDepth(float* depth, float* depth_out, unsigned int step, float min_distance, float max_distance, unsigned int width, unsigned height);
+
+// CPU convolution, the image pitch is imageW as for the GPU functions
+void convolutionRows(uchar4 *d_Dst, uchar4 *d_Src, float* i_depth, int imageW, int imageH, int depth_pitch, float focus_point);
+void convolutionColumns(uchar4 *d_Dst, uchar4 *d_Src, float* i_depth, int imageW, int imageH, int depth_pitch, float focus_point);
+
+// CPU constant-time convolution (box_blur.h), the cost does not depend on the blur
+void convolutionRowsBox(uchar4 *d_Dst, uchar4 *d_Src, float* i_depth, int imageW, int imageH, int depth_pitch, float focus_point);
+void convolutionColumnsBox(uchar4 *d_Dst, uchar4 *d_Src, float* i_depth, int imageW, int imageH, int depth_pitch, float focus_point);
+
+// Number of threads of the passes, 0 (default) for all the cores
+void setNumThreads(int nb_threads);
+int getNumThreads();
+
+// Name of the instruction set used by the passes
+const char* getSimdName();
+
+}
+
+#endif //DOF_CPU_H
@@ -27,4 +27,8 @@ void normalizeDepth(float* depth, float* depth_out, unsigned int step, float min
 void convolutionRows(sl::uchar4 *d_Dst, sl::uchar4 *d_Src, float* i_depth, int imageW, int imageH, int depth_pitch, float focus_point);
 void convolutionColumns(sl::uchar4 *d_Dst, sl::uchar4 *d_Src, float* i_depth, int imageW, int imageH, int depth_pitch, float focus_point);
 
+// GPU constant-time convolution (box_blur.h), the cost does not depend on the blur
+void convolutionRowsBox(sl::uchar4 *d_Dst, sl::uchar4 *d_Src, float* i_depth, int imageW, int imageH, int depth_pitch, float focus_point);
+void convolutionColumnsBox(sl::uchar4 *d_Dst, sl::uchar4 *d_Src, float* i_depth, int imageW, int imageH, int depth_pitch, float focus_point);
+
 #endif //DOF_GPU_H
\ No newline at end of file
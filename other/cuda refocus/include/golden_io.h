@@ -0,0 +1,40 @@
+#ifndef GOLDEN_IO_H
+#define GOLDEN_IO_H
+
+/* golden_io.h.
+ *
+ * Reading and writing of the golden files of the refocus sample:
+ * the inputs and the output of the GPU pipeline, dumped by the sample,
+ * and compared with the CPU pipeline by ZED_CUDA_Refocus_CPU_Bench.
+ * Images are binary PPM (RGB, the alpha is 255), depths are PFM (float, NaN kept).
+ */
+
+#include <string>
+#include <vector>
+
+#include "dof_cpu.h"
+
+namespace golden {
+
+// Files of a golden folder
+const std::string LEFT_FILE = "left.ppm";               // BGRA input image
+const std::string DEPTH_FILE = "depth.pfm";             // input depth, in the unit of min/max_distance
+const std::string DEPTH_NORMALIZED_FILE = "depth_normalized.pfm"; // normalizeDepth output
+const std::string RENDER_FILE = "render.ppm";           // convolutionColumns output, RGBA
+const std::string PARAMETERS_FILE = "parameters.txt";   // focus_point min_distance max_distance box
+
+// step : in pixels, bgra : the x and z channels of the pixels are swapped
+bool writePPM(const std::string& path, const dof_cpu::uchar4* pixels, int width, int height, int step, bool bgra);
+bool readPPM(const std::string& path, std::vector<dof_cpu::uchar4>& pixels, int& width, int& height, bool bgra);
+
+// step : in floats
+bool writePFM(const std::string& path, const float* values, int width, int height, int step);
+bool readPFM(const std::string& path, std::vector<float>& values, int& width, int& height);
+
+// box : rendering of the constant-time blur (convolution*Box)
+bool writeParameters(const std::string& path, float focus_point, float min_distance, float max_distance, bool box);
+bool readParameters(const std::string& path, float& focus_point, float& min_distance, float& max_distance, bool& box);
+
+}
+
+#endif //GOLDEN_IO_H
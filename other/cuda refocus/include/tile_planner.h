@@ -0,0 +1,77 @@
+#ifndef TILE_PLANNER_H
+#define TILE_PLANNER_H
+
+/* tile_planner.h.
+ *
+ * This file contains the tiling of the gaussian convolution kernels of dof_gpu.cu.
+ * Each block filters a tile of the image, loaded in shared memory with a halo on
+ * both sides along the filtered direction. The grid covers the whole image (tail blocks
+ * for the last partial tiles), the halo is sized to the largest kernel radius of the pass.
+ * It is host code only, so that the plans can be checked without CUDA device
+ * (ZED_CUDA_Refocus_CPU_Bench executes them on the CPU).
+ */
+
+#include <cmath>
+#include <cstddef>
+
+#ifndef KERNEL_RADIUS
+#define KERNEL_RADIUS 32
+#endif
+
+// Row pass: a block of ROWS_BLOCKDIM_X x ROWS_BLOCKDIM_Y threads filters ROWS_BLOCKDIM_Y rows
+// of ROWS_RESULT_STEPS * ROWS_BLOCKDIM_X pixels
+#define   ROWS_BLOCKDIM_X 32
+#define   ROWS_BLOCKDIM_Y 4
+#define ROWS_RESULT_STEPS 8
+
+// Column pass: a block of COLUMNS_BLOCKDIM_X x COLUMNS_BLOCKDIM_Y threads filters COLUMNS_BLOCKDIM_X columns
+// of COLUMNS_RESULT_STEPS * COLUMNS_BLOCKDIM_Y pixels
+#define   COLUMNS_BLOCKDIM_X 16
+#define   COLUMNS_BLOCKDIM_Y 8
+#define COLUMNS_RESULT_STEPS 8
+
+struct TilePlan {
+    int blocks_x, blocks_y;   // grid, the last blocks can be partially outside the image
+    int threads_x, threads_y; // block
+    int halo_steps;           // steps of threads loaded on each side of the tile
+    int max_radius;           // largest kernel radius of the pass, within the halo
+    int tile_stride;          // pixels of a line of the tile in shared memory
+    size_t shared_bytes;      // dynamic shared memory of a block
+};
+
+// Largest radius floorf(KERNEL_RADIUS * fabs(depth - focus_point)) for the depths of normalizeDepth, in [0, 1]:
+// the distance to the focus is the largest at one of the bounds
+inline int maxKernelRadius(float focus_point) {
+    float radius = std::floor(std::fmax((KERNEL_RADIUS) * std::fabs(0.f - focus_point), (KERNEL_RADIUS) * std::fabs(1.f - focus_point)));
+    // Any radius when the focus is not a number
+    return (radius >= 0.f && radius < KERNEL_RADIUS) ? static_cast<int>(radius) : KERNEL_RADIUS;
+}
+
+inline TilePlan planRowTiles(int imageW, int imageH, float focus_point) {
+    TilePlan plan;
+    plan.threads_x = ROWS_BLOCKDIM_X;
+    plan.threads_y = ROWS_BLOCKDIM_Y;
+    plan.blocks_x = (imageW + ROWS_RESULT_STEPS * ROWS_BLOCKDIM_X - 1) / (ROWS_RESULT_STEPS * ROWS_BLOCKDIM_X);
+    plan.blocks_y = (imageH + ROWS_BLOCKDIM_Y - 1) / ROWS_BLOCKDIM_Y;
+    plan.max_radius = maxKernelRadius(focus_point);
+    plan.halo_steps = (plan.max_radius + ROWS_BLOCKDIM_X - 1) / ROWS_BLOCKDIM_X;
+    plan.tile_stride = (ROWS_RESULT_STEPS + 2 * plan.halo_steps) * ROWS_BLOCKDIM_X;
+    plan.shared_bytes = static_cast<size_t>(ROWS_BLOCKDIM_Y) * plan.tile_stride * 4 /* uchar4 */;
+    return plan;
+}
+
+inline TilePlan planColumnTiles(int imageW, int imageH, float focus_point) {
+    TilePlan plan;
+    plan.threads_x = COLUMNS_BLOCKDIM_X;
+    plan.threads_y = COLUMNS_BLOCKDIM_Y;
+    plan.blocks_x = (imageW + COLUMNS_BLOCKDIM_X - 1) / COLUMNS_BLOCKDIM_X;
+    plan.blocks_y = (imageH + COLUMNS_RESULT_STEPS * COLUMNS_BLOCKDIM_Y - 1) / (COLUMNS_RESULT_STEPS * COLUMNS_BLOCKDIM_Y);
+    plan.max_radius = maxKernelRadius(focus_point);
+    plan.halo_steps = (plan.max_radius + COLUMNS_BLOCKDIM_Y - 1) / COLUMNS_BLOCKDIM_Y;
+    // One more pixel per column: the threads of a warp read different banks
+    plan.tile_stride = (COLUMNS_RESULT_STEPS + 2 * plan.halo_steps) * COLUMNS_BLOCKDIM_Y + 1;
+    plan.shared_bytes = static_cast<size_t>(COLUMNS_BLOCKDIM_X) * plan.tile_stride * 4 /* uchar4 */;
+    return plan;
+}
+
+#endif //TILE_PLANNER_H
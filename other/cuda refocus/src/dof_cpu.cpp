@@ -0,0 +1,500 @@
+/*
+ * This file contains the definition of the CPU functions ,
+ * for rendering depth of field, based on Gaussian blurring
+ * using separable convolution, with depth-dependent kernel size.
+ * It follows the CUDA kernels of dof_gpu.cu: a pixel is filtered with the kernel
+ * of its own radius, the taps are summed in the same order, in float.
+*/
+
+#include "dof_cpu.h"
+#include "box_blur.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <thread>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#define DOF_WITH_NEON 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define DOF_WITH_SSE2 1
+#endif
+
+namespace dof_cpu {
+
+// Same tables as c_kernel: the kernel of radius r starts at r * r - 1
+static float c_kernel[KERNEL_RADIUS * (KERNEL_RADIUS + 2)];
+
+// Boxes of each radius for the constant-time blur, the radius 0 keeps the pixel
+struct BoxFilter {
+    int a, b, c;
+    int half_length;    // (a + b + c - 3) / 2
+    float inv_weight;   // 1 / (a * b * c)
+};
+static BoxFilter c_box[KERNEL_RADIUS + 1] = {{1, 1, 1, 0, 1.f}};
+
+// Columns filtered together by a task of the column pass, its working set is
+// COLUMNS_STRIP * (imageH + 2 * KERNEL_RADIUS) float pixels (293KB for HD1080), it stays in L2
+#define COLUMNS_STRIP 16
+// Rows filtered by a task of the row pass
+#define ROWS_PER_TASK 8
+
+static std::atomic<int> nb_threads_setting(0);
+
+////////////////////////////////////////////////////////////////////////////////
+// 4 x float operations, one pixel (x, y, z, w) per vector
+////////////////////////////////////////////////////////////////////////////////
+#if DOF_WITH_SSE2
+typedef __m128 Vec4;
+
+static inline Vec4 vZero() { return _mm_setzero_ps(); }
+static inline Vec4 vLoad(const float* p) { return _mm_loadu_ps(p); }
+static inline void vStore(float* p, Vec4 v) { _mm_storeu_ps(p, v); }
+static inline Vec4 vMulAdd(Vec4 sum, float k, Vec4 v) { return _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(k), v)); }
+
+static inline Vec4 vFromPixel(uchar4 p) {
+    int32_t bits;
+    memcpy(&bits, &p, sizeof(bits));
+    const __m128i zero = _mm_setzero_si128();
+    __m128i i = _mm_unpacklo_epi8(_mm_cvtsi32_si128(bits), zero);
+    return _mm_cvtepi32_ps(_mm_unpacklo_epi16(i, zero));
+}
+
+// Truncation with saturation, as the float to unsigned char conversion of CUDA
+static inline uchar4 vToPixel(Vec4 v, bool swap_xz) {
+    if (swap_xz) v = _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 0, 1, 2));
+    __m128i i = _mm_cvttps_epi32(v);
+    i = _mm_packs_epi32(i, i);
+    i = _mm_packus_epi16(i, i);
+    uint32_t bits = static_cast<uint32_t>(_mm_cvtsi128_si32(i)) | 0xFF000000u;
+    uchar4 p;
+    memcpy(&p, &bits, sizeof(p));
+    return p;
+}
+#elif DOF_WITH_NEON
+typedef float32x4_t Vec4;
+
+static inline Vec4 vZero() { return vdupq_n_f32(0.f); }
+static inline Vec4 vLoad(const float* p) { return vld1q_f32(p); }
+static inline void vStore(float* p, Vec4 v) { vst1q_f32(p, v); }
+// No fused multiply-add, the CPU tables give the same sums on all the platforms
+static inline Vec4 vMulAdd(Vec4 sum, float k, Vec4 v) { return vaddq_f32(sum, vmulq_n_f32(v, k)); }
+
+static inline Vec4 vFromPixel(uchar4 p) {
+    uint32_t bits;
+    memcpy(&bits, &p, sizeof(bits));
+    uint16x8_t h = vmovl_u8(vreinterpret_u8_u32(vdup_n_u32(bits)));
+    return vcvtq_f32_u32(vmovl_u16(vget_low_u16(h)));
+}
+
+static inline uchar4 vToPixel(Vec4 v, bool swap_xz) {
+    uint16x4_t h = vqmovn_u32(vcvtq_u32_f32(v));
+    uint8_t bytes[8];
+    vst1_u8(bytes, vqmovn_u16(vcombine_u16(h, h)));
+    uchar4 p;
+    p.x = swap_xz ? bytes[2] : bytes[0];
+    p.y = bytes[1];
+    p.z = swap_xz ? bytes[0] : bytes[2];
+    p.w = 255;
+    return p;
+}
+#else
+struct Vec4 {
+    float v[4];
+};
+
+static inline Vec4 vZero() { return Vec4{{0.f, 0.f, 0.f, 0.f}}; }
+static inline Vec4 vLoad(const float* p) { return Vec4{{p[0], p[1], p[2], p[3]}}; }
+static inline void vStore(float* p, Vec4 v) { memcpy(p, v.v, sizeof(v.v)); }
+static inline Vec4 vMulAdd(Vec4 sum, float k, Vec4 v) {
+    for (int c = 0; c < 4; c++) {
+        float prod = k * v.v[c];
+        sum.v[c] += prod;
+    }
+    return sum;
+}
+
+static inline Vec4 vFromPixel(uchar4 p) { return Vec4{{(float) p.x, (float) p.y, (float) p.z, (float) p.w}}; }
+
+static inline uint8_t toUchar(float f) { return f <= 0.f ? 0 : (f >= 255.f ? 255 : static_cast<uint8_t>(f)); }
+
+static inline uchar4 vToPixel(Vec4 v, bool swap_xz) {
+    uchar4 p;
+    p.x = toUchar(v.v[swap_xz ? 2 : 0]);
+    p.y = toUchar(v.v[1]);
+    p.z = toUchar(v.v[swap_xz ? 0 : 2]);
+    p.w = 255;
+    return p;
+}
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+// 4 x uint32 operations for the running sums of the constant-time blur, they wrap around
+////////////////////////////////////////////////////////////////////////////////
+#if DOF_WITH_SSE2
+typedef __m128i VecI4;
+
+static inline VecI4 viZero() { return _mm_setzero_si128(); }
+static inline VecI4 viLoad(const uint32_t* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+static inline void viStore(uint32_t* p, VecI4 v) { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v); }
+static inline VecI4 viAdd(VecI4 a, VecI4 b) { return _mm_add_epi32(a, b); }
+static inline VecI4 viSub(VecI4 a, VecI4 b) { return _mm_sub_epi32(a, b); }
+
+static inline VecI4 viFromPixel(uchar4 p) {
+    int32_t bits;
+    memcpy(&bits, &p, sizeof(bits));
+    const __m128i zero = _mm_setzero_si128();
+    return _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(bits), zero), zero);
+}
+
+// sum / weight rounded down: sum < 2^23 and its distance to a multiple of the weight is more than the float error
+static inline uchar4 viToPixel(VecI4 sum, float inv_weight, bool swap_xz) {
+    if (swap_xz) sum = _mm_shuffle_epi32(sum, _MM_SHUFFLE(3, 0, 1, 2));
+    __m128 v = _mm_mul_ps(_mm_add_ps(_mm_cvtepi32_ps(sum), _mm_set1_ps(0.5f)), _mm_set1_ps(inv_weight));
+    return vToPixel(v, false);
+}
+#elif DOF_WITH_NEON
+typedef uint32x4_t VecI4;
+
+static inline VecI4 viZero() { return vdupq_n_u32(0); }
+static inline VecI4 viLoad(const uint32_t* p) { return vld1q_u32(p); }
+static inline void viStore(uint32_t* p, VecI4 v) { vst1q_u32(p, v); }
+static inline VecI4 viAdd(VecI4 a, VecI4 b) { return vaddq_u32(a, b); }
+static inline VecI4 viSub(VecI4 a, VecI4 b) { return vsubq_u32(a, b); }
+
+static inline VecI4 viFromPixel(uchar4 p) {
+    uint32_t bits;
+    memcpy(&bits, &p, sizeof(bits));
+    return vmovl_u16(vget_low_u16(vmovl_u8(vreinterpret_u8_u32(vdup_n_u32(bits)))));
+}
+
+static inline uchar4 viToPixel(VecI4 sum, float inv_weight, bool swap_xz) {
+    return vToPixel(vmulq_n_f32(vaddq_f32(vcvtq_f32_u32(sum), vdupq_n_f32(0.5f)), inv_weight), swap_xz);
+}
+#else
+struct VecI4 {
+    uint32_t v[4];
+};
+
+static inline VecI4 viZero() { return VecI4{{0, 0, 0, 0}}; }
+static inline VecI4 viLoad(const uint32_t* p) { return VecI4{{p[0], p[1], p[2], p[3]}}; }
+static inline void viStore(uint32_t* p, VecI4 v) { memcpy(p, v.v, sizeof(v.v)); }
+static inline VecI4 viAdd(VecI4 a, VecI4 b) { return VecI4{{a.v[0] + b.v[0], a.v[1] + b.v[1], a.v[2] + b.v[2], a.v[3] + b.v[3]}}; }
+static inline VecI4 viSub(VecI4 a, VecI4 b) { return VecI4{{a.v[0] - b.v[0], a.v[1] - b.v[1], a.v[2] - b.v[2], a.v[3] - b.v[3]}}; }
+static inline VecI4 viFromPixel(uchar4 p) { return VecI4{{p.x, p.y, p.z, p.w}}; }
+
+static inline uchar4 viToPixel(VecI4 sum, float inv_weight, bool swap_xz) {
+    Vec4 v;
+    for (int c = 0; c < 4; c++) v.v[c] = (static_cast<float>(sum.v[c]) + 0.5f) * inv_weight;
+    return vToPixel(v, swap_xz);
+}
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+// Shared by the passes
+////////////////////////////////////////////////////////////////////////////////
+
+// Radius of the kernel of a pixel, the invalid depths (never normalized) are not blurred
+static inline int kernelRadius(float depth, float focus_depth) {
+    float radius = floorf((KERNEL_RADIUS) * fabsf(depth - focus_depth));
+    if (!(radius > 0.f)) return 0;
+    return radius < KERNEL_RADIUS ? static_cast<int>(radius) : KERNEL_RADIUS;
+}
+
+// line: the pixel to filter in a zero padded line of float pixels, KERNEL_RADIUS pixels on each side
+static inline Vec4 filterPixel(const float* line, int kernel_radius) {
+    if (kernel_radius == 0) return vLoad(line);
+    const float* kernel = c_kernel + kernel_radius * kernel_radius - 1 + kernel_radius;
+    Vec4 sum = vZero();
+    for (int j = -kernel_radius; j <= kernel_radius; ++j)
+        sum = vMulAdd(sum, kernel[j], vLoad(line + 4 * j));
+    return sum;
+}
+
+// Two neighbours of the same radius (the depth is mostly smooth): two independent sums hide the latency of the additions,
+// each one keeps the order of the taps
+static inline void filterPixels2(const float* line0, const float* line1, int kernel_radius, Vec4& sum0, Vec4& sum1) {
+    if (kernel_radius == 0) {
+        sum0 = vLoad(line0);
+        sum1 = vLoad(line1);
+        return;
+    }
+    const float* kernel = c_kernel + kernel_radius * kernel_radius - 1 + kernel_radius;
+    sum0 = vZero();
+    sum1 = vZero();
+    for (int j = -kernel_radius; j <= kernel_radius; ++j) {
+        sum0 = vMulAdd(sum0, kernel[j], vLoad(line0 + 4 * j));
+        sum1 = vMulAdd(sum1, kernel[j], vLoad(line1 + 4 * j));
+    }
+}
+
+static inline void loadPixel(float* dst, const uchar4* src) {
+    vStore(dst, src ? vFromPixel(*src) : vZero());
+}
+
+// Third order running sum, one step: the running sums of the lower orders are updated in place
+static inline VecI4 integratePixel(const uchar4* src, VecI4& sum1, VecI4& sum2, VecI4& sum3) {
+    sum1 = viAdd(sum1, src ? viFromPixel(*src) : viZero());
+    sum2 = viAdd(sum2, sum1);
+    sum3 = viAdd(sum3, sum2);
+    return sum3;
+}
+
+// sums: the third order running sum of a zero padded line, at the pixel to filter
+// The 3 boxes are 3 differences of the running sum: 8 reads whatever their widths
+static inline uchar4 boxPixel(const uint32_t* sums, int kernel_radius, bool swap_xz) {
+    const BoxFilter& box = c_box[kernel_radius];
+    const uint32_t* end = sums + 4 * box.half_length;
+    auto at = [end](int offset) { return viLoad(end - 4 * offset); };
+    VecI4 sum = viAdd(viAdd(at(0), at(box.a + box.b)), viAdd(at(box.a + box.c), at(box.b + box.c)));
+    sum = viSub(sum, viAdd(viAdd(at(box.a), at(box.b)), viAdd(at(box.c), at(box.a + box.b + box.c))));
+    return viToPixel(sum, box.inv_weight, swap_xz);
+}
+
+// Runs task(index, scratch) for index in [0, nb_tasks[ on the threads, scratch is a buffer owned by the thread
+template<typename Scratch = float, typename Task>
+static void parallelFor(int nb_tasks, Task task) {
+    const int nb_threads = std::min(getNumThreads(), nb_tasks);
+    if (nb_threads <= 1) {
+        std::vector<Scratch> scratch;
+        for (int i = 0; i < nb_tasks; i++) task(i, scratch);
+        return;
+    }
+#ifdef _OPENMP
+#pragma omp parallel num_threads(nb_threads)
+    {
+        std::vector<Scratch> scratch;
+        // The cost of a task depends on the blur of its pixels, dynamic scheduling balances the threads
+#pragma omp for schedule(dynamic)
+        for (int i = 0; i < nb_tasks; i++) task(i, scratch);
+    }
+#else
+    std::atomic<int> next_task(0);
+    auto worker = [&]() {
+        std::vector<Scratch> scratch;
+        for (int i = next_task++; i < nb_tasks; i = next_task++) task(i, scratch);
+    };
+    std::vector<std::thread> threads;
+    for (int t = 1; t < nb_threads; t++) threads.emplace_back(worker);
+    worker();
+    for (auto& thread : threads) thread.join();
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Public functions
+////////////////////////////////////////////////////////////////////////////////
+
+void gaussianKernel(int kernel_index, std::vector<float>& gauss_vec) {
+    gauss_vec.resize((kernel_index + 1) * 2 + 1, 0);
+
+    // Compute Gaussian coeff
+    int rad = (gauss_vec.size() - 1) / 2;
+    float sigma = 0.3f * ((gauss_vec.size() - 1.f) * 0.5f - 1.f) + 0.8f;
+    float sum = 0;
+    for (int u = -rad; u <= rad; u++) {
+        float gauss_value = expf(-1.f * (powf(u, 2.f) / (2.f * powf(sigma, 2.f))));
+        gauss_vec[u + rad] = gauss_value;
+        sum += gauss_value;
+    }
+    sum = 1.f / sum;
+    for (size_t u = 0; u < gauss_vec.size(); u++)
+        gauss_vec[u] *= sum;
+}
+
+void copyKernel(float *kernel_coefficients, int kernel_index) {
+    if (kernel_index < 0 || kernel_index >= KERNEL_RADIUS) return;
+    int kernel_radius = kernel_index + 1;
+    memcpy(c_kernel + kernel_index * (kernel_index + 2), kernel_coefficients, (2 * kernel_radius + 1) * sizeof(float));
+
+    BoxWidths widths = boxWidths(kernel_coefficients, kernel_radius);
+    BoxFilter& box = c_box[kernel_radius];
+    box.a = widths.a;
+    box.b = widths.b;
+    box.c = widths.c;
+    box.half_length = (widths.a + widths.b + widths.c - 3) / 2;
+    box.inv_weight = 1.f / (widths.a * widths.b * widths.c);
+}
+
+void normalizeDepth(float* depth, float* depth_out, unsigned int step, float min_distance, float max_distance, unsigned int width, unsigned height) {
+    const float range = max_distance - min_distance;
+    parallelFor((height + ROWS_PER_TASK - 1) / ROWS_PER_TASK, [&](int task, std::vector<float>&) {
+        const unsigned y_end = std::min<unsigned>(height, (task + 1) * ROWS_PER_TASK);
+        for (unsigned y = task * ROWS_PER_TASK; y < y_end; y++) {
+            const float* src = depth + static_cast<size_t>(y) * step;
+            float* dst = depth_out + static_cast<size_t>(y) * step;
+            unsigned x = 0;
+#if DOF_WITH_SSE2
+            const __m128 v_max = _mm_set1_ps(max_distance), v_range = _mm_set1_ps(range);
+            const __m128 v_zero = _mm_setzero_ps(), v_one = _mm_set1_ps(1.f);
+            for (; x + 4 <= width; x += 4) {
+                __m128 n = _mm_div_ps(_mm_sub_ps(v_max, _mm_loadu_ps(src + x)), v_range);
+                // +-inf are clamped, only NaN is not finite after the clamp
+                __m128 valid = _mm_cmpord_ps(n, n);
+                n = _mm_min_ps(_mm_max_ps(n, v_zero), v_one);
+                _mm_storeu_ps(dst + x, _mm_or_ps(_mm_and_ps(valid, n), _mm_andnot_ps(valid, _mm_loadu_ps(dst + x))));
+            }
+#elif DOF_WITH_NEON
+            const float32x4_t v_max = vdupq_n_f32(max_distance), v_range = vdupq_n_f32(range);
+            const float32x4_t v_zero = vdupq_n_f32(0.f), v_one = vdupq_n_f32(1.f);
+            for (; x + 4 <= width; x += 4) {
+                float32x4_t n = vdivq_f32(vsubq_f32(v_max, vld1q_f32(src + x)), v_range);
+                uint32x4_t valid = vceqq_f32(n, n);
+                n = vminq_f32(vmaxq_f32(n, v_zero), v_one);
+                vst1q_f32(dst + x, vbslq_f32(valid, n, vld1q_f32(dst + x)));
+            }
+#endif
+            for (; x < width; x++) {
+                float depth_normalized = (max_distance - src[x]) / range;
+                if (depth_normalized < 0.f) depth_normalized = 0.f;
+                if (depth_normalized > 1.f) depth_normalized = 1.f;
+                if (std::isfinite(depth_normalized))
+                    dst[x] = depth_normalized;
+            }
+        }
+    });
+}
+
+void convolutionRows(uchar4 *d_Dst, uchar4 *d_Src, float* i_depth, int imageW, int imageH, int depth_pitch, float focus_point) {
+    const int line_size = imageW + 2 * KERNEL_RADIUS;
+    parallelFor((imageH + ROWS_PER_TASK - 1) / ROWS_PER_TASK, [&](int task, std::vector<float>& line) {
+        line.resize(line_size * 4);
+        const int y_end = std::min(imageH, (task + 1) * ROWS_PER_TASK);
+        for (int y = task * ROWS_PER_TASK; y < y_end; y++) {
+            const uchar4* src = d_Src + static_cast<size_t>(y) * imageW;
+            uchar4* dst = d_Dst + static_cast<size_t>(y) * imageW;
+            const float* depth = i_depth + static_cast<size_t>(y) * depth_pitch;
+            // The row in float once, with the zero halo of the GPU kernel
+            for (int x = -KERNEL_RADIUS; x < imageW + KERNEL_RADIUS; x++)
+                loadPixel(&line[(x + KERNEL_RADIUS) * 4], (x >= 0 && x < imageW) ? src + x : nullptr);
+            const float* center = &line[KERNEL_RADIUS * 4];
+            int x = 0;
+            for (; x + 1 < imageW; x += 2) {
+                int radius0 = kernelRadius(depth[x], focus_point), radius1 = kernelRadius(depth[x + 1], focus_point);
+                Vec4 sum0, sum1;
+                if (radius0 == radius1)
+                    filterPixels2(center + x * 4, center + x * 4 + 4, radius0, sum0, sum1);
+                else {
+                    sum0 = filterPixel(center + x * 4, radius0);
+                    sum1 = filterPixel(center + x * 4 + 4, radius1);
+                }
+                dst[x] = vToPixel(sum0, false);
+                dst[x + 1] = vToPixel(sum1, false);
+            }
+            if (x < imageW)
+                dst[x] = vToPixel(filterPixel(center + x * 4, kernelRadius(depth[x], focus_point)), false);
+        }
+    });
+}
+
+void convolutionColumns(uchar4 *d_Dst, uchar4 *d_Src, float* i_depth, int imageW, int imageH, int depth_pitch, float focus_point) {
+    const int column_size = imageH + 2 * KERNEL_RADIUS;
+    parallelFor((imageW + COLUMNS_STRIP - 1) / COLUMNS_STRIP, [&](int task, std::vector<float>& columns) {
+        columns.resize(COLUMNS_STRIP * column_size * 4);
+        const int x_begin = task * COLUMNS_STRIP;
+        const int strip = std::min(COLUMNS_STRIP, imageW - x_begin);
+        // Transposes the strip: each column becomes a contiguous zero padded line, read row by row from the image
+        for (int y = -KERNEL_RADIUS; y < imageH + KERNEL_RADIUS; y++) {
+            const bool inside = y >= 0 && y < imageH;
+            const uchar4* src = d_Src + (inside ? static_cast<size_t>(y) * imageW + x_begin : 0);
+            for (int c = 0; c < strip; c++)
+                loadPixel(&columns[(c * column_size + y + KERNEL_RADIUS) * 4], inside ? src + c : nullptr);
+        }
+        // Written row by row too, strip pixels at a time
+        for (int y = 0; y < imageH; y++) {
+            uchar4* dst = d_Dst + static_cast<size_t>(y) * imageW + x_begin;
+            const float* depth = i_depth + static_cast<size_t>(y) * depth_pitch + x_begin;
+            // BGRA to RGBA for the OpenGL texture, as the GPU kernel
+            int c = 0;
+            for (; c + 1 < strip; c += 2) {
+                const float* center0 = &columns[(c * column_size + y + KERNEL_RADIUS) * 4];
+                const float* center1 = center0 + column_size * 4;
+                int radius0 = kernelRadius(depth[c], focus_point), radius1 = kernelRadius(depth[c + 1], focus_point);
+                Vec4 sum0, sum1;
+                if (radius0 == radius1)
+                    filterPixels2(center0, center1, radius0, sum0, sum1);
+                else {
+                    sum0 = filterPixel(center0, radius0);
+                    sum1 = filterPixel(center1, radius1);
+                }
+                dst[c] = vToPixel(sum0, true);
+                dst[c + 1] = vToPixel(sum1, true);
+            }
+            if (c < strip)
+                dst[c] = vToPixel(filterPixel(&columns[(c * column_size + y + KERNEL_RADIUS) * 4], kernelRadius(depth[c], focus_point)), true);
+        }
+    });
+}
+
+void convolutionRowsBox(uchar4 *d_Dst, uchar4 *d_Src, float* i_depth, int imageW, int imageH, int depth_pitch, float focus_point) {
+    const int line_size = imageW + 2 * BOX_PADDING;
+    parallelFor<uint32_t>((imageH + ROWS_PER_TASK - 1) / ROWS_PER_TASK, [&](int task, std::vector<uint32_t>& sums) {
+        sums.resize(line_size * 4);
+        const int y_end = std::min(imageH, (task + 1) * ROWS_PER_TASK);
+        for (int y = task * ROWS_PER_TASK; y < y_end; y++) {
+            const uchar4* src = d_Src + static_cast<size_t>(y) * imageW;
+            uchar4* dst = d_Dst + static_cast<size_t>(y) * imageW;
+            const float* depth = i_depth + static_cast<size_t>(y) * depth_pitch;
+            VecI4 sum1 = viZero(), sum2 = viZero(), sum3 = viZero();
+            for (int x = -BOX_PADDING; x < imageW + BOX_PADDING; x++)
+                viStore(&sums[(x + BOX_PADDING) * 4], integratePixel((x >= 0 && x < imageW) ? src + x : nullptr, sum1, sum2, sum3));
+            const uint32_t* center = &sums[BOX_PADDING * 4];
+            for (int x = 0; x < imageW; x++)
+                dst[x] = boxPixel(center + x * 4, kernelRadius(depth[x], focus_point), false);
+        }
+    });
+}
+
+void convolutionColumnsBox(uchar4 *d_Dst, uchar4 *d_Src, float* i_depth, int imageW, int imageH, int depth_pitch, float focus_point) {
+    const int column_size = imageH + 2 * BOX_PADDING;
+    parallelFor<uint32_t>((imageW + COLUMNS_STRIP - 1) / COLUMNS_STRIP, [&](int task, std::vector<uint32_t>& sums) {
+        sums.resize(COLUMNS_STRIP * column_size * 4);
+        const int x_begin = task * COLUMNS_STRIP;
+        const int strip = std::min(COLUMNS_STRIP, imageW - x_begin);
+        // Running sums of the columns of the strip, the image is read row by row
+        VecI4 sum1[COLUMNS_STRIP], sum2[COLUMNS_STRIP], sum3[COLUMNS_STRIP];
+        for (int c = 0; c < strip; c++) sum1[c] = sum2[c] = sum3[c] = viZero();
+        for (int y = -BOX_PADDING; y < imageH + BOX_PADDING; y++) {
+            const bool inside = y >= 0 && y < imageH;
+            const uchar4* src = d_Src + (inside ? static_cast<size_t>(y) * imageW + x_begin : 0);
+            for (int c = 0; c < strip; c++)
+                viStore(&sums[(c * column_size + y + BOX_PADDING) * 4], integratePixel(inside ? src + c : nullptr, sum1[c], sum2[c], sum3[c]));
+        }
+        for (int y = 0; y < imageH; y++) {
+            uchar4* dst = d_Dst + static_cast<size_t>(y) * imageW + x_begin;
+            const float* depth = i_depth + static_cast<size_t>(y) * depth_pitch + x_begin;
+            // BGRA to RGBA for the OpenGL texture, as the gaussian pass
+            for (int c = 0; c < strip; c++)
+                dst[c] = boxPixel(&sums[(c * column_size + y + BOX_PADDING) * 4], kernelRadius(depth[c], focus_point), true);
+        }
+    });
+}
+
+void setNumThreads(int nb_threads) {
+    nb_threads_setting = std::max(0, nb_threads);
+}
+
+int getNumThreads() {
+    int nb_threads = nb_threads_setting;
+    if (nb_threads > 0) return nb_threads;
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+const char* getSimdName() {
+#if DOF_WITH_SSE2
+    return "SSE2";
+#elif DOF_WITH_NEON
+    return "NEON";
+#else
+    return "scalar";
+#endif
+}
+
+}
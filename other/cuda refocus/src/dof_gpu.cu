@@ -6,14 +6,22 @@
 */
 
 #include "dof_gpu.h"
+#include "box_blur.h"
+#include "tile_planner.h"
 
 __constant__ float c_kernel[KERNEL_RADIUS * (KERNEL_RADIUS + 2)];
+// Widths of the 3 boxes of each radius, for the constant-time blur. The radius 0 keeps the pixel
+__constant__ int c_box[(KERNEL_RADIUS + 1) * 3] = {1, 1, 1};
 
 void copyKernel(float *kernel_coefficients, int kernel_index) {
     int kernel_radius = kernel_index + 1;
     cudaMemcpyToSymbol(c_kernel, kernel_coefficients,
                        KERNEL_LENGTH_X(kernel_radius) * sizeof(float),
                        kernel_index * (kernel_index + 2) * sizeof(float));
+
+    BoxWidths widths = boxWidths(kernel_coefficients, kernel_radius);
+    int box[3] = {widths.a, widths.b, widths.c};
+    cudaMemcpyToSymbol(c_box, box, sizeof(box), kernel_radius * sizeof(box));
 }
 
 __global__ void _k_normalizeDepth(float* depth, float* depth_norm, unsigned int step, float min_distance, float max_distance, unsigned int width, unsigned height) {
@@ -44,141 +52,224 @@ void normalizeDepth(float* depth, float* depth_out, unsigned int step, float min
     _k_normalizeDepth << <dimGrid, dimBlock, 0 >> > (depth, depth_out, step, min_distance, max_distance, width, height);
 }
 
+// Kernel radius of a pixel, the NaN depths are not blurred. max_radius bounds it to the halo of the tiles
+__device__ int _d_kernelRadius(float depth, float focus_depth, int max_radius) {
+    float radius = floorf((KERNEL_RADIUS) * fabs(depth - focus_depth));
+    return radius > 0.f ? min(static_cast<int>(radius), max_radius) : 0;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
-// Row convolution filter
+// Row convolution filter, tiles of planRowTiles
 ////////////////////////////////////////////////////////////////////////////////
-#define   ROWS_BLOCKDIM_X 32
-#define   ROWS_BLOCKDIM_Y 4
-#define ROWS_RESULT_STEPS 8
-#define   ROWS_HALO_STEPS 1
-
-__global__ void _k_convolutionRows(sl::uchar4 *d_Dst, sl::uchar4 *d_Src, float* depth, int imageW, int imageH, int pitch, int pitch_depth, float focus_depth) {
-    __shared__ sl::uchar4 s_Data[ROWS_BLOCKDIM_Y][(ROWS_RESULT_STEPS + 2 * ROWS_HALO_STEPS) * ROWS_BLOCKDIM_X];
+__global__ void _k_convolutionRows(sl::uchar4 *d_Dst, sl::uchar4 *d_Src, float* depth, int imageW, int imageH, int pitch, int pitch_depth, float focus_depth, int halo_steps, int max_radius) {
+    // [ROWS_BLOCKDIM_Y][tile_stride]
+    extern __shared__ sl::uchar4 s_Data[];
+    const int tile_stride = (ROWS_RESULT_STEPS + 2 * halo_steps) * ROWS_BLOCKDIM_X;
+    sl::uchar4 *s_Row = s_Data + threadIdx.y * tile_stride;
 
     //Offset to the left halo edge
-    const int baseX = (blockIdx.x * ROWS_RESULT_STEPS - ROWS_HALO_STEPS) * ROWS_BLOCKDIM_X + threadIdx.x;
+    const int baseX = (blockIdx.x * ROWS_RESULT_STEPS - halo_steps) * ROWS_BLOCKDIM_X + threadIdx.x;
     const int baseY = blockIdx.y * ROWS_BLOCKDIM_Y + threadIdx.y;
-
-    d_Src += baseY * pitch + baseX;
-    d_Dst += baseY * pitch + baseX;
-    depth += baseY * pitch_depth + baseX;
+    // Rows of a tail block below the image: loaded as zeros, not written
+    const bool inside = baseY < imageH;
 
     sl::uchar4 reset(0, 0, 0, 0);
-    //Load main data
-#pragma unroll
-    for (int i = ROWS_HALO_STEPS; i < ROWS_HALO_STEPS + ROWS_RESULT_STEPS; i++) {
-        s_Data[threadIdx.y][threadIdx.x + i * ROWS_BLOCKDIM_X] = d_Src[i * ROWS_BLOCKDIM_X];
-    }
-
-    //Load left halo
-#pragma unroll
-    for (int i = 0; i < ROWS_HALO_STEPS; i++) {
-        s_Data[threadIdx.y][threadIdx.x + i * ROWS_BLOCKDIM_X] = (baseX >= -i * ROWS_BLOCKDIM_X) ? d_Src[i * ROWS_BLOCKDIM_X] : reset;
-    }
-
-    //Load right halo
-#pragma unroll
-    for (int i = ROWS_HALO_STEPS + ROWS_RESULT_STEPS; i < ROWS_HALO_STEPS + ROWS_RESULT_STEPS + ROWS_HALO_STEPS; i++) {
-        s_Data[threadIdx.y][threadIdx.x + i * ROWS_BLOCKDIM_X] = (imageW - baseX > i * ROWS_BLOCKDIM_X) ? d_Src[i * ROWS_BLOCKDIM_X] : reset;
+    //Load main data and halos, zero padding outside the image
+    for (int i = 0; i < ROWS_RESULT_STEPS + 2 * halo_steps; i++) {
+        const int x = baseX + i * ROWS_BLOCKDIM_X;
+        s_Row[threadIdx.x + i * ROWS_BLOCKDIM_X] = (inside && x >= 0 && x < imageW) ? d_Src[baseY * pitch + x] : reset;
     }
 
     //Compute and store results
     __syncthreads();
+    if (!inside) return;
 #pragma unroll
-    for (int i = ROWS_HALO_STEPS; i < ROWS_HALO_STEPS + ROWS_RESULT_STEPS; i++) {
+    for (int step = 0; step < ROWS_RESULT_STEPS; step++) {
+        const int i = halo_steps + step;
+        const int x = baseX + i * ROWS_BLOCKDIM_X;
+        if (x >= imageW) break;
         sl::float3 sum(0, 0, 0);
-        int kernel_radius = floorf((KERNEL_RADIUS) * fabs(depth[i * ROWS_BLOCKDIM_X] - focus_depth));
+        int kernel_radius = _d_kernelRadius(depth[baseY * pitch_depth + x], focus_depth, max_radius);
         int kernel_mid = kernel_radius * kernel_radius - 1 + kernel_radius;
         if (kernel_radius > 0) {
             for (int j = -kernel_radius; j <= kernel_radius; ++j) {
-                sum.x += c_kernel[kernel_mid + j] * (float) s_Data[threadIdx.y][threadIdx.x + i * ROWS_BLOCKDIM_X + j].x;
-                sum.y += c_kernel[kernel_mid + j] * (float) s_Data[threadIdx.y][threadIdx.x + i * ROWS_BLOCKDIM_X + j].y;
-                sum.z += c_kernel[kernel_mid + j] * (float) s_Data[threadIdx.y][threadIdx.x + i * ROWS_BLOCKDIM_X + j].z;
+                sum.x += c_kernel[kernel_mid + j] * (float) s_Row[threadIdx.x + i * ROWS_BLOCKDIM_X + j].x;
+                sum.y += c_kernel[kernel_mid + j] * (float) s_Row[threadIdx.x + i * ROWS_BLOCKDIM_X + j].y;
+                sum.z += c_kernel[kernel_mid + j] * (float) s_Row[threadIdx.x + i * ROWS_BLOCKDIM_X + j].z;
             }
         } else {
-            sum.x = (float) s_Data[threadIdx.y][threadIdx.x + i * ROWS_BLOCKDIM_X].x;
-            sum.y = (float) s_Data[threadIdx.y][threadIdx.x + i * ROWS_BLOCKDIM_X].y;
-            sum.z = (float) s_Data[threadIdx.y][threadIdx.x + i * ROWS_BLOCKDIM_X].z;
+            sum.x = (float) s_Row[threadIdx.x + i * ROWS_BLOCKDIM_X].x;
+            sum.y = (float) s_Row[threadIdx.x + i * ROWS_BLOCKDIM_X].y;
+            sum.z = (float) s_Row[threadIdx.x + i * ROWS_BLOCKDIM_X].z;
         }
 
-        d_Dst[i * ROWS_BLOCKDIM_X].x = sum.x;
-        d_Dst[i * ROWS_BLOCKDIM_X].y = sum.y;
-        d_Dst[i * ROWS_BLOCKDIM_X].z = sum.z;
-        d_Dst[i * ROWS_BLOCKDIM_X].w = 255;
+        sl::uchar4 &dst = d_Dst[baseY * pitch + x];
+        dst.x = sum.x;
+        dst.y = sum.y;
+        dst.z = sum.z;
+        dst.w = 255;
     }
 }
 
 void convolutionRows(sl::uchar4 *d_Dst, sl::uchar4 *d_Src, float* i_depth, int imageW, int imageH, int depth_pitch, float focus_point) {
-    dim3 blocks(imageW / (ROWS_RESULT_STEPS * ROWS_BLOCKDIM_X), imageH / ROWS_BLOCKDIM_Y);
-    dim3 threads(ROWS_BLOCKDIM_X, ROWS_BLOCKDIM_Y);
-    _k_convolutionRows << <blocks, threads >> > (d_Dst, d_Src, i_depth, imageW, imageH, imageW, depth_pitch, focus_point);
+    TilePlan plan = planRowTiles(imageW, imageH, focus_point);
+    if (plan.blocks_x == 0 || plan.blocks_y == 0) return;
+    dim3 blocks(plan.blocks_x, plan.blocks_y);
+    dim3 threads(plan.threads_x, plan.threads_y);
+    _k_convolutionRows << <blocks, threads, plan.shared_bytes >> > (d_Dst, d_Src, i_depth, imageW, imageH, imageW, depth_pitch, focus_point, plan.halo_steps, plan.max_radius);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-// Column convolution filter
+// Column convolution filter, tiles of planColumnTiles
 ////////////////////////////////////////////////////////////////////////////////
-#define   COLUMNS_BLOCKDIM_X 16
-#define   COLUMNS_BLOCKDIM_Y 8
-#define COLUMNS_RESULT_STEPS 2
-#define   COLUMNS_HALO_STEPS 4
+__global__ void _k_convolutionColumns(sl::uchar4 *d_Dst, sl::uchar4 *d_Src, float* depth, int imageW, int imageH, int pitch, int pitch_depth, float focus_depth, int halo_steps, int max_radius) {
+    // [COLUMNS_BLOCKDIM_X][tile_stride]
+    extern __shared__ sl::uchar4 s_Data[];
+    const int tile_stride = (COLUMNS_RESULT_STEPS + 2 * halo_steps) * COLUMNS_BLOCKDIM_Y + 1;
+    sl::uchar4 *s_Column = s_Data + threadIdx.x * tile_stride;
 
-__global__ void _k_convolutionColumns(sl::uchar4 *d_Dst, sl::uchar4 *d_Src, float* depth, int imageW, int imageH, int pitch, int pitch_depth, float focus_depth) {
-    __shared__ sl::uchar4 s_Data[COLUMNS_BLOCKDIM_X][(COLUMNS_RESULT_STEPS + 2 * COLUMNS_HALO_STEPS) * COLUMNS_BLOCKDIM_Y + 1];
     sl::uchar4 reset(0, 0, 0, 0);
     //Offset to the upper halo edge
     const int baseX = blockIdx.x * COLUMNS_BLOCKDIM_X + threadIdx.x;
-    const int baseY = (blockIdx.y * COLUMNS_RESULT_STEPS - COLUMNS_HALO_STEPS) * COLUMNS_BLOCKDIM_Y + threadIdx.y;
-    d_Src += baseY * pitch + baseX;
-    d_Dst += baseY * pitch + baseX;
-    depth += baseY * pitch_depth + baseX;
+    const int baseY = (blockIdx.y * COLUMNS_RESULT_STEPS - halo_steps) * COLUMNS_BLOCKDIM_Y + threadIdx.y;
+    // Columns of a tail block right of the image: loaded as zeros, not written
+    const bool inside = baseX < imageW;
 
-    //Main data
-#pragma unroll
-    for (int i = COLUMNS_HALO_STEPS; i < COLUMNS_HALO_STEPS + COLUMNS_RESULT_STEPS; i++) {
-        s_Data[threadIdx.x][threadIdx.y + i * COLUMNS_BLOCKDIM_Y] = d_Src[i * COLUMNS_BLOCKDIM_Y * pitch];
-    }
-
-    //Upper halo
-#pragma unroll
-    for (int i = 0; i < COLUMNS_HALO_STEPS; i++) {
-        s_Data[threadIdx.x][threadIdx.y + i * COLUMNS_BLOCKDIM_Y] = (baseY >= -i * COLUMNS_BLOCKDIM_Y) ? d_Src[i * COLUMNS_BLOCKDIM_Y * pitch] : reset;
-    }
-
-    //Lower halo
-#pragma unroll
-    for (int i = COLUMNS_HALO_STEPS + COLUMNS_RESULT_STEPS; i < COLUMNS_HALO_STEPS + COLUMNS_RESULT_STEPS + COLUMNS_HALO_STEPS; i++) {
-        s_Data[threadIdx.x][threadIdx.y + i * COLUMNS_BLOCKDIM_Y] = (imageH - baseY > i * COLUMNS_BLOCKDIM_Y) ? d_Src[i * COLUMNS_BLOCKDIM_Y * pitch] : reset;
+    //Main data and halos, zero padding outside the image
+    for (int i = 0; i < COLUMNS_RESULT_STEPS + 2 * halo_steps; i++) {
+        const int y = baseY + i * COLUMNS_BLOCKDIM_Y;
+        s_Column[threadIdx.y + i * COLUMNS_BLOCKDIM_Y] = (inside && y >= 0 && y < imageH) ? d_Src[y * pitch + baseX] : reset;
     }
 
     //Compute and store results
     __syncthreads();
+    if (!inside) return;
 #pragma unroll
-    for (int i = COLUMNS_HALO_STEPS; i < COLUMNS_HALO_STEPS + COLUMNS_RESULT_STEPS; i++) {
+    for (int step = 0; step < COLUMNS_RESULT_STEPS; step++) {
+        const int i = halo_steps + step;
+        const int y = baseY + i * COLUMNS_BLOCKDIM_Y;
+        if (y >= imageH) break;
         sl::float3 sum(0, 0, 0);
-        int kernel_radius = floorf((KERNEL_RADIUS) * fabs(depth[i * COLUMNS_BLOCKDIM_Y * pitch] - focus_depth));
+        int kernel_radius = _d_kernelRadius(depth[y * pitch_depth + baseX], focus_depth, max_radius);
         int kernel_mid = kernel_radius * kernel_radius - 1 + kernel_radius;
 
         if (kernel_radius > 0) {
             for (int j = -kernel_radius; j <= kernel_radius; ++j) {
-                sum.x += c_kernel[kernel_mid + j] * (float) s_Data[threadIdx.x][threadIdx.y + i * COLUMNS_BLOCKDIM_Y + j].z;
-                sum.y += c_kernel[kernel_mid + j] * (float) s_Data[threadIdx.x][threadIdx.y + i * COLUMNS_BLOCKDIM_Y + j].y;
-                sum.z += c_kernel[kernel_mid + j] * (float) s_Data[threadIdx.x][threadIdx.y + i * COLUMNS_BLOCKDIM_Y + j].x;
+                sum.x += c_kernel[kernel_mid + j] * (float) s_Column[threadIdx.y + i * COLUMNS_BLOCKDIM_Y + j].z;
+                sum.y += c_kernel[kernel_mid + j] * (float) s_Column[threadIdx.y + i * COLUMNS_BLOCKDIM_Y + j].y;
+                sum.z += c_kernel[kernel_mid + j] * (float) s_Column[threadIdx.y + i * COLUMNS_BLOCKDIM_Y + j].x;
             }
         } else {
-            sum.x = (float) s_Data[threadIdx.x][threadIdx.y + i * COLUMNS_BLOCKDIM_Y].z;
-            sum.y = (float) s_Data[threadIdx.x][threadIdx.y + i * COLUMNS_BLOCKDIM_Y].y;
-            sum.z = (float) s_Data[threadIdx.x][threadIdx.y + i * COLUMNS_BLOCKDIM_Y].x;
+            sum.x = (float) s_Column[threadIdx.y + i * COLUMNS_BLOCKDIM_Y].z;
+            sum.y = (float) s_Column[threadIdx.y + i * COLUMNS_BLOCKDIM_Y].y;
+            sum.z = (float) s_Column[threadIdx.y + i * COLUMNS_BLOCKDIM_Y].x;
         }
 
-        d_Dst[i * COLUMNS_BLOCKDIM_Y * pitch].x = sum.x;
-        d_Dst[i * COLUMNS_BLOCKDIM_Y * pitch].y = sum.y;
-        d_Dst[i * COLUMNS_BLOCKDIM_Y * pitch].z = sum.z;
-        d_Dst[i * COLUMNS_BLOCKDIM_Y * pitch].w = 255;
+        sl::uchar4 &dst = d_Dst[y * pitch + baseX];
+        dst.x = sum.x;
+        dst.y = sum.y;
+        dst.z = sum.z;
+        dst.w = 255;
     }
 }
 
 void convolutionColumns(sl::uchar4 *d_Dst, sl::uchar4 *d_Src, float* i_depth, int imageW, int imageH, int depth_pitch, float focus_point) {
-    dim3 blocks(imageW / COLUMNS_BLOCKDIM_X, imageH / (COLUMNS_RESULT_STEPS * COLUMNS_BLOCKDIM_Y));
-    dim3 threads(COLUMNS_BLOCKDIM_X, COLUMNS_BLOCKDIM_Y);
-    _k_convolutionColumns << <blocks, threads >> > (d_Dst, d_Src, i_depth, imageW, imageH, imageW, depth_pitch, focus_point);
+    TilePlan plan = planColumnTiles(imageW, imageH, focus_point);
+    if (plan.blocks_x == 0 || plan.blocks_y == 0) return;
+    dim3 blocks(plan.blocks_x, plan.blocks_y);
+    dim3 threads(plan.threads_x, plan.threads_y);
+    _k_convolutionColumns << <blocks, threads, plan.shared_bytes >> > (d_Dst, d_Src, i_depth, imageW, imageH, imageW, depth_pitch, focus_point, plan.halo_steps, plan.max_radius);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Constant-time convolution filter: one block per line, rows or columns
+////////////////////////////////////////////////////////////////////////////////
+#define BOX_BLOCKDIM 256
+
+// Inclusive running sum of a line in shared memory, by all the threads of the block
+__device__ void _d_runningSum(unsigned int *s_line, int length, unsigned int *s_partial) {
+    // Each thread sums a contiguous chunk, then adds the sum of the chunks before it
+    const int chunk = (length + BOX_BLOCKDIM - 1) / BOX_BLOCKDIM;
+    const int begin = threadIdx.x * chunk;
+    const int end = min(begin + chunk, length);
+    unsigned int sum = 0;
+    for (int i = begin; i < end; i++) {
+        sum += s_line[i];
+        s_line[i] = sum;
+    }
+    s_partial[threadIdx.x] = sum;
+    __syncthreads();
+
+    // Running sum of the chunk sums
+    for (int offset = 1; offset < BOX_BLOCKDIM; offset *= 2) {
+        unsigned int previous = threadIdx.x >= offset ? s_partial[threadIdx.x - offset] : 0;
+        __syncthreads();
+        s_partial[threadIdx.x] += previous;
+        __syncthreads();
+    }
+
+    unsigned int base = threadIdx.x > 0 ? s_partial[threadIdx.x - 1] : 0;
+    for (int i = begin; i < end; i++)
+        s_line[i] += base;
+    __syncthreads();
+}
+
+// The 3 boxes are 3 differences of the third order running sum: 8 reads whatever their widths
+__device__ unsigned int _d_boxSum(const unsigned int *s_sums, int end, int a, int b, int c) {
+    return s_sums[end] + s_sums[end - a - b] + s_sums[end - a - c] + s_sums[end - b - c]
+            - s_sums[end - a] - s_sums[end - b] - s_sums[end - c] - s_sums[end - a - b - c];
+}
+
+// Pixel i of line l: d_Src[l * line_step + i * pixel_step], idem for the depth
+__global__ void _k_boxFilter(sl::uchar4 *d_Dst, sl::uchar4 *d_Src, float* depth, int length, int pixel_step, int line_step,
+                             int depth_pixel_step, int depth_line_step, float focus_depth, bool swap_xz) {
+    // x, y and z running sums of the zero padded line
+    extern __shared__ unsigned int s_sums[];
+    __shared__ unsigned int s_partial[BOX_BLOCKDIM];
+    const int padded_length = length + 2 * BOX_PADDING;
+    unsigned int* s_channels[3] = {s_sums, s_sums + padded_length, s_sums + 2 * padded_length};
+
+    d_Src += blockIdx.x * line_step;
+    d_Dst += blockIdx.x * line_step;
+    depth += blockIdx.x * depth_line_step;
+
+    sl::uchar4 reset(0, 0, 0, 0);
+    for (int i = threadIdx.x; i < padded_length; i += BOX_BLOCKDIM) {
+        const int pixel = i - BOX_PADDING;
+        sl::uchar4 value = (pixel >= 0 && pixel < length) ? d_Src[pixel * pixel_step] : reset;
+        s_channels[0][i] = value.x;
+        s_channels[1][i] = value.y;
+        s_channels[2][i] = value.z;
+    }
+    __syncthreads();
+
+    // Third order: 3 running sums of each channel, they wrap around but their differences are exact
+    for (int order = 0; order < 3; order++)
+        for (int channel = 0; channel < 3; channel++)
+            _d_runningSum(s_channels[channel], padded_length, s_partial);
+
+    for (int pixel = threadIdx.x; pixel < length; pixel += BOX_BLOCKDIM) {
+        int kernel_radius = _d_kernelRadius(depth[pixel * depth_pixel_step], focus_depth, KERNEL_RADIUS);
+        int a = c_box[kernel_radius * 3], b = c_box[kernel_radius * 3 + 1], c = c_box[kernel_radius * 3 + 2];
+        int end = pixel + BOX_PADDING + (a + b + c - 3) / 2;
+        unsigned int weight = a * b * c;
+
+        unsigned int x = _d_boxSum(s_channels[0], end, a, b, c) / weight;
+        unsigned int y = _d_boxSum(s_channels[1], end, a, b, c) / weight;
+        unsigned int z = _d_boxSum(s_channels[2], end, a, b, c) / weight;
+        sl::uchar4 result(swap_xz ? z : x, y, swap_xz ? x : z, 255);
+        d_Dst[pixel * pixel_step] = result;
+    }
+}
+
+// The whole line is in shared memory: 3 * (length + 2 * BOX_PADDING) * 4 bytes, up to 4000 pixels with 48KB
+void convolutionRowsBox(sl::uchar4 *d_Dst, sl::uchar4 *d_Src, float* i_depth, int imageW, int imageH, int depth_pitch, float focus_point) {
+    size_t shared_size = 3 * (imageW + 2 * BOX_PADDING) * sizeof(unsigned int);
+    _k_boxFilter << <imageH, BOX_BLOCKDIM, shared_size >> > (d_Dst, d_Src, i_depth, imageW, 1, imageW, 1, depth_pitch, focus_point, false);
+}
+
+// The blocks read the columns with a stride, but each pixel is read once: the pass is bound by the running sums, not the memory
+void convolutionColumnsBox(sl::uchar4 *d_Dst, sl::uchar4 *d_Src, float* i_depth, int imageW, int imageH, int depth_pitch, float focus_point) {
+    size_t shared_size = 3 * (imageH + 2 * BOX_PADDING) * sizeof(unsigned int);
+    _k_boxFilter << <imageW, BOX_BLOCKDIM, shared_size >> > (d_Dst, d_Src, i_depth, imageH, imageW, 1, depth_pitch, 1, focus_point, true);
 }
@@ -0,0 +1,109 @@
+/*
+ * This file contains the reading and writing of the golden files of the refocus sample.
+*/
+
+#include "golden_io.h"
+
+#include <cstdio>
+#include <cstring>
+
+namespace golden {
+
+bool writePPM(const std::string& path, const dof_cpu::uchar4* pixels, int width, int height, int step, bool bgra) {
+    FILE* file = fopen(path.c_str(), "wb");
+    if (!file) return false;
+    fprintf(file, "P6\n%d %d\n255\n", width, height);
+    std::vector<unsigned char> row(width * 3);
+    bool ok = true;
+    for (int y = 0; y < height && ok; y++) {
+        const dof_cpu::uchar4* src = pixels + static_cast<size_t>(y) * step;
+        for (int x = 0; x < width; x++) {
+            row[x * 3] = bgra ? src[x].z : src[x].x;
+            row[x * 3 + 1] = src[x].y;
+            row[x * 3 + 2] = bgra ? src[x].x : src[x].z;
+        }
+        ok = fwrite(row.data(), 1, row.size(), file) == row.size();
+    }
+    fclose(file);
+    return ok;
+}
+
+bool readPPM(const std::string& path, std::vector<dof_cpu::uchar4>& pixels, int& width, int& height, bool bgra) {
+    FILE* file = fopen(path.c_str(), "rb");
+    if (!file) return false;
+    int max_value = 0;
+    bool ok = fscanf(file, "P6 %d %d %d", &width, &height, &max_value) == 3 && max_value == 255 && width > 0 && height > 0;
+    // A single whitespace ends the header
+    ok = ok && fgetc(file) != EOF;
+    if (ok) {
+        std::vector<unsigned char> rgb(static_cast<size_t>(width) * height * 3);
+        ok = fread(rgb.data(), 1, rgb.size(), file) == rgb.size();
+        pixels.resize(static_cast<size_t>(width) * height);
+        for (size_t i = 0; ok && i < pixels.size(); i++) {
+            pixels[i].x = rgb[i * 3 + (bgra ? 2 : 0)];
+            pixels[i].y = rgb[i * 3 + 1];
+            pixels[i].z = rgb[i * 3 + (bgra ? 0 : 2)];
+            pixels[i].w = 255;
+        }
+    }
+    fclose(file);
+    return ok;
+}
+
+static bool isLittleEndian() {
+    const uint16_t value = 1;
+    unsigned char first;
+    memcpy(&first, &value, 1);
+    return first == 1;
+}
+
+bool writePFM(const std::string& path, const float* values, int width, int height, int step) {
+    FILE* file = fopen(path.c_str(), "wb");
+    if (!file) return false;
+    // Negative scale: little endian floats
+    fprintf(file, "Pf\n%d %d\n%s\n", width, height, isLittleEndian() ? "-1.0" : "1.0");
+    bool ok = true;
+    // PFM rows go from the bottom to the top of the image
+    for (int y = height - 1; y >= 0 && ok; y--)
+        ok = fwrite(values + static_cast<size_t>(y) * step, sizeof(float), width, file) == static_cast<size_t>(width);
+    fclose(file);
+    return ok;
+}
+
+bool readPFM(const std::string& path, std::vector<float>& values, int& width, int& height) {
+    FILE* file = fopen(path.c_str(), "rb");
+    if (!file) return false;
+    float scale = 0.f;
+    bool ok = fscanf(file, "Pf %d %d %f", &width, &height, &scale) == 3 && width > 0 && height > 0;
+    ok = ok && fgetc(file) != EOF && (scale < 0.f) == isLittleEndian();
+    if (ok) {
+        values.resize(static_cast<size_t>(width) * height);
+        for (int y = height - 1; y >= 0 && ok; y--)
+            ok = fread(&values[static_cast<size_t>(y) * width], sizeof(float), width, file) == static_cast<size_t>(width);
+    }
+    fclose(file);
+    return ok;
+}
+
+bool writeParameters(const std::string& path, float focus_point, float min_distance, float max_distance, bool box) {
+    FILE* file = fopen(path.c_str(), "w");
+    if (!file) return false;
+    // 9 significant digits: the floats are read back exactly
+    fprintf(file, "%.9g %.9g %.9g %d\n", focus_point, min_distance, max_distance, box ? 1 : 0);
+    fclose(file);
+    return true;
+}
+
+bool readParameters(const std::string& path, float& focus_point, float& min_distance, float& max_distance, bool& box) {
+    FILE* file = fopen(path.c_str(), "r");
+    if (!file) return false;
+    int box_value = 0;
+    bool ok = fscanf(file, "%f %f %f", &focus_point, &min_distance, &max_distance) == 3;
+    // Gaussian blur if not written
+    if (ok && fscanf(file, "%d", &box_value) != 1) box_value = 0;
+    box = box_value != 0;
+    fclose(file);
+    return ok;
+}
+
+}
@@ -22,6 +22,7 @@
 /****************************************************************************************************
  ** This sample demonstrates how to grab and process images/depth on a CUDA kernel                 **
  ** This sample creates a simple layered depth-of-filed rendering based on CUDAconvolution sample  **
+ ** The same rendering runs on the CPU with --cpu (dof_cpu.h)                                      **
  ****************************************************************************************************/
 
  // ZED SDK include
@@ -37,33 +38,100 @@
 // CUDA functions 
 #include "dof_gpu.h"
 
+// CPU functions and golden files
+#include "dof_cpu.h"
+#include "golden_io.h"
+
+// Upload of the rendering to OpenGL, or to a result sink without display
+#include "DisplayMode.hpp"
+#include "GLPresenter.hpp"
+
+#include <chrono>
+
 using namespace sl;
 using namespace std;
 
-// Declare some resources (GL texture ID, GL shader ID...)
-GLuint imageTex;
-cudaGraphicsResource* pcuImageRes;
+// Textures of the rendering, registered to CUDA or filled from the CPU
+GLPresenter presenter;
+// --headless, --preview N, --sink
+DisplayMode display;
 
 // ZED Camera object
 Camera zed;
 
-// Mat ressources
-Mat gpu_image_left;
-Mat gpu_Image_render;
-Mat gpu_depth;
-Mat gpu_depth_normalized;
-Mat gpu_image_convol;
+// Mat ressources, in GPU memory or in CPU memory with --cpu
+Mat image_left;
+Mat image_render;
+Mat depth;
+Mat depth_normalized;
+Mat image_convol;
+// Copy of the rendering in CPU memory for the sink, GPU rendering only
+Mat image_sink;
+bool use_cpu = false;
+MEM mem = MEM::GPU;
 
 // Focus point detected in pixels (X,Y) when mouse click event
 float norm_depth_focus_point = 0.f;
 
+// Set by the 'd' key, the files are written after the processing of the next frame
+bool dump_golden = false;
+
+// Toggled by the 'b' key: constant-time blur (box_blur.h) instead of the gaussian blur
+bool use_box = false;
+
+static_assert(sizeof(sl::uchar4) == sizeof(dof_cpu::uchar4), "dof_cpu::uchar4 has the layout of sl::uchar4");
+
+dof_cpu::uchar4* cpuPixels(Mat& mat) {
+    return reinterpret_cast<dof_cpu::uchar4*>(mat.getPtr<sl::uchar4>(MEM::CPU));
+}
+
+// Writes the inputs and the output of the rendering in the current folder, for ZED_CUDA_Refocus_CPU_Bench --golden
+void dumpGolden(float min_range, float max_range) {
+    Mat left, depth_raw, depth_norm, render;
+    COPY_TYPE copy_type = use_cpu ? COPY_TYPE::CPU_CPU : COPY_TYPE::GPU_CPU;
+    image_left.copyTo(left, copy_type);
+    depth.copyTo(depth_raw, copy_type);
+    depth_normalized.copyTo(depth_norm, copy_type);
+    image_render.copyTo(render, copy_type);
+    int width = left.getWidth(), height = left.getHeight();
+    bool ok = golden::writePPM(golden::LEFT_FILE, cpuPixels(left), width, height, left.getStep(), true)
+            && golden::writePFM(golden::DEPTH_FILE, depth_raw.getPtr<float>(), width, height, depth_raw.getStep())
+            && golden::writePFM(golden::DEPTH_NORMALIZED_FILE, depth_norm.getPtr<float>(), width, height, depth_norm.getStep())
+            && golden::writePPM(golden::RENDER_FILE, cpuPixels(render), width, height, render.getStep(), false)
+            && golden::writeParameters(golden::PARAMETERS_FILE, norm_depth_focus_point, min_range, max_range, use_box);
+    if (ok)
+        cout << " Golden files of the " << (use_cpu ? "CPU" : "GPU") << " rendering written in the current folder" << endl;
+    else
+        cout << "[Sample][Error] Cannot write the golden files in the current folder" << endl;
+}
+
+void keyPressedCallback(unsigned char key, int x, int y) {
+    if (key == 'd') dump_golden = true;
+    if (key == 'b') {
+        use_box = !use_box;
+        cout << " Blur : " << (use_box ? "constant-time (box)" : "gaussian") << endl;
+    }
+}
+
+// Average time of the refocus, printed every 100 frames
+void addRefocusTime(double ms) {
+    static double total_ms = 0.;
+    static int nb_frames = 0;
+    total_ms += ms;
+    if (++nb_frames == 100) {
+        cout << " " << (use_cpu ? "CPU" : "GPU") << " refocus (" << (use_box ? "box" : "gaussian") << "): " << total_ms / nb_frames << "ms/frame" << endl;
+        total_ms = 0.;
+        nb_frames = 0;
+    }
+}
+
 void mouseButtonCallback(int button, int state, int x, int y) {
     if (button == 0 && state) {
         // Get the depth at the mouse click point
         float depth_focus_point = 0.f;
         float max_range = zed.getInitParameters().depth_maximum_distance;
         float min_range = zed.getInitParameters().depth_minimum_distance;
-        gpu_depth.getValue<sl::float1>(x, y, &depth_focus_point, MEM::GPU);
+        depth.getValue<sl::float1>(x, y, &depth_focus_point, mem);
         // Check that the value is valid
         if (isValidMeasure(depth_focus_point)) {
             cout << " Focus point set at : " << depth_focus_point << "mm {" << x << "," << y << "}" << endl;
@@ -73,38 +141,93 @@ void mouseButtonCallback(int button, int state, int x, int y) {
     }
 }
 
-void draw() {
+// Sends the rendering of the current frame to the sink
+void publishFrame(double refocus_ms) {
+    FrameResult result;
+    result.timestamp = zed.getTimestamp(TIME_REFERENCE::IMAGE).getNanoseconds();
+    result.text = "focus " + to_string(norm_depth_focus_point) + " refocus_ms " + to_string(refocus_ms);
+    Mat& render = use_cpu ? image_render : image_sink;
+    if (!use_cpu) image_render.copyTo(image_sink, COPY_TYPE::GPU_CPU);
+    result.image = render.getPtr<sl::uchar4>(MEM::CPU);
+    result.width = render.getWidth();
+    result.height = render.getHeight();
+    result.channels = 4;
+    result.step = render.getStepBytes(MEM::CPU);
+    display.publish(result);
+}
+
+// Grabs a frame and renders it in image_render
+ERROR_CODE refocusFrame() {
     RuntimeParameters params;
     params.sensing_mode = SENSING_MODE::FILL;
 
-    if (zed.grab(params) == ERROR_CODE::SUCCESS) {
+    ERROR_CODE state = zed.grab(params);
+    if (state == ERROR_CODE::SUCCESS) {
         // Retrieve Image and Depth
-        zed.retrieveImage(gpu_image_left, VIEW::LEFT, MEM::GPU);
-        zed.retrieveMeasure(gpu_depth, MEASURE::DEPTH, MEM::GPU);
+        zed.retrieveImage(image_left, VIEW::LEFT, mem);
+        zed.retrieveMeasure(depth, MEASURE::DEPTH, mem);
 
-        // Process Image with CUDA
         // Normalize the depth map and make separable convolution
         float max_range = zed.getInitParameters().depth_maximum_distance;
         float min_range = zed.getInitParameters().depth_minimum_distance;
 
+        double refocus_ms = 0.;
+        if (use_cpu) {
+            // Process Image on the CPU
+            auto rows = use_box ? dof_cpu::convolutionRowsBox : dof_cpu::convolutionRows;
+            auto columns = use_box ? dof_cpu::convolutionColumnsBox : dof_cpu::convolutionColumns;
+            auto start = chrono::steady_clock::now();
+            dof_cpu::normalizeDepth(depth.getPtr<float>(MEM::CPU), depth_normalized.getPtr<float>(MEM::CPU), depth.getStep(MEM::CPU), min_range, max_range, depth.getWidth(), depth.getHeight());
+            rows(cpuPixels(image_convol), cpuPixels(image_left), depth_normalized.getPtr<float>(MEM::CPU), image_left.getWidth(), image_left.getHeight(), depth_normalized.getStep(MEM::CPU), norm_depth_focus_point);
+            columns(cpuPixels(image_render), cpuPixels(image_convol), depth_normalized.getPtr<float>(MEM::CPU), image_left.getWidth(), image_left.getHeight(), depth_normalized.getStep(MEM::CPU), norm_depth_focus_point);
+            refocus_ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        } else {
+            // Process Image with CUDA
+            static cudaEvent_t events[2] = {nullptr, nullptr};
+            if (!events[0]) {
+                cudaEventCreate(&events[0]);
+                cudaEventCreate(&events[1]);
+            }
+            auto rows = use_box ? convolutionRowsBox : convolutionRows;
+            auto columns = use_box ? convolutionColumnsBox : convolutionColumns;
+            cudaEventRecord(events[0]);
+            normalizeDepth(depth.getPtr<float>(MEM::GPU), depth_normalized.getPtr<float>(MEM::GPU), depth.getStep(MEM::GPU), min_range, max_range, depth.getWidth(), depth.getHeight());
+            rows(image_convol.getPtr<sl::uchar4>(MEM::GPU), image_left.getPtr<sl::uchar4>(MEM::GPU), depth_normalized.getPtr<float>(MEM::GPU), image_left.getWidth(), image_left.getHeight(), depth_normalized.getStep(MEM::GPU), norm_depth_focus_point);
+            columns(image_render.getPtr<sl::uchar4>(MEM::GPU), image_convol.getPtr<sl::uchar4>(MEM::GPU), depth_normalized.getPtr<float>(MEM::GPU), image_left.getWidth(), image_left.getHeight(), depth_normalized.getStep(MEM::GPU), norm_depth_focus_point);
+            cudaEventRecord(events[1]);
+            cudaEventSynchronize(events[1]);
+            float gpu_ms = 0.f;
+            cudaEventElapsedTime(&gpu_ms, events[0], events[1]);
+            refocus_ms = gpu_ms;
+        }
+        addRefocusTime(refocus_ms);
 
-        normalizeDepth(gpu_depth.getPtr<float>(MEM::GPU), gpu_depth_normalized.getPtr<float>(MEM::GPU), gpu_depth.getStep(MEM::GPU), min_range, max_range, gpu_depth.getWidth(), gpu_depth.getHeight());
-        convolutionRows(gpu_image_convol.getPtr<sl::uchar4>(MEM::GPU), gpu_image_left.getPtr<sl::uchar4>(MEM::GPU), gpu_depth_normalized.getPtr<float>(MEM::GPU), gpu_image_left.getWidth(), gpu_image_left.getHeight(), gpu_depth_normalized.getStep(MEM::GPU), norm_depth_focus_point);
-        convolutionColumns(gpu_Image_render.getPtr<sl::uchar4>(MEM::GPU), gpu_image_convol.getPtr<sl::uchar4>(MEM::GPU), gpu_depth_normalized.getPtr<float>(MEM::GPU), gpu_image_left.getWidth(), gpu_image_left.getHeight(), gpu_depth_normalized.getStep(MEM::GPU), norm_depth_focus_point);
+        if (dump_golden) {
+            dumpGolden(min_range, max_range);
+            dump_golden = false;
+        }
+        if (display.hasSink()) publishFrame(refocus_ms);
+    }
+    return state;
+}
 
-        // Map to OpenGL and display
-        cudaArray_t ArrIm;
-        cudaGraphicsMapResources(1, &pcuImageRes, 0);
-        cudaGraphicsSubResourceGetMappedArray(&ArrIm, pcuImageRes, 0, 0);
-        cudaMemcpy2DToArray(ArrIm, 0, 0, gpu_Image_render.getPtr<sl::uchar4>(MEM::GPU), gpu_Image_render.getStepBytes(MEM::GPU), gpu_Image_render.getWidth() * sizeof(sl::uchar4), gpu_Image_render.getHeight(), cudaMemcpyDeviceToDevice);
-        cudaGraphicsUnmapResources(1, &pcuImageRes, 0);
+void draw() {
+    display.nextFrame();
+    if (refocusFrame() == ERROR_CODE::SUCCESS && display.renderFrame()) {
+        if (use_cpu) {
+            // Upload to OpenGL through a pixel buffer, the output is RGBA
+            presenter.uploadHost(image_render.getPtr<sl::uchar4>(MEM::CPU), image_render.getStepBytes(MEM::CPU));
+        } else {
+            // Copy to OpenGL, queued after the kernels on the default stream: the next frame's kernels wait for it
+            presenter.uploadDevice(image_render.getPtr<sl::uchar4>(MEM::GPU), image_render.getStepBytes(MEM::GPU));
+        }
 
         //OpenGL Part
         glDrawBuffer(GL_BACK);
         glLoadIdentity();
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
         glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-        glBindTexture(GL_TEXTURE_2D, imageTex);
+        glBindTexture(GL_TEXTURE_2D, presenter.texture());
 
         glBegin(GL_QUADS);
         glTexCoord2f(0.0, 1.0);
@@ -125,28 +248,43 @@ void draw() {
 
 int main(int argc, char **argv) {
 
-    if (argc > 2) {
-        cout << "Only the path of a SVO can be passed in arg" << endl;
-        return EXIT_FAILURE;
+    if (!display.parse(argc, argv)) return EXIT_FAILURE;
+    string svo_path;
+    for (int i = 1; i < argc; i++) {
+        string arg(argv[i]);
+        if (arg == "--cpu")
+            use_cpu = true;
+        else if (svo_path.empty() && arg[0] != '-')
+            svo_path = arg;
+        else {
+            cout << "Usage : ./ZED_CUDA_Refocus [path.svo] [--cpu] " << DisplayMode::usage() << endl;
+            return EXIT_FAILURE;
+        }
     }
+    mem = use_cpu ? MEM::CPU : MEM::GPU;
 
-    // Init glut
-    glutInit(&argc, argv);
+    // No window nor GL context when headless
+    if (!display.headless()) {
+        // Init glut
+        glutInit(&argc, argv);
 
-    //Create Window
-    glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGBA | GLUT_DEPTH);
-    glutInitWindowPosition(50, 25);
-    glutInitWindowSize(1280, 720);
-    glutCreateWindow("ZED CUDA Refocus");
+        //Create Window
+        glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGBA | GLUT_DEPTH);
+        glutInitWindowPosition(50, 25);
+        glutInitWindowSize(1280, 720);
+        glutCreateWindow("ZED CUDA Refocus");
 
-    //init GLEW
-    glewInit();
+        //init GLEW
+        glewInit();
+    }
     
     InitParameters init_parameters;
     init_parameters.depth_mode = DEPTH_MODE::ULTRA;
     init_parameters.camera_resolution = RESOLUTION::HD720;
     init_parameters.coordinate_units = UNIT::MILLIMETER;
     init_parameters.depth_minimum_distance = 400.0f;
+    if (!svo_path.empty())
+        init_parameters.input.setFromSVOFile(String(svo_path.c_str()));
 
     // Open the camera
     ERROR_CODE zed_open_state = zed.open(init_parameters);
@@ -158,61 +296,82 @@ int main(int argc, char **argv) {
     // Get Image Size
     sl::Resolution camera_resolution_ = zed.getCameraInformation().camera_configuration.resolution;
 
-    // Create and Register OpenGL Texture for Image (RGBA -- 4channels)
-    glEnable(GL_TEXTURE_2D);
-    glGenTextures(1, &imageTex);
-    glBindTexture(GL_TEXTURE_2D, imageTex);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, camera_resolution_.width, camera_resolution_.height, 0, GL_BGRA_EXT, GL_UNSIGNED_BYTE, NULL);
-    glBindTexture(GL_TEXTURE_2D, 0);
-    cudaError_t state = cudaGraphicsGLRegisterImage(&pcuImageRes, imageTex, GL_TEXTURE_2D, cudaGraphicsRegisterFlagsWriteDiscard);
-    if (state != cudaSuccess)
-        return EXIT_FAILURE;
+    if (!display.headless()) {
+        // Create the OpenGL Textures for Image (RGBA -- 4channels), registered to CUDA for the GPU rendering
+        glEnable(GL_TEXTURE_2D);
+        // The kernels write RGBA: no channel reordering
+        if (!presenter.init(camera_resolution_.width, camera_resolution_.height, !use_cpu, PixelFormat::RGBA)) {
+            cout << "[Sample][Error] Cannot create the OpenGL textures of the rendering" << endl;
+            zed.close();
+            return EXIT_FAILURE;
+        }
 
-    glutSetOption(GLUT_ACTION_ON_WINDOW_CLOSE, GLUT_ACTION_CONTINUE_EXECUTION);
+        glutSetOption(GLUT_ACTION_ON_WINDOW_CLOSE, GLUT_ACTION_CONTINUE_EXECUTION);
+    }
 
     // Alloc Mat and tmp buffer
-    gpu_image_left.alloc(camera_resolution_, MAT_TYPE::U8_C4, MEM::GPU);
-    gpu_Image_render.alloc(camera_resolution_, MAT_TYPE::U8_C4, MEM::GPU);
-    gpu_depth.alloc(camera_resolution_, MAT_TYPE::F32_C1, MEM::GPU);
-    gpu_depth_normalized.alloc(camera_resolution_, MAT_TYPE::F32_C1, MEM::GPU);
-    gpu_image_convol.alloc(camera_resolution_, MAT_TYPE::U8_C4, MEM::GPU);
+    image_left.alloc(camera_resolution_, MAT_TYPE::U8_C4, mem);
+    image_render.alloc(camera_resolution_, MAT_TYPE::U8_C4, mem);
+    depth.alloc(camera_resolution_, MAT_TYPE::F32_C1, mem);
+    depth_normalized.alloc(camera_resolution_, MAT_TYPE::F32_C1, mem);
+    image_convol.alloc(camera_resolution_, MAT_TYPE::U8_C4, mem);
+    if (display.hasSink() && !use_cpu) image_sink.alloc(camera_resolution_, MAT_TYPE::U8_C4, MEM::CPU);
+    // The invalid depths keep the normalized depth of the previous frames, none at first
+    depth_normalized.setTo<sl::float1>(0.f, mem);
 
     vector<float> gauss_vec;
-    // Create all the gaussien kernel for different radius and copy them to GPU
+    // Create all the gaussien kernel for different radius and copy them to GPU (or CPU)
     for (int i = 0; i < KERNEL_RADIUS; ++i) {
-        gauss_vec.resize((i + 1) * 2 + 1, 0);
-
-        // Compute Gaussian coeff
-        int rad = (gauss_vec.size() - 1) / 2;
-        float sigma = 0.3f * ((gauss_vec.size() - 1.f)*0.5f - 1.f) + 0.8f;
-        float sum = 0;
-        for (int u = -rad; u <= rad; u++) {
-            float gauss_value = expf(-1.f * (powf(u, 2.f) / (2.f * powf(sigma, 2.f))));
-            gauss_vec[u + rad] = gauss_value;
-            sum += gauss_value;
-        }
-        sum = 1.f / sum;
-        for (int u = 0; u < gauss_vec.size(); u++)
-            gauss_vec[u] *= sum;
-
-        // Copy coeff to GPU
-        copyKernel(gauss_vec.data(), i);
+        dof_cpu::gaussianKernel(i, gauss_vec);
+        if (use_cpu)
+            dof_cpu::copyKernel(gauss_vec.data(), i);
+        else
+            copyKernel(gauss_vec.data(), i);
     }
 
-    cout << "** Click on the image to set the focus distance **" << endl;
-
-    glutDisplayFunc(draw);
-    glutMouseFunc(mouseButtonCallback);
-    glutMainLoop(); // Start main loop 
+    if (use_cpu)
+        cout << "** Refocus on the CPU: " << dof_cpu::getNumThreads() << " threads, " << dof_cpu::getSimdName() << " **" << endl;
+    if (display.headless()) {
+        // Without click, the focus stays at its initial distance. Runs until Ctrl+C or the end of the SVO
+        int nb_failed_grabs = 0;
+        auto last_failure_print = chrono::steady_clock::now();
+        while (display.nextFrame()) {
+            ERROR_CODE state = refocusFrame();
+            if (state == ERROR_CODE::END_OF_SVOFILE_REACHED) break;
+            if (state != ERROR_CODE::SUCCESS) {
+                // Unplugged or stalled camera: 1ms to 128ms between the grabs, and tell it every 5s
+                auto now = chrono::steady_clock::now();
+                if (nb_failed_grabs == 0 || chrono::duration<double>(now - last_failure_print).count() >= 5.) {
+                    cout << "[Sample][Error] Grab failed " << nb_failed_grabs + 1 << " times: " << state << endl;
+                    last_failure_print = now;
+                }
+                sleep_ms(1 << min(nb_failed_grabs, 7));
+                nb_failed_grabs++;
+                continue;
+            }
+            if (nb_failed_grabs > 0) {
+                cout << "[Sample] Camera back after " << nb_failed_grabs << " failed grabs" << endl;
+                nb_failed_grabs = 0;
+            }
+        }
+    } else {
+        cout << "** Display upload: " << presenter.pathName() << ", " << presenter.format().name() << " **" << endl;
+        cout << "** Click on the image to set the focus distance, press 'b' to toggle the constant-time blur, 'd' to dump the golden files **" << endl;
+
+        glutDisplayFunc(draw);
+        glutMouseFunc(mouseButtonCallback);
+        glutKeyboardFunc(keyPressedCallback);
+        glutMainLoop(); // Start main loop 
+    }
 
     //On close
-    gpu_image_left.free();
-    gpu_Image_render.free();
-    gpu_depth.free();
-    gpu_depth_normalized.free();
-    gpu_image_convol.free();
+    presenter.release();
+    image_left.free();
+    image_render.free();
+    depth.free();
+    depth_normalized.free();
+    image_convol.free();
+    image_sink.free();
     zed.close();
     return EXIT_SUCCESS;
 }
@@ -0,0 +1,476 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+/*****************************************************************************
+ ** Validation and throughput of the CPU depth-of-field pipeline (dof_cpu): **
+ **  - against a scalar port of the CUDA kernels, on synthetic scenes        **
+ **  - against the golden files dumped by the GPU sample ('d' key)           **
+ **  - in MP/s, at the ZED resolutions, for 1 thread up to all the cores     **
+ ** The tile plans of the CUDA kernels (tile_planner.h) are executed block by **
+ ** block on odd resolutions: every pixel written once, within the halo.     **
+ ** The constant-time blur (box_blur.h) is checked against a direct          **
+ ** convolution of its boxes and compared to the gaussian blur: PSNR, speed  **
+ ** and cost per radius.                                                     **
+ ** It does not need the ZED SDK nor a CUDA device.                          **
+ *****************************************************************************/
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "dof_cpu.h"
+#include "box_blur.h"
+#include "golden_io.h"
+#include "tile_planner.h"
+
+using namespace std;
+using dof_cpu::uchar4;
+
+// The GPU sums are contracted in fused multiply-adds: a sum can end on the other side of an integer
+// and the difference of the row pass is blurred again by the column pass
+#define GOLDEN_MAX_DIFF 2
+#define REFERENCE_MAX_DIFF 1
+// The constant-time blur is computed in integers, on the GPU as on the CPU
+#define BOX_MAX_DIFF 0
+
+static vector<vector<float>> kernels;
+// Integer weights of the box filter of each radius, their sum is box_weights[r]
+static vector<vector<uint32_t>> box_kernels;
+static vector<uint32_t> box_weights;
+
+////////////////////////////////////////////////////////////////////////////////
+// Scalar port of the CUDA kernels, one output pixel at a time
+////////////////////////////////////////////////////////////////////////////////
+static void referenceNormalizeDepth(const float* depth, float* depth_out, int step, float min_distance, float max_distance, int width, int height) {
+    for (int y = 0; y < height; y++)
+        for (int x = 0; x < width; x++) {
+            float depth_normalized = (max_distance - depth[x + y * step]) / (max_distance - min_distance);
+            if (depth_normalized < 0.f) depth_normalized = 0.f;
+            if (depth_normalized > 1.f) depth_normalized = 1.f;
+            if (isfinite(depth_normalized))
+                depth_out[x + y * step] = depth_normalized;
+        }
+}
+
+static void referenceConvolution(uchar4* dst, const uchar4* src, const float* depth, int width, int height, int depth_pitch, float focus, bool columns) {
+    const uchar4 reset = {0, 0, 0, 0};
+    for (int y = 0; y < height; y++)
+        for (int x = 0; x < width; x++) {
+            float sum[3] = {0.f, 0.f, 0.f};
+            int kernel_radius = floorf((KERNEL_RADIUS) * fabs(depth[x + y * depth_pitch] - focus));
+            for (int j = -kernel_radius; j <= kernel_radius; ++j) {
+                int sx = columns ? x : x + j, sy = columns ? y + j : y;
+                uchar4 s = (sx >= 0 && sx < width && sy >= 0 && sy < height) ? src[sx + sy * width] : reset;
+                float k = kernel_radius > 0 ? kernels[kernel_radius - 1][j + kernel_radius] : 1.f;
+                sum[0] += k * (float) s.x;
+                sum[1] += k * (float) s.y;
+                sum[2] += k * (float) s.z;
+            }
+            uchar4& d = dst[x + y * width];
+            d.x = static_cast<unsigned char>(min(255.f, sum[columns ? 2 : 0]));
+            d.y = static_cast<unsigned char>(min(255.f, sum[1]));
+            d.z = static_cast<unsigned char>(min(255.f, sum[columns ? 0 : 2]));
+            d.w = 255;
+        }
+}
+
+// Direct convolution of the 3 boxes, without running sums
+static void referenceBoxConvolution(uchar4* dst, const uchar4* src, const float* depth, int width, int height, int depth_pitch, float focus, bool columns) {
+    const uchar4 reset = {0, 0, 0, 0};
+    for (int y = 0; y < height; y++)
+        for (int x = 0; x < width; x++) {
+            float radius = floorf((KERNEL_RADIUS) * fabsf(depth[x + y * depth_pitch] - focus));
+            int kernel_radius = radius > 0.f ? min(static_cast<int>(radius), KERNEL_RADIUS) : 0;
+            const vector<uint32_t>& kernel = box_kernels[kernel_radius];
+            const int half_length = static_cast<int>(kernel.size()) / 2;
+            uint32_t sum[3] = {0, 0, 0};
+            for (int j = -half_length; j <= half_length; ++j) {
+                int sx = columns ? x : x + j, sy = columns ? y + j : y;
+                uchar4 s = (sx >= 0 && sx < width && sy >= 0 && sy < height) ? src[sx + sy * width] : reset;
+                sum[0] += kernel[j + half_length] * s.x;
+                sum[1] += kernel[j + half_length] * s.y;
+                sum[2] += kernel[j + half_length] * s.z;
+            }
+            uchar4& d = dst[x + y * width];
+            d.x = static_cast<unsigned char>(sum[columns ? 2 : 0] / box_weights[kernel_radius]);
+            d.y = static_cast<unsigned char>(sum[1] / box_weights[kernel_radius]);
+            d.z = static_cast<unsigned char>(sum[columns ? 0 : 2] / box_weights[kernel_radius]);
+            d.w = 255;
+        }
+}
+
+// Block by block execution of a tile plan of the CUDA kernels, in the order of the threads.
+// Returns false if a pixel is not written once, or if a kernel reads outside the tile in shared memory
+static bool tiledConvolution(const TilePlan& plan, uchar4* dst, const uchar4* src, const float* depth, int width, int height, int depth_pitch,
+                             float focus, bool columns) {
+    const uchar4 reset = {0, 0, 0, 0};
+    const int result_steps = columns ? COLUMNS_RESULT_STEPS : ROWS_RESULT_STEPS;
+    // Threads along the filtered direction, and across it
+    const int along = columns ? plan.threads_y : plan.threads_x;
+    const int across = columns ? plan.threads_x : plan.threads_y;
+    const int tile_size = static_cast<int>(plan.shared_bytes / sizeof(uchar4));
+    const int line_length = columns ? height : width, nb_lines = columns ? width : height;
+    vector<uchar4> tile(tile_size);
+    vector<int> nb_writes(static_cast<size_t>(width) * height, 0);
+    bool ok = true;
+    for (int block_y = 0; block_y < plan.blocks_y; block_y++)
+        for (int block_x = 0; block_x < plan.blocks_x; block_x++) {
+            const int block_along = columns ? block_y : block_x, block_across = columns ? block_x : block_y;
+            // Load, then compute after __syncthreads
+            for (int pass = 0; pass < 2; pass++)
+                for (int t_across = 0; t_across < across; t_across++)
+                    for (int t_along = 0; t_along < along; t_along++) {
+                        const int line = block_across * across + t_across;
+                        const int base = (block_along * result_steps - plan.halo_steps) * along + t_along;
+                        uchar4* s_line = tile.data() + t_across * plan.tile_stride;
+                        auto pixel = [&](int position) { return columns ? line + position * width : position + line * width; };
+                        if (pass == 0) {
+                            for (int i = 0; i < result_steps + 2 * plan.halo_steps; i++) {
+                                const int position = base + i * along;
+                                s_line[t_along + i * along] = (line < nb_lines && position >= 0 && position < line_length) ? src[pixel(position)] : reset;
+                            }
+                            continue;
+                        }
+                        if (line >= nb_lines) continue;
+                        for (int step = 0; step < result_steps; step++) {
+                            const int i = plan.halo_steps + step;
+                            const int position = base + i * along;
+                            if (position >= line_length) break;
+                            const int x = columns ? line : position, y = columns ? position : line;
+                            float radius = floorf((KERNEL_RADIUS) * fabsf(depth[x + y * depth_pitch] - focus));
+                            int kernel_radius = radius > 0.f ? static_cast<int>(radius) : 0;
+                            const int center = t_across * plan.tile_stride + t_along + i * along;
+                            if (kernel_radius > plan.max_radius || center - kernel_radius < t_across * plan.tile_stride
+                                    || center + kernel_radius >= min(tile_size, (t_across + 1) * plan.tile_stride)) {
+                                ok = false;
+                                continue;
+                            }
+                            float sum[3] = {0.f, 0.f, 0.f};
+                            for (int j = -kernel_radius; j <= kernel_radius; ++j) {
+                                const uchar4& v = s_line[t_along + i * along + j];
+                                float k = kernel_radius > 0 ? kernels[kernel_radius - 1][j + kernel_radius] : 1.f;
+                                sum[0] += k * (float) v.x;
+                                sum[1] += k * (float) v.y;
+                                sum[2] += k * (float) v.z;
+                            }
+                            uchar4& d = dst[pixel(position)];
+                            d.x = static_cast<unsigned char>(min(255.f, sum[columns ? 2 : 0]));
+                            d.y = static_cast<unsigned char>(min(255.f, sum[1]));
+                            d.z = static_cast<unsigned char>(min(255.f, sum[columns ? 0 : 2]));
+                            d.w = 255;
+                            nb_writes[pixel(position)]++;
+                        }
+                    }
+        }
+    for (int n : nb_writes) ok &= n == 1;
+    return ok;
+}
+
+static void buildBoxKernels() {
+    box_kernels.assign(KERNEL_RADIUS + 1, vector<uint32_t>(1, 1));
+    box_weights.assign(KERNEL_RADIUS + 1, 1);
+    for (int radius = 1; radius <= KERNEL_RADIUS; radius++) {
+        BoxWidths widths = boxWidths(kernels[radius - 1].data(), radius);
+        vector<uint32_t> kernel(1, 1);
+        for (int width : {widths.a, widths.b, widths.c}) {
+            vector<uint32_t> next(kernel.size() + width - 1, 0);
+            for (size_t i = 0; i < kernel.size(); i++)
+                for (int j = 0; j < width; j++) next[i + j] += kernel[i];
+            kernel.swap(next);
+        }
+        box_kernels[radius] = kernel;
+        box_weights[radius] = widths.a * widths.b * widths.c;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Helpers
+////////////////////////////////////////////////////////////////////////////////
+struct Scene {
+    int width, height;
+    vector<uchar4> image;
+    vector<float> depth;
+    float min_distance = 400.f, max_distance = 20000.f, focus = 0.35f;
+};
+
+// Textured background, objects at several depths, invalid (NaN) and out of range (inf) depths
+static Scene syntheticScene(int width, int height) {
+    Scene scene;
+    scene.width = width;
+    scene.height = height;
+    scene.image.resize(width * height);
+    scene.depth.resize(width * height);
+    uint32_t seed = 1234567u;
+    auto random = [&seed]() {
+        seed = seed * 1664525u + 1013904223u;
+        return seed >> 8;
+    };
+    for (int y = 0; y < height; y++)
+        for (int x = 0; x < width; x++) {
+            uchar4& p = scene.image[x + y * width];
+            bool checker = ((x / 24) + (y / 24)) % 2;
+            p.x = static_cast<uint8_t>((x * 255) / width);
+            p.y = static_cast<uint8_t>(checker ? 220 : 30);
+            p.z = static_cast<uint8_t>(random() & 0xFF);
+            p.w = 255;
+            // Floor from far (top) to near (bottom), three boxes in front of it
+            float depth = scene.max_distance * 1.2f - (scene.max_distance * 1.2f - 200.f) * y / height;
+            if (x > width / 8 && x < width / 3 && y > height / 4 && y < height * 3 / 4) depth = 1500.f;
+            if (x > width / 2 && x < width * 2 / 3 && y > height / 3 && y < height * 2 / 3) depth = 5000.f + 10.f * (x % 50);
+            if (x > width * 3 / 4 && y < height / 2) depth = 12000.f;
+            uint32_t r = random() % 100;
+            if (r < 3) depth = NAN;
+            else if (r < 4) depth = INFINITY;
+            scene.depth[x + y * width] = depth;
+        }
+    return scene;
+}
+
+struct Comparison {
+    int max_diff = 0;
+    double identical = 0.;  // % of the pixels
+    double psnr = INFINITY;
+};
+
+static Comparison compare(const vector<uchar4>& a, const vector<uchar4>& b) {
+    Comparison result;
+    double squared_error = 0.;
+    size_t nb_identical = 0;
+    for (size_t i = 0; i < a.size(); i++) {
+        int dx = abs(a[i].x - b[i].x), dy = abs(a[i].y - b[i].y), dz = abs(a[i].z - b[i].z);
+        result.max_diff = max(result.max_diff, max(dx, max(dy, dz)));
+        squared_error += dx * dx + dy * dy + dz * dz;
+        if (dx + dy + dz == 0) nb_identical++;
+    }
+    result.identical = 100. * nb_identical / a.size();
+    if (squared_error > 0.) result.psnr = 10. * log10(255. * 255. / (squared_error / (a.size() * 3)));
+    return result;
+}
+
+static void printComparison(const char* name, const Comparison& comparison, int max_diff) {
+    char psnr[32] = "inf";
+    if (!isinf(comparison.psnr)) snprintf(psnr, sizeof(psnr), "%.1f dB", comparison.psnr);
+    printf("  %-24s max diff %d, %6.2f%% identical, PSNR %s%s\n", name, comparison.max_diff, comparison.identical, psnr,
+            comparison.max_diff > max_diff ? "  MISMATCH" : "");
+}
+
+static void runCpu(Scene& scene, vector<float>& depth_normalized, vector<uchar4>& tmp, vector<uchar4>& render, bool box, double* timings = nullptr) {
+    auto rows = box ? dof_cpu::convolutionRowsBox : dof_cpu::convolutionRows;
+    auto columns = box ? dof_cpu::convolutionColumnsBox : dof_cpu::convolutionColumns;
+    auto t0 = chrono::steady_clock::now();
+    dof_cpu::normalizeDepth(scene.depth.data(), depth_normalized.data(), scene.width, scene.min_distance, scene.max_distance, scene.width, scene.height);
+    auto t1 = chrono::steady_clock::now();
+    rows(tmp.data(), scene.image.data(), depth_normalized.data(), scene.width, scene.height, scene.width, scene.focus);
+    auto t2 = chrono::steady_clock::now();
+    columns(render.data(), tmp.data(), depth_normalized.data(), scene.width, scene.height, scene.width, scene.focus);
+    auto t3 = chrono::steady_clock::now();
+    if (timings) {
+        timings[0] += chrono::duration<double, milli>(t1 - t0).count();
+        timings[1] += chrono::duration<double, milli>(t2 - t1).count();
+        timings[2] += chrono::duration<double, milli>(t3 - t2).count();
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Golden files of the GPU sample
+////////////////////////////////////////////////////////////////////////////////
+static bool checkGolden(const string& folder) {
+    Scene scene;
+    vector<float> gpu_depth_normalized;
+    vector<uchar4> gpu_render;
+    int w = 0, h = 0;
+    bool box = false;
+    string path = folder + "/";
+    bool ok = golden::readPPM(path + golden::LEFT_FILE, scene.image, scene.width, scene.height, true)
+            && golden::readPFM(path + golden::DEPTH_FILE, scene.depth, w, h) && w == scene.width && h == scene.height
+            && golden::readPFM(path + golden::DEPTH_NORMALIZED_FILE, gpu_depth_normalized, w, h) && w == scene.width && h == scene.height
+            && golden::readPPM(path + golden::RENDER_FILE, gpu_render, w, h, false) && w == scene.width && h == scene.height
+            && golden::readParameters(path + golden::PARAMETERS_FILE, scene.focus, scene.min_distance, scene.max_distance, box);
+    if (!ok) {
+        printf("[Sample][Error] Invalid or missing golden files in %s\n", folder.c_str());
+        return false;
+    }
+    printf("Golden %s: %dx%d, focus %.3f, %s blur\n", folder.c_str(), scene.width, scene.height, scene.focus, box ? "box" : "gaussian");
+
+    // The invalid depths keep the value of the previous frames on the GPU: start from its output
+    vector<float> depth_normalized = gpu_depth_normalized;
+    vector<uchar4> tmp(scene.image.size()), render(scene.image.size());
+    runCpu(scene, depth_normalized, tmp, render, box);
+
+    size_t nb_depth_diff = 0;
+    for (size_t i = 0; i < depth_normalized.size(); i++)
+        if (depth_normalized[i] != gpu_depth_normalized[i] && !(std::isnan(depth_normalized[i]) && std::isnan(gpu_depth_normalized[i])))
+            nb_depth_diff++;
+    printf("  %-24s %zu different values%s\n", "normalizeDepth", nb_depth_diff, nb_depth_diff ? "  MISMATCH" : "");
+    const int max_diff = box ? BOX_MAX_DIFF : GOLDEN_MAX_DIFF;
+    Comparison comparison = compare(render, gpu_render);
+    printComparison("render", comparison, max_diff);
+    return nb_depth_diff == 0 && comparison.max_diff <= max_diff;
+}
+
+int main(int argc, char **argv) {
+    int nb_iterations = 10;
+    string golden_folder;
+    for (int i = 1; i < argc; i++) {
+        string arg(argv[i]);
+        if (arg == "--golden" && i + 1 < argc) golden_folder = argv[++i];
+        else if (arg == "--iterations" && i + 1 < argc) nb_iterations = max(1, atoi(argv[++i]));
+        else {
+            printf("Usage : ./ZED_CUDA_Refocus_CPU_Bench [--golden folder] [--iterations 10]\n");
+            return EXIT_FAILURE;
+        }
+    }
+
+    // The kernels of the sample
+    kernels.resize(KERNEL_RADIUS);
+    for (int i = 0; i < KERNEL_RADIUS; ++i) {
+        dof_cpu::gaussianKernel(i, kernels[i]);
+        dof_cpu::copyKernel(kernels[i].data(), i);
+    }
+    buildBoxKernels();
+
+    const int nb_cores = dof_cpu::getNumThreads();
+#ifdef _OPENMP
+    const char* threading = "OpenMP";
+#else
+    const char* threading = "std::thread";
+#endif
+    printf("Refocus CPU: %s, %s, %d cores, %d iterations\n", dof_cpu::getSimdName(), threading, nb_cores, nb_iterations);
+
+    bool ok = true;
+    if (!golden_folder.empty()) ok = checkGolden(golden_folder);
+
+    // Tile plans of the CUDA kernels: odd resolutions, focus from the near to the far plane
+    printf("GPU tile plans vs reference\n");
+    printf("  %10s %6s %15s %15s %7s %10s\n", "resolution", "focus", "rows blocks", "columns blocks", "halo", "result");
+    struct { int width, height; } tiled_resolutions[] = {{672, 376}, {1920, 1080}, {2208, 1242}, {1281, 7}, {37, 13}, {1, 1}};
+    for (auto& res : tiled_resolutions)
+        for (float focus : {0.f, 0.35f, 0.5f, 1.f}) {
+            Scene scene = syntheticScene(res.width, res.height);
+            scene.focus = focus;
+            const size_t nb_pixels = scene.image.size();
+            vector<float> depth_normalized(nb_pixels, 0.f);
+            vector<uchar4> ref_tmp(nb_pixels), ref_render(nb_pixels), tmp(nb_pixels), render(nb_pixels);
+            referenceNormalizeDepth(scene.depth.data(), depth_normalized.data(), res.width, scene.min_distance, scene.max_distance, res.width, res.height);
+            referenceConvolution(ref_tmp.data(), scene.image.data(), depth_normalized.data(), res.width, res.height, res.width, focus, false);
+            referenceConvolution(ref_render.data(), ref_tmp.data(), depth_normalized.data(), res.width, res.height, res.width, focus, true);
+            TilePlan rows = planRowTiles(res.width, res.height, focus), columns = planColumnTiles(res.width, res.height, focus);
+            bool tiles_ok = tiledConvolution(rows, tmp.data(), scene.image.data(), depth_normalized.data(), res.width, res.height, res.width, focus, false)
+                    && tiledConvolution(columns, render.data(), ref_tmp.data(), depth_normalized.data(), res.width, res.height, res.width, focus, true);
+            tiles_ok = tiles_ok && compare(tmp, ref_tmp).max_diff == 0 && compare(render, ref_render).max_diff == 0;
+            char name[32], rows_blocks[32], columns_blocks[32], halo[32];
+            snprintf(name, sizeof(name), "%dx%d", res.width, res.height);
+            snprintf(rows_blocks, sizeof(rows_blocks), "%dx%d", rows.blocks_x, rows.blocks_y);
+            snprintf(columns_blocks, sizeof(columns_blocks), "%dx%d", columns.blocks_x, columns.blocks_y);
+            snprintf(halo, sizeof(halo), "%d/%d", rows.halo_steps * ROWS_BLOCKDIM_X, columns.halo_steps * COLUMNS_BLOCKDIM_Y);
+            printf("  %10s %6.2f %15s %15s %7s %10s\n", name, focus, rows_blocks, columns_blocks, halo, tiles_ok ? "identical" : "MISMATCH");
+            ok &= tiles_ok;
+        }
+
+    struct { const char* name; int width, height; } resolutions[] = {
+        {"VGA", 672, 376}, {"HD720", 1280, 720}, {"HD1080", 1920, 1080}
+    };
+    for (auto& res : resolutions) {
+        Scene scene = syntheticScene(res.width, res.height);
+        const size_t nb_pixels = scene.image.size();
+        printf("%s %dx%d\n", res.name, res.width, res.height);
+
+        vector<float> ref_depth_normalized(nb_pixels, 0.f);
+        vector<uchar4> ref_tmp(nb_pixels), ref_render(nb_pixels);
+        auto t0 = chrono::steady_clock::now();
+        referenceNormalizeDepth(scene.depth.data(), ref_depth_normalized.data(), res.width, scene.min_distance, scene.max_distance, res.width, res.height);
+        referenceConvolution(ref_tmp.data(), scene.image.data(), ref_depth_normalized.data(), res.width, res.height, res.width, scene.focus, false);
+        referenceConvolution(ref_render.data(), ref_tmp.data(), ref_depth_normalized.data(), res.width, res.height, res.width, scene.focus, true);
+        double reference_ms = chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+
+        vector<float> depth_normalized(nb_pixels, 0.f);
+        vector<uchar4> tmp(nb_pixels), render(nb_pixels);
+        dof_cpu::setNumThreads(0);
+        runCpu(scene, depth_normalized, tmp, render, false);
+        bool depth_identical = memcmp(depth_normalized.data(), ref_depth_normalized.data(), nb_pixels * sizeof(float)) == 0;
+        printf("  %-24s %s\n", "normalizeDepth", depth_identical ? "identical" : "MISMATCH");
+        Comparison comparison = compare(tmp, ref_tmp);
+        printComparison("rows vs reference", comparison, REFERENCE_MAX_DIFF);
+        ok &= comparison.max_diff <= REFERENCE_MAX_DIFF;
+        comparison = compare(render, ref_render);
+        printComparison("render vs reference", comparison, REFERENCE_MAX_DIFF);
+        ok &= depth_identical && comparison.max_diff <= REFERENCE_MAX_DIFF;
+
+        // Constant-time blur: exact against its direct convolution, approximation of the gaussian blur
+        vector<uchar4> ref_box_tmp(nb_pixels), ref_box_render(nb_pixels), box_tmp(nb_pixels), box_render(nb_pixels);
+        referenceBoxConvolution(ref_box_tmp.data(), scene.image.data(), ref_depth_normalized.data(), res.width, res.height, res.width, scene.focus, false);
+        referenceBoxConvolution(ref_box_render.data(), ref_box_tmp.data(), ref_depth_normalized.data(), res.width, res.height, res.width, scene.focus, true);
+        runCpu(scene, depth_normalized, box_tmp, box_render, true);
+        comparison = compare(box_render, ref_box_render);
+        printComparison("box vs box reference", comparison, BOX_MAX_DIFF);
+        ok &= comparison.max_diff <= BOX_MAX_DIFF;
+        printComparison("box vs gaussian", compare(box_render, render), 255);
+
+        for (int box = 0; box < 2; box++) {
+            printf("  %8s %10s %10s %10s %10s %10s %8s\n", box ? "box" : "gaussian", "normalize", "rows", "columns", "total", "MP/s", "speedup");
+            if (!box)
+                printf("  %8s %10s %10s %10s %7.2f ms %10.1f %8s\n", "scalar", "", "", "", reference_ms, nb_pixels / (reference_ms * 1e3), "1.00x");
+            for (int nb_threads = 1;; nb_threads = min(nb_threads * 2, nb_cores)) {
+                dof_cpu::setNumThreads(nb_threads);
+                // Warm up: scratch buffers and threads
+                runCpu(scene, depth_normalized, tmp, render, box);
+                double timings[3] = {0., 0., 0.};
+                for (int i = 0; i < nb_iterations; i++)
+                    runCpu(scene, depth_normalized, tmp, render, box, timings);
+                for (auto& timing : timings) timing /= nb_iterations;
+                double total = timings[0] + timings[1] + timings[2];
+                printf("  %8d %7.2f ms %7.2f ms %7.2f ms %7.2f ms %10.1f %7.2fx\n", nb_threads, timings[0], timings[1], timings[2], total,
+                        nb_pixels / (total * 1e3), reference_ms / total);
+                if (nb_threads == nb_cores) break;
+            }
+        }
+    }
+
+    // Cost per radius: the whole HD720 image at the same blur, 1 thread
+    printf("Uniform blur, HD720, 1 thread\n");
+    printf("  %8s %12s %12s\n", "radius", "gaussian", "box");
+    Scene scene = syntheticScene(1280, 720);
+    vector<float> depth_normalized(scene.image.size(), 0.f);
+    vector<uchar4> tmp(scene.image.size()), render(scene.image.size());
+    dof_cpu::setNumThreads(1);
+    for (int radius : {0, 4, 8, 16, 32}) {
+        // Normalized depth (radius + 0.5) / KERNEL_RADIUS, focus on the far plane
+        const float normalized = min(1.f, (radius + 0.5f) / KERNEL_RADIUS);
+        for (auto& depth : scene.depth) depth = scene.max_distance - normalized * (scene.max_distance - scene.min_distance);
+        scene.focus = 0.f;
+        double ms[2];
+        for (int box = 0; box < 2; box++) {
+            double timings[3] = {0., 0., 0.};
+            for (int i = 0; i < nb_iterations; i++)
+                runCpu(scene, depth_normalized, tmp, render, box, timings);
+            ms[box] = (timings[1] + timings[2]) / nb_iterations;
+        }
+        printf("  %8d %9.2f ms %9.2f ms\n", radius, ms[0], ms[1]);
+    }
+
+    dof_cpu::setNumThreads(0);
+    printf("%s\n", ok ? "PASSED" : "FAILED");
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,109 @@
+#ifndef __CAPTURE_SERVICE_HPP__
+#define __CAPTURE_SERVICE_HPP__
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+#include "FrameSetMatcher.hpp"
+
+///
+/// \brief A camera of the capture service, grab() is only called from the grab thread of this camera
+///
+class FrameGrabber {
+public:
+    virtual ~FrameGrabber() {}
+    ///
+    /// \brief wait for the next frame and write it into image (already allocated with getSize() and getType())
+    /// \param timestamp : capture time of the frame in nanoseconds, on a clock shared by all the cameras
+    ///
+    virtual bool grab(cv::Mat& image, uint64_t& timestamp) = 0;
+    virtual cv::Size getSize() const = 0;
+    virtual int getType() const = 0;
+};
+
+///
+/// \brief Frames of all the cameras, captured within the tolerance of the service
+///
+struct FrameSet {
+    std::vector<cv::Mat> images;        ///< in camera order, they stay valid until the next getFrameSet()
+    std::vector<uint64_t> timestamps;
+    uint64_t skew = 0;                  ///< newest - oldest timestamp, nanoseconds
+};
+
+///
+/// \brief Counters of a camera of the service
+///
+struct CameraStats {
+    float fps = 0.f;                    ///< frames grabbed per second, over the last second
+    uint64_t nb_grabbed = 0;
+    uint64_t nb_grab_errors = 0;
+    uint64_t nb_dropped = 0;            ///< grabbed frames which were not part of any set
+};
+
+///
+/// \brief The CaptureService class
+/// One grab thread per camera writes the frames in a ring of buffers owned by the service, a FrameSetMatcher pairs
+/// them by timestamp and the consumer gets the sets with getFrameSet(). The frames are never copied: the set
+/// references the ring buffers, which are given back to the grab threads with the next call.
+///
+class CaptureService {
+public:
+    ///
+    /// \param grabbers : the cameras, not owned
+    /// \param tolerance : maximum skew of a set, nanoseconds
+    /// \param ring_size : buffers per camera, at least 4 (one being written, one in the consumer set, the others queued)
+    ///
+    CaptureService(const std::vector<FrameGrabber*>& grabbers, uint64_t tolerance, int ring_size = 6);
+    ~CaptureService();
+
+    ///
+    /// \brief called first by the grab thread of each camera, with the camera index (e.g. to pin the thread)
+    ///
+    void setThreadInit(std::function<void(int)> init) { thread_init = init; }
+
+    void start();
+    void stop();
+
+    ///
+    /// \brief wait for the next frame set, the images of the previous one are released
+    /// \return false after timeout_ms, or if the service is stopped
+    ///
+    bool getFrameSet(FrameSet& set, int timeout_ms);
+
+    int getNbCameras() const { return static_cast<int>(cameras.size()); }
+    std::vector<CameraStats> getCameraStats();
+    MatcherStats getMatcherStats();
+
+private:
+    struct Camera {
+        FrameGrabber* grabber;
+        std::vector<cv::Mat> ring;
+        std::vector<int> free_slots;
+        int held_slot = -1;             ///< slot in the consumer set
+        std::thread thread;
+        CameraStats stats;
+        uint64_t frames_in_window = 0;
+        std::chrono::steady_clock::time_point window_start;
+    };
+
+    void grabLoop(int camera);
+    void release(const std::vector<QueuedFrame>& frames);
+
+    std::vector<Camera> cameras;
+    FrameSetMatcher matcher;
+    std::function<void(int)> thread_init;
+
+    std::mutex mtx;
+    std::condition_variable set_cv, free_cv;
+    std::atomic<bool> running{false};
+    std::vector<QueuedFrame> released;
+};
+
+#endif
@@ -0,0 +1,72 @@
+#ifndef __FRAME_PUBLISHER_HPP__
+#define __FRAME_PUBLISHER_HPP__
+
+#include <atomic>
+#include <cstdint>
+
+#include <opencv2/opencv.hpp>
+
+///
+/// \brief The FramePublisher class
+/// Triple buffer between one writer thread and one reader thread, without lock nor copy.
+/// The writer fills the back buffer and publishes it, the reader takes the last published one. The three buffers
+/// are only exchanged through an atomic index swap, so the writer never waits for the reader and the reader always
+/// gets a complete frame: when the reader is slower, the intermediate frames are overwritten.
+///
+class FramePublisher {
+public:
+    FramePublisher() {}
+    FramePublisher(cv::Size size, int type) { init(size, type); }
+
+    void init(cv::Size size, int type) {
+        for (int i = 0; i < 3; i++) {
+            buffers[i] = cv::Mat(size, type);
+            timestamps[i] = 0;
+        }
+        back_index = 0;
+        middle.store(1);
+        front_index = 2;
+    }
+
+    ///
+    /// \brief writer side, the buffer to fill before publish(). Only the writer accesses it.
+    ///
+    cv::Mat& back() { return buffers[back_index]; }
+    int backIndex() const { return back_index; }
+    cv::Mat& buffer(int index) { return buffers[index]; }
+
+    ///
+    /// \brief writer side, makes the back buffer the latest frame and gets a free one as new back buffer
+    ///
+    void publish(uint64_t timestamp) {
+        timestamps[back_index] = timestamp;
+        // release: the frame written in the back buffer is visible to the reader which swaps it in
+        back_index = middle.exchange(back_index | NEW_FRAME, std::memory_order_acq_rel) & INDEX_MASK;
+    }
+
+    ///
+    /// \brief reader side, takes the latest published frame if it was not read yet
+    /// \param image : the frame, valid until the next call of acquire()
+    /// \return false if nothing was published since the previous call
+    ///
+    bool acquire(cv::Mat& image, uint64_t& timestamp) {
+        if (!(middle.load(std::memory_order_relaxed) & NEW_FRAME)) return false;
+        // acquire: the content of the published buffer is complete
+        front_index = middle.exchange(front_index, std::memory_order_acq_rel) & INDEX_MASK;
+        image = buffers[front_index];
+        timestamp = timestamps[front_index];
+        return true;
+    }
+
+private:
+    static const int INDEX_MASK = 3;
+    static const int NEW_FRAME = 4;
+
+    cv::Mat buffers[3];
+    uint64_t timestamps[3];
+    int back_index = 0;             ///< writer only
+    std::atomic<int> middle{1};     ///< index of the latest published buffer, with NEW_FRAME until it is read
+    int front_index = 2;            ///< reader only
+};
+
+#endif
@@ -0,0 +1,72 @@
+#ifndef __FRAME_SET_MATCHER_HPP__
+#define __FRAME_SET_MATCHER_HPP__
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+///
+/// \brief A frame waiting to be matched, slot is the index of its buffer in the camera ring
+///
+struct QueuedFrame {
+    int camera;
+    uint64_t timestamp;
+    int slot;
+};
+
+///
+/// \brief Counters of a FrameSetMatcher
+///
+struct MatcherStats {
+    uint64_t nb_sets = 0;
+    std::vector<uint64_t> nb_dropped;       ///< per camera, frames which were not part of any set
+    std::vector<uint64_t> skew_histogram;   ///< skew (newest - oldest timestamp) of the sets
+    uint64_t bin_width = 0;                 ///< nanoseconds per histogram bin
+};
+
+///
+/// \brief The FrameSetMatcher class
+/// Assembles sets of one frame per camera whose timestamps are within a tolerance. Only works on timestamps
+/// and buffer slots, the frames themselves stay in the camera rings. Not thread safe.
+///
+class FrameSetMatcher {
+public:
+    ///
+    /// \param tolerance : maximum skew of a set, nanoseconds
+    /// \param max_queued : frames kept per camera while waiting for the others, the oldest is dropped beyond
+    /// \param nb_bins : number of bins of the skew histogram, covering [0, tolerance]
+    ///
+    FrameSetMatcher(int nb_cameras, uint64_t tolerance, size_t max_queued, int nb_bins = 10);
+
+    ///
+    /// \brief add a frame of a camera, its timestamp must be newer than the previous one of this camera
+    /// \param released : the frames dropped to make room are appended, their slots can be reused
+    ///
+    void push(int camera, uint64_t timestamp, int slot, std::vector<QueuedFrame>& released);
+
+    ///
+    /// \brief try to assemble the oldest possible set
+    /// \param set : one frame per camera, in camera order, when a set is found
+    /// \param released : the frames which can not be part of a set anymore are appended
+    ///
+    bool match(std::vector<QueuedFrame>& set, std::vector<QueuedFrame>& released);
+
+    ///
+    /// \brief all the queued frames, to release them when stopping
+    ///
+    void clear(std::vector<QueuedFrame>& released);
+
+    const MatcherStats& getStats() const { return stats; }
+    uint64_t getTolerance() const { return tolerance; }
+
+private:
+    void drop(int camera, std::vector<QueuedFrame>& released);
+
+    std::vector<std::deque<QueuedFrame>> queues;
+    uint64_t tolerance;
+    size_t max_queued;
+    MatcherStats stats;
+};
+
+#endif
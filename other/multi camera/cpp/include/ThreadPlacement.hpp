@@ -0,0 +1,141 @@
+#ifndef __THREAD_PLACEMENT_HPP__
+#define __THREAD_PLACEMENT_HPP__
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+///
+/// \brief CPUs of each NUMA node of the machine
+///
+struct CpuTopology {
+    std::vector<std::vector<int>> node_cpus;
+
+    ///
+    /// \brief reads /sys/devices/system/node, one node with all the CPUs of the process when not available
+    ///
+    static CpuTopology detect();
+
+    std::vector<int> allCpus() const;
+    int nodeOf(int cpu) const;
+    int getNbNodes() const { return static_cast<int>(node_cpus.size()); }
+};
+
+///
+/// \brief parse a Linux CPU list such as "0-3,8,10-11"
+///
+bool parseCpuList(const std::string& text, std::vector<int>& cpus);
+std::string formatCpuList(const std::vector<int>& cpus);
+
+///
+/// \brief NUMA node of a device, from any sysfs or /dev path of it (the parents are searched for numa_node)
+/// \return -1 if unknown
+///
+int numaNodeOfDevice(const std::string& path);
+
+///
+/// \brief Where the threads of a role go
+///
+struct PlacementTarget {
+    enum class KIND { ANY, CPUS, NODE, LOCAL };
+    KIND kind = KIND::ANY;
+    std::vector<int> cpus;              ///< KIND::CPUS
+    int node = -1;                      ///< KIND::NODE
+};
+
+struct PlacementRule {
+    std::string role;                   ///< "grab", "display"... or "*"
+    int camera = -1;                    ///< -1 for all the cameras
+    PlacementTarget target;
+};
+
+///
+/// \brief The PlacementPolicy class
+/// Rules separated by ';', each "role[:camera]=target", target being:
+///  - a CPU list ("2-3,6"), the thread is pinned to these CPUs
+///  - "node:N", the thread may run on any CPU of NUMA node N
+///  - "local", the NUMA node of the camera device (USB controller), from the device node given to resolve()
+///  - "any", no placement
+/// The most specific rule applies: role and camera, then role for all cameras, then "*".
+/// Example: "grab:0=2;grab:1=3;grab=local;display=node:0"
+///
+class PlacementPolicy {
+public:
+    ///
+    /// \param error : description of the invalid rule when false is returned
+    ///
+    static bool parse(const std::string& text, PlacementPolicy& policy, std::string& error);
+
+    ///
+    /// \brief the CPUs a thread is allowed to run on, empty for no placement
+    /// \param device_node : NUMA node of the camera device, for "local" (-1 if unknown: no placement)
+    ///
+    std::vector<int> resolve(const std::string& role, int camera, int device_node, const CpuTopology& topology) const;
+
+    bool empty() const { return rules.empty(); }
+    const std::vector<PlacementRule>& getRules() const { return rules; }
+
+private:
+    std::vector<PlacementRule> rules;
+};
+
+///
+/// \brief pin the calling thread to cpus (no change if empty)
+///
+bool setCurrentThreadAffinity(const std::vector<int>& cpus);
+
+///
+/// \brief name of the calling thread, as shown by top -H or a debugger (truncated to 15 characters on Linux)
+///
+void setCurrentThreadName(const std::string& name);
+
+///
+/// \brief Scheduling statistics of a thread, from /proc/self/task/<tid>/schedstat and sched
+///
+struct ThreadSchedStats {
+    std::string name;
+    std::vector<int> cpus;              ///< placement, empty if not pinned
+    uint64_t run_ns = 0;                ///< time on a CPU
+    uint64_t wait_ns = 0;               ///< time runnable but waiting for a CPU
+    uint64_t nb_timeslices = 0;
+    uint64_t nb_migrations = 0;         ///< 0 if the kernel does not report it
+    uint64_t nb_involuntary_switches = 0;
+    ///
+    /// \brief average delay between a wake up and the thread running, the scheduling latency
+    ///
+    double getAverageLatencyUs() const { return nb_timeslices ? wait_ns * 1e-3 / nb_timeslices : 0.; }
+};
+
+///
+/// \brief The ThreadRegistry class
+/// Threads register themselves with place(), which applies the policy, names them and keeps their id to report their
+/// scheduling statistics. report() gives the statistics since the previous report.
+///
+class ThreadRegistry {
+public:
+    ThreadRegistry(const PlacementPolicy& policy, const CpuTopology& topology);
+
+    ///
+    /// \brief from the thread itself: placement, name "<role>_<camera>" and registration
+    /// \return the CPUs the thread was pinned to, empty if none
+    ///
+    std::vector<int> place(const std::string& role, int camera = -1, int device_node = -1);
+
+    std::vector<ThreadSchedStats> report();
+
+private:
+    struct Entry {
+        long tid;
+        ThreadSchedStats last;
+    };
+
+    PlacementPolicy policy;
+    CpuTopology topology;
+    std::mutex mtx;
+    std::vector<Entry> threads;
+};
+
+void printSchedStats(const std::vector<ThreadSchedStats>& stats);
+
+#endif
@@ -0,0 +1,143 @@
+#include "CaptureService.hpp"
+
+#include <algorithm>
+
+CaptureService::CaptureService(const std::vector<FrameGrabber*>& grabbers, uint64_t tolerance, int ring_size)
+    : cameras(grabbers.size()), matcher(static_cast<int>(grabbers.size()), tolerance, std::max(4, ring_size) - 3) {
+    ring_size = std::max(4, ring_size);
+    for (size_t c = 0; c < grabbers.size(); c++) {
+        Camera& cam = cameras[c];
+        cam.grabber = grabbers[c];
+        // All the buffers are allocated once, then recycled
+        for (int s = 0; s < ring_size; s++) {
+            cam.ring.push_back(cv::Mat(cam.grabber->getSize(), cam.grabber->getType()));
+            cam.free_slots.push_back(s);
+        }
+    }
+}
+
+CaptureService::~CaptureService() {
+    stop();
+}
+
+void CaptureService::start() {
+    if (running) return;
+    running = true;
+    for (size_t c = 0; c < cameras.size(); c++) {
+        cameras[c].window_start = std::chrono::steady_clock::now();
+        cameras[c].thread = std::thread(&CaptureService::grabLoop, this, static_cast<int>(c));
+    }
+}
+
+void CaptureService::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        running = false;
+    }
+    set_cv.notify_all();
+    free_cv.notify_all();
+    for (auto& cam : cameras)
+        if (cam.thread.joinable()) cam.thread.join();
+
+    std::lock_guard<std::mutex> lock(mtx);
+    released.clear();
+    matcher.clear(released);
+    release(released);
+}
+
+void CaptureService::release(const std::vector<QueuedFrame>& frames) {
+    for (auto& f : frames)
+        cameras[f.camera].free_slots.push_back(f.slot);
+    if (!frames.empty()) free_cv.notify_all();
+}
+
+void CaptureService::grabLoop(int c) {
+    if (thread_init) thread_init(c);
+    Camera& cam = cameras[c];
+    while (running) {
+        int slot;
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            // The matcher never keeps more than ring_size - 3 frames, a slot is always free soon
+            free_cv.wait(lock, [&] { return !cam.free_slots.empty() || !running; });
+            if (!running) break;
+            slot = cam.free_slots.back();
+            cam.free_slots.pop_back();
+        }
+
+        // The frame is written in the ring without lock, nobody else uses this slot
+        uint64_t timestamp = 0;
+        bool ok = cam.grabber->grab(cam.ring[slot], timestamp);
+
+        std::lock_guard<std::mutex> lock(mtx);
+        if (!ok) {
+            cam.free_slots.push_back(slot);
+            cam.stats.nb_grab_errors++;
+            continue;
+        }
+        cam.stats.nb_grabbed++;
+        cam.frames_in_window++;
+        auto now = std::chrono::steady_clock::now();
+        float elapsed = std::chrono::duration<float>(now - cam.window_start).count();
+        if (elapsed >= 1.f) {
+            cam.stats.fps = cam.frames_in_window / elapsed;
+            cam.frames_in_window = 0;
+            cam.window_start = now;
+        }
+
+        released.clear();
+        matcher.push(c, timestamp, slot, released);
+        release(released);
+        set_cv.notify_one();
+    }
+}
+
+bool CaptureService::getFrameSet(FrameSet& set, int timeout_ms) {
+    std::unique_lock<std::mutex> lock(mtx);
+    // The previous set is not used anymore
+    for (auto& cam : cameras) {
+        if (cam.held_slot >= 0) cam.free_slots.push_back(cam.held_slot);
+        cam.held_slot = -1;
+    }
+    free_cv.notify_all();
+
+    std::vector<QueuedFrame> frames;
+    bool found = set_cv.wait_for(lock, std::chrono::milliseconds(timeout_ms), [&] {
+        if (!running) return true;
+        released.clear();
+        bool matched = matcher.match(frames, released);
+        release(released);
+        return matched;
+    });
+    if (!found || !running || frames.size() != cameras.size()) return false;
+
+    set.images.resize(cameras.size());
+    set.timestamps.resize(cameras.size());
+    uint64_t oldest = UINT64_MAX, newest = 0;
+    for (auto& f : frames) {
+        Camera& cam = cameras[f.camera];
+        cam.held_slot = f.slot;
+        set.images[f.camera] = cam.ring[f.slot];
+        set.timestamps[f.camera] = f.timestamp;
+        oldest = std::min(oldest, f.timestamp);
+        newest = std::max(newest, f.timestamp);
+    }
+    set.skew = newest - oldest;
+    return true;
+}
+
+std::vector<CameraStats> CaptureService::getCameraStats() {
+    std::lock_guard<std::mutex> lock(mtx);
+    std::vector<CameraStats> stats;
+    for (size_t c = 0; c < cameras.size(); c++) {
+        CameraStats s = cameras[c].stats;
+        s.nb_dropped = matcher.getStats().nb_dropped[c];
+        stats.push_back(s);
+    }
+    return stats;
+}
+
+MatcherStats CaptureService::getMatcherStats() {
+    std::lock_guard<std::mutex> lock(mtx);
+    return matcher.getStats();
+}
@@ -0,0 +1,80 @@
+#include "FrameSetMatcher.hpp"
+
+#include <algorithm>
+
+FrameSetMatcher::FrameSetMatcher(int nb_cameras, uint64_t tolerance_, size_t max_queued_, int nb_bins)
+    : queues(nb_cameras), tolerance(tolerance_), max_queued(std::max<size_t>(1, max_queued_)) {
+    stats.nb_dropped.assign(nb_cameras, 0);
+    stats.skew_histogram.assign(std::max(1, nb_bins), 0);
+    stats.bin_width = std::max<uint64_t>(1, (tolerance + stats.skew_histogram.size()) / stats.skew_histogram.size());
+}
+
+void FrameSetMatcher::drop(int camera, std::vector<QueuedFrame>& released) {
+    released.push_back(queues[camera].front());
+    queues[camera].pop_front();
+    stats.nb_dropped[camera]++;
+}
+
+void FrameSetMatcher::push(int camera, uint64_t timestamp, int slot, std::vector<QueuedFrame>& released) {
+    auto& queue = queues[camera];
+    if (queue.size() >= max_queued)
+        drop(camera, released);
+    QueuedFrame frame;
+    frame.camera = camera;
+    frame.timestamp = timestamp;
+    frame.slot = slot;
+    queue.push_back(frame);
+}
+
+bool FrameSetMatcher::match(std::vector<QueuedFrame>& set, std::vector<QueuedFrame>& released) {
+    const int nb_cameras = static_cast<int>(queues.size());
+    while (true) {
+        uint64_t newest = 0;
+        for (auto& queue : queues) {
+            if (queue.empty()) return false;
+            newest = std::max(newest, queue.front().timestamp);
+        }
+
+        // The oldest frames can only be matched with frames at least as new as the newest head:
+        // drop those which are too old for it, or which have a closer successor
+        bool dropped_all = false;
+        for (int c = 0; c < nb_cameras && !dropped_all; c++) {
+            auto& queue = queues[c];
+            while (!queue.empty()) {
+                const QueuedFrame& head = queue.front();
+                bool too_old = head.timestamp + tolerance < newest;
+                bool better_next = queue.size() > 1 && queue[1].timestamp <= newest;
+                if (!too_old && !better_next) break;
+                drop(c, released);
+            }
+            dropped_all = queue.empty();
+        }
+        if (dropped_all) return false;
+
+        // The newest head is never dropped, so the heads are now all within [newest - tolerance, newest]
+        uint64_t oldest = UINT64_MAX;
+        newest = 0;
+        for (auto& queue : queues) {
+            oldest = std::min(oldest, queue.front().timestamp);
+            newest = std::max(newest, queue.front().timestamp);
+        }
+        if (newest - oldest > tolerance) continue;
+
+        set.clear();
+        for (auto& queue : queues) {
+            set.push_back(queue.front());
+            queue.pop_front();
+        }
+        stats.nb_sets++;
+        size_t bin = std::min<size_t>((newest - oldest) / stats.bin_width, stats.skew_histogram.size() - 1);
+        stats.skew_histogram[bin]++;
+        return true;
+    }
+}
+
+void FrameSetMatcher::clear(std::vector<QueuedFrame>& released) {
+    for (auto& queue : queues) {
+        released.insert(released.end(), queue.begin(), queue.end());
+        queue.clear();
+    }
+}
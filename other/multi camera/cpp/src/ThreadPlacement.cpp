@@ -0,0 +1,355 @@
+#include "ThreadPlacement.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+#if defined(__linux__)
+#include <dirent.h>
+#include <limits.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#elif defined(_WIN32)
+#include <Windows.h>
+#endif
+
+static std::string trim(const std::string& s) {
+    size_t begin = s.find_first_not_of(" \t\n");
+    if (begin == std::string::npos) return "";
+    size_t end = s.find_last_not_of(" \t\n");
+    return s.substr(begin, end - begin + 1);
+}
+
+static bool parseInt(const std::string& s, int& value) {
+    if (s.empty()) return false;
+    char* end = nullptr;
+    long v = strtol(s.c_str(), &end, 10);
+    if (*end != '\0' || v < 0 || v > 65535) return false;
+    value = static_cast<int>(v);
+    return true;
+}
+
+bool parseCpuList(const std::string& text, std::vector<int>& cpus) {
+    cpus.clear();
+    std::stringstream ss(trim(text));
+    std::string range;
+    while (std::getline(ss, range, ',')) {
+        range = trim(range);
+        int first, last;
+        size_t dash = range.find('-');
+        if (dash == std::string::npos) {
+            if (!parseInt(range, first)) return false;
+            last = first;
+        } else if (!parseInt(range.substr(0, dash), first) || !parseInt(range.substr(dash + 1), last) || last < first)
+            return false;
+        for (int c = first; c <= last; c++) cpus.push_back(c);
+    }
+    std::sort(cpus.begin(), cpus.end());
+    cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+    return !cpus.empty();
+}
+
+std::string formatCpuList(const std::vector<int>& cpus) {
+    std::string text;
+    for (size_t i = 0; i < cpus.size(); i++) {
+        size_t j = i;
+        while (j + 1 < cpus.size() && cpus[j + 1] == cpus[j] + 1) j++;
+        if (!text.empty()) text += ",";
+        text += std::to_string(cpus[i]);
+        if (j > i) text += "-" + std::to_string(cpus[j]);
+        i = j;
+    }
+    return text;
+}
+
+static bool readFile(const std::string& path, std::string& content) {
+    std::ifstream file(path);
+    if (!file.is_open()) return false;
+    std::stringstream ss;
+    ss << file.rdbuf();
+    content = ss.str();
+    return true;
+}
+
+CpuTopology CpuTopology::detect() {
+    CpuTopology topology;
+#if defined(__linux__)
+    std::string online;
+    std::vector<int> nodes;
+    if (readFile("/sys/devices/system/node/online", online) && parseCpuList(online, nodes)) {
+        for (int n : nodes) {
+            std::string list;
+            std::vector<int> cpus;
+            if (readFile("/sys/devices/system/node/node" + std::to_string(n) + "/cpulist", list) && parseCpuList(list, cpus)) {
+                if (topology.node_cpus.size() <= static_cast<size_t>(n)) topology.node_cpus.resize(n + 1);
+                topology.node_cpus[n] = cpus;
+            }
+        }
+    }
+    if (topology.node_cpus.empty()) {
+        // No NUMA information: a single node with the CPUs available to the process
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        std::vector<int> cpus;
+        if (sched_getaffinity(0, sizeof(set), &set) == 0)
+            for (int c = 0; c < CPU_SETSIZE; c++)
+                if (CPU_ISSET(c, &set)) cpus.push_back(c);
+        topology.node_cpus.push_back(cpus);
+    }
+#else
+    std::vector<int> cpus;
+    for (unsigned c = 0; c < std::max(1u, std::thread::hardware_concurrency()); c++) cpus.push_back(c);
+    topology.node_cpus.push_back(cpus);
+#endif
+    return topology;
+}
+
+std::vector<int> CpuTopology::allCpus() const {
+    std::vector<int> cpus;
+    for (auto& node : node_cpus) cpus.insert(cpus.end(), node.begin(), node.end());
+    std::sort(cpus.begin(), cpus.end());
+    return cpus;
+}
+
+int CpuTopology::nodeOf(int cpu) const {
+    for (size_t n = 0; n < node_cpus.size(); n++)
+        if (std::find(node_cpus[n].begin(), node_cpus[n].end(), cpu) != node_cpus[n].end()) return static_cast<int>(n);
+    return -1;
+}
+
+int numaNodeOfDevice(const std::string& path) {
+#if defined(__linux__)
+    // /dev/videoN is not in sysfs, its class entry links to the device
+    std::string sysfs = path;
+    if (path.compare(0, 5, "/dev/") == 0) {
+        std::string name = path.substr(path.find_last_of('/') + 1);
+        sysfs = "/sys/class/video4linux/" + name + "/device";
+    }
+    char resolved[PATH_MAX];
+    if (!realpath(sysfs.c_str(), resolved)) return -1;
+    // USB devices have no numa_node, the one of the PCI controller above them is used
+    std::string dir(resolved);
+    while (dir.size() > 1) {
+        std::string value;
+        if (readFile(dir + "/numa_node", value)) {
+            int node = atoi(value.c_str());
+            if (node >= 0) return node;
+        }
+        dir = dir.substr(0, dir.find_last_of('/'));
+    }
+#else
+    (void)path;
+#endif
+    return -1;
+}
+
+bool PlacementPolicy::parse(const std::string& text, PlacementPolicy& policy, std::string& error) {
+    policy.rules.clear();
+    std::stringstream ss(text);
+    std::string item;
+    while (std::getline(ss, item, ';')) {
+        item = trim(item);
+        if (item.empty()) continue;
+        size_t eq = item.find('=');
+        if (eq == std::string::npos) {
+            error = "missing '=' in \"" + item + "\"";
+            return false;
+        }
+        PlacementRule rule;
+        std::string who = trim(item.substr(0, eq)), where = trim(item.substr(eq + 1));
+        size_t colon = who.find(':');
+        rule.role = trim(who.substr(0, colon));
+        if (colon != std::string::npos) {
+            std::string camera = trim(who.substr(colon + 1));
+            if (camera != "*" && !parseInt(camera, rule.camera)) {
+                error = "invalid camera in \"" + item + "\"";
+                return false;
+            }
+        }
+        if (rule.role.empty()) {
+            error = "missing role in \"" + item + "\"";
+            return false;
+        }
+
+        if (where == "any")
+            rule.target.kind = PlacementTarget::KIND::ANY;
+        else if (where == "local")
+            rule.target.kind = PlacementTarget::KIND::LOCAL;
+        else if (where.compare(0, 5, "node:") == 0) {
+            rule.target.kind = PlacementTarget::KIND::NODE;
+            if (!parseInt(where.substr(5), rule.target.node)) {
+                error = "invalid NUMA node in \"" + item + "\"";
+                return false;
+            }
+        } else {
+            rule.target.kind = PlacementTarget::KIND::CPUS;
+            if (!parseCpuList(where, rule.target.cpus)) {
+                error = "invalid CPU list in \"" + item + "\"";
+                return false;
+            }
+        }
+        policy.rules.push_back(rule);
+    }
+    return true;
+}
+
+std::vector<int> PlacementPolicy::resolve(const std::string& role, int camera, int device_node, const CpuTopology& topology) const {
+    const PlacementRule* best = nullptr;
+    int best_score = -1;
+    for (auto& rule : rules) {
+        int score;
+        if (rule.role == role && rule.camera >= 0 && rule.camera == camera) score = 3;
+        else if (rule.role == role && rule.camera < 0) score = 2;
+        else if (rule.role == "*" && (rule.camera < 0 || rule.camera == camera)) score = 1;
+        else continue;
+        // On equal scores the last rule wins, so a policy can be extended by appending rules
+        if (score >= best_score) {
+            best = &rule;
+            best_score = score;
+        }
+    }
+    if (!best) return {};
+
+    std::vector<int> available = topology.allCpus();
+    std::vector<int> cpus;
+    switch (best->target.kind) {
+        case PlacementTarget::KIND::ANY: break;
+        case PlacementTarget::KIND::CPUS:
+            // CPUs which do not exist here are ignored, the same policy can be used on several machines
+            for (int c : best->target.cpus)
+                if (std::find(available.begin(), available.end(), c) != available.end()) cpus.push_back(c);
+            break;
+        case PlacementTarget::KIND::NODE:
+            if (best->target.node < topology.getNbNodes()) cpus = topology.node_cpus[best->target.node];
+            break;
+        case PlacementTarget::KIND::LOCAL:
+            if (device_node >= 0 && device_node < topology.getNbNodes()) cpus = topology.node_cpus[device_node];
+            break;
+    }
+    return cpus;
+}
+
+bool setCurrentThreadAffinity(const std::vector<int>& cpus) {
+    if (cpus.empty()) return true;
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int c : cpus)
+        if (c < CPU_SETSIZE) CPU_SET(c, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#elif defined(_WIN32)
+    DWORD_PTR mask = 0;
+    for (int c : cpus)
+        if (c < static_cast<int>(sizeof(DWORD_PTR) * 8)) mask |= DWORD_PTR(1) << c;
+    return mask && SetThreadAffinityMask(GetCurrentThread(), mask) != 0;
+#else
+    return false;
+#endif
+}
+
+void setCurrentThreadName(const std::string& name) {
+#if defined(__linux__)
+    pthread_setname_np(pthread_self(), name.substr(0, 15).c_str());
+#else
+    (void)name;
+#endif
+}
+
+static long currentThreadId() {
+#if defined(__linux__)
+    return static_cast<long>(syscall(SYS_gettid));
+#elif defined(_WIN32)
+    return static_cast<long>(GetCurrentThreadId());
+#else
+    return 0;
+#endif
+}
+
+// Cumulated counters of a thread, zeros where the kernel does not provide them
+static ThreadSchedStats readSchedStats(long tid) {
+    ThreadSchedStats stats;
+#if defined(__linux__)
+    const std::string task = "/proc/self/task/" + std::to_string(tid);
+    std::string content;
+    if (readFile(task + "/schedstat", content)) {
+        unsigned long long run = 0, wait = 0, slices = 0;
+        if (sscanf(content.c_str(), "%llu %llu %llu", &run, &wait, &slices) == 3) {
+            stats.run_ns = run;
+            stats.wait_ns = wait;
+            stats.nb_timeslices = slices;
+        }
+    }
+    if (readFile(task + "/sched", content)) {
+        size_t pos = content.find("se.nr_migrations");
+        if (pos != std::string::npos && (pos = content.find(':', pos)) != std::string::npos)
+            stats.nb_migrations = strtoull(content.c_str() + pos + 1, nullptr, 10);
+    }
+    if (readFile(task + "/status", content)) {
+        size_t pos = content.find("nonvoluntary_ctxt_switches:");
+        if (pos != std::string::npos)
+            stats.nb_involuntary_switches = strtoull(content.c_str() + pos + 27, nullptr, 10);
+    }
+#else
+    (void)tid;
+#endif
+    return stats;
+}
+
+ThreadRegistry::ThreadRegistry(const PlacementPolicy& policy_, const CpuTopology& topology_) : policy(policy_), topology(topology_) {}
+
+std::vector<int> ThreadRegistry::place(const std::string& role, int camera, int device_node) {
+    std::vector<int> cpus = policy.resolve(role, camera, device_node, topology);
+    std::string name = (camera >= 0) ? role + "_" + std::to_string(camera) : role;
+    setCurrentThreadName(name);
+    if (!setCurrentThreadAffinity(cpus)) {
+        std::cout << "[Sample][Warning] " << name << " could not be pinned to CPUs " << formatCpuList(cpus) << std::endl;
+        cpus.clear();
+    }
+
+    Entry entry;
+    entry.tid = currentThreadId();
+    entry.last = readSchedStats(entry.tid);
+    entry.last.name = name;
+    entry.last.cpus = cpus;
+    std::lock_guard<std::mutex> lock(mtx);
+    threads.push_back(entry);
+    return cpus;
+}
+
+std::vector<ThreadSchedStats> ThreadRegistry::report() {
+    std::lock_guard<std::mutex> lock(mtx);
+    std::vector<ThreadSchedStats> report;
+    for (auto& entry : threads) {
+        ThreadSchedStats now = readSchedStats(entry.tid);
+        ThreadSchedStats delta;
+        delta.name = entry.last.name;
+        delta.cpus = entry.last.cpus;
+        // A thread which exited reads as zeros, keep its last values
+        if (now.nb_timeslices >= entry.last.nb_timeslices) {
+            delta.run_ns = now.run_ns - entry.last.run_ns;
+            delta.wait_ns = now.wait_ns - entry.last.wait_ns;
+            delta.nb_timeslices = now.nb_timeslices - entry.last.nb_timeslices;
+            delta.nb_migrations = now.nb_migrations - std::min(now.nb_migrations, entry.last.nb_migrations);
+            delta.nb_involuntary_switches = now.nb_involuntary_switches - std::min(now.nb_involuntary_switches, entry.last.nb_involuntary_switches);
+            now.name = entry.last.name;
+            now.cpus = entry.last.cpus;
+            entry.last = now;
+        }
+        report.push_back(delta);
+    }
+    return report;
+}
+
+void printSchedStats(const std::vector<ThreadSchedStats>& stats) {
+    printf("%-16s %-10s %10s %12s %10s %10s %10s\n", "thread", "cpus", "run (ms)", "latency (us)", "slices", "migrations", "preempted");
+    for (auto& s : stats)
+        printf("%-16s %-10s %10.1f %12.1f %10llu %10llu %10llu\n", s.name.c_str(), s.cpus.empty() ? "any" : formatCpuList(s.cpus).c_str(),
+                s.run_ns * 1e-6, s.getAverageLatencyUs(), static_cast<unsigned long long>(s.nb_timeslices),
+                static_cast<unsigned long long>(s.nb_migrations), static_cast<unsigned long long>(s.nb_involuntary_switches));
+}
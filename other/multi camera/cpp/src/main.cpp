@@ -22,18 +22,73 @@
 /******************************************************************************************************************
  ** This sample demonstrates how to use two ZEDs with the ZED SDK, each grab are in a separate thread             **
  ** This sample has been tested with 3 ZEDs in HD720@30fps resolution. Linux only.                                **
+ ** With --sync [tolerance_ms], the frames of all the cameras are matched by timestamp and displayed as sets      **
+ ** With --placement "<policy>", the grab and display threads are pinned to CPUs (see ThreadPlacement.hpp)       **
  *******************************************************************************************************************/
 
+#include <memory>
+
 #include <sl/Camera.hpp>
 
 #include <opencv2/opencv.hpp>
+
+#include "CaptureService.hpp"
+#include "DisplayMode.hpp"
+#include "FramePublisher.hpp"
+#include "MatBridge.hpp"
+#include "ThreadPlacement.hpp"
  // Using std and sl namespaces
 using namespace std;
 using namespace sl;
 
-void zed_acquisition(Camera& zed, cv::Mat& image_low_res, bool& run, Timestamp& ts);
+void zed_acquisition(Camera& zed, FramePublisher& publisher, atomic<bool>& run);
+int synchronized_acquisition(vector<Camera>& zeds, double tolerance_ms, ThreadRegistry& registry, const vector<int>& device_nodes, bool print_sched, DisplayMode& display);
+void publishImage(DisplayMode& display, int camera_id, const cv::Mat& image, uint64_t timestamp);
+
+// Grabs Left+Depth side by side, directly into the buffer given by the CaptureService
+class ZedGrabber : public FrameGrabber {
+public:
+    ZedGrabber(Camera& zed_, cv::Size size_) : zed(zed_), size(size_) {}
+
+    bool grab(cv::Mat& image, uint64_t& timestamp) override {
+        if (zed.grab() != ERROR_CODE::SUCCESS) return false;
+        const int w_low_res = size.width / 2;
+        Resolution low_res(w_low_res, size.height);
+        // sl::Mat views on the two halves of the image, the row step is the one of the full image
+        Mat left = toSlMat(image(cv::Rect(0, 0, w_low_res, size.height)));
+        Mat depth = toSlMat(image(cv::Rect(w_low_res, 0, w_low_res, size.height)));
+        zed.retrieveImage(left, VIEW::LEFT, MEM::CPU, low_res);
+        zed.retrieveImage(depth, VIEW::DEPTH, MEM::CPU, low_res);
+        // IMAGE timestamps of all the cameras are on the host clock
+        timestamp = zed.getTimestamp(TIME_REFERENCE::IMAGE).getNanoseconds();
+        return true;
+    }
+    cv::Size getSize() const override { return size; }
+    int getType() const override { return CV_8UC4; }
+
+private:
+    Camera& zed;
+    cv::Size size;
+};
 
 int main(int argc, char** argv) {
+    DisplayMode display;
+    if (!display.parse(argc, argv)) return EXIT_FAILURE;
+    bool sync_mode = false;
+    double tolerance_ms = 5.;
+    PlacementPolicy placement;
+    for (int i = 1; i < argc; i++) {
+        if (string(argv[i]) == "--sync") {
+            sync_mode = true;
+            if (i + 1 < argc && atof(argv[i + 1]) > 0.) tolerance_ms = atof(argv[++i]);
+        } else if (string(argv[i]) == "--placement" && i + 1 < argc) {
+            string error;
+            if (!PlacementPolicy::parse(argv[++i], placement, error)) {
+                cout << "[Sample][Error] Invalid placement policy: " << error << endl;
+                return EXIT_FAILURE;
+            }
+        }
+    }
     
 	InitParameters init_parameters;
     init_parameters.depth_mode = DEPTH_MODE::PERFORMANCE;
@@ -53,6 +108,15 @@ int main(int argc, char** argv) {
     
     cout << nb_detected_zed << " ZED Detected" << endl;
 
+    // Thread placement: the display is the main thread, the grab threads place themselves when they start
+    CpuTopology topology = CpuTopology::detect();
+    ThreadRegistry registry(placement, topology);
+    const bool print_sched = !placement.empty();
+    vector<int> device_nodes(nb_detected_zed); // NUMA node of the USB controller of each camera
+    for (int z = 0; z < nb_detected_zed; z++)
+        device_nodes[z] = numaNodeOfDevice(devList[z].path.c_str());
+    registry.place("display");
+
     vector<Camera> zeds(nb_detected_zed);
     // try to open every detected cameras
     for (int z = 0; z < nb_detected_zed; z++) {
@@ -67,38 +131,53 @@ int main(int argc, char** argv) {
         }
     }
     
-    bool run = true;
+    if (sync_mode)
+        return synchronized_acquisition(zeds, tolerance_ms, registry, device_nodes, print_sched, display);
+
+    atomic<bool> run(true);
     // Create a grab thread for each opened camera
     vector<thread> thread_pool(nb_detected_zed); // compute threads
-    vector<cv::Mat> images_lr(nb_detected_zed); // display images
+    vector<FramePublisher> publishers(nb_detected_zed); // Left+Depth images, from the grab threads to the display
     vector<string> wnd_names(nb_detected_zed); // display windows names
-    vector<Timestamp> images_ts(nb_detected_zed); // images timestamps
 
     for (int z = 0; z < nb_detected_zed; z++)
         if (zeds[z].isOpened()) {
-            // create an image to store Left+Depth image
-            images_lr[z] = cv::Mat(404, 720*2, CV_8UC4);
+            // create the images to store Left+Depth image
+            publishers[z].init(cv::Size(720*2, 404), CV_8UC4);
             // camera acquisition thread
-            thread_pool[z] = std::thread(zed_acquisition, ref(zeds[z]), ref(images_lr[z]), ref(run), ref(images_ts[z]));
+            thread_pool[z] = std::thread([&, z] {
+                registry.place("grab", z, device_nodes[z]);
+                zed_acquisition(zeds[z], publishers[z], run);
+            });
             // create windows for display
             wnd_names[z] = "ZED ID: " + to_string(z);
-            cv::namedWindow(wnd_names[z]);
+            if (!display.headless()) cv::namedWindow(wnd_names[z]);
         }
 
-    vector<Timestamp> last_ts(nb_detected_zed, 0); // use to detect new images
-
+    cv::Mat image_lr;
+    uint64_t image_ts;
+    auto last_print = chrono::steady_clock::now();
     char key = ' ';
     // Loop until 'Esc' is pressed
-    while (key != 27) {
-        // Resize and show images
+    while (key != 27 && display.nextFrame()) {
+        // Show the images published since the last display
         for (int z = 0; z < nb_detected_zed; z++) {
-            if (images_ts[z] > last_ts[z]) { // if the current timestamp is newer it is a new image
-                cv::imshow(wnd_names[z], images_lr[z]);
-                last_ts[z] = images_ts[z];
+            if (zeds[z].isOpened() && publishers[z].acquire(image_lr, image_ts)) {
+                if (display.hasSink()) publishImage(display, z, image_lr, image_ts);
+                if (display.renderFrame()) cv::imshow(wnd_names[z], image_lr);
             }
         }
 
-        key = cv::waitKey(10);
+        auto now = chrono::steady_clock::now();
+        if (print_sched && now - last_print >= chrono::seconds(5)) {
+            last_print = now;
+            printSchedStats(registry.report());
+        }
+
+        if (display.renderFrame())
+            key = cv::waitKey(10);
+        else
+            this_thread::sleep_for(chrono::milliseconds(10));
     }
 
     // stop all running threads
@@ -112,23 +191,97 @@ int main(int argc, char** argv) {
     return EXIT_SUCCESS;
 }
 
-void zed_acquisition(Camera& zed, cv::Mat& image_low_res, bool& run, Timestamp& ts) {
-    Mat zed_image;
-    const int w_low_res = image_low_res.cols / 2;
-    const int h_low_res = image_low_res.rows;
+int synchronized_acquisition(vector<Camera>& zeds, double tolerance_ms, ThreadRegistry& registry, const vector<int>& device_nodes, bool print_sched, DisplayMode& display) {
+    vector<unique_ptr<ZedGrabber>> grabbers;
+    vector<FrameGrabber*> cameras;
+    vector<int> camera_ids;
+    vector<string> wnd_names;
+    for (int z = 0; z < static_cast<int>(zeds.size()); z++)
+        if (zeds[z].isOpened()) {
+            camera_ids.push_back(z);
+            grabbers.emplace_back(new ZedGrabber(zeds[z], cv::Size(720 * 2, 404)));
+            cameras.push_back(grabbers.back().get());
+            wnd_names.push_back("ZED ID: " + to_string(z));
+            if (!display.headless()) cv::namedWindow(wnd_names.back());
+        }
+    if (cameras.empty()) {
+        cout << "No ZED opened, exit program" << endl;
+        return EXIT_FAILURE;
+    }
+
+    cout << "Matching the frames of " << cameras.size() << " cameras within " << tolerance_ms << "ms" << endl;
+    CaptureService service(cameras, static_cast<uint64_t>(tolerance_ms * 1e6));
+    service.setThreadInit([&](int c) { registry.place("grab", camera_ids[c], device_nodes[camera_ids[c]]); });
+    service.start();
+
+    FrameSet set;
+    auto last_print = chrono::steady_clock::now();
+    char key = ' ';
+    // Loop until 'Esc' is pressed
+    while (key != 27 && display.nextFrame()) {
+        // The images of a set stay valid until the next getFrameSet(), no copy is needed to display them
+        if (service.getFrameSet(set, 100))
+            for (size_t c = 0; c < set.images.size(); c++) {
+                if (display.hasSink()) publishImage(display, camera_ids[c], set.images[c], set.timestamps[c]);
+                if (display.renderFrame()) cv::imshow(wnd_names[c], set.images[c]);
+            }
+
+        auto now = chrono::steady_clock::now();
+        if (now - last_print >= chrono::seconds(1)) {
+            last_print = now;
+            auto cam_stats = service.getCameraStats();
+            for (size_t c = 0; c < cam_stats.size(); c++)
+                cout << wnd_names[c] << ": " << cam_stats[c].fps << " FPS, " << cam_stats[c].nb_dropped << " dropped, " << cam_stats[c].nb_grab_errors << " grab errors" << endl;
+            auto matcher_stats = service.getMatcherStats();
+            cout << matcher_stats.nb_sets << " sets, skew histogram (" << matcher_stats.bin_width * 1e-6 << "ms bins):";
+            for (auto bin : matcher_stats.skew_histogram) cout << " " << bin;
+            cout << endl;
+            if (print_sched) printSchedStats(registry.report());
+        }
+
+        if (display.renderFrame()) key = cv::waitKey(1);
+    }
+
+    service.stop();
+    for (auto& zed : zeds)
+        zed.close();
+    return EXIT_SUCCESS;
+}
+
+// Left+Depth image of a camera sent to the sink, the text tells the camera
+void publishImage(DisplayMode& display, int camera_id, const cv::Mat& image, uint64_t timestamp) {
+    FrameResult result;
+    result.timestamp = timestamp;
+    result.text = "camera " + to_string(camera_id);
+    result.image = image.data;
+    result.width = image.cols;
+    result.height = image.rows;
+    result.channels = image.channels();
+    result.step = image.step;
+    display.publish(result);
+}
+
+void zed_acquisition(Camera& zed, FramePublisher& publisher, atomic<bool>& run) {
+    const int w_low_res = publisher.back().cols / 2;
+    const int h_low_res = publisher.back().rows;
     Resolution low_res(w_low_res, h_low_res);
+    // sl::Mat views on the left and right halves of the three buffers of the publisher: the images are retrieved
+    // directly into the back buffer, then published without copy
+    Mat left[3], depth[3];
+    for (int i = 0; i < 3; i++) {
+        cv::Mat& image = publisher.buffer(i);
+        left[i] = toSlMat(image(cv::Rect(0, 0, w_low_res, h_low_res)));
+        depth[i] = toSlMat(image(cv::Rect(w_low_res, 0, w_low_res, h_low_res)));
+    }
     while (run) {
-        // grab current images and compute depth
+        // grab blocks until the next image is available
         if (zed.grab() == ERROR_CODE::SUCCESS) {
-            zed.retrieveImage(zed_image, VIEW::LEFT, MEM::CPU, low_res);
-            // copy Left image to the left part of the side by side image
-            cv::Mat(h_low_res, w_low_res, CV_8UC4, zed_image.getPtr<sl::uchar1>(MEM::CPU)).copyTo(image_low_res(cv::Rect(0, 0, w_low_res, h_low_res)));
-            zed.retrieveImage(zed_image, VIEW::DEPTH, MEM::CPU, low_res);
-            // copy Dpeth image to the right part of the side by side image
-            cv::Mat(h_low_res, w_low_res, CV_8UC4, zed_image.getPtr<sl::uchar1>(MEM::CPU)).copyTo(image_low_res(cv::Rect(w_low_res, 0, w_low_res, h_low_res)));
-            ts = zed.getTimestamp(TIME_REFERENCE::IMAGE);
-        }
-        sleep_ms(2);
+            int back = publisher.backIndex();
+            zed.retrieveImage(left[back], VIEW::LEFT, MEM::CPU, low_res);
+            zed.retrieveImage(depth[back], VIEW::DEPTH, MEM::CPU, low_res);
+            publisher.publish(zed.getTimestamp(TIME_REFERENCE::IMAGE).getNanoseconds());
+        } else
+            sleep_ms(1); // camera not available, do not spin on the error
     }
     zed.close();
 }
@@ -0,0 +1,168 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+/***********************************************************************
+ ** Thread placement on a synthetic multi camera workload, no ZED     **
+ ** needed: per camera, a grab thread woken at the camera rate writes **
+ ** a frame, a display thread reads it, and optional noise threads    **
+ ** load the CPUs. The run without placement is compared to the run   **
+ ** with the policy, on wake up jitter, frame time and scheduling.    **
+ ***********************************************************************/
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "FramePublisher.hpp"
+#include "ThreadPlacement.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+struct CameraResult {
+    std::vector<double> wake_us;        ///< delay between the frame time and the grab thread running
+    std::vector<double> write_us;       ///< time to write a frame
+    uint64_t nb_read = 0;
+};
+
+static void grabThread(ThreadRegistry& registry, int camera, FramePublisher& publisher, std::atomic<bool>& run, CameraResult& result) {
+    registry.place("grab", camera);
+    const auto period = std::chrono::microseconds(33333);
+    auto next = Clock::now() + period;
+    uint64_t frame = 0;
+    while (run) {
+        std::this_thread::sleep_until(next);
+        auto woken = Clock::now();
+        result.wake_us.push_back(std::chrono::duration<double, std::micro>(woken - next).count());
+        // The retrieve of a frame: writing a full image
+        cv::Mat& image = publisher.back();
+        for (int r = 0; r < image.rows; r++)
+            memset(image.data + r * image.step, static_cast<int>(++frame % 251), image.cols * 4);
+        result.write_us.push_back(std::chrono::duration<double, std::micro>(Clock::now() - woken).count());
+        publisher.publish(frame);
+        next += period;
+    }
+}
+
+static void displayThread(ThreadRegistry& registry, int camera, FramePublisher& publisher, std::atomic<bool>& run, CameraResult& result) {
+    registry.place("display", camera);
+    cv::Mat image;
+    uint64_t timestamp;
+    volatile uint64_t sum = 0;
+    while (run) {
+        if (publisher.acquire(image, timestamp)) {
+            // The display of a frame: reading it
+            for (int r = 0; r < image.rows; r += 4)
+                sum += image.data[r * image.step];
+            result.nb_read++;
+        } else
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+}
+
+static void noiseThread(ThreadRegistry& registry, int index, std::atomic<bool>& run) {
+    registry.place("noise", index);
+    std::vector<uint8_t> buffer(8 << 20);
+    size_t pos = 0;
+    while (run) {
+        // Streams through a buffer larger than the caches
+        buffer[pos] ^= 1;
+        pos = (pos + 64) % buffer.size();
+    }
+}
+
+static double percentile(std::vector<double> values, double p) {
+    if (values.empty()) return 0.;
+    std::sort(values.begin(), values.end());
+    return values[std::min(values.size() - 1, static_cast<size_t>(p * values.size()))];
+}
+
+static void runWorkload(const PlacementPolicy& policy, const CpuTopology& topology, int nb_cameras, int nb_noise, int duration_s) {
+    ThreadRegistry registry(policy, topology);
+    std::atomic<bool> run(true);
+    std::vector<FramePublisher> publishers(nb_cameras);
+    std::vector<CameraResult> results(nb_cameras);
+    std::vector<std::thread> threads;
+    for (int c = 0; c < nb_cameras; c++) {
+        publishers[c].init(cv::Size(1280, 720), CV_8UC4);
+        threads.emplace_back(grabThread, std::ref(registry), c, std::ref(publishers[c]), std::ref(run), std::ref(results[c]));
+        threads.emplace_back(displayThread, std::ref(registry), c, std::ref(publishers[c]), std::ref(run), std::ref(results[c]));
+    }
+    for (int n = 0; n < nb_noise; n++)
+        threads.emplace_back(noiseThread, std::ref(registry), n, std::ref(run));
+
+    // Statistics since all the threads are started
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    registry.report();
+    std::this_thread::sleep_for(std::chrono::seconds(duration_s));
+    auto sched = registry.report();
+    run = false;
+    for (auto& t : threads) t.join();
+
+    printf("%-10s %12s %12s %12s %14s %10s\n", "camera", "wake p50", "wake p99", "wake max", "write avg (us)", "displayed");
+    for (int c = 0; c < nb_cameras; c++) {
+        auto& r = results[c];
+        double write_avg = 0.;
+        for (double w : r.write_us) write_avg += w / r.write_us.size();
+        printf("%-10d %12.1f %12.1f %12.1f %14.1f %10llu\n", c, percentile(r.wake_us, 0.5), percentile(r.wake_us, 0.99),
+                percentile(r.wake_us, 1.), write_avg, static_cast<unsigned long long>(r.nb_read));
+    }
+    printSchedStats(sched);
+}
+
+int main(int argc, char **argv) {
+    int nb_cameras = (argc > 2) ? atoi(argv[2]) : 4;
+    int duration_s = (argc > 3) ? atoi(argv[3]) : 5;
+    int nb_noise = (argc > 4) ? atoi(argv[4]) : 0;
+
+    CpuTopology topology = CpuTopology::detect();
+    std::vector<int> cpus = topology.allCpus();
+    std::cout << "Topology: " << topology.getNbNodes() << " NUMA node(s)" << std::endl;
+    for (int n = 0; n < topology.getNbNodes(); n++)
+        std::cout << "  node " << n << ": CPUs " << formatCpuList(topology.node_cpus[n]) << std::endl;
+
+    std::string text;
+    if (argc > 1 && argv[1][0]) text = argv[1];
+    else {
+        // Default: each grab thread and its display thread on neighbour CPUs of node 0, the noise elsewhere
+        const std::vector<int>& node = topology.node_cpus[0];
+        for (int c = 0; c < nb_cameras; c++)
+            text += "grab:" + std::to_string(c) + "=" + std::to_string(node[(2 * c) % node.size()]) + ";display:" + std::to_string(c) + "=" + std::to_string(node[(2 * c + 1) % node.size()]) + ";";
+        if (cpus.size() > static_cast<size_t>(2 * nb_cameras))
+            text += "noise=" + formatCpuList(std::vector<int>(cpus.begin() + 2 * nb_cameras, cpus.end()));
+    }
+    PlacementPolicy policy;
+    std::string error;
+    if (!PlacementPolicy::parse(text, policy, error)) {
+        std::cout << "[Sample][Error] Invalid placement policy: " << error << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::cout << std::endl << nb_cameras << " cameras at 30FPS, " << nb_noise << " noise threads, " << duration_s << "s per run" << std::endl;
+    std::cout << std::endl << "Without placement" << std::endl;
+    runWorkload(PlacementPolicy(), topology, nb_cameras, nb_noise, duration_s);
+    std::cout << std::endl << "With placement \"" << text << "\"" << std::endl;
+    runWorkload(policy, topology, nb_cameras, nb_noise, duration_s);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,111 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+/***********************************************************************
+ ** Stress test of the FramePublisher, no ZED needed:                 **
+ ** fake cameras publish frames as fast as possible while the reader  **
+ ** checks that every acquired frame is complete and never modified   **
+ ** while it is held. Build with -fsanitize=thread to check the races **
+ ***********************************************************************/
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "FramePublisher.hpp"
+
+// Every byte of frame n is n % 251, its timestamp is n
+static void fakeCamera(FramePublisher& publisher, std::atomic<bool>& run, uint64_t& nb_published) {
+    std::mt19937 rng(std::random_device{}());
+    uint64_t frame = 0;
+    while (run) {
+        frame++;
+        cv::Mat& image = publisher.back();
+        const size_t row_bytes = image.cols * 4;
+        for (int r = 0; r < image.rows; r++)
+            memset(image.data + r * image.step, static_cast<int>(frame % 251), row_bytes);
+        publisher.publish(frame);
+        // Irregular rate, from back to back frames to a few hundred microseconds
+        if (rng() % 4 == 0) std::this_thread::sleep_for(std::chrono::microseconds(rng() % 300));
+    }
+    nb_published = frame;
+}
+
+static bool checkFrame(const cv::Mat& image, uint64_t timestamp) {
+    const uchar expected = static_cast<uchar>(timestamp % 251);
+    const size_t row_bytes = image.cols * 4;
+    for (int r = 0; r < image.rows; r++) {
+        const uchar* row = image.data + r * image.step;
+        for (size_t b = 0; b < row_bytes; b++)
+            if (row[b] != expected) return false;
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    int nb_cameras = (argc > 1) ? atoi(argv[1]) : 4;
+    int duration_s = (argc > 2) ? atoi(argv[2]) : 5;
+    std::cout << nb_cameras << " fake cameras, " << duration_s << "s" << std::endl;
+
+    std::atomic<bool> run(true);
+    std::vector<FramePublisher> publishers(nb_cameras);
+    std::vector<uint64_t> nb_published(nb_cameras, 0), nb_read(nb_cameras, 0), nb_torn(nb_cameras, 0), nb_unordered(nb_cameras, 0), last_ts(nb_cameras, 0);
+    std::vector<std::thread> cameras;
+    for (int c = 0; c < nb_cameras; c++) {
+        publishers[c].init(cv::Size(320, 180), CV_8UC4);
+        cameras.emplace_back(fakeCamera, std::ref(publishers[c]), std::ref(run), std::ref(nb_published[c]));
+    }
+
+    std::mt19937 rng(1);
+    cv::Mat image;
+    uint64_t timestamp;
+    auto start = std::chrono::steady_clock::now();
+    while (std::chrono::steady_clock::now() - start < std::chrono::seconds(duration_s)) {
+        for (int c = 0; c < nb_cameras; c++) {
+            if (!publishers[c].acquire(image, timestamp)) continue;
+            nb_read[c]++;
+            if (timestamp <= last_ts[c]) nb_unordered[c]++;
+            last_ts[c] = timestamp;
+            if (!checkFrame(image, timestamp)) nb_torn[c]++;
+            // Hold the frame like a display would, it must not change meanwhile
+            if (rng() % 8 == 0) {
+                std::this_thread::sleep_for(std::chrono::microseconds(rng() % 500));
+                if (!checkFrame(image, timestamp)) nb_torn[c]++;
+            }
+        }
+    }
+    run = false;
+    for (auto& t : cameras) t.join();
+
+    bool ok = true;
+    for (int c = 0; c < nb_cameras; c++) {
+        printf("camera %d: %llu published, %llu read, %llu torn, %llu out of order\n", c,
+                static_cast<unsigned long long>(nb_published[c]), static_cast<unsigned long long>(nb_read[c]),
+                static_cast<unsigned long long>(nb_torn[c]), static_cast<unsigned long long>(nb_unordered[c]));
+        ok &= nb_read[c] > 0 && nb_torn[c] == 0 && nb_unordered[c] == 0;
+    }
+    std::cout << (ok ? "OK" : "[Error] failed") << std::endl;
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
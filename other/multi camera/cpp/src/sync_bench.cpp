@@ -0,0 +1,158 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+/***********************************************************************
+ ** Frame set matching on synthetic cameras, no ZED needed:           **
+ **  - the matcher alone, on timestamp streams with phase offsets,    **
+ **    jitter, clock drift and lost frames                            **
+ **  - the capture service, with one thread per synthetic camera      **
+ ***********************************************************************/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <thread>
+
+#include "CaptureService.hpp"
+#include "FrameSetMatcher.hpp"
+
+// Timestamps of a camera running at fps * (1 + drift), shifted by phase, with a uniform jitter and lost frames
+struct SyntheticStream {
+    double fps, drift, phase_ms, jitter_ms, loss;
+    uint64_t timestamp(int frame, std::mt19937& rng) const {
+        std::uniform_real_distribution<double> jitter(-jitter_ms, jitter_ms);
+        double t_ms = phase_ms + frame * 1000. / (fps * (1. + drift)) + jitter(rng);
+        return static_cast<uint64_t>(std::max(0., t_ms + 1000.) * 1e6);
+    }
+};
+
+static void printStats(const MatcherStats& stats) {
+    printf("  %llu sets, dropped per camera:", static_cast<unsigned long long>(stats.nb_sets));
+    for (auto d : stats.nb_dropped) printf(" %llu", static_cast<unsigned long long>(d));
+    printf("\n  skew histogram (%.1f ms bins):", stats.bin_width * 1e-6);
+    for (auto b : stats.skew_histogram) printf(" %llu", static_cast<unsigned long long>(b));
+    printf("\n");
+}
+
+static bool matcherTest(const std::vector<SyntheticStream>& streams, double tolerance_ms, int nb_frames) {
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<double> uniform(0., 1.);
+    const int nb_cameras = static_cast<int>(streams.size());
+
+    // All the frames of all the cameras, in arrival order
+    std::vector<QueuedFrame> arrivals;
+    for (int c = 0; c < nb_cameras; c++)
+        for (int f = 0; f < nb_frames; f++)
+            if (uniform(rng) >= streams[c].loss)
+                arrivals.push_back(QueuedFrame{c, streams[c].timestamp(f, rng), f});
+    std::stable_sort(arrivals.begin(), arrivals.end(), [](const QueuedFrame& a, const QueuedFrame& b) { return a.timestamp < b.timestamp; });
+
+    FrameSetMatcher matcher(nb_cameras, static_cast<uint64_t>(tolerance_ms * 1e6), 3);
+    std::vector<QueuedFrame> set, released;
+    std::vector<uint64_t> last_ts(nb_cameras, 0);
+    bool ok = true;
+    uint64_t nb_frames_out = 0;
+    for (auto& a : arrivals) {
+        matcher.push(a.camera, a.timestamp, a.slot, released);
+        while (matcher.match(set, released)) {
+            uint64_t oldest = UINT64_MAX, newest = 0;
+            for (int c = 0; c < nb_cameras; c++) {
+                // One frame per camera, in order, never twice
+                ok &= (set[c].camera == c) && (set[c].timestamp > last_ts[c]);
+                last_ts[c] = set[c].timestamp;
+                oldest = std::min(oldest, set[c].timestamp);
+                newest = std::max(newest, set[c].timestamp);
+            }
+            ok &= (newest - oldest) <= matcher.getTolerance();
+            nb_frames_out += nb_cameras;
+        }
+    }
+    matcher.clear(released);
+    // Every frame is either in a set or released, exactly once
+    ok &= (nb_frames_out + released.size() == arrivals.size());
+    printStats(matcher.getStats());
+    return ok;
+}
+
+// Camera at a fixed rate, with the shared steady clock as timestamps
+class SyntheticGrabber : public FrameGrabber {
+public:
+    SyntheticGrabber(double fps, double phase_ms)
+        : period(static_cast<int64_t>(1e9 / fps)), next(std::chrono::steady_clock::now() + std::chrono::microseconds(static_cast<int64_t>(phase_ms * 1000))) {}
+    bool grab(cv::Mat& image, uint64_t& timestamp) override {
+        std::this_thread::sleep_until(next);
+        timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(next.time_since_epoch()).count();
+        image.setTo(cv::Scalar::all(static_cast<double>(timestamp % 251)));
+        next += period;
+        return true;
+    }
+    cv::Size getSize() const override { return cv::Size(640, 360); }
+    int getType() const override { return CV_8UC4; }
+
+private:
+    std::chrono::nanoseconds period;
+    std::chrono::steady_clock::time_point next;
+};
+
+int main(int argc, char **argv) {
+    double tolerance_ms = (argc > 1) ? atof(argv[1]) : 5.;
+    bool ok = true;
+
+    std::vector<SyntheticStream> streams = {
+        {30., 0., 0., 0.5, 0.},
+        {30., 0., 1., 0.5, 0.01},
+        {30., 1e-6, -1., 0.5, 0.01},
+        {30., -1e-6, 1.5, 1., 0.02},
+    };
+    std::cout << "Matcher, 4 synthetic cameras at 30FPS (phase, jitter, drift, 1-2% lost frames), tolerance " << tolerance_ms << "ms" << std::endl;
+    bool matcher_ok = matcherTest(streams, tolerance_ms, 30 * 600);
+    std::cout << (matcher_ok ? "  OK" : "  [Error] invalid frame sets") << std::endl;
+    ok &= matcher_ok;
+
+    std::cout << "Capture service, 4 synthetic camera threads at 30FPS for 3s, phases within the tolerance" << std::endl;
+    const double phase_ms = tolerance_ms / 4.;
+    SyntheticGrabber g0(30., 0.), g1(30., phase_ms), g2(30., 2 * phase_ms), g3(30., 3 * phase_ms);
+    CaptureService service({&g0, &g1, &g2, &g3}, static_cast<uint64_t>(tolerance_ms * 1e6));
+    service.start();
+    FrameSet set;
+    int nb_sets = 0;
+    uint64_t max_skew = 0;
+    auto start = std::chrono::steady_clock::now();
+    while (std::chrono::steady_clock::now() - start < std::chrono::seconds(3)) {
+        if (service.getFrameSet(set, 100)) {
+            nb_sets++;
+            max_skew = std::max(max_skew, set.skew);
+            // The images are those of the matched timestamps
+            for (size_t c = 0; c < set.images.size(); c++)
+                ok &= set.images[c].at<cv::Vec4b>(0, 0)[0] == set.timestamps[c] % 251;
+        }
+    }
+    service.stop();
+    auto cam_stats = service.getCameraStats();
+    for (size_t c = 0; c < cam_stats.size(); c++)
+        printf("  camera %zu: %.1f FPS, %llu grabbed, %llu dropped\n", c, cam_stats[c].fps,
+                static_cast<unsigned long long>(cam_stats[c].nb_grabbed), static_cast<unsigned long long>(cam_stats[c].nb_dropped));
+    printf("  %d sets, max skew %.2f ms\n", nb_sets, max_skew * 1e-6);
+    ok &= max_skew <= static_cast<uint64_t>(tolerance_ms * 1e6) && nb_sets > 0;
+    std::cout << (ok ? "OK" : "[Error] failed") << std::endl;
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
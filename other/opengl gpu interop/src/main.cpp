@@ -23,7 +23,10 @@
 /***********************************************************************************************
  ** This sample demonstrates how to grab images and depth map with the ZED SDK                **
  ** The GPU buffer is ingested directly into OpenGL texture to avoid GPU->CPU readback time   **
- ** For the Left image, a GLSL shader is used for RGBA-->BGRA transformation, as an example   **
+ ** The copies are queued on the CUDA stream of the ZED SDK (GLPresenter), the draw of a      **
+ ** frame does not wait for the copy of the next one                                          **
+ ** The Left image is BGRA: its textures are swizzled to be sampled in RGBA order, a GLSL      **
+ ** shader swaps the channels only on contexts without texture swizzle                        **
  ***********************************************************************************************/
 
 #include <stdio.h>
@@ -40,21 +43,27 @@
 #include <cuda_runtime.h>
 #include <cuda_gl_interop.h>
 
+#include "DisplayMode.hpp"
+#include "GLPresenter.hpp"
+
 using namespace sl;
 using namespace std;
 
-// Resource declarations (texture, GLSL fragment shader, GLSL program...)
-GLuint imageTex;
-GLuint depthTex;
-GLuint shaderF;
-GLuint program;
-// Cuda resources for CUDA-OpenGL interoperability
-cudaGraphicsResource* pcuImageRes;
-cudaGraphicsResource* pcuDepthRes;
+// Resource declarations (GLSL fragment shader, GLSL program...), only without texture swizzle
+GLuint shaderF = 0;
+GLuint program = 0;
+// Textures of the left and depth images, filled through CUDA-OpenGL interoperability
+GLPresenter imagePresenter;
+GLPresenter depthPresenter;
 
 Camera zed;
 Mat gpuLeftImage;
 Mat gpuDepthImage;
+// Left image in CPU memory, for the sink only
+Mat cpuLeftImage;
+
+// --headless, --preview N, --sink
+DisplayMode display;
 
 // Simple fragment shader that switch red and blue channels (RGBA -->BGRA)
 string strFragmentShad = ("uniform sampler2D texImage;\n"
@@ -62,35 +71,52 @@ string strFragmentShad = ("uniform sampler2D texImage;\n"
         " vec4 color = texture2D(texImage, gl_TexCoord[0].st);\n"
         " gl_FragColor = vec4(color.b, color.g, color.r, color.a);\n}");
 
+// Compiles the shader above, for contexts without texture swizzle
+bool createSwapProgram();
+// Grab loop without display
+int runHeadless(int argc, char **argv);
+
+// Sends the left image of the current frame to the sink, read back in CPU memory
+void publishFrame() {
+    if (zed.retrieveImage(cpuLeftImage, VIEW::LEFT, MEM::CPU) != ERROR_CODE::SUCCESS) return;
+    FrameResult result;
+    result.timestamp = zed.getTimestamp(TIME_REFERENCE::IMAGE).getNanoseconds();
+    result.text = "LEFT BGRA";
+    result.image = cpuLeftImage.getPtr<sl::uchar1>(MEM::CPU);
+    result.width = cpuLeftImage.getWidth();
+    result.height = cpuLeftImage.getHeight();
+    result.channels = 4;
+    result.step = cpuLeftImage.getStepBytes(MEM::CPU);
+    display.publish(result);
+}
+
 // Main loop for acquisition and rendering : 
 // * grab from the ZED SDK
-// * Map cuda and opengl resources and copy the GPU buffer into a CUDA array
-// * Use the OpenGL texture to render on the screen
+// * Queue the copy of the GPU buffers into the textures of the presenters
+// * Use the OpenGL textures of the latest copied frame to render on the screen
 
 void draw() {
+    display.nextFrame();
     if (zed.grab() == ERROR_CODE::SUCCESS) {
-        // Map GPU Resource for left image
-        // With OpenGL textures, we need to use the cudaGraphicsSubResourceGetMappedArray CUDA functions. It will link/sync the OpenGL texture with a CUDA cuArray
-        // Then, we just have to copy our GPU Buffer to the CudaArray (DeviceToDevice copy) and the texture will contain the GPU buffer content.
+        if (display.hasSink()) publishFrame();
+        // Preview: the frames between two renderings are not copied to OpenGL
+        if (!display.renderFrame()) {
+            glutPostRedisplay();
+            return;
+        }
+
+        // Copy the GPU buffer of the left image into an OpenGL texture
+        // The presenter maps the texture registered to CUDA as a cuArray and copies the GPU buffer in it (DeviceToDevice copy), the texture then contains the GPU buffer content.
         // That's the most efficient way since we don't have to go back on the CPU to render the texture. Make sure that retrieveXXX() functions of the ZED SDK
         // are used with sl::MEM::GPU parameters.
-        if (zed.retrieveImage(gpuLeftImage, VIEW::LEFT, MEM::GPU) == ERROR_CODE::SUCCESS) {
-            cudaArray_t ArrIm;
-            cudaGraphicsMapResources(1, &pcuImageRes, 0);
-            cudaGraphicsSubResourceGetMappedArray(&ArrIm, pcuImageRes, 0, 0);
-            cudaMemcpy2DToArray(ArrIm, 0, 0, gpuLeftImage.getPtr<sl::uchar1>(MEM::GPU), gpuLeftImage.getStepBytes(MEM::GPU), gpuLeftImage.getWidth() * sizeof (sl::uchar4), gpuLeftImage.getHeight(), cudaMemcpyDeviceToDevice);
-            cudaGraphicsUnmapResources(1, &pcuImageRes, 0);
-        }
+        // The copy is queued on the CUDA stream of the ZED SDK: the next retrieve waits for it, the CPU does not.
+        if (zed.retrieveImage(gpuLeftImage, VIEW::LEFT, MEM::GPU) == ERROR_CODE::SUCCESS)
+            imagePresenter.uploadDevice(gpuLeftImage.getPtr<sl::uchar1>(MEM::GPU), gpuLeftImage.getStepBytes(MEM::GPU), zed.getCUDAStream());
 
-        // Map GPU Resource for depth image.
+        // Same for the depth image.
         // Note that we use the depth image here in a 8UC4 (RGBA) format.
-        if (zed.retrieveImage(gpuDepthImage, VIEW::DEPTH, MEM::GPU) == ERROR_CODE::SUCCESS) {
-            cudaArray_t ArrDe;
-            cudaGraphicsMapResources(1, &pcuDepthRes, 0);
-            cudaGraphicsSubResourceGetMappedArray(&ArrDe, pcuDepthRes, 0, 0);
-            cudaMemcpy2DToArray(ArrDe, 0, 0, gpuDepthImage.getPtr<sl::uchar1>(MEM::GPU), gpuDepthImage.getStepBytes(MEM::GPU), gpuLeftImage.getWidth() * sizeof (sl::uchar4), gpuLeftImage.getHeight(), cudaMemcpyDeviceToDevice);
-            cudaGraphicsUnmapResources(1, &pcuDepthRes, 0);
-        }
+        if (zed.retrieveImage(gpuDepthImage, VIEW::DEPTH, MEM::GPU) == ERROR_CODE::SUCCESS)
+            depthPresenter.uploadDevice(gpuDepthImage.getPtr<sl::uchar1>(MEM::GPU), gpuDepthImage.getStepBytes(MEM::GPU), zed.getCUDAStream());
 
         ////  OpenGL rendering part ////
         glDrawBuffer(GL_BACK); // Write to both BACK_LEFT & BACK_RIGHT
@@ -98,11 +124,11 @@ void draw() {
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
         glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
 
-        // Left Image on left side of the screen
-        glBindTexture(GL_TEXTURE_2D, imageTex);
+        // Left Image on left side of the screen, latest frame copied
+        glBindTexture(GL_TEXTURE_2D, imagePresenter.texture());
 
-        // Use GLSL program to switch red and blue channels
-        glUseProgram(program);
+        // Without texture swizzle, use GLSL program to switch red and blue channels
+        if (program) glUseProgram(program);
 
         // Render the final texture
         glBegin(GL_QUADS);
@@ -116,10 +142,10 @@ void draw() {
         glVertex2f(-1.0, 1.0);
         glEnd();
 
-        glUseProgram(0);
+        if (program) glUseProgram(0);
 
         // Depth image on right side of the screen
-        glBindTexture(GL_TEXTURE_2D, depthTex);
+        glBindTexture(GL_TEXTURE_2D, depthPresenter.texture());
 
         glBegin(GL_QUADS);
         glTexCoord2f(0.0, 1.0);
@@ -140,11 +166,16 @@ void draw() {
 }
 
 void close() {
+    imagePresenter.release();
+    depthPresenter.release();
     gpuLeftImage.free();
     gpuDepthImage.free();
+    cpuLeftImage.free();
     zed.close();
-    glDeleteShader(shaderF);
-    glDeleteProgram(program);
+    if (program) {
+        glDeleteShader(shaderF);
+        glDeleteProgram(program);
+    }
     glBindTexture(GL_TEXTURE_2D, 0);
 }
 
@@ -155,10 +186,13 @@ void keyPressedCallback(unsigned char c, int x, int y) {
 
 int main(int argc, char **argv) {
 
+    if (!display.parse(argc, argv)) return EXIT_FAILURE;
     if (argc > 2) {
-        cout << "Only the path of a SVO can be passed in arg" << endl;
+        cout << "Only the path of a SVO can be passed in arg, with " << DisplayMode::usage() << endl;
         return EXIT_FAILURE;
     }
+    if (display.headless())
+        return runHeadless(argc, argv);
     // init glut
     glutInit(&argc, argv);
     glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGBA | GLUT_DEPTH);
@@ -200,38 +234,65 @@ int main(int argc, char **argv) {
     // Get Image Size
     auto res_ = zed.getCameraInformation().camera_configuration.resolution;
 
-    cudaError_t err1, err2;
-
-    // Create an OpenGL texture and register the CUDA resource on this texture for left image (8UC4 -- RGBA)
+    // Create the OpenGL textures of the left (BGRA) and depth (8UC4, same value in the 3 channels) images, registered to CUDA
     glEnable(GL_TEXTURE_2D);
-    glGenTextures(1, &imageTex);
-    glBindTexture(GL_TEXTURE_2D, imageTex);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, res_.width, res_.height, 0, GL_BGRA_EXT, GL_UNSIGNED_BYTE, NULL);
-    glBindTexture(GL_TEXTURE_2D, 0);
-    err1 = cudaGraphicsGLRegisterImage(&pcuImageRes, imageTex, GL_TEXTURE_2D, cudaGraphicsRegisterFlagsWriteDiscard);
-
-    // Create an OpenGL texture and register the CUDA resource on this texture for depth image (8UC4 -- RGBA)
-    glGenTextures(1, &depthTex);
-    glGenTextures(1, &depthTex);
-    glBindTexture(GL_TEXTURE_2D, depthTex);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, res_.width, res_.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
-    glBindTexture(GL_TEXTURE_2D, 0);
-    err2 = cudaGraphicsGLRegisterImage(&pcuDepthRes, depthTex, GL_TEXTURE_2D, cudaGraphicsRegisterFlagsWriteDiscard);
+    if (!imagePresenter.init(res_.width, res_.height, true, PixelFormat::BGRA) || !depthPresenter.init(res_.width, res_.height, true)) {
+        cout << "[Sample][Error] Cannot register the OpenGL textures to CUDA" << endl;
+        zed.close();
+        return EXIT_FAILURE;
+    }
 
-    // If any error are triggered, exit the program
-    if (err1 != 0 || err2 != 0) return -1;
+    cout << "** Left image: " << imagePresenter.format().name() << " **" << endl;
+    if (imagePresenter.format().channels == ChannelPath::SHADER && !createSwapProgram()) {
+        zed.close();
+        return -2;
+    }
 
+    // Start the draw loop and closing event function
+    glutDisplayFunc(draw);
+    glutCloseFunc(close);
+    glutKeyboardFunc(keyPressedCallback);
+    glutMainLoop();
+
+    return EXIT_SUCCESS;
+}
+
+int runHeadless(int argc, char **argv) {
+    InitParameters init_parameters;
+    if (argc == 1) { // Use in Live Mode
+        init_parameters.camera_resolution = RESOLUTION::HD720;
+        init_parameters.camera_fps = 30;
+    } else // Use in SVO playback mode
+        init_parameters.input.setFromSVOFile(String(argv[1]));
+    init_parameters.depth_mode = DEPTH_MODE::PERFORMANCE;
+    ERROR_CODE err = zed.open(init_parameters);
+    if (err != ERROR_CODE::SUCCESS) {
+        cout << "ZED Opening Error: " << err << endl;
+        zed.close();
+        return EXIT_FAILURE;
+    }
+
+    // No window nor texture: the frames only go to the sink, until Ctrl+C or the end of the SVO
+    while (display.nextFrame()) {
+        err = zed.grab();
+        if (err == ERROR_CODE::SUCCESS) {
+            if (display.hasSink()) publishFrame();
+        } else if (err == ERROR_CODE::END_OF_SVOFILE_REACHED)
+            break;
+    }
+    cpuLeftImage.free();
+    zed.close();
+    return EXIT_SUCCESS;
+}
+
+bool createSwapProgram() {
     // Create the GLSL program that will run the fragment shader (defined at the top)
     // * Create the fragment shader from the string source
     // * Compile the shader and check for errors
     // * Create the GLSL program and attach the shader to it
     // * Link the program and check for errors
     // * Specify the uniform variable of the shader
-    GLuint shaderF = glCreateShader(GL_FRAGMENT_SHADER); //fragment shader
+    shaderF = glCreateShader(GL_FRAGMENT_SHADER); //fragment shader
     const char* pszConstString = strFragmentShad.c_str();
     glShaderSource(shaderF, 1, (const char**) &pszConstString, NULL);
 
@@ -239,7 +300,7 @@ int main(int argc, char **argv) {
     glCompileShader(shaderF);
     GLint compile_status = GL_FALSE;
     glGetShaderiv(shaderF, GL_COMPILE_STATUS, &compile_status);
-    if (compile_status != GL_TRUE) return -2;
+    if (compile_status != GL_TRUE) return false;
 
     // Create the progam for both V and F Shader
     program = glCreateProgram();
@@ -249,16 +310,11 @@ int main(int argc, char **argv) {
     glLinkProgram(program);
     GLint link_status = GL_FALSE;
     glGetProgramiv(program, GL_LINK_STATUS, &link_status);
-    if (link_status != GL_TRUE) return -2;
+    if (link_status != GL_TRUE) return false;
 
     // Set the uniform variable for texImage (sampler2D) to the texture unit (GL_TEXTURE0 by default --> id = 0)
+    glUseProgram(program);
     glUniform1i(glGetUniformLocation(program, "texImage"), 0);
-
-    // Start the draw loop and closing event function
-    glutDisplayFunc(draw);
-    glutCloseFunc(close);
-    glutKeyboardFunc(keyPressedCallback);
-    glutMainLoop();
-
-    return EXIT_SUCCESS;
+    glUseProgram(0);
+    return true;
 }
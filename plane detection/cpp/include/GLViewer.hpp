@@ -6,6 +6,8 @@
 #include <GL/glew.h>
 #include <GL/freeglut.h>
 
+#include "GLPresenter.hpp"
+
 #include <mutex>
 
 #ifndef M_PI
@@ -89,8 +91,7 @@ class ImageHandler {
 
     private:
     GLuint texID;
-    GLuint imageTex;
-    cudaGraphicsResource* cuda_gl_ressource;//cuda GL resource
+    GLPresenter presenter;
     ShaderData shader;
     GLuint quad_vb;
 };
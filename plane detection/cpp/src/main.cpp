@@ -29,21 +29,26 @@
 #include <sl/Camera.hpp>
 
 // Sample includes
+#include "DisplayMode.hpp"
+#include "ZedFrameSource.hpp"
 #include "GLViewer.hpp"
 
 // Using std and sl namespaces
 using namespace std;
 using namespace sl;
  
-void parseArgs(int argc, char **argv,sl::InitParameters& param);
-
 int main(int argc, char** argv) {
     Camera zed;
     // Setup configuration parameters for the ZED    
     InitParameters init_parameters;
     init_parameters.coordinate_units = UNIT::METER;
     init_parameters.coordinate_system = COORDINATE_SYSTEM::RIGHT_HANDED_Y_UP; // OpenGL coordinates system
-    parseArgs(argc,argv, init_parameters);
+    // --headless, --preview N, --sink
+    DisplayMode display;
+    if (!display.parse(argc, argv)) return EXIT_FAILURE;
+    // Input of the sample: SVO file, IP[:port] of a stream, camera resolution or --source (FrameSource.hpp)
+    FrameSourceOptions source;
+    if (!source.parse(argc, argv) || !applyFrameSource(source, init_parameters)) return EXIT_FAILURE;
 
     // Open the camera
     ERROR_CODE zed_open_state = zed.open(init_parameters);
@@ -56,7 +61,8 @@ int main(int argc, char** argv) {
     auto has_imu = camera_infos.sensors_configuration.isSensorAvailable(SENSOR_TYPE::GYROSCOPE);
 
     GLViewer viewer;
-    bool error_viewer = viewer.init(argc, argv, camera_infos.camera_configuration.calibration_parameters.left_cam, has_imu);
+    // No GL context when headless
+    bool error_viewer = !display.headless() && viewer.init(argc, argv, camera_infos.camera_configuration.calibration_parameters.left_cam, has_imu);
     if(error_viewer) {
         viewer.exit();
         zed.close();
@@ -83,16 +89,20 @@ int main(int argc, char** argv) {
     RuntimeParameters runtime_parameters;
     runtime_parameters.measure3D_reference_frame = REFERENCE_FRAME::WORLD;
     
-    while(viewer.isAvailable()) {
-        if(zed.grab(runtime_parameters) == ERROR_CODE::SUCCESS) {
-            // Retrieve image in GPU memory
-            zed.retrieveImage(image, VIEW::LEFT, MEM::GPU);
+    while(display.nextFrame()) {
+        if (display.renderFrame() && !viewer.isAvailable()) break;
+        ERROR_CODE grab_state = zed.grab(runtime_parameters);
+        if(grab_state == ERROR_CODE::SUCCESS) {
+            // Retrieve image in GPU memory, only displayed
+            if (display.renderFrame()) zed.retrieveImage(image, VIEW::LEFT, MEM::GPU);
             // Update pose data (used for projection of the mesh over the current image)
             tracking_state = zed.getPosition(pose);
 
             if (tracking_state == POSITIONAL_TRACKING_STATE::OK) {
                 // Compute elapse time since the last call of plane detection
                 auto duration = chrono::duration_cast<chrono::milliseconds>(chrono::high_resolution_clock::now() - ts_last).count();
+                // Without window to press the Space Bar, the floor is searched continuously
+                if (display.headless()) user_action.press_space = true;
                 // Ask for a mesh update 
                 if(user_action.hit) {
                     auto image_click = sl::uint2(user_action.hit_coord.x * camera_infos.camera_configuration.resolution.width,user_action.hit_coord.y * camera_infos.camera_configuration.resolution.height);
@@ -108,13 +118,25 @@ int main(int argc, char** argv) {
                 }
 
                 if(find_plane_status == ERROR_CODE::SUCCESS) {
-                    mesh = plane.extractMesh();
-                    viewer.updateMesh(mesh, plane.type);
+                    if (!display.headless()) {
+                        mesh = plane.extractMesh();
+                        viewer.updateMesh(mesh, plane.type);
+                    }
+                    if (display.hasSink()) {
+                        auto equation = plane.getPlaneEquation();
+                        display.publish(zed.getTimestamp(TIME_REFERENCE::IMAGE).getNanoseconds(), string(toString(plane.type).c_str()) +
+                                " equation " + to_string(equation.x) + " " + to_string(equation.y) + " " + to_string(equation.z) + " " + to_string(equation.w));
+                    }
                 }
             }
 
-            user_action = viewer.updateImageAndState(image, pose.pose_data, tracking_state);
-        }
+            // The actions of the user are read at the rendered frames only
+            if (display.renderFrame())
+                user_action = viewer.updateImageAndState(image, pose.pose_data, tracking_state);
+            else
+                user_action.clear();
+        } else if (grab_state == ERROR_CODE::END_OF_SVOFILE_REACHED && display.headless())
+            break;
     }
 
     image.free();
@@ -124,41 +146,3 @@ int main(int argc, char** argv) {
     zed.close();
     return EXIT_SUCCESS;
 }
-
-void parseArgs(int argc, char **argv,sl::InitParameters& param)
-{
-    if (argc > 1 && string(argv[1]).find(".svo")!=string::npos) {
-        // SVO input mode
-        param.input.setFromSVOFile(argv[1]);
-        cout<<"[Sample] Using SVO File input: "<<argv[1]<<endl;
-    } else if (argc > 1 && string(argv[1]).find(".svo")==string::npos) {
-        string arg = string(argv[1]);
-        unsigned int a,b,c,d,port;
-        if (sscanf(arg.c_str(),"%u.%u.%u.%u:%d", &a, &b, &c, &d,&port) == 5) {
-            // Stream input mode - IP + port
-            string ip_adress = to_string(a)+"."+to_string(b)+"."+to_string(c)+"."+to_string(d);
-            param.input.setFromStream(sl::String(ip_adress.c_str()),port);
-            cout<<"[Sample] Using Stream input, IP : "<<ip_adress<<", port : "<<port<<endl;
-        }
-        else  if (sscanf(arg.c_str(),"%u.%u.%u.%u", &a, &b, &c, &d) == 4) {
-            // Stream input mode - IP only
-            param.input.setFromStream(sl::String(argv[1]));
-            cout<<"[Sample] Using Stream input, IP : "<<argv[1]<<endl;
-        }
-        else if (arg.find("HD2K")!=string::npos) {
-            param.camera_resolution = sl::RESOLUTION::HD2K;
-            cout<<"[Sample] Using Camera in resolution HD2K"<<endl;
-        } else if (arg.find("HD1080")!=string::npos) {
-            param.camera_resolution = sl::RESOLUTION::HD1080;
-            cout<<"[Sample] Using Camera in resolution HD1080"<<endl;
-        } else if (arg.find("HD720")!=string::npos) {
-            param.camera_resolution = sl::RESOLUTION::HD720;
-            cout<<"[Sample] Using Camera in resolution HD720"<<endl;
-        } else if (arg.find("VGA")!=string::npos) {
-            param.camera_resolution = sl::RESOLUTION::VGA;
-            cout<<"[Sample] Using Camera in resolution VGA"<<endl;
-        }
-    } else {
-        // Default
-    }
-}
@@ -27,6 +27,8 @@
 #include <sl/Camera.hpp>
 
 // Sample includes
+#include "DisplayMode.hpp"
+#include "ZedFrameSource.hpp"
 #include "GLViewer.hpp"
 
 // Using std namespace
@@ -40,8 +42,6 @@ inline void setTxt(sl::float3 value, char* ptr_txt) {
     snprintf(ptr_txt, MAX_CHAR, "%3.2f; %3.2f; %3.2f", value.x, value.y, value.z);
 }
 
-void parseArgs(int argc, char **argv, sl::InitParameters& param);
-
 int main(int argc, char **argv) {
 
     Camera zed;
@@ -50,7 +50,12 @@ int main(int argc, char **argv) {
     init_parameters.coordinate_units = UNIT::METER;
     init_parameters.coordinate_system = COORDINATE_SYSTEM::RIGHT_HANDED_Y_UP;
     init_parameters.sdk_verbose = true;
-    parseArgs(argc, argv, init_parameters);
+    // --headless, --preview N, --sink
+    DisplayMode display;
+    if (!display.parse(argc, argv)) return EXIT_FAILURE;
+    // Input of the sample: SVO file, IP[:port] of a stream, camera resolution or --source (FrameSource.hpp)
+    FrameSourceOptions source;
+    if (!source.parse(argc, argv) || !applyFrameSource(source, init_parameters)) return EXIT_FAILURE;
 
     // Open the camera
     auto returned_state = zed.open(init_parameters);
@@ -61,12 +66,12 @@ int main(int argc, char **argv) {
 
     auto camera_model = zed.getCameraInformation().camera_model;
     GLViewer viewer;
-    // Initialize OpenGL viewer
-    viewer.init(argc, argv, camera_model);
+    // Initialize OpenGL viewer, no GL context when headless
+    if (!display.headless()) viewer.init(argc, argv, camera_model);
 
     // Create text for GUI
-    char text_rotation[MAX_CHAR];
-    char text_translation[MAX_CHAR];
+    char text_rotation[MAX_CHAR] = "";
+    char text_translation[MAX_CHAR] = "";
 
     // Set parameters for Positional Tracking
     PositionalTrackingParameters positional_tracking_param;
@@ -85,15 +90,17 @@ int main(int argc, char **argv) {
     SensorsData sensors_data;
 #endif
     
-    while (viewer.isAvailable()) {
-        if (zed.grab() == ERROR_CODE::SUCCESS) {
+    while (display.nextFrame()) {
+        if (display.renderFrame() && !viewer.isAvailable()) break;
+        returned_state = zed.grab();
+        if (returned_state == ERROR_CODE::SUCCESS) {
             // Get the position of the camera in a fixed reference frame (the World Frame)
             tracking_state = zed.getPosition(camera_path, REFERENCE_FRAME::WORLD);
 
 #if IMU_ONLY
             if (zed.getSensorsData(sensors_data, TIME_REFERENCE::IMAGE) == sl::ERROR_CODE::SUCCESS) {
                 setTxt(sensors_data.imu.pose.getEulerAngles(), text_rotation); //only rotation is computed for IMU
-                viewer.updateData(sensors_data.imu.pose, string(text_translation), string(text_rotation), sl::POSITIONAL_TRACKING_STATE::OK);
+                if (!display.headless()) viewer.updateData(sensors_data.imu.pose, string(text_translation), string(text_rotation), sl::POSITIONAL_TRACKING_STATE::OK);
             }
 #else
             if (tracking_state == POSITIONAL_TRACKING_STATE::OK) {
@@ -102,11 +109,17 @@ int main(int argc, char **argv) {
                 setTxt(camera_path.getTranslation(), text_translation);
             }
 
-            // Update rotation, translation and tracking state values in the OpenGL window
-            viewer.updateData(camera_path.pose_data, string(text_translation), string(text_rotation), tracking_state);
+            // Update rotation, translation and tracking state values in the OpenGL window.
+            // At each frame, even those not rendered in preview: the viewer draws the whole path
+            if (!display.headless()) viewer.updateData(camera_path.pose_data, string(text_translation), string(text_rotation), tracking_state);
 #endif
+            if (display.hasSink())
+                display.publish(zed.getTimestamp(TIME_REFERENCE::IMAGE).getNanoseconds(), string(toString(tracking_state).c_str()) +
+                        " translation " + text_translation + " rotation " + text_rotation);
 
-        } else
+        } else if (returned_state == ERROR_CODE::END_OF_SVOFILE_REACHED && display.headless())
+            break;
+        else
             sleep_ms(1);
     }
 
@@ -117,38 +130,3 @@ int main(int argc, char **argv) {
     return EXIT_SUCCESS;
 }
 
-void parseArgs(int argc, char **argv, sl::InitParameters& param) {
-    if (argc > 1 && string(argv[1]).find(".svo") != string::npos) {
-        // SVO input mode
-        param.input.setFromSVOFile(argv[1]);
-        cout << "[Sample] Using SVO File input: " << argv[1] << endl;
-    } else if (argc > 1 && string(argv[1]).find(".svo") == string::npos) {
-        string arg = string(argv[1]);
-        unsigned int a, b, c, d, port;
-        if (sscanf(arg.c_str(), "%u.%u.%u.%u:%d", &a, &b, &c, &d, &port) == 5) {
-            // Stream input mode - IP + port
-            string ip_adress = to_string(a) + "." + to_string(b) + "." + to_string(c) + "." + to_string(d);
-            param.input.setFromStream(sl::String(ip_adress.c_str()), port);
-            cout << "[Sample] Using Stream input, IP : " << ip_adress << ", port : " << port << endl;
-        } else if (sscanf(arg.c_str(), "%u.%u.%u.%u", &a, &b, &c, &d) == 4) {
-            // Stream input mode - IP only
-            param.input.setFromStream(sl::String(argv[1]));
-            cout << "[Sample] Using Stream input, IP : " << argv[1] << endl;
-        } else if (arg.find("HD2K") != string::npos) {
-            param.camera_resolution = sl::RESOLUTION::HD2K;
-            cout << "[Sample] Using Camera in resolution HD2K" << endl;
-        } else if (arg.find("HD1080") != string::npos) {
-            param.camera_resolution = sl::RESOLUTION::HD1080;
-            cout << "[Sample] Using Camera in resolution HD1080" << endl;
-        } else if (arg.find("HD720") != string::npos) {
-            param.camera_resolution = sl::RESOLUTION::HD720;
-            cout << "[Sample] Using Camera in resolution HD720" << endl;
-        } else if (arg.find("VGA") != string::npos) {
-            param.camera_resolution = sl::RESOLUTION::VGA;
-            cout << "[Sample] Using Camera in resolution VGA" << endl;
-        }
-    } else {
-        // Default
-    }
-}
-
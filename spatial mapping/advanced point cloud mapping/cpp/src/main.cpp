@@ -27,7 +27,10 @@
 #include <sl/Camera.hpp>
 
 // Sample includes
+#include "DisplayMode.hpp"
+#include "ZedFrameSource.hpp"
 #include "GLViewer.hpp"
+#include "MatBridge.hpp"
 
 #include <opencv2/opencv.hpp>
 
@@ -35,8 +38,6 @@
 using namespace std;
 using namespace sl;
 
-void parse_args(int argc, char **argv,InitParameters& param);
-
 void print(std::string msg_prefix, sl::ERROR_CODE err_code = sl::ERROR_CODE::SUCCESS, std::string msg_suffix = "");
 
 int main(int argc, char **argv) {
@@ -45,7 +46,13 @@ int main(int argc, char **argv) {
     InitParameters init_parameters;
     init_parameters.depth_mode = DEPTH_MODE::ULTRA;    
     init_parameters.coordinate_system = COORDINATE_SYSTEM::RIGHT_HANDED_Y_UP; // OpenGL's coordinate system is right_handed    
-    parse_args(argc, argv, init_parameters);
+    // --headless, --preview N, --sink
+    DisplayMode display;
+    if (!display.parse(argc, argv)) return EXIT_FAILURE;
+    // Input of the sample: SVO file, IP[:port] of a stream, camera resolution or --source (FrameSource.hpp)
+    FrameSourceOptions source;
+    if (!source.parse(argc, argv) || !applyFrameSource(source, init_parameters)) return EXIT_FAILURE;
+    if (source.kind == FRAME_SOURCE::SVO) init_parameters.svo_real_time_mode = true;
 
     // Open the camera
     auto returned_state = zed.open(init_parameters);
@@ -63,9 +70,12 @@ int main(int argc, char **argv) {
 
     // Initialize point cloud viewer
     FusedPointCloud map;
-    GLenum errgl = viewer.init(argc, argv, camera_infos.camera_configuration.calibration_parameters.left_cam, &map, camera_infos.camera_model);
-    if (errgl!=GLEW_OK)
-        print("Error OpenGL: "+std::string((char*)glewGetErrorString(errgl)));
+    // No GL context when headless
+    if (!display.headless()) {
+        GLenum errgl = viewer.init(argc, argv, camera_infos.camera_configuration.calibration_parameters.left_cam, &map, camera_infos.camera_model);
+        if (errgl!=GLEW_OK)
+            print("Error OpenGL: "+std::string((char*)glewGetErrorString(errgl)));
+    }
 
     // Setup and start positional tracking
     Pose pose;
@@ -105,23 +115,26 @@ int main(int argc, char **argv) {
 
     // Create a Mat to contain the left image and its opencv ref
     Mat image_zed(display_resolution, MAT_TYPE::U8_C4);
-    cv::Mat image_zed_ocv(image_zed.getHeight(), image_zed.getWidth(), CV_8UC4, image_zed.getPtr<sl::uchar1>(MEM::CPU));
+    cv::Mat image_zed_ocv = toCvMat(image_zed);
     
     // Start the main loop
-    while (viewer.isAvailable()) {
+    while (display.nextFrame()) {
+        if (display.renderFrame() && !viewer.isAvailable()) break;
         // Grab a new image
-        if (zed.grab(runtime_parameters) == ERROR_CODE::SUCCESS) {
-            // Retrieve the left image
-            zed.retrieveImage(image_zed, VIEW::LEFT, MEM::CPU, display_resolution);
+        returned_state = zed.grab(runtime_parameters);
+        if (returned_state == ERROR_CODE::SUCCESS) {
+            // Retrieve the left image, only displayed
+            if (display.renderFrame()) zed.retrieveImage(image_zed, VIEW::LEFT, MEM::CPU, display_resolution);
             // Retrieve the camera pose data
             tracking_state = zed.getPosition(pose);
-            viewer.updatePose(pose, tracking_state);
+            // The viewer draws the whole path, it is given every pose
+            if (!display.headless()) viewer.updatePose(pose, tracking_state);
 
             if (tracking_state == POSITIONAL_TRACKING_STATE::OK) {                
                 auto duration = chrono::duration_cast<chrono::milliseconds>(chrono::high_resolution_clock::now() - ts_last).count();
                 
-                // Ask for a fused point cloud update if 500ms have elapsed since last request
-                if((duration > 500) && viewer.chunksUpdated()) {
+                // Ask for a fused point cloud update if 500ms have elapsed since last request, and the viewer has the previous one
+                if((duration > 500) && (display.headless() || viewer.chunksUpdated())) {
                     // Ask for a point cloud refresh
                     zed.requestSpatialMapAsync();
                     ts_last = chrono::high_resolution_clock::now();
@@ -130,16 +143,30 @@ int main(int argc, char **argv) {
                 // If the point cloud is ready to be retrieved
                 if(zed.getSpatialMapRequestStatusAsync() == ERROR_CODE::SUCCESS) {                    
                     zed.retrieveSpatialMapAsync(map);
-                    viewer.updateChunks();
+                    if (!display.headless()) viewer.updateChunks();
                 }
             }
-            cv::imshow("ZED View", image_zed_ocv);
-            cv::waitKey(15);
-        }
+            if (display.hasSink())
+                display.publish(zed.getTimestamp(TIME_REFERENCE::IMAGE).getNanoseconds(), string(toString(tracking_state).c_str()) +
+                        " chunks " + to_string(map.chunks.size()));
+            if (display.renderFrame()) {
+                cv::imshow("ZED View", image_zed_ocv);
+                cv::waitKey(15);
+            }
+        } else if (returned_state == ERROR_CODE::END_OF_SVOFILE_REACHED && display.headless())
+            break;
     }
 
     // Save generated point cloud
-    //map.save("MyFusedPointCloud");
+    if (display.headless()) {
+        // Nothing was displayed, the whole point cloud is the result
+        zed.extractWholeSpatialMap(map);
+        string save_name = "MyFusedPointCloud.ply";
+        if (map.save(save_name.c_str(), MESH_FILE_FORMAT::PLY))
+            print("Point cloud saved under: " + save_name);
+        else
+            print("Failed to save the point cloud under: " + save_name);
+    }
 
     // Free allocated memory before closing the camera
     image_zed.free();
@@ -149,45 +176,6 @@ int main(int argc, char **argv) {
     return 0;
 }
 
-void parse_args(int argc, char **argv,InitParameters& param)
-{
-    if (argc > 1 && string(argv[1]).find(".svo")!=string::npos) {
-        // SVO input mode
-        param.input.setFromSVOFile(argv[1]);
-        param.svo_real_time_mode=true;
-
-        cout<<"[Sample] Using SVO File input: "<<argv[1]<<endl;
-    } else if (argc > 1 && string(argv[1]).find(".svo")==string::npos) {
-        string arg = string(argv[1]);
-        unsigned int a,b,c,d,port;
-        if (sscanf(arg.c_str(),"%u.%u.%u.%u:%d", &a, &b, &c, &d,&port) == 5) {
-            // Stream input mode - IP + port
-            string ip_adress = to_string(a)+"."+to_string(b)+"."+to_string(c)+"."+to_string(d);
-            param.input.setFromStream(String(ip_adress.c_str()),port);
-            cout<<"[Sample] Using Stream input, IP : "<<ip_adress<<", port : "<<port<<endl;
-        }
-        else  if (sscanf(arg.c_str(),"%u.%u.%u.%u", &a, &b, &c, &d) == 4) {
-            // Stream input mode - IP only
-            param.input.setFromStream(String(argv[1]));
-            cout<<"[Sample] Using Stream input, IP : "<<argv[1]<<endl;
-        }
-        else if (arg.find("HD2K")!=string::npos) {
-            param.camera_resolution = RESOLUTION::HD2K;
-            cout<<"[Sample] Using Camera in resolution HD2K"<<endl;
-        } else if (arg.find("HD1080")!=string::npos) {
-            param.camera_resolution = RESOLUTION::HD1080;
-            cout<<"[Sample] Using Camera in resolution HD1080"<<endl;
-        } else if (arg.find("HD720")!=string::npos) {
-            param.camera_resolution = RESOLUTION::HD720;
-            cout<<"[Sample] Using Camera in resolution HD720"<<endl;
-        } else if (arg.find("VGA")!=string::npos) {
-            param.camera_resolution = RESOLUTION::VGA;
-            cout<<"[Sample] Using Camera in resolution VGA"<<endl;
-        }
-    } else {
-        // Default
-    }
-}
 
 void print(std::string msg_prefix, sl::ERROR_CODE err_code, std::string msg_suffix) {
     cout <<"[Sample]";
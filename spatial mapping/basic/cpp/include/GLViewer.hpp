@@ -8,6 +8,8 @@
 #include <GL/glew.h>
 #include <GL/freeglut.h>
 
+#include "GLPresenter.hpp"
+
 #include <mutex>
 
 #include <list>
@@ -44,6 +46,12 @@ struct ShaderData {
     GLuint shColorLoc;
 };
 
+///
+/// \brief indices of the points of a point cloud chunk, 0 to nb_points - 1. The chunks mostly grow from an update to
+/// the next: the indices already in index are kept, only the ones of the new points are written
+///
+void buildPointIndices(std::vector<sl::uint1> &index, size_t nb_points);
+
 class SubMapObj {
     GLuint vaoID_;
     GLuint vboID_[2];
@@ -74,8 +82,7 @@ class ImageHandler {
 
     private:
     GLuint texID;
-    GLuint imageTex;
-    cudaGraphicsResource* cuda_gl_ressource;//cuda GL resource
+    GLPresenter presenter;
     ShaderData shader;
     GLuint quad_vb;
 };
@@ -64,11 +64,8 @@ GLchar* IMAGE_FRAGMENT_SHADER =
 " in vec2 UV;\n"
 " out vec4 color;\n"
 " uniform sampler2D texImage;\n"
-" uniform bool revert;\n"
-" uniform bool rgbflip;\n"
 " void main() {\n"
-"    vec2 scaler  =revert?vec2(UV.x,1.f - UV.y):vec2(UV.x,UV.y);\n"
-"    vec3 rgbcolor = rgbflip?vec3(texture(texImage, scaler).zyx):vec3(texture(texImage, scaler).xyz);\n"
+"    vec3 rgbcolor = texture(texImage, UV).rgb;\n"
 "    color = vec4(rgbcolor,1);\n"
 "}";
 
@@ -77,10 +74,16 @@ GLchar* IMAGE_VERTEX_SHADER =
 "layout(location = 0) in vec3 vert;\n"
 "out vec2 UV;"
 "void main() {\n"
-"   UV = (vert.xy+vec2(1,1))/2;\n"
+"   UV = vec2(vert.x + 1.0, 1.0 - vert.y) / 2.0;\n"
 "	gl_Position = vec4(vert, 1);\n"
 "}\n";
 
+void buildPointIndices(std::vector<sl::uint1> &index, size_t nb_points) {
+    size_t nb_valid = std::min(index.size(), nb_points);
+    index.resize(nb_points);
+    for (size_t c = nb_valid; c < nb_points; c++) index[c] = static_cast<sl::uint1>(c);
+}
+
 SubMapObj::SubMapObj() {
     current_fc = 0;
     vaoID_ = 0;
@@ -129,9 +132,7 @@ void SubMapObj::update(sl::PointCloudChunk &chunk) {
 
     glShadeModel(GL_SMOOTH);
 
-	const auto nb_v = chunk.vertices.size();
-    index.resize(nb_v);
-    for (int c = 0; c < nb_v; c++) index[c] = c;
+    buildPointIndices(index, chunk.vertices.size());
     
     glBindVertexArray(vaoID_);
 
@@ -568,7 +569,7 @@ ImageHandler::~ImageHandler() {
 }
 
 void ImageHandler::close() {
-    glDeleteTextures(1, &imageTex);
+    presenter.release();
 }
 
 bool ImageHandler::initialize(sl::Resolution res) {
@@ -588,33 +589,20 @@ bool ImageHandler::initialize(sl::Resolution res) {
     glBindBuffer(GL_ARRAY_BUFFER, 0);
 
     glEnable(GL_TEXTURE_2D);
-    glGenTextures(1, &imageTex);
-    glBindTexture(GL_TEXTURE_2D, imageTex);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, res.width, res.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
-    glBindTexture(GL_TEXTURE_2D, 0);
-    cudaError_t err = cudaGraphicsGLRegisterImage(&cuda_gl_ressource, imageTex, GL_TEXTURE_2D, cudaGraphicsRegisterFlagsWriteDiscard);
-    return (err == cudaSuccess);
+    // Ring of textures: the copy of the next image does not wait for the draw of this one
+    return presenter.init(res.width, res.height, true, PixelFormat::BGRA);
 }
 
 void ImageHandler::pushNewImage(sl::Mat& image) {
-    cudaArray_t ArrIm;
-    cudaGraphicsMapResources(1, &cuda_gl_ressource, 0);
-    cudaGraphicsSubResourceGetMappedArray(&ArrIm, cuda_gl_ressource, 0, 0);
-    cudaMemcpy2DToArray(ArrIm, 0, 0, image.getPtr<sl::uchar1>(sl::MEM::GPU), image.getStepBytes(sl::MEM::GPU), image.getPixelBytes() * image.getWidth(), image.getHeight(), cudaMemcpyDeviceToDevice);
-    cudaGraphicsUnmapResources(1, &cuda_gl_ressource, 0);
+    presenter.uploadDevice(image.getPtr<sl::uchar1>(sl::MEM::GPU), image.getStepBytes(sl::MEM::GPU));
 }
 
 void ImageHandler::draw() {
     glEnable(GL_TEXTURE_2D);
     glUseProgram(shader.it.getProgramId());
     glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, imageTex);
+    glBindTexture(GL_TEXTURE_2D, presenter.texture());
     glUniform1i(texID, 0);
-    //invert y axis and color for this image (since its reverted from cuda array)
-    glUniform1i(glGetUniformLocation(shader.it.getProgramId(), "revert"), 1);
-    glUniform1i(glGetUniformLocation(shader.it.getProgramId(), "rgbflip"), 1);
 
     glEnableVertexAttribArray(0);
     glBindBuffer(GL_ARRAY_BUFFER, quad_vb);
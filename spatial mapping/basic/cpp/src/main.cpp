@@ -29,7 +29,10 @@
 #include <sl/Camera.hpp>
 
  // Sample includes
+#include "DisplayMode.hpp"
+#include "ZedFrameSource.hpp"
 #include "GLViewer.hpp"
+#include "StageTrace.hpp"
 
  // Using std and sl namespaces
 using namespace std;
@@ -38,7 +41,8 @@ using namespace sl;
 // set to 0 to create a Fused Point Cloud
 #define CREATE_MESH 1
 
-void parseArgs(int argc, char **argv,sl::InitParameters& param);
+template<typename Map>
+void saveMap(Camera& zed, Map& map, const SpatialMappingParameters& spatial_mapping_parameters);
 
 int main(int argc, char** argv) {
     Camera zed;
@@ -46,7 +50,15 @@ int main(int argc, char** argv) {
     InitParameters init_parameters;
     init_parameters.coordinate_units = UNIT::METER;
     init_parameters.coordinate_system = COORDINATE_SYSTEM::RIGHT_HANDED_Y_UP; // OpenGL coordinates system
-    parseArgs(argc,argv, init_parameters);
+    // --headless, --preview N, --sink
+    DisplayMode display;
+    if (!display.parse(argc, argv)) return EXIT_FAILURE;
+    // --trace <file.json>, --trace-stats
+    StageTrace trace;
+    if (!trace.parse(argc, argv)) return EXIT_FAILURE;
+    // Input of the sample: SVO file, IP[:port] of a stream, camera resolution or --source (FrameSource.hpp)
+    FrameSourceOptions source;
+    if (!source.parse(argc, argv) || !applyFrameSource(source, init_parameters)) return EXIT_FAILURE;
 
     // Open the camera
     auto returned_state = zed.open(init_parameters);
@@ -64,7 +76,8 @@ int main(int argc, char** argv) {
     CameraParameters camera_parameters = zed.getCameraInformation().camera_configuration.calibration_parameters.left_cam;
 
     GLViewer viewer;
-    bool error_viewer = viewer.init(argc, argv, camera_parameters, &map);
+    // No GL context when headless
+    bool error_viewer = !display.headless() && viewer.init(argc, argv, camera_parameters, &map);
 
     if(error_viewer) {
         viewer.exit();
@@ -89,30 +102,50 @@ int main(int argc, char** argv) {
         return EXIT_FAILURE;
     }
 
-    while(viewer.isAvailable()) {
-        if(zed.grab() == ERROR_CODE::SUCCESS) {
-            // Retrieve image in GPU memory
-            zed.retrieveImage(image, VIEW::LEFT, MEM::GPU);
+    while(display.nextFrame()) {
+        if (display.renderFrame() && !viewer.isAvailable()) break;
+        STAGE_SPAN("frame");
+        StageSpan grab_span("grab");
+        returned_state = zed.grab();
+        grab_span.end();
+        if(returned_state == ERROR_CODE::SUCCESS) {
+            // Retrieve image in GPU memory, only displayed
+            if (display.renderFrame()) {
+                STAGE_SPAN("retrieveImage");
+                zed.retrieveImage(image, VIEW::LEFT, MEM::GPU);
+            }
             // Update pose data (used for projection of the mesh over the current image)
+            StageSpan pose_span("getPosition");
             tracking_state = zed.getPosition(pose);
+            pose_span.end();
 
             if(mapping_activated) {
                 mapping_state = zed.getSpatialMappingState();
                 // Compute elapsed time since the last call of Camera::requestSpatialMapAsync()
                 auto duration = chrono::duration_cast<chrono::milliseconds>(chrono::high_resolution_clock::now() - ts_last).count();
-                // Ask for a mesh update if 500ms elapsed since last request
-                if((duration > 500) && viewer.chunksUpdated()) {
+                // Ask for a mesh update if 500ms elapsed since last request, and the viewer has the previous one
+                if((duration > 500) && (display.headless() || viewer.chunksUpdated())) {
+                    STAGE_SPAN("requestSpatialMapAsync");
                     zed.requestSpatialMapAsync();
                     ts_last = chrono::high_resolution_clock::now();
                 }
 
                 if(zed.getSpatialMapRequestStatusAsync() == ERROR_CODE::SUCCESS) {
+                    STAGE_SPAN("retrieveSpatialMapAsync");
                     zed.retrieveSpatialMapAsync(map);
                     viewer.updateChunks();
                 }
             }
 
-            bool change_state = viewer.updateImageAndState(image, pose.pose_data, tracking_state, mapping_state);
+            // Without window to press the space bar, the mapping starts at the first frame and stops at the end
+            bool change_state = display.headless() ? !mapping_activated : false;
+            if (display.renderFrame()) {
+                STAGE_SPAN("viewer");
+                change_state = viewer.updateImageAndState(image, pose.pose_data, tracking_state, mapping_state);
+            }
+            if (display.hasSink())
+                display.publish(zed.getTimestamp(TIME_REFERENCE::IMAGE).getNanoseconds(), string(toString(tracking_state).c_str()) + " " +
+                        toString(mapping_state).c_str() + " chunks " + to_string(map.chunks.size()));
 
             if(change_state) {
                 if(!mapping_activated) {
@@ -145,33 +178,18 @@ int main(int argc, char** argv) {
 
                     mapping_activated = true;
                 } else {
-                    // Extract the whole mesh
-                    zed.extractWholeSpatialMap(map);
-#if CREATE_MESH
-                    MeshFilterParameters filter_params;
-                    filter_params.set(MeshFilterParameters::MESH_FILTER::MEDIUM);
-                    // Filter the extracted mesh
-                    map.filter(filter_params, true);
-					viewer.clearCurrentMesh();
-
-                    // If textures have been saved during spatial mapping, apply them to the mesh
-                    if(spatial_mapping_parameters.save_texture)
-                        map.applyTexture(MESH_TEXTURE_FORMAT::RGB);
-#endif
-                    // Save mesh as an OBJ file
-                    string saveName = getDir() + "mesh_gen.obj";
-                    bool error_save = map.save(saveName.c_str());
-                    if(error_save)
-                        print("Mesh saved under: " +saveName);
-					else
-                        print("Failed to save the mesh under: " +saveName);
-
+                    saveMap(zed, map, spatial_mapping_parameters);
+                    viewer.clearCurrentMesh();
                     mapping_state = SPATIAL_MAPPING_STATE::NOT_ENABLED;
                     mapping_activated = false;
                 }
             }
-        }
+        } else if(returned_state == ERROR_CODE::END_OF_SVOFILE_REACHED && display.headless())
+            break;
     }
+    // Headless, the map is saved when the sample ends
+    if(display.headless() && mapping_activated)
+        saveMap(zed, map, spatial_mapping_parameters);
 
     image.free();
     map.clear();
@@ -179,43 +197,31 @@ int main(int argc, char** argv) {
     zed.disableSpatialMapping();
     zed.disablePositionalTracking();
     zed.close();
+    trace.finish();
     return EXIT_SUCCESS;
 }
 
-void parseArgs(int argc, char **argv,sl::InitParameters& param)
-{
-    if (argc > 1 && string(argv[1]).find(".svo")!=string::npos) {
-        // SVO input mode
-        param.input.setFromSVOFile(argv[1]);
-        cout<<"[Sample] Using SVO File input: "<<argv[1]<<endl;
-    } else if (argc > 1 && string(argv[1]).find(".svo")==string::npos) {
-        string arg = string(argv[1]);
-        unsigned int a,b,c,d,port;
-        if (sscanf(arg.c_str(),"%u.%u.%u.%u:%d", &a, &b, &c, &d,&port) == 5) {
-            // Stream input mode - IP + port
-            string ip_adress = to_string(a)+"."+to_string(b)+"."+to_string(c)+"."+to_string(d);
-            param.input.setFromStream(sl::String(ip_adress.c_str()),port);
-            cout<<"[Sample] Using Stream input, IP : "<<ip_adress<<", port : "<<port<<endl;
-        }
-        else  if (sscanf(arg.c_str(),"%u.%u.%u.%u", &a, &b, &c, &d) == 4) {
-            // Stream input mode - IP only
-            param.input.setFromStream(sl::String(argv[1]));
-            cout<<"[Sample] Using Stream input, IP : "<<argv[1]<<endl;
-        }
-        else if (arg.find("HD2K")!=string::npos) {
-            param.camera_resolution = sl::RESOLUTION::HD2K;
-            cout<<"[Sample] Using Camera in resolution HD2K"<<endl;
-        } else if (arg.find("HD1080")!=string::npos) {
-            param.camera_resolution = sl::RESOLUTION::HD1080;
-            cout<<"[Sample] Using Camera in resolution HD1080"<<endl;
-        } else if (arg.find("HD720")!=string::npos) {
-            param.camera_resolution = sl::RESOLUTION::HD720;
-            cout<<"[Sample] Using Camera in resolution HD720"<<endl;
-        } else if (arg.find("VGA")!=string::npos) {
-            param.camera_resolution = sl::RESOLUTION::VGA;
-            cout<<"[Sample] Using Camera in resolution VGA"<<endl;
-        }
-    } else {
-        // Default
-    }
+template<typename Map>
+void saveMap(Camera& zed, Map& map, const SpatialMappingParameters& spatial_mapping_parameters) {
+    // Extract the whole mesh
+    zed.extractWholeSpatialMap(map);
+#if CREATE_MESH
+    MeshFilterParameters filter_params;
+    filter_params.set(MeshFilterParameters::MESH_FILTER::MEDIUM);
+    // Filter the extracted mesh
+    map.filter(filter_params, true);
+
+    // If textures have been saved during spatial mapping, apply them to the mesh
+    if(spatial_mapping_parameters.save_texture)
+        map.applyTexture(MESH_TEXTURE_FORMAT::RGB);
+#else
+    (void)spatial_mapping_parameters;
+#endif
+    // Save mesh as an OBJ file
+    string saveName = getDir() + "mesh_gen.obj";
+    bool error_save = map.save(saveName.c_str());
+    if(error_save)
+        print("Mesh saved under: " +saveName);
+    else
+        print("Failed to save the mesh under: " +saveName);
 }
@@ -0,0 +1,70 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+/***********************************************************************
+ ** CPU side of the update of the point cloud chunks of the viewer:   **
+ ** indices of the points uploaded with each chunk, for a new chunk,  **
+ ** for a chunk that grew since its last update (the common case      **
+ ** while mapping) and with the previous loop that rewrote them all.  **
+ ***********************************************************************/
+
+#include "GLViewer.hpp"
+#include "BenchSuite.hpp"
+
+int main(int argc, char **argv) {
+    BenchSuite suite("ZED_Spatial_Mapping_Bench");
+
+    // Points of a chunk of a fused point cloud, from a small to a dense one
+    const size_t chunk_sizes[] = {20000, 200000, 1000000};
+    // Chunks kept alive by the lambdas of the suite
+    std::list<std::vector<sl::uint1>> indices;
+
+    for (size_t nb_points : chunk_sizes) {
+        // The chunk grew by 2% since its last update
+        const size_t previous_size = nb_points - nb_points / 50;
+        std::vector<sl::uint1> grown;
+        buildPointIndices(grown, previous_size);
+        buildPointIndices(grown, nb_points);
+        bool valid = grown.size() == nb_points;
+        for (size_t c = 0; valid && c < nb_points; c++) valid = grown[c] == c;
+        suite.check(valid, "indices of a grown chunk");
+
+        std::string name = "/" + std::to_string(nb_points);
+        indices.emplace_back();
+        auto &index = indices.back();
+        suite.add("point_indices/rewrite" + name, [&index, nb_points]() {
+            index.resize(nb_points);
+            for (size_t c = 0; c < nb_points; c++) index[c] = static_cast<sl::uint1>(c);
+            doNotOptimize(index.data());
+        }).items(static_cast<double>(nb_points));
+        suite.add("point_indices/new" + name, [&index, nb_points]() {
+            index.clear();
+            buildPointIndices(index, nb_points);
+            doNotOptimize(index.data());
+        }).items(static_cast<double>(nb_points));
+        suite.add("point_indices/grown" + name, [&index, nb_points, previous_size]() {
+            index.resize(previous_size);
+            buildPointIndices(index, nb_points);
+            doNotOptimize(index.data());
+        }).items(static_cast<double>(nb_points));
+    }
+
+    return suite.run(argc, argv);
+}
@@ -0,0 +1,116 @@
+#ifndef __AVI_CONCAT_HPP__
+#define __AVI_CONCAT_HPP__
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+///
+/// \brief The video stream of an AVI file: its headers, as written in the file, and the position of its frames
+///
+struct AviVideoStream {
+    struct Frame {
+        uint64_t offset = 0;    ///< position of the data of the frame in the file
+        uint32_t size = 0;
+    };
+
+    std::vector<uint8_t> strh;  ///< AVIStreamHeader
+    std::vector<uint8_t> strf;  ///< BITMAPINFOHEADER, with the extra data of the codec
+    std::vector<Frame> frames;  ///< in stream order, over all the RIFF lists of the file
+
+    uint32_t fourcc() const;    ///< biCompression of strf
+    int width() const;
+    int height() const;
+    uint32_t scale() const;
+    uint32_t rate() const;
+
+    ///
+    /// \brief headers of a video stream of fps frames per second, for AviWriter
+    ///
+    static AviVideoStream make(uint32_t fourcc, int width, int height, int fps);
+};
+
+///
+/// \brief reads the headers and the frame positions of the first video stream of an AVI file, OpenDML (> 1 GB) files included
+/// Prints the error and returns false if the file is not a readable AVI file
+///
+bool readAviVideoStream(const std::string& path, AviVideoStream& stream);
+
+///
+/// \brief whether a frame of the codec can be decoded on its own. Every frame of an intra only codec (MJPG) is,
+/// an MPEG-4 part 2 frame is if it is an I-VOP
+/// \return false for an empty frame, and for the codecs not known here (see isAviCodecSupported)
+///
+bool isAviKeyFrame(uint32_t fourcc, const uint8_t* data, size_t size);
+bool isAviCodecSupported(uint32_t fourcc);
+
+///
+/// \brief The AviWriter class
+/// Writes an already encoded video stream in an AVI file: frames copied as they are, without decoding. The file is an
+/// OpenDML AVI (RIFF lists of 1 GB at most, standard and super indexes) with the idx1 index of the first RIFF list for
+/// the AVI 1.0 readers, so it can hold hours of video.
+///
+class AviWriter {
+public:
+    ///
+    /// \brief riff_max_size : size of the RIFF lists, 1 GB as recommended by OpenDML. Smaller lists are only useful to check the readers
+    ///
+    explicit AviWriter(uint64_t riff_max_size = 1ull << 30) : riff_max_size(riff_max_size) {}
+    ~AviWriter() { close(); }
+
+    ///
+    /// \brief creates the file, with the headers of format (the frames of format are ignored)
+    ///
+    bool open(const std::string& path, const AviVideoStream& format);
+    bool write(const uint8_t* data, uint32_t size, bool keyframe);
+    ///
+    /// \brief writes the indexes and the frame counts. Returns false if a write of the file failed
+    ///
+    bool close();
+
+    bool isOpened() const { return file.is_open(); }
+    int getNbFrames() const { return nb_frames; }
+
+private:
+    struct Entry {
+        uint64_t offset;    ///< position of the data of the frame
+        uint32_t size;
+        bool keyframe;
+    };
+    struct RiffIndex {
+        uint64_t offset;    ///< position of the ix00 chunk
+        uint32_t size;
+        uint32_t nb_frames;
+    };
+
+    void startRiff();
+    void endRiff();
+    uint64_t beginChunk(const char* id);
+    uint64_t beginList(const char* type, const char* list_type);
+    void endChunk(uint64_t size_position);
+    void put(const void* data, size_t size);
+    void put32(uint32_t value);
+    void putAt32(uint64_t at, uint32_t value);
+
+    const uint64_t riff_max_size;
+    std::ofstream file;
+    uint64_t position = 0;  ///< end of the file, where the next write goes
+    AviVideoStream header;
+    uint64_t avih_position = 0, strh_position = 0, indx_position = 0, dmlh_position = 0;
+    uint64_t riff_position = 0, riff_size_position = 0, movi_position = 0, movi_size_position = 0;
+    std::vector<Entry> riff_entries, first_riff_entries;
+    std::vector<RiffIndex> riff_indexes;
+    uint32_t max_frame_size = 0;
+    int nb_frames = 0;
+    bool failed = false;
+};
+
+///
+/// \brief concatenates AVI files of the same format into a single one, in the given order, by copying their frames
+/// without decoding them: no second encoding, no quality loss, and the time of a file copy
+/// \return the number of frames written, -1 if a file cannot be read or written, or if the files have different formats
+///
+int concatAviSegments(const std::vector<std::string>& segment_files, const std::string& output_path);
+
+#endif
@@ -0,0 +1,151 @@
+#ifndef __EXPORT_POOL_HPP__
+#define __EXPORT_POOL_HPP__
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+#include "FrameContainer.hpp"
+
+///
+/// \brief What the encoder workers produce from each frame
+///
+enum class EXPORT_OUTPUT {
+    VIDEO,                  ///< side by side BGR frame, written in order to a cv::VideoWriter
+    IMAGE_SEQUENCE,         ///< left + right (or depth view) images
+    IMAGE_SEQUENCE_DEPTH_16,///< left image + 16 bit depth in millimeters
+    RAW_CONTAINER           ///< left image + depth written in a memory mapped FrameContainer
+};
+
+///
+/// \brief One recycled frame buffer. The producer fills left and right (or depth),
+/// the pool takes care of the conversion, the encoding and the writing.
+///
+struct ExportFrame {
+    int slot = 0;           ///< index of the buffer in the pool
+    int index = 0;          ///< frame number, used for the file names
+    unsigned long long sequence = 0; ///< submission order, used by the ordered video writer
+    unsigned long long timestamp = 0; ///< image timestamp in nanoseconds, stored in the RAW_CONTAINER index
+    cv::Mat left;           ///< BGRA
+    cv::Mat right;          ///< BGRA, RIGHT or DEPTH view
+    cv::Mat depth;          ///< F32, only allocated for IMAGE_SEQUENCE_DEPTH_16 and RAW_CONTAINER
+    cv::Mat side_by_side;   ///< BGR, only allocated for VIDEO
+};
+
+///
+/// \brief The ExportPool class
+/// Spreads the frame conversion and the image encoding (PNG/JPEG compression dominates the export time) over several threads.
+/// Frames are handed over through a bounded set of recycled buffers: acquire() blocks when every buffer is in flight,
+/// which keeps the memory usage constant and throttles the SVO decoding to the encoding speed.
+/// In VIDEO mode the conversions run in parallel but a single writer thread pushes the frames to the cv::VideoWriter in submission order.
+/// The class only depends on OpenCV so it can be fed with synthetic frames.
+///
+class ExportPool {
+public:
+
+    ///
+    /// \brief ExportPool
+    /// \param output_ : kind of output to produce
+    /// \param image_size : size of a single (left or right) image
+    /// \param nb_workers : number of encoder threads, 0 to use all the available cores
+    /// \param nb_buffers : number of recycled frame buffers, 0 to use twice the number of workers
+    ///
+    ExportPool(EXPORT_OUTPUT output_, cv::Size image_size, int nb_workers = 0, int nb_buffers = 0);
+    ~ExportPool();
+
+    ///
+    /// \brief set the image sequence destination
+    /// \param folder : output folder, must end with '/' or '\'
+    /// \param right_prefix : file prefix of the second image ("right" or "depth")
+    /// \param extension : image file extension (".png", ".jpg"). 16 bit depth is always written as PNG
+    ///
+    void setImageSequence(std::string folder, std::string right_prefix, std::string extension = ".png");
+
+    ///
+    /// \brief set the video destination, must be opened with a frame size of (2*width, height)
+    ///
+    void setVideoWriter(cv::VideoWriter* writer);
+
+    ///
+    /// \brief set the raw container destination, frames are stored in the slot of their index
+    ///
+    void setContainer(FrameContainerWriter* container);
+
+    ///
+    /// \brief start the encoder (and writer) threads
+    ///
+    void start();
+
+    ///
+    /// \brief acquire a free buffer, blocks until one is recycled
+    /// \return nullptr if the pool is stopped
+    ///
+    ExportFrame* acquire();
+
+    ///
+    /// \brief submit a filled buffer to the encoders
+    ///
+    void submit(ExportFrame* frame);
+
+    ///
+    /// \brief give back an unused buffer without encoding it
+    ///
+    void release(ExportFrame* frame);
+
+    ///
+    /// \brief wait for all the submitted frames to be written then stop the threads
+    ///
+    void finish();
+
+    /// Buffers accessors, used to wrap the memory once (e.g. into sl::Mat) before the export
+    int getNbBuffers() const { return static_cast<int>(frames.size()); }
+    ExportFrame& getBuffer(int i) { return frames[i]; }
+    int getNbWorkers() const { return nb_workers; }
+
+    /// Statistics
+    int getNbWritten() const { return nb_written; }
+    int getNbErrors() const { return nb_errors; }
+    ///
+    /// \brief mean throughput since start(), in frames per second
+    ///
+    float getFPS() const;
+
+private:
+    void encoderLoop();
+    void writerLoop();
+    void encode(ExportFrame& frame, cv::Mat& depth16, std::vector<uint8_t>& scratch);
+    void recycle(ExportFrame* frame);
+    bool write(const std::string& file, const cv::Mat& image);
+
+    EXPORT_OUTPUT output;
+    int nb_workers = 1;
+    std::string folder, right_prefix, extension = ".png";
+    cv::VideoWriter* video_writer = nullptr;
+    FrameContainerWriter* container = nullptr;
+
+    std::vector<ExportFrame> frames;
+    std::vector<std::thread> workers;
+    std::thread writer;
+
+    std::mutex mtx;
+    std::condition_variable free_cv, job_cv, done_cv;
+    std::deque<int> free_slots;
+    std::deque<int> jobs;
+    std::map<unsigned long long, int> encoded; // sequence -> slot, waiting for the ordered writer
+    unsigned long long next_sequence = 0, next_to_write = 0;
+    bool stopping = false, encoders_done = false, running = false;
+
+    std::atomic<int> nb_written{0};
+    std::atomic<int> nb_errors{0};
+    std::chrono::steady_clock::time_point start_time;
+};
+
+#endif
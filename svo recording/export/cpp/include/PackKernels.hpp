@@ -0,0 +1,27 @@
+#ifndef __PACK_KERNELS_HPP__
+#define __PACK_KERNELS_HPP__
+
+#include <cstddef>
+#include <cstdint>
+
+///
+/// \brief pack two BGRA images side by side into a BGR image, in a single pass
+/// Replaces the two cv::cvtColor(BGRA2BGR) into the ROIs of the side by side frame. dst can be any buffer,
+/// e.g. the input frame of the video encoder, as long as it holds height rows of dst_step >= 6 * width bytes.
+/// \param left, right : BGRA images of width x height, left_step / right_step bytes per row
+/// \param dst : BGR output of (2 * width) x height, dst_step bytes per row
+///
+void packSideBySideBGR(const uint8_t* left, size_t left_step, const uint8_t* right, size_t right_step,
+        int width, int height, uint8_t* dst, size_t dst_step);
+
+///
+/// \brief BGRA -> BGR conversion of a single row of width pixels
+///
+void packRowBGR(const uint8_t* src, uint8_t* dst, int width);
+
+///
+/// \brief name of the implementation selected for this CPU: "AVX2", "NEON" or "scalar"
+///
+const char* packKernelName();
+
+#endif
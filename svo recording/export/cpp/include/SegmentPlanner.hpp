@@ -0,0 +1,53 @@
+#ifndef __SEGMENT_PLANNER_HPP__
+#define __SEGMENT_PLANNER_HPP__
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+///
+/// \brief A range of SVO frames [start, end) exported by a single sl::Camera instance
+///
+struct ExportSegment {
+    int id = 0;
+    int start = 0;
+    int end = 0;
+
+    int size() const { return end - start; }
+    bool contains(int svo_position) const { return svo_position >= start && svo_position < end; }
+};
+
+///
+/// \brief split [0, nb_frames) into nb_segments contiguous ranges of (almost) equal size
+/// The first (nb_frames % nb_segments) segments get one extra frame. Empty segments are never returned.
+///
+inline std::vector<ExportSegment> planSegments(int nb_frames, int nb_segments) {
+    std::vector<ExportSegment> segments;
+    if (nb_frames <= 0) return segments;
+    nb_segments = std::max(1, std::min(nb_segments, nb_frames));
+    int base = nb_frames / nb_segments, extra = nb_frames % nb_segments;
+    int start = 0;
+    for (int i = 0; i < nb_segments; i++) {
+        ExportSegment s;
+        s.id = i;
+        s.start = start;
+        s.end = start + base + (i < extra ? 1 : 0);
+        segments.push_back(s);
+        start = s.end;
+    }
+    return segments;
+}
+
+///
+/// \brief name of the temporary video of a segment: "path/file.avi" -> "path/file_part2.avi"
+///
+inline std::string segmentFileName(const std::string& output_path, int segment_id) {
+    size_t dot = output_path.find_last_of('.');
+    size_t sep = output_path.find_last_of("/\\");
+    std::string suffix = "_part" + std::to_string(segment_id);
+    if (dot == std::string::npos || (sep != std::string::npos && dot < sep))
+        return output_path + suffix;
+    return output_path.substr(0, dot) + suffix + output_path.substr(dot);
+}
+
+#endif
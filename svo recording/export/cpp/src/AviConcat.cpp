@@ -0,0 +1,520 @@
+#include "AviConcat.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <iostream>
+
+namespace {
+const uint32_t AVIF_HASINDEX = 0x10;
+const uint32_t AVIF_ISINTERLEAVED = 0x100;
+const uint32_t AVIIF_KEYFRAME = 0x10;
+// OpenDML: the super index of the stream points to the index of each RIFF list, 256 lists of 1 GB
+const int SUPER_INDEX_ENTRIES = 256;
+const size_t AVIH_SIZE = 56, STRH_SIZE = 56, DMLH_SIZE = 248;
+const size_t INDX_SIZE = 24 + 16 * SUPER_INDEX_ENTRIES;
+
+uint32_t get32(const uint8_t* data) {
+    return data[0] | (data[1] << 8) | (data[2] << 16) | (static_cast<uint32_t>(data[3]) << 24);
+}
+
+void set16(uint8_t* data, uint32_t value) {
+    data[0] = value & 0xFF;
+    data[1] = (value >> 8) & 0xFF;
+}
+
+void set32(uint8_t* data, uint32_t value) {
+    for (int i = 0; i < 4; i++) data[i] = (value >> (8 * i)) & 0xFF;
+}
+
+uint32_t fourccOf(const char* text) {
+    return get32(reinterpret_cast<const uint8_t*>(text));
+}
+
+std::string fourccText(uint32_t fourcc) {
+    std::string text(4, ' ');
+    for (int i = 0; i < 4; i++) {
+        char c = static_cast<char>((fourcc >> (8 * i)) & 0xFF);
+        text[i] = isprint(static_cast<unsigned char>(c)) ? c : '?';
+    }
+    return text;
+}
+
+std::string upperFourcc(uint32_t fourcc) {
+    std::string text = fourccText(fourcc);
+    for (auto& c : text) c = static_cast<char>(toupper(static_cast<unsigned char>(c)));
+    return text;
+}
+
+bool isIntraCodec(uint32_t fourcc) {
+    static const char* const intra[] = {"MJPG", "JPEG", "AVRN", "LJPG", "DMB1"};
+    std::string text = upperFourcc(fourcc);
+    return std::find(std::begin(intra), std::end(intra), text) != std::end(intra);
+}
+
+bool isMpeg4Part2(uint32_t fourcc) {
+    static const char* const mpeg4[] = {"FMP4", "M4S2", "MP4V", "MP4S", "XVID", "DIVX", "DX50", "3IV2"};
+    std::string text = upperFourcc(fourcc);
+    return std::find(std::begin(mpeg4), std::end(mpeg4), text) != std::end(mpeg4);
+}
+
+// Chunks of the RIFF tree of an AVI file, with the bounds checked against the file
+class AviReader {
+public:
+    bool open(const std::string& path_) {
+        path = path_;
+        file.open(path, std::ios::binary);
+        if (!file.is_open()) return error("Cannot open");
+        file.seekg(0, std::ios::end);
+        file_size = static_cast<uint64_t>(file.tellg());
+        return true;
+    }
+
+    bool parse(AviVideoStream& stream) {
+        uint64_t position = 0;
+        bool first = true;
+        while (position + 12 <= file_size) {
+            uint8_t header[12];
+            if (!read(position, header, sizeof(header))) return false;
+            if (get32(header) != fourccOf("RIFF")) break;
+            uint32_t form = get32(header + 8);
+            if (form != fourccOf(first ? "AVI " : "AVIX")) {
+                if (first) return error("Not an AVI file");
+                break;
+            }
+            uint64_t end = std::min<uint64_t>(position + 8 + get32(header + 4), file_size);
+            if (!parseChunks(position + 12, end, stream, first)) return false;
+            if (first && video_stream < 0) return error("No video stream in");
+            first = false;
+            position = end + (end & 1);
+        }
+        if (first) return error("Not an AVI file");
+        return true;
+    }
+
+private:
+    bool error(const std::string& what) {
+        std::cout << "[Sample][Error] " << what << " " << path << std::endl;
+        return false;
+    }
+
+    bool read(uint64_t position, void* data, size_t size) {
+        if (position + size > file_size) return error("Truncated AVI file");
+        file.seekg(static_cast<std::streamoff>(position));
+        file.read(static_cast<char*>(data), size);
+        return file.good() || error("Cannot read");
+    }
+
+    bool readChunk(uint64_t position, uint64_t end, uint32_t& id, uint32_t& size) {
+        uint8_t header[8];
+        if (position + 8 > end || !read(position, header, sizeof(header))) return error("Truncated AVI chunk in");
+        id = get32(header);
+        size = get32(header + 4);
+        if (position + 8 + size > end) return error("Truncated AVI chunk in");
+        return true;
+    }
+
+    bool readBytes(uint64_t position, uint32_t size, std::vector<uint8_t>& bytes) {
+        bytes.resize(size);
+        return size == 0 || read(position, bytes.data(), size);
+    }
+
+    // Top level chunks of a RIFF list: headers and movi lists
+    bool parseChunks(uint64_t position, uint64_t end, AviVideoStream& stream, bool first) {
+        while (position + 8 <= end) {
+            uint32_t id, size;
+            if (!readChunk(position, end, id, size)) return false;
+            uint64_t data = position + 8;
+            if (id == fourccOf("LIST") && size >= 4) {
+                uint8_t type[4];
+                if (!read(data, type, sizeof(type))) return false;
+                if (first && get32(type) == fourccOf("hdrl") && !parseHeaders(data + 4, data + size, stream)) return false;
+                if (get32(type) == fourccOf("movi") && !parseMovi(data + 4, data + size, stream)) return false;
+            }
+            position = data + size + (size & 1);
+        }
+        return true;
+    }
+
+    // strl lists of the hdrl list, the first video stream is kept
+    bool parseHeaders(uint64_t position, uint64_t end, AviVideoStream& stream) {
+        int nb_streams = 0;
+        while (position + 8 <= end) {
+            uint32_t id, size;
+            if (!readChunk(position, end, id, size)) return false;
+            uint64_t data = position + 8;
+            uint8_t type[4];
+            if (id == fourccOf("LIST") && size >= 4 && read(data, type, sizeof(type)) && get32(type) == fourccOf("strl")) {
+                std::vector<uint8_t> strh, strf;
+                uint64_t strl = data + 4, strl_end = data + size;
+                while (strl + 8 <= strl_end) {
+                    uint32_t strl_id, strl_size;
+                    if (!readChunk(strl, strl_end, strl_id, strl_size)) return false;
+                    if (strl_id == fourccOf("strh") && !readBytes(strl + 8, strl_size, strh)) return false;
+                    if (strl_id == fourccOf("strf") && !readBytes(strl + 8, strl_size, strf)) return false;
+                    strl += 8 + strl_size + (strl_size & 1);
+                }
+                if (video_stream < 0 && strh.size() >= STRH_SIZE && strf.size() >= 20 && get32(strh.data()) == fourccOf("vids")) {
+                    video_stream = nb_streams;
+                    stream.strh = strh;
+                    stream.strf = strf;
+                }
+                nb_streams++;
+            }
+            position = data + size + (size & 1);
+        }
+        return true;
+    }
+
+    // Frames of the video stream: "NNdc" (compressed) and "NNdb" (uncompressed) chunks, also in "rec " lists
+    bool parseMovi(uint64_t position, uint64_t end, AviVideoStream& stream) {
+        if (video_stream < 0) return error("No video stream header before the frames in");
+        const char digits[2] = {static_cast<char>('0' + video_stream / 10 % 10), static_cast<char>('0' + video_stream % 10)};
+        while (position + 8 <= end) {
+            uint32_t id, size;
+            if (!readChunk(position, end, id, size)) return false;
+            uint64_t data = position + 8;
+            char text[4];
+            set32(reinterpret_cast<uint8_t*>(text), id);
+            if (id == fourccOf("LIST") && size >= 4) {
+                uint8_t type[4];
+                if (!read(data, type, sizeof(type))) return false;
+                if (get32(type) == fourccOf("rec ") && !parseMovi(data + 4, data + size, stream)) return false;
+            } else if (text[0] == digits[0] && text[1] == digits[1] && text[2] == 'd' && (text[3] == 'c' || text[3] == 'b')) {
+                AviVideoStream::Frame frame;
+                frame.offset = data;
+                frame.size = size;
+                stream.frames.push_back(frame);
+            }
+            position = data + size + (size & 1);
+        }
+        return true;
+    }
+
+    std::string path;
+    std::ifstream file;
+    uint64_t file_size = 0;
+    int video_stream = -1;
+};
+}
+
+uint32_t AviVideoStream::fourcc() const {
+    return strf.size() >= 20 ? get32(strf.data() + 16) : 0;
+}
+
+int AviVideoStream::width() const {
+    return strf.size() >= 8 ? static_cast<int>(get32(strf.data() + 4)) : 0;
+}
+
+int AviVideoStream::height() const {
+    return strf.size() >= 12 ? std::abs(static_cast<int>(get32(strf.data() + 8))) : 0;
+}
+
+uint32_t AviVideoStream::scale() const {
+    return strh.size() >= STRH_SIZE ? get32(strh.data() + 20) : 0;
+}
+
+uint32_t AviVideoStream::rate() const {
+    return strh.size() >= STRH_SIZE ? get32(strh.data() + 24) : 0;
+}
+
+AviVideoStream AviVideoStream::make(uint32_t fourcc, int width, int height, int fps) {
+    AviVideoStream stream;
+    stream.strh.assign(STRH_SIZE, 0);
+    uint8_t* strh = stream.strh.data();
+    set32(strh, fourccOf("vids"));
+    set32(strh + 4, fourcc);
+    set32(strh + 20, 1);                // dwScale
+    set32(strh + 24, fps);              // dwRate
+    set32(strh + 40, 0xFFFFFFFF);       // dwQuality, default
+    set16(strh + 52, width);            // rcFrame right
+    set16(strh + 54, height);           // rcFrame bottom
+
+    stream.strf.assign(40, 0);
+    uint8_t* strf = stream.strf.data();
+    set32(strf, 40);                    // biSize
+    set32(strf + 4, width);
+    set32(strf + 8, height);
+    set16(strf + 12, 1);                // biPlanes
+    set16(strf + 14, 24);               // biBitCount
+    set32(strf + 16, fourcc);           // biCompression
+    set32(strf + 20, width * height * 3);
+    return stream;
+}
+
+bool readAviVideoStream(const std::string& path, AviVideoStream& stream) {
+    stream = AviVideoStream();
+    AviReader reader;
+    return reader.open(path) && reader.parse(stream);
+}
+
+bool isAviCodecSupported(uint32_t fourcc) {
+    return isIntraCodec(fourcc) || isMpeg4Part2(fourcc);
+}
+
+bool isAviKeyFrame(uint32_t fourcc, const uint8_t* data, size_t size) {
+    if (size == 0) return false;
+    if (isIntraCodec(fourcc)) return true;
+    if (isMpeg4Part2(fourcc)) {
+        // vop_coding_type, the 2 bits after the VOP start code: 0 for an intra coded VOP
+        for (size_t i = 0; i + 4 < size; i++)
+            if (data[i] == 0 && data[i + 1] == 0 && data[i + 2] == 1 && data[i + 3] == 0xB6)
+                return (data[i + 4] >> 6) == 0;
+    }
+    return false;
+}
+
+bool AviWriter::open(const std::string& path, const AviVideoStream& format) {
+    close();
+    header = format;
+    header.frames.clear();
+    position = 0;
+    riff_entries.clear();
+    first_riff_entries.clear();
+    riff_indexes.clear();
+    max_frame_size = 0;
+    nb_frames = 0;
+    failed = false;
+    if (header.strh.size() < STRH_SIZE || header.strf.size() < 20) return false;
+
+    file.open(path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) return false;
+
+    riff_size_position = beginList("RIFF", "AVI ");
+    uint64_t hdrl = beginList("LIST", "hdrl");
+
+    uint8_t avih[AVIH_SIZE] = {0};
+    uint32_t rate = std::max(header.rate(), 1u);
+    set32(avih, static_cast<uint32_t>(1e6 * header.scale() / rate));  // dwMicroSecPerFrame
+    set32(avih + 12, AVIF_HASINDEX | AVIF_ISINTERLEAVED);
+    set32(avih + 24, 1);                                                // dwStreams
+    set32(avih + 32, header.width());
+    set32(avih + 36, header.height());
+    uint64_t chunk = beginChunk("avih");
+    avih_position = position;
+    put(avih, sizeof(avih));
+    endChunk(chunk);
+
+    uint64_t strl = beginList("LIST", "strl");
+    chunk = beginChunk("strh");
+    strh_position = position;
+    put(header.strh.data(), header.strh.size());
+    endChunk(chunk);
+    chunk = beginChunk("strf");
+    put(header.strf.data(), header.strf.size());
+    endChunk(chunk);
+    // Super index, filled when the file is closed
+    std::vector<uint8_t> indx(INDX_SIZE, 0);
+    set16(indx.data(), 4);                  // wLongsPerEntry
+    indx[3] = 0;                            // AVI_INDEX_OF_INDEXES
+    set32(indx.data() + 8, fourccOf("00dc"));
+    chunk = beginChunk("indx");
+    indx_position = position;
+    put(indx.data(), indx.size());
+    endChunk(chunk);
+    endChunk(strl);
+
+    uint64_t odml = beginList("LIST", "odml");
+    std::vector<uint8_t> dmlh(DMLH_SIZE, 0);
+    chunk = beginChunk("dmlh");
+    dmlh_position = position;
+    put(dmlh.data(), dmlh.size());
+    endChunk(chunk);
+    endChunk(odml);
+    endChunk(hdrl);
+
+    riff_position = riff_size_position - 4;
+    movi_size_position = beginList("LIST", "movi");
+    movi_position = movi_size_position + 4;
+    if (failed) close();
+    return !failed;
+}
+
+bool AviWriter::write(const uint8_t* data, uint32_t size, bool keyframe) {
+    if (!file.is_open() || failed) return false;
+    // Room for this frame and the indexes of the RIFF list, the idx1 index too in the first one
+    uint64_t nb_entries = riff_entries.size() + 1;
+    uint64_t indexes = 32 + 8 * nb_entries + (riff_indexes.empty() ? 8 + 16 * nb_entries : 0);
+    if (!riff_entries.empty() && position - riff_position + 8 + size + 1 + indexes > riff_max_size) {
+        if (riff_indexes.size() + 1 >= static_cast<size_t>(SUPER_INDEX_ENTRIES)) {
+            std::cout << "[Sample][Error] AVI file too large, at most " << SUPER_INDEX_ENTRIES << " RIFF lists" << std::endl;
+            failed = true;
+            return false;
+        }
+        endRiff();
+        startRiff();
+    }
+    uint64_t chunk = beginChunk("00dc");
+    Entry entry;
+    entry.offset = position;
+    entry.size = size;
+    entry.keyframe = keyframe;
+    if (size) put(data, size);
+    endChunk(chunk);
+    riff_entries.push_back(entry);
+    max_frame_size = std::max(max_frame_size, size);
+    nb_frames++;
+    return !failed;
+}
+
+bool AviWriter::close() {
+    if (!file.is_open()) return !failed;
+    endRiff();
+
+    // Frame counts: the first RIFF list for the AVI 1.0 readers, all the frames for the others
+    putAt32(avih_position + 16, static_cast<uint32_t>(first_riff_entries.size()));
+    putAt32(avih_position + 28, max_frame_size + 8);
+    putAt32(strh_position + 32, nb_frames);
+    putAt32(strh_position + 36, max_frame_size + 8);
+    putAt32(dmlh_position, nb_frames);
+    putAt32(indx_position + 4, static_cast<uint32_t>(riff_indexes.size()));
+    for (size_t i = 0; i < riff_indexes.size(); i++) {
+        uint64_t entry = indx_position + 24 + 16 * i;
+        putAt32(entry, static_cast<uint32_t>(riff_indexes[i].offset));
+        putAt32(entry + 4, static_cast<uint32_t>(riff_indexes[i].offset >> 32));
+        putAt32(entry + 8, riff_indexes[i].size);
+        putAt32(entry + 12, riff_indexes[i].nb_frames);
+    }
+    file.close();
+    if (file.fail()) failed = true;
+    return !failed;
+}
+
+void AviWriter::startRiff() {
+    riff_size_position = beginList("RIFF", "AVIX");
+    riff_position = riff_size_position - 4;
+    movi_size_position = beginList("LIST", "movi");
+    movi_position = movi_size_position + 4;
+}
+
+void AviWriter::endRiff() {
+    // Standard index of the frames of this RIFF list, at the end of its movi list
+    RiffIndex index;
+    index.offset = position;
+    index.nb_frames = static_cast<uint32_t>(riff_entries.size());
+    uint64_t chunk = beginChunk("ix00");
+    uint8_t ix[24] = {0};
+    set16(ix, 2);                               // wLongsPerEntry
+    ix[3] = 1;                                  // AVI_INDEX_OF_CHUNKS
+    set32(ix + 4, index.nb_frames);
+    set32(ix + 8, fourccOf("00dc"));
+    set32(ix + 12, static_cast<uint32_t>(riff_position));         // qwBaseOffset
+    set32(ix + 16, static_cast<uint32_t>(riff_position >> 32));
+    put(ix, sizeof(ix));
+    for (auto& entry : riff_entries) {
+        uint8_t bytes[8];
+        set32(bytes, static_cast<uint32_t>(entry.offset - riff_position));
+        set32(bytes + 4, entry.size | (entry.keyframe ? 0 : 0x80000000u));
+        put(bytes, sizeof(bytes));
+    }
+    endChunk(chunk);
+    index.size = static_cast<uint32_t>(position - index.offset);
+    riff_indexes.push_back(index);
+    endChunk(movi_size_position);
+
+    if (riff_indexes.size() == 1) {
+        // idx1 of the AVI 1.0 readers, offsets from the movi fourcc
+        chunk = beginChunk("idx1");
+        for (auto& entry : riff_entries) {
+            uint8_t bytes[16];
+            set32(bytes, fourccOf("00dc"));
+            set32(bytes + 4, entry.keyframe ? AVIIF_KEYFRAME : 0);
+            set32(bytes + 8, static_cast<uint32_t>(entry.offset - 8 - movi_position));
+            set32(bytes + 12, entry.size);
+            put(bytes, sizeof(bytes));
+        }
+        endChunk(chunk);
+        first_riff_entries = riff_entries;
+    }
+    endChunk(riff_size_position);
+    riff_entries.clear();
+}
+
+uint64_t AviWriter::beginChunk(const char* id) {
+    put(id, 4);
+    uint64_t size_position = position;
+    put32(0);
+    return size_position;
+}
+
+uint64_t AviWriter::beginList(const char* type, const char* list_type) {
+    uint64_t size_position = beginChunk(type);
+    put(list_type, 4);
+    return size_position;
+}
+
+void AviWriter::endChunk(uint64_t size_position) {
+    uint64_t size = position - size_position - 4;
+    putAt32(size_position, static_cast<uint32_t>(size));
+    if (size & 1) {
+        const uint8_t pad = 0;
+        put(&pad, 1);
+    }
+}
+
+void AviWriter::put(const void* data, size_t size) {
+    file.write(static_cast<const char*>(data), size);
+    position += size;
+    if (!file.good()) failed = true;
+}
+
+void AviWriter::put32(uint32_t value) {
+    uint8_t bytes[4];
+    set32(bytes, value);
+    put(bytes, sizeof(bytes));
+}
+
+void AviWriter::putAt32(uint64_t at, uint32_t value) {
+    uint8_t bytes[4];
+    set32(bytes, value);
+    file.seekp(static_cast<std::streamoff>(at));
+    file.write(reinterpret_cast<const char*>(bytes), sizeof(bytes));
+    file.seekp(static_cast<std::streamoff>(position));
+    if (!file.good()) failed = true;
+}
+
+int concatAviSegments(const std::vector<std::string>& segment_files, const std::string& output_path) {
+    if (segment_files.empty()) return -1;
+    std::vector<AviVideoStream> streams(segment_files.size());
+    for (size_t i = 0; i < segment_files.size(); i++)
+        if (!readAviVideoStream(segment_files[i], streams[i])) return -1;
+
+    const AviVideoStream& format = streams[0];
+    if (!isAviCodecSupported(format.fourcc())) {
+        std::cout << "[Sample][Error] Stream copy of the " << fourccText(format.fourcc()) << " codec is not supported" << std::endl;
+        return -1;
+    }
+    for (size_t i = 1; i < streams.size(); i++) {
+        if (streams[i].strf != format.strf || streams[i].scale() != format.scale() || streams[i].rate() != format.rate()) {
+            std::cout << "[Sample][Error] " << segment_files[i] << " is not in the format of " << segment_files[0] << std::endl;
+            return -1;
+        }
+    }
+
+    AviWriter writer;
+    if (!writer.open(output_path, format)) {
+        std::cout << "[Sample][Error] Cannot open " << output_path << std::endl;
+        return -1;
+    }
+    std::vector<uint8_t> data;
+    for (size_t i = 0; i < streams.size(); i++) {
+        std::ifstream segment(segment_files[i], std::ios::binary);
+        for (auto& frame : streams[i].frames) {
+            data.resize(frame.size);
+            segment.seekg(static_cast<std::streamoff>(frame.offset));
+            if (frame.size && !segment.read(reinterpret_cast<char*>(data.data()), frame.size)) {
+                std::cout << "[Sample][Error] Cannot read segment " << segment_files[i] << std::endl;
+                return -1;
+            }
+            if (!writer.write(data.data(), frame.size, isAviKeyFrame(format.fourcc(), data.data(), frame.size))) {
+                std::cout << "[Sample][Error] Cannot write " << output_path << std::endl;
+                return -1;
+            }
+        }
+    }
+    if (!writer.close()) {
+        std::cout << "[Sample][Error] Cannot write " << output_path << std::endl;
+        return -1;
+    }
+    return writer.getNbFrames();
+}
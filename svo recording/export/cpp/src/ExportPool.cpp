@@ -0,0 +1,224 @@
+#include "ExportPool.hpp"
+#include "PackKernels.hpp"
+#include "StageTrace.hpp"
+
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+ExportPool::ExportPool(EXPORT_OUTPUT output_, cv::Size image_size, int nb_workers_, int nb_buffers) : output(output_) {
+    nb_workers = nb_workers_;
+    if (nb_workers <= 0)
+        nb_workers = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    if (nb_buffers <= 0)
+        nb_buffers = 2 * nb_workers;
+
+    // All the buffers are allocated once, then recycled for the whole export
+    frames.resize(nb_buffers);
+    for (int i = 0; i < nb_buffers; i++) {
+        ExportFrame& f = frames[i];
+        f.slot = i;
+        f.left = cv::Mat(image_size, CV_8UC4);
+        if (output == EXPORT_OUTPUT::IMAGE_SEQUENCE_DEPTH_16 || output == EXPORT_OUTPUT::RAW_CONTAINER)
+            f.depth = cv::Mat(image_size, CV_32FC1);
+        else
+            f.right = cv::Mat(image_size, CV_8UC4);
+        if (output == EXPORT_OUTPUT::VIDEO)
+            f.side_by_side = cv::Mat(image_size.height, image_size.width * 2, CV_8UC3);
+        free_slots.push_back(i);
+    }
+}
+
+ExportPool::~ExportPool() {
+    finish();
+}
+
+void ExportPool::setImageSequence(std::string folder_, std::string right_prefix_, std::string extension_) {
+    folder = folder_;
+    right_prefix = right_prefix_;
+    extension = extension_;
+}
+
+void ExportPool::setVideoWriter(cv::VideoWriter* writer_) {
+    video_writer = writer_;
+}
+
+void ExportPool::setContainer(FrameContainerWriter* container_) {
+    container = container_;
+}
+
+void ExportPool::start() {
+    if (running) return;
+    running = true;
+    stopping = encoders_done = false;
+    start_time = std::chrono::steady_clock::now();
+    for (int i = 0; i < nb_workers; i++)
+        workers.emplace_back(&ExportPool::encoderLoop, this);
+    if (output == EXPORT_OUTPUT::VIDEO)
+        writer = std::thread(&ExportPool::writerLoop, this);
+}
+
+ExportFrame* ExportPool::acquire() {
+    std::unique_lock<std::mutex> lock(mtx);
+    free_cv.wait(lock, [this] { return !free_slots.empty() || stopping; });
+    if (free_slots.empty()) return nullptr;
+    int slot = free_slots.front();
+    free_slots.pop_front();
+    return &frames[slot];
+}
+
+void ExportPool::submit(ExportFrame* frame) {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        frame->sequence = next_sequence++;
+        jobs.push_back(frame->slot);
+    }
+    job_cv.notify_one();
+}
+
+void ExportPool::release(ExportFrame* frame) {
+    recycle(frame);
+}
+
+void ExportPool::recycle(ExportFrame* frame) {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        free_slots.push_back(frame->slot);
+    }
+    free_cv.notify_one();
+}
+
+void ExportPool::finish() {
+    if (!running) return;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        stopping = true;
+    }
+    // Workers drain the remaining jobs before leaving
+    job_cv.notify_all();
+    for (auto& w : workers) w.join();
+    workers.clear();
+    // Then the writer flushes what has been encoded
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        encoders_done = true;
+    }
+    done_cv.notify_all();
+    if (writer.joinable()) writer.join();
+    free_cv.notify_all();
+    running = false;
+}
+
+float ExportPool::getFPS() const {
+    if (!running && nb_written == 0) return 0.f;
+    float elapsed = std::chrono::duration<float>(std::chrono::steady_clock::now() - start_time).count();
+    return elapsed > 0.f ? nb_written / elapsed : 0.f;
+}
+
+void ExportPool::encoderLoop() {
+    StageTrace::nameThread("encoder");
+    // Per worker scratch buffers, avoid an allocation per frame for the 16 bit conversion and the compression
+    cv::Mat depth16;
+    std::vector<uint8_t> scratch;
+    while (true) {
+        int slot;
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            job_cv.wait(lock, [this] { return !jobs.empty() || stopping; });
+            if (jobs.empty()) return;
+            slot = jobs.front();
+            jobs.pop_front();
+        }
+
+        ExportFrame& frame = frames[slot];
+        encode(frame, depth16, scratch);
+
+        if (output == EXPORT_OUTPUT::VIDEO) {
+            // Hand over to the ordered writer
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                encoded[frame.sequence] = slot;
+            }
+            done_cv.notify_one();
+        } else {
+            nb_written++;
+            recycle(&frame);
+        }
+    }
+}
+
+void ExportPool::writerLoop() {
+    StageTrace::nameThread("writer");
+    while (true) {
+        int slot;
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            // Once every encoder has returned the map is complete, nothing else will arrive
+            done_cv.wait(lock, [this] { return encoded.count(next_to_write) || encoders_done; });
+            auto it = encoded.find(next_to_write);
+            if (it == encoded.end()) return;
+            slot = it->second;
+            encoded.erase(it);
+            next_to_write++;
+        }
+        StageSpan write_span("VideoWriter::write");
+        video_writer->write(frames[slot].side_by_side);
+        write_span.end();
+        nb_written++;
+        recycle(&frames[slot]);
+    }
+}
+
+void ExportPool::encode(ExportFrame& frame, cv::Mat& depth16, std::vector<uint8_t>& scratch) {
+    if (output == EXPORT_OUTPUT::VIDEO) {
+        // Single pass BGRA + BGRA -> side by side BGR, directly in the frame given to the video writer
+        STAGE_SPAN("packSideBySideBGR");
+        packSideBySideBGR(frame.left.data, frame.left.step, frame.right.data, frame.right.step,
+                frame.left.cols, frame.left.rows, frame.side_by_side.data, frame.side_by_side.step);
+        return;
+    }
+
+    if (output == EXPORT_OUTPUT::RAW_CONTAINER) {
+        STAGE_SPAN("writeFrame");
+        if (!container->writeFrame(frame.index, frame.timestamp, frame.left.data, frame.left.step,
+                reinterpret_cast<const float*>(frame.depth.data), frame.depth.step, scratch)) {
+            if (nb_errors++ == 0)
+                std::cout << "[Sample][Error] Cannot write frame " << frame.index << " in the container" << std::endl;
+        }
+        return;
+    }
+
+    std::ostringstream filename1;
+    filename1 << folder << "left" << std::setfill('0') << std::setw(6) << frame.index << extension;
+    write(filename1.str(), frame.left);
+
+    if (output == EXPORT_OUTPUT::IMAGE_SEQUENCE) {
+        std::ostringstream filename2;
+        filename2 << folder << right_prefix << std::setfill('0') << std::setw(6) << frame.index << extension;
+        write(filename2.str(), frame.right);
+    } else {
+        // Depth is in millimeters, convert to 16 bit (PNG is the only lossless option here)
+        std::ostringstream filename2;
+        filename2 << folder << right_prefix << std::setfill('0') << std::setw(6) << frame.index << ".png";
+        StageSpan convert_span("depth_to_u16");
+        frame.depth.convertTo(depth16, CV_16UC1);
+        convert_span.end();
+        write(filename2.str(), depth16);
+    }
+}
+
+bool ExportPool::write(const std::string& file, const cv::Mat& image) {
+    STAGE_SPAN("imwrite");
+    bool ok = false;
+    try {
+        ok = cv::imwrite(file, image);
+    } catch (const cv::Exception& e) {
+        std::cout << "[Sample][Error] " << e.what() << std::endl;
+    }
+    if (!ok) {
+        // Only report the first failure, the others are most probably the same
+        if (nb_errors++ == 0)
+            std::cout << "[Sample][Error] Cannot write " << file << std::endl;
+    }
+    return ok;
+}
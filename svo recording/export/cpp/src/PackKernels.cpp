@@ -0,0 +1,105 @@
+#include "PackKernels.hpp"
+
+#if defined(__aarch64__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define PACK_WITH_NEON 1
+#elif defined(__x86_64__) || defined(_M_X64) || defined(__i386__)
+#include <immintrin.h>
+#define PACK_WITH_AVX2 1
+#if defined(__GNUC__) || defined(__clang__)
+// The kernel is built for AVX2 on its own and selected at runtime, the rest of the sample keeps the default target
+#define PACK_AVX2_TARGET __attribute__((target("avx2")))
+#define PACK_AVX2_RUNTIME_CHECK 1
+#elif defined(__AVX2__)
+#define PACK_AVX2_TARGET
+#else
+#undef PACK_WITH_AVX2
+#endif
+#endif
+
+static void packRowScalar(const uint8_t* src, uint8_t* dst, int width) {
+    for (int x = 0; x < width; x++) {
+        dst[0] = src[0];
+        dst[1] = src[1];
+        dst[2] = src[2];
+        src += 4;
+        dst += 3;
+    }
+}
+
+#if PACK_WITH_AVX2
+PACK_AVX2_TARGET static void packRowAVX2(const uint8_t* src, uint8_t* dst, int width) {
+    // In each 128 bit lane: 4 BGRA pixels -> 12 BGR bytes, the last 4 bytes are dropped
+    const __m256i shuffle = _mm256_setr_epi8(
+            0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1,
+            0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+    // Then gather the 2 x 12 bytes in the low 24 bytes
+    const __m256i compact = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 7, 7);
+    int x = 0;
+    // Each iteration writes 32 bytes of which 24 are valid, stop early enough not to write past the row
+    for (; x + 11 <= width; x += 8) {
+        __m256i px = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + x * 4));
+        px = _mm256_shuffle_epi8(px, shuffle);
+        px = _mm256_permutevar8x32_epi32(px, compact);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + x * 3), px);
+    }
+    packRowScalar(src + x * 4, dst + x * 3, width - x);
+}
+#endif
+
+#if PACK_WITH_NEON
+static void packRowNEON(const uint8_t* src, uint8_t* dst, int width) {
+    int x = 0;
+    for (; x + 16 <= width; x += 16) {
+        uint8x16x4_t bgra = vld4q_u8(src + x * 4);
+        uint8x16x3_t bgr;
+        bgr.val[0] = bgra.val[0];
+        bgr.val[1] = bgra.val[1];
+        bgr.val[2] = bgra.val[2];
+        vst3q_u8(dst + x * 3, bgr);
+    }
+    packRowScalar(src + x * 4, dst + x * 3, width - x);
+}
+#endif
+
+typedef void (*PackRowFct)(const uint8_t*, uint8_t*, int);
+
+static PackRowFct selectPackRow(const char** name) {
+#if PACK_WITH_NEON
+    *name = "NEON";
+    return packRowNEON;
+#elif PACK_WITH_AVX2
+#if PACK_AVX2_RUNTIME_CHECK
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        *name = "AVX2";
+        return packRowAVX2;
+    }
+#else
+    *name = "AVX2";
+    return packRowAVX2;
+#endif
+#endif
+    *name = "scalar";
+    return packRowScalar;
+}
+
+static const char* pack_name = nullptr;
+static const PackRowFct pack_row = selectPackRow(&pack_name);
+
+void packRowBGR(const uint8_t* src, uint8_t* dst, int width) {
+    pack_row(src, dst, width);
+}
+
+void packSideBySideBGR(const uint8_t* left, size_t left_step, const uint8_t* right, size_t right_step,
+        int width, int height, uint8_t* dst, size_t dst_step) {
+    for (int y = 0; y < height; y++) {
+        uint8_t* row = dst + y * dst_step;
+        pack_row(left + y * left_step, row, width);
+        pack_row(right + y * right_step, row + width * 3, width);
+    }
+}
+
+const char* packKernelName() {
+    return pack_name;
+}
@@ -0,0 +1,147 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+/***********************************************************************
+ ** Read/write throughput of the raw frame container used by the      **
+ ** SVO export (mode 5), with synthetic frames. No camera needed.     **
+ ***********************************************************************/
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "FrameContainer.hpp"
+
+using namespace std;
+
+static double elapsedSince(chrono::steady_clock::time_point t0) {
+    return chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+}
+
+static void report(const string& name, int nb_frames, uint64_t bytes, double seconds) {
+    printf("%-24s %8.1f FPS %10.1f MB/s\n", name.c_str(), nb_frames / seconds, bytes / seconds / (1024. * 1024.));
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        cout << "Usage: \n";
+        cout << "$ ZED_SVO_Container_Bench <file.zraw> [nb_frames] [width] [height] [format]\n";
+        cout << "  format : f32 (default), u16, u16:<unit>, optionally followed by -lz4 or -zstd\n";
+        cout << "  The file is overwritten.\n";
+        return EXIT_FAILURE;
+    }
+
+    string path(argv[1]);
+    int nb_frames = argc > 2 ? atoi(argv[2]) : 300;
+    ContainerParameters params;
+    params.width = argc > 3 ? atoi(argv[3]) : 1280;
+    params.height = argc > 4 ? atoi(argv[4]) : 720;
+    if (argc > 5 && !parseContainerFormat(argv[5], params)) {
+        cout << "Invalid or unavailable format " << argv[5] << endl;
+        return EXIT_FAILURE;
+    }
+
+    // Synthetic frames: a smooth gradient with some noise, closer to real data than random bytes for the compression
+    const int nb_sources = 8;
+    size_t pixels = (size_t) params.width * params.height;
+    vector<vector<uint8_t>> images(nb_sources, vector<uint8_t>(pixels * 4));
+    vector<vector<float>> depths(nb_sources, vector<float>(pixels));
+    mt19937 rng(42);
+    uniform_int_distribution<int> noise(0, 7);
+    for (int s = 0; s < nb_sources; s++) {
+        for (size_t i = 0; i < pixels; i++) {
+            size_t x = i % params.width, y = i / params.width;
+            for (int c = 0; c < 3; c++)
+                images[s][i * 4 + c] = (uint8_t) ((x + y * c + s * 16 + noise(rng)) & 0xFF);
+            images[s][i * 4 + 3] = 255;
+            depths[s][i] = (i % 97 == 0) ? NAN : 500.f + 10.f * y + x * 0.5f + s;
+        }
+    }
+
+    // Write
+    FrameContainerWriter writer;
+    auto t0 = chrono::steady_clock::now();
+    if (!writer.create(path, params, nb_frames)) {
+        cout << "Cannot create " << path << endl;
+        return EXIT_FAILURE;
+    }
+    double allocation_time = elapsedSince(t0);
+    vector<uint8_t> scratch;
+    t0 = chrono::steady_clock::now();
+    for (int i = 0; i < nb_frames; i++) {
+        int s = i % nb_sources;
+        writer.writeFrame(i, 1000000ULL * (i + 1), images[s].data(), params.width * 4, depths[s].data(), params.width * sizeof(float), scratch);
+    }
+    uint64_t raw_bytes = writer.getHeader().image_bytes + writer.getHeader().depth_bytes;
+    writer.close();
+    double write_time = elapsedSince(t0);
+
+    // Read
+    FrameContainerReader reader;
+    if (!reader.open(path)) {
+        cout << "Cannot open " << path << endl;
+        return EXIT_FAILURE;
+    }
+    const ContainerHeader& header = reader.getHeader();
+    int nb_read = (int) reader.getNbFrames();
+
+    uint64_t checksum = 0;
+    t0 = chrono::steady_clock::now();
+    if (header.compression == FRAME_COMPRESSION::NONE) {
+        // Zero-copy: touch one value per cache line directly in the mapping
+        for (int i = 0; i < nb_read; i++) {
+            const uint8_t* img = reader.image(i);
+            const uint8_t* dep = (const uint8_t*) reader.depth(i);
+            for (uint64_t b = 0; b < header.image_bytes; b += 64) checksum += img[b];
+            for (uint64_t b = 0; b < header.depth_bytes; b += 64) checksum += dep[b];
+        }
+    } else {
+        vector<uint8_t> image_out(header.image_bytes), depth_out(header.depth_bytes);
+        for (int i = 0; i < nb_read; i++) {
+            reader.decode(i, image_out.data(), depth_out.data());
+            checksum += image_out[i % header.image_bytes];
+        }
+    }
+    double read_time = elapsedSince(t0);
+
+    // Random access by timestamp
+    uniform_int_distribution<int> pick(0, max(0, nb_read - 1));
+    int nb_lookups = 100000, nb_found = 0;
+    t0 = chrono::steady_clock::now();
+    for (int i = 0; i < nb_lookups; i++) {
+        uint64_t ts = 1000000ULL * (pick(rng) + 1);
+        nb_found += reader.getEntry(reader.findTimestamp(ts) % max(1, nb_read)).timestamp == ts;
+    }
+    double lookup_time = elapsedSince(t0);
+
+    cout << "Container " << path << " : " << nb_read << " frames " << params.width << "x" << params.height
+         << ", stride " << header.frame_stride / 1024 << " KB, allocated in " << allocation_time * 1000. << " ms" << endl;
+    report("write", nb_frames, raw_bytes * nb_frames, write_time);
+    report(header.compression == FRAME_COMPRESSION::NONE ? "read (zero-copy)" : "read (decode)", nb_read, raw_bytes * nb_read, read_time);
+    printf("%-24s %8.3f us/lookup (%d/%d found)\n", "timestamp lookup", lookup_time * 1e6 / nb_lookups, nb_found, nb_lookups);
+    if (checksum == 0) cout << "(empty container)" << endl;
+
+    reader.close();
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,101 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+/***********************************************************************
+ ** Conversions of the export, per frame and on synthetic frames:     **
+ ** side by side BGR packing of the AVI export (fused kernel versus   **
+ ** the two cv::cvtColor calls it replaces), 16 bit depth and PNG     **
+ ** encoding of the image sequences, at the ZED resolutions.          **
+ ***********************************************************************/
+
+#include <cmath>
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+#include "BenchSuite.hpp"
+#include "PackKernels.hpp"
+
+using namespace std;
+
+int main(int argc, char **argv) {
+    BenchSuite suite("ZED_SVO_Export_Bench");
+    suite.setContext("pack_kernel", packKernelName());
+    suite.setContext("opencv", CV_VERSION);
+
+    struct { const char* name; int width, height; } resolutions[] = {
+        {"HD720", 1280, 720}, {"HD1080", 1920, 1080}, {"HD2K", 2208, 1242}
+    };
+
+    // Single threaded, the export runs one conversion per encoder thread
+    cv::setNumThreads(1);
+
+    struct Frames {
+        cv::Mat left, right, reference, packed, depth, depth16;
+        vector<uchar> png;
+    };
+    // The lambdas of the suite keep references to the frames
+    vector<Frames> frames(sizeof(resolutions) / sizeof(resolutions[0]));
+
+    for (size_t r = 0; r < frames.size(); r++) {
+        auto& res = resolutions[r];
+        auto& f = frames[r];
+        f.left.create(res.height, res.width, CV_8UC4);
+        f.right.create(res.height, res.width, CV_8UC4);
+        cv::randu(f.left, cv::Scalar::all(0), cv::Scalar::all(255));
+        cv::randu(f.right, cv::Scalar::all(0), cv::Scalar::all(255));
+        f.reference.create(res.height, res.width * 2, CV_8UC3);
+        f.packed.create(res.height, res.width * 2, CV_8UC3);
+        // Depth in millimeters, 0.3 to 20 m, with the invalid values of the camera
+        f.depth.create(res.height, res.width, CV_32FC1);
+        cv::randu(f.depth, cv::Scalar(300.f), cv::Scalar(20000.f));
+        for (int y = 0; y < res.height; y += 7) f.depth.at<float>(y, (y * 13) % res.width) = NAN;
+        f.depth.convertTo(f.depth16, CV_16UC1);
+
+        cv::Rect left_roi(0, 0, res.width, res.height), right_roi(res.width, 0, res.width, res.height);
+        cv::cvtColor(f.left, f.reference(left_roi), cv::COLOR_BGRA2BGR);
+        cv::cvtColor(f.right, f.reference(right_roi), cv::COLOR_BGRA2BGR);
+        packSideBySideBGR(f.left.data, f.left.step, f.right.data, f.right.step, res.width, res.height, f.packed.data, f.packed.step);
+        suite.check(cv::norm(f.reference, f.packed, cv::NORM_INF) == 0, string("side by side packing differs from cv::cvtColor at ") + res.name);
+
+        double frame_bytes = 2. * res.width * res.height * 4;
+        string name = res.name;
+        suite.add("pack_side_by_side/cvtColor/" + name, [&f, left_roi, right_roi]() {
+            cv::cvtColor(f.left, f.reference(left_roi), cv::COLOR_BGRA2BGR);
+            cv::cvtColor(f.right, f.reference(right_roi), cv::COLOR_BGRA2BGR);
+        }).bytes(frame_bytes);
+        suite.add("pack_side_by_side/fused/" + name, [&f]() {
+            packSideBySideBGR(f.left.data, f.left.step, f.right.data, f.right.step, f.left.cols, f.left.rows, f.packed.data, f.packed.step);
+        }).bytes(frame_bytes);
+        suite.add("depth_to_u16/" + name, [&f]() {
+            f.depth.convertTo(f.depth16, CV_16UC1);
+        }).bytes(res.width * res.height * 4.);
+    }
+
+    // PNG encoding of the image sequences (modes 2 to 4), the main cost of these modes before the disk
+    auto& hd720 = frames[0];
+    suite.add("png_encode/left/HD720", [&hd720]() {
+        cv::imencode(".png", hd720.left, hd720.png);
+    }).items(1);
+    suite.add("png_encode/depth16/HD720", [&hd720]() {
+        cv::imencode(".png", hd720.depth16, hd720.png);
+    }).items(1);
+
+    return suite.run(argc, argv);
+}
@@ -0,0 +1,181 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+/*****************************************************************************************
+ ** Check of the parallel segments of the export, CPU only: no ZED SDK, OpenCV nor SVO.  **
+ ** The SVO is split in segments, the segment file names are checked, then segment AVI   **
+ ** files of synthetic frames are concatenated by stream copy and read back.             **
+ *****************************************************************************************/
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "AviConcat.hpp"
+#include "SegmentPlanner.hpp"
+
+using namespace std;
+
+static bool check(bool condition, const string& what) {
+    printf("  %-60s %s\n", what.c_str(), condition ? "ok" : "FAILED");
+    return condition;
+}
+
+static uint32_t fourcc(const char* text) {
+    return text[0] | (text[1] << 8) | (text[2] << 16) | (static_cast<uint32_t>(text[3]) << 24);
+}
+
+// Synthetic encoded frame: its index in the first bytes, odd sizes included for the chunk padding.
+// MPEG-4 frames start with a VOP header, an I-VOP every 10 frames
+static vector<uint8_t> makeFrame(int index, bool mpeg4) {
+    vector<uint8_t> frame(100 + (index * 37) % 501);
+    for (size_t i = 0; i < frame.size(); i++) frame[i] = static_cast<uint8_t>(index * 7 + i);
+    if (mpeg4) {
+        const uint8_t vop[] = {0, 0, 1, 0xB6, static_cast<uint8_t>(index % 10 == 0 ? 0x10 : 0x50)};
+        copy(begin(vop), end(vop), frame.begin());
+    }
+    return frame;
+}
+
+static bool writeSegment(const string& path, const AviVideoStream& format, int first, int count, bool mpeg4, uint64_t riff_size = 1ull << 30) {
+    AviWriter writer(riff_size);
+    if (!writer.open(path, format)) return false;
+    for (int i = first; i < first + count; i++) {
+        auto frame = makeFrame(i, mpeg4);
+        if (!writer.write(frame.data(), static_cast<uint32_t>(frame.size()), isAviKeyFrame(format.fourcc(), frame.data(), frame.size()))) return false;
+    }
+    return writer.close() && writer.getNbFrames() == count;
+}
+
+// Frames [first, first + count) of the synthetic stream, in order
+static bool readBack(const string& path, int first, int count, bool mpeg4) {
+    AviVideoStream stream;
+    if (!readAviVideoStream(path, stream) || static_cast<int>(stream.frames.size()) != count) return false;
+    ifstream file(path, ios::binary);
+    for (int i = 0; i < count; i++) {
+        auto expected = makeFrame(first + i, mpeg4);
+        auto& frame = stream.frames[i];
+        if (frame.size != expected.size()) return false;
+        vector<uint8_t> data(frame.size);
+        file.seekg(static_cast<streamoff>(frame.offset));
+        if (!file.read(reinterpret_cast<char*>(data.data()), data.size()) || data != expected) return false;
+    }
+    return true;
+}
+
+int main(int argc, char **) {
+    if (argc > 1) {
+        printf("Usage : ./ZED_SVO_Export_Check\n");
+        return EXIT_FAILURE;
+    }
+    bool ok = true;
+
+    printf("Segments\n");
+    {
+        auto segments = planSegments(10, 3);
+        ok &= check(segments.size() == 3 && segments[0].start == 0 && segments[0].end == 4 && segments[1].start == 4 && segments[1].end == 7
+            && segments[2].start == 7 && segments[2].end == 10, "10 frames in 3 segments: 4, 3, 3");
+        bool contiguous = true;
+        int total = 0;
+        segments = planSegments(1001, 7);
+        for (size_t i = 0; i < segments.size(); i++) {
+            contiguous &= segments[i].id == static_cast<int>(i) && segments[i].start == total && segments[i].size() > 0;
+            total = segments[i].end;
+        }
+        ok &= check(segments.size() == 7 && contiguous && total == 1001, "contiguous segments cover all the frames");
+        ok &= check(planSegments(3, 8).size() == 3, "never more segments than frames");
+        ok &= check(planSegments(0, 4).empty() && planSegments(-5, 4).empty(), "no segment without frames");
+        ok &= check(planSegments(5, 0).size() == 1 && planSegments(5, -2).size() == 1, "at least one segment");
+        ExportSegment segment{1, 4, 7};
+        ok &= check(!segment.contains(3) && segment.contains(4) && segment.contains(6) && !segment.contains(7), "segment bounds, end excluded");
+    }
+
+    printf("Segment file names\n");
+    {
+        ok &= check(segmentFileName("path/file.avi", 2) == "path/file_part2.avi", "extension kept");
+        ok &= check(segmentFileName("path/file", 0) == "path/file_part0", "without extension");
+        ok &= check(segmentFileName("path.d/file", 1) == "path.d/file_part1", "dot in a directory name");
+        ok &= check(segmentFileName("C:\\videos.d\\file.avi", 3) == "C:\\videos.d\\file_part3.avi", "Windows path");
+    }
+
+    printf("Key frames\n");
+    {
+        auto i_vop = makeFrame(0, true), p_vop = makeFrame(1, true);
+        ok &= check(isAviKeyFrame(fourcc("M4S2"), i_vop.data(), i_vop.size()) && !isAviKeyFrame(fourcc("M4S2"), p_vop.data(), p_vop.size()),
+            "MPEG-4 part 2: I-VOP only");
+        vector<uint8_t> vol = {0, 0, 1, 0x20, 0x12, 0x34, 0, 0, 1, 0xB6, 0x00};
+        ok &= check(isAviKeyFrame(fourcc("FMP4"), vol.data(), vol.size()), "MPEG-4 part 2: I-VOP after the VOL header");
+        ok &= check(isAviKeyFrame(fourcc("MJPG"), p_vop.data(), p_vop.size()) && !isAviKeyFrame(fourcc("MJPG"), nullptr, 0), "MJPG: every frame but the empty ones");
+        ok &= check(!isAviCodecSupported(fourcc("H264")), "codec not known: no stream copy");
+    }
+
+    printf("Concatenation\n");
+    {
+        const int counts[] = {25, 13, 31};
+        for (bool mpeg4 : {false, true}) {
+            string codec = mpeg4 ? "M4S2" : "MJPG";
+            AviVideoStream format = AviVideoStream::make(fourcc(codec.c_str()), 2560, 720, 30);
+            vector<string> files;
+            bool written = true;
+            int first = 0;
+            for (size_t i = 0; i < 3; i++) {
+                files.push_back(segmentFileName("export_check.avi", static_cast<int>(i)));
+                // The middle segment is split in several RIFF lists, as a segment of more than 1 GB
+                written &= writeSegment(files.back(), format, first, counts[i], mpeg4, i == 1 ? 4096 : 1ull << 30);
+                first += counts[i];
+            }
+            ok &= check(written && readBack(files[0], 0, counts[0], mpeg4), codec + ": segment written and read back");
+            ok &= check(readBack(files[1], counts[0], counts[1], mpeg4), codec + ": segment of several RIFF lists read back");
+
+            int nb_merged = concatAviSegments(files, "export_check.avi");
+            ok &= check(nb_merged == first, codec + ": every frame concatenated");
+            ok &= check(readBack("export_check.avi", 0, first, mpeg4), codec + ": frames copied in order, unchanged");
+            AviVideoStream merged;
+            ok &= check(readAviVideoStream("export_check.avi", merged) && merged.strf == format.strf && merged.rate() == 30
+                && merged.width() == 2560 && merged.height() == 720, codec + ": format of the segments kept");
+            for (auto& file : files) remove(file.c_str());
+        }
+        remove("export_check.avi");
+
+        // Segments of different formats are not concatenated
+        vector<string> files = {"export_check_a.avi", "export_check_b.avi"};
+        bool written = writeSegment(files[0], AviVideoStream::make(fourcc("MJPG"), 1280, 720, 30), 0, 5, false)
+            && writeSegment(files[1], AviVideoStream::make(fourcc("MJPG"), 1280, 720, 15), 5, 5, false);
+        ok &= check(written && concatAviSegments(files, "export_check.avi") == -1, "segments of different frame rates rejected");
+        ok &= check(concatAviSegments({"export_check_missing.avi"}, "export_check.avi") == -1, "missing segment rejected");
+        {
+            // First half of a segment, as written by an interrupted export
+            ifstream in(files[0], ios::binary | ios::ate);
+            vector<char> data(static_cast<size_t>(in.tellg()) / 2 + 3);
+            in.seekg(0);
+            in.read(data.data(), data.size());
+            ofstream(files[1], ios::binary | ios::trunc).write(data.data(), data.size());
+        }
+        AviVideoStream stream;
+        ok &= check(!readAviVideoStream(files[1], stream), "truncated AVI file rejected");
+        for (auto& file : files) remove(file.c_str());
+        remove("export_check.avi");
+    }
+
+    printf(ok ? "PASSED\n" : "FAILED\n");
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -29,8 +29,17 @@
 // Sample includes
 #include <iostream>
 #include <sstream>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
 #include <opencv2/opencv.hpp>
 #include "utils.hpp"
+#include "ExportPool.hpp"
+#include "MatBridge.hpp"
+#include "AviConcat.hpp"
+#include "SegmentPlanner.hpp"
+#include "StageTrace.hpp"
 
 // Using namespace
 using namespace sl;
@@ -39,16 +48,28 @@ using namespace std;
 enum APP_TYPE {
     LEFT_AND_RIGHT,
     LEFT_AND_DEPTH,
-    LEFT_AND_DEPTH_16
+    LEFT_AND_DEPTH_16,
+    LEFT_AND_DEPTH_RAW
+};
+
+// sl::Mat sharing the memory of each ExportPool buffer, so that no copy is needed before the encoding
+struct PoolBuffers {
+    vector<Mat> left, right, depth;
 };
 
 void print(string msg_prefix, ERROR_CODE err_code = ERROR_CODE::SUCCESS, string msg_suffix = "");
+PoolBuffers wrapPoolBuffers(ExportPool& pool, APP_TYPE app_type);
+bool exportSegment(Camera& zed, ExportSegment segment, APP_TYPE app_type, ExportPool& pool, PoolBuffers& buffers, atomic<int>& nb_grabbed);
 
 int main(int argc, char **argv) {
 
-    if (argc != 4) {
+    // --trace <file.json>, --trace-stats: spans of the grab, encoder and writer threads
+    StageTrace trace;
+    if (!trace.parse(argc, argv)) return EXIT_FAILURE;
+
+    if (argc < 4 || argc > 7) {
         cout << "Usage: \n\n";
-        cout << "    ZED_SVO_Export A B C \n\n";
+        cout << "    ZED_SVO_Export A B C [D] [E] [F] " << StageTrace::usage() << "\n\n";
         cout << "Please use the following parameters from the command line:\n";
         cout << " A - SVO file path (input) : \"path/to/file.svo\"\n";
         cout << " B - AVI file path (output) or image sequence folder(output) : \"path/to/output/file.avi\" or \"path/to/output/folder\"\n";
@@ -57,6 +78,11 @@ int main(int argc, char **argv) {
         cout << "                   2=Export LEFT+RIGHT image sequence.\n";
         cout << "                   3=Export LEFT+DEPTH_VIEW image sequence.\n";
         cout << "                   4=Export LEFT+DEPTH_16Bit image sequence.\n";
+        cout << "                   5=Export LEFT+DEPTH raw container (single memory mapped file).\n";
+        cout << " D - (optional) Number of encoder threads, 0 = all cores (default)\n";
+        cout << " E - (optional) Image sequence format: png (default) or jpg. 16Bit depth is always png\n";
+        cout << "                Raw container depth format: f32 (default), u16 or u16:<unit in mm>, optionally followed by -lz4 or -zstd\n";
+        cout << " F - (optional) Number of SVO segments decoded in parallel, each by its own camera instance (default 1)\n";
         cout << " A and B need to end with '/' or '\\'\n\n";
         cout << "Examples: \n";
         cout << "  (AVI LEFT+RIGHT)   ZED_SVO_Export \"path/to/file.svo\" \"path/to/output/file.avi\" 0\n";
@@ -64,6 +90,9 @@ int main(int argc, char **argv) {
         cout << "  (SEQUENCE LEFT+RIGHT)   ZED_SVO_Export \"path/to/file.svo\" \"path/to/output/folder\" 2\n";
         cout << "  (SEQUENCE LEFT+DEPTH)   ZED_SVO_Export \"path/to/file.svo\" \"path/to/output/folder\" 3\n";
         cout << "  (SEQUENCE LEFT+DEPTH_16Bit)   ZED_SVO_Export \"path/to/file.svo\" \"path/to/output/folder\" 4\n";
+        cout << "  (SEQUENCE LEFT+RIGHT, 8 threads, jpg)   ZED_SVO_Export \"path/to/file.svo\" \"path/to/output/folder\" 2 8 jpg\n";
+        cout << "  (RAW LEFT+DEPTH, uint16 in 0.5mm, LZ4)   ZED_SVO_Export \"path/to/file.svo\" \"path/to/output/file.zraw\" 5 0 u16:0.5-lz4\n";
+        cout << "  (AVI LEFT+RIGHT, 4 segments)   ZED_SVO_Export \"path/to/file.svo\" \"path/to/output/file.avi\" 0 0 png 4\n";
         cout << "\nPress [Enter] to continue";
         cin.ignore();
         return 1;
@@ -78,148 +107,305 @@ int main(int argc, char **argv) {
         app_type = LEFT_AND_DEPTH;
     if (!strcmp(argv[3], "4"))
         app_type = LEFT_AND_DEPTH_16;
+    if (!strcmp(argv[3], "5"))
+        app_type = LEFT_AND_DEPTH_RAW;
+    bool output_as_container = (app_type == LEFT_AND_DEPTH_RAW);
 
     // Check if exporting to AVI or SEQUENCE
     if (strcmp(argv[3], "0") && strcmp(argv[3], "1"))
         output_as_video = false;
 
-    if (!output_as_video && !directoryExists(output_path)) {
+    int nb_encoders = (argc > 4) ? atoi(argv[4]) : 0;
+    string image_extension = ".png";
+    if (argc > 5 && (!strcmp(argv[5], "jpg") || !strcmp(argv[5], "jpeg")))
+        image_extension = ".jpg";
+    ContainerParameters container_params;
+    if (output_as_container && argc > 5 && !parseContainerFormat(argv[5], container_params)) {
+        print("Error: invalid or unavailable raw container format " + string(argv[5]));
+        return EXIT_FAILURE;
+    }
+    int nb_segments = (argc > 6) ? max(1, atoi(argv[6])) : 1;
+    if (nb_encoders <= 0)
+        nb_encoders = max(1, (int) thread::hardware_concurrency());
+
+    if (!output_as_video && !output_as_container && !directoryExists(output_path)) {
         print("Input directory doesn't exist. Check permissions or create it." + output_path);
         return EXIT_FAILURE;
     }
 
-    if (!output_as_video && output_path.back() != '/' && output_path.back() != '\\') {
+    if (!output_as_video && !output_as_container && output_path.back() != '/' && output_path.back() != '\\') {
         print("Error: output folder needs to end with '/' or '\\'."+output_path);
         return EXIT_FAILURE;
     }
 
-    // Create ZED objects
-    Camera zed;
-
     // Specify SVO path parameter
     InitParameters init_parameters;
     init_parameters.input.setFromSVOFile(svo_input_path.c_str());
     init_parameters.coordinate_units = UNIT::MILLIMETER;
 
-    // Open the camera
-    ERROR_CODE zed_open_state = zed.open(init_parameters);
+    // The first camera gives the SVO properties and exports the first segment
+    vector<unique_ptr<Camera>> cameras;
+    cameras.emplace_back(new Camera());
+    ERROR_CODE zed_open_state = cameras[0]->open(init_parameters);
     if (zed_open_state != ERROR_CODE::SUCCESS) {
         print("Camera Open", zed_open_state, "Exit program.");
         return EXIT_FAILURE;
     }
 
     // Get image size
-    Resolution image_size = zed.getCameraInformation().camera_configuration.resolution;
-
-    Mat left_image(image_size, MAT_TYPE::U8_C4);
-    cv::Mat left_image_ocv = slMat2cvMat(left_image);
-
-    Mat right_image(image_size, MAT_TYPE::U8_C4);
-    cv::Mat right_image_ocv = slMat2cvMat(right_image);
-
-    Mat depth_image(image_size, MAT_TYPE::F32_C1);
-    cv::Mat depth_image_ocv = slMat2cvMat(depth_image);
+    Resolution image_size = cameras[0]->getCameraInformation().camera_configuration.resolution;
+    int nb_frames = cameras[0]->getSVONumberOfFrames();
+    int frame_rate = fmax(cameras[0]->getInitParameters().camera_fps, 25); // Minimum write rate in OpenCV is 25
+
+    // Split the SVO in ranges, each one decoded by its own camera instance opened on the same file
+    vector<ExportSegment> segments = planSegments(nb_frames, nb_segments);
+    if (segments.empty()) segments.push_back(ExportSegment{0, 0, nb_frames});
+    for (size_t i = 1; i < segments.size(); i++) {
+        cameras.emplace_back(new Camera());
+        zed_open_state = cameras[i]->open(init_parameters);
+        if (zed_open_state != ERROR_CODE::SUCCESS) {
+            print("Camera Open (segment " + to_string(i) + ")", zed_open_state, "Use fewer segments.");
+            for (auto& zed : cameras) zed->close();
+            return EXIT_FAILURE;
+        }
+    }
 
-    cv::Mat image_sideByside;
-    if(output_as_video)
-        image_sideByside = cv::Mat(image_size.height, image_size.width *2, CV_8UC3);
+    // The encoding is spread over a pool of threads, frames are retrieved directly into its recycled buffers.
+    // Image sequences share a single pool since the file names come from the SVO position.
+    // Videos need one ordered writer per segment, each segment is written in its own file and concatenated at the end.
+    EXPORT_OUTPUT output = EXPORT_OUTPUT::VIDEO;
+    if (output_as_container)
+        output = EXPORT_OUTPUT::RAW_CONTAINER;
+    else if (!output_as_video)
+        output = (app_type == LEFT_AND_DEPTH_16) ? EXPORT_OUTPUT::IMAGE_SEQUENCE_DEPTH_16 : EXPORT_OUTPUT::IMAGE_SEQUENCE;
+    int nb_pools = output_as_video ? segments.size() : 1;
+    int nb_pool_workers = max(1, nb_encoders / nb_pools);
+    // Videos are written directly to the output path when there is a single segment
+    bool merge_segments = output_as_video && segments.size() > 1;
 
-    // Create video writer
-    cv::VideoWriter video_writer;
-    if (output_as_video) {
 #if (defined(CV_VERSION_EPOCH) && CV_VERSION_EPOCH == 2)
-        int fourcc = CV_FOURCC('M','J','P','G');
+    int fourcc = CV_FOURCC('M','J','P','G');
 #else
-        int fourcc = cv::VideoWriter::fourcc('M', '4', 'S', '2'); // MPEG-4 part 2 codec
+    int fourcc = cv::VideoWriter::fourcc('M', '4', 'S', '2'); // MPEG-4 part 2 codec
 #endif
-        int frame_rate = fmax(zed.getInitParameters().camera_fps, 25); // Minimum write rate in OpenCV is 25
-        video_writer.open(output_path, fourcc, frame_rate, cv::Size(image_size.width*2, image_size.height));
-        if (!video_writer.isOpened()) {
-            print("Error: OpenCV video writer cannot be opened. Please check the .avi file path and write permissions.");
-            zed.close();
+    cv::Size video_size(image_size.width * 2, image_size.height);
+
+    // The raw container is allocated once for the whole SVO, each frame is written in the slot of its SVO position
+    FrameContainerWriter container;
+    if (output_as_container) {
+        container_params.width = image_size.width;
+        container_params.height = image_size.height;
+        if (!container.create(output_path, container_params, max(nb_frames, 1))) {
+            print("Error: raw container cannot be created. Please check the file path, write permissions and free space.");
+            for (auto& zed : cameras) zed->close();
             return EXIT_FAILURE;
         }
     }
 
-    RuntimeParameters rt_param;
-    rt_param.sensing_mode = SENSING_MODE::FILL;
+    vector<unique_ptr<ExportPool>> pools;
+    vector<PoolBuffers> pool_buffers;
+    vector<cv::VideoWriter> video_writers(nb_pools);
+    vector<string> segment_files;
+    for (int i = 0; i < nb_pools; i++) {
+        pools.emplace_back(new ExportPool(output, cv::Size(image_size.width, image_size.height), nb_pool_workers));
+        pool_buffers.push_back(wrapPoolBuffers(*pools[i], app_type));
+
+        if (output_as_video) {
+            // Create video writer
+            string video_path = merge_segments ? segmentFileName(output_path, i) : output_path;
+            video_writers[i].open(video_path, fourcc, frame_rate, video_size);
+            if (!video_writers[i].isOpened()) {
+                print("Error: OpenCV video writer cannot be opened. Please check the .avi file path and write permissions.");
+                for (auto& zed : cameras) zed->close();
+                return EXIT_FAILURE;
+            }
+            pools[i]->setVideoWriter(&video_writers[i]);
+            segment_files.push_back(video_path);
+        } else if (output_as_container) {
+            pools[i]->setContainer(&container);
+        } else {
+            pools[i]->setImageSequence(output_path, (app_type == LEFT_AND_RIGHT ? "right" : "depth"), image_extension);
+        }
+    }
 
     // Start SVO conversion to AVI/SEQUENCE
-    print("Converting SVO... Use Ctrl-C to interrupt conversion.");
-
-    int nb_frames = zed.getSVONumberOfFrames();
-    int svo_position = 0;
-    zed.setSVOPosition(svo_position);
+    print("Converting SVO with " + to_string(segments.size()) + " segment(s) and " + to_string(nb_pools * nb_pool_workers) + " encoder threads... Use Ctrl-C to interrupt conversion.");
 
     SetCtrlHandler();
+    for (auto& pool : pools) pool->start();
+
+    auto start_time = chrono::steady_clock::now();
+    atomic<int> nb_grabbed(0);
+    atomic<int> nb_running((int) segments.size());
+    vector<char> segment_ok(segments.size(), 0);
+    vector<thread> segment_threads;
+    for (size_t i = 0; i < segments.size(); i++) {
+        int p = output_as_video ? i : 0;
+        segment_threads.emplace_back([&, i, p]() {
+            StageTrace::nameThread("segment " + to_string(i));
+            segment_ok[i] = exportSegment(*cameras[i], segments[i], app_type, *pools[p], pool_buffers[p], nb_grabbed);
+            nb_running--;
+        });
+    }
+
+    // Display progress
+    while (nb_running > 0) {
+        int nb_written = 0;
+        for (auto& pool : pools) nb_written += pool->getNbWritten();
+        float elapsed = chrono::duration<float>(chrono::steady_clock::now() - start_time).count();
+        ProgressBar(nb_grabbed / (float) max(1, nb_frames), 30, elapsed > 0.f ? nb_written / elapsed : 0.f);
+        this_thread::sleep_for(chrono::milliseconds(100));
+    }
+    for (auto& t : segment_threads) t.join();
+
+    // Wait for the pending frames to be written
+    int nb_written = 0, nb_errors = 0;
+    for (auto& pool : pools) {
+        pool->finish();
+        nb_written += pool->getNbWritten();
+        nb_errors += pool->getNbErrors();
+    }
+    float elapsed = chrono::duration<float>(chrono::steady_clock::now() - start_time).count();
+    print("Exported " + to_string(nb_written) + " frames in " + to_string(elapsed) + "s, " + to_string(nb_written / max(elapsed, 1e-3f)) + " FPS");
+    if (nb_errors)
+        print("[Warning] " + to_string(nb_errors) + " files could not be written");
+
+    // Release the sl::Mat wrappers before the buffers they point to
+    pool_buffers.clear();
+
+    bool success = find(segment_ok.begin(), segment_ok.end(), 0) == segment_ok.end();
+    if (output_as_container)
+        container.close();
+    if (output_as_video) {
+        // Close the video writers
+        for (auto& writer : video_writers) writer.release();
+
+        if (merge_segments) {
+            if (success && !exit_app) {
+                print("Concatenating " + to_string(segment_files.size()) + " segments into " + output_path);
+                // Stream copy of the encoded frames, no second encoding
+                int nb_merged = concatAviSegments(segment_files, output_path);
+                if (nb_merged == nb_written) {
+                    for (auto& file : segment_files) remove(file.c_str());
+                } else {
+                    print("Error: segment concatenation failed, the segment files are kept.");
+                    success = false;
+                }
+            } else
+                print("Export interrupted, the segment files are kept.");
+        }
+    }
+
+    for (auto& zed : cameras) zed->close();
+    trace.finish();
+    return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+PoolBuffers wrapPoolBuffers(ExportPool& pool, APP_TYPE app_type) {
+    PoolBuffers buffers;
+    int nb_buffers = pool.getNbBuffers();
+    buffers.left.resize(nb_buffers);
+    buffers.right.resize(nb_buffers);
+    buffers.depth.resize(nb_buffers);
+    for (int i = 0; i < nb_buffers; i++) {
+        ExportFrame& buffer = pool.getBuffer(i);
+        buffers.left[i] = toSlMat(buffer.left);
+        if (app_type == LEFT_AND_DEPTH_16 || app_type == LEFT_AND_DEPTH_RAW)
+            buffers.depth[i] = toSlMat(buffer.depth);
+        else
+            buffers.right[i] = toSlMat(buffer.right);
+    }
+    return buffers;
+}
+
+// Grab the frames of [segment.start, segment.end) and hand them to the pool
+bool exportSegment(Camera& zed, ExportSegment segment, APP_TYPE app_type, ExportPool& pool, PoolBuffers& buffers, atomic<int>& nb_grabbed) {
+    RuntimeParameters rt_param;
+    rt_param.sensing_mode = SENSING_MODE::FILL;
+
+    zed.setSVOPosition(segment.start);
+    // Next frame to export: every frame of the segment is exported, in order, or the segment fails
+    int next_frame = segment.start;
+    int seek_back = 0;
 
     while (!exit_app) {
+        // Blocks while every buffer is being encoded
+        StageSpan acquire_span("acquire");
+        ExportFrame* frame = pool.acquire();
+        acquire_span.end();
+        if (!frame) break;
+
+        StageSpan grab_span("grab");
         sl::ERROR_CODE err = zed.grab(rt_param);
+        grab_span.end();
         if (err == ERROR_CODE::SUCCESS) {
-            svo_position = zed.getSVOPosition();
+            int svo_position = zed.getSVOPosition();
+            if (svo_position < next_frame) {
+                // setSVOPosition() may land before the requested frame, the previous segment exports these ones
+                pool.release(frame);
+                continue;
+            }
+            if (svo_position > next_frame) {
+                pool.release(frame);
+                if (next_frame == segment.start && segment.start - seek_back > 0) {
+                    // setSVOPosition() may also land after the requested frame: seek earlier, the frames before the
+                    // segment are skipped above
+                    seek_back = seek_back ? 2 * seek_back : 1;
+                    zed.setSVOPosition(max(0, segment.start - seek_back));
+                    continue;
+                }
+                print("Segment " + to_string(segment.id) + ": frames " + to_string(next_frame) + " to " + to_string(svo_position - 1) + " cannot be read", ERROR_CODE::FAILURE);
+                return false;
+            }
+            if (svo_position >= segment.end) {
+                // Reached the start of the next segment
+                pool.release(frame);
+                break;
+            }
+            next_frame = svo_position + 1;
+            frame->index = svo_position;
+            frame->timestamp = zed.getTimestamp(TIME_REFERENCE::IMAGE).getNanoseconds();
 
             // Retrieve SVO images
-            zed.retrieveImage(left_image, VIEW::LEFT);
+            StageSpan image_span("retrieveImage");
+            zed.retrieveImage(buffers.left[frame->slot], VIEW::LEFT);
 
             switch (app_type) {
                 case LEFT_AND_RIGHT:
-                    zed.retrieveImage(right_image, VIEW::RIGHT);
+                    zed.retrieveImage(buffers.right[frame->slot], VIEW::RIGHT);
                     break;
                 case LEFT_AND_DEPTH:
-                    zed.retrieveImage(right_image, VIEW::DEPTH);
+                    zed.retrieveImage(buffers.right[frame->slot], VIEW::DEPTH);
                     break;
                 case LEFT_AND_DEPTH_16:
-                    zed.retrieveMeasure(depth_image, MEASURE::DEPTH);
+                case LEFT_AND_DEPTH_RAW: {
+                    image_span.end();
+                    STAGE_SPAN("retrieveMeasure");
+                    zed.retrieveMeasure(buffers.depth[frame->slot], MEASURE::DEPTH);
                     break;
+                }
                 default:
                     break;
             }
-
-            if (output_as_video) {
-                // Convert SVO image from RGBA to RGB
-                cv::cvtColor(left_image_ocv, image_sideByside(cv::Rect(0,0,image_size.width,image_size.height)), cv::COLOR_BGRA2BGR);
-                cv::cvtColor(right_image_ocv, image_sideByside(cv::Rect(image_size.width,0,image_size.width,image_size.height)), cv::COLOR_BGRA2BGR);
-                // Write the RGB image in the video
-                video_writer.write(image_sideByside);
-            } else {
-                // Generate filenames
-                ostringstream filename1;
-                filename1 << output_path << "/left" << setfill('0') << setw(6) << svo_position << ".png";
-                ostringstream filename2;
-                filename2 << output_path << (app_type == LEFT_AND_RIGHT ? "/right" : "/depth") << setfill('0') << setw(6) << svo_position << ".png";
-
-                // Save Left images
-                cv::imwrite(filename1.str(), left_image_ocv);
-
-                // Save depth
-                if (app_type != LEFT_AND_DEPTH_16)
-                    cv::imwrite(filename2.str(), right_image_ocv);
-                else {
-                    // Convert to 16Bit
-                    cv::Mat depth16;
-                    depth_image_ocv.convertTo(depth16, CV_16UC1);
-                    cv::imwrite(filename2.str(), depth16);
+            image_span.end();
+
+            // Conversion, encoding and writing are done by the pool
+            pool.submit(frame);
+            nb_grabbed++;
+        } else {
+            pool.release(frame);
+            if (err == sl::ERROR_CODE::END_OF_SVOFILE_REACHED) {
+                if (next_frame < segment.end && !exit_app) {
+                    print("Segment " + to_string(segment.id) + ": end of the SVO at frame " + to_string(next_frame) + " instead of " + to_string(segment.end), ERROR_CODE::FAILURE);
+                    return false;
                 }
+                break;
             }
-
-            // Display progress
-            ProgressBar((float) (svo_position / (float) nb_frames), 30);
-        } else if (err == sl::ERROR_CODE::END_OF_SVOFILE_REACHED){
-            print("SVO end has been reached. Exiting now.");
-            exit_app = true;
-        }
-        else {
-            print("Grab Error: ",err);
-            exit_app = true;
+            print("Grab Error (segment " + to_string(segment.id) + "): ", err);
+            return false;
         }
     }
-    if (output_as_video) {
-        // Close the video writer
-        video_writer.release();
-    }
-
-    zed.close();
-    return EXIT_SUCCESS;
+    return !exit_app;
 }
 
 void print(string msg_prefix, ERROR_CODE err_code, string msg_suffix) {
@@ -0,0 +1,133 @@
+#ifndef __FRAME_PREFETCHER_HPP__
+#define __FRAME_PREFETCHER_HPP__
+
+#include <condition_variable>
+#include <list>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+///
+/// \brief Source of decoded frames, only called from the prefetch thread
+///
+class FrameDecoder {
+public:
+    virtual ~FrameDecoder() {}
+    ///
+    /// \brief decode the frame at position into image (already allocated with the display size and type)
+    ///
+    virtual bool decode(int position, cv::Mat& image) = 0;
+};
+
+///
+/// \brief The FrameCache class
+/// Keeps the decoded frames of a window around the playhead, and small thumbnails of every thumbnail_step frames (LRU,
+/// bounded in bytes).
+/// The buffers of the frames leaving the window are recycled. Not thread safe, the FramePrefetcher locks it.
+///
+class FrameCache {
+public:
+    ///
+    /// \param nb_frames : number of frames of the video
+    /// \param window_before, window_after : number of frames kept behind and ahead of the playhead
+    /// \param thumbnail_step : a thumbnail is kept for the frames multiple of thumbnail_step
+    /// \param max_thumbnail_bytes : thumbnail cache capacity, in bytes of pixels
+    /// \param thumbnail_size : size of the thumbnails
+    ///
+    FrameCache(int nb_frames, int window_before, int window_after, int thumbnail_step, size_t max_thumbnail_bytes, cv::Size thumbnail_size);
+
+    ///
+    /// \brief move the window, the frames that leave it are released
+    ///
+    void setPlayhead(int position);
+    int getPlayhead() const { return playhead; }
+
+    bool inWindow(int position) const;
+    bool contains(int position) const { return frames.count(position) != 0; }
+
+    ///
+    /// \brief next frame to decode: the first missing one ahead of the playhead, then behind it. -1 when the window is full
+    ///
+    int nextMissing() const;
+
+    ///
+    /// \brief buffer to decode a frame into, recycled when possible
+    ///
+    cv::Mat getBuffer(cv::Size size, int type);
+
+    ///
+    /// \brief store a decoded frame, ignored if it left the window in the meantime. Also creates its thumbnail if requested
+    ///
+    void insert(int position, cv::Mat image, bool with_thumbnail = true);
+
+    ///
+    /// \brief the decoded frame, if cached
+    ///
+    bool get(int position, cv::Mat& image) const;
+
+    ///
+    /// \brief the thumbnail of the closest position for which one is cached
+    /// \return its position, -1 if there is none
+    ///
+    int getThumbnail(int position, cv::Mat& thumbnail);
+
+    size_t getNbFrames() const { return frames.size(); }
+    size_t getNbThumbnails() const { return thumbnails.size(); }
+    size_t getThumbnailBytes() const { return thumbnail_bytes; }
+
+private:
+    int nb_frames, window_before, window_after;
+    int thumbnail_step;
+    size_t max_thumbnail_bytes, thumbnail_bytes = 0;
+    cv::Size thumbnail_size;
+    int playhead = 0;
+
+    std::map<int, cv::Mat> frames;
+    std::vector<cv::Mat> free_buffers;
+    std::map<int, cv::Mat> thumbnails;
+    std::list<int> thumbnails_lru; // most recent first
+};
+
+///
+/// \brief The FramePrefetcher class
+/// A thread that decodes the frames of the cache window as soon as the playhead moves, so that seeking and scrubbing
+/// usually find the frame already decoded. The decoder is only used by this thread.
+///
+class FramePrefetcher {
+public:
+    FramePrefetcher(FrameDecoder& decoder, FrameCache& cache, cv::Size frame_size, int frame_type);
+    ~FramePrefetcher();
+
+    void start();
+    void stop();
+
+    ///
+    /// \brief move the playhead, the prefetch starts from there
+    ///
+    void seek(int position);
+
+    ///
+    /// \brief copy the frame at position into image
+    /// \param wait_ms : how long to wait for the frame to be decoded
+    /// \return true if the frame was decoded, else image holds the closest thumbnail (if any) upscaled to the frame size
+    ///
+    bool get(int position, cv::Mat& image, int wait_ms);
+
+private:
+    void prefetchLoop();
+
+    FrameDecoder& decoder;
+    FrameCache& cache;
+    cv::Size frame_size;
+    int frame_type;
+
+    std::thread worker;
+    std::mutex mtx;
+    std::condition_variable wake_cv, decoded_cv;
+    bool running = false;
+};
+
+#endif
@@ -0,0 +1,92 @@
+#ifndef __SVO_INDEX_HPP__
+#define __SVO_INDEX_HPP__
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#define SVO_INDEX_MAGIC "ZEDSVOI"
+#define SVO_INDEX_VERSION 1
+#define SVO_INDEX_UNKNOWN_OFFSET 0xFFFFFFFFFFFFFFFFULL
+
+///
+/// \brief One entry per SVO frame
+///
+struct SvoIndexEntry {
+    uint64_t timestamp = 0;     ///< image timestamp in nanoseconds
+    uint64_t byte_offset = SVO_INDEX_UNKNOWN_OFFSET; ///< position of the frame in the SVO file, when known
+    uint32_t flags = 0;         ///< SvoIndex::FLAG_*
+    uint32_t reserved = 0;
+};
+
+///
+/// \brief The SvoIndex class
+/// Frame number -> timestamp table of a SVO, saved next to it ("file.svo.idx") so that it is built only once.
+/// The sidecar is tied to the size and modification time of the SVO and is rebuilt when they change.
+/// The SDK does not expose the byte offsets nor the keyframes of a SVO, the fields are kept in the format for the tools that know them.
+///
+class SvoIndex {
+public:
+    enum {
+        FLAG_KEYFRAME_KNOWN = 1, ///< the FLAG_KEYFRAME bit is meaningful
+        FLAG_KEYFRAME = 2
+    };
+
+    ///
+    /// \brief sidecar path of a SVO
+    ///
+    static std::string sidecarPath(const std::string& svo_path) { return svo_path + ".idx"; }
+
+    ///
+    /// \brief load the sidecar of svo_path
+    /// \return false if it does not exist, is invalid or does not match the current SVO file
+    ///
+    bool load(const std::string& svo_path);
+
+    ///
+    /// \brief save the sidecar of svo_path
+    ///
+    bool save(const std::string& svo_path) const;
+
+    /// Building
+    void clear() { entries.clear(); sorted_frames.clear(); }
+    void reserve(size_t n) { entries.reserve(n); }
+    ///
+    /// \brief set the entry of a frame, the table grows as needed. Missing frames get a 0 timestamp,
+    /// they are ignored by the timestamp queries
+    ///
+    void set(int frame, const SvoIndexEntry& entry);
+    void setFrameRate(float fps) { frame_rate = fps; }
+
+    /// Queries
+    int size() const { return static_cast<int>(entries.size()); }
+    bool empty() const { return entries.empty(); }
+    float getFrameRate() const { return frame_rate; }
+    const SvoIndexEntry& operator[](int frame) const { return entries[frame]; }
+    uint64_t getTimestamp(int frame) const { return entries[frame].timestamp; }
+    ///
+    /// \brief whether the timestamp of frame is known (not a missing frame)
+    ///
+    bool hasTimestamp(int frame) const { return frame >= 0 && frame < size() && entries[frame].timestamp != 0; }
+    ///
+    /// \brief timestamp of the first frame which has one, 0 if there is none
+    ///
+    uint64_t getFirstTimestamp() const { return sorted_frames.empty() ? 0 : entries[sorted_frames.front()].timestamp; }
+    ///
+    /// \brief frame whose timestamp is the closest to ts (binary search over the frames which have one), -1 if there is none
+    ///
+    int findFrame(uint64_t ts) const;
+    ///
+    /// \brief nearest keyframe at or before frame, the frame itself if the keyframes are unknown
+    ///
+    int previousKeyframe(int frame) const;
+
+private:
+    void sortFrames();
+
+    std::vector<SvoIndexEntry> entries;
+    std::vector<int> sorted_frames; ///< frames with a timestamp, by increasing timestamp
+    float frame_rate = 0.f;
+};
+
+#endif
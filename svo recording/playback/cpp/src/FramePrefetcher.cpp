@@ -0,0 +1,168 @@
+#include "FramePrefetcher.hpp"
+
+#include <chrono>
+
+/////////////////////////////////////////////////////////////////////////////
+// FrameCache
+
+FrameCache::FrameCache(int nb_frames_, int window_before_, int window_after_, int thumbnail_step_, size_t max_thumbnail_bytes_, cv::Size thumbnail_size_) {
+    nb_frames = nb_frames_;
+    window_before = std::max(0, window_before_);
+    window_after = std::max(1, window_after_);
+    thumbnail_step = std::max(1, thumbnail_step_);
+    max_thumbnail_bytes = max_thumbnail_bytes_;
+    thumbnail_size = thumbnail_size_;
+}
+
+void FrameCache::setPlayhead(int position) {
+    playhead = std::max(0, std::min(position, nb_frames - 1));
+    for (auto it = frames.begin(); it != frames.end();) {
+        if (!inWindow(it->first)) {
+            free_buffers.push_back(it->second);
+            it = frames.erase(it);
+        } else
+            ++it;
+    }
+}
+
+bool FrameCache::inWindow(int position) const {
+    return position >= 0 && position < nb_frames && position >= playhead - window_before && position <= playhead + window_after;
+}
+
+int FrameCache::nextMissing() const {
+    // Ahead first, it is where the playback goes
+    for (int p = playhead; p <= std::min(playhead + window_after, nb_frames - 1); p++)
+        if (!frames.count(p)) return p;
+    for (int p = playhead - 1; p >= std::max(playhead - window_before, 0); p--)
+        if (!frames.count(p)) return p;
+    return -1;
+}
+
+cv::Mat FrameCache::getBuffer(cv::Size size, int type) {
+    while (!free_buffers.empty()) {
+        cv::Mat buffer = free_buffers.back();
+        free_buffers.pop_back();
+        if (buffer.size() == size && buffer.type() == type) return buffer;
+    }
+    return cv::Mat(size, type);
+}
+
+void FrameCache::insert(int position, cv::Mat image, bool with_thumbnail) {
+    size_t bytes = thumbnail_size.area() * image.elemSize();
+    if (with_thumbnail && bytes <= max_thumbnail_bytes && position % thumbnail_step == 0) {
+        auto it = thumbnails.find(position);
+        if (it == thumbnails.end()) {
+            while (thumbnail_bytes + bytes > max_thumbnail_bytes) {
+                auto oldest = thumbnails.find(thumbnails_lru.back());
+                thumbnail_bytes -= oldest->second.total() * oldest->second.elemSize();
+                thumbnails.erase(oldest);
+                thumbnails_lru.pop_back();
+            }
+            cv::resize(image, thumbnails[position], thumbnail_size, 0, 0, cv::INTER_AREA);
+            thumbnail_bytes += bytes;
+        } else
+            thumbnails_lru.remove(position);
+        thumbnails_lru.push_front(position);
+    }
+
+    if (inWindow(position) && !frames.count(position))
+        frames[position] = image;
+    else
+        free_buffers.push_back(image);
+}
+
+bool FrameCache::get(int position, cv::Mat& image) const {
+    auto it = frames.find(position);
+    if (it == frames.end()) return false;
+    it->second.copyTo(image);
+    return true;
+}
+
+int FrameCache::getThumbnail(int position, cv::Mat& thumbnail) {
+    if (thumbnails.empty()) return -1;
+    auto after = thumbnails.lower_bound(position);
+    auto best = after;
+    if (after == thumbnails.end() || (after != thumbnails.begin() && position - std::prev(after)->first < after->first - position))
+        best = std::prev(after);
+    thumbnail = best->second;
+    thumbnails_lru.remove(best->first);
+    thumbnails_lru.push_front(best->first);
+    return best->first;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// FramePrefetcher
+
+FramePrefetcher::FramePrefetcher(FrameDecoder& decoder_, FrameCache& cache_, cv::Size frame_size_, int frame_type_)
+    : decoder(decoder_), cache(cache_), frame_size(frame_size_), frame_type(frame_type_) {
+}
+
+FramePrefetcher::~FramePrefetcher() {
+    stop();
+}
+
+void FramePrefetcher::start() {
+    if (running) return;
+    running = true;
+    worker = std::thread(&FramePrefetcher::prefetchLoop, this);
+}
+
+void FramePrefetcher::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        running = false;
+    }
+    wake_cv.notify_all();
+    if (worker.joinable()) worker.join();
+}
+
+void FramePrefetcher::seek(int position) {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        cache.setPlayhead(position);
+    }
+    wake_cv.notify_one();
+}
+
+bool FramePrefetcher::get(int position, cv::Mat& image, int wait_ms) {
+    std::unique_lock<std::mutex> lock(mtx);
+    if (cache.get(position, image)) return true;
+    if (wait_ms > 0 && cache.inWindow(position)) {
+        decoded_cv.wait_for(lock, std::chrono::milliseconds(wait_ms), [&] { return cache.contains(position) || !running; });
+        if (cache.get(position, image)) return true;
+    }
+    // Not decoded yet: show the closest thumbnail meanwhile
+    cv::Mat thumbnail;
+    if (cache.getThumbnail(position, thumbnail) >= 0)
+        cv::resize(thumbnail, image, frame_size, 0, 0, cv::INTER_LINEAR);
+    return false;
+}
+
+void FramePrefetcher::prefetchLoop() {
+    while (true) {
+        int position;
+        cv::Mat buffer;
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            wake_cv.wait(lock, [this] { return !running || cache.nextMissing() >= 0; });
+            if (!running) break;
+            position = cache.nextMissing();
+            buffer = cache.getBuffer(frame_size, frame_type);
+        }
+
+        // Decoding is done without the lock, the playhead may move meanwhile
+        bool ok = decoder.decode(position, buffer);
+
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            if (ok)
+                cache.insert(position, buffer);
+            else {
+                // Nothing to decode there (end of file, read error): avoid looping on it
+                cache.insert(position, cv::Mat(frame_size, frame_type, cv::Scalar::all(0)), false);
+            }
+        }
+        decoded_cv.notify_all();
+    }
+    decoded_cv.notify_all();
+}
@@ -0,0 +1,112 @@
+#include "SvoIndex.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#pragma pack(push, 1)
+struct SvoIndexHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t nb_frames;
+    uint64_t svo_size;
+    int64_t svo_mtime;
+    float frame_rate;
+    uint32_t entry_size;
+};
+#pragma pack(pop)
+
+static bool svoFileInfo(const std::string& svo_path, uint64_t& size, int64_t& mtime) {
+    struct stat info;
+    if (stat(svo_path.c_str(), &info) != 0) return false;
+    size = static_cast<uint64_t>(info.st_size);
+    mtime = static_cast<int64_t>(info.st_mtime);
+    return true;
+}
+
+bool SvoIndex::load(const std::string& svo_path) {
+    clear();
+    uint64_t svo_size;
+    int64_t svo_mtime;
+    if (!svoFileInfo(svo_path, svo_size, svo_mtime)) return false;
+
+    std::ifstream file(sidecarPath(svo_path), std::ios::binary);
+    if (!file.is_open()) return false;
+
+    SvoIndexHeader header;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header))) return false;
+    if (memcmp(header.magic, SVO_INDEX_MAGIC, sizeof(SVO_INDEX_MAGIC)) != 0 || header.version != SVO_INDEX_VERSION
+            || header.entry_size != sizeof(SvoIndexEntry) || header.svo_size != svo_size || header.svo_mtime != svo_mtime)
+        return false;
+
+    entries.resize(header.nb_frames);
+    if (!file.read(reinterpret_cast<char*>(entries.data()), entries.size() * sizeof(SvoIndexEntry))) {
+        clear();
+        return false;
+    }
+    frame_rate = header.frame_rate;
+    sortFrames();
+    return true;
+}
+
+bool SvoIndex::save(const std::string& svo_path) const {
+    SvoIndexHeader header;
+    memset(&header, 0, sizeof(header));
+    if (!svoFileInfo(svo_path, header.svo_size, header.svo_mtime)) return false;
+    memcpy(header.magic, SVO_INDEX_MAGIC, sizeof(SVO_INDEX_MAGIC));
+    header.version = SVO_INDEX_VERSION;
+    header.nb_frames = static_cast<uint32_t>(entries.size());
+    header.frame_rate = frame_rate;
+    header.entry_size = sizeof(SvoIndexEntry);
+
+    std::ofstream file(sidecarPath(svo_path), std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) return false;
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(SvoIndexEntry));
+    return file.good();
+}
+
+void SvoIndex::set(int frame, const SvoIndexEntry& entry) {
+    if (frame < 0) return;
+    if (frame >= size()) entries.resize(frame + 1);
+    bool was_sorted = entries[frame].timestamp != 0;
+    entries[frame] = entry;
+    // The index is built in order: appending keeps the sorted frames sorted, anything else sorts them again
+    if (!was_sorted && entry.timestamp != 0
+            && (sorted_frames.empty() || entries[sorted_frames.back()].timestamp < entry.timestamp))
+        sorted_frames.push_back(frame);
+    else if (was_sorted || entry.timestamp != 0)
+        sortFrames();
+}
+
+void SvoIndex::sortFrames() {
+    sorted_frames.clear();
+    for (int f = 0; f < size(); f++)
+        if (entries[f].timestamp != 0) sorted_frames.push_back(f);
+    std::stable_sort(sorted_frames.begin(), sorted_frames.end(),
+            [this](int a, int b) { return entries[a].timestamp < entries[b].timestamp; });
+}
+
+int SvoIndex::findFrame(uint64_t ts) const {
+    // The missing frames (0 timestamp) are not in sorted_frames, they would break the ordering
+    if (sorted_frames.empty()) return -1;
+    auto it = std::lower_bound(sorted_frames.begin(), sorted_frames.end(), ts,
+            [this](int f, uint64_t t) { return entries[f].timestamp < t; });
+    if (it == sorted_frames.end()) return sorted_frames.back();
+    // it is the first frame >= ts, the previous one may be closer
+    if (it != sorted_frames.begin() && ts - entries[*std::prev(it)].timestamp < entries[*it].timestamp - ts)
+        --it;
+    return *it;
+}
+
+int SvoIndex::previousKeyframe(int frame) const {
+    frame = std::max(0, std::min(frame, size() - 1));
+    for (int f = frame; f >= 0; f--) {
+        if (!(entries[f].flags & FLAG_KEYFRAME_KNOWN)) return frame;
+        if (entries[f].flags & FLAG_KEYFRAME) return f;
+    }
+    return frame;
+}
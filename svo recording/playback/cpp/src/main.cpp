@@ -29,6 +29,10 @@
 // Sample includes
 #include <opencv2/opencv.hpp>
 #include "utils.hpp"
+#include "SvoIndex.hpp"
+#include "FramePrefetcher.hpp"
+#include "DisplayMode.hpp"
+#include "MatBridge.hpp"
 
 // Using namespace
 using namespace sl;
@@ -36,12 +40,72 @@ using namespace std;
 
 void print(string msg_prefix, ERROR_CODE err_code = ERROR_CODE::SUCCESS, string msg_suffix = "");
 
+///
+/// \brief Decodes the SVO frames for the FramePrefetcher, at the display resolution.
+/// Sequential reads only call grab(), setSVOPosition() is only used when the requested frame is not the next one.
+///
+class SvoDecoder : public FrameDecoder {
+public:
+    SvoDecoder(Camera& zed_, Resolution resolution_) : zed(zed_), resolution(resolution_) {
+        // Only the images are displayed
+        runtime_parameters.enable_depth = false;
+    }
+
+    bool decode(int position, cv::Mat& image) override {
+        if (position != next_position)
+            zed.setSVOPosition(position);
+        ERROR_CODE err = zed.grab(runtime_parameters);
+        if (err != ERROR_CODE::SUCCESS) {
+            next_position = -1;
+            return false;
+        }
+        next_position = zed.getSVOPosition() + 1;
+        // Retrieve the side by side image directly in the cache buffer
+        Mat view = toSlMat(image);
+        return zed.retrieveImage(view, VIEW::SIDE_BY_SIDE, MEM::CPU, resolution) == ERROR_CODE::SUCCESS;
+    }
+
+private:
+    Camera& zed;
+    Resolution resolution;
+    RuntimeParameters runtime_parameters;
+    int next_position = -1;
+};
+
+// Read the timestamp of every frame once, the result is saved next to the SVO
+bool buildIndex(Camera& zed, SvoIndex& index, int nb_frames) {
+    RuntimeParameters runtime_parameters;
+    runtime_parameters.enable_depth = false;
+    index.clear();
+    index.reserve(nb_frames);
+    index.setFrameRate(zed.getInitParameters().camera_fps);
+    zed.setSVOPosition(0);
+    SetCtrlHandler();
+    while (!exit_app) {
+        ERROR_CODE err = zed.grab(runtime_parameters);
+        if (err == ERROR_CODE::END_OF_SVOFILE_REACHED) break;
+        if (err != ERROR_CODE::SUCCESS) return false;
+        int position = zed.getSVOPosition();
+        SvoIndexEntry entry;
+        entry.timestamp = zed.getTimestamp(TIME_REFERENCE::IMAGE).getNanoseconds();
+        index.set(position, entry);
+        ProgressBar(position / (float) max(nb_frames, 1), 30);
+    }
+    cout << endl;
+    zed.setSVOPosition(0);
+    return !exit_app;
+}
+
 int main(int argc, char **argv) {
 
+    DisplayMode display;
+    if (!display.parse(argc, argv)) return EXIT_FAILURE;
+
     if (argc<=1)  {
         cout << "Usage: \n";
-        cout << "$ ZED_SVO_Playback <SVO_file> \n";
-        cout << "  ** SVO file is mandatory in the application ** \n\n";
+        cout << "$ ZED_SVO_Playback <SVO_file> [start_time_s] " << DisplayMode::usage() << "\n";
+        cout << "  ** SVO file is mandatory in the application ** \n";
+        cout << "  start_time_s : optional start time, in seconds from the first frame\n\n";
         return EXIT_FAILURE;
     }
 
@@ -61,58 +125,116 @@ int main(int argc, char **argv) {
     auto resolution = zed.getCameraInformation().camera_configuration.resolution;
     // Define OpenCV window size (resize to max 720/404)
     sl::Resolution low_resolution(min(720, (int)resolution.width) * 2, min(404, (int)resolution.height));
-    Mat svo_image(low_resolution, MAT_TYPE::U8_C4, MEM::CPU);
-    cv::Mat svo_image_ocv = slMat2cvMat(svo_image);
-
-    // Setup key, images, times
-    char key = ' ';
-    cout << " Press 's' to save SVO image as a PNG" << endl;
-    cout << " Press 'f' to jump forward in the video" << endl;
-    cout << " Press 'b' to jump backward in the video" << endl;
-    cout << " Press 'q' to exit..." << endl;
+    cv::Size display_size(low_resolution.width, low_resolution.height);
+    cv::Mat svo_image_ocv(display_size, CV_8UC4, cv::Scalar::all(0));
+    // The frame with the time overlay, the captures are saved without it
+    cv::Mat display_image;
 
     int svo_frame_rate = zed.getInitParameters().camera_fps;
     int nb_frames = zed.getSVONumberOfFrames();
     print("[Info] SVO contains " +to_string(nb_frames)+" frames");
 
+    // Frame -> timestamp index, built once and saved next to the SVO
+    string svo_path(argv[1]);
+    SvoIndex index;
+    if (index.load(svo_path)) {
+        print("[Info] Loaded frame index " + SvoIndex::sidecarPath(svo_path));
+    } else {
+        print("[Info] Building the frame index, this is done only once per SVO... Use Ctrl-C to skip it.");
+        if (buildIndex(zed, index, nb_frames) && index.save(svo_path))
+            print("[Info] Frame index saved to " + SvoIndex::sidecarPath(svo_path));
+        else {
+            print("[Info] Frame index unavailable, timestamp seek disabled");
+            index.clear();
+            exit_app = false;
+        }
+    }
+
+    int svo_position = 0;
+    if (argc > 2 && !index.empty()) {
+        uint64_t start_ts = index.getFirstTimestamp() + (uint64_t) (atof(argv[2]) * 1e9);
+        svo_position = index.findFrame(start_ts);
+    }
+
+    // Decoded frames are kept around the playhead (2s behind, 4s ahead), with a thumbnail every second for fast scrubbing.
+    // The thumbnails are bounded to 64 MB, about 7 minutes of video at the largest display size
+    SvoDecoder decoder(zed, low_resolution);
+    FrameCache cache(nb_frames, 2 * svo_frame_rate, 4 * svo_frame_rate, svo_frame_rate, 64 << 20, cv::Size(display_size.width / 4, display_size.height / 4));
+    FramePrefetcher prefetcher(decoder, cache, display_size, CV_8UC4);
+    prefetcher.seek(svo_position);
+    prefetcher.start();
+
+    // Setup key, images, times
+    char key = ' ';
+    if (!display.headless()) {
+        cout << " Press 's' to save SVO image as a PNG" << endl;
+        cout << " Press 'f' to jump forward in the video" << endl;
+        cout << " Press 'b' to jump backward in the video" << endl;
+        cout << " Press 'q' to exit..." << endl;
+    }
+
     // Start SVO playback
 
-     while (key != 'q') {
-        returned_state = zed.grab();
-        if (returned_state == ERROR_CODE::SUCCESS) {
+     // Ctrl-C during the index build replaced the handler of the display mode, exit_app also ends the headless loop
+     while (key != 'q' && display.nextFrame() && !exit_app) {
+        // The zed is only used by the prefetch thread from now on
+        bool decoded = prefetcher.get(svo_position, svo_image_ocv, 1000 / max(svo_frame_rate, 1));
 
-            // Get the side by side image
-            zed.retrieveImage(svo_image, VIEW::SIDE_BY_SIDE, MEM::CPU, low_resolution);
-            int svo_position = zed.getSVOPosition();
+        if (display.hasSink()) {
+            FrameResult result;
+            result.timestamp = index.hasTimestamp(svo_position) ? index.getTimestamp(svo_position) : 0;
+            result.text = "position " + to_string(svo_position) + (decoded ? "" : " thumbnail");
+            result.image = svo_image_ocv.data;
+            result.width = svo_image_ocv.cols;
+            result.height = svo_image_ocv.rows;
+            result.channels = svo_image_ocv.channels();
+            result.step = svo_image_ocv.step;
+            display.publish(result);
+        }
 
-            // Display the frame
-            cv::imshow("View", svo_image_ocv);
-            key = cv::waitKey(10);
-            
-            switch (key) {
-            case 's':
-                svo_image.write(("capture_" + to_string(svo_position) + ".png").c_str());
-                break;
-            case 'f':
-                zed.setSVOPosition(svo_position + svo_frame_rate);
-                break;
-            case 'b':
-                zed.setSVOPosition(svo_position - svo_frame_rate);
-                break;
+        // Display the frame
+        if (display.renderFrame()) {
+            svo_image_ocv.copyTo(display_image);
+            if (index.hasTimestamp(svo_position)) {
+                int t = (int) ((index.getTimestamp(svo_position) - index.getFirstTimestamp()) / 1000000000ULL);
+                char time_text[64];
+                snprintf(time_text, sizeof(time_text), "%02d:%02d:%02d%s", t / 3600, (t / 60) % 60, t % 60, decoded ? "" : " (preview)");
+                cv::putText(display_image, time_text, cv::Point(10, 25), cv::FONT_HERSHEY_SIMPLEX, 0.7, cv::Scalar(255, 255, 255, 255), 2);
             }
+            cv::imshow("View", display_image);
+            key = cv::waitKey(10);
+        }
 
-            ProgressBar((float)(svo_position / (float)nb_frames), 30);
+        int next_position = decoded ? svo_position + 1 : svo_position;
+        switch (key) {
+        case 's':
+            cv::imwrite("capture_" + to_string(svo_position) + ".png", svo_image_ocv);
+            break;
+        case 'f':
+            next_position = svo_position + svo_frame_rate;
+            break;
+        case 'b':
+            next_position = svo_position - svo_frame_rate;
+            break;
         }
-        else if (returned_state == sl::ERROR_CODE::END_OF_SVOFILE_REACHED)
-        {
+
+        if (next_position >= nb_frames && display.headless()) {
+            print("SVO end has been reached. Exit\n");
+            break;
+        }
+        if (next_position >= nb_frames) {
             print("SVO end has been reached. Looping back to 0\n");
-            zed.setSVOPosition(0);
+            next_position = 0;
         }
-        else {
-            print("Grab ZED : ", returned_state);
-            break;
+        next_position = max(0, next_position);
+        if (next_position != svo_position) {
+            svo_position = next_position;
+            prefetcher.seek(svo_position);
         }
+
+        ProgressBar((float)(svo_position / (float)nb_frames), 30);
      } 
+    prefetcher.stop();
     zed.close();
     return EXIT_SUCCESS;
 }
@@ -0,0 +1,223 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+/*****************************************************************************************
+ ** Check of the frame index and of the frame cache of the playback, without the ZED SDK **
+ ** nor a SVO: the index is filled with synthetic timestamps, the prefetcher decodes     **
+ ** synthetic frames whose pixels hold their position.                                   **
+ *****************************************************************************************/
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+
+#include "SvoIndex.hpp"
+#include "FramePrefetcher.hpp"
+
+using namespace std;
+
+static bool check(bool condition, const string& what) {
+    printf("  %-60s %s\n", what.c_str(), condition ? "ok" : "FAILED");
+    return condition;
+}
+
+static SvoIndexEntry makeEntry(uint64_t timestamp, uint32_t flags = 0) {
+    SvoIndexEntry entry;
+    entry.timestamp = timestamp;
+    entry.flags = flags;
+    return entry;
+}
+
+// Frame of the synthetic video: every pixel holds position % 256
+static cv::Mat makeFrame(int position, cv::Size size) {
+    return cv::Mat(size, CV_8UC4, cv::Scalar::all(position % 256));
+}
+
+static bool isFrame(const cv::Mat& image, int position) {
+    return !image.empty() && image.at<cv::Vec4b>(image.rows / 2, image.cols / 2)[0] == position % 256;
+}
+
+class SyntheticDecoder : public FrameDecoder {
+public:
+    explicit SyntheticDecoder(int nb_frames_) : nb_frames(nb_frames_) {}
+
+    bool decode(int position, cv::Mat& image) override {
+        nb_decoded++;
+        if (position >= nb_frames) return false;
+        makeFrame(position, image.size()).copyTo(image);
+        return true;
+    }
+
+    std::atomic<int> nb_decoded{0};
+
+private:
+    int nb_frames;
+};
+
+int main(int argc, char **) {
+    if (argc > 1) {
+        printf("Usage : ./ZED_SVO_Playback_Check\n");
+        return EXIT_FAILURE;
+    }
+    bool ok = true;
+    const uint64_t period = 33333333; // 30 fps, in ns
+
+    printf("SvoIndex\n");
+    {
+        SvoIndex index;
+        ok &= check(index.findFrame(12345) == -1 && index.getFirstTimestamp() == 0, "empty index: no frame");
+
+        for (int f = 0; f < 100; f++) index.set(f, makeEntry(1000 + f * period));
+        ok &= check(index.findFrame(1000 + 42 * period) == 42, "exact timestamp");
+        ok &= check(index.findFrame(1000 + 42 * period + period / 3) == 42 && index.findFrame(1000 + 42 * period + 2 * period / 3) == 43,
+            "closest frame");
+        ok &= check(index.findFrame(0) == 0 && index.findFrame(1000 + 500 * period) == 99, "before the first, after the last frame");
+
+        // Frames 0 to 2 and 10 to 19 could not be read: their entries stay at 0
+        SvoIndex gaps;
+        for (int f = 3; f < 10; f++) gaps.set(f, makeEntry(1000 + f * period));
+        for (int f = 20; f < 30; f++) gaps.set(f, makeEntry(1000 + f * period));
+        ok &= check(gaps.size() == 30 && !gaps.hasTimestamp(0) && !gaps.hasTimestamp(15) && gaps.hasTimestamp(20), "missing frames have no timestamp");
+        ok &= check(gaps.getFirstTimestamp() == 1000 + 3 * period, "first timestamp skips the missing frames");
+        bool found = true;
+        for (int f = 0; f < 30; f++) {
+            int expected = f < 3 ? 3 : (f < 10 || f >= 20) ? f : (f < 15 ? 9 : 20);
+            found &= gaps.findFrame(1000 + f * period) == expected;
+        }
+        ok &= check(found, "missing frames skipped by the binary search");
+        ok &= check(gaps.findFrame(0) == 3, "0 timestamp: first known frame, not a missing one");
+
+        // Frames set out of order, and an entry replaced
+        gaps.set(15, makeEntry(1000 + 15 * period));
+        gaps.set(1, makeEntry(1000 + 1 * period));
+        gaps.set(25, makeEntry(0));
+        ok &= check(gaps.findFrame(1000 + 15 * period) == 15 && gaps.findFrame(1000) == 1 && gaps.getFirstTimestamp() == 1000 + period,
+            "frames set out of order are found");
+        ok &= check(gaps.findFrame(1000 + 25 * period) != 25, "cleared frame no longer found");
+
+        SvoIndex missing;
+        missing.set(9, SvoIndexEntry());
+        ok &= check(missing.size() == 10 && missing.findFrame(1000) == -1, "only missing frames: no frame");
+
+        SvoIndex keyframes;
+        for (int f = 0; f < 10; f++)
+            keyframes.set(f, makeEntry(1000 + f * period, SvoIndex::FLAG_KEYFRAME_KNOWN | (f % 4 == 0 ? SvoIndex::FLAG_KEYFRAME : 0)));
+        ok &= check(keyframes.previousKeyframe(7) == 4 && keyframes.previousKeyframe(8) == 8 && keyframes.previousKeyframe(3) == 0,
+            "previous keyframe");
+        ok &= check(index.previousKeyframe(57) == 57, "keyframes unknown: the frame itself");
+    }
+
+    printf("SvoIndex sidecar\n");
+    {
+        const string svo_path = "playback_check.svo";
+        ofstream(svo_path, ios::binary | ios::trunc) << "not a real SVO";
+        SvoIndex index;
+        for (int f = 0; f < 50; f++)
+            if (f % 7) index.set(f, makeEntry(1000 + f * period));
+        index.setFrameRate(30.f);
+        SvoIndex loaded;
+        ok &= check(index.save(svo_path) && loaded.load(svo_path), "sidecar saved and loaded");
+        bool same = loaded.size() == index.size() && loaded.getFrameRate() == 30.f;
+        for (int f = 0; same && f < index.size(); f++) same = loaded.getTimestamp(f) == index.getTimestamp(f);
+        ok &= check(same, "same entries after the reload");
+        ok &= check(loaded.findFrame(1000 + 14 * period - 1) == 13 && loaded.findFrame(1000 + 15 * period) == 15, "loaded index skips the missing frames");
+
+        ofstream(svo_path, ios::binary | ios::app) << " modified";
+        ok &= check(!loaded.load(svo_path) && loaded.empty() && loaded.findFrame(1000) == -1, "sidecar of a modified SVO rejected");
+        remove(SvoIndex::sidecarPath(svo_path).c_str());
+        ok &= check(!loaded.load(svo_path), "missing sidecar");
+        remove(svo_path.c_str());
+    }
+
+    const cv::Size frame_size(64, 32), thumbnail_size(16, 8);
+    const size_t thumbnail_bytes = thumbnail_size.area() * 4;
+
+    printf("FrameCache\n");
+    {
+        FrameCache cache(100, 2, 4, 10, 3 * thumbnail_bytes, thumbnail_size);
+        cache.setPlayhead(50);
+        ok &= check(!cache.inWindow(47) && cache.inWindow(48) && cache.inWindow(54) && !cache.inWindow(55), "window around the playhead");
+        ok &= check(cache.nextMissing() == 50, "prefetch starts at the playhead");
+        for (int p = 50; p <= 54; p++) cache.insert(p, makeFrame(p, frame_size));
+        ok &= check(cache.nextMissing() == 49, "then goes behind it once ahead is full");
+        for (int p = 48; p <= 49; p++) cache.insert(p, makeFrame(p, frame_size));
+        ok &= check(cache.nextMissing() == -1 && cache.getNbFrames() == 7, "window full");
+        cv::Mat image;
+        ok &= check(cache.get(52, image) && isFrame(image, 52) && !cache.get(60, image), "cached frames");
+        cache.insert(80, makeFrame(80, frame_size));
+        ok &= check(!cache.contains(80), "frame outside the window not kept");
+        cache.setPlayhead(53);
+        ok &= check(cache.getNbFrames() == 4 && !cache.contains(50) && cache.nextMissing() == 55, "frames leaving the window released");
+        cv::Mat buffer = cache.getBuffer(frame_size, CV_8UC4);
+        ok &= check(buffer.size() == frame_size && buffer.type() == CV_8UC4, "recycled buffer of the requested size");
+        cache.setPlayhead(120);
+        ok &= check(cache.getPlayhead() == 99 && cache.nextMissing() == 99, "playhead clamped to the last frame");
+
+        // Thumbnails of 50 and 80 so far: the frames multiple of 10
+        ok &= check(cache.getNbThumbnails() == 2 && cache.getThumbnailBytes() == 2 * thumbnail_bytes, "thumbnail of every 10th frame");
+        cv::Mat thumbnail;
+        ok &= check(cache.getThumbnail(62, thumbnail) == 50 && cache.getThumbnail(70, thumbnail) == 80 && thumbnail.size() == thumbnail_size,
+            "closest thumbnail");
+        for (int p = 0; p < 100; p += 10) cache.insert(p, makeFrame(p, frame_size));
+        ok &= check(cache.getNbThumbnails() == 3 && cache.getThumbnailBytes() <= 3 * thumbnail_bytes, "thumbnails bounded in bytes");
+        ok &= check(cache.getThumbnail(74, thumbnail) == 70 && isFrame(thumbnail, 70), "least recently used thumbnails evicted");
+
+        FrameCache small(100, 2, 4, 10, thumbnail_bytes - 1, thumbnail_size);
+        small.insert(0, makeFrame(0, frame_size));
+        ok &= check(small.getNbThumbnails() == 0 && small.getThumbnail(0, thumbnail) == -1, "no thumbnail above the budget");
+        cache.insert(40, makeFrame(40, frame_size), false);
+        ok &= check(cache.getThumbnail(40, thumbnail) != 40, "frame inserted without thumbnail");
+    }
+
+    printf("FramePrefetcher\n");
+    {
+        const int nb_frames = 200;
+        SyntheticDecoder decoder(nb_frames - 10); // the last frames cannot be decoded
+        FrameCache cache(nb_frames, 5, 10, 30, 64 << 20, thumbnail_size);
+        FramePrefetcher prefetcher(decoder, cache, frame_size, CV_8UC4);
+        prefetcher.seek(0);
+        prefetcher.start();
+
+        cv::Mat image;
+        bool sequential = true;
+        for (int p = 0; p < 60; p++) {
+            sequential &= prefetcher.get(p, image, 1000) && isFrame(image, p);
+            prefetcher.seek(p + 1);
+        }
+        ok &= check(sequential, "sequential playback, every frame decoded");
+
+        prefetcher.seek(120);
+        ok &= check(prefetcher.get(120, image, 1000) && isFrame(image, 120), "frame decoded after a seek");
+        // 150 is far from the playhead: not decoded, the thumbnail of 120 is shown meanwhile
+        image.release();
+        ok &= check(!prefetcher.get(150, image, 0) && image.size() == frame_size && isFrame(image, 120), "thumbnail shown while not decoded");
+
+        prefetcher.seek(nb_frames - 1);
+        ok &= check(prefetcher.get(nb_frames - 1, image, 1000) && isFrame(image, 0), "frame failing to decode: black, no retry loop");
+        prefetcher.stop();
+        // Frames 0 to 70, 115 to 130 and 194 to 199, plus at most one decode in flight at each seek
+        ok &= check(decoder.nb_decoded <= 71 + 16 + 6 + 2, "each frame of the window decoded once");
+    }
+
+    printf(ok ? "PASSED\n" : "FAILED\n");
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
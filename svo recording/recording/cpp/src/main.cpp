@@ -28,13 +28,13 @@
 
 // Sample includes
 #include "utils.hpp"
+#include "ZedFrameSource.hpp"
 
 // Using namespace
 using namespace sl;
 using namespace std;
 
 void print(string msg_prefix, ERROR_CODE err_code = ERROR_CODE::SUCCESS, string msg_suffix = "");
-void parseArgs(int argc, char **argv,sl::InitParameters& param);
 
 int main(int argc, char **argv) {
 
@@ -50,7 +50,16 @@ int main(int argc, char **argv) {
     InitParameters init_parameters;
     init_parameters.camera_resolution = RESOLUTION::HD2K;
     init_parameters.depth_mode = DEPTH_MODE::NONE;
-    parseArgs(argc,argv,init_parameters);
+    // Input of the recording after the output file: IP[:port] of a stream or camera resolution (FrameSource.hpp)
+    FrameSourceOptions source;
+    if (argc > 2 && source.parseInput(argv[2])) {
+        if (source.kind == FRAME_SOURCE::SVO) {
+            cout << "[Sample][Warning] SVO input is not supported... switching to live mode" << endl;
+            source = FrameSourceOptions();
+        } else
+            cout << "[Sample] Using " << source.describe() << endl;
+    }
+    if (!applyFrameSource(source, init_parameters)) return EXIT_FAILURE;
 
     // Open the camera
     auto returned_state  = zed.open(init_parameters);
@@ -104,40 +113,3 @@ void print(string msg_prefix, ERROR_CODE err_code, string msg_suffix) {
         cout << " " << msg_suffix;
     cout << endl;
 }
-
-void parseArgs(int argc, char **argv,sl::InitParameters& param)
-{
-    if (argc > 2 && string(argv[2]).find(".svo")!=string::npos) {
-        // SVO input mode
-        cout<<"[sample][Warning] SVO input is not supported... switching to live mode"<<endl;
-    } else if (argc > 2 && string(argv[2]).find(".svo")==string::npos) {
-        string arg = string(argv[2]);
-        unsigned int a,b,c,d,port;
-        if (sscanf(arg.c_str(),"%u.%u.%u.%u:%d", &a, &b, &c, &d,&port) == 5) {
-            // Stream input mode - IP + port
-            string ip_adress = to_string(a)+"."+to_string(b)+"."+to_string(c)+"."+to_string(d);
-            param.input.setFromStream(sl::String(ip_adress.c_str()),port);
-            cout<<"[Sample] Using Stream input, IP : "<<ip_adress<<", port : "<<port<<endl;
-        }
-        else  if (sscanf(arg.c_str(),"%u.%u.%u.%u", &a, &b, &c, &d) == 4) {
-            // Stream input mode - IP only
-            param.input.setFromStream(sl::String(argv[2]));
-            cout<<"[Sample] Using Stream input, IP : "<<argv[2]<<endl;
-        }
-        else if (arg.find("HD2K")!=string::npos) {
-            param.camera_resolution = sl::RESOLUTION::HD2K;
-            cout<<"[Sample] Using Camera in resolution HD2K"<<endl;
-        } else if (arg.find("HD1080")!=string::npos) {
-            param.camera_resolution = sl::RESOLUTION::HD1080;
-            cout<<"[Sample] Using Camera in resolution HD1080"<<endl;
-        } else if (arg.find("HD720")!=string::npos) {
-            param.camera_resolution = sl::RESOLUTION::HD720;
-            cout<<"[Sample] Using Camera in resolution HD720"<<endl;
-        } else if (arg.find("VGA")!=string::npos) {
-            param.camera_resolution = sl::RESOLUTION::VGA;
-            cout<<"[Sample] Using Camera in resolution VGA"<<endl;
-        }
-    } else {
-        // Default
-    }
-}
@@ -24,6 +24,21 @@
 #include <stdio.h>
 #include <math.h>
 
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <unistd.h>
+#endif
+
+// Sleep without spinning, between two sensor samples
+void sleepMicroseconds(int us) {
+#ifdef _WIN32
+	Sleep(us >= 1000 ? us / 1000 : 1);
+#else
+	usleep(us);
+#endif
+}
+
 
 void printSensorConfiguration(struct SL_SensorParameters* sensor_parameters) {
 	if (sensor_parameters->is_available) {
@@ -80,13 +95,23 @@ int main(int argc, char **argv) {
 
 	struct SL_SensorData sensor_data;
 
+	// The IMU gives a new sample every period, there is no need to ask more often
+	float imu_rate = sl_get_sensors_configuration(camera_id)->accelerometer_parameters.sampling_rate;
+	int period_us = (imu_rate > 0) ? (int)(1e6f / imu_rate) : 2500;
+	unsigned long long last_imu_ts = 0, last_mag_ts = 0, last_baro_ts = 0;
+
 	int n = 0;
 
 	while (n < 500) {
 
 		// Depending on your camera model, different sensors are available.
 		// NOTE: There is no need to acquire images with grab(). getSensorsData runs in a separate internal capture thread.
-		if (sl_get_sensors_data(camera_id, &sensor_data, SL_TIME_REFERENCE_CURRENT) == SL_ERROR_CODE_SUCCESS) {
+		bool new_sample = false;
+		if (sl_get_sensors_data(camera_id, &sensor_data, SL_TIME_REFERENCE_CURRENT) == SL_ERROR_CODE_SUCCESS
+			&& sensor_data.imu.timestamp_ns > last_imu_ts) {
+			// Only the samples which were not displayed yet
+			last_imu_ts = sensor_data.imu.timestamp_ns;
+			new_sample = true;
 
 			printf("Sample %i \n", n++);
 			printf(" - IMU:\n");
@@ -94,10 +119,20 @@ int main(int argc, char **argv) {
 			printf(" \t Acceleration: {%f,%f,%f} [m/sec^2] \n", sensor_data.imu.linear_acceleration.x, sensor_data.imu.linear_acceleration.y, sensor_data.imu.linear_acceleration.z);
 			printf(" \t Angular Velocity: {%f,%f,%f} [deg/sec] \n", sensor_data.imu.angular_velocity.x, sensor_data.imu.angular_velocity.y, sensor_data.imu.angular_velocity.z);
 
-			printf(" - Magnetometer \n \t Magnetic Field: {%f,%f,%f} [uT] \n", sensor_data.magnetometer.magnetic_field_c.x, sensor_data.magnetometer.magnetic_field_c.y, sensor_data.magnetometer.magnetic_field_c.z);
-		
-			printf(" - Barometer \n \t Atmospheric pressure: %f [hPa] \n", sensor_data.barometer.pressure);
+			// The magnetometer and the barometer are slower than the IMU
+			if (sensor_data.magnetometer.timestamp_ns > last_mag_ts) {
+				last_mag_ts = sensor_data.magnetometer.timestamp_ns;
+				printf(" - Magnetometer \n \t Magnetic Field: {%f,%f,%f} [uT] \n", sensor_data.magnetometer.magnetic_field_c.x, sensor_data.magnetometer.magnetic_field_c.y, sensor_data.magnetometer.magnetic_field_c.z);
+			}
+
+			if (sensor_data.barometer.timestamp_ns > last_baro_ts) {
+				last_baro_ts = sensor_data.barometer.timestamp_ns;
+				printf(" - Barometer \n \t Atmospheric pressure: %f [hPa] \n", sensor_data.barometer.pressure);
+			}
 		}
+
+		// Sleep most of the period after a new sample, then poll more often until the next one
+		sleepMicroseconds(new_sample ? period_us * 8 / 10 : period_us / 10);
 	}
 
 	sl_close_camera(camera_id);